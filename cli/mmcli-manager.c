@@ -44,6 +44,9 @@
 typedef struct {
     MMManager *manager;
     GCancellable *cancellable;
+    GDBusConnection *monitor_connection;
+    guint monitor_subscription_id;
+    GDBusProxy *debug_proxy;
 #if defined WITH_UDEV
     GUdevClient *udev;
 #endif
@@ -54,8 +57,11 @@ static Context *ctx;
 static gboolean get_daemon_version_flag;
 static gboolean list_modems_flag;
 static gboolean monitor_modems_flag;
+static gboolean monitor_flag;
 static gboolean scan_modems_flag;
 static gchar *set_logging_str;
+static gchar *get_trace_str;
+static gboolean get_metrics_flag;
 static gchar *inhibit_device_str;
 static gchar *report_kernel_event_str;
 
@@ -72,6 +78,14 @@ static GOptionEntry entries[] = {
       "Set logging level in the ModemManager daemon",
       "[ERR,WARN,INFO,DEBUG]",
     },
+    { "get-trace", 0, 0, G_OPTION_ARG_STRING, &get_trace_str,
+      "Get the timing of the latest modem and bearer operation steps (requires the daemon running with --debug)",
+      "[text,chrome]",
+    },
+    { "get-metrics", 0, 0, G_OPTION_ARG_NONE, &get_metrics_flag,
+      "Get the current value of the daemon metrics (requires the daemon running with --debug)",
+      NULL
+    },
     { "list-modems", 'L', 0, G_OPTION_ARG_NONE, &list_modems_flag,
       "List available modems",
       NULL
@@ -80,6 +94,10 @@ static GOptionEntry entries[] = {
       "List available modems and monitor additions and removals",
       NULL
     },
+    { "monitor", 0, 0, G_OPTION_ARG_NONE, &monitor_flag,
+      "Monitor property changes and signals in all modems, bearers, SIMs and SMS",
+      NULL
+    },
     { "scan-modems", 'S', 0, G_OPTION_ARG_NONE, &scan_modems_flag,
       "Request to re-scan looking for modems",
       NULL
@@ -129,8 +147,11 @@ mmcli_manager_options_enabled (void)
     n_actions = (get_daemon_version_flag +
                  list_modems_flag +
                  monitor_modems_flag +
+                 monitor_flag +
                  scan_modems_flag +
                  !!set_logging_str +
+                 !!get_trace_str +
+                 get_metrics_flag +
                  !!inhibit_device_str +
                  !!report_kernel_event_str);
 
@@ -147,7 +168,13 @@ mmcli_manager_options_enabled (void)
         mmcli_force_sync_operation ();
     else if (monitor_modems_flag) {
         if (mmcli_output_get () != MMC_OUTPUT_TYPE_HUMAN) {
-            g_printerr ("error: modem monitoring not available in keyvalue output\n");
+            g_printerr ("error: modem monitoring only available in human output, use --monitor instead\n");
+            exit (EXIT_FAILURE);
+        }
+        mmcli_force_async_operation ();
+    } else if (monitor_flag) {
+        if (mmcli_output_get () == MMC_OUTPUT_TYPE_KEYVALUE) {
+            g_printerr ("error: monitoring not available in keyvalue output\n");
             exit (EXIT_FAILURE);
         }
         mmcli_force_async_operation ();
@@ -174,6 +201,13 @@ context_free (Context *ctx)
         g_object_unref (ctx->udev);
 #endif
 
+    if (ctx->monitor_connection) {
+        if (ctx->monitor_subscription_id)
+            g_dbus_connection_signal_unsubscribe (ctx->monitor_connection, ctx->monitor_subscription_id);
+        g_object_unref (ctx->monitor_connection);
+    }
+    if (ctx->debug_proxy)
+        g_object_unref (ctx->debug_proxy);
     if (ctx->manager)
         g_object_unref (ctx->manager);
     if (ctx->cancellable)
@@ -292,6 +326,89 @@ set_logging_ready (MMManager    *manager,
     mmcli_async_operation_done ();
 }
 
+/* The Debug interface is only exported when the daemon runs with --debug, and
+ * it is not part of the stable API, so it is not wrapped by libmm-glib */
+#define MM_DBUS_INTERFACE_DEBUG "org.freedesktop.ModemManager1.Debug"
+
+#define DEBUG_PROXY_FLAGS (G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES | \
+                           G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS)
+
+static void
+debug_proxy_process (GDBusProxy   *proxy,
+                     const GError *error)
+{
+    if (!proxy) {
+        g_printerr ("error: couldn't access the debug interface: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Setup operation timeout */
+    mmcli_force_operation_timeout (proxy);
+}
+
+static void
+get_trace_process_reply (GVariant     *result,
+                         const GError *error)
+{
+    const gchar *trace;
+
+    if (!result) {
+        g_printerr ("error: couldn't get trace: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_get (result, "(&s)", &trace);
+    g_print ("%s", trace);
+    g_variant_unref (result);
+}
+
+static void
+get_trace_ready (GDBusProxy   *proxy,
+                 GAsyncResult *result,
+                 gpointer      nothing)
+{
+    GVariant *trace;
+    GError *error = NULL;
+
+    trace = g_dbus_proxy_call_finish (proxy, result, &error);
+    get_trace_process_reply (trace, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+get_metrics_process_reply (GVariant     *result,
+                           const GError *error)
+{
+    const gchar *metrics;
+
+    if (!result) {
+        g_printerr ("error: couldn't get metrics: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_get (result, "(&s)", &metrics);
+    g_print ("%s", metrics);
+    g_variant_unref (result);
+}
+
+static void
+get_metrics_ready (GDBusProxy   *proxy,
+                   GAsyncResult *result,
+                   gpointer      nothing)
+{
+    GVariant *metrics;
+    GError *error = NULL;
+
+    metrics = g_dbus_proxy_call_finish (proxy, result, &error);
+    get_metrics_process_reply (metrics, error);
+
+    mmcli_async_operation_done ();
+}
+
 static void
 scan_devices_process_reply (gboolean      result,
                             const GError *error)
@@ -379,6 +496,115 @@ cancelled (GCancellable *cancellable)
     mmcli_async_operation_done ();
 }
 
+static void
+monitor_signal_received (GDBusConnection *connection,
+                         const gchar     *sender_name,
+                         const gchar     *object_path,
+                         const gchar     *interface_name,
+                         const gchar     *signal_name,
+                         GVariant        *parameters)
+{
+    /* One event per changed or invalidated property */
+    if (g_str_equal (interface_name, "org.freedesktop.DBus.Properties") &&
+        g_str_equal (signal_name, "PropertiesChanged") &&
+        g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)"))) {
+        const gchar   *changed_interface;
+        GVariantIter  *changed_iter;
+        const gchar  **invalidated;
+        const gchar   *property;
+        GVariant      *value;
+        guint          i;
+
+        g_variant_get (parameters, "(&sa{sv}^a&s)", &changed_interface, &changed_iter, &invalidated);
+        while (g_variant_iter_next (changed_iter, "{&sv}", &property, &value)) {
+            mmcli_output_monitor_event ("property-changed", object_path, changed_interface, property, value);
+            g_variant_unref (value);
+        }
+        for (i = 0; invalidated[i]; i++)
+            mmcli_output_monitor_event ("property-invalidated", object_path, changed_interface, invalidated[i], NULL);
+        g_variant_iter_free (changed_iter);
+        g_free (invalidated);
+        return;
+    }
+
+    /* One event per interface added to or removed from a modem object */
+    if (g_str_equal (interface_name, "org.freedesktop.DBus.ObjectManager") &&
+        g_str_equal (signal_name, "InterfacesAdded") &&
+        g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oa{sa{sv}})"))) {
+        const gchar  *added_path;
+        GVariantIter *added_iter;
+        const gchar  *added_interface;
+        GVariant     *properties;
+
+        g_variant_get (parameters, "(&oa{sa{sv}})", &added_path, &added_iter);
+        while (g_variant_iter_next (added_iter, "{&s@a{sv}}", &added_interface, &properties)) {
+            mmcli_output_monitor_event ("interface-added", added_path, added_interface, NULL, properties);
+            g_variant_unref (properties);
+        }
+        g_variant_iter_free (added_iter);
+        return;
+    }
+
+    if (g_str_equal (interface_name, "org.freedesktop.DBus.ObjectManager") &&
+        g_str_equal (signal_name, "InterfacesRemoved") &&
+        g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oas)"))) {
+        const gchar  *removed_path;
+        const gchar **removed_interfaces;
+        guint         i;
+
+        g_variant_get (parameters, "(&o^a&s)", &removed_path, &removed_interfaces);
+        for (i = 0; removed_interfaces[i]; i++)
+            mmcli_output_monitor_event ("interface-removed", removed_path, removed_interfaces[i], NULL, NULL);
+        g_free (removed_interfaces);
+        return;
+    }
+
+    /* Any other signal (e.g. StateChanged, Added, Deleted, CallAdded...) is
+     * reported as is */
+    mmcli_output_monitor_event ("signal", object_path, interface_name, signal_name, parameters);
+}
+
+static void
+monitor_current_objects (MMManager *manager)
+{
+    GList *objects;
+    GList *l;
+
+    /* Report the cached properties of the modem objects known at startup, so
+     * that the listener doesn't need to query them separately */
+    objects = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (manager));
+    for (l = objects; l; l = g_list_next (l)) {
+        GList *interfaces;
+        GList *k;
+
+        interfaces = g_dbus_object_get_interfaces (G_DBUS_OBJECT (l->data));
+        for (k = interfaces; k; k = g_list_next (k)) {
+            GDBusProxy  *proxy;
+            gchar      **properties;
+            guint        i;
+
+            proxy = G_DBUS_PROXY (k->data);
+            properties = g_dbus_proxy_get_cached_property_names (proxy);
+            for (i = 0; properties && properties[i]; i++) {
+                GVariant *value;
+
+                value = g_dbus_proxy_get_cached_property (proxy, properties[i]);
+                if (!value)
+                    continue;
+                mmcli_output_monitor_event ("property-initial",
+                                            g_dbus_proxy_get_object_path (proxy),
+                                            g_dbus_proxy_get_interface_name (proxy),
+                                            properties[i],
+                                            value);
+                g_variant_unref (value);
+            }
+            g_strfreev (properties);
+        }
+        g_list_free_full (interfaces, g_object_unref);
+    }
+    g_list_free_full (objects, g_object_unref);
+}
+
 #if defined WITH_UDEV
 
 static void
@@ -498,6 +724,31 @@ get_manager_ready (GObject      *source,
         return;
     }
 
+    /* Request to monitor everything? A single signal subscription covers
+     * all objects exported by the daemon, not only the ones known by the
+     * object manager (bearers, SIMs, SMS and calls aren't) */
+    if (monitor_flag) {
+        ctx->monitor_connection = g_object_ref (g_dbus_object_manager_client_get_connection (G_DBUS_OBJECT_MANAGER_CLIENT (ctx->manager)));
+        ctx->monitor_subscription_id = g_dbus_connection_signal_subscribe (ctx->monitor_connection,
+                                                                           MM_DBUS_SERVICE,
+                                                                           NULL, /* any interface */
+                                                                           NULL, /* any member */
+                                                                           NULL, /* any path */
+                                                                           NULL, /* any arg0 */
+                                                                           G_DBUS_SIGNAL_FLAGS_NONE,
+                                                                           (GDBusSignalCallback) monitor_signal_received,
+                                                                           NULL,
+                                                                           NULL);
+        monitor_current_objects (ctx->manager);
+
+        /* If we get cancelled, operation done */
+        g_cancellable_connect (ctx->cancellable,
+                               G_CALLBACK (cancelled),
+                               NULL,
+                               NULL);
+        return;
+    }
+
     /* Request to list modems? */
     if (list_modems_flag) {
         list_current_modems (ctx->manager);
@@ -518,6 +769,45 @@ get_manager_ready (GObject      *source,
     g_warn_if_reached ();
 }
 
+static void
+debug_proxy_ready (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      none)
+{
+    GError *error = NULL;
+
+    ctx->debug_proxy = g_dbus_proxy_new_finish (result, &error);
+    debug_proxy_process (ctx->debug_proxy, error);
+
+    /* Request to get trace? */
+    if (get_trace_str) {
+        g_dbus_proxy_call (ctx->debug_proxy,
+                           "GetTrace",
+                           g_variant_new ("(s)", get_trace_str),
+                           G_DBUS_CALL_FLAGS_NONE,
+                           -1,
+                           ctx->cancellable,
+                           (GAsyncReadyCallback)get_trace_ready,
+                           NULL);
+        return;
+    }
+
+    /* Request to get metrics? */
+    if (get_metrics_flag) {
+        g_dbus_proxy_call (ctx->debug_proxy,
+                           "GetMetrics",
+                           NULL,
+                           G_DBUS_CALL_FLAGS_NONE,
+                           -1,
+                           ctx->cancellable,
+                           (GAsyncReadyCallback)get_metrics_ready,
+                           NULL);
+        return;
+    }
+
+    g_warn_if_reached ();
+}
+
 void
 mmcli_manager_run_asynchronous (GDBusConnection *connection,
                                 GCancellable    *cancellable)
@@ -527,6 +817,20 @@ mmcli_manager_run_asynchronous (GDBusConnection *connection,
     if (cancellable)
         ctx->cancellable = g_object_ref (cancellable);
 
+    /* Debug interface requests don't need the Manager object */
+    if (get_trace_str || get_metrics_flag) {
+        g_dbus_proxy_new (connection,
+                          DEBUG_PROXY_FLAGS,
+                          NULL,
+                          MM_DBUS_SERVICE,
+                          MM_DBUS_PATH,
+                          MM_DBUS_INTERFACE_DEBUG,
+                          cancellable,
+                          (GAsyncReadyCallback)debug_proxy_ready,
+                          NULL);
+        return;
+    }
+
     /* Create a new Manager object asynchronously */
     mmcli_get_manager (connection,
                        cancellable,
@@ -544,6 +848,11 @@ mmcli_manager_run_synchronous (GDBusConnection *connection)
         exit (EXIT_FAILURE);
     }
 
+    if (monitor_flag) {
+        g_printerr ("error: monitoring cannot be done synchronously\n");
+        exit (EXIT_FAILURE);
+    }
+
 #if defined WITH_UDEV
     if (report_kernel_event_auto_scan) {
         g_printerr ("error: monitoring udev events cannot be done synchronously\n");
@@ -553,6 +862,50 @@ mmcli_manager_run_synchronous (GDBusConnection *connection)
 
     /* Initialize context */
     ctx = g_new0 (Context, 1);
+
+    /* Debug interface requests don't need the Manager object */
+    if (get_trace_str || get_metrics_flag) {
+        ctx->debug_proxy = g_dbus_proxy_new_sync (connection,
+                                                  DEBUG_PROXY_FLAGS,
+                                                  NULL,
+                                                  MM_DBUS_SERVICE,
+                                                  MM_DBUS_PATH,
+                                                  MM_DBUS_INTERFACE_DEBUG,
+                                                  NULL,
+                                                  &error);
+        debug_proxy_process (ctx->debug_proxy, error);
+    }
+
+    /* Request to get trace? */
+    if (get_trace_str) {
+        GVariant *trace;
+
+        trace = g_dbus_proxy_call_sync (ctx->debug_proxy,
+                                        "GetTrace",
+                                        g_variant_new ("(s)", get_trace_str),
+                                        G_DBUS_CALL_FLAGS_NONE,
+                                        -1,
+                                        NULL,
+                                        &error);
+        get_trace_process_reply (trace, error);
+        return;
+    }
+
+    /* Request to get metrics? */
+    if (get_metrics_flag) {
+        GVariant *metrics;
+
+        metrics = g_dbus_proxy_call_sync (ctx->debug_proxy,
+                                          "GetMetrics",
+                                          NULL,
+                                          G_DBUS_CALL_FLAGS_NONE,
+                                          -1,
+                                          NULL,
+                                          &error);
+        get_metrics_process_reply (metrics, error);
+        return;
+    }
+
     ctx->manager = mmcli_get_manager_sync (connection);
 
     /* Get daemon version? */
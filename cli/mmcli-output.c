@@ -1068,6 +1068,356 @@ dump_output_list_keyvalue (MmcF field)
     }
 }
 
+/******************************************************************************/
+/* JSON output */
+
+static void
+json_append_string (GString     *str,
+                    const gchar *value)
+{
+    const gchar *p;
+
+    g_string_append_c (str, '"');
+    for (p = value; *p; p++) {
+        switch (*p) {
+        case '"':
+            g_string_append (str, "\\\"");
+            break;
+        case '\\':
+            g_string_append (str, "\\\\");
+            break;
+        case '\n':
+            g_string_append (str, "\\n");
+            break;
+        case '\r':
+            g_string_append (str, "\\r");
+            break;
+        case '\t':
+            g_string_append (str, "\\t");
+            break;
+        default:
+            if ((guchar)(*p) < 0x20)
+                g_string_append_printf (str, "\\u%04x", (guint)(guchar)(*p));
+            else
+                g_string_append_c (str, *p);
+            break;
+        }
+    }
+    g_string_append_c (str, '"');
+}
+
+static void
+json_append_variant (GString  *str,
+                     GVariant *value)
+{
+    switch (g_variant_classify (value)) {
+    case G_VARIANT_CLASS_BOOLEAN:
+        g_string_append (str, g_variant_get_boolean (value) ? "true" : "false");
+        break;
+    case G_VARIANT_CLASS_BYTE:
+        g_string_append_printf (str, "%u", (guint) g_variant_get_byte (value));
+        break;
+    case G_VARIANT_CLASS_INT16:
+        g_string_append_printf (str, "%d", (gint) g_variant_get_int16 (value));
+        break;
+    case G_VARIANT_CLASS_UINT16:
+        g_string_append_printf (str, "%u", (guint) g_variant_get_uint16 (value));
+        break;
+    case G_VARIANT_CLASS_INT32:
+        g_string_append_printf (str, "%d", g_variant_get_int32 (value));
+        break;
+    case G_VARIANT_CLASS_UINT32:
+        g_string_append_printf (str, "%u", g_variant_get_uint32 (value));
+        break;
+    case G_VARIANT_CLASS_INT64:
+        g_string_append_printf (str, "%" G_GINT64_FORMAT, g_variant_get_int64 (value));
+        break;
+    case G_VARIANT_CLASS_UINT64:
+        g_string_append_printf (str, "%" G_GUINT64_FORMAT, g_variant_get_uint64 (value));
+        break;
+    case G_VARIANT_CLASS_HANDLE:
+        g_string_append_printf (str, "%d", g_variant_get_handle (value));
+        break;
+    case G_VARIANT_CLASS_DOUBLE: {
+        gdouble d;
+        gchar   buffer[G_ASCII_DTOSTR_BUF_SIZE];
+
+        /* NaN and infinite values have no JSON representation */
+        d = g_variant_get_double (value);
+        if ((d - d) != 0.0)
+            g_string_append (str, "null");
+        else
+            g_string_append (str, g_ascii_dtostr (buffer, sizeof (buffer), d));
+        break;
+    }
+    case G_VARIANT_CLASS_STRING:
+    case G_VARIANT_CLASS_OBJECT_PATH:
+    case G_VARIANT_CLASS_SIGNATURE:
+        json_append_string (str, g_variant_get_string (value, NULL));
+        break;
+    case G_VARIANT_CLASS_VARIANT: {
+        GVariant *inner;
+
+        inner = g_variant_get_variant (value);
+        json_append_variant (str, inner);
+        g_variant_unref (inner);
+        break;
+    }
+    case G_VARIANT_CLASS_MAYBE: {
+        GVariant *inner;
+
+        inner = g_variant_get_maybe (value);
+        if (inner) {
+            json_append_variant (str, inner);
+            g_variant_unref (inner);
+        } else
+            g_string_append (str, "null");
+        break;
+    }
+    case G_VARIANT_CLASS_ARRAY:
+    case G_VARIANT_CLASS_TUPLE:
+    case G_VARIANT_CLASS_DICT_ENTRY: {
+        gboolean is_dict;
+        gsize    n;
+        gsize    i;
+
+        is_dict = g_variant_is_of_type (value, G_VARIANT_TYPE_DICTIONARY);
+        g_string_append_c (str, is_dict ? '{' : '[');
+        n = g_variant_n_children (value);
+        for (i = 0; i < n; i++) {
+            GVariant *child;
+
+            if (i > 0)
+                g_string_append_c (str, ',');
+            child = g_variant_get_child_value (value, i);
+            if (is_dict) {
+                GVariant *child_key;
+                GVariant *child_value;
+
+                /* JSON object keys are always strings */
+                child_key = g_variant_get_child_value (child, 0);
+                child_value = g_variant_get_child_value (child, 1);
+                if (g_variant_is_of_type (child_key, G_VARIANT_TYPE_STRING))
+                    json_append_string (str, g_variant_get_string (child_key, NULL));
+                else {
+                    gchar *printed;
+
+                    printed = g_variant_print (child_key, FALSE);
+                    json_append_string (str, printed);
+                    g_free (printed);
+                }
+                g_string_append_c (str, ':');
+                json_append_variant (str, child_value);
+                g_variant_unref (child_key);
+                g_variant_unref (child_value);
+            } else
+                json_append_variant (str, child);
+            g_variant_unref (child);
+        }
+        g_string_append_c (str, is_dict ? '}' : ']');
+        break;
+    }
+    default:
+        g_string_append (str, "null");
+        break;
+    }
+}
+
+/* Keys are sorted alphabetically, which guarantees that all keys sharing the
+ * same dot-separated prefix are consecutive, so that each nested object is
+ * opened and closed exactly once. */
+static gint
+list_sort_json (const OutputItem *item_a,
+                const OutputItem *item_b)
+{
+    return g_strcmp0 (field_infos[item_a->field].key, field_infos[item_b->field].key);
+}
+
+static void
+dump_output_json (void)
+{
+    GString  *str;
+    GList    *l;
+    gchar   **current = NULL;
+    guint     n_current = 0;
+    gboolean  need_comma = FALSE;
+    guint     i;
+
+    output_items = g_list_sort (output_items, (GCompareFunc) list_sort_json);
+
+    str = g_string_new ("{");
+    for (l = output_items; l; l = g_list_next (l)) {
+        OutputItem          *item_l;
+        OutputItemSingle    *single = NULL;
+        OutputItemMultiple  *multiple = NULL;
+        gchar              **path;
+        guint                n_path;
+        guint                n_common;
+
+        item_l = (OutputItem *)(l->data);
+        if (item_l->type == VALUE_TYPE_SINGLE)
+            single = (OutputItemSingle *)item_l;
+        else if (item_l->type == VALUE_TYPE_MULTIPLE)
+            multiple = (OutputItemMultiple *)item_l;
+        else
+            g_assert_not_reached ();
+
+        path = g_strsplit (field_infos[item_l->field].key, ".", -1);
+        n_path = g_strv_length (path);
+        g_assert (n_path > 0);
+
+        /* Close the objects not shared with the new key, open the new ones */
+        for (n_common = 0;
+             n_common < n_current && n_common < (n_path - 1) && g_str_equal (current[n_common], path[n_common]);
+             n_common++);
+        for (i = n_common; i < n_current; i++) {
+            g_string_append_c (str, '}');
+            need_comma = TRUE;
+        }
+        for (i = n_common; i < (n_path - 1); i++) {
+            if (need_comma)
+                g_string_append_c (str, ',');
+            json_append_string (str, path[i]);
+            g_string_append (str, ":{");
+            need_comma = FALSE;
+        }
+        g_strfreev (current);
+        current = path;
+        n_current = n_path - 1;
+
+        if (need_comma)
+            g_string_append_c (str, ',');
+        json_append_string (str, path[n_path - 1]);
+        g_string_append_c (str, ':');
+        need_comma = TRUE;
+
+        if (single)
+            json_append_string (str, single->value ? single->value : "--");
+        else if (multiple) {
+            g_string_append_c (str, '[');
+            for (i = 0; multiple->values && multiple->values[i]; i++) {
+                if (i > 0)
+                    g_string_append_c (str, ',');
+                json_append_string (str, multiple->values[i]);
+            }
+            g_string_append_c (str, ']');
+        }
+    }
+    for (i = 0; i < n_current; i++)
+        g_string_append_c (str, '}');
+    g_string_append_c (str, '}');
+    g_strfreev (current);
+
+    g_print ("%s\n", str->str);
+    g_string_free (str, TRUE);
+}
+
+static void
+dump_output_list_json (MmcF field)
+{
+    GString  *str;
+    GList    *l;
+    gchar   **path;
+    guint     n_path;
+    guint     i;
+
+    g_assert (field != MMC_F_UNKNOWN);
+
+    path = g_strsplit (field_infos[field].key, ".", -1);
+    n_path = g_strv_length (path);
+    g_assert (n_path > 0);
+
+    str = g_string_new ("{");
+    for (i = 0; i < (n_path - 1); i++) {
+        json_append_string (str, path[i]);
+        g_string_append (str, ":{");
+    }
+    json_append_string (str, path[n_path - 1]);
+    g_string_append (str, ":[");
+
+    for (l = output_items; l; l = g_list_next (l)) {
+        OutputItem         *item_l;
+        OutputItemListitem *listitem;
+
+        item_l = (OutputItem *)(l->data);
+        g_assert (item_l->type == VALUE_TYPE_LISTITEM);
+        listitem = (OutputItemListitem *)item_l;
+        g_assert (listitem->value);
+
+        /* All items must be of same type */
+        g_assert_cmpint (item_l->field, ==, field);
+
+        if (l != output_items)
+            g_string_append_c (str, ',');
+        json_append_string (str, listitem->value);
+    }
+
+    g_string_append_c (str, ']');
+    for (i = 0; i < n_path; i++)
+        g_string_append_c (str, '}');
+    g_strfreev (path);
+
+    g_print ("%s\n", str->str);
+    g_string_free (str, TRUE);
+}
+
+/******************************************************************************/
+/* Monitor output */
+
+void
+mmcli_output_monitor_event (const gchar *event,
+                            const gchar *path,
+                            const gchar *interface,
+                            const gchar *property,
+                            GVariant    *value)
+{
+    GString *str;
+
+    g_assert (event);
+
+    if (selected_type == MMC_OUTPUT_TYPE_JSON) {
+        str = g_string_new ("{\"event\":");
+        json_append_string (str, event);
+        g_string_append_printf (str, ",\"timestamp\":%" G_GINT64_FORMAT, g_get_real_time ());
+        if (path) {
+            g_string_append (str, ",\"path\":");
+            json_append_string (str, path);
+        }
+        if (interface) {
+            g_string_append (str, ",\"interface\":");
+            json_append_string (str, interface);
+        }
+        if (property) {
+            g_string_append (str, ",\"property\":");
+            json_append_string (str, property);
+        }
+        if (value) {
+            g_string_append (str, ",\"value\":");
+            json_append_variant (str, value);
+        }
+        g_string_append_c (str, '}');
+    } else {
+        str = g_string_new ("");
+        g_string_append_printf (str, "[%s] %s", event, path ? path : "");
+        if (interface)
+            g_string_append_printf (str, " %s", interface);
+        if (property)
+            g_string_append_printf (str, ".%s", property);
+        if (value) {
+            gchar *printed;
+
+            printed = g_variant_print (value, FALSE);
+            g_string_append_printf (str, ": %s", printed);
+            g_free (printed);
+        }
+    }
+
+    g_print ("%s\n", str->str);
+    g_string_free (str, TRUE);
+
+    fflush (stdout);
+}
+
 /******************************************************************************/
 /* Dump output */
 
@@ -1083,6 +1433,9 @@ mmcli_output_dump (void)
     case MMC_OUTPUT_TYPE_KEYVALUE:
         dump_output_keyvalue ();
         break;
+    case MMC_OUTPUT_TYPE_JSON:
+        dump_output_json ();
+        break;
     }
 
     g_list_free_full (output_items, (GDestroyNotify) output_item_free);
@@ -1103,6 +1456,9 @@ mmcli_output_list_dump (MmcF field)
     case MMC_OUTPUT_TYPE_KEYVALUE:
         dump_output_list_keyvalue (field);
         break;
+    case MMC_OUTPUT_TYPE_JSON:
+        dump_output_list_json (field);
+        break;
     }
 
     g_list_free_full (output_items, (GDestroyNotify) output_item_free);
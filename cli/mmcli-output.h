@@ -282,6 +282,7 @@ typedef enum {
     MMC_OUTPUT_TYPE_NONE,
     MMC_OUTPUT_TYPE_HUMAN,
     MMC_OUTPUT_TYPE_KEYVALUE,
+    MMC_OUTPUT_TYPE_JSON,
 } MmcOutputType;
 
 void          mmcli_output_set (MmcOutputType type);
@@ -328,6 +329,15 @@ void mmcli_output_firmware_list    (GList                    *firmware_list,
                                     MMFirmwareProperties     *selected);
 void mmcli_output_pco_list         (GList                    *pco_list);
 
+/******************************************************************************/
+/* Monitor output: events are printed right away, not dumped */
+
+void mmcli_output_monitor_event (const gchar *event,
+                                 const gchar *path,
+                                 const gchar *interface,
+                                 const gchar *property,
+                                 GVariant    *value);
+
 /******************************************************************************/
 /* Dump output */
 
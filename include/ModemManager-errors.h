@@ -277,6 +277,7 @@ typedef enum { /*< underscore_name=mm_connection_error >*/
  * @MM_SERIAL_ERROR_NOT_OPEN: The serial port is not open.
  * @MM_SERIAL_ERROR_PARSE_FAILED: The serial port specific parsing failed.
  * @MM_SERIAL_ERROR_FRAME_NOT_FOUND: The serial port reported that the frame marker wasn't found (e.g. for QCDM).
+ * @MM_SERIAL_ERROR_QUEUE_FULL: Too many commands already queued in the serial port.
  *
  * Serial errors that may be reported by ModemManager.
  */
@@ -290,6 +291,7 @@ typedef enum { /*< underscore_name=mm_serial_error >*/
     MM_SERIAL_ERROR_NOT_OPEN              = 6, /*< nick=NotOpen            >*/
     MM_SERIAL_ERROR_PARSE_FAILED          = 7, /*< nick=ParseFailed        >*/
     MM_SERIAL_ERROR_FRAME_NOT_FOUND       = 8, /*< nick=FrameNotFound      >*/
+    MM_SERIAL_ERROR_QUEUE_FULL            = 9, /*< nick=QueueFull          >*/
 } MMSerialError;
 
 /**
@@ -218,6 +218,57 @@ mm_modem_messaging_get_default_storage (MMModemMessaging *self)
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_messaging_get_send_queue_depth:
+ * @self: A #MMModem.
+ *
+ * Gets the number of SMS messages waiting to be sent, including the one
+ * currently being sent, if any.
+ *
+ * Returns: the number of messages in the send queue.
+ */
+guint
+mm_modem_messaging_get_send_queue_depth (MMModemMessaging *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), 0);
+
+    return mm_gdbus_modem_messaging_get_send_queue_depth (MM_GDBUS_MODEM_MESSAGING (self));
+}
+
+/**
+ * mm_modem_messaging_get_send_queue_sent:
+ * @self: A #MMModem.
+ *
+ * Gets the number of SMS messages successfully sent.
+ *
+ * Returns: the number of messages sent.
+ */
+guint
+mm_modem_messaging_get_send_queue_sent (MMModemMessaging *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), 0);
+
+    return mm_gdbus_modem_messaging_get_send_queue_sent (MM_GDBUS_MODEM_MESSAGING (self));
+}
+
+/**
+ * mm_modem_messaging_get_send_queue_failed:
+ * @self: A #MMModem.
+ *
+ * Gets the number of SMS messages that couldn't be sent.
+ *
+ * Returns: the number of messages failed.
+ */
+guint
+mm_modem_messaging_get_send_queue_failed (MMModemMessaging *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), 0);
+
+    return mm_gdbus_modem_messaging_get_send_queue_failed (MM_GDBUS_MODEM_MESSAGING (self));
+}
+
+/*****************************************************************************/
+
 typedef struct {
     gchar **sms_paths;
     GList *sms_objects;
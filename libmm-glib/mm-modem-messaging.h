@@ -82,6 +82,10 @@ gboolean     mm_modem_messaging_peek_supported_storages (MMModemMessaging *self,
 
 MMSmsStorage mm_modem_messaging_get_default_storage    (MMModemMessaging *self);
 
+guint        mm_modem_messaging_get_send_queue_depth   (MMModemMessaging *self);
+guint        mm_modem_messaging_get_send_queue_sent    (MMModemMessaging *self);
+guint        mm_modem_messaging_get_send_queue_failed  (MMModemMessaging *self);
+
 void   mm_modem_messaging_create        (MMModemMessaging *self,
                                          MMSmsProperties *properties,
                                          GCancellable *cancellable,
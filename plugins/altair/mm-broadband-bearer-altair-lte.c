@@ -126,6 +126,7 @@ connect_3gpp_apnsettings_ready (MMBaseModem *modem,
                                    20, /* timeout */
                                    FALSE, /* allow_cached */
                                    FALSE, /* is_raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)connect_3gpp_connect_ready,
                                    task); /* user_data */
@@ -209,6 +210,7 @@ connect_3gpp (MMBroadbandBearer *self,
                                    10, /* timeout */
                                    FALSE, /* allow_cached */
                                    FALSE, /* is_raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    cancellable,
                                    (GAsyncReadyCallback)connect_3gpp_apnsettings_ready,
                                    task); /* user_data */
@@ -308,6 +310,7 @@ disconnect_3gpp (MMBroadbandBearer *self,
                                    20, /* timeout */
                                    FALSE, /* allow_cached */
                                    FALSE, /* is_raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)disconnect_3gpp_check_status,
                                    task); /* user_data */
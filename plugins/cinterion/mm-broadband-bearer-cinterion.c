@@ -344,6 +344,7 @@ handle_cancel_dial (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL,
                                    NULL,
                                    NULL);
@@ -404,6 +405,7 @@ dial_3gpp_context_step (GTask *task)
                                            10,
                                            FALSE,
                                            FALSE,
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                            NULL,
                                            (GAsyncReadyCallback) common_dial_operation_ready,
                                            task);
@@ -430,6 +432,7 @@ dial_3gpp_context_step (GTask *task)
                                        90,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback) common_dial_operation_ready,
                                        task);
@@ -620,6 +623,7 @@ disconnect_3gpp_context_step (GTask *task)
                                        10,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback) swwan_disconnect_ready,
                                        task);
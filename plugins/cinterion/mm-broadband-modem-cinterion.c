@@ -568,6 +568,7 @@ modem_power_off (MMIfaceModem        *self,
                                    5,
                                    FALSE, /* allow_cached */
                                    FALSE, /* is_raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)smso_ready,
                                    task);
@@ -1140,6 +1141,7 @@ register_in_network (MMIfaceModem3gpp    *self,
                                    120,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    cancellable,
                                    (GAsyncReadyCallback)cops_write_ready,
                                    task);
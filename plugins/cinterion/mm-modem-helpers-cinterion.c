@@ -28,6 +28,7 @@
 #include "mm-errors-types.h"
 #include "mm-modem-helpers-cinterion.h"
 #include "mm-modem-helpers.h"
+#include "mm-modem-band-set.h"
 
 /* Setup relationship between the 3G band bitmask in the modem and the bitmask
  * in ModemManager. */
@@ -382,17 +383,15 @@ mm_cinterion_build_band (GArray *bands,
     if (bands->len == 1 && g_array_index (bands, MMModemBand, 0) == MM_MODEM_BAND_ANY) {
         band = supported;
     } else {
+        MMModemBandSet requested;
         guint i;
 
-        for (i = 0; i < G_N_ELEMENTS (cinterion_bands); i++) {
-            guint j;
+        mm_modem_band_set_clear (&requested);
+        mm_modem_band_set_add_array (&requested, bands);
 
-            for (j = 0; j < bands->len; j++) {
-                if (g_array_index (bands, MMModemBand, j) == cinterion_bands[i].mm_band) {
-                    band |= cinterion_bands[i].cinterion_band_flag;
-                    break;
-                }
-            }
+        for (i = 0; i < G_N_ELEMENTS (cinterion_bands); i++) {
+            if (mm_modem_band_set_contains (&requested, cinterion_bands[i].mm_band))
+                band |= cinterion_bands[i].cinterion_band_flag;
         }
 
         /* 2G-only modems only support a subset of the possible band
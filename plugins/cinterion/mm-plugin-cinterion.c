@@ -97,6 +97,7 @@ cinterion_custom_init (MMPortProbe         *probe,
         3,
         FALSE, /* raw */
         FALSE, /* allow cached */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         cancellable,
         (GAsyncReadyCallback) sqport_ready,
         task);
@@ -293,6 +293,7 @@ custom_init_step (GTask *task)
                                    3,
                                    FALSE, /* raw */
                                    FALSE, /* allow_cached */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)response_ready,
                                    task);
@@ -306,6 +307,7 @@ custom_init_step (GTask *task)
                                    3,
                                    FALSE, /* raw */
                                    FALSE, /* allow_cached */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)response_ready,
                                    task);
@@ -320,6 +322,7 @@ custom_init_step (GTask *task)
                                    3,
                                    FALSE, /* raw */
                                    FALSE, /* allow_cached */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)response_ready,
                                    task);
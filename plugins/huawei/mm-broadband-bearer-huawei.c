@@ -76,7 +76,6 @@ typedef struct {
     MMPortSerialAt *primary;
     MMPort *data;
     Connect3gppContextStep step;
-    guint check_count;
     guint failed_ndisstatqry_count;
     MMBearerIpConfig *ipv4_config;
 } Connect3gppContext;
@@ -184,72 +183,103 @@ connect_dhcp_check_ready (MMBaseModem *modem,
     connect_3gpp_context_step (task);
 }
 
-static gboolean
-connect_retry_ndisstatqry_check_cb (MMBroadbandBearerHuawei *self)
+static void
+connect_ndisstatqry_check (MMBroadbandBearerHuawei *self,
+                           GTask                   *task,
+                           GAsyncReadyCallback      callback,
+                           gpointer                 user_data)
 {
-    GTask *task;
-
-    /* Recover context */
-    task = self->priv->connect_pending;
-    g_assert (task != NULL);
-
-    /* Balance refcount */
-    g_object_unref (self);
-
-    /* Retry same step */
-    connect_3gpp_context_step (task);
+    Connect3gppContext *ctx;
 
-    return G_SOURCE_REMOVE;
+    ctx = g_task_get_task_data (task);
+    mm_base_modem_at_command_full (ctx->modem,
+                                   ctx->primary,
+                                   "^NDISSTATQRY?",
+                                   3,
+                                   FALSE,
+                                   FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                   NULL,
+                                   callback,
+                                   user_data);
 }
 
-static void
-connect_ndisstatqry_check_ready (MMBaseModem *modem,
-                                 GAsyncResult *res,
-                                 MMBroadbandBearerHuawei *self)
+static MMBroadbandBearerPollResult
+connect_ndisstatqry_check_finish (MMBroadbandBearerHuawei  *self,
+                                  GTask                    *task,
+                                  GAsyncResult             *res,
+                                  GError                  **error)
 {
-    GTask *task;
     Connect3gppContext *ctx;
     const gchar *response;
-    GError *error = NULL;
+    GError *inner_error = NULL;
     gboolean ipv4_available = FALSE;
     gboolean ipv4_connected = FALSE;
     gboolean ipv6_available = FALSE;
     gboolean ipv6_connected = FALSE;
 
-    task = self->priv->connect_pending;
-    g_assert (task != NULL);
-
     ctx = g_task_get_task_data (task);
 
-    /* Balance refcount */
-    g_object_unref (self);
-
-    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+    response = mm_base_modem_at_command_full_finish (ctx->modem, res, &inner_error);
     if (!response ||
         !mm_huawei_parse_ndisstatqry_response (response,
                                                &ipv4_available,
                                                &ipv4_connected,
                                                &ipv6_available,
                                                &ipv6_connected,
-                                               &error)) {
+                                               &inner_error)) {
         ctx->failed_ndisstatqry_count++;
         mm_dbg ("Unexpected response to ^NDISSTATQRY command: %s (Attempts so far: %u)",
-                error->message, ctx->failed_ndisstatqry_count);
-        g_error_free (error);
+                inner_error->message, ctx->failed_ndisstatqry_count);
+        g_error_free (inner_error);
+
+        /* Give up if too many unexpected responses to NIDSSTATQRY are encountered. */
+        if (ctx->failed_ndisstatqry_count > 10) {
+            g_set_error (error,
+                         MM_MOBILE_EQUIPMENT_ERROR,
+                         MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED,
+                         "Connection attempt not supported.");
+            return MM_BROADBAND_BEARER_POLL_FAILED;
+        }
+        return MM_BROADBAND_BEARER_POLL_CONTINUE;
     }
 
     /* Connected in IPv4? */
-    if (ipv4_available && ipv4_connected) {
-        /* Success! */
-        ctx->step++;
-        connect_3gpp_context_step (task);
+    if (ipv4_available && ipv4_connected)
+        return MM_BROADBAND_BEARER_POLL_DONE;
+
+    return MM_BROADBAND_BEARER_POLL_CONTINUE;
+}
+
+static void
+connect_ndisstatqry_poll_ready (MMBroadbandBearer *_self,
+                                GAsyncResult      *res,
+                                GTask             *task)
+{
+    MMBroadbandBearerHuawei *self = MM_BROADBAND_BEARER_HUAWEI (_self);
+    Connect3gppContext *ctx;
+    GError *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+
+    if (!mm_broadband_bearer_connect_poll_finish (_self, res, &error)) {
+        /* Cancellation is handled when running the step again */
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free (error);
+            connect_3gpp_context_step (task);
+            return;
+        }
+
+        /* Clear context */
+        self->priv->connect_pending = NULL;
+        g_task_return_error (task, error);
+        g_object_unref (task);
         return;
     }
 
-    /* Setup timeout to retry the same step */
-    g_timeout_add_seconds (1,
-                           (GSourceFunc)connect_retry_ndisstatqry_check_cb,
-                           g_object_ref (self));
+    /* Success! */
+    ctx->step++;
+    connect_3gpp_context_step (task);
 }
 
 static void
@@ -329,6 +359,7 @@ connect_3gpp_context_step (GTask *task)
                                            3,
                                            FALSE,
                                            FALSE,
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                            NULL,
                                            NULL, /* Do not care the AT response */
                                            NULL);
@@ -417,6 +448,7 @@ connect_3gpp_context_step (GTask *task)
                                        3,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback)connect_ndisdup_ready,
                                        g_object_ref (self));
@@ -425,44 +457,17 @@ connect_3gpp_context_step (GTask *task)
     }
 
     case CONNECT_3GPP_CONTEXT_STEP_NDISSTATQRY:
-        /* Wait for dial up timeout, retries for 60 times
-         * (1s between the retries, so it means 1 minute).
-         * If too many retries, failed
-         */
-        if (ctx->check_count > 60) {
-            /* Clear context */
-            self->priv->connect_pending = NULL;
-            g_task_return_new_error (task,
-                                     MM_MOBILE_EQUIPMENT_ERROR,
-                                     MM_MOBILE_EQUIPMENT_ERROR_NETWORK_TIMEOUT,
-                                     "Connection attempt timed out");
-            g_object_unref (task);
-            return;
-        }
-
-        /* Give up if too many unexpected responses to NIDSSTATQRY are encountered. */
-        if (ctx->failed_ndisstatqry_count > 10) {
-            /* Clear context */
-            self->priv->connect_pending = NULL;
-            g_task_return_new_error (task,
-                                     MM_MOBILE_EQUIPMENT_ERROR,
-                                     MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED,
-                                     "Connection attempt not supported.");
-            g_object_unref (task);
-            return;
-        }
-
-        /* Check if connected */
-        ctx->check_count++;
-        mm_base_modem_at_command_full (ctx->modem,
-                                       ctx->primary,
-                                       "^NDISSTATQRY?",
-                                       3,
-                                       FALSE,
-                                       FALSE,
-                                       NULL,
-                                       (GAsyncReadyCallback)connect_ndisstatqry_check_ready,
-                                       g_object_ref (self));
+        /* Wait for dial up for up to 1 minute, checking often at first and
+         * then every second. A ^NDISSTAT unsolicited message reporting the
+         * connection finishes the wait right away. */
+        mm_broadband_bearer_connect_poll (MM_BROADBAND_BEARER (self),
+                                          100, 1000, 60000,
+                                          (MMBroadbandBearerPollCheckFn) connect_ndisstatqry_check,
+                                          (MMBroadbandBearerPollCheckFinishFn) connect_ndisstatqry_check_finish,
+                                          task,
+                                          g_task_get_cancellable (task),
+                                          (GAsyncReadyCallback) connect_ndisstatqry_poll_ready,
+                                          task);
         return;
 
     case CONNECT_3GPP_CONTEXT_STEP_IP_CONFIG:
@@ -472,6 +477,7 @@ connect_3gpp_context_step (GTask *task)
                                        3,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback)connect_dhcp_check_ready,
                                        g_object_ref (self));
@@ -711,6 +717,7 @@ disconnect_3gpp_context_step (GTask *task)
                                        3,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback)disconnect_ndisdup_ready,
                                        g_object_ref (self));
@@ -749,6 +756,7 @@ disconnect_3gpp_context_step (GTask *task)
                                        3,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback)disconnect_ndisstatqry_check_ready,
                                        g_object_ref (self));
@@ -823,8 +831,14 @@ report_connection_status (MMBaseBearer *bearer,
 
     /* When a pending connection / disconnection attempt is in progress, we use
      * ^NDISSTATQRY? to check the connection status and thus temporarily ignore
-     * ^NDISSTAT unsolicited messages */
-    if (self->priv->connect_pending || self->priv->disconnect_pending)
+     * ^NDISSTAT unsolicited messages; only a 'CONNECTED' one is used to stop
+     * waiting for the connection. */
+    if (self->priv->connect_pending) {
+        if (status == MM_BEARER_CONNECTION_STATUS_CONNECTED)
+            mm_broadband_bearer_connect_poll_report (MM_BROADBAND_BEARER (self), NULL);
+        return;
+    }
+    if (self->priv->disconnect_pending)
         return;
 
     mm_dbg ("Received spontaneous ^NDISSTAT (%s)",
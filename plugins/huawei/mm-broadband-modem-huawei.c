@@ -39,6 +39,7 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
 #include "mm-iface-modem-3gpp-ussd.h"
+#include "mm-ussd-codec.h"
 #include "mm-iface-modem-location.h"
 #include "mm-iface-modem-time.h"
 #include "mm-iface-modem-cdma.h"
@@ -2111,6 +2112,7 @@ modem_3gpp_disable_unsolicited_events (MMIfaceModem3gpp *self,
         5,
         FALSE, /* allow_cached */
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)own_disable_unsolicited_events_ready,
         task);
@@ -2339,21 +2341,15 @@ decode (MMIfaceModem3gppUssd *self,
         const gchar *reply,
         GError **error)
 {
-    gchar *bin, *utf8;
-    guint8 *unpacked;
-    gsize bin_len;
-    guint32 unpacked_len;
+    GString *utf8;
 
-    bin = mm_utils_hexstr2bin (reply, &bin_len);
-    unpacked = mm_charset_gsm_unpack ((guint8*) bin, (bin_len * 8) / 7, 0, &unpacked_len);
-    /* if the last character in a 7-byte block is padding, then drop it */
-    if ((bin_len % 7 == 0) && (unpacked[unpacked_len - 1] == 0x0d))
-        unpacked_len--;
-    utf8 = (char*) mm_charset_gsm_unpacked_to_utf8 (unpacked, unpacked_len);
-
-    g_free (bin);
-    g_free (unpacked);
-    return utf8;
+    /* Trailing <CR> padding is dropped by the codec */
+    utf8 = g_string_sized_new (strlen (reply) + 1);
+    if (!mm_ussd_decode_hex (MM_USSD_ENCODING_GSM7, reply, strlen (reply), utf8, error)) {
+        g_string_free (utf8, TRUE);
+        return NULL;
+    }
+    return g_string_free (utf8, FALSE);
 }
 
 /*****************************************************************************/
@@ -3564,6 +3560,7 @@ disable_location_gathering (MMIfaceModemLocation *_self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)gps_disabled_ready,
                                        task);
@@ -3620,6 +3617,7 @@ gps_enabled_ready (MMBaseModem *self,
                                       3,
                                       FALSE,
                                       FALSE, /* raw */
+                                      MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                       NULL, /* cancellable */
                                       (GAsyncReadyCallback)gps_enabled_ready,
                                       task);
@@ -3686,6 +3684,7 @@ parent_enable_location_gathering_ready (MMIfaceModemLocation *_self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)gps_enabled_ready,
                                        task);
@@ -4058,7 +4057,7 @@ setup_ports (MMBroadbandModem *self)
         mm_base_modem_at_command_full (MM_BASE_MODEM (self),
                                        mm_base_modem_peek_port_primary (MM_BASE_MODEM (self)),
                                        "^WPEND",
-                                       3, FALSE, FALSE, NULL, NULL, NULL);
+                                       3, FALSE, FALSE, MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, NULL, NULL, NULL);
         /* Add handler for the NMEA traces */
         mm_port_serial_gps_add_trace_handler (gps_data_port,
                                               (MMPortSerialGpsTraceFn)gps_trace_received,
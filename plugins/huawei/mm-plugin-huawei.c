@@ -285,6 +285,7 @@ huawei_custom_init_step (GTask *task)
             3,
             FALSE, /* raw */
             FALSE, /* allow_cached */
+            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
             g_task_get_cancellable (task),
             (GAsyncReadyCallback)curc_ready,
             task);
@@ -307,6 +308,7 @@ huawei_custom_init_step (GTask *task)
             3,
             FALSE, /* raw */
             FALSE, /* allow_cached */
+            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
             g_task_get_cancellable (task),
             (GAsyncReadyCallback)getportmode_ready,
             task);
@@ -186,6 +186,7 @@ get_ip_config_3gpp (MMBroadbandBearer *_self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)ip_config_ready,
                                        task);
@@ -365,6 +366,7 @@ disconnect_3gpp (MMBroadbandBearer *bearer,
         60,
         FALSE,
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)disconnect_ipdpact_ready,
         g_object_ref (self)); /* we pass the bearer object! */
@@ -438,6 +440,7 @@ connect_reset (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)connect_reset_ready,
                                    ctx);
@@ -566,6 +569,7 @@ process_pending_connect_attempt (MMBroadbandBearerIcera   *self,
             60,
             FALSE,
             FALSE, /* raw */
+            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
             NULL, /* cancellable */
             (GAsyncReadyCallback) ier_query_ready,
             task);
@@ -698,6 +702,7 @@ authenticate_ready (MMBaseModem  *modem,
                                    60,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback) activate_ready,
                                    g_object_ref (self)); /* we pass the bearer object! */
@@ -770,6 +775,7 @@ authenticate (GTask *task)
                                    60,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)authenticate_ready,
                                    task);
@@ -812,6 +818,7 @@ connect_deactivate (GTask *task)
         60,
         FALSE,
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)deactivate_ready,
         task);
@@ -113,6 +113,7 @@ dial_ready (MMBaseModem *modem,
             3,
             FALSE,
             FALSE, /* raw */
+            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
             NULL, /* cancellable */
             (GAsyncReadyCallback)connect_report_ready,
             task);
@@ -169,6 +170,7 @@ service_type_ready (MMBaseModem *modem,
         60,
         FALSE,
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)dial_ready,
         task);
@@ -208,6 +210,7 @@ connect (MMBaseBearer *self,
         3,
         FALSE,
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)service_type_ready,
         task);
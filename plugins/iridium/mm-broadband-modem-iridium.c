@@ -355,6 +355,8 @@ mm_broadband_modem_iridium_new (const gchar *device,
                          MM_BASE_MODEM_MAX_TIMEOUTS, 3,
                          /* Only CS network is supported by the Iridium modem */
                          MM_IFACE_MODEM_3GPP_PS_NETWORK_SUPPORTED, FALSE,
+                         /* Supported modes are a fixed list, loading them keeps no state */
+                         MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED, TRUE,
                          NULL);
 }
 
@@ -384,6 +384,9 @@ mm_broadband_modem_longcheer_new (const gchar *device,
                          MM_BASE_MODEM_PLUGIN, plugin,
                          MM_BASE_MODEM_VENDOR_ID, vendor_id,
                          MM_BASE_MODEM_PRODUCT_ID, product_id,
+                         /* Supported modes are the generic ones filtered with a fixed list,
+                          * loading them keeps no state */
+                         MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED, TRUE,
                          NULL);
 }
 
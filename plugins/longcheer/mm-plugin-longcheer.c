@@ -130,6 +130,7 @@ longcheer_custom_init_step (GTask *task)
         3,
         FALSE, /* raw */
         FALSE, /* allow_cached */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         cancellable,
         (GAsyncReadyCallback)gmr_ready,
         task);
@@ -58,15 +58,14 @@ typedef struct {
     MMPortSerialAt *primary;
     guint           cid;
     MMPort         *data;
-    guint           poll_count;
-    guint           poll_id;
+    gboolean        polling;
     GError         *saved_error;
 } Dial3gppContext;
 
 static void
 dial_3gpp_context_free (Dial3gppContext *ctx)
 {
-    g_assert (!ctx->poll_id);
+    g_assert (!ctx->polling);
     g_assert (!ctx->saved_error);
     g_clear_object (&ctx->data);
     g_clear_object (&ctx->primary);
@@ -130,18 +129,28 @@ process_pending_connect_attempt (MMBroadbandBearerMbm     *self,
     GTask           *task;
     Dial3gppContext *ctx;
 
-    /* Recover connection task */
-    task = self->priv->connect_pending;
-    self->priv->connect_pending = NULL;
-    g_assert (task != NULL);
+    g_assert (self->priv->connect_pending != NULL);
+    ctx = g_task_get_task_data (self->priv->connect_pending);
 
-    ctx = g_task_get_task_data (task);
+    /* If already polling, the unsolicited status just finishes the poll
+     * earlier; the poll completion takes care of the connection task */
+    if (ctx->polling) {
+        if (status == MM_BEARER_CONNECTION_STATUS_CONNECTED)
+            mm_broadband_bearer_connect_poll_report (MM_BROADBAND_BEARER (self), NULL);
+        else {
+            GError *error;
 
-    if (ctx->poll_id) {
-        g_source_remove (ctx->poll_id);
-        ctx->poll_id = 0;
+            error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Call setup failed");
+            mm_broadband_bearer_connect_poll_report (MM_BROADBAND_BEARER (self), error);
+            g_error_free (error);
+        }
+        return;
     }
 
+    /* Recover connection task */
+    task = self->priv->connect_pending;
+    self->priv->connect_pending = NULL;
+
     /* Received 'CONNECTED' during a connection attempt? */
     if (status == MM_BEARER_CONNECTION_STATUS_CONNECTED) {
         /* If we wanted to get cancelled before, do it now. */
@@ -167,95 +176,82 @@ process_pending_connect_attempt (MMBroadbandBearerMbm     *self,
     g_object_unref (task);
 }
 
-static gboolean connect_poll_cb (MMBroadbandBearerMbm *self);
-
 static void
-connect_poll_ready (MMBaseModem          *modem,
-                    GAsyncResult         *res,
-                    MMBroadbandBearerMbm *self)
+connect_enap_check (MMBroadbandBearerMbm *self,
+                    GTask                *task,
+                    GAsyncReadyCallback   callback,
+                    gpointer              user_data)
 {
-    GTask           *task;
     Dial3gppContext *ctx;
-    GError          *error = NULL;
-    const gchar     *response;
-    guint            state;
 
-    task = self->priv->connect_pending;
-    self->priv->connect_pending = NULL;
+    ctx = g_task_get_task_data (task);
+    mm_base_modem_at_command_full (ctx->modem,
+                                   ctx->primary,
+                                   "AT*ENAP?",
+                                   3,
+                                   FALSE,
+                                   FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                   g_task_get_cancellable (task),
+                                   callback,
+                                   user_data);
+}
 
-    if (!task) {
-        mm_dbg ("Connection context was finished already by an unsolicited message");
-        /* Run _finish() to finalize the async call, even if we don't care
-         * the result */
-        mm_base_modem_at_command_full_finish (modem, res, NULL);
-        return;
-    }
+static MMBroadbandBearerPollResult
+connect_enap_check_finish (MMBroadbandBearerMbm  *self,
+                           GTask                 *task,
+                           GAsyncResult          *res,
+                           GError               **error)
+{
+    Dial3gppContext *ctx;
+    const gchar     *response;
+    guint            state;
 
     ctx = g_task_get_task_data (task);
 
-    response = mm_base_modem_at_command_full_finish (modem, res, &error);
-    if (!response) {
-        ctx->saved_error = error;
-        connect_reset (task);
-        return;
-    }
+    response = mm_base_modem_at_command_full_finish (ctx->modem, res, error);
+    if (!response)
+        return MM_BROADBAND_BEARER_POLL_FAILED;
 
-    if (sscanf (response, "*ENAP: %d", &state) == 1 && state == 1) {
-        /* Success!  Connected... */
-        g_task_return_pointer (task, g_object_ref (ctx->data), g_object_unref);
-        g_object_unref (task);
-        return;
-    }
+    if (sscanf (response, "*ENAP: %d", &state) == 1 && state == 1)
+        return MM_BROADBAND_BEARER_POLL_DONE;
 
-    /* Restore pending task and check again in one second */
-    self->priv->connect_pending = task;
-    g_assert (ctx->poll_id == 0);
-    ctx->poll_id = g_timeout_add_seconds (1, (GSourceFunc) connect_poll_cb, self);
+    return MM_BROADBAND_BEARER_POLL_CONTINUE;
 }
 
-static gboolean
-connect_poll_cb (MMBroadbandBearerMbm *self)
+static void
+connect_poll_ready (MMBroadbandBearerMbm *self,
+                    GAsyncResult         *res,
+                    GTask                *task)
 {
-    GTask           *task;
     Dial3gppContext *ctx;
+    GError          *error = NULL;
 
-    task = self->priv->connect_pending;
-    self->priv->connect_pending = NULL;
-
-    g_assert (task);
     ctx = g_task_get_task_data (task);
 
-    ctx->poll_id = 0;
-
-    /* Complete if we were cancelled */
-    if (g_cancellable_is_cancelled (g_task_get_cancellable (task))) {
+    g_assert (self->priv->connect_pending == task);
+    self->priv->connect_pending = NULL;
+    ctx->polling = FALSE;
+
+    if (!mm_broadband_bearer_connect_poll_finish (MM_BROADBAND_BEARER (self), res, &error)) {
+        /* When cancelled, the reset returns the cancelled error itself */
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_error_free (error);
+        else
+            ctx->saved_error = error;
         connect_reset (task);
-        return G_SOURCE_REMOVE;
+        return;
     }
 
-    /* Too many retries... */
-    if (ctx->poll_count > 50) {
-        g_assert (!ctx->saved_error);
-        ctx->saved_error = g_error_new (MM_MOBILE_EQUIPMENT_ERROR,
-                                        MM_MOBILE_EQUIPMENT_ERROR_NETWORK_TIMEOUT,
-                                        "Connection attempt timed out");
+    /* If we wanted to get cancelled before, do it now. */
+    if (g_cancellable_is_cancelled (g_task_get_cancellable (task))) {
         connect_reset (task);
-        return G_SOURCE_REMOVE;
+        return;
     }
 
-    /* Restore pending task and poll */
-    self->priv->connect_pending = task;
-    ctx->poll_count++;
-    mm_base_modem_at_command_full (ctx->modem,
-                                   ctx->primary,
-                                   "AT*ENAP?",
-                                   3,
-                                   FALSE,
-                                   FALSE, /* raw */
-                                   g_task_get_cancellable (task),
-                                   (GAsyncReadyCallback)connect_poll_ready,
-                                   self);
-    return G_SOURCE_REMOVE;
+    /* Success!  Connected... */
+    g_task_return_pointer (task, g_object_ref (ctx->data), g_object_unref);
+    g_object_unref (task);
 }
 
 static void
@@ -293,7 +289,15 @@ activate_ready (MMBaseModem          *modem,
     /* No unsolicited E2NAP status yet; wait for it and periodically poll
      * to handle very old F3507g/MD300 firmware that may not send E2NAP. */
     self->priv->connect_pending = task;
-    ctx->poll_id = g_timeout_add_seconds (1, (GSourceFunc)connect_poll_cb, self);
+    ctx->polling = TRUE;
+    mm_broadband_bearer_connect_poll (MM_BROADBAND_BEARER (self),
+                                      100, 1000, 50000,
+                                      (MMBroadbandBearerPollCheckFn) connect_enap_check,
+                                      (MMBroadbandBearerPollCheckFinishFn) connect_enap_check_finish,
+                                      task,
+                                      g_task_get_cancellable (task),
+                                      (GAsyncReadyCallback) connect_poll_ready,
+                                      task);
 
  out:
     /* Balance refcount with the extra ref we passed to command_full() */
@@ -324,6 +328,7 @@ activate (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)activate_ready,
                                    g_object_ref (self)); /* we pass the bearer object! */
@@ -384,6 +389,7 @@ authenticate (GTask *task)
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        g_task_get_cancellable (task),
                                        (GAsyncReadyCallback) authenticate_ready,
                                        task);
@@ -562,6 +568,7 @@ get_ip_config_3gpp (MMBroadbandBearer *self,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)ip_config_ready,
                                    task);
@@ -707,6 +714,7 @@ disconnect_poll_cb (MMBroadbandBearerMbm *self)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback) disconnect_poll_ready,
                                    g_object_ref (self)); /* we pass the bearer object! */
@@ -786,6 +794,7 @@ disconnect_3gpp (MMBroadbandBearer   *_self,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)disconnect_enap_ready,
                                    g_object_ref (self)); /* we pass the bearer object! */
@@ -1196,6 +1196,7 @@ disable_location_gathering (MMIfaceModemLocation *_self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)gps_disabled_ready,
                                        task);
@@ -1263,6 +1264,7 @@ gps_enabled_ready (MMBaseModem *self,
                                     buf,
                                     3,
                                     FALSE,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                     NULL,
                                     NULL,
                                     NULL);
@@ -1314,6 +1316,7 @@ parent_enable_location_gathering_ready (MMIfaceModemLocation *_self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)gps_enabled_ready,
                                        task);
@@ -1433,7 +1436,7 @@ setup_ports (MMBroadbandModem *_self)
         mm_base_modem_at_command_full (MM_BASE_MODEM (self),
                                        mm_base_modem_peek_port_primary (MM_BASE_MODEM (self)),
                                        "AT*E2GPSCTL=0",
-                                       3, FALSE, FALSE, NULL, NULL, NULL);
+                                       3, FALSE, FALSE, MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, NULL, NULL, NULL);
         /* Add handler for the NMEA traces */
         mm_port_serial_gps_add_trace_handler (gps_data_port,
                                               (MMPortSerialGpsTraceFn)gps_trace_received,
@@ -262,6 +262,7 @@ retry_atz (GTask *task)
                                    6,
                                    FALSE,
                                    FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)atz_ready,
                                    task);
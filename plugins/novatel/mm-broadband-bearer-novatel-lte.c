@@ -148,7 +148,6 @@ typedef struct {
     MMBaseModem *modem;
     MMPortSerialAt *primary;
     MMPort *data;
-    gint retries;
 } DetailedConnectContext;
 
 static void
@@ -169,93 +168,98 @@ connect_3gpp_finish (MMBroadbandBearer *self,
     return g_task_propagate_pointer (G_TASK (res), error);
 }
 
-static gboolean connect_3gpp_qmistatus (GTask *task);
-
 static void
-connect_3gpp_qmistatus_ready (MMBaseModem *modem,
-                              GAsyncResult *res,
-                              GTask *task)
+connect_3gpp_qmistatus_check (MMBroadbandBearer   *self,
+                              GTask               *task,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    DetailedConnectContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+
+    mm_base_modem_at_command_full (
+        ctx->modem,
+        ctx->primary,
+        "$NWQMISTATUS",
+        3, /* timeout */
+        FALSE, /* allow_cached */
+        FALSE, /* is_raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+        g_task_get_cancellable (task),
+        callback,
+        user_data);
+}
+
+static MMBroadbandBearerPollResult
+connect_3gpp_qmistatus_check_finish (MMBroadbandBearer  *self,
+                                     GTask              *task,
+                                     GAsyncResult       *res,
+                                     GError            **error)
 {
     DetailedConnectContext *ctx;
+    MMBroadbandBearerPollResult poll_result = MM_BROADBAND_BEARER_POLL_CONTINUE;
     const gchar *result;
     gchar *normalized_result;
-    GError *error = NULL;
-
-    if (g_task_return_error_if_cancelled (task)) {
-        g_object_unref (task);
-        return;
-    }
+    GError *inner_error = NULL;
 
     ctx = g_task_get_task_data (task);
 
-    result = mm_base_modem_at_command_full_finish (modem, res, &error);
+    result = mm_base_modem_at_command_full_finish (ctx->modem, res, &inner_error);
     if (!result) {
-        mm_warn ("QMI connection status failed: %s", error->message);
-        if (!g_error_matches (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN)) {
-            g_task_return_error (task, error);
-            g_object_unref (task);
-            return;
+        mm_warn ("QMI connection status failed: %s", inner_error->message);
+        if (!g_error_matches (inner_error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN)) {
+            g_propagate_error (error, inner_error);
+            return MM_BROADBAND_BEARER_POLL_FAILED;
         }
-        g_error_free (error);
+        g_error_free (inner_error);
         result = "Unknown error";
     } else if (is_qmistatus_connected (result)) {
-        MMBearerIpConfig *config;
-
         mm_dbg("Connected");
-        config = mm_bearer_ip_config_new ();
-        mm_bearer_ip_config_set_method (config, MM_BEARER_IP_METHOD_DHCP);
-        g_task_return_pointer (
-            task,
-            mm_bearer_connect_result_new (ctx->data, config, NULL),
-            (GDestroyNotify)mm_bearer_connect_result_unref);
-        g_object_unref (task);
-        g_object_unref (config);
-        return;
+        return MM_BROADBAND_BEARER_POLL_DONE;
     } else if (is_qmistatus_call_failed (result)) {
         /* Don't retry if the call failed */
-        ctx->retries = 0;
+        poll_result = MM_BROADBAND_BEARER_POLL_FAILED;
     }
 
     mm_dbg ("Error: '%s'", result);
 
-    if (ctx->retries > 0) {
-        ctx->retries--;
-        mm_dbg ("Retrying status check in a second. %d retries left.",
-                ctx->retries);
-        g_timeout_add_seconds (1, (GSourceFunc)connect_3gpp_qmistatus, task);
-        return;
-    }
-
-    /* Already exhausted all retries */
+    /* Becomes the final error if the call failed or if polling times out */
     normalized_result = normalize_qmistatus (result);
-    g_task_return_new_error (task,
-                             MM_CORE_ERROR,
-                             MM_CORE_ERROR_FAILED,
-                             "QMI connect failed: %s",
-                             normalized_result);
-    g_object_unref (task);
+    g_set_error (error,
+                 MM_CORE_ERROR,
+                 MM_CORE_ERROR_FAILED,
+                 "QMI connect failed: %s",
+                 normalized_result);
     g_free (normalized_result);
+    return poll_result;
 }
 
-static gboolean
-connect_3gpp_qmistatus (GTask *task)
+static void
+connect_3gpp_qmistatus_poll_ready (MMBroadbandBearer *self,
+                                   GAsyncResult      *res,
+                                   GTask             *task)
 {
     DetailedConnectContext *ctx;
+    MMBearerIpConfig *config;
+    GError *error = NULL;
 
-    ctx = g_task_get_task_data (task);
+    if (!mm_broadband_bearer_connect_poll_finish (self, res, &error)) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
 
-    mm_base_modem_at_command_full (
-        ctx->modem,
-        ctx->primary,
-        "$NWQMISTATUS",
-        3, /* timeout */
-        FALSE, /* allow_cached */
-        FALSE, /* is_raw */
-        g_task_get_cancellable (task),
-        (GAsyncReadyCallback)connect_3gpp_qmistatus_ready, /* callback */
-        task); /* user_data */
+    ctx = g_task_get_task_data (task);
 
-    return G_SOURCE_REMOVE;
+    config = mm_bearer_ip_config_new ();
+    mm_bearer_ip_config_set_method (config, MM_BEARER_IP_METHOD_DHCP);
+    g_task_return_pointer (
+        task,
+        mm_bearer_connect_result_new (ctx->data, config, NULL),
+        (GDestroyNotify)mm_bearer_connect_result_unref);
+    g_object_unref (task);
+    g_object_unref (config);
 }
 
 static void
@@ -278,9 +282,16 @@ connect_3gpp_qmiconnect_ready (MMBaseModem *modem,
      * The connection takes a bit of time to set up, but there's no
      * asynchronous notification from the modem when this has
      * happened. Instead, we need to poll the modem to see if it's
-     * ready.
+     * ready, for up to 1 minute.
      */
-    g_timeout_add_seconds (1, (GSourceFunc)connect_3gpp_qmistatus, task);
+    mm_broadband_bearer_connect_poll (MM_BROADBAND_BEARER (g_task_get_source_object (task)),
+                                      100, 1000, 60000,
+                                      (MMBroadbandBearerPollCheckFn) connect_3gpp_qmistatus_check,
+                                      (MMBroadbandBearerPollCheckFinishFn) connect_3gpp_qmistatus_check_finish,
+                                      task,
+                                      g_task_get_cancellable (task),
+                                      (GAsyncReadyCallback) connect_3gpp_qmistatus_poll_ready,
+                                      task);
 }
 
 static void
@@ -310,6 +321,7 @@ connect_3gpp_authenticate (GTask *task)
         10, /* timeout */
         FALSE, /* allow_cached */
         FALSE, /* is_raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         g_task_get_cancellable (task),
         (GAsyncReadyCallback)connect_3gpp_qmiconnect_ready,
         task); /* user_data */
@@ -331,7 +343,6 @@ connect_3gpp (MMBroadbandBearer *self,
     ctx = g_slice_new0 (DetailedConnectContext);
     ctx->modem = MM_BASE_MODEM (g_object_ref (modem));
     ctx->primary = g_object_ref (primary);
-    ctx->retries = 60;
 
     task = g_task_new (self, cancellable, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)detailed_connect_context_free);
@@ -449,6 +460,7 @@ disconnect_3gpp_qmistatus (GTask *task)
         3, /* timeout */
         FALSE, /* allow_cached */
         FALSE, /* is_raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)disconnect_3gpp_status_ready,
         task); /* user_data */
@@ -501,6 +513,7 @@ disconnect_3gpp (MMBroadbandBearer *self,
         10, /* timeout */
         FALSE, /* allow_cached */
         FALSE, /* is_raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)disconnect_3gpp_check_status,
         task); /* user_data */
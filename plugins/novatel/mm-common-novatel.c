@@ -117,6 +117,7 @@ custom_init_step (GTask *task)
                                    3,
                                    FALSE, /* raw */
                                    FALSE, /* allow_cached */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)nwdmat_ready,
                                    task);
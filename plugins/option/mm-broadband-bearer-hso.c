@@ -206,6 +206,7 @@ get_ip_config_3gpp (MMBroadbandBearer *self,
         3,
         FALSE,
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)ip_config_ready,
         task);
@@ -279,6 +280,7 @@ connect_reset (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)connect_reset_ready,
                                    task);
@@ -474,6 +476,7 @@ authenticate_ready (MMBaseModem  *modem,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback) activate_ready,
                                    g_object_ref (self)); /* we pass the bearer object! */
@@ -567,6 +570,7 @@ authenticate (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)authenticate_ready,
                                    task);
@@ -687,6 +691,7 @@ disconnect_3gpp (MMBroadbandBearer *self,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)disconnect_owancall_ready,
                                    task);
@@ -487,6 +487,7 @@ disable_location_gathering (MMIfaceModemLocation *self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)gps_disabled_ready,
                                        task);
@@ -591,6 +592,7 @@ parent_enable_location_gathering_ready (MMIfaceModemLocation *_self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)gps_enabled_ready,
                                        task);
@@ -688,7 +690,7 @@ setup_ports (MMBroadbandModem *self)
         mm_base_modem_at_command_full (MM_BASE_MODEM (self),
                                        gps_control_port,
                                        "_OGPS=0",
-                                       3, FALSE, FALSE, NULL, NULL, NULL);
+                                       3, FALSE, FALSE, MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, NULL, NULL, NULL);
 
         /* Add handler for the NMEA traces */
         mm_port_serial_gps_add_trace_handler (gps_data_port,
@@ -152,6 +152,7 @@ load_connection_status (MMBaseBearer        *self,
                                    3,
                                    FALSE, /* allow cached */
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback) scact_periodic_query_ready,
                                    task);
@@ -310,6 +311,7 @@ dial_3gpp_context_step (GTask *task)
                                        10,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)cgatt_ready,
                                        task);
@@ -387,6 +389,7 @@ dial_3gpp_context_step (GTask *task)
                                            3,
                                            FALSE,
                                            FALSE, /* raw */
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                            NULL, /* cancellable */
                                            (GAsyncReadyCallback)authenticate_ready,
                                            task);
@@ -410,6 +413,7 @@ dial_3gpp_context_step (GTask *task)
                                            10,
                                            FALSE,
                                            FALSE, /* raw */
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                            NULL, /* cancellable */
                                            (GAsyncReadyCallback)scact_ready,
                                            task);
@@ -535,6 +539,7 @@ disconnect_3gpp (MMBroadbandBearer *self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)disconnect_scact_ready,
                                        task);
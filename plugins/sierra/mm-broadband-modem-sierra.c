@@ -776,6 +776,7 @@ load_current_modes (MMIfaceModem *self,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)selrat_query_ready,
                                    task);
@@ -894,6 +895,7 @@ set_current_modes (MMIfaceModem *self,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)selrat_set_ready,
                                    task);
@@ -213,6 +213,7 @@ sierra_custom_init_step (GTask *task)
         3,
         FALSE, /* raw */
         FALSE, /* allow_cached */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         cancellable,
         (GAsyncReadyCallback)gcap_ready,
         task);
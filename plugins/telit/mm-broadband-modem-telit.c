@@ -292,6 +292,7 @@ qss_setup_step (GTask *task)
                                            3,
                                            FALSE,
                                            FALSE, /* raw */
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                            NULL, /* cancellable */
                                            (GAsyncReadyCallback) telit_qss_enable_ready,
                                            task);
@@ -304,6 +305,7 @@ qss_setup_step (GTask *task)
                                                3,
                                                FALSE,
                                                FALSE, /* raw */
+                                               MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                                NULL, /* cancellable */
                                                (GAsyncReadyCallback) telit_qss_enable_ready,
                                                task);
@@ -1391,6 +1393,7 @@ parent_enable_unsolicited_events_ready (MMIfaceModem3gpp *self,
         5,
         FALSE,
         FALSE,
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)cind_set_ready,
         task);
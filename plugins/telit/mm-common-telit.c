@@ -263,6 +263,7 @@ telit_custom_init_step (GTask *task)
             2,
             FALSE, /* raw */
             FALSE, /* allow_cached */
+            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
             g_task_get_cancellable (task),
             (GAsyncReadyCallback)getportcfg_ready,
             task);
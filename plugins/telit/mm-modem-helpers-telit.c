@@ -25,100 +25,104 @@
 
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-modem-band-set.h"
 #include "mm-modem-helpers-telit.h"
 
 
+/*****************************************************************************/
+/* Telit band flag to MM bands maps */
+
+static const TelitToMMBandMap telit_2g_bands_map [] = {
+    { BND_FLAG_GSM900_DCS1800, {MM_MODEM_BAND_EGSM, MM_MODEM_BAND_DCS, MM_MODEM_BAND_UNKNOWN} }, /* 0 */
+    { BND_FLAG_GSM900_PCS1900, {MM_MODEM_BAND_EGSM, MM_MODEM_BAND_PCS, MM_MODEM_BAND_UNKNOWN} }, /* 1 */
+    { BND_FLAG_GSM850_DCS1800, {MM_MODEM_BAND_DCS, MM_MODEM_BAND_G850, MM_MODEM_BAND_UNKNOWN} }, /* 2 */
+    { BND_FLAG_GSM850_PCS1900, {MM_MODEM_BAND_PCS, MM_MODEM_BAND_G850, MM_MODEM_BAND_UNKNOWN} }, /* 3 */
+    { BND_FLAG_UNKNOWN, {}},
+};
+
+static const TelitToMMBandMap telit_3g_bands_map [] = {
+    { BND_FLAG_0, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_1, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_2, { MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_3, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_4, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_5, { MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_6, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_7, { MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UNKNOWN} },
+    { BND_FLAG_8, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_9, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_10, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_12, { MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
+    { BND_FLAG_13, { MM_MODEM_BAND_UTRAN_3, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_14, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_15, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_3, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_16, { MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_17, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_18, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
+    { BND_FLAG_19, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN }},
+    { BND_FLAG_20, { MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
+    { BND_FLAG_21, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
+    { BND_FLAG_UNKNOWN, {}},
+};
+
 /*****************************************************************************/
 /* Set current bands helpers */
 
+#define BAND_MASK_2G(band) ((guint64) 1 << ((band) - MM_MODEM_BAND_EGSM))
+#define BAND_MASK_3G(band) ((guint64) 1 << ((band) - MM_MODEM_BAND_UTRAN_1))
+
 void
 mm_telit_get_band_flag (GArray *bands_array,
                         gint *flag2g,
                         gint *flag3g,
                         gint *flag4g)
 {
-    guint mask2g = 0;
-    guint mask3g = 0;
-    guint mask4g = 0;
-    guint found4g = FALSE;
-    guint i;
-
-    for (i = 0; i < bands_array->len; i++) {
-        MMModemBand band = g_array_index (bands_array, MMModemBand, i);
-
-        if (flag2g != NULL) {
-            switch (band) {
-                case MM_MODEM_BAND_EGSM:
-                case MM_MODEM_BAND_DCS:
-                case MM_MODEM_BAND_PCS:
-                case MM_MODEM_BAND_G850:
-                    mask2g += 1 << band;
-                    break;
-                default:
-                    break;
-            }
-        }
-
-        if (flag3g != NULL) {
-            switch (band) {
-                case MM_MODEM_BAND_UTRAN_1:
-                case MM_MODEM_BAND_UTRAN_2:
-                case MM_MODEM_BAND_UTRAN_3:
-                case MM_MODEM_BAND_UTRAN_4:
-                case MM_MODEM_BAND_UTRAN_5:
-                case MM_MODEM_BAND_UTRAN_6:
-                case MM_MODEM_BAND_UTRAN_7:
-                case MM_MODEM_BAND_UTRAN_8:
-                case MM_MODEM_BAND_UTRAN_9:
-                    mask3g += 1 << band;
-                    break;
-                default:
-                    break;
-            }
-        }
+    MMModemBandSet bands;
 
-         if (flag4g != NULL &&
-             band >= MM_MODEM_BAND_EUTRAN_1 && band <= MM_MODEM_BAND_EUTRAN_44) {
-             mask4g += 1 << (band - MM_MODEM_BAND_EUTRAN_1);
-             found4g = TRUE;
-        }
-    }
+    mm_modem_band_set_clear (&bands);
+    mm_modem_band_set_add_array (&bands, bands_array);
 
-    /* Get 2G flag */
+    /* Get 2G flag; bit N of the mask is band EGSM + N */
     if (flag2g != NULL) {
-        if (mask2g == ((1 << MM_MODEM_BAND_EGSM) + (1 << MM_MODEM_BAND_DCS)))
+        guint64 mask2g;
+
+        mask2g = mm_modem_band_set_get_range_mask (&bands, MM_MODEM_BAND_EGSM, MM_MODEM_BAND_G850);
+        if (mask2g == (BAND_MASK_2G (MM_MODEM_BAND_EGSM) | BAND_MASK_2G (MM_MODEM_BAND_DCS)))
             *flag2g = 0;
-        else if (mask2g == ((1 << MM_MODEM_BAND_EGSM) + (1 << MM_MODEM_BAND_PCS)))
+        else if (mask2g == (BAND_MASK_2G (MM_MODEM_BAND_EGSM) | BAND_MASK_2G (MM_MODEM_BAND_PCS)))
             *flag2g = 1;
-        else if (mask2g == ((1 << MM_MODEM_BAND_G850) + (1 << MM_MODEM_BAND_DCS)))
+        else if (mask2g == (BAND_MASK_2G (MM_MODEM_BAND_G850) | BAND_MASK_2G (MM_MODEM_BAND_DCS)))
             *flag2g = 2;
-        else if (mask2g == ((1 << MM_MODEM_BAND_G850) + (1 << MM_MODEM_BAND_PCS)))
+        else if (mask2g == (BAND_MASK_2G (MM_MODEM_BAND_G850) | BAND_MASK_2G (MM_MODEM_BAND_PCS)))
             *flag2g = 3;
         else
             *flag2g = -1;
     }
 
-    /* Get 3G flag */
+    /* Get 3G flag; UTRAN 1 to 9 take all values from UTRAN 1 to UTRAN 7 */
     if (flag3g != NULL) {
-        if (mask3g == (1 << MM_MODEM_BAND_UTRAN_1))
+        guint64 mask3g;
+
+        mask3g = mm_modem_band_set_get_range_mask (&bands, MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_7);
+        if (mask3g == BAND_MASK_3G (MM_MODEM_BAND_UTRAN_1))
             *flag3g = 0;
-        else if (mask3g == (1 << MM_MODEM_BAND_UTRAN_2))
+        else if (mask3g == BAND_MASK_3G (MM_MODEM_BAND_UTRAN_2))
             *flag3g = 1;
-        else if (mask3g == (1 << MM_MODEM_BAND_UTRAN_5))
+        else if (mask3g == BAND_MASK_3G (MM_MODEM_BAND_UTRAN_5))
             *flag3g = 2;
-        else if (mask3g == ((1 << MM_MODEM_BAND_UTRAN_1) +
-                            (1 << MM_MODEM_BAND_UTRAN_2) +
-                            (1 << MM_MODEM_BAND_UTRAN_5)))
+        else if (mask3g == (BAND_MASK_3G (MM_MODEM_BAND_UTRAN_1) |
+                            BAND_MASK_3G (MM_MODEM_BAND_UTRAN_2) |
+                            BAND_MASK_3G (MM_MODEM_BAND_UTRAN_5)))
             *flag3g = 3;
-        else if (mask3g == ((1 << MM_MODEM_BAND_UTRAN_2) +
-                            (1 << MM_MODEM_BAND_UTRAN_5)))
+        else if (mask3g == (BAND_MASK_3G (MM_MODEM_BAND_UTRAN_2) |
+                            BAND_MASK_3G (MM_MODEM_BAND_UTRAN_5)))
             *flag3g = 4;
-        else if (mask3g == (1 << MM_MODEM_BAND_UTRAN_8))
+        else if (mask3g == BAND_MASK_3G (MM_MODEM_BAND_UTRAN_8))
             *flag3g = 5;
-        else if (mask3g == ((1 << MM_MODEM_BAND_UTRAN_1) +
-                            (1 << MM_MODEM_BAND_UTRAN_8)))
+        else if (mask3g == (BAND_MASK_3G (MM_MODEM_BAND_UTRAN_1) |
+                            BAND_MASK_3G (MM_MODEM_BAND_UTRAN_8)))
             *flag3g = 6;
-        else if (mask3g == (1 << MM_MODEM_BAND_UTRAN_4))
+        else if (mask3g == BAND_MASK_3G (MM_MODEM_BAND_UTRAN_4))
             *flag3g = 7;
         else
             *flag3g = -1;
@@ -126,8 +130,11 @@ mm_telit_get_band_flag (GArray *bands_array,
 
     /* 4G flag correspond to the mask */
     if (flag4g != NULL) {
-        if (found4g)
-            *flag4g = mask4g;
+        guint64 mask4g;
+
+        mask4g = mm_modem_band_set_get_range_mask (&bands, MM_MODEM_BAND_EUTRAN_1, MM_MODEM_BAND_EUTRAN_44);
+        if (mask4g)
+            *flag4g = (gint) mask4g;
         else
             *flag4g = -1;
     }
@@ -196,7 +203,7 @@ mm_telit_parse_bnd_response (const gchar *response,
                              GArray **supported_bands,
                              GError **error)
 {
-    GArray *bands = NULL;
+    MMModemBandSet bands;
     GMatchInfo *match_info = NULL;
     GRegex *r = NULL;
     gboolean ret = FALSE;
@@ -226,7 +233,7 @@ mm_telit_parse_bnd_response (const gchar *response,
         goto end;
     }
 
-    bands = g_array_new (TRUE, TRUE, sizeof (MMModemBand));
+    mm_modem_band_set_clear (&bands);
 
     if (modem_is_2g && !mm_telit_get_2g_mm_bands (match_info, &bands, error))
         goto end;
@@ -237,13 +244,10 @@ mm_telit_parse_bnd_response (const gchar *response,
     if (modem_is_4g && !mm_telit_get_4g_mm_bands (match_info, &bands, error))
         goto end;
 
-    *supported_bands = bands;
+    *supported_bands = mm_modem_band_set_to_array (&bands);
     ret = TRUE;
 
 end:
-    if (!ret && bands != NULL)
-        g_array_free (bands, TRUE);
-
     g_match_info_free (match_info);
     g_regex_unref (r);
 
@@ -252,7 +256,7 @@ end:
 
 gboolean
 mm_telit_get_2g_mm_bands (GMatchInfo *match_info,
-                          GArray **bands,
+                          MMModemBandSet *bands,
                           GError **error)
 {
     GArray *flags = NULL;
@@ -260,14 +264,6 @@ mm_telit_get_2g_mm_bands (GMatchInfo *match_info,
     guint i;
     gboolean ret = TRUE;
 
-    TelitToMMBandMap map [5] = {
-        { BND_FLAG_GSM900_DCS1800, {MM_MODEM_BAND_EGSM, MM_MODEM_BAND_DCS, MM_MODEM_BAND_UNKNOWN} }, /* 0 */
-        { BND_FLAG_GSM900_PCS1900, {MM_MODEM_BAND_EGSM, MM_MODEM_BAND_PCS, MM_MODEM_BAND_UNKNOWN} }, /* 1 */
-        { BND_FLAG_GSM850_DCS1800, {MM_MODEM_BAND_DCS, MM_MODEM_BAND_G850, MM_MODEM_BAND_UNKNOWN} }, /* 2 */
-        { BND_FLAG_GSM850_PCS1900, {MM_MODEM_BAND_PCS, MM_MODEM_BAND_G850, MM_MODEM_BAND_UNKNOWN} }, /* 3 */
-        { BND_FLAG_UNKNOWN, {}},
-    };
-
     match_str = g_match_info_fetch_named (match_info, "Bands2G");
 
     if (match_str == NULL || match_str[0] == '\0') {
@@ -288,7 +284,7 @@ mm_telit_get_2g_mm_bands (GMatchInfo *match_info,
         guint flag;
 
         flag = g_array_index (flags, guint, i);
-        if (!mm_telit_update_band_array (flag, map, bands, error)) {
+        if (!mm_telit_update_band_set (flag, telit_2g_bands_map, bands, error)) {
             ret = FALSE;
             goto end;
         }
@@ -305,7 +301,7 @@ end:
 
 gboolean
 mm_telit_get_3g_mm_bands (GMatchInfo *match_info,
-                          GArray **bands,
+                          MMModemBandSet *bands,
                           GError **error)
 {
     GArray *flags = NULL;
@@ -313,31 +309,6 @@ mm_telit_get_3g_mm_bands (GMatchInfo *match_info,
     guint i;
     gboolean ret = TRUE;
 
-    TelitToMMBandMap map [] = {
-        { BND_FLAG_0, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_1, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_2, { MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_3, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_4, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_5, { MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_6, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_7, { MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UNKNOWN} },
-        { BND_FLAG_8, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_9, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_10, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_12, { MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
-        { BND_FLAG_13, { MM_MODEM_BAND_UTRAN_3, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_14, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_15, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_3, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_16, { MM_MODEM_BAND_UTRAN_8, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_17, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_4, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_18, { MM_MODEM_BAND_UTRAN_1, MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
-        { BND_FLAG_19, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN }},
-        { BND_FLAG_20, { MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
-        { BND_FLAG_21, { MM_MODEM_BAND_UTRAN_2, MM_MODEM_BAND_UTRAN_5, MM_MODEM_BAND_UTRAN_6, MM_MODEM_BAND_UNKNOWN}},
-        { BND_FLAG_UNKNOWN, {}},
-    };
-
     match_str = g_match_info_fetch_named (match_info, "Bands3G");
 
     if (match_str == NULL || match_str[0] == '\0') {
@@ -358,7 +329,7 @@ mm_telit_get_3g_mm_bands (GMatchInfo *match_info,
         guint flag;
 
         flag = g_array_index (flags, guint, i);
-        if (!mm_telit_update_band_array (flag, map, bands, error)) {
+        if (!mm_telit_update_band_set (flag, telit_3g_bands_map, bands, error)) {
             ret = FALSE;
             goto end;
         }
@@ -375,13 +346,11 @@ end:
 
 gboolean
 mm_telit_get_4g_mm_bands (GMatchInfo *match_info,
-                          GArray **bands,
+                          MMModemBandSet *bands,
                           GError **error)
 {
-    MMModemBand band;
     gboolean ret = TRUE;
     gchar *match_str = NULL;
-    guint i;
     guint value;
     gchar **tokens;
 
@@ -409,13 +378,7 @@ mm_telit_get_4g_mm_bands (GMatchInfo *match_info,
         sscanf (match_str, "%d", &value);
     }
 
-    for (i = 0; value > 0; i++) {
-        if (value % 2 != 0) {
-            band = MM_MODEM_BAND_EUTRAN_1 + i;
-            g_array_append_val (*bands, band);
-        }
-        value = value >> 1;
-    }
+    mm_modem_band_set_add_range_mask (bands, MM_MODEM_BAND_EUTRAN_1, value);
 
 end:
     g_free (match_str);
@@ -424,35 +387,18 @@ end:
 }
 
 gboolean
-mm_telit_bands_contains (GArray *mm_bands, const MMModemBand mm_band)
-{
-    guint i;
-
-    for (i = 0; i < mm_bands->len; i++) {
-        if (mm_band == g_array_index (mm_bands, MMModemBand, i))
-            return TRUE;
-    }
-
-    return FALSE;
-}
-
-gboolean
-mm_telit_update_band_array (const gint bands_flag,
-                            const TelitToMMBandMap *map,
-                            GArray **bands,
-                            GError **error)
+mm_telit_update_band_set (const gint bands_flag,
+                          const TelitToMMBandMap *map,
+                          MMModemBandSet *bands,
+                          GError **error)
 {
     guint i;
     guint j;
 
     for (i = 0; map[i].flag != BND_FLAG_UNKNOWN; i++) {
         if (bands_flag == map[i].flag) {
-            for (j = 0; map[i].mm_bands[j] != MM_MODEM_BAND_UNKNOWN; j++) {
-                if (!mm_telit_bands_contains (*bands, map[i].mm_bands[j])) {
-                    g_array_append_val (*bands, map[i].mm_bands[j]);
-                }
-            }
-
+            for (j = 0; map[i].mm_bands[j] != MM_MODEM_BAND_UNKNOWN; j++)
+                mm_modem_band_set_add (bands, map[i].mm_bands[j]);
             return TRUE;
         }
     }
@@ -464,7 +410,6 @@ mm_telit_update_band_array (const gint bands_flag,
     return FALSE;
 }
 
-
 gboolean
 mm_telit_get_band_flags_from_string (const gchar *flag_str,
                                      GArray **band_flags,
@@ -18,6 +18,7 @@
 
 #include <glib.h>
 #include "ModemManager.h"
+#include "mm-modem-band-set.h"
 
 #define MAX_BANDS_LIST_LEN 20
 
@@ -77,17 +78,15 @@ mm_telit_parse_bnd_response (const gchar *response,
                              GError **error);
 
 
-gboolean mm_telit_bands_contains (GArray *mm_bands, const MMModemBand mm_band);
-
-gboolean mm_telit_update_band_array (const gint bands_flag,
-                                     const TelitToMMBandMap *map,
-                                     GArray **bands,
-                                     GError **error);
+gboolean mm_telit_update_band_set (const gint bands_flag,
+                                   const TelitToMMBandMap *map,
+                                   MMModemBandSet *bands,
+                                   GError **error);
 
 gboolean mm_telit_get_band_flags_from_string (const gchar *flag_str, GArray **band_flags, GError **error);
-gboolean mm_telit_get_2g_mm_bands(GMatchInfo *match_info, GArray **bands, GError **error);
-gboolean mm_telit_get_3g_mm_bands(GMatchInfo *match_info, GArray **bands, GError **error);
-gboolean mm_telit_get_4g_mm_bands(GMatchInfo *match_info, GArray **bands, GError **error);
+gboolean mm_telit_get_2g_mm_bands(GMatchInfo *match_info, MMModemBandSet *bands, GError **error);
+gboolean mm_telit_get_3g_mm_bands(GMatchInfo *match_info, MMModemBandSet *bands, GError **error);
+gboolean mm_telit_get_4g_mm_bands(GMatchInfo *match_info, MMModemBandSet *bands, GError **error);
 
 gboolean mm_telit_update_2g_bands(gchar *band_list, GMatchInfo **match_info, GArray **bands, GError **error);
 gboolean mm_telit_update_3g_bands(gchar *band_list, GMatchInfo **match_info, GArray **bands, GError **error);
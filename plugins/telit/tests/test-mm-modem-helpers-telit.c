@@ -26,20 +26,31 @@
 #include "mm-modem-helpers-telit.h"
 
 static void
-test_mm_bands_contains (void) {
-    GArray* mm_bands;
-    guint i = 1;
-
-    mm_bands = g_array_sized_new (FALSE, TRUE, sizeof (MMModemBand), 3);
-
-    for (i = 0; i < 3; i++)
-        g_array_append_val (mm_bands, i);
-
-    g_assert (mm_telit_bands_contains (mm_bands, 2));
-    g_assert (mm_telit_bands_contains (mm_bands, 2));
-    g_assert (!mm_telit_bands_contains (mm_bands, 3));
+test_mm_update_band_set (void) {
+    TelitToMMBandMap map [] = {
+        { 0, { MM_MODEM_BAND_EGSM, MM_MODEM_BAND_DCS, MM_MODEM_BAND_UNKNOWN } },
+        { 1, { MM_MODEM_BAND_EGSM, MM_MODEM_BAND_PCS, MM_MODEM_BAND_UNKNOWN } },
+        { BND_FLAG_UNKNOWN, {}},
+    };
+    MMModemBandSet bands;
+    GError *error = NULL;
 
-    g_array_free (mm_bands, TRUE);
+    mm_modem_band_set_clear (&bands);
+
+    /* Bands given by more than one flag are only added once */
+    g_assert (mm_telit_update_band_set (0, map, &bands, &error));
+    g_assert_no_error (error);
+    g_assert (mm_telit_update_band_set (1, map, &bands, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (mm_modem_band_set_count (&bands), ==, 3);
+    g_assert (mm_modem_band_set_contains (&bands, MM_MODEM_BAND_EGSM));
+    g_assert (mm_modem_band_set_contains (&bands, MM_MODEM_BAND_DCS));
+    g_assert (mm_modem_band_set_contains (&bands, MM_MODEM_BAND_PCS));
+    g_assert (!mm_modem_band_set_contains (&bands, MM_MODEM_BAND_G850));
+
+    g_assert (!mm_telit_update_band_set (2, map, &bands, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
 }
 
 typedef struct {
@@ -122,9 +133,9 @@ static BNDResponseTest supported_band_mapping_tests [] = {
                                                        MM_MODEM_BAND_DCS,
                                                        MM_MODEM_BAND_G850,
                                                        MM_MODEM_BAND_UTRAN_1,
-                                                       MM_MODEM_BAND_UTRAN_2,
                                                        MM_MODEM_BAND_UTRAN_5,
-                                                       MM_MODEM_BAND_UTRAN_8} },
+                                                       MM_MODEM_BAND_UTRAN_8,
+                                                       MM_MODEM_BAND_UTRAN_2} },
     { "#BND: (0-3),(0,2,5,6),(1-1)", TRUE, TRUE, TRUE, 8, { MM_MODEM_BAND_EGSM,
                                                          MM_MODEM_BAND_DCS,
                                                          MM_MODEM_BAND_PCS,
@@ -192,8 +203,8 @@ static BNDResponseTest current_band_mapping_tests [] = {
     { "#BND: 1,3", TRUE, TRUE, FALSE, 5, { MM_MODEM_BAND_EGSM,
                                            MM_MODEM_BAND_PCS,
                                            MM_MODEM_BAND_UTRAN_1,
-                                           MM_MODEM_BAND_UTRAN_2,
                                            MM_MODEM_BAND_UTRAN_5,
+                                           MM_MODEM_BAND_UTRAN_2,
                                          }
     },
     { "#BND: 2,7", TRUE, TRUE, FALSE, 3, { MM_MODEM_BAND_DCS,
@@ -489,7 +500,7 @@ int main (int argc, char **argv)
 
     g_test_init (&argc, &argv, NULL);
 
-    g_test_add_func ("/MM/telit/bands/supported/bands_contains", test_mm_bands_contains);
+    g_test_add_func ("/MM/telit/bands/supported/update_band_set", test_mm_update_band_set);
     g_test_add_func ("/MM/telit/bands/supported/parse_band_flag", test_parse_band_flag_str);
     g_test_add_func ("/MM/telit/bands/supported/parse_bands_response", test_parse_supported_bands_response);
     g_test_add_func ("/MM/telit/bands/current/parse_bands_response", test_parse_current_bands_response);
@@ -0,0 +1,711 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+/*
+ * Benchmarks of the AT response parsers in the core and plugin helpers.
+ *
+ * Every parser is run against a corpus of responses reported by real modems,
+ * and the average time and number of heap allocations per parse operation is
+ * reported. The benchmarks are not part of the test suite, they're only built
+ * and run on request; by default each parser is run just a few times, and the
+ * actual measurements are done in performance mode:
+ *
+ *   $ make -C plugins parser-benchmarks
+ *
+ * which is equivalent to:
+ *
+ *   $ make -C plugins test-parser-benchmarks
+ *   $ ./plugins/test-parser-benchmarks -m perf --verbose
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-log.h"
+#include "mm-modem-helpers.h"
+#include "mm-modem-helpers-huawei.h"
+#include "mm-modem-helpers-cinterion.h"
+#include "mm-modem-helpers-telit.h"
+#include "mm-modem-helpers-ublox.h"
+#include "mm-modem-helpers-xmm.h"
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#define QUICK_ITERATIONS 10
+#define PERF_ITERATIONS  20000
+
+/*****************************************************************************/
+/* Allocation counting
+ *
+ * Allocations done through GLib are counted with a custom memory vtable, which
+ * must be installed before any other GLib call. Newer GLib releases ignore
+ * custom vtables, so allocation counts are only reported if the vtable is
+ * actually in use. Only allocations done while a benchmark is being measured
+ * are counted. */
+
+static gboolean allocation_counter_available;
+static gboolean counting;
+static guint    n_allocations;
+
+static gpointer
+counting_malloc (gsize n_bytes)
+{
+    if (counting)
+        n_allocations++;
+    return malloc (n_bytes);
+}
+
+static gpointer
+counting_realloc (gpointer mem,
+                  gsize    n_bytes)
+{
+    if (counting)
+        n_allocations++;
+    return realloc (mem, n_bytes);
+}
+
+static gpointer
+counting_calloc (gsize n_blocks,
+                 gsize n_block_bytes)
+{
+    if (counting)
+        n_allocations++;
+    return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable counting_vtable = {
+    counting_malloc,
+    counting_realloc,
+    free,
+    counting_calloc,
+    counting_malloc,
+    counting_realloc,
+};
+
+static void
+allocation_counter_setup (void)
+{
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+    g_mem_set_vtable (&counting_vtable);
+    G_GNUC_END_IGNORE_DEPRECATIONS
+
+    /* Check whether allocations really go through the vtable */
+    counting = TRUE;
+    g_free (g_malloc (1));
+    counting = FALSE;
+    allocation_counter_available = (n_allocations > 0);
+}
+
+static void
+allocation_counter_start (void)
+{
+    n_allocations = 0;
+    counting = TRUE;
+}
+
+static guint
+allocation_counter_stop (void)
+{
+    counting = FALSE;
+    return n_allocations;
+}
+
+/*****************************************************************************/
+/* Parsers under test; each one releases everything that was allocated while
+ * parsing, and returns whether the response was successfully parsed. */
+
+typedef gboolean (* ParseFunc) (const gchar  *response,
+                                GError      **error);
+
+static gboolean
+parse_cops_test (const gchar  *response,
+                 GError      **error)
+{
+    GList *list;
+
+    list = mm_3gpp_parse_cops_test_response (response, error);
+    mm_3gpp_network_info_list_free (list);
+    return !!list;
+}
+
+static gboolean
+parse_cops_read (const gchar  *response,
+                 GError      **error)
+{
+    guint                    mode;
+    guint                    format;
+    gchar                   *operator_id = NULL;
+    MMModemAccessTechnology  act;
+    gboolean                 success;
+
+    success = mm_3gpp_parse_cops_read_response (response, &mode, &format, &operator_id, &act, error);
+    g_free (operator_id);
+    return success;
+}
+
+static gboolean
+parse_cgdcont_test (const gchar  *response,
+                    GError      **error)
+{
+    GList *list;
+
+    list = mm_3gpp_parse_cgdcont_test_response (response, error);
+    mm_3gpp_pdp_context_format_list_free (list);
+    return !!list;
+}
+
+static gboolean
+parse_cgdcont_read (const gchar  *response,
+                    GError      **error)
+{
+    GList *list;
+
+    list = mm_3gpp_parse_cgdcont_read_response (response, error);
+    mm_3gpp_pdp_context_list_free (list);
+    return !!list;
+}
+
+static gboolean
+parse_cgact_read (const gchar  *response,
+                  GError      **error)
+{
+    GList *list;
+
+    list = mm_3gpp_parse_cgact_read_response (response, error);
+    mm_3gpp_pdp_context_active_list_free (list);
+    return !!list;
+}
+
+static gboolean
+parse_creg (const gchar  *response,
+            GError      **error)
+{
+    MMModem3gppRegistrationState state;
+    MMModemAccessTechnology      act;
+    gulong                       lac;
+    gulong                       ci;
+    gboolean                     cgreg;
+    gboolean                     cereg;
+
+    return mm_3gpp_parse_creg_response (response, &state, &lac, &ci, &act, &cgreg, &cereg, error);
+}
+
+/* Reference for the registration report parser: the list of regular
+ * expressions that used to be tried in turn on every report, compiled once in
+ * main(). Each captured field is fetched, as the GMatchInfo based parser did,
+ * so that both benchmarks do comparable work. */
+static const gchar *creg_legacy_patterns[] = {
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9])$",
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])$",
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)$",
+    "\\+(CREG|CGREG|CEREG):\\s*([0-9]),\\s*([0-9])\\s*,\\s*([^,]*)\\s*,\\s*([^,\\s]*)$",
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*(\"[^,]*\")\\s*,\\s*(\"[^,\\s]*\")$",
+    "\\+(CREG|CGREG|CEREG):\\s*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([0-9])$",
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9])\\s*,\\s*(\"[^,\\s]*\")\\s*,\\s*(\"[^,\\s]*\")\\s*,\\s*0*([0-9])$",
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])$",
+    "\\+(CREG|CGREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*[^,\\s]*$",
+    "\\+(CREG|CGREG):\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])\\s*,\\s*([^,\\s]*)$",
+    "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*(\"[^\"\\s]*\")\\s*,\\s*(\"[^\"\\s]*\")$",
+    "\\+(CEREG):\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])$",
+    "\\+(CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])$",
+};
+
+static GPtrArray *creg_legacy_regexes;
+
+static gboolean
+parse_creg_regex_array (const gchar  *response,
+                        GError      **error)
+{
+    guint i;
+
+    for (i = 0; i < creg_legacy_regexes->len; i++) {
+        GMatchInfo *info = NULL;
+        gint        j;
+
+        if (!g_regex_match ((GRegex *) g_ptr_array_index (creg_legacy_regexes, i), response, 0, &info)) {
+            g_match_info_free (info);
+            continue;
+        }
+
+        for (j = 1; j < g_match_info_get_match_count (info); j++)
+            g_free (g_match_info_fetch (info, j));
+        g_match_info_free (info);
+        return TRUE;
+    }
+
+    g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "No registration regex matched");
+    return FALSE;
+}
+
+static gboolean
+parse_cind_test (const gchar  *response,
+                 GError      **error)
+{
+    GHashTable *table;
+
+    table = mm_3gpp_parse_cind_test_response (response, error);
+    if (!table)
+        return FALSE;
+    g_hash_table_unref (table);
+    return TRUE;
+}
+
+static gboolean
+parse_cind_read (const gchar  *response,
+                 GError      **error)
+{
+    GByteArray *array;
+
+    array = mm_3gpp_parse_cind_read_response (response, error);
+    if (!array)
+        return FALSE;
+    g_byte_array_unref (array);
+    return TRUE;
+}
+
+static gboolean
+parse_cmgl (const gchar  *response,
+            GError      **error)
+{
+    GList *list;
+
+    list = mm_3gpp_parse_pdu_cmgl_response (response, error);
+    mm_3gpp_pdu_info_list_free (list);
+    return !!list;
+}
+
+static gboolean
+parse_ws46_test (const gchar  *response,
+                 GError      **error)
+{
+    GArray *array;
+
+    array = mm_3gpp_parse_ws46_test_response (response, error);
+    if (!array)
+        return FALSE;
+    g_array_unref (array);
+    return TRUE;
+}
+
+static gboolean
+parse_cesq (const gchar  *response,
+            GError      **error)
+{
+    guint rxlev, ber, rscp, ecn0, rsrq, rsrp;
+
+    return mm_3gpp_parse_cesq_response (response, &rxlev, &ber, &rscp, &ecn0, &rsrq, &rsrp, error);
+}
+
+static gboolean
+parse_huawei_syscfgex_test (const gchar  *response,
+                            GError      **error)
+{
+    GArray *array;
+
+    array = mm_huawei_parse_syscfgex_test (response, error);
+    if (!array)
+        return FALSE;
+    g_array_unref (array);
+    return TRUE;
+}
+
+static gboolean
+parse_huawei_hcsq (const gchar  *response,
+                   GError      **error)
+{
+    MMModemAccessTechnology act;
+    guint                   value1, value2, value3, value4, value5;
+
+    return mm_huawei_parse_hcsq_response (response, &act, &value1, &value2, &value3, &value4, &value5, error);
+}
+
+static gboolean
+parse_huawei_ndisstatqry (const gchar  *response,
+                          GError      **error)
+{
+    gboolean ipv4_available, ipv4_connected, ipv6_available, ipv6_connected;
+
+    return mm_huawei_parse_ndisstatqry_response (response,
+                                                 &ipv4_available, &ipv4_connected,
+                                                 &ipv6_available, &ipv6_connected,
+                                                 error);
+}
+
+static gboolean
+parse_ublox_uact_test (const gchar  *response,
+                       GError      **error)
+{
+    GArray *bands_2g = NULL;
+    GArray *bands_3g = NULL;
+    GArray *bands_4g = NULL;
+
+    if (!mm_ublox_parse_uact_test (response, &bands_2g, &bands_3g, &bands_4g, error))
+        return FALSE;
+
+    if (bands_2g)
+        g_array_unref (bands_2g);
+    if (bands_3g)
+        g_array_unref (bands_3g);
+    if (bands_4g)
+        g_array_unref (bands_4g);
+    return TRUE;
+}
+
+static gboolean
+parse_ublox_uact_read (const gchar  *response,
+                       GError      **error)
+{
+    GArray *bands;
+
+    bands = mm_ublox_parse_uact_response (response, error);
+    if (!bands)
+        return FALSE;
+    g_array_unref (bands);
+    return TRUE;
+}
+
+static gboolean
+parse_cinterion_scfg_test (const gchar  *response,
+                           GError      **error)
+{
+    GArray *bands = NULL;
+
+    if (!mm_cinterion_parse_scfg_test (response, MM_MODEM_CHARSET_UNKNOWN, &bands, error))
+        return FALSE;
+    g_array_unref (bands);
+    return TRUE;
+}
+
+static gboolean
+parse_cinterion_scfg_read (const gchar  *response,
+                           GError      **error)
+{
+    GArray *bands = NULL;
+
+    if (!mm_cinterion_parse_scfg_response (response, MM_MODEM_CHARSET_UNKNOWN, &bands, error))
+        return FALSE;
+    g_array_unref (bands);
+    return TRUE;
+}
+
+static gboolean
+parse_telit_bnd (const gchar          *response,
+                 MMTelitLoadBandsType  band_type,
+                 GError              **error)
+{
+    GArray *bands = NULL;
+
+    if (!mm_telit_parse_bnd_response (response, TRUE, TRUE, TRUE, band_type, &bands, error))
+        return FALSE;
+    g_array_unref (bands);
+    return TRUE;
+}
+
+static gboolean
+parse_telit_bnd_test (const gchar  *response,
+                      GError      **error)
+{
+    return parse_telit_bnd (response, LOAD_SUPPORTED_BANDS, error);
+}
+
+static gboolean
+parse_telit_bnd_read (const gchar  *response,
+                      GError      **error)
+{
+    return parse_telit_bnd (response, LOAD_CURRENT_BANDS, error);
+}
+
+static gboolean
+parse_xmm_xact_test (const gchar  *response,
+                     GError      **error)
+{
+    GArray *modes = NULL;
+    GArray *bands = NULL;
+
+    if (!mm_xmm_parse_xact_test_response (response, &modes, &bands, error))
+        return FALSE;
+
+    if (modes)
+        g_array_unref (modes);
+    if (bands)
+        g_array_unref (bands);
+    return TRUE;
+}
+
+static gboolean
+parse_xmm_xact_read (const gchar  *response,
+                     GError      **error)
+{
+    MMModemModeCombination  mode;
+    GArray                 *bands = NULL;
+
+    if (!mm_xmm_parse_xact_query_response (response, &mode, &bands, error))
+        return FALSE;
+
+    if (bands)
+        g_array_unref (bands);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Corpus */
+
+typedef struct {
+    const gchar *name;
+    ParseFunc    parse;
+    const gchar *response;
+} ParserBenchmark;
+
+static const ParserBenchmark benchmarks[] = {
+    {
+        "3gpp/cops-test", parse_cops_test,
+        "+COPS: (2,\"T-Mobile US\",\"TMO US\",\"31026\",0),(1,\"AT&T\",\"AT&T\",\"310410\",2),"
+        "(1,\"AT&T\",\"AT&T\",\"310410\",0),,(0,1,2,3,4),(0,1,2)"
+    },
+    {
+        "3gpp/cops-read", parse_cops_read,
+        "+COPS: 1,0,\"CHINA MOBILE\",7"
+    },
+    {
+        "3gpp/cgdcont-test", parse_cgdcont_test,
+        "+CGDCONT: (1-10),\"IP\",,,(0,1),(0,1)\r\n"
+        "+CGDCONT: (1-10),\"IPV6\",,,(0,1),(0,1)\r\n"
+        "+CGDCONT: (1-10),\"IPV4V6\",,,(0,1),(0,1)\r\n"
+    },
+    {
+        "3gpp/cgdcont-read", parse_cgdcont_read,
+        "+CGDCONT: 1,\"IP\",\"nate.sktelecom.com\",\"\",0,0\r\n"
+        "+CGDCONT: 2,\"IP\",\"epc.tmobile.com\",\"\",0,0\r\n"
+        "+CGDCONT: 3,\"IP\",\"MAXROAM.com\",\"\",0,0\r\n"
+    },
+    {
+        "3gpp/cgact-read", parse_cgact_read,
+        "+CGACT: 1,0\r\n"
+        "+CGACT: 4,1\r\n"
+        "+CGACT: 5,0\r\n"
+    },
+    {
+        "3gpp/creg", parse_creg,
+        "+CGREG: 2,1,\"8BE3\",\"00002B5D\",3"
+    },
+    {
+        "3gpp/creg-regex-array", parse_creg_regex_array,
+        "+CGREG: 2,1,\"8BE3\",\"00002B5D\",3"
+    },
+    {
+        "3gpp/cind-test", parse_cind_test,
+        "+CIND: (\"battchg\",(0-5)),(\"signal\",(0-5)),(\"batterywarning\",(0-1)),(\"chargerconnected\",(0-1)),"
+        "(\"service\",(0-1)),(\"sounder\",(0-1)),(\"message\",(0-1)),(\"call\",(0-1)),(\"roam\",(0-1)),"
+        "(\"smsfull\",(0-1))"
+    },
+    {
+        "3gpp/cind-read", parse_cind_read,
+        "+CIND: 5,3,0,0,1,0,0,0,0,0"
+    },
+    {
+        "3gpp/cmgl", parse_cmgl,
+        "+CMGL: 0,1,,147\r\n07914306073011F00405812261F700003130916191314095C27"
+        "4D96D2FBBD3E437280CB2BEC961F3DB5D76818EF2F0381D9E83E06F39A8CC2E9FD372F"
+        "77BEE0249CBE37A594E0E83E2F532085E2F93CB73D0B93CA7A7DFEEB01C447F93DF731"
+        "0BD3E07CDCB727B7A9C7ECF41E432C8FC96B7C32079189E26874179D0F8DD7E93C3A0B"
+        "21B246AA641D637396C7EBBCB22D0FD7E77B5D376B3AB3C07\r\n"
+        "+CMGL: 1,1,,147\r\n07914306073011F00405812261F700003130916191314095C27"
+        "4D96D2FBBD3E437280CB2BEC961F3DB5D76818EF2F0381D9E83E06F39A8CC2E9FD372F"
+        "77BEE0249CBE37A594E0E83E2F532085E2F93CB73D0B93CA7A7DFEEB01C447F93DF731"
+        "0BD3E07CDCB727B7A9C7ECF41E432C8FC96B7C32079189E26874179D0F8DD7E93C3A0B"
+        "21B246AA641D637396C7EBBCB22D0FD7E77B5D376B3AB3C07\r\n"
+        "+CMGL: 2,1,,147\r\n07914306073011F00405812261F700003130916191314095C27"
+        "4D96D2FBBD3E437280CB2BEC961F3DB5D76818EF2F0381D9E83E06F39A8CC2E9FD372F"
+        "77BEE0249CBE37A594E0E83E2F532085E2F93CB73D0B93CA7A7DFEEB01C447F93DF731"
+        "0BD3E07CDCB727B7A9C7ECF41E432C8FC96B7C32079189E26874179D0F8DD7E93C3A0B"
+        "21B246AA641D637396C7EBBCB22D0FD7E77B5D376B3AB3C07"
+    },
+    {
+        "3gpp/ws46-test", parse_ws46_test,
+        "+WS46: (12,22,25,28,29)"
+    },
+    {
+        "3gpp/cesq", parse_cesq,
+        "+CESQ: 99,99,255,255,20,80"
+    },
+    {
+        "huawei/syscfgex-test", parse_huawei_syscfgex_test,
+        "^SYSCFGEX: (\"00\",\"03\",\"02\",\"01\",\"99\"),"
+        "((2000004e80380,\"GSM850/GSM900/GSM1800/GSM1900/WCDMA850/WCDMA900/WCDMA1900/WCDMA2100\"),(3fffffff,\"All Bands\")),"
+        "(0-3),"
+        "(0-4),"
+        "((800c5,\"LTE2100/LTE1800/LTE2600/LTE900/LTE800\"),(7fffffffffffffff,\"All bands\"))"
+        "\r\n"
+    },
+    {
+        "huawei/hcsq", parse_huawei_hcsq,
+        "^HCSQ:\"LTE\",30,19,66,0\r\n"
+    },
+    {
+        "huawei/ndisstatqry", parse_huawei_ndisstatqry,
+        "^NDISSTATQRY: 1,,,IPV4\r\n"
+    },
+    {
+        "ublox/uact-test", parse_ublox_uact_test,
+        "+UACT: ,,,(900,1800),(1,8),(101,103,107,108,120),(138)\r\n"
+    },
+    {
+        "ublox/uact-read", parse_ublox_uact_read,
+        "+UACT: ,,,900,1800,1900,850,1,2,3,4,5,6,7,8,9,101,102,103,104,105,106,107,108,109\r\n"
+    },
+    {
+        "cinterion/scfg-test", parse_cinterion_scfg_test,
+        "^SCFG: \"Audio/Loop\",(\"0\",\"1\")\r\n"
+        "^SCFG: \"Call/ECC\",(\"0\"-\"255\")\r\n"
+        "^SCFG: \"GPRS/Auth\",(\"0\",\"1\",\"2\")\r\n"
+        "^SCFG: \"GPRS/AutoAttach\",(\"disabled\",\"enabled\")\r\n"
+        "^SCFG: \"Ident/Manufacturer\",(25)\r\n"
+        "^SCFG: \"MEopMode/Airplane\",(\"off\",\"on\")\r\n"
+        "^SCFG: \"MEopMode/PwrSave\",(\"disabled\",\"enabled\"),(\"0-600\"),(\"1-36000\")\r\n"
+        "^SCFG: \"Radio/Band\",(\"1-511\",\"0-1\")\r\n"
+        "^SCFG: \"Radio/NWSM\",(\"0\",\"1\",\"2\")\r\n"
+        "^SCFG: \"Serial/USB/DDD\",(\"0\",\"1\"),(\"0\"),(4),(4),(4),(63),(63),(4)\r\n"
+        "^SCFG: \"URC/DstIfc\",(\"mdm\",\"app\")\r\n"
+    },
+    {
+        "cinterion/scfg-read", parse_cinterion_scfg_read,
+        "^SCFG: \"Radio/Band\",\"3\",\"3\"\r\n"
+        "\r\n"
+    },
+    {
+        "telit/bnd-test", parse_telit_bnd_test,
+        "#BND: (0-3),(0,2,5,6),(1-1)"
+    },
+    {
+        "telit/bnd-read", parse_telit_bnd_read,
+        "#BND: 3,0,1"
+    },
+    {
+        "xmm/xact-test", parse_xmm_xact_test,
+        "+XACT: "
+        "(0-6),(0-2),0,"
+        "900,1800,1900,850,"
+        "1,2,4,5,8,"
+        "101,102,103,104,105,107,108,111,112,113,117,118,119,120,121,126,128,129,130,138,139,140,141,166"
+    },
+    {
+        "xmm/xact-read", parse_xmm_xact_read,
+        "+XACT: "
+        "1,1,,"
+        "1,2,4,5,8,"
+        "101,102,103,104,105,107,108,111,112,113,117,118,119,120,121,126,128,129,130,138,139,140,141,166"
+    },
+};
+
+/*****************************************************************************/
+
+static void
+run_benchmark (gconstpointer user_data)
+{
+    const ParserBenchmark *benchmark = user_data;
+    GError                *error = NULL;
+    guint                  n_iterations;
+    guint                  i;
+    gdouble                elapsed;
+    guint                  n_allocs;
+
+    /* The first run validates the response, and also warms up any lazily
+     * initialized state (e.g. GType registrations or quark lookups) so that
+     * it isn't accounted as part of the parser cost */
+    if (!benchmark->parse (benchmark->response, &error))
+        g_error ("couldn't parse '%s' response: %s", benchmark->name, error ? error->message : "unknown error");
+    g_assert_no_error (error);
+
+    n_iterations = g_test_perf () ? PERF_ITERATIONS : QUICK_ITERATIONS;
+
+    allocation_counter_start ();
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        benchmark->parse (benchmark->response, NULL);
+    elapsed = g_test_timer_elapsed ();
+    n_allocs = allocation_counter_stop ();
+
+    g_test_minimized_result ((elapsed * 1e9) / n_iterations,
+                             "%s: %.0f ns/op",
+                             benchmark->name, (elapsed * 1e9) / n_iterations);
+    if (allocation_counter_available)
+        g_test_minimized_result ((gdouble) n_allocs / n_iterations,
+                                 "%s: %.1f allocs/op",
+                                 benchmark->name, (gdouble) n_allocs / n_iterations);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32     level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    guint i;
+    gint  ret;
+
+    /* Slice allocations must also go through g_malloc() to be accounted */
+    setenv ("G_SLICE", "always-malloc", TRUE);
+    allocation_counter_setup ();
+
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    creg_legacy_regexes = g_ptr_array_new_with_free_func ((GDestroyNotify) g_regex_unref);
+    for (i = 0; i < G_N_ELEMENTS (creg_legacy_patterns); i++)
+        g_ptr_array_add (creg_legacy_regexes,
+                         g_regex_new (creg_legacy_patterns[i], G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL));
+
+    for (i = 0; i < G_N_ELEMENTS (benchmarks); i++) {
+        gchar *path;
+
+        path = g_strdup_printf ("/MM/parsers/benchmark/%s", benchmarks[i].name);
+        g_test_add_data_func (path, &benchmarks[i], run_benchmark);
+        g_free (path);
+    }
+
+    ret = g_test_run ();
+
+    g_ptr_array_unref (creg_legacy_regexes);
+
+    return ret;
+}
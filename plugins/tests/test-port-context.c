@@ -18,6 +18,7 @@
 #include <string.h>
 
 #include "test-port-context.h"
+#include "mm-cmux.h"
 
 #define BUFFER_SIZE 1024
 
@@ -33,6 +34,7 @@ struct _TestPortContext {
     GSocketService *socket_service;
     GList *clients;
     GHashTable *commands;
+    gboolean cmux;
 };
 
 /*****************************************************************************/
@@ -47,6 +49,13 @@ test_port_context_set_command (TestPortContext *self,
     g_hash_table_replace (self->commands, g_strdup (command), g_strcompress (response));
 }
 
+void
+test_port_context_set_cmux (TestPortContext *self,
+                            gboolean enabled)
+{
+    self->cmux = enabled;
+}
+
 void
 test_port_context_load_commands (TestPortContext *self,
                                  const gchar *file)
@@ -94,12 +103,14 @@ test_port_context_load_commands (TestPortContext *self,
 
 static const gchar *
 process_next_command (TestPortContext *ctx,
-                      GByteArray *buffer)
+                      GByteArray *buffer,
+                      gboolean *cmux_requested)
 {
     gsize i = 0;
     gchar *command;
     const gchar *response;
     static const gchar *error_response = "\r\nERROR\r\n";
+    static const gchar *ok_response = "\r\nOK\r\n";
 
     /* Find command end */
     while (i < buffer->len && buffer->data[i] != '\r' && buffer->data[i] != '\n')
@@ -113,7 +124,11 @@ process_next_command (TestPortContext *ctx,
 
     /* Setup command and lookup response */
     command = g_strndup ((gchar *)buffer->data, i);
-    response = g_hash_table_lookup (ctx->commands, command);
+    if (cmux_requested && ctx->cmux && g_str_has_prefix (command, "AT+CMUX=")) {
+        *cmux_requested = TRUE;
+        response = ok_response;
+    } else
+        response = ctx->commands ? g_hash_table_lookup (ctx->commands, command) : NULL;
     g_free (command);
 
     /* Remove command from buffer */
@@ -129,16 +144,25 @@ typedef struct {
     GSocketConnection *connection;
     GSource *connection_readable_source;
     GByteArray *buffer;
+    /* CMUX emulation, per-DLCI input */
+    gboolean cmux;
+    GByteArray *dlci_buffers[MM_CMUX_DLCI_MAX + 1];
 } Client;
 
 static void
 client_free (Client *client)
 {
+    guint i;
+
     g_source_destroy (client->connection_readable_source);
     g_source_unref (client->connection_readable_source);
     g_output_stream_close (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)), NULL, NULL);
     if (client->buffer)
         g_byte_array_unref (client->buffer);
+    for (i = 0; i <= MM_CMUX_DLCI_MAX; i++) {
+        if (client->dlci_buffers[i])
+            g_byte_array_unref (client->dlci_buffers[i]);
+    }
     g_object_unref (client->connection);
     g_slice_free (Client, client);
 }
@@ -151,26 +175,140 @@ connection_close (Client *client)
 }
 
 static void
-client_parse_request (Client *client)
+client_send (Client *client,
+             const guint8 *data,
+             gsize len)
 {
-    const gchar *response;
+    GError *error = NULL;
 
+    if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
+                                    data,
+                                    len,
+                                    NULL, /* bytes_written */
+                                    NULL, /* cancellable */
+                                    &error)) {
+        g_warning ("Cannot send response to client: %s", error->message);
+        g_error_free (error);
+    }
+}
+
+static void
+client_send_frame (Client *client,
+                   guint8 dlci,
+                   guint8 type,
+                   gboolean pf,
+                   const guint8 *data,
+                   gsize len)
+{
+    GByteArray *frame;
+
+    /* We're the responder, so C/R is set in responses and cleared in commands */
+    frame = g_byte_array_new ();
     do {
-        response = process_next_command (client->ctx, client->buffer);
-        if (response) {
-            GError *error = NULL;
-
-            if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
-                                            response,
-                                            strlen (response),
-                                            NULL, /* bytes_written */
-                                            NULL, /* cancellable */
-                                            &error)) {
-                g_warning ("Cannot send response to client: %s", error->message);
-                g_error_free (error);
+        gsize chunk;
+
+        chunk = MIN (len, MM_CMUX_DEFAULT_FRAME_SIZE);
+        mm_cmux_frame_append (frame, dlci, type, pf, type != MM_CMUX_FRAME_TYPE_UIH, data, chunk);
+        data += chunk;
+        len -= chunk;
+    } while (len > 0);
+    client_send (client, frame->data, frame->len);
+    g_byte_array_unref (frame);
+}
+
+static void
+client_process_control (Client *client,
+                        const guint8 *data,
+                        gsize len)
+{
+    guint8 type;
+    gboolean cr;
+    const guint8 *value;
+    gsize value_len;
+    GByteArray *response;
+
+    if (!mm_cmux_control_message_parse (data, len, &type, &cr, &value, &value_len) || !cr)
+        return;
+
+    /* Reply to all commands echoing the value */
+    response = g_byte_array_new ();
+    mm_cmux_control_message_append (response, type, FALSE, value, value_len);
+    client_send_frame (client, 0, MM_CMUX_FRAME_TYPE_UIH, FALSE, response->data, response->len);
+    g_byte_array_unref (response);
+
+    /* Back to AT command mode */
+    if (type == MM_CMUX_CONTROL_TYPE_CLD)
+        client->cmux = FALSE;
+}
+
+static void
+client_parse_frames (Client *client)
+{
+    while (client->cmux && client->buffer->len > 0) {
+        MMCmuxFrame frame;
+        MMCmuxParseResult result;
+        gsize consumed = 0;
+
+        result = mm_cmux_frame_parse (client->buffer->data, client->buffer->len, &frame, &consumed);
+        if (result == MM_CMUX_PARSE_RESULT_FRAME) {
+            switch (frame.type) {
+            case MM_CMUX_FRAME_TYPE_SABM:
+            case MM_CMUX_FRAME_TYPE_DISC:
+                client_send_frame (client, frame.dlci, MM_CMUX_FRAME_TYPE_UA, frame.pf, NULL, 0);
+                break;
+            case MM_CMUX_FRAME_TYPE_UIH:
+                if (frame.dlci == 0) {
+                    client_process_control (client, frame.data, frame.len);
+                    break;
+                }
+                if (!client->dlci_buffers[frame.dlci])
+                    client->dlci_buffers[frame.dlci] = g_byte_array_new ();
+                g_byte_array_append (client->dlci_buffers[frame.dlci], frame.data, frame.len);
+                for (;;) {
+                    const gchar *response;
+
+                    response = process_next_command (client->ctx, client->dlci_buffers[frame.dlci], NULL);
+                    if (!response)
+                        break;
+                    client_send_frame (client, frame.dlci, MM_CMUX_FRAME_TYPE_UIH, FALSE,
+                                       (const guint8 *)response, strlen (response));
+                }
+                break;
+            default:
+                break;
             }
         }
 
+        if (consumed)
+            g_byte_array_remove_range (client->buffer, 0, MIN (consumed, client->buffer->len));
+        if (result == MM_CMUX_PARSE_RESULT_NEED_MORE)
+            break;
+    }
+}
+
+static void
+client_parse_request (Client *client)
+{
+    const gchar *response;
+
+    if (client->cmux) {
+        client_parse_frames (client);
+        return;
+    }
+
+    do {
+        gboolean cmux_requested = FALSE;
+
+        response = process_next_command (client->ctx, client->buffer, &cmux_requested);
+        if (response)
+            client_send (client, (const guint8 *)response, strlen (response));
+
+        /* Anything after the AT+CMUX command is already multiplexed */
+        if (cmux_requested) {
+            client->cmux = TRUE;
+            client_parse_frames (client);
+            return;
+        }
     } while (response);
 }
 
@@ -32,4 +32,9 @@ void             test_port_context_set_command   (TestPortContext *self,
 void             test_port_context_load_commands (TestPortContext *self,
                                                   const gchar *commands_file);
 
+/* When enabled, AT+CMUX switches the port to 3GPP TS 27.010 basic option
+ * multiplexing, and commands are processed in every DLCI */
+void             test_port_context_set_cmux      (TestPortContext *self,
+                                                  gboolean enabled);
+
 #endif /* TEST_PORT_CONTEXT_H */
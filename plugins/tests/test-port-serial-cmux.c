@@ -0,0 +1,178 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#define _GNU_SOURCE  /* for posix_openpt() */
+
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "test-port-context.h"
+#include "mm-port-serial-cmux.h"
+#include "mm-log.h"
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+/*****************************************************************************/
+
+typedef struct {
+    GMainLoop *loop;
+    GError    *error;
+    guint      n_pending;
+    gchar     *responses[MM_PORT_SERIAL_CMUX_CHANNEL_LAST + 1];
+} TestContext;
+
+static void
+start_ready (MMPortSerialCmux *cmux,
+             GAsyncResult     *res,
+             TestContext      *ctx)
+{
+    mm_port_serial_cmux_start_finish (cmux, res, &ctx->error);
+    g_main_loop_quit (ctx->loop);
+}
+
+static void
+command_ready (MMPortSerialAt *port,
+               GAsyncResult   *res,
+               TestContext    *ctx)
+{
+    const gchar *response;
+    GError      *error = NULL;
+    guint        i;
+
+    response = mm_port_serial_at_command_finish (port, res, &error);
+    g_assert_no_error (error);
+
+    for (i = MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL; i <= MM_PORT_SERIAL_CMUX_CHANNEL_LAST; i++) {
+        if (g_object_get_data (G_OBJECT (port), "test-channel") == GUINT_TO_POINTER (i))
+            ctx->responses[i] = g_strstrip (g_strdup (response));
+    }
+
+    if (--ctx->n_pending == 0)
+        g_main_loop_quit (ctx->loop);
+}
+
+static void
+test_cmux_channels (void)
+{
+    TestPortContext  *port_context;
+    MMPortSerialCmux *cmux;
+    TestContext       ctx = { 0 };
+    gchar            *name;
+    guint             i;
+    gint              fd;
+
+    /* Channels are exposed as pseudo-terminals, which may not be available
+     * when building in containers */
+    fd = posix_openpt (O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        g_test_message ("pseudo-terminals not available, skipping");
+        return;
+    }
+    close (fd);
+
+    /* Add process ID so that multiple runs of this test in the same system
+     * don't clash with each other */
+    name = g_strdup_printf ("abstract:cmux:%ld", (glong) getpid ());
+
+    port_context = test_port_context_new (name);
+    test_port_context_set_cmux (port_context, TRUE);
+    test_port_context_set_command (port_context, "AT+CGSN", "\\r\\n123456789012345\\r\\n\\r\\nOK\\r\\n");
+    test_port_context_start (port_context);
+
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+
+    cmux = mm_port_serial_cmux_new (name, MM_PORT_SUBSYS_UNIX);
+    mm_port_serial_cmux_start (cmux, NULL, (GAsyncReadyCallback) start_ready, &ctx);
+    g_main_loop_run (ctx.loop);
+    g_assert_no_error (ctx.error);
+    g_assert (mm_port_serial_cmux_is_running (cmux));
+
+    /* Run the same command in all channels at the same time */
+    for (i = MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL; i <= MM_PORT_SERIAL_CMUX_CHANNEL_LAST; i++) {
+        MMPortSerialAt *port;
+        GError         *error = NULL;
+
+        port = mm_port_serial_cmux_peek_channel (cmux, i);
+        g_assert (port != NULL);
+        g_object_set_data (G_OBJECT (port), "test-channel", GUINT_TO_POINTER (i));
+        g_object_set (port, MM_PORT_SERIAL_AT_INIT_SEQUENCE_ENABLED, FALSE, NULL);
+
+        mm_port_serial_open (MM_PORT_SERIAL (port), &error);
+        g_assert_no_error (error);
+
+        ctx.n_pending++;
+        mm_port_serial_at_command (port, "+CGSN", 3, FALSE, FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                   NULL,
+                                   (GAsyncReadyCallback) command_ready,
+                                   &ctx);
+    }
+    g_main_loop_run (ctx.loop);
+
+    for (i = MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL; i <= MM_PORT_SERIAL_CMUX_CHANNEL_LAST; i++) {
+        g_assert_cmpstr (ctx.responses[i], ==, "123456789012345");
+        g_free (ctx.responses[i]);
+        mm_port_serial_close (MM_PORT_SERIAL (mm_port_serial_cmux_peek_channel (cmux, i)));
+    }
+
+    mm_port_serial_cmux_stop (cmux);
+    g_assert (!mm_port_serial_cmux_is_running (cmux));
+    g_assert (mm_port_serial_cmux_peek_channel (cmux, MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL) == NULL);
+
+    g_object_unref (cmux);
+    g_main_loop_unref (ctx.loop);
+
+    test_port_context_stop (port_context);
+    test_port_context_free (port_context);
+    g_free (name);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/port-serial-cmux/channels", test_cmux_channels);
+
+    return g_test_run ();
+}
@@ -229,6 +229,8 @@ mm_broadband_modem_thuraya_new (const gchar *device,
                          MM_BASE_MODEM_PLUGIN, plugin,
                          MM_BASE_MODEM_VENDOR_ID, vendor_id,
                          MM_BASE_MODEM_PRODUCT_ID, product_id,
+                         /* Supported modes are a fixed list, loading them keeps no state */
+                         MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED, TRUE,
                          NULL);
 }
 
@@ -797,6 +797,7 @@ parent_voice_enable_unsolicited_events_ready (MMIfaceModemVoice *self,
         5,
         FALSE, /* allow_cached */
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)own_voice_enable_unsolicited_events_ready,
         task);
@@ -862,6 +863,7 @@ modem_voice_disable_unsolicited_events (MMIfaceModemVoice   *self,
         5,
         FALSE, /* allow_cached */
         FALSE, /* raw */
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         NULL, /* cancellable */
         (GAsyncReadyCallback)own_voice_disable_unsolicited_events_ready,
         task);
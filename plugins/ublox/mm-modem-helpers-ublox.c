@@ -18,6 +18,7 @@
 
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-modem-band-set.h"
 #include "mm-modem-helpers-ublox.h"
 
 /*****************************************************************************/
@@ -601,52 +602,55 @@ static const BandConfiguration band_configuration[] = {
     },
 };
 
+static void
+band_configuration_add_bands (const BandConfiguration *config,
+                              MMModemMode              mode,
+                              MMModemBandSet          *bands)
+{
+    guint i;
+
+    for (i = 0; i < 2; i++) {
+        if (mode & MM_MODEM_MODE_2G)
+            mm_modem_band_set_add (bands, config->bands_2g[i]);
+        if (mode & MM_MODEM_MODE_3G)
+            mm_modem_band_set_add (bands, config->bands_3g[i]);
+        if (mode & MM_MODEM_MODE_4G)
+            mm_modem_band_set_add (bands, config->bands_4g[i]);
+    }
+
+    /* Unused entries in the configuration are UNKNOWN */
+    mm_modem_band_set_remove (bands, MM_MODEM_BAND_UNKNOWN);
+}
+
 GArray *
 mm_ublox_get_supported_bands (const gchar  *model,
                               GError      **error)
 {
-    MMModemMode  mode;
-    GArray      *bands;
-    guint        i;
+    MMModemMode     mode;
+    MMModemBandSet  bands;
+    guint           i;
 
     mode = supported_modes_per_model (model);
 
-    bands = g_array_new (FALSE, FALSE, sizeof (MMModemBand));
-
-    for (i = 0; i < G_N_ELEMENTS (band_configuration); i++) {
-        if ((mode & MM_MODEM_MODE_2G) && band_configuration[i].bands_2g[0]) {
-            bands = g_array_append_val (bands, band_configuration[i].bands_2g[0]);
-            if (band_configuration[i].bands_2g[1])
-                bands = g_array_append_val (bands, band_configuration[i].bands_2g[1]);
-        }
-        if ((mode & MM_MODEM_MODE_3G) && band_configuration[i].bands_3g[0]) {
-            bands = g_array_append_val (bands, band_configuration[i].bands_3g[0]);
-            if (band_configuration[i].bands_3g[1])
-                bands = g_array_append_val (bands, band_configuration[i].bands_3g[1]);
-        }
-        if ((mode & MM_MODEM_MODE_4G) && band_configuration[i].bands_4g[0]) {
-            bands = g_array_append_val (bands, band_configuration[i].bands_4g[0]);
-            if (band_configuration[i].bands_4g[1])
-                bands = g_array_append_val (bands, band_configuration[i].bands_4g[1]);
-        }
-    }
+    mm_modem_band_set_clear (&bands);
+    for (i = 0; i < G_N_ELEMENTS (band_configuration); i++)
+        band_configuration_add_bands (&band_configuration[i], mode, &bands);
 
-    if (bands->len == 0) {
-        g_array_unref (bands);
+    if (mm_modem_band_set_is_empty (&bands)) {
         g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
                      "No valid supported bands loaded");
         return NULL;
     }
 
-    return bands;
+    return mm_modem_band_set_to_array (&bands);
 }
 
 /*****************************************************************************/
 /* +UBANDSEL? response parser */
 
 static void
-append_bands (GArray *bands,
-              guint   ubandsel_value)
+add_bands (MMModemBandSet *bands,
+           guint           ubandsel_value)
 {
     guint i;
 
@@ -662,35 +666,19 @@ append_bands (GArray *bands,
     /* Note: we don't care if the device doesn't support one of these modes;
      * the generic logic will filter out all bands not supported before
      * exposing them in the DBus property */
-
-    if (band_configuration[i].bands_2g[0]) {
-        g_array_append_val (bands, band_configuration[i].bands_2g[0]);
-        if (band_configuration[i].bands_2g[1])
-            g_array_append_val (bands, band_configuration[i].bands_2g[1]);
-    }
-
-    if (band_configuration[i].bands_3g[0]) {
-        g_array_append_val (bands, band_configuration[i].bands_3g[0]);
-        if (band_configuration[i].bands_3g[1])
-            g_array_append_val (bands, band_configuration[i].bands_3g[1]);
-    }
-
-    if (band_configuration[i].bands_4g[0]) {
-        g_array_append_val (bands, band_configuration[i].bands_4g[0]);
-        if (band_configuration[i].bands_4g[1])
-            g_array_append_val (bands, band_configuration[i].bands_4g[1]);
-    }
+    band_configuration_add_bands (&band_configuration[i], MM_MODEM_MODE_ANY, bands);
 }
 
 GArray *
 mm_ublox_parse_ubandsel_response (const gchar  *response,
                                   GError      **error)
 {
-    GArray  *array_values = NULL;
-    GArray  *array = NULL;
-    gchar   *dupstr = NULL;
-    GError  *inner_error = NULL;
-    guint    i;
+    GArray         *array_values = NULL;
+    GArray         *array = NULL;
+    MMModemBandSet  bands;
+    gchar          *dupstr = NULL;
+    GError         *inner_error = NULL;
+    guint           i;
 
     if (!g_str_has_prefix (response, "+UBANDSEL")) {
         inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
@@ -708,16 +696,18 @@ mm_ublox_parse_ubandsel_response (const gchar  *response,
         goto out;
 
     /* Convert list of ubandsel numbers to MMModemBand values */
-    array = g_array_new (FALSE, FALSE, sizeof (MMModemBand));
+    mm_modem_band_set_clear (&bands);
     for (i = 0; i < array_values->len; i++)
-        append_bands (array, g_array_index (array_values, guint, i));
+        add_bands (&bands, g_array_index (array_values, guint, i));
 
-    if (!array->len) {
+    if (mm_modem_band_set_is_empty (&bands)) {
         inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
                                    "No known band selection values matched in +UBANDSEL response: '%s'", response);
         goto out;
     }
 
+    array = mm_modem_band_set_to_array (&bands);
+
 out:
     if (inner_error) {
         g_propagate_error (error, inner_error);
@@ -741,29 +731,27 @@ gchar *
 mm_ublox_build_ubandsel_set_command (GArray  *bands,
                                      GError **error)
 {
-    GString *command = NULL;
-    GArray  *ubandsel_nums;
-    guint    i;
+    GString        *command = NULL;
+    GArray         *ubandsel_nums;
+    MMModemBandSet  requested;
+    guint           i;
 
     if (bands->len == 1 && g_array_index (bands, MMModemBand, 0) == MM_MODEM_BAND_ANY)
         return g_strdup ("+UBANDSEL=0");
 
+    mm_modem_band_set_clear (&requested);
+    mm_modem_band_set_add_array (&requested, bands);
+    mm_modem_band_set_remove (&requested, MM_MODEM_BAND_UNKNOWN);
+
     ubandsel_nums = g_array_sized_new (FALSE, FALSE, sizeof (guint), G_N_ELEMENTS (band_configuration));
     for (i = 0; i < G_N_ELEMENTS (band_configuration); i++) {
-        guint j;
-
-        for (j = 0; j < bands->len; j++) {
-            MMModemBand band;
-
-            band = g_array_index (bands, MMModemBand, j);
+        MMModemBandSet config_bands;
 
-            if (band == band_configuration[i].bands_2g[0] || band == band_configuration[i].bands_2g[1] ||
-                band == band_configuration[i].bands_3g[0] || band == band_configuration[i].bands_3g[1] ||
-                band == band_configuration[i].bands_4g[0] || band == band_configuration[i].bands_4g[1]) {
-                g_array_append_val (ubandsel_nums, band_configuration[i].ubandsel_value);
-                break;
-            }
-        }
+        mm_modem_band_set_clear (&config_bands);
+        band_configuration_add_bands (&band_configuration[i], MM_MODEM_MODE_ANY, &config_bands);
+        mm_modem_band_set_intersect (&config_bands, &requested);
+        if (!mm_modem_band_set_is_empty (&config_bands))
+            g_array_append_val (ubandsel_nums, band_configuration[i].ubandsel_value);
     }
 
     if (ubandsel_nums->len == 0) {
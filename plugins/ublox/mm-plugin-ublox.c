@@ -232,6 +232,7 @@ ublox_custom_init (MMPortProbe         *probe,
                                    1,
                                    FALSE, /* raw */
                                    FALSE, /* allow_cached */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback)quick_at_ready,
                                    task);
@@ -1090,6 +1090,7 @@ gps_engine_start (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)xlcslsr_ready,
                                    task);
@@ -1149,6 +1150,7 @@ gps_engine_stop (GTask *task)
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)xlsrstop_ready,
                                    task);
@@ -1535,7 +1537,7 @@ mm_shared_xmm_setup_ports (MMBroadbandModem *self)
         mm_base_modem_at_command_full (MM_BASE_MODEM (self),
                                        ports[i],
                                        "+XLSRSTOP",
-                                       3, FALSE, FALSE, NULL, NULL, NULL);
+                                       3, FALSE, FALSE, MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, NULL, NULL, NULL);
     }
 }
 
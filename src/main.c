@@ -27,8 +27,11 @@
 #include "ModemManager.h"
 
 #include "mm-base-manager.h"
+#include "mm-base-modem-at.h"
 #include "mm-log.h"
 #include "mm-context.h"
+#include "mm-metrics.h"
+#include "mm-probe-scheduler.h"
 
 #if defined WITH_SYSTEMD_SUSPEND_RESUME
 # include "mm-sleep-monitor.h"
@@ -82,6 +85,11 @@ bus_acquired_cb (GDBusConnection *connection,
 
     mm_dbg ("Bus acquired, creating manager...");
 
+    /* Metrics are only reported in the debug interface or in the metrics
+     * file, don't pay for the connection filter otherwise */
+    if (mm_context_get_debug () || mm_context_get_metrics_file ())
+        mm_metrics_watch_connection (connection);
+
     /* Create Manager object */
     g_assert (!manager);
     manager = mm_base_manager_new (connection,
@@ -89,6 +97,7 @@ bus_acquired_cb (GDBusConnection *connection,
                                    !mm_context_get_no_auto_scan (),
                                    mm_context_get_filter_policy (),
                                    mm_context_get_initial_kernel_events (),
+                                   mm_context_get_kernel_event_debounce (),
                                    mm_context_get_test_enable (),
                                    &error);
     if (!manager) {
@@ -154,6 +163,12 @@ main (int argc, char *argv[])
     g_unix_signal_add (SIGTERM, quit_cb, NULL);
     g_unix_signal_add (SIGINT, quit_cb, NULL);
 
+    if (mm_context_get_metrics_file ())
+        mm_metrics_export_to_file (mm_context_get_metrics_file ());
+
+    mm_probe_scheduler_set_limits (mm_context_get_probe_concurrency (),
+                                   mm_context_get_probe_concurrency_per_hub ());
+
     mm_info ("ModemManager (version " MM_DIST_VERSION ") starting in %s bus...",
              mm_context_get_test_session () ? "session" : "system");
 
@@ -185,6 +200,9 @@ main (int argc, char *argv[])
     inner = loop;
     loop = NULL;
 
+    /* Metrics are reported before the modems are removed */
+    mm_metrics_shutdown ();
+
     if (manager) {
         GTimer *timer;
 
@@ -215,6 +233,8 @@ main (int argc, char *argv[])
 
     g_bus_unown_name (name_id);
 
+    mm_base_modem_at_log_stats ();
+
     mm_info ("ModemManager is shut down");
 
     mm_log_shutdown ();
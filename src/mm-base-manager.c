@@ -35,6 +35,7 @@
 #include <mm-errors-types.h>
 #include <mm-gdbus-manager.h>
 #include <mm-gdbus-test.h>
+#include <mm-gdbus-debug.h>
 
 #include "mm-context.h"
 #include "mm-base-manager.h"
@@ -45,6 +46,8 @@
 #include "mm-plugin.h"
 #include "mm-filter.h"
 #include "mm-log.h"
+#include "mm-trace.h"
+#include "mm-metrics.h"
 
 static void initable_iface_init (GInitableIface *iface);
 
@@ -60,6 +63,7 @@ enum {
     PROP_ENABLE_TEST,
     PROP_PLUGIN_DIR,
     PROP_INITIAL_KERNEL_EVENTS,
+    PROP_KERNEL_EVENT_DEBOUNCE,
     LAST_PROP
 };
 
@@ -76,6 +80,14 @@ struct _MMBaseManagerPrivate {
     gchar *plugin_dir;
     /* Path to the list of initial kernel events */
     gchar *initial_kernel_events;
+    /* Time to wait for bursts of kernel events to settle, in ms */
+    guint kernel_event_debounce;
+    /* Batches of kernel events waiting to be processed, by physdev uid */
+    GHashTable *pending_events;
+    /* Kernel event counters */
+    guint n_events_received;
+    guint n_events_dispatched;
+    guint n_events_collapsed;
     /* The authorization provider */
     MMAuthProvider *authp;
     GCancellable *authp_cancellable;
@@ -85,6 +97,11 @@ struct _MMBaseManagerPrivate {
     MMFilter *filter;
     /* The container of devices being prepared */
     GHashTable *devices;
+    /* Lookup indices of the devices, by port ("subsystem/name") and by modem
+     * object. They're kept in sync with the port and modem changes reported
+     * by each device, and don't hold any reference. */
+    GHashTable *devices_by_port;
+    GHashTable *devices_by_modem;
     /* The Object Manager server */
     GDBusObjectManagerServer *object_manager;
     /* The map of inhibited devices */
@@ -93,6 +110,9 @@ struct _MMBaseManagerPrivate {
     /* The Test interface support */
     MmGdbusTest *test_skeleton;
 
+    /* The Debug interface support */
+    MmGdbusDebug *debug_skeleton;
+
 #if defined WITH_UDEV
     /* The UDev client */
     GUdevClient *udev;
@@ -101,21 +121,22 @@ struct _MMBaseManagerPrivate {
 
 /*****************************************************************************/
 
+static gchar *
+port_index_key (MMKernelDevice *port)
+{
+    const gchar *subsys;
+    const gchar *name;
+
+    subsys = mm_kernel_device_get_subsystem (port);
+    name = mm_kernel_device_get_name (port);
+    return ((subsys && name) ? g_strdup_printf ("%s/%s", subsys, name) : NULL);
+}
+
 static MMDevice *
 find_device_by_modem (MMBaseManager *manager,
                       MMBaseModem *modem)
 {
-    GHashTableIter iter;
-    gpointer key, value;
-
-    g_hash_table_iter_init (&iter, manager->priv->devices);
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        MMDevice *candidate = MM_DEVICE (value);
-
-        if (modem == mm_device_peek_modem (candidate))
-            return candidate;
-    }
-    return NULL;
+    return g_hash_table_lookup (manager->priv->devices_by_modem, modem);
 }
 
 static MMDevice *
@@ -124,6 +145,22 @@ find_device_by_port (MMBaseManager  *manager,
 {
     GHashTableIter iter;
     gpointer key, value;
+    gchar *port_key;
+    MMDevice *device = NULL;
+
+    port_key = port_index_key (port);
+    if (port_key) {
+        device = g_hash_table_lookup (manager->priv->devices_by_port, port_key);
+        g_free (port_key);
+        if (device && mm_device_owns_port (device, port))
+            return device;
+
+        /* Ports renamed by udev (e.g. net interfaces) are only matched by
+         * their previous sysfs path, which isn't indexed; anything else not
+         * in the index is not owned by any device */
+        if (!mm_kernel_device_has_property (port, "DEVPATH_OLD"))
+            return NULL;
+    }
 
     g_hash_table_iter_init (&iter, manager->priv->devices);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
@@ -149,6 +186,115 @@ find_device_by_kernel_device (MMBaseManager  *manager,
     return find_device_by_physdev_uid (manager, mm_kernel_device_get_physdev_uid (kernel_device));
 }
 
+/*****************************************************************************/
+/* Device tracking */
+
+static void
+device_port_grabbed (MMDevice       *device,
+                     MMKernelDevice *port,
+                     MMBaseManager  *self)
+{
+    gchar *port_key;
+
+    port_key = port_index_key (port);
+    if (port_key)
+        g_hash_table_insert (self->priv->devices_by_port, port_key, device);
+}
+
+static void
+device_port_released (MMDevice       *device,
+                      MMKernelDevice *port,
+                      MMBaseManager  *self)
+{
+    gchar *port_key;
+
+    port_key = port_index_key (port);
+    if (!port_key)
+        return;
+
+    if (g_hash_table_lookup (self->priv->devices_by_port, port_key) == device)
+        g_hash_table_remove (self->priv->devices_by_port, port_key);
+    g_free (port_key);
+}
+
+static gboolean
+index_value_is_device (gpointer key,
+                       gpointer value,
+                       MMDevice *device)
+{
+    return (value == device);
+}
+
+static void
+device_modem_updated (MMDevice      *device,
+                      GParamSpec    *pspec,
+                      MMBaseManager *self)
+{
+    MMBaseModem *modem;
+
+    g_hash_table_foreach_remove (self->priv->devices_by_modem, (GHRFunc)index_value_is_device, device);
+
+    modem = mm_device_peek_modem (device);
+    if (modem)
+        g_hash_table_insert (self->priv->devices_by_modem, modem, device);
+}
+
+static void
+device_index (MMBaseManager *self,
+              MMDevice      *device)
+{
+    GList *l;
+
+    g_signal_connect (device, MM_DEVICE_PORT_GRABBED,      G_CALLBACK (device_port_grabbed),  self);
+    g_signal_connect (device, MM_DEVICE_PORT_RELEASED,     G_CALLBACK (device_port_released), self);
+    g_signal_connect (device, "notify::" MM_DEVICE_MODEM, G_CALLBACK (device_modem_updated), self);
+
+    /* Devices are usually tracked before any port is grabbed, but not always */
+    for (l = mm_device_peek_port_probe_list (device); l; l = g_list_next (l))
+        device_port_grabbed (device, mm_port_probe_peek_port (MM_PORT_PROBE (l->data)), self);
+    device_modem_updated (device, NULL, self);
+}
+
+static void
+device_unindex (MMBaseManager *self,
+                MMDevice      *device)
+{
+    g_signal_handlers_disconnect_by_data (device, self);
+    g_hash_table_foreach_remove (self->priv->devices_by_port,  (GHRFunc)index_value_is_device, device);
+    g_hash_table_foreach_remove (self->priv->devices_by_modem, (GHRFunc)index_value_is_device, device);
+}
+
+static gboolean
+foreach_unindex (gpointer       key,
+                 MMDevice      *device,
+                 MMBaseManager *self)
+{
+    device_unindex (self, device);
+    return TRUE;
+}
+
+/* Takes ownership of the device */
+static void
+track_device (MMBaseManager *self,
+              MMDevice      *device)
+{
+    g_hash_table_insert (self->priv->devices, g_strdup (mm_device_get_uid (device)), device);
+    device_index (self, device);
+}
+
+static void
+untrack_device (MMBaseManager *self,
+                MMDevice      *device)
+{
+    /* The device may have already been removed from the tracking HT, or even
+     * replaced by a new one with the same uid */
+    if (g_hash_table_lookup (self->priv->devices, mm_device_get_uid (device)) != device)
+        return;
+
+    device_unindex (self, device);
+    g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -183,7 +329,7 @@ device_support_check_ready (MMPluginManager          *plugin_manager,
         mm_info ("Couldn't check support for device '%s': %s",
                  mm_device_get_uid (ctx->device), error->message);
         g_error_free (error);
-        g_hash_table_remove (ctx->self->priv->devices, mm_device_get_uid (ctx->device));
+        untrack_device (ctx->self, ctx->device);
         find_device_support_context_free (ctx);
         return;
     }
@@ -196,7 +342,7 @@ device_support_check_ready (MMPluginManager          *plugin_manager,
         mm_warn ("Couldn't create modem for device '%s': %s",
                  mm_device_get_uid (ctx->device), error->message);
         g_error_free (error);
-        g_hash_table_remove (ctx->self->priv->devices, mm_device_get_uid (ctx->device));
+        untrack_device (ctx->self, ctx->device);
         find_device_support_context_free (ctx);
         return;
     }
@@ -253,7 +399,7 @@ device_removed (MMBaseManager  *self,
                     /* The device may have already been removed from the tracking HT, we
                      * just try to remove it and if it fails, we ignore it */
                     mm_device_remove_modem (device);
-                    g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+                    untrack_device (self, device);
                 }
             }
             g_object_unref (device);
@@ -293,7 +439,7 @@ device_removed (MMBaseManager  *self,
     if (device) {
         mm_dbg ("Removing device '%s'", mm_device_get_uid (device));
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        untrack_device (self, device);
         return;
     }
 }
@@ -369,9 +515,7 @@ device_added (MMBaseManager  *manager,
 
         /* Keep the device listed in the Manager */
         device = mm_device_new (physdev_uid, hotplugged, FALSE);
-        g_hash_table_insert (manager->priv->devices,
-                             g_strdup (physdev_uid),
-                             device);
+        track_device (manager, device);
 
         /* Launch device support check */
         ctx = g_slice_new (FindDeviceSupportContext);
@@ -390,9 +534,243 @@ device_added (MMBaseManager  *manager,
     mm_device_grab_port (device, port);
 }
 
+/*****************************************************************************/
+/* Kernel event debouncing
+ *
+ * Hub resets or USB configuration switches make the kernel report bursts of
+ * remove/add events for all the ports of the affected devices. Instead of
+ * processing each event right away, events are batched per physical device
+ * until no new event has been received for that device during the debounce
+ * window, and then each port in the batch ends up with at most one removal
+ * and one addition. Ports added and removed again within the same batch are
+ * not reported at all. */
+
+/* Upper bound of how long a batch may be delayed, as a multiple of the
+ * debounce window, so that a device flapping continuously is still handled */
+#define KERNEL_EVENT_DEBOUNCE_MAX_FACTOR 10
+
+typedef struct {
+    gchar          *key;
+    MMKernelDevice *last_added;
+    MMKernelDevice *last_removed;
+    gboolean        first_is_add;
+    gboolean        last_is_add;
+    gboolean        manual_scan;
+} PendingPort;
+
+typedef struct {
+    MMBaseManager *self;
+    gchar         *physdev_uid;
+    GPtrArray     *ports;
+    gint64         first_event_time;
+    guint          n_events;
+    guint          timeout_id;
+} PendingDevice;
+
+static void
+pending_port_free (PendingPort *port)
+{
+    if (port->last_added)
+        g_object_unref (port->last_added);
+    if (port->last_removed)
+        g_object_unref (port->last_removed);
+    g_free (port->key);
+    g_slice_free (PendingPort, port);
+}
+
+static void
+pending_device_free (PendingDevice *pending)
+{
+    if (pending->timeout_id)
+        g_source_remove (pending->timeout_id);
+    g_ptr_array_unref (pending->ports);
+    g_free (pending->physdev_uid);
+    g_slice_free (PendingDevice, pending);
+}
+
+static PendingPort *
+pending_device_lookup_port (PendingDevice *pending,
+                            gchar         *key)
+{
+    PendingPort *port;
+    guint        i;
+
+    for (i = 0; i < pending->ports->len; i++) {
+        port = g_ptr_array_index (pending->ports, i);
+        if (g_strcmp0 (port->key, key) == 0) {
+            g_free (key);
+            return port;
+        }
+    }
+
+    port = g_slice_new0 (PendingPort);
+    port->key = key;
+    g_ptr_array_add (pending->ports, port);
+    return port;
+}
+
+static void
+kernel_event_dispatch (MMBaseManager  *self,
+                       MMKernelDevice *kernel_device,
+                       gboolean        add,
+                       gboolean        manual_scan)
+{
+    self->priv->n_events_dispatched++;
+    if (add)
+        device_added (self, kernel_device, TRUE, manual_scan);
+    else
+        device_removed (self, kernel_device);
+}
+
+static void
+pending_device_flush (PendingDevice *pending)
+{
+    MMBaseManager *self = pending->self;
+    guint          n_dispatched_before;
+    guint          n_dispatched;
+    guint          i;
+
+    n_dispatched_before = self->priv->n_events_dispatched;
+
+    /* Removals first, so that ports replaced during the burst are released
+     * before being grabbed again */
+    for (i = 0; i < pending->ports->len; i++) {
+        PendingPort *port;
+
+        port = g_ptr_array_index (pending->ports, i);
+        if (!port->last_removed)
+            continue;
+
+        /* A port that was first seen being added and that isn't known
+         * already, was never reported before the burst: the removal just
+         * cancels the addition */
+        if (port->first_is_add && !find_device_by_port (self, port->last_removed))
+            continue;
+
+        kernel_event_dispatch (self, port->last_removed, FALSE, port->manual_scan);
+    }
+
+    for (i = 0; i < pending->ports->len; i++) {
+        PendingPort *port;
+
+        port = g_ptr_array_index (pending->ports, i);
+        if (port->last_is_add)
+            kernel_event_dispatch (self, port->last_added, TRUE, port->manual_scan);
+    }
+
+    n_dispatched = self->priv->n_events_dispatched - n_dispatched_before;
+    g_assert (n_dispatched <= pending->n_events);
+    self->priv->n_events_collapsed += (pending->n_events - n_dispatched);
+
+    mm_dbg ("Processed %u kernel events of device %s (%u collapsed)",
+            pending->n_events, pending->physdev_uid, pending->n_events - n_dispatched);
+}
+
+static gboolean
+pending_device_timeout (PendingDevice *pending)
+{
+    MMBaseManager *self = pending->self;
+
+    pending->timeout_id = 0;
+
+    /* Remove from the table before processing, so that the batch is not
+     * modified while being flushed */
+    g_hash_table_steal (self->priv->pending_events, pending->physdev_uid);
+    pending_device_flush (pending);
+    pending_device_free (pending);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+pending_device_schedule (PendingDevice *pending)
+{
+    guint  window;
+    gint64 elapsed;
+    gint64 max_delay;
+
+    window = pending->self->priv->kernel_event_debounce;
+
+    /* Each new event restarts the window, but never beyond the max delay */
+    elapsed = (g_get_monotonic_time () - pending->first_event_time) / 1000;
+    max_delay = (gint64) window * KERNEL_EVENT_DEBOUNCE_MAX_FACTOR;
+    if (elapsed + window > max_delay)
+        window = (elapsed < max_delay) ? (guint) (max_delay - elapsed) : 0;
+
+    if (pending->timeout_id)
+        g_source_remove (pending->timeout_id);
+    pending->timeout_id = g_timeout_add (window, (GSourceFunc) pending_device_timeout, pending);
+}
+
+static gboolean
+foreach_flush_pending (const gchar   *physdev_uid,
+                       PendingDevice *pending,
+                       MMBaseManager *self)
+{
+    pending_device_flush (pending);
+    pending_device_free (pending);
+    return TRUE;
+}
+
+static void
+kernel_event_queue (MMBaseManager  *self,
+                    MMKernelDevice *kernel_device,
+                    gboolean        add,
+                    gboolean        manual_scan)
+{
+    PendingDevice *pending;
+    PendingPort   *port;
+    const gchar   *physdev_uid;
+    gchar         *key = NULL;
+
+    self->priv->n_events_received++;
+
+    physdev_uid = mm_kernel_device_get_physdev_uid (kernel_device);
+    if (self->priv->kernel_event_debounce && physdev_uid)
+        key = port_index_key (kernel_device);
+
+    /* Debouncing disabled, or no way to batch the event with other events
+     * of the same device; in the latter case any pending batch is processed
+     * first, so that event ordering is kept */
+    if (!key) {
+        if (g_hash_table_size (self->priv->pending_events) > 0)
+            g_hash_table_foreach_steal (self->priv->pending_events, (GHRFunc) foreach_flush_pending, self);
+        kernel_event_dispatch (self, kernel_device, add, manual_scan);
+        return;
+    }
+
+    pending = g_hash_table_lookup (self->priv->pending_events, physdev_uid);
+    if (!pending) {
+        pending = g_slice_new0 (PendingDevice);
+        pending->self = self;
+        pending->physdev_uid = g_strdup (physdev_uid);
+        pending->ports = g_ptr_array_new_with_free_func ((GDestroyNotify) pending_port_free);
+        pending->first_event_time = g_get_monotonic_time ();
+        g_hash_table_insert (self->priv->pending_events, pending->physdev_uid, pending);
+    }
+
+    port = pending_device_lookup_port (pending, key);
+    if (!port->last_added && !port->last_removed)
+        port->first_is_add = add;
+    port->last_is_add = add;
+    port->manual_scan = manual_scan;
+    if (add) {
+        if (port->last_added)
+            g_object_unref (port->last_added);
+        port->last_added = g_object_ref (kernel_device);
+    } else {
+        if (port->last_removed)
+            g_object_unref (port->last_removed);
+        port->last_removed = g_object_ref (kernel_device);
+    }
+    pending->n_events++;
+
+    pending_device_schedule (pending);
+}
+
 static gboolean
 handle_kernel_event (MMBaseManager            *self,
                      MMKernelEventProperties  *properties,
+                     gboolean                  initial,
                      GError                  **error)
 {
     MMKernelDevice *kernel_device;
@@ -440,10 +818,21 @@ handle_kernel_event (MMBaseManager            *self,
     if (!kernel_device)
         return FALSE;
 
+    /* Initial events are about devices already there, which don't need any
+     * debouncing, and which are not reported as hotplugged */
+    if (initial) {
+        if (g_strcmp0 (action, "add") == 0)
+            device_added (self, kernel_device, FALSE, TRUE);
+        else
+            device_removed (self, kernel_device);
+        g_object_unref (kernel_device);
+        return TRUE;
+    }
+
     if (g_strcmp0 (action, "add") == 0)
-        device_added (self, kernel_device, TRUE, TRUE);
+        kernel_event_queue (self, kernel_device, TRUE, TRUE);
     else if (g_strcmp0 (action, "remove") == 0)
-        device_removed (self, kernel_device);
+        kernel_event_queue (self, kernel_device, FALSE, TRUE);
     else
         g_assert_not_reached ();
     g_object_unref (kernel_device);
@@ -479,90 +868,84 @@ handle_uevent (GUdevClient *client,
     name = mm_kernel_device_get_name (kernel_device);
     if (   (g_str_equal (action, "add") || g_str_equal (action, "move") || g_str_equal (action, "change"))
         && (!g_str_has_prefix (subsys, "usb") || (name && g_str_has_prefix (name, "cdc-wdm"))))
-        device_added (self, kernel_device, TRUE, FALSE);
+        kernel_event_queue (self, kernel_device, TRUE, FALSE);
     else if (g_str_equal (action, "remove"))
-        device_removed (self, kernel_device);
+        kernel_event_queue (self, kernel_device, FALSE, FALSE);
 
     g_object_unref (kernel_device);
 }
 
+/* All ports found in a scan are added in a single idle, so that every device
+ * has all its ports grabbed by the time the plugin manager starts probing it,
+ * and so that all devices get probed at the same time. */
 typedef struct {
     MMBaseManager *self;
-    GUdevDevice *device;
+    GList *devices;
     gboolean manual_scan;
-} StartDeviceAdded;
+} ScanDevicesAdded;
 
 static gboolean
-start_device_added_idle (StartDeviceAdded *ctx)
+scan_devices_added_idle (ScanDevicesAdded *ctx)
 {
-    MMKernelDevice *kernel_device;
+    GList *l;
 
-    kernel_device = mm_kernel_device_udev_new (ctx->device);
-    device_added (ctx->self, kernel_device, FALSE, ctx->manual_scan);
-    g_object_unref (kernel_device);
+    for (l = ctx->devices; l; l = g_list_next (l)) {
+        MMKernelDevice *kernel_device;
+
+        kernel_device = mm_kernel_device_udev_new (G_UDEV_DEVICE (l->data));
+        device_added (ctx->self, kernel_device, FALSE, ctx->manual_scan);
+        g_object_unref (kernel_device);
+    }
 
+    mm_dbg ("Processed %u ports found in device scan", g_list_length (ctx->devices));
+
+    g_list_free_full (ctx->devices, g_object_unref);
     g_object_unref (ctx->self);
-    g_object_unref (ctx->device);
-    g_slice_free (StartDeviceAdded, ctx);
+    g_slice_free (ScanDevicesAdded, ctx);
     return G_SOURCE_REMOVE;
 }
 
-static void
-start_device_added (MMBaseManager *self,
-                    GUdevDevice *device,
-                    gboolean manual_scan)
-{
-    StartDeviceAdded *ctx;
-
-    ctx = g_slice_new (StartDeviceAdded);
-    ctx->self = g_object_ref (self);
-    ctx->device = g_object_ref (device);
-    ctx->manual_scan = manual_scan;
-    g_idle_add ((GSourceFunc)start_device_added_idle, ctx);
-}
-
-static void
-process_scan (MMBaseManager *self,
-              gboolean       manual_scan)
+static GList *
+scan_subsystem (MMBaseManager *self,
+                const gchar   *subsystem,
+                gboolean       cdc_wdm_only,
+                GList         *found)
 {
     GList *devices, *iter;
 
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "tty");
-    for (iter = devices; iter; iter = g_list_next (iter)) {
-        start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
-    }
-    g_list_free (devices);
-
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "net");
-    for (iter = devices; iter; iter = g_list_next (iter)) {
-        start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
-    }
-    g_list_free (devices);
-
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "usb");
+    devices = g_udev_client_query_by_subsystem (self->priv->udev, subsystem);
     for (iter = devices; iter; iter = g_list_next (iter)) {
         const gchar *name;
 
         name = g_udev_device_get_name (G_UDEV_DEVICE (iter->data));
-        if (name && g_str_has_prefix (name, "cdc-wdm"))
-            start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
+        if (!cdc_wdm_only || (name && g_str_has_prefix (name, "cdc-wdm")))
+            found = g_list_prepend (found, iter->data);
+        else
+            g_object_unref (G_OBJECT (iter->data));
     }
     g_list_free (devices);
 
+    return found;
+}
+
+static void
+process_scan (MMBaseManager *self,
+              gboolean       manual_scan)
+{
+    ScanDevicesAdded *ctx;
+    GList *found = NULL;
+
+    found = scan_subsystem (self, "tty", FALSE, found);
+    found = scan_subsystem (self, "net", FALSE, found);
+    found = scan_subsystem (self, "usb", TRUE, found);
     /* Newer kernels report 'usbmisc' subsystem */
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "usbmisc");
-    for (iter = devices; iter; iter = g_list_next (iter)) {
-        const gchar *name;
+    found = scan_subsystem (self, "usbmisc", TRUE, found);
 
-        name = g_udev_device_get_name (G_UDEV_DEVICE (iter->data));
-        if (name && g_str_has_prefix (name, "cdc-wdm"))
-            start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
-    }
-    g_list_free (devices);
+    ctx = g_slice_new (ScanDevicesAdded);
+    ctx->self = g_object_ref (self);
+    ctx->devices = g_list_reverse (found);
+    ctx->manual_scan = manual_scan;
+    g_idle_add ((GSourceFunc)scan_devices_added_idle, ctx);
 }
 
 #endif
@@ -601,7 +984,7 @@ process_initial_kernel_events (MMBaseManager *self)
             if (!properties) {
                 g_warning ("Couldn't parse line '%s' as initial kernel event %s", line, error->message);
                 g_clear_error (&error);
-            } else if (!handle_kernel_event (self, properties, &error)) {
+            } else if (!handle_kernel_event (self, properties, TRUE, &error)) {
                 g_warning ("Couldn't process line '%s' as initial kernel event %s", line, error->message);
                 g_clear_error (&error);
             } else
@@ -653,7 +1036,7 @@ remove_disable_ready (MMBaseModem *modem,
     if (device) {
         g_cancellable_cancel (mm_base_modem_peek_cancellable (modem));
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        untrack_device (self, device);
     }
 }
 
@@ -680,6 +1063,7 @@ foreach_remove (gpointer key,
     if (modem)
         g_cancellable_cancel (mm_base_modem_peek_cancellable (modem));
     mm_device_remove_modem (device);
+    device_unindex (self, device);
     return TRUE;
 }
 
@@ -693,6 +1077,16 @@ mm_base_manager_shutdown (MMBaseManager *self,
     /* Cancel all ongoing auth requests */
     g_cancellable_cancel (self->priv->authp_cancellable);
 
+    /* Kernel events not processed yet are just discarded */
+    if (g_hash_table_size (self->priv->pending_events) > 0) {
+        mm_dbg ("Discarding pending kernel events of %u devices", g_hash_table_size (self->priv->pending_events));
+        g_hash_table_remove_all (self->priv->pending_events);
+    }
+    mm_dbg ("Kernel events: %u received, %u dispatched, %u collapsed",
+            self->priv->n_events_received,
+            self->priv->n_events_dispatched,
+            self->priv->n_events_collapsed);
+
     if (disable) {
         g_hash_table_foreach (self->priv->devices, (GHFunc)foreach_disable, self);
 
@@ -786,6 +1180,133 @@ handle_set_logging (MmGdbusOrgFreedesktopModemManager1 *manager,
     return TRUE;
 }
 
+/*****************************************************************************/
+/* Get trace */
+
+typedef struct {
+    MMBaseManager *self;
+    MmGdbusDebug *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMTraceFormat format;
+} GetTraceContext;
+
+static void
+get_trace_context_free (GetTraceContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+get_trace_auth_ready (MMAuthProvider *authp,
+                      GAsyncResult *res,
+                      GetTraceContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else {
+        gchar *trace;
+
+        trace = mm_trace_build (ctx->format);
+        mm_gdbus_debug_complete_get_trace (ctx->skeleton, ctx->invocation, trace);
+        g_free (trace);
+    }
+
+    get_trace_context_free (ctx);
+}
+
+static gboolean
+handle_get_trace (MmGdbusDebug *skeleton,
+                  GDBusMethodInvocation *invocation,
+                  const gchar *format,
+                  MMBaseManager *self)
+{
+    GetTraceContext *ctx;
+    GError *error = NULL;
+
+    ctx = g_new0 (GetTraceContext, 1);
+    if (!mm_trace_format_from_string (format, &ctx->format, &error)) {
+        g_dbus_method_invocation_take_error (invocation, error);
+        g_free (ctx);
+        return TRUE;
+    }
+
+    ctx->self = g_object_ref (self);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_trace_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Get metrics */
+
+typedef struct {
+    MMBaseManager *self;
+    MmGdbusDebug *skeleton;
+    GDBusMethodInvocation *invocation;
+} GetMetricsContext;
+
+static void
+get_metrics_context_free (GetMetricsContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+get_metrics_auth_ready (MMAuthProvider *authp,
+                        GAsyncResult *res,
+                        GetMetricsContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else {
+        gchar *metrics;
+
+        metrics = mm_metrics_build ();
+        mm_gdbus_debug_complete_get_metrics (ctx->skeleton, ctx->invocation, metrics);
+        g_free (metrics);
+    }
+
+    get_metrics_context_free (ctx);
+}
+
+static gboolean
+handle_get_metrics (MmGdbusDebug *skeleton,
+                    GDBusMethodInvocation *invocation,
+                    MMBaseManager *self)
+{
+    GetMetricsContext *ctx;
+
+    ctx = g_new0 (GetMetricsContext, 1);
+    ctx->self = g_object_ref (self);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_metrics_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
 /*****************************************************************************/
 /* Manual scan */
 
@@ -888,7 +1409,7 @@ report_kernel_event_auth_ready (MMAuthProvider           *authp,
     if (!properties)
         goto out;
 
-    handle_kernel_event (ctx->self, properties, &error);
+    handle_kernel_event (ctx->self, properties, FALSE, &error);
 
 out:
     if (error)
@@ -1272,7 +1793,8 @@ handle_set_profile (MmGdbusTest *skeleton,
     /* Create device and keep it listed in the Manager */
     physdev_uid = g_strdup_printf ("/virtual/%s", id);
     device = mm_device_new (physdev_uid, TRUE, TRUE);
-    g_hash_table_insert (self->priv->devices, physdev_uid, device);
+    track_device (self, device);
+    g_free (physdev_uid);
 
     /* Grab virtual ports */
     mm_device_virtual_grab_ports (device, (const gchar **)ports);
@@ -1306,7 +1828,7 @@ out:
 
     if (error) {
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        untrack_device (self, device);
         g_dbus_method_invocation_return_gerror (invocation, error);
         g_error_free (error);
     } else
@@ -1323,6 +1845,7 @@ mm_base_manager_new (GDBusConnection  *connection,
                      gboolean          auto_scan,
                      MMFilterRule      filter_policy,
                      const gchar      *initial_kernel_events,
+                     guint             kernel_event_debounce,
                      gboolean          enable_test,
                      GError          **error)
 {
@@ -1336,6 +1859,7 @@ mm_base_manager_new (GDBusConnection  *connection,
                            MM_BASE_MANAGER_AUTO_SCAN,             auto_scan,
                            MM_BASE_MANAGER_FILTER_POLICY,         filter_policy,
                            MM_BASE_MANAGER_INITIAL_KERNEL_EVENTS, initial_kernel_events,
+                           MM_BASE_MANAGER_KERNEL_EVENT_DEBOUNCE, kernel_event_debounce,
                            MM_BASE_MANAGER_ENABLE_TEST,           enable_test,
                            "version",                             MM_DIST_VERSION,
                            NULL);
@@ -1369,6 +1893,11 @@ set_property (GObject *object,
                 mm_dbg ("Stopping connection in test skeleton");
                 g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (priv->test_skeleton));
             }
+            if (priv->debug_skeleton &&
+                g_dbus_interface_skeleton_get_connection (G_DBUS_INTERFACE_SKELETON (priv->debug_skeleton))) {
+                mm_dbg ("Stopping connection in debug skeleton");
+                g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (priv->debug_skeleton));
+            }
         }
         break;
     }
@@ -1389,6 +1918,9 @@ set_property (GObject *object,
         g_free (priv->initial_kernel_events);
         priv->initial_kernel_events = g_value_dup_string (value);
         break;
+    case PROP_KERNEL_EVENT_DEBOUNCE:
+        priv->kernel_event_debounce = g_value_get_uint (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -1422,6 +1954,9 @@ get_property (GObject *object,
     case PROP_INITIAL_KERNEL_EVENTS:
         g_value_set_string (value, priv->initial_kernel_events);
         break;
+    case PROP_KERNEL_EVENT_DEBOUNCE:
+        g_value_set_uint (value, priv->kernel_event_debounce);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -1444,6 +1979,11 @@ mm_base_manager_init (MMBaseManager *manager)
 
     /* Setup internal lists of device objects */
     priv->devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+    priv->devices_by_port = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    priv->devices_by_modem = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    /* Setup internal list of pending kernel events */
+    priv->pending_events = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)pending_device_free);
 
     /* Setup internal list of inhibited devices */
     priv->inhibited_devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)inhibited_device_info_free);
@@ -1523,6 +2063,20 @@ initable_init (GInitable *initable,
             return FALSE;
     }
 
+    /* Setup the Debug skeleton and export the interface */
+    if (mm_context_get_debug ()) {
+        priv->debug_skeleton = mm_gdbus_debug_skeleton_new ();
+        g_object_connect (priv->debug_skeleton,
+                          "signal::handle-get-trace",   G_CALLBACK (handle_get_trace),   initable,
+                          "signal::handle-get-metrics", G_CALLBACK (handle_get_metrics), initable,
+                          NULL);
+        if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (priv->debug_skeleton),
+                                               priv->connection,
+                                               MM_DBUS_PATH,
+                                               error))
+            return FALSE;
+    }
+
     /* All good */
     return TRUE;
 }
@@ -1535,8 +2089,12 @@ finalize (GObject *object)
     g_free (priv->initial_kernel_events);
     g_free (priv->plugin_dir);
 
+    g_hash_table_destroy (priv->pending_events);
     g_hash_table_destroy (priv->inhibited_devices);
+    g_hash_table_foreach_remove (priv->devices, (GHRFunc)foreach_unindex, object);
     g_hash_table_destroy (priv->devices);
+    g_hash_table_destroy (priv->devices_by_port);
+    g_hash_table_destroy (priv->devices_by_modem);
 
 #if defined WITH_UDEV
     if (priv->udev)
@@ -1555,6 +2113,9 @@ finalize (GObject *object)
     if (priv->test_skeleton)
         g_object_unref (priv->test_skeleton);
 
+    if (priv->debug_skeleton)
+        g_object_unref (priv->debug_skeleton);
+
     if (priv->connection)
         g_object_unref (priv->connection);
 
@@ -1635,4 +2196,12 @@ mm_base_manager_class_init (MMBaseManagerClass *manager_class)
                               "Path to a file with the list of initial kernel events",
                               NULL,
                               G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_KERNEL_EVENT_DEBOUNCE,
+         g_param_spec_uint (MM_BASE_MANAGER_KERNEL_EVENT_DEBOUNCE,
+                            "Kernel event debounce",
+                            "Time to wait for bursts of kernel events to settle, in ms",
+                            0, G_MAXUINT, 0,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 }
@@ -37,6 +37,7 @@
 #define MM_BASE_MANAGER_ENABLE_TEST           "enable-test"           /* Construct-only */
 #define MM_BASE_MANAGER_PLUGIN_DIR            "plugin-dir"            /* Construct-only */
 #define MM_BASE_MANAGER_INITIAL_KERNEL_EVENTS "initial-kernel-events" /* Construct-only */
+#define MM_BASE_MANAGER_KERNEL_EVENT_DEBOUNCE "kernel-event-debounce" /* Construct-only */
 
 typedef struct _MMBaseManagerPrivate MMBaseManagerPrivate;
 
@@ -56,6 +57,7 @@ MMBaseManager   *mm_base_manager_new         (GDBusConnection  *bus,
                                               gboolean          auto_scan,
                                               MMFilterRule      filter_policy,
                                               const gchar      *initial_kernel_events,
+                                              guint             kernel_event_debounce,
                                               gboolean          enable_test,
                                               GError          **error);
 
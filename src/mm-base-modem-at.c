@@ -13,6 +13,8 @@
  * Copyright (C) 2011 Aleksander Morgado <aleksander@gnu.org>
  */
 
+#include <string.h>
+
 #include <glib.h>
 #include <glib-object.h>
 
@@ -20,37 +22,31 @@
 
 #include "mm-base-modem-at.h"
 #include "mm-errors-types.h"
+#include "mm-log.h"
+#include "mm-metrics.h"
 
 static gboolean
-abort_async_if_port_unusable (MMBaseModem *self,
-                              MMPortSerialAt *port,
-                              GAsyncReadyCallback callback,
-                              gpointer user_data)
+open_port_if_usable (MMPortSerialAt *port,
+                     GError **error)
 {
-    GError *error = NULL;
+    GError *inner_error = NULL;
     gboolean init_sequence_enabled = FALSE;
 
     /* If no port given, probably the port disappeared */
     if (!port) {
-        g_simple_async_report_error_in_idle (
-            G_OBJECT (self),
-            callback,
-            user_data,
-            MM_CORE_ERROR,
-            MM_CORE_ERROR_NOT_FOUND,
-            "Cannot run sequence: port not given");
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_NOT_FOUND,
+                     "Cannot run sequence: port not given");
         return FALSE;
     }
 
     /* Ensure we don't try to use a connected port */
     if (mm_port_get_connected (MM_PORT (port))) {
-        g_simple_async_report_error_in_idle (
-            G_OBJECT (self),
-            callback,
-            user_data,
-            MM_CORE_ERROR,
-            MM_CORE_ERROR_CONNECTED,
-            "Cannot run sequence: port is connected");
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_CONNECTED,
+                     "Cannot run sequence: port is connected");
         return FALSE;
     }
 
@@ -60,16 +56,13 @@ abort_async_if_port_unusable (MMBaseModem *self,
     g_object_set (port, MM_PORT_SERIAL_AT_INIT_SEQUENCE_ENABLED, FALSE, NULL);
 
     /* Ensure we have a port open during the sequence */
-    if (!mm_port_serial_open (MM_PORT_SERIAL (port), &error)) {
-        g_simple_async_report_error_in_idle (
-            G_OBJECT (self),
-            callback,
-            user_data,
-            MM_CORE_ERROR,
-            MM_CORE_ERROR_CONNECTED,
-            "Cannot run sequence: '%s'",
-            error->message);
-        g_error_free (error);
+    if (!mm_port_serial_open (MM_PORT_SERIAL (port), &inner_error)) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_CONNECTED,
+                     "Cannot run sequence: '%s'",
+                     inner_error->message);
+        g_error_free (inner_error);
         return FALSE;
     }
 
@@ -79,6 +72,25 @@ abort_async_if_port_unusable (MMBaseModem *self,
     return TRUE;
 }
 
+static gboolean
+abort_async_if_port_unusable (MMBaseModem *self,
+                              MMPortSerialAt *port,
+                              GAsyncReadyCallback callback,
+                              gpointer user_data)
+{
+    GError *error = NULL;
+
+    if (!open_port_if_usable (port, &error)) {
+        g_simple_async_report_take_gerror_in_idle (G_OBJECT (self),
+                                                   callback,
+                                                   user_data,
+                                                   error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 static void
 modem_cancellable_cancelled (GCancellable *modem_cancellable,
                              GCancellable *user_cancellable)
@@ -86,6 +98,132 @@ modem_cancellable_cancelled (GCancellable *modem_cancellable,
     g_cancellable_cancel (user_cancellable);
 }
 
+/*****************************************************************************/
+/* Per-modem command metrics, kept as modem object data and setup on the
+ * first command. The latency includes the time waiting in the port queue. */
+
+#define AT_METRICS_TAG "at-metrics-tag"
+static GQuark at_metrics_quark;
+
+typedef struct {
+    MMMetric *commands;
+    MMMetric *errors;
+    MMMetric *timeouts;
+    MMMetric *latency;
+} AtMetrics;
+
+static void
+at_metrics_free (AtMetrics *metrics)
+{
+    mm_metric_unref (metrics->commands);
+    mm_metric_unref (metrics->errors);
+    mm_metric_unref (metrics->timeouts);
+    mm_metric_unref (metrics->latency);
+    g_slice_free (AtMetrics, metrics);
+}
+
+static void
+at_metrics_record (MMBaseModem  *self,
+                   gint64        start_time,
+                   const GError *error)
+{
+    AtMetrics *metrics;
+
+    if (G_UNLIKELY (!at_metrics_quark))
+        at_metrics_quark = g_quark_from_static_string (AT_METRICS_TAG);
+
+    metrics = g_object_get_qdata (G_OBJECT (self), at_metrics_quark);
+    if (G_UNLIKELY (!metrics)) {
+        const gchar *device;
+
+        device = mm_base_modem_get_device (self);
+        metrics = g_slice_new (AtMetrics);
+        metrics->commands = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_modem_at_commands_total", device);
+        metrics->errors   = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_modem_at_errors_total",   device);
+        metrics->timeouts = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_modem_at_timeouts_total", device);
+        metrics->latency  = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_modem_at_latency_ms",     device);
+        g_object_set_qdata_full (G_OBJECT (self), at_metrics_quark, metrics, (GDestroyNotify)at_metrics_free);
+    }
+
+    mm_metric_inc (metrics->commands);
+    mm_metric_observe (metrics->latency, (g_get_monotonic_time () - start_time) / 1000);
+
+    /* Cancellations are not the modem's fault */
+    if (!error || g_error_matches (error, MM_CORE_ERROR, MM_CORE_ERROR_CANCELLED))
+        return;
+    if (g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT))
+        mm_metric_inc (metrics->timeouts);
+    else
+        mm_metric_inc (metrics->errors);
+}
+
+/*****************************************************************************/
+/* Context pools
+ *
+ * AT commands are sent all the time by every modem (e.g. when polling), so
+ * instead of allocating a new context for each of them, a few of the released
+ * ones are kept around for reuse. All AT operations are run in the main
+ * thread, so the pools need no locking. */
+
+#define CONTEXT_POOL_SIZE 16
+
+typedef struct {
+    gsize    context_size;
+    gpointer contexts[CONTEXT_POOL_SIZE];
+    guint    n_contexts;
+} ContextPool;
+
+static MMBaseModemAtStats stats;
+
+static gpointer
+context_pool_acquire (ContextPool *pool)
+{
+    gpointer ctx;
+
+    if (!pool->n_contexts) {
+        stats.n_contexts_allocated++;
+        return g_malloc0 (pool->context_size);
+    }
+
+    stats.n_contexts_reused++;
+    ctx = pool->contexts[--pool->n_contexts];
+    memset (ctx, 0, pool->context_size);
+    return ctx;
+}
+
+static void
+context_pool_release (ContextPool *pool,
+                      gpointer     ctx)
+{
+    if (pool->n_contexts < CONTEXT_POOL_SIZE)
+        pool->contexts[pool->n_contexts++] = ctx;
+    else
+        g_free (ctx);
+}
+
+void
+mm_base_modem_at_get_stats (MMBaseModemAtStats *out_stats)
+{
+    *out_stats = stats;
+}
+
+void
+mm_base_modem_at_log_stats (void)
+{
+    if (!stats.n_contexts_allocated)
+        return;
+
+    mm_dbg ("AT commands: %" G_GUINT64_FORMAT " single (%" G_GUINT64_FORMAT " with borrowed response), "
+            "%" G_GUINT64_FORMAT " in sequences; contexts: %" G_GUINT64_FORMAT " allocated, "
+            "%" G_GUINT64_FORMAT " reused; %" G_GUINT64_FORMAT " async results created",
+            stats.n_commands,
+            stats.n_borrowed_commands,
+            stats.n_sequence_commands,
+            stats.n_contexts_allocated,
+            stats.n_contexts_reused,
+            stats.n_async_results);
+}
+
 /*****************************************************************************/
 /* AT sequence handling */
 
@@ -102,8 +240,11 @@ typedef struct {
     gpointer response_processor_context;
     GDestroyNotify response_processor_context_free;
     GVariant *result;
+    gint64 command_start_time;
 } AtSequenceContext;
 
+static ContextPool at_sequence_context_pool = { sizeof (AtSequenceContext) };
+
 static void
 at_sequence_context_free (AtSequenceContext *ctx)
 {
@@ -127,7 +268,7 @@ at_sequence_context_free (AtSequenceContext *ctx)
         g_variant_unref (ctx->result);
     if (ctx->simple)
         g_object_unref (ctx->simple);
-    g_free (ctx);
+    context_pool_release (&at_sequence_context_pool, ctx);
 }
 
 GVariant *
@@ -164,7 +305,10 @@ at_sequence_parse_response (MMPortSerialAt *port,
     const gchar *response;
     GError *error = NULL;
 
-    response = mm_port_serial_at_command_finish (port, res, &error);
+    /* The response is only given to the response processor, which must not
+     * keep it around, so there's no need to copy it */
+    response = mm_port_serial_at_command_borrowed_finish (port, res, NULL, &error);
+    at_metrics_record (ctx->self, ctx->command_start_time, error);
 
     /* Cancelled? */
     if (g_cancellable_is_cancelled (ctx->cancellable)) {
@@ -215,12 +359,15 @@ at_sequence_parse_response (MMPortSerialAt *port,
         ctx->current++;
         if (ctx->current->command) {
             /* Schedule the next command in the probing group */
-            mm_port_serial_at_command (
+            stats.n_sequence_commands++;
+            ctx->command_start_time = g_get_monotonic_time ();
+            mm_port_serial_at_command_borrowed (
                 ctx->port,
                 ctx->current->command,
                 ctx->current->timeout,
                 FALSE,
                 ctx->current->allow_cached,
+                ctx->current->priority,
                 ctx->cancellable,
                 (GAsyncReadyCallback)at_sequence_parse_response,
                 ctx);
@@ -268,13 +415,14 @@ mm_base_modem_at_sequence_full (MMBaseModem *self,
         return;
 
     /* Setup context */
-    ctx = g_new0 (AtSequenceContext, 1);
+    ctx = context_pool_acquire (&at_sequence_context_pool);
     ctx->self = g_object_ref (self);
     ctx->port = g_object_ref (port);
     ctx->simple = g_simple_async_result_new (G_OBJECT (self),
                                              callback,
                                              user_data,
                                              mm_base_modem_at_sequence_full);
+    stats.n_async_results++;
     ctx->current = ctx->sequence = sequence;
     ctx->response_processor_context = response_processor_context;
     ctx->response_processor_context_free = response_processor_context_free;
@@ -296,12 +444,15 @@ mm_base_modem_at_sequence_full (MMBaseModem *self,
     }
 
     /* Go on with the first one in the sequence */
-    mm_port_serial_at_command (
+    stats.n_sequence_commands++;
+    ctx->command_start_time = g_get_monotonic_time ();
+    mm_port_serial_at_command_borrowed (
         ctx->port,
         ctx->current->command,
         ctx->current->timeout,
         FALSE,
         FALSE,
+        ctx->current->priority,
         ctx->cancellable,
         (GAsyncReadyCallback)at_sequence_parse_response,
         ctx);
@@ -331,8 +482,10 @@ mm_base_modem_at_sequence (MMBaseModem *self,
     MMPortSerialAt *port;
     GError *error = NULL;
 
-    /* No port given, so we'll try to guess which is best */
-    port = mm_base_modem_peek_best_at_port (self, &error);
+    /* No port given, so we'll try to guess which is best. The whole sequence
+     * is run in the same port, so background sequences (e.g. polling) may
+     * be scheduled in a port different to the primary one */
+    port = mm_base_modem_peek_scheduled_at_port (self, sequence[0].priority, &error);
     if (!port) {
         g_assert (error != NULL);
         g_simple_async_report_take_gerror_in_idle (G_OBJECT (self),
@@ -439,25 +592,71 @@ typedef struct {
     GCancellable *modem_cancellable;
     GCancellable *user_cancellable;
     GSimpleAsyncResult *result;
+    /* Borrowed response handling */
+    MMBaseModemAtResponseFunc response_func;
+    gpointer response_func_user_data;
+    GError *error;
+    gint64 start_time;
 } AtCommandContext;
 
+static ContextPool at_command_context_pool = { sizeof (AtCommandContext) };
+
 static void
 at_command_context_free (AtCommandContext *ctx)
 {
-    mm_port_serial_close (MM_PORT_SERIAL (ctx->port));
+    if (ctx->port) {
+        mm_port_serial_close (MM_PORT_SERIAL (ctx->port));
+        g_object_unref (ctx->port);
+    }
 
     if (ctx->cancelled_id)
         g_cancellable_disconnect (ctx->modem_cancellable,
                                   ctx->cancelled_id);
     if (ctx->user_cancellable)
         g_object_unref (ctx->user_cancellable);
-    g_object_unref (ctx->modem_cancellable);
-    g_object_unref (ctx->cancellable);
+    if (ctx->modem_cancellable)
+        g_object_unref (ctx->modem_cancellable);
+    if (ctx->cancellable)
+        g_object_unref (ctx->cancellable);
 
-    g_object_unref (ctx->port);
-    g_object_unref (ctx->result);
+    if (ctx->error)
+        g_error_free (ctx->error);
+    if (ctx->result)
+        g_object_unref (ctx->result);
     g_object_unref (ctx->self);
-    g_free (ctx);
+    context_pool_release (&at_command_context_pool, ctx);
+}
+
+static AtCommandContext *
+at_command_context_new (MMBaseModem *self,
+                        MMPortSerialAt *port,
+                        GCancellable *cancellable)
+{
+    AtCommandContext *ctx;
+
+    ctx = context_pool_acquire (&at_command_context_pool);
+    ctx->self = g_object_ref (self);
+    ctx->port = g_object_ref (port);
+
+    /* Setup cancellables */
+    ctx->modem_cancellable = mm_base_modem_get_cancellable (self);
+    ctx->user_cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+    if (!ctx->user_cancellable)
+        /* Just the modem-wide one, use it directly */
+        ctx->cancellable = g_object_ref (ctx->modem_cancellable);
+    else {
+        /* Use the user provided one, which will also get cancelled if the modem
+         * wide-one gets cancelled */
+        ctx->cancellable = g_object_ref (ctx->user_cancellable);
+        ctx->cancelled_id = g_cancellable_connect (ctx->modem_cancellable,
+                                                   G_CALLBACK (modem_cancellable_cancelled),
+                                                   ctx->user_cancellable,
+                                                   NULL);
+    }
+
+    stats.n_commands++;
+    ctx->start_time = g_get_monotonic_time ();
+    return ctx;
 }
 
 const gchar *
@@ -479,7 +678,11 @@ at_command_ready (MMPortSerialAt *port,
     const gchar *response;
     GError *error = NULL;
 
-    response = mm_port_serial_at_command_finish (port, res, &error);
+    /* The response is owned by the port command result, which is kept alive
+     * until we return, so it can be given without copying it as we always
+     * complete right away */
+    response = mm_port_serial_at_command_borrowed_finish (port, res, NULL, &error);
+    at_metrics_record (ctx->self, ctx->start_time, error);
 
     /* Cancelled? */
     if (g_cancellable_is_cancelled (ctx->cancellable)) {
@@ -511,6 +714,7 @@ mm_base_modem_at_command_full (MMBaseModem *self,
                                guint timeout,
                                gboolean allow_cached,
                                gboolean is_raw,
+                               MMPortSerialCommandPriority priority,
                                GCancellable *cancellable,
                                GAsyncReadyCallback callback,
                                gpointer user_data)
@@ -521,37 +725,21 @@ mm_base_modem_at_command_full (MMBaseModem *self,
     if (!abort_async_if_port_unusable (self, port, callback, user_data))
         return;
 
-    ctx = g_new0 (AtCommandContext, 1);
-    ctx->self = g_object_ref (self);
-    ctx->port = g_object_ref (port);
+    ctx = at_command_context_new (self, port, cancellable);
     ctx->result = g_simple_async_result_new (G_OBJECT (self),
                                              callback,
                                              user_data,
                                              mm_base_modem_at_command_full);
-
-    /* Setup cancellables */
-    ctx->modem_cancellable = mm_base_modem_get_cancellable (self);
-    ctx->user_cancellable = cancellable ? g_object_ref (cancellable) : NULL;
-    if (!ctx->user_cancellable)
-        /* Just the modem-wide one, use it directly */
-        ctx->cancellable = g_object_ref (ctx->modem_cancellable);
-    else {
-        /* Use the user provided one, which will also get cancelled if the modem
-         * wide-one gets cancelled */
-        ctx->cancellable = g_object_ref (ctx->user_cancellable);
-        ctx->cancelled_id = g_cancellable_connect (ctx->modem_cancellable,
-                                                   G_CALLBACK (modem_cancellable_cancelled),
-                                                   ctx->user_cancellable,
-                                                   NULL);
-    }
+    stats.n_async_results++;
 
     /* Go on with the command */
-    mm_port_serial_at_command (
+    mm_port_serial_at_command_borrowed (
         port,
         command,
         timeout,
         is_raw,
         allow_cached,
+        priority,
         ctx->cancellable,
         (GAsyncReadyCallback)at_command_ready,
         ctx);
@@ -594,6 +782,7 @@ _at_command (MMBaseModem *self,
                                    timeout,
                                    allow_cached,
                                    is_raw,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL,
                                    callback,
                                    user_data);
@@ -620,3 +809,133 @@ mm_base_modem_at_command_raw (MMBaseModem *self,
 {
     _at_command (self, command, timeout, allow_cached, TRUE, callback, user_data);
 }
+
+/*****************************************************************************/
+/* Single AT command handling, borrowed response */
+
+static gboolean
+at_command_borrowed_report_error_idle (AtCommandContext *ctx)
+{
+    ctx->response_func (ctx->self, NULL, 0, ctx->error, ctx->response_func_user_data);
+    at_command_context_free (ctx);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+at_command_borrowed_report_error (MMBaseModem *self,
+                                  GError *error,
+                                  MMBaseModemAtResponseFunc callback,
+                                  gpointer user_data)
+{
+    AtCommandContext *ctx;
+
+    /* Just what's needed to report the error, the context is not accounted
+     * as a command */
+    ctx = context_pool_acquire (&at_command_context_pool);
+    ctx->self = g_object_ref (self);
+    ctx->response_func = callback;
+    ctx->response_func_user_data = user_data;
+    ctx->error = error;
+    g_idle_add ((GSourceFunc)at_command_borrowed_report_error_idle, ctx);
+}
+
+static void
+at_command_borrowed_ready (MMPortSerialAt *port,
+                           GAsyncResult *res,
+                           AtCommandContext *ctx)
+{
+    const gchar *response;
+    gsize response_len = 0;
+    GError *error = NULL;
+
+    response = mm_port_serial_at_command_borrowed_finish (port, res, &response_len, &error);
+    at_metrics_record (ctx->self, ctx->start_time, error);
+
+    /* Cancelled? */
+    if (g_cancellable_is_cancelled (ctx->cancellable)) {
+        g_clear_error (&error);
+        error = g_error_new (MM_CORE_ERROR,
+                             MM_CORE_ERROR_CANCELLED,
+                             "AT command was cancelled");
+        response = NULL;
+        response_len = 0;
+    }
+
+    /* Never in idle, the response is only valid while the port result is */
+    ctx->response_func (ctx->self, response, response_len, error, ctx->response_func_user_data);
+
+    if (error)
+        g_error_free (error);
+    at_command_context_free (ctx);
+}
+
+void
+mm_base_modem_at_command_borrowed_full (MMBaseModem *self,
+                                        MMPortSerialAt *port,
+                                        const gchar *command,
+                                        guint timeout,
+                                        gboolean allow_cached,
+                                        gboolean is_raw,
+                                        MMPortSerialCommandPriority priority,
+                                        GCancellable *cancellable,
+                                        MMBaseModemAtResponseFunc callback,
+                                        gpointer user_data)
+{
+    AtCommandContext *ctx;
+    GError *error = NULL;
+
+    g_assert (callback != NULL);
+
+    /* Ensure that we have an open port */
+    if (!open_port_if_usable (port, &error)) {
+        at_command_borrowed_report_error (self, error, callback, user_data);
+        return;
+    }
+
+    ctx = at_command_context_new (self, port, cancellable);
+    ctx->response_func = callback;
+    ctx->response_func_user_data = user_data;
+    stats.n_borrowed_commands++;
+
+    mm_port_serial_at_command_borrowed (
+        port,
+        command,
+        timeout,
+        is_raw,
+        allow_cached,
+        priority,
+        ctx->cancellable,
+        (GAsyncReadyCallback)at_command_borrowed_ready,
+        ctx);
+}
+
+void
+mm_base_modem_at_command_borrowed (MMBaseModem *self,
+                                   const gchar *command,
+                                   guint timeout,
+                                   gboolean allow_cached,
+                                   MMBaseModemAtResponseFunc callback,
+                                   gpointer user_data)
+{
+    MMPortSerialAt *port;
+    GError *error = NULL;
+
+    /* No port given, so we'll try to guess which is best */
+    port = mm_base_modem_peek_best_at_port (self, &error);
+    if (!port) {
+        g_assert (error != NULL);
+        at_command_borrowed_report_error (self, error, callback, user_data);
+        return;
+    }
+
+    mm_base_modem_at_command_borrowed_full (self,
+                                            port,
+                                            command,
+                                            timeout,
+                                            allow_cached,
+                                            FALSE,
+                                            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                            NULL,
+                                            callback,
+                                            user_data);
+}
@@ -61,6 +61,8 @@ typedef struct {
     gboolean allow_cached;
     /* The response processor */
     MMBaseModemAtResponseProcessor response_processor;
+    /* Priority of the command in the port queue; interactive if not given */
+    MMPortSerialCommandPriority priority;
 } MMBaseModemAtCommand;
 
 /* Generic AT sequence handling, using the best AT port available and without
@@ -157,6 +159,7 @@ void mm_base_modem_at_command_full                (MMBaseModem *self,
                                                    guint timeout,
                                                    gboolean allow_cached,
                                                    gboolean is_raw,
+                                                   MMPortSerialCommandPriority priority,
                                                    GCancellable *cancellable,
                                                    GAsyncReadyCallback callback,
                                                    gpointer user_data);
@@ -164,4 +167,51 @@ const gchar *mm_base_modem_at_command_full_finish (MMBaseModem *self,
                                                    GAsyncResult *res,
                                                    GError **error);
 
+/* AT command handling with a borrowed response.
+ *
+ * Instead of a GAsyncResult, the callback directly gets either the response or
+ * the error. The response is owned by the port and it is only valid until the
+ * callback returns, so it must be copied if needed afterwards. The modem
+ * doesn't create an async result of its own on top of the one of the port
+ * command, which still allocates its result and command buffer as usual, and
+ * the context is taken from a pool, so this is the preferred variant for
+ * commands that are run periodically. */
+typedef void (* MMBaseModemAtResponseFunc) (MMBaseModem *self,
+                                            const gchar *response,
+                                            gsize response_len,
+                                            const GError *error,
+                                            gpointer user_data);
+
+void mm_base_modem_at_command_borrowed      (MMBaseModem *self,
+                                             const gchar *command,
+                                             guint timeout,
+                                             gboolean allow_cached,
+                                             MMBaseModemAtResponseFunc callback,
+                                             gpointer user_data);
+void mm_base_modem_at_command_borrowed_full (MMBaseModem *self,
+                                             MMPortSerialAt *port,
+                                             const gchar *command,
+                                             guint timeout,
+                                             gboolean allow_cached,
+                                             gboolean is_raw,
+                                             MMPortSerialCommandPriority priority,
+                                             GCancellable *cancellable,
+                                             MMBaseModemAtResponseFunc callback,
+                                             gpointer user_data);
+
+/* Process-wide counters of the AT commands run and of the allocations done
+ * for them in the modem; async results are the ones created by the modem on
+ * top of the port command ones */
+typedef struct {
+    guint64 n_commands;
+    guint64 n_borrowed_commands;
+    guint64 n_sequence_commands;
+    guint64 n_contexts_allocated;
+    guint64 n_contexts_reused;
+    guint64 n_async_results;
+} MMBaseModemAtStats;
+
+void mm_base_modem_at_get_stats (MMBaseModemAtStats *stats);
+void mm_base_modem_at_log_stats (void);
+
 #endif /* MM_BASE_MODEM_AT_H */
@@ -884,6 +884,55 @@ mm_base_modem_peek_best_at_port (MMBaseModem *self,
     return NULL;
 }
 
+MMPortSerialAt *
+mm_base_modem_get_scheduled_at_port (MMBaseModem                  *self,
+                                     MMPortSerialCommandPriority   priority,
+                                     GError                      **error)
+{
+    MMPortSerialAt *scheduled;
+
+    scheduled = mm_base_modem_peek_scheduled_at_port (self, priority, error);
+    return (scheduled ? g_object_ref (scheduled) : NULL);
+}
+
+static gboolean
+at_port_schedulable (MMPortSerialAt *port)
+{
+    /* Only consider ports already open, so that we don't end up opening and
+     * closing a port for every single command */
+    return (port &&
+            !mm_port_get_connected (MM_PORT (port)) &&
+            mm_port_serial_is_open (MM_PORT_SERIAL (port)));
+}
+
+MMPortSerialAt *
+mm_base_modem_peek_scheduled_at_port (MMBaseModem                  *self,
+                                      MMPortSerialCommandPriority   priority,
+                                      GError                      **error)
+{
+    guint primary_load;
+    guint secondary_load;
+
+    /* Only background commands are considered independent enough to be run
+     * in any port. Commands which may depend on the channel state (e.g.
+     * selected charset or SMS format) must keep on using the best port.
+     *
+     * Only the primary and secondary ports are candidates: the AT channels of
+     * a CMUX multiplexer are not grabbed by the modem, and any other AT port
+     * is not guaranteed to be set up to run commands. */
+    if (priority != MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND ||
+        !at_port_schedulable (self->priv->primary) ||
+        !at_port_schedulable (self->priv->secondary))
+        return mm_base_modem_peek_best_at_port (self, error);
+
+    /* Both ports available, use the least loaded one, and if both are equally
+     * loaded prefer the secondary one so that the primary port is left for
+     * the user-initiated commands */
+    primary_load = mm_port_serial_get_queue_length (MM_PORT_SERIAL (self->priv->primary));
+    secondary_load = mm_port_serial_get_queue_length (MM_PORT_SERIAL (self->priv->secondary));
+    return (primary_load < secondary_load ? self->priv->primary : self->priv->secondary);
+}
+
 gboolean
 mm_base_modem_has_at_port (MMBaseModem *self)
 {
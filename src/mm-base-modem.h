@@ -130,6 +130,7 @@ MMPortMbim       *mm_base_modem_peek_port_mbim          (MMBaseModem *self);
 MMPortMbim       *mm_base_modem_peek_port_mbim_for_data (MMBaseModem *self, MMPort *data, GError **error);
 #endif
 MMPortSerialAt   *mm_base_modem_peek_best_at_port      (MMBaseModem *self, GError **error);
+MMPortSerialAt   *mm_base_modem_peek_scheduled_at_port (MMBaseModem *self, MMPortSerialCommandPriority priority, GError **error);
 MMPort           *mm_base_modem_peek_best_data_port    (MMBaseModem *self, MMPortType type);
 GList            *mm_base_modem_peek_data_ports        (MMBaseModem *self);
 
@@ -147,6 +148,7 @@ MMPortMbim       *mm_base_modem_get_port_mbim          (MMBaseModem *self);
 MMPortMbim       *mm_base_modem_get_port_mbim_for_data (MMBaseModem *self, MMPort *data, GError **error);
 #endif
 MMPortSerialAt   *mm_base_modem_get_best_at_port      (MMBaseModem *self, GError **error);
+MMPortSerialAt   *mm_base_modem_get_scheduled_at_port (MMBaseModem *self, MMPortSerialCommandPriority priority, GError **error);
 MMPort           *mm_base_modem_get_best_data_port    (MMBaseModem *self, MMPortType type);
 GList            *mm_base_modem_get_data_ports        (MMBaseModem *self);
 
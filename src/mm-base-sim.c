@@ -32,6 +32,7 @@
 #include "mm-base-modem.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-sim-info-cache.h"
 
 static void async_initable_iface_init (GAsyncInitableIface *iface);
 
@@ -951,6 +952,69 @@ mm_base_sim_get_path (MMBaseSim *self)
     return self->priv->path;
 }
 
+/*****************************************************************************/
+/* Cached SIM files
+ *
+ * The default loaders keep the raw contents of the files they read, keyed by
+ * the ICCID of the card, and use them instead of querying the card again the
+ * next time a SIM object is created for the same card. The ICCID itself is
+ * always read, as it's what identifies the card. */
+
+static const gchar *
+sim_file_cache_peek (MMBaseSim *self,
+                     guint file_id)
+{
+    const gchar *iccid;
+
+    iccid = mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (self));
+    return (iccid ? mm_sim_info_cache_peek (iccid, file_id) : NULL);
+}
+
+static void
+sim_file_cache_store (MMBaseSim *self,
+                      guint file_id,
+                      const gchar *contents)
+{
+    const gchar *iccid;
+
+    iccid = mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (self));
+    if (iccid)
+        mm_sim_info_cache_store (iccid, file_id, contents);
+}
+
+/* Completes the load with the cached contents, if any */
+static gboolean
+sim_file_load_from_cache (MMBaseSim *self,
+                          guint file_id,
+                          const gchar *description,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data)
+{
+    const gchar *contents;
+    GTask *task;
+
+    contents = sim_file_cache_peek (self, file_id);
+    if (!contents)
+        return FALSE;
+
+    mm_dbg ("loading %s from cache...", description);
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_return_pointer (task, g_strdup (contents), g_free);
+    g_object_unref (task);
+    return TRUE;
+}
+
+void
+mm_base_sim_invalidate_info_cache (MMBaseSim *self,
+                                   const gchar *reason)
+{
+    const gchar *iccid;
+
+    iccid = mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (self));
+    if (iccid)
+        mm_sim_info_cache_invalidate (iccid, reason);
+}
+
 /*****************************************************************************/
 
 #undef STR_REPLY_READY_FN
@@ -1090,6 +1154,8 @@ load_imsi_finish (MMBaseSim *self,
         return NULL;
 
     imsi = parse_imsi (result, error);
+    if (imsi)
+        sim_file_cache_store (self, MM_SIM_FILE_IMSI, result);
     g_free (result);
     if (!imsi)
         return NULL;
@@ -1105,6 +1171,9 @@ load_imsi (MMBaseSim *self,
            GAsyncReadyCallback callback,
            gpointer user_data)
 {
+    if (sim_file_load_from_cache (self, MM_SIM_FILE_IMSI, "IMSI", callback, user_data))
+        return;
+
     mm_dbg ("loading IMSI...");
 
     mm_base_modem_at_command (
@@ -1197,6 +1266,8 @@ load_operator_identifier_finish (MMBaseSim *self,
         return NULL;
 
     mnc_length = parse_mnc_length (result, &inner_error);
+    if (!inner_error)
+        sim_file_cache_store (self, MM_SIM_FILE_AD, result);
     g_free (result);
     if (inner_error) {
         g_propagate_error (error, inner_error);
@@ -1223,6 +1294,9 @@ load_operator_identifier (MMBaseSim *self,
                           GAsyncReadyCallback callback,
                           gpointer user_data)
 {
+    if (sim_file_load_from_cache (self, MM_SIM_FILE_AD, "Operator ID", callback, user_data))
+        return;
+
     mm_dbg ("loading Operator ID...");
 
     /* READ BINARY of EFad (Administrative Data) ETSI 51.011 section 10.3.18 */
@@ -1307,6 +1381,8 @@ load_operator_name_finish (MMBaseSim *self,
         return NULL;
 
     spn = parse_spn (result, error);
+    if (spn)
+        sim_file_cache_store (self, MM_SIM_FILE_SPN, result);
     g_free (result);
     return spn;
 }
@@ -1318,6 +1394,9 @@ load_operator_name (MMBaseSim *self,
                     GAsyncReadyCallback callback,
                     gpointer user_data)
 {
+    if (sim_file_load_from_cache (self, MM_SIM_FILE_SPN, "Operator Name", callback, user_data))
+        return;
+
     mm_dbg ("loading Operator Name...");
 
     /* READ BINARY of EFspn (Service Provider Name) ETSI 51.011 section 10.3.11 */
@@ -1338,15 +1417,18 @@ static void interface_initialization_step (GTask *task);
 typedef enum {
     INITIALIZATION_STEP_FIRST,
     INITIALIZATION_STEP_SIM_IDENTIFIER,
-    INITIALIZATION_STEP_IMSI,
-    INITIALIZATION_STEP_OPERATOR_ID,
-    INITIALIZATION_STEP_OPERATOR_NAME,
+    INITIALIZATION_STEP_SIM_FILES,
     INITIALIZATION_STEP_LAST
 } InitializationStep;
 
 struct _InitAsyncContext {
     InitializationStep step;
     guint sim_identifier_tries;
+    /* Loads issued together in the SIM files step */
+    guint n_sim_file_loads_pending;
+    GAsyncResult *imsi_result;
+    GAsyncResult *operator_identifier_result;
+    GAsyncResult *operator_name_result;
 };
 
 MMBaseSim *
@@ -1414,35 +1496,64 @@ init_load_sim_identifier_ready (MMBaseSim *self,
     interface_initialization_step (task);
 }
 
+static void
+sim_files_load_done (GTask *task)
+{
+    MMBaseSim *self;
+    InitAsyncContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+    if (--ctx->n_sim_file_loads_pending > 0)
+        return;
+
+    self = g_task_get_source_object (task);
+
+    /* Results are processed in this order regardless of which arrived first,
+     * as the default Operator ID loader needs the IMSI */
+#define SIM_FILE_RESULT_PROCESS(NAME,DISPLAY)                                                \
+    if (ctx->NAME##_result) {                                                                \
+        GError *error = NULL;                                                                \
+        gchar *val;                                                                          \
+                                                                                             \
+        val = MM_BASE_SIM_GET_CLASS (self)->load_##NAME##_finish (self, ctx->NAME##_result, &error); \
+        mm_gdbus_sim_set_##NAME (MM_GDBUS_SIM (self), val);                                  \
+        g_free (val);                                                                        \
+        if (error) {                                                                         \
+            mm_warn ("couldn't load %s: '%s'", DISPLAY, error->message);                     \
+            g_error_free (error);                                                            \
+        }                                                                                    \
+        g_clear_object (&ctx->NAME##_result);                                                \
+    }
+
+    SIM_FILE_RESULT_PROCESS (imsi, "IMSI")
+    SIM_FILE_RESULT_PROCESS (operator_identifier, "Operator identifier")
+    SIM_FILE_RESULT_PROCESS (operator_name, "Operator name")
+
+#undef SIM_FILE_RESULT_PROCESS
+
+    /* Go on to next step */
+    ctx->step++;
+    interface_initialization_step (task);
+}
+
 #undef STR_REPLY_READY_FN
-#define STR_REPLY_READY_FN(NAME,DISPLAY)                                \
+#define STR_REPLY_READY_FN(NAME)                                        \
     static void                                                         \
     init_load_##NAME##_ready (MMBaseSim *self,                          \
                               GAsyncResult *res,                        \
                               GTask *task)                              \
     {                                                                   \
         InitAsyncContext *ctx;                                          \
-        GError *error = NULL;                                           \
-        gchar *val;                                                     \
-                                                                        \
-        val = MM_BASE_SIM_GET_CLASS (self)->load_##NAME##_finish (self, res, &error); \
-        mm_gdbus_sim_set_##NAME (MM_GDBUS_SIM (self), val);             \
-        g_free (val);                                                   \
-                                                                        \
-        if (error) {                                                    \
-            mm_warn ("couldn't load %s: '%s'", DISPLAY, error->message); \
-            g_error_free (error);                                       \
-        }                                                               \
                                                                         \
-        /* Go on to next step */                                        \
+        /* Just keep the result until all loads are done */             \
         ctx = g_task_get_task_data (task);                              \
-        ctx->step++;                                                    \
-        interface_initialization_step (task);                           \
+        ctx->NAME##_result = g_object_ref (res);                        \
+        sim_files_load_done (task);                                     \
     }
 
-STR_REPLY_READY_FN (imsi, "IMSI")
-STR_REPLY_READY_FN (operator_identifier, "Operator identifier")
-STR_REPLY_READY_FN (operator_name, "Operator name")
+STR_REPLY_READY_FN (imsi)
+STR_REPLY_READY_FN (operator_identifier)
+STR_REPLY_READY_FN (operator_name)
 
 static void
 interface_initialization_step (GTask *task)
@@ -1479,53 +1590,36 @@ interface_initialization_step (GTask *task)
         /* Fall down to next step */
         ctx->step++;
 
-    case INITIALIZATION_STEP_IMSI:
-        /* IMSI is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_sim_get_imsi (MM_GDBUS_SIM (self)) == NULL &&
-            MM_BASE_SIM_GET_CLASS (self)->load_imsi &&
-            MM_BASE_SIM_GET_CLASS (self)->load_imsi_finish) {
-            MM_BASE_SIM_GET_CLASS (self)->load_imsi (
-                self,
-                (GAsyncReadyCallback)init_load_imsi_ready,
-                task);
-            return;
+    case INITIALIZATION_STEP_SIM_FILES:
+        /* IMSI, Operator ID and Operator Name are meant to be loaded only
+         * once during the whole lifetime of the modem. Therefore, if we
+         * already have them loaded, don't try to load them again.
+         *
+         * The loads don't depend on each other, so they're all requested
+         * right away and the commands go back-to-back to the modem; the
+         * extra pending count keeps the step from completing while still
+         * issuing them. */
+        ctx->n_sim_file_loads_pending = 1;
+
+#define SIM_FILE_LOAD(NAME)                                                   \
+        if (mm_gdbus_sim_get_##NAME (MM_GDBUS_SIM (self)) == NULL &&          \
+            MM_BASE_SIM_GET_CLASS (self)->load_##NAME &&                      \
+            MM_BASE_SIM_GET_CLASS (self)->load_##NAME##_finish) {             \
+            ctx->n_sim_file_loads_pending++;                                  \
+            MM_BASE_SIM_GET_CLASS (self)->load_##NAME (                       \
+                self,                                                         \
+                (GAsyncReadyCallback)init_load_##NAME##_ready,                \
+                task);                                                        \
         }
-        /* Fall down to next step */
-        ctx->step++;
 
-    case INITIALIZATION_STEP_OPERATOR_ID:
-        /* Operator ID is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_sim_get_operator_identifier (MM_GDBUS_SIM (self)) == NULL &&
-            MM_BASE_SIM_GET_CLASS (self)->load_operator_identifier &&
-            MM_BASE_SIM_GET_CLASS (self)->load_operator_identifier_finish) {
-            MM_BASE_SIM_GET_CLASS (self)->load_operator_identifier (
-                self,
-                (GAsyncReadyCallback)init_load_operator_identifier_ready,
-                task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+        SIM_FILE_LOAD (imsi)
+        SIM_FILE_LOAD (operator_identifier)
+        SIM_FILE_LOAD (operator_name)
 
-    case INITIALIZATION_STEP_OPERATOR_NAME:
-        /* Operator Name is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_sim_get_operator_name (MM_GDBUS_SIM (self)) == NULL &&
-            MM_BASE_SIM_GET_CLASS (self)->load_operator_name &&
-            MM_BASE_SIM_GET_CLASS (self)->load_operator_name_finish) {
-            MM_BASE_SIM_GET_CLASS (self)->load_operator_name (
-                self,
-                (GAsyncReadyCallback)init_load_operator_name_ready,
-                task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+#undef SIM_FILE_LOAD
+
+        sim_files_load_done (task);
+        return;
 
     case INITIALIZATION_STEP_LAST:
         /* We are done without errors! */
@@ -1550,9 +1644,8 @@ common_init_async (GAsyncInitable *initable,
 
     self = MM_BASE_SIM (initable);
 
-    ctx = g_new (InitAsyncContext, 1);
+    ctx = g_new0 (InitAsyncContext, 1);
     ctx->step = INITIALIZATION_STEP_FIRST;
-    ctx->sim_identifier_tries = 0;
 
     task = g_task_new (self, cancellable, callback, user_data);
     g_task_set_task_data (task, ctx, g_free);
@@ -172,4 +172,8 @@ gchar       *mm_base_sim_load_sim_identifier_finish (MMBaseSim *self,
                                                      GAsyncResult *res,
                                                      GError **error);
 
+/* Forget the cached files of the card, so that they're read again */
+void         mm_base_sim_invalidate_info_cache      (MMBaseSim *self,
+                                                     const gchar *reason);
+
 #endif /* MM_BASE_SIM_H */
@@ -508,16 +508,16 @@ handle_send_context_free (HandleSendContext *ctx)
 }
 
 static void
-handle_send_ready (MMBaseSms *self,
+handle_send_ready (MMIfaceModemMessaging *modem,
                    GAsyncResult *res,
                    HandleSendContext *ctx)
 {
     GError *error = NULL;
 
-    if (!MM_BASE_SMS_GET_CLASS (self)->send_finish (self, res, &error)) {
+    if (!mm_iface_modem_messaging_send_sms_finish (modem, res, &error)) {
         /* On error, clear up the parts we generated */
-        g_list_free_full (self->priv->parts, (GDestroyNotify)mm_sms_part_free);
-        self->priv->parts = NULL;
+        g_list_free_full (ctx->self->priv->parts, (GDestroyNotify)mm_sms_part_free);
+        ctx->self->priv->parts = NULL;
         g_dbus_method_invocation_take_error (ctx->invocation, error);
     } else {
         /* Transition from Unknown->Sent or Stored->Sent */
@@ -620,9 +620,12 @@ handle_send_auth_ready (MMBaseModem *modem,
         return;
     }
 
-    MM_BASE_SMS_GET_CLASS (ctx->self)->send (ctx->self,
-                                             (GAsyncReadyCallback)handle_send_ready,
-                                             ctx);
+    /* Sending is serialized per modem, so that concurrent requests don't
+     * fight for the storage locks or interleave their commands */
+    mm_iface_modem_messaging_send_sms (MM_IFACE_MODEM_MESSAGING (ctx->modem),
+                                       ctx->self,
+                                       (GAsyncReadyCallback)handle_send_ready,
+                                       ctx);
 }
 
 static gboolean
@@ -1026,13 +1029,31 @@ sms_store (MMBaseSms *self,
 /*****************************************************************************/
 /* Send the SMS */
 
+/* Whether the modem supports keeping the relay protocol link open between
+ * consecutive messages with AT+CMMS=1; probed once per modem */
+typedef enum {
+    CMMS_SUPPORT_UNKNOWN,
+    CMMS_SUPPORT_NO,
+    CMMS_SUPPORT_YES,
+} CmmsSupport;
+
+static GQuark cmms_support_quark;
+
 typedef struct {
     MMBaseModem *modem;
     gboolean need_unlock;
     gboolean from_storage;
+    /* Storage lock already held by the caller */
+    gboolean storage_locked;
     gboolean use_pdu_mode;
     GList *current;
     gchar *msg_data;
+    /* Multipart sending */
+    guint n_parts;
+    guint n_parts_sent;
+    gboolean keep_link;
+    gint64 start_time;
+    gint64 part_start_time;
 } SmsSendContext;
 
 static void
@@ -1081,12 +1102,35 @@ read_message_reference_from_reply (const gchar *response,
     return idx;
 }
 
+static void
+sms_send_part_done (GTask *task,
+                    gint message_reference)
+{
+    SmsSendContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+
+    mm_sms_part_set_message_reference ((MMSmsPart *)ctx->current->data,
+                                       (guint)message_reference);
+
+    ctx->n_parts_sent++;
+    if (ctx->n_parts > 1)
+        mm_dbg ("SMS part %u/%u sent in %.3fs (message reference %d, link %s)",
+                ctx->n_parts_sent,
+                ctx->n_parts,
+                (g_get_monotonic_time () - ctx->part_start_time) / (gdouble) G_USEC_PER_SEC,
+                message_reference,
+                ctx->keep_link ? "kept open" : "not kept open");
+
+    ctx->current = g_list_next (ctx->current);
+    sms_send_next_part (task);
+}
+
 static void
 send_generic_msg_data_ready (MMBaseModem *modem,
                              GAsyncResult *res,
                              GTask *task)
 {
-    SmsSendContext *ctx;
     GError *error = NULL;
     const gchar *response;
     gint message_reference;
@@ -1105,13 +1149,7 @@ send_generic_msg_data_ready (MMBaseModem *modem,
         return;
     }
 
-    ctx = g_task_get_task_data (task);
-
-    mm_sms_part_set_message_reference ((MMSmsPart *)ctx->current->data,
-                                       (guint)message_reference);
-
-    ctx->current = g_list_next (ctx->current);
-    sms_send_next_part (task);
+    sms_send_part_done (task, message_reference);
 }
 
 static void
@@ -1176,11 +1214,7 @@ send_from_storage_ready (MMBaseModem *modem,
         return;
     }
 
-    mm_sms_part_set_message_reference ((MMSmsPart *)ctx->current->data,
-                                       (guint)message_reference);
-
-    ctx->current = g_list_next (ctx->current);
-    sms_send_next_part (task);
+    sms_send_part_done (task, message_reference);
 }
 
 static void
@@ -1193,12 +1227,23 @@ sms_send_next_part (GTask *task)
     ctx = g_task_get_task_data (task);
 
     if (!ctx->current) {
+        if (ctx->n_parts > 1) {
+            gdouble elapsed;
+
+            elapsed = (g_get_monotonic_time () - ctx->start_time) / (gdouble) G_USEC_PER_SEC;
+            mm_dbg ("Multipart SMS sent in %.3fs: %u parts, %.3fs per part on average (link %s)",
+                    elapsed, ctx->n_parts, elapsed / ctx->n_parts,
+                    ctx->keep_link ? "kept open" : "not kept open");
+        }
+
         /* Done we are */
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
         return;
     }
 
+    ctx->part_start_time = g_get_monotonic_time ();
+
     /* Send from storage */
     if (ctx->from_storage) {
         cmd = g_strdup_printf ("+CMSS=%d",
@@ -1239,6 +1284,103 @@ sms_send_next_part (GTask *task)
     g_free (cmd);
 }
 
+static void
+cmms_set_ready (MMBaseModem *modem,
+                GAsyncResult *res,
+                GTask *task)
+{
+    SmsSendContext *ctx;
+    GError *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+
+    /* Not fatal, the parts are just sent without keeping the link open */
+    if (!mm_base_modem_at_command_finish (modem, res, &error)) {
+        mm_dbg ("Couldn't keep the link open while sending multipart SMS: '%s'", error->message);
+        g_error_free (error);
+    } else
+        ctx->keep_link = TRUE;
+
+    sms_send_next_part (task);
+}
+
+static void
+sms_send_keep_link (GTask *task)
+{
+    SmsSendContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+
+    if (GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (ctx->modem), cmms_support_quark)) != CMMS_SUPPORT_YES) {
+        sms_send_next_part (task);
+        return;
+    }
+
+    /* Mode 1 goes back to 0 by itself once no more messages are sent
+     * within the modem's timeout, so there is no need to disable it once
+     * done, even if sending fails */
+    mm_base_modem_at_command (ctx->modem,
+                              "+CMMS=1",
+                              3,
+                              FALSE,
+                              (GAsyncReadyCallback)cmms_set_ready,
+                              task);
+}
+
+static void
+cmms_test_ready (MMBaseModem *modem,
+                 GAsyncResult *res,
+                 GTask *task)
+{
+    const gchar *response;
+    gboolean keep_link_supported = FALSE;
+    GError *error = NULL;
+
+    response = mm_base_modem_at_command_finish (modem, res, &error);
+    if (!response || !mm_3gpp_parse_cmms_test_response (response, &keep_link_supported, &error)) {
+        mm_dbg ("Keeping the link open between SMS messages is unsupported: '%s'", error->message);
+        g_error_free (error);
+    }
+
+    g_object_set_qdata (G_OBJECT (modem),
+                        cmms_support_quark,
+                        GUINT_TO_POINTER (keep_link_supported ? CMMS_SUPPORT_YES : CMMS_SUPPORT_NO));
+    sms_send_keep_link (task);
+}
+
+static void
+sms_send_start (GTask *task,
+                GList *parts)
+{
+    SmsSendContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+    ctx->current = parts;
+    ctx->n_parts = g_list_length (parts);
+    ctx->start_time = g_get_monotonic_time ();
+
+    /* Single part, nothing else to do */
+    if (ctx->n_parts < 2) {
+        sms_send_next_part (task);
+        return;
+    }
+
+    /* With multiple parts, try to keep the relay protocol link open until
+     * the last one has been sent, so that it's not released and set up again
+     * between parts */
+    if (GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (ctx->modem), cmms_support_quark)) == CMMS_SUPPORT_UNKNOWN) {
+        mm_base_modem_at_command (ctx->modem,
+                                  "+CMMS=?",
+                                  3,
+                                  TRUE,
+                                  (GAsyncReadyCallback)cmms_test_ready,
+                                  task);
+        return;
+    }
+
+    sms_send_keep_link (task);
+}
+
 static void
 send_lock_sms_storages_ready (MMBroadbandModem *modem,
                               GAsyncResult *res,
@@ -1262,14 +1404,14 @@ send_lock_sms_storages_ready (MMBroadbandModem *modem,
     ctx->need_unlock = TRUE;
 
     /* Go on to send the parts */
-    ctx->current = self->priv->parts;
-    sms_send_next_part (task);
+    sms_send_start (task, self->priv->parts);
 }
 
 static void
-sms_send (MMBaseSms *self,
-          GAsyncReadyCallback callback,
-          gpointer user_data)
+sms_send_full (MMBaseSms *self,
+               gboolean storage_locked,
+               GAsyncReadyCallback callback,
+               gpointer user_data)
 {
     SmsSendContext *ctx;
     GTask *task;
@@ -1277,12 +1419,18 @@ sms_send (MMBaseSms *self,
     /* Setup the context */
     ctx = g_new0 (SmsSendContext, 1);
     ctx->modem = g_object_ref (self->priv->modem);
+    ctx->storage_locked = storage_locked;
 
     task = g_task_new (self, NULL, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)sms_send_context_free);
 
     /* If the SMS is STORED, try to send from storage */
     ctx->from_storage = (mm_base_sms_get_storage (self) != MM_SMS_STORAGE_UNKNOWN);
+    if (ctx->from_storage && ctx->storage_locked) {
+        /* Lock already held by the caller, which will also release it */
+        sms_send_start (task, self->priv->parts);
+        return;
+    }
     if (ctx->from_storage) {
         /* When sending from storage, first lock storage to use */
         g_assert (MM_IS_BROADBAND_MODEM (self->priv->modem));
@@ -1299,8 +1447,51 @@ sms_send (MMBaseSms *self,
     g_object_get (self->priv->modem,
                   MM_IFACE_MODEM_MESSAGING_SMS_PDU_MODE, &ctx->use_pdu_mode,
                   NULL);
-    ctx->current = self->priv->parts;
-    sms_send_next_part (task);
+    sms_send_start (task, self->priv->parts);
+}
+
+static void
+sms_send (MMBaseSms *self,
+          GAsyncReadyCallback callback,
+          gpointer user_data)
+{
+    sms_send_full (self, FALSE, callback, user_data);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_base_sms_send_finish (MMBaseSms *self,
+                         GAsyncResult *res,
+                         GError **error)
+{
+    return MM_BASE_SMS_GET_CLASS (self)->send_finish (self, res, error);
+}
+
+void
+mm_base_sms_send (MMBaseSms *self,
+                  gboolean storage_locked,
+                  GAsyncReadyCallback callback,
+                  gpointer user_data)
+{
+    /* Only the generic AT based implementation locks storages, see
+     * mm_base_sms_get_send_lock_storage() */
+    if (MM_BASE_SMS_GET_CLASS (self)->send == sms_send) {
+        sms_send_full (self, storage_locked, callback, user_data);
+        return;
+    }
+
+    MM_BASE_SMS_GET_CLASS (self)->send (self, callback, user_data);
+}
+
+MMSmsStorage
+mm_base_sms_get_send_lock_storage (MMBaseSms *self)
+{
+    /* Only the generic AT based implementation locks storages */
+    if (MM_BASE_SMS_GET_CLASS (self)->send != sms_send)
+        return MM_SMS_STORAGE_UNKNOWN;
+
+    return mm_base_sms_get_storage (self);
 }
 
 /*****************************************************************************/
@@ -2001,6 +2192,8 @@ mm_base_sms_class_init (MMBaseSmsClass *klass)
 
     g_type_class_add_private (object_class, sizeof (MMBaseSmsPrivate));
 
+    cmms_support_quark = g_quark_from_static_string ("mm-base-sms-cmms-support");
+
     /* Virtual methods */
     object_class->get_property = get_property;
     object_class->set_property = set_property;
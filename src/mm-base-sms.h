@@ -116,6 +116,18 @@ guint        mm_base_sms_get_multipart_reference (MMBaseSms *self);
 gboolean     mm_base_sms_multipart_is_complete   (MMBaseSms *self);
 gboolean     mm_base_sms_multipart_is_assembled  (MMBaseSms *self);
 
+/* Send the SMS right away, used by the per-modem send queue. If
+ * @storage_locked is TRUE, the caller already holds the lock of the storage
+ * returned by mm_base_sms_get_send_lock_storage() */
+void         mm_base_sms_send                   (MMBaseSms *self,
+                                                 gboolean storage_locked,
+                                                 GAsyncReadyCallback callback,
+                                                 gpointer user_data);
+gboolean     mm_base_sms_send_finish            (MMBaseSms *self,
+                                                 GAsyncResult *res,
+                                                 GError **error);
+MMSmsStorage mm_base_sms_get_send_lock_storage  (MMBaseSms *self);
+
 void     mm_base_sms_delete        (MMBaseSms *self,
                                     GAsyncReadyCallback callback,
                                     gpointer user_data);
@@ -33,6 +33,7 @@
 #include "mm-port-enums-types.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-trace.h"
 
 G_DEFINE_TYPE (MMBearerQmi, mm_bearer_qmi, MM_TYPE_BASE_BEARER)
 
@@ -440,6 +441,8 @@ typedef struct {
     guint32 packet_data_handle_ipv6;
     MMBearerIpConfig *ipv6_config;
     GError *error_ipv6;
+
+    MMTraceSequence trace;
 } ConnectContext;
 
 static void
@@ -472,6 +475,7 @@ connect_context_free (ConnectContext *ctx)
                                                  &ctx->event_report_ipv6_indication_id);
     }
 
+    mm_trace_sequence_clear (&ctx->trace);
     g_clear_error (&ctx->error_ipv4);
     g_clear_error (&ctx->error_ipv6);
     g_clear_object (&ctx->client_ipv4);
@@ -1225,6 +1229,7 @@ connect_context_step (GTask *task)
         ctx->step++;
 
     case CONNECT_STEP_OPEN_QMI_PORT:
+        mm_trace_sequence_step (&ctx->trace, "open-qmi-port");
         if (!mm_port_qmi_is_open (ctx->qmi)) {
             mm_port_qmi_open (ctx->qmi,
                               TRUE,
@@ -1270,6 +1275,7 @@ connect_context_step (GTask *task)
     case CONNECT_STEP_WDS_CLIENT_IPV4: {
         QmiClient *client;
 
+        mm_trace_sequence_step (&ctx->trace, "wds-client-ipv4");
         client = mm_port_qmi_get_client (ctx->qmi,
                                          QMI_SERVICE_WDS,
                                          MM_PORT_QMI_FLAG_WDS_IPV4);
@@ -1290,6 +1296,7 @@ connect_context_step (GTask *task)
     }
 
     case CONNECT_STEP_IP_FAMILY_IPV4:
+        mm_trace_sequence_step (&ctx->trace, "ip-family-ipv4");
         /* If client is new enough, select IP family */
         if (!ctx->no_ip_family_preference &&
             qmi_client_check_version (QMI_CLIENT (ctx->client_ipv4), 1, 9)) {
@@ -1314,6 +1321,7 @@ connect_context_step (GTask *task)
         ctx->step++;
 
     case CONNECT_STEP_ENABLE_INDICATIONS_IPV4:
+        mm_trace_sequence_step (&ctx->trace, "enable-indications-ipv4");
         common_setup_cleanup_packet_service_status_unsolicited_events (ctx->self,
                                                                        ctx->client_ipv4,
                                                                        TRUE,
@@ -1328,6 +1336,7 @@ connect_context_step (GTask *task)
     case CONNECT_STEP_START_NETWORK_IPV4: {
         QmiMessageWdsStartNetworkInput *input;
 
+        mm_trace_sequence_step (&ctx->trace, "start-network-ipv4");
         mm_dbg ("Starting IPv4 connection...");
         input = build_start_network_input (ctx);
         qmi_client_wds_start_network (ctx->client_ipv4,
@@ -1341,6 +1350,7 @@ connect_context_step (GTask *task)
     }
 
     case CONNECT_STEP_GET_CURRENT_SETTINGS_IPV4: {
+        mm_trace_sequence_step (&ctx->trace, "get-current-settings-ipv4");
         /* Retrieve and print IP configuration */
         if (ctx->packet_data_handle_ipv4) {
             mm_dbg ("Getting IPv4 configuration...");
@@ -1369,6 +1379,7 @@ connect_context_step (GTask *task)
     case CONNECT_STEP_WDS_CLIENT_IPV6: {
         QmiClient *client;
 
+        mm_trace_sequence_step (&ctx->trace, "wds-client-ipv6");
         client = mm_port_qmi_get_client (ctx->qmi,
                                          QMI_SERVICE_WDS,
                                          MM_PORT_QMI_FLAG_WDS_IPV6);
@@ -1389,7 +1400,7 @@ connect_context_step (GTask *task)
     }
 
     case CONNECT_STEP_IP_FAMILY_IPV6:
-
+        mm_trace_sequence_step (&ctx->trace, "ip-family-ipv6");
         g_assert (ctx->no_ip_family_preference == FALSE);
 
         /* If client is new enough, select IP family */
@@ -1415,6 +1426,7 @@ connect_context_step (GTask *task)
         ctx->step++;
 
     case CONNECT_STEP_ENABLE_INDICATIONS_IPV6:
+        mm_trace_sequence_step (&ctx->trace, "enable-indications-ipv6");
         common_setup_cleanup_packet_service_status_unsolicited_events (ctx->self,
                                                                        ctx->client_ipv6,
                                                                        TRUE,
@@ -1429,6 +1441,7 @@ connect_context_step (GTask *task)
     case CONNECT_STEP_START_NETWORK_IPV6: {
         QmiMessageWdsStartNetworkInput *input;
 
+        mm_trace_sequence_step (&ctx->trace, "start-network-ipv6");
         mm_dbg ("Starting IPv6 connection...");
         input = build_start_network_input (ctx);
         qmi_client_wds_start_network (ctx->client_ipv6,
@@ -1442,6 +1455,7 @@ connect_context_step (GTask *task)
     }
 
     case CONNECT_STEP_GET_CURRENT_SETTINGS_IPV6: {
+        mm_trace_sequence_step (&ctx->trace, "get-current-settings-ipv6");
         /* Retrieve and print IP configuration */
         if (ctx->packet_data_handle_ipv6) {
             mm_dbg ("Getting IPv6 configuration...");
@@ -1485,6 +1499,7 @@ connect_context_step (GTask *task)
             }
 
             /* Set operation result */
+            mm_trace_sequence_complete (&ctx->trace, NULL);
             g_task_return_pointer (
                 task,
                 mm_bearer_connect_result_new (ctx->data, ctx->ipv4_config, ctx->ipv6_config),
@@ -1501,6 +1516,7 @@ connect_context_step (GTask *task)
                 ctx->error_ipv6 = NULL;
             }
 
+            mm_trace_sequence_complete (&ctx->trace, error);
             g_task_return_error (task, error);
         }
 
@@ -1603,6 +1619,7 @@ _connect (MMBaseBearer *self,
     ctx->data = data;
     ctx->step = CONNECT_STEP_FIRST;
     ctx->ip_method = MM_BEARER_IP_METHOD_UNKNOWN;
+    mm_trace_sequence_init (&ctx->trace, mm_base_bearer_get_path (self), "connection");
 
     g_object_get (self,
                   MM_BASE_BEARER_CONFIG, &properties,
@@ -34,6 +34,7 @@
 #include "mm-base-modem-at.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-trace.h"
 #include "mm-port-enums-types.h"
 #include "mm-helper-enums-types.h"
 
@@ -70,6 +71,9 @@ struct _MMBroadbandBearerPrivate {
     /*-- 3GPP specific --*/
     /* CID of the PDP context */
     guint cid;
+
+    /* Ongoing connect status poll */
+    GTask *connect_poll_task;
 };
 
 /*****************************************************************************/
@@ -80,6 +84,228 @@ mm_broadband_bearer_get_3gpp_cid (MMBroadbandBearer *self)
     return self->priv->cid;
 }
 
+/*****************************************************************************/
+/* Connect status polling */
+
+typedef struct {
+    MMBroadbandBearerPollCheckFn        check;
+    MMBroadbandBearerPollCheckFinishFn  check_finish;
+    gpointer                            check_data;
+    guint                               delay_ms;
+    guint                               max_delay_ms;
+    gint64                              deadline;
+    guint                               timeout_id;
+    guint                               n_checks;
+    gboolean                            check_running;
+    GError                             *last_error;
+    gboolean                            reported;
+    GError                             *reported_error;
+} ConnectPollContext;
+
+static void
+connect_poll_context_free (ConnectPollContext *ctx)
+{
+    g_assert (!ctx->timeout_id);
+    g_clear_error (&ctx->last_error);
+    g_clear_error (&ctx->reported_error);
+    g_slice_free (ConnectPollContext, ctx);
+}
+
+gboolean
+mm_broadband_bearer_connect_poll_finish (MMBroadbandBearer  *self,
+                                         GAsyncResult       *res,
+                                         GError            **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+connect_poll_complete (GTask  *task,
+                       GError *error)
+{
+    MMBroadbandBearer  *self;
+    ConnectPollContext *ctx;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    g_assert (self->priv->connect_poll_task == task);
+    self->priv->connect_poll_task = NULL;
+
+    if (ctx->timeout_id) {
+        g_source_remove (ctx->timeout_id);
+        ctx->timeout_id = 0;
+    }
+
+    mm_dbg ("Connect status polling finished after %u checks", ctx->n_checks);
+
+    if (error)
+        g_task_return_error (task, error);
+    else
+        g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+static void connect_poll_schedule (GTask *task);
+
+static void
+connect_poll_check_ready (GObject      *source,
+                          GAsyncResult *res,
+                          GTask        *task)
+{
+    MMBroadbandBearer           *self;
+    ConnectPollContext          *ctx;
+    MMBroadbandBearerPollResult  result;
+    GError                      *error = NULL;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    ctx->check_running = FALSE;
+    result = ctx->check_finish (self, ctx->check_data, res, &error);
+
+    /* A report received while the check was running wins */
+    if (ctx->reported) {
+        g_clear_error (&error);
+        error = ctx->reported_error;
+        ctx->reported_error = NULL;
+        connect_poll_complete (task, error);
+        return;
+    }
+
+    switch (result) {
+    case MM_BROADBAND_BEARER_POLL_DONE:
+        g_clear_error (&error);
+        connect_poll_complete (task, NULL);
+        return;
+    case MM_BROADBAND_BEARER_POLL_FAILED:
+        g_assert (error);
+        connect_poll_complete (task, error);
+        return;
+    case MM_BROADBAND_BEARER_POLL_CONTINUE:
+        /* Errors while still pending are only reported if we time out */
+        if (error) {
+            mm_dbg ("Connect status check %u: %s", ctx->n_checks, error->message);
+            g_clear_error (&ctx->last_error);
+            ctx->last_error = error;
+        }
+        connect_poll_schedule (task);
+        return;
+    }
+
+    g_assert_not_reached ();
+}
+
+static gboolean
+connect_poll_timeout_cb (GTask *task)
+{
+    MMBroadbandBearer  *self;
+    ConnectPollContext *ctx;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+    ctx->timeout_id = 0;
+
+    ctx->n_checks++;
+    ctx->check_running = TRUE;
+    ctx->check (self,
+                ctx->check_data,
+                (GAsyncReadyCallback) connect_poll_check_ready,
+                task);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+connect_poll_schedule (GTask *task)
+{
+    ConnectPollContext *ctx;
+    GError             *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+
+    if (g_cancellable_set_error_if_cancelled (g_task_get_cancellable (task), &error)) {
+        connect_poll_complete (task, error);
+        return;
+    }
+
+    if (g_get_monotonic_time () >= ctx->deadline) {
+        if (ctx->last_error) {
+            error = ctx->last_error;
+            ctx->last_error = NULL;
+        } else
+            error = g_error_new (MM_MOBILE_EQUIPMENT_ERROR,
+                                 MM_MOBILE_EQUIPMENT_ERROR_NETWORK_TIMEOUT,
+                                 "Connection attempt timed out");
+        connect_poll_complete (task, error);
+        return;
+    }
+
+    g_assert (!ctx->timeout_id);
+    ctx->timeout_id = g_timeout_add (ctx->delay_ms, (GSourceFunc) connect_poll_timeout_cb, task);
+    ctx->delay_ms = MIN (ctx->delay_ms * 2, ctx->max_delay_ms);
+}
+
+void
+mm_broadband_bearer_connect_poll (MMBroadbandBearer                  *self,
+                                  guint                               initial_delay_ms,
+                                  guint                               max_delay_ms,
+                                  guint                               timeout_ms,
+                                  MMBroadbandBearerPollCheckFn        check,
+                                  MMBroadbandBearerPollCheckFinishFn  check_finish,
+                                  gpointer                            check_data,
+                                  GCancellable                       *cancellable,
+                                  GAsyncReadyCallback                 callback,
+                                  gpointer                            user_data)
+{
+    ConnectPollContext *ctx;
+    GTask              *task;
+
+    g_assert (initial_delay_ms > 0 && initial_delay_ms <= max_delay_ms);
+    g_assert (check && check_finish);
+
+    ctx = g_slice_new0 (ConnectPollContext);
+    ctx->check = check;
+    ctx->check_finish = check_finish;
+    ctx->check_data = check_data;
+    ctx->delay_ms = initial_delay_ms;
+    ctx->max_delay_ms = max_delay_ms;
+    ctx->deadline = g_get_monotonic_time () + ((gint64) timeout_ms * 1000);
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_check_cancellable (task, FALSE);
+    g_task_set_task_data (task, ctx, (GDestroyNotify) connect_poll_context_free);
+
+    g_assert (!self->priv->connect_poll_task);
+    self->priv->connect_poll_task = task;
+
+    connect_poll_schedule (task);
+}
+
+void
+mm_broadband_bearer_connect_poll_report (MMBroadbandBearer *self,
+                                         const GError      *error)
+{
+    GTask              *task;
+    ConnectPollContext *ctx;
+
+    task = self->priv->connect_poll_task;
+    if (!task)
+        return;
+
+    ctx = g_task_get_task_data (task);
+
+    /* The check callback completes the poll */
+    if (ctx->check_running) {
+        if (!ctx->reported) {
+            ctx->reported = TRUE;
+            ctx->reported_error = (error ? g_error_copy (error) : NULL);
+        }
+        return;
+    }
+
+    connect_poll_complete (task, error ? g_error_copy (error) : NULL);
+}
+
 /*****************************************************************************/
 
 static MMBearerIpFamily
@@ -113,6 +339,7 @@ typedef struct {
 
     /* 3GPP-specific */
     MMBearerIpFamily ip_family;
+    MMTraceSequence trace;
 } DetailedConnectContext;
 
 static MMBearerConnectResult *
@@ -134,6 +361,7 @@ detailed_connect_context_free (DetailedConnectContext *ctx)
             mm_port_serial_close (MM_PORT_SERIAL (ctx->data));
         g_object_unref (ctx->data);
     }
+    mm_trace_sequence_clear (&ctx->trace);
     g_object_unref (ctx->modem);
     g_slice_free (DetailedConnectContext, ctx);
 }
@@ -273,6 +501,7 @@ cdma_connect_context_dial (GTask *task)
                                    90,
                                    FALSE,
                                    FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL,
                                    (GAsyncReadyCallback)dial_cdma_ready,
                                    task);
@@ -365,6 +594,7 @@ current_rm_protocol_ready (MMBaseModem *self,
                                        3,
                                        FALSE,
                                        FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL,
                                        (GAsyncReadyCallback)set_rm_protocol_ready,
                                        task);
@@ -417,6 +647,7 @@ connect_cdma (MMBroadbandBearer *self,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)current_rm_protocol_ready,
                                        task);
@@ -521,6 +752,7 @@ atd_ready (MMBaseModem *modem,
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)extended_error_ready,
                                        task);
@@ -593,6 +825,7 @@ dial_3gpp (MMBroadbandBearer *self,
                                    60,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)atd_ready,
                                    task);
@@ -708,6 +941,7 @@ find_cid_ready (MMBaseModem  *modem,
                                    3,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback) initialize_pdp_context_ready,
                                    task);
@@ -964,6 +1198,7 @@ get_ip_config_3gpp_ready (MMBroadbandBearer *self,
                                                                           &ipv4_config,
                                                                           &ipv6_config,
                                                                           &error)) {
+        mm_trace_sequence_complete (&ctx->trace, error);
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
@@ -973,6 +1208,7 @@ get_ip_config_3gpp_ready (MMBroadbandBearer *self,
     if (MM_IS_PORT_SERIAL_AT (ctx->data))
         ctx->close_data_on_exit = FALSE;
 
+    mm_trace_sequence_complete (&ctx->trace, NULL);
     g_task_return_pointer (
         task,
         mm_bearer_connect_result_new (ctx->data, ipv4_config, ipv6_config),
@@ -1002,6 +1238,7 @@ dial_3gpp_ready (MMBroadbandBearer *self,
     if (!ctx->data) {
         /* Clear CID when it failed to connect. */
         self->priv->cid = 0;
+        mm_trace_sequence_complete (&ctx->trace, error);
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
@@ -1015,6 +1252,7 @@ dial_3gpp_ready (MMBroadbandBearer *self,
     if (MM_BROADBAND_BEARER_GET_CLASS (self)->get_ip_config_3gpp &&
         MM_BROADBAND_BEARER_GET_CLASS (self)->get_ip_config_3gpp_finish) {
         /* Launch specific IP config retrieval */
+        mm_trace_sequence_step (&ctx->trace, "ip-config");
         MM_BROADBAND_BEARER_GET_CLASS (self)->get_ip_config_3gpp (
             self,
             MM_BROADBAND_MODEM (ctx->modem),
@@ -1052,6 +1290,7 @@ dial_3gpp_ready (MMBroadbandBearer *self,
     }
     g_assert (ipv4_config || ipv6_config);
 
+    mm_trace_sequence_complete (&ctx->trace, NULL);
     g_task_return_pointer (
         task,
         mm_bearer_connect_result_new (ctx->data, ipv4_config, ipv6_config),
@@ -1076,11 +1315,13 @@ cid_selection_3gpp_ready (MMBroadbandBearer *self,
      * handle corresponding unsolicited PDP activation responses. */
     self->priv->cid = MM_BROADBAND_BEARER_GET_CLASS (self)->cid_selection_3gpp_finish (self, res, &error);
     if (!self->priv->cid) {
+        mm_trace_sequence_complete (&ctx->trace, error);
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
     }
 
+    mm_trace_sequence_step (&ctx->trace, "dial");
     MM_BROADBAND_BEARER_GET_CLASS (self)->dial_3gpp (self,
                                                      ctx->modem,
                                                      ctx->primary,
@@ -1108,10 +1349,12 @@ connect_3gpp (MMBroadbandBearer   *self,
     self->priv->cid = 0;
 
     ctx = detailed_connect_context_new (self, modem, primary, secondary);
+    mm_trace_sequence_init (&ctx->trace, mm_base_bearer_get_path (MM_BASE_BEARER (self)), "connection");
 
     task = g_task_new (self, cancellable, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)detailed_connect_context_free);
 
+    mm_trace_sequence_step (&ctx->trace, "cid-selection");
     MM_BROADBAND_BEARER_GET_CLASS (self)->cid_selection_3gpp (self,
                                                               ctx->modem,
                                                               ctx->primary,
@@ -1586,6 +1829,7 @@ data_flash_3gpp_ready (MMPortSerial *data,
                                    10,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL,
                                    NULL, /* cancellable */
                                    (GAsyncReadyCallback)cgact_data_ready,
                                    task);
@@ -1697,6 +1941,7 @@ disconnect_3gpp (MMBroadbandBearer *self,
                                        10,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)cgact_ready,
                                        task);
@@ -1716,6 +1961,7 @@ disconnect_3gpp (MMBroadbandBearer *self,
                                        10,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)cgact_ready,
                                        task);
@@ -1891,48 +2137,16 @@ load_connection_status_finish (MMBaseBearer  *bearer,
 }
 
 static void
-cgact_periodic_query_ready (MMBaseModem  *modem,
-                            GAsyncResult *res,
-                            GTask        *task)
+pdp_context_status_ready (MMBroadbandModem *modem,
+                          GAsyncResult     *res,
+                          GTask            *task)
 {
-    MMBroadbandBearer        *self;
-    const gchar              *response;
+    MMBearerConnectionStatus  status;
     GError                   *error = NULL;
-    GList                    *pdp_active_list = NULL;
-    GList                    *l;
-    MMBearerConnectionStatus  status = MM_BEARER_CONNECTION_STATUS_UNKNOWN;
-
-    self = MM_BROADBAND_BEARER (g_task_get_source_object (task));
 
-    response = mm_base_modem_at_command_finish (modem, res, &error);
-    if (response)
-        pdp_active_list = mm_3gpp_parse_cgact_read_response (response, &error);
-
-    if (error) {
-        g_assert (!pdp_active_list);
-        g_prefix_error (&error, "Couldn't check current list of active PDP contexts: ");
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
-
-    for (l = pdp_active_list; l; l = g_list_next (l)) {
-        MM3gppPdpContextActive *pdp_active;
-
-        /* We look for he just assume the first active PDP context found is the one we're
-         * looking for. */
-        pdp_active = (MM3gppPdpContextActive *)(l->data);
-        if (pdp_active->cid == self->priv->cid) {
-            status = (pdp_active->active ? MM_BEARER_CONNECTION_STATUS_CONNECTED : MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
-            break;
-        }
-    }
-    mm_3gpp_pdp_context_active_list_free (pdp_active_list);
-
-    /* PDP context not found? This shouldn't happen, error out */
+    status = mm_broadband_modem_load_pdp_context_status_finish (modem, res, &error);
     if (status == MM_BEARER_CONNECTION_STATUS_UNKNOWN)
-        g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
-                                 "PDP context not found in the known contexts list");
+        g_task_return_error (task, error);
     else
         g_task_return_int (task, (gssize) status);
     g_object_unref (task);
@@ -1943,9 +2157,8 @@ load_connection_status (MMBaseBearer        *self,
                         GAsyncReadyCallback  callback,
                         gpointer             user_data)
 {
-    GTask          *task;
-    MMBaseModem    *modem = NULL;
-    MMPortSerialAt *port;
+    GTask       *task;
+    MMBaseModem *modem = NULL;
 
     task = g_task_new (self, NULL, callback, user_data);
 
@@ -1969,24 +2182,11 @@ load_connection_status (MMBaseBearer        *self,
         goto out;
     }
 
-    /* If no control port available, error out */
-    port = mm_base_modem_peek_best_at_port (modem, NULL);
-    if (!port) {
-        g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
-                                 "Couldn't load connection status: no control port available");
-        g_object_unref (task);
-        goto out;
-    }
-
-    mm_base_modem_at_command_full (MM_BASE_MODEM (modem),
-                                   port,
-                                   "+CGACT?",
-                                   3,
-                                   FALSE, /* allow cached */
-                                   FALSE, /* raw */
-                                   NULL, /* cancellable */
-                                   (GAsyncReadyCallback) cgact_periodic_query_ready,
-                                   task);
+    /* The +CGACT? query is shared with all the other bearers of the modem */
+    mm_broadband_modem_load_pdp_context_status (MM_BROADBAND_MODEM (modem),
+                                                MM_BROADBAND_BEARER (self)->priv->cid,
+                                                (GAsyncReadyCallback) pdp_context_status_ready,
+                                                task);
 
 out:
     g_clear_object (&modem);
@@ -2139,6 +2339,7 @@ interface_initialization_step (GTask *task)
                                            3,
                                            TRUE, /* getting range, so reply can be cached */
                                            FALSE, /* raw */
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                            NULL, /* cancellable */
                                            (GAsyncReadyCallback)crm_range_ready,
                                            task);
@@ -153,4 +153,44 @@ MMBaseBearer *mm_broadband_bearer_new_finish (GAsyncResult *res,
 
 guint        mm_broadband_bearer_get_3gpp_cid (MMBroadbandBearer *self);
 
+/* Polling of the connection status while a connection attempt is ongoing.
+ * Checks run with a delay that starts at @initial_delay_ms and doubles up to
+ * @max_delay_ms, until one of them reports the connection as established or
+ * failed, or until @timeout_ms expire. */
+typedef enum {
+    MM_BROADBAND_BEARER_POLL_CONTINUE,
+    MM_BROADBAND_BEARER_POLL_DONE,
+    MM_BROADBAND_BEARER_POLL_FAILED,
+} MMBroadbandBearerPollResult;
+
+typedef void                        (* MMBroadbandBearerPollCheckFn)       (MMBroadbandBearer    *self,
+                                                                            gpointer              check_data,
+                                                                            GAsyncReadyCallback   callback,
+                                                                            gpointer              user_data);
+/* An error given along with MM_BROADBAND_BEARER_POLL_CONTINUE is returned if
+ * the poll times out; it is mandatory with MM_BROADBAND_BEARER_POLL_FAILED */
+typedef MMBroadbandBearerPollResult (* MMBroadbandBearerPollCheckFinishFn) (MMBroadbandBearer    *self,
+                                                                            gpointer              check_data,
+                                                                            GAsyncResult         *res,
+                                                                            GError              **error);
+
+void     mm_broadband_bearer_connect_poll        (MMBroadbandBearer                   *self,
+                                                  guint                                initial_delay_ms,
+                                                  guint                                max_delay_ms,
+                                                  guint                                timeout_ms,
+                                                  MMBroadbandBearerPollCheckFn         check,
+                                                  MMBroadbandBearerPollCheckFinishFn   check_finish,
+                                                  gpointer                             check_data,
+                                                  GCancellable                        *cancellable,
+                                                  GAsyncReadyCallback                  callback,
+                                                  gpointer                             user_data);
+gboolean mm_broadband_bearer_connect_poll_finish (MMBroadbandBearer                   *self,
+                                                  GAsyncResult                        *res,
+                                                  GError                             **error);
+
+/* Completes the ongoing poll right away, e.g. when an unsolicited message
+ * reports the connection result; %NULL @error means connected */
+void     mm_broadband_bearer_connect_poll_report (MMBroadbandBearer                   *self,
+                                                  const GError                        *error);
+
 #endif /* MM_BROADBAND_BEARER_H */
@@ -36,6 +36,7 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
 #include "mm-iface-modem-3gpp-ussd.h"
+#include "mm-ussd-codec.h"
 #include "mm-iface-modem-location.h"
 #include "mm-iface-modem-messaging.h"
 #include "mm-iface-modem-signal.h"
@@ -4375,34 +4376,17 @@ ussd_encode (const gchar  *command,
              guint32      *scheme,
              GError      **error)
 {
-    GByteArray *array;
+    GByteArray     *array;
+    MMUssdEncoding  encoding;
 
-    if (mm_charset_can_convert_to (command, MM_MODEM_CHARSET_GSM)) {
-        guint8  *gsm;
-        guint8  *packed;
-        guint32  len = 0;
-        guint32  packed_len = 0;
+    encoding = mm_ussd_encoding_for_utf8 (command);
+    *scheme = mm_ussd_encoding_to_dcs (encoding);
 
-        *scheme = MM_MODEM_GSM_USSD_SCHEME_7BIT;
-        gsm = mm_charset_utf8_to_unpacked_gsm (command, &len);
-        if (!gsm) {
-            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
-                         "Failed to encode USSD command in GSM7 charset");
-            return NULL;
-        }
-        packed = mm_charset_gsm_pack (gsm, len, 0, &packed_len);
-        g_free (gsm);
-
-        array = g_byte_array_new_take (packed, packed_len);
-    } else {
-        *scheme = MM_MODEM_GSM_USSD_SCHEME_UCS2;
-        array = g_byte_array_sized_new (strlen (command) * 2);
-        if (!mm_modem_charset_byte_array_append (array, command, FALSE, MM_MODEM_CHARSET_UCS2)) {
-            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
-                         "Failed to encode USSD command in UCS2 charset");
-            g_byte_array_unref (array);
-            return NULL;
-        }
+    array = g_byte_array_sized_new (strlen (command) * 2);
+    if (!mm_ussd_encode (encoding, command, array, error)) {
+        g_prefix_error (error, "Failed to encode USSD command: ");
+        g_byte_array_unref (array);
+        return NULL;
     }
 
     if (array->len > 160) {
@@ -4416,33 +4400,20 @@ ussd_encode (const gchar  *command,
 }
 
 static gchar *
-ussd_decode (guint32      scheme,
-             GByteArray  *data,
-             GError     **error)
-{
-    gchar *decoded = NULL;
-
-    if (scheme == MM_MODEM_GSM_USSD_SCHEME_7BIT) {
-        guint8  *unpacked;
-        guint32  unpacked_len;
-
-        unpacked = mm_charset_gsm_unpack ((const guint8 *)data->data, (data->len * 8) / 7, 0, &unpacked_len);
-        decoded = (gchar *) mm_charset_gsm_unpacked_to_utf8 (unpacked, unpacked_len);
-        if (!decoded)
-            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
-                         "Error decoding USSD command in 0x%04x scheme (GSM7 charset)",
-                         scheme);
-    } else if (scheme == MM_MODEM_GSM_USSD_SCHEME_UCS2) {
-        decoded = mm_modem_charset_byte_array_to_utf8 (data, MM_MODEM_CHARSET_UCS2);
-        if (!decoded)
-            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
-                         "Error decoding USSD command in 0x%04x scheme (UCS2 charset)",
-                         scheme);
-    } else
-        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
-                     "Failed to decode USSD command in unsupported 0x%04x scheme", scheme);
+ussd_decode (guint32        scheme,
+             const guint8  *data,
+             guint32        data_size,
+             GError       **error)
+{
+    GString *decoded;
 
-    return decoded;
+    decoded = g_string_sized_new (data_size * 2 + 1);
+    if (!mm_ussd_decode (mm_ussd_encoding_from_dcs (scheme), data, data_size, decoded, error)) {
+        g_prefix_error (error, "Error decoding USSD command in 0x%04x scheme: ", scheme);
+        g_string_free (decoded, TRUE);
+        return NULL;
+    }
+    return g_string_free (decoded, FALSE);
 }
 
 /*****************************************************************************/
@@ -4458,7 +4429,6 @@ process_ussd_message (MMBroadbandModemMbim *self,
 {
     GTask                       *task = NULL;
     MMModem3gppUssdSessionState  ussd_state = MM_MODEM_3GPP_USSD_SESSION_STATE_IDLE;
-    GByteArray                  *bytearray = NULL;
     gchar                       *converted = NULL;
     GError                      *error = NULL;
 
@@ -4468,13 +4438,10 @@ process_ussd_message (MMBroadbandModemMbim *self,
         self->priv->pending_ussd_action = NULL;
     }
 
-    if (data_size)
-        bytearray = g_byte_array_append (g_byte_array_new (), data, data_size);
-
     switch (ussd_response) {
     case MBIM_USSD_RESPONSE_NO_ACTION_REQUIRED:
         /* no further action required */
-        converted = ussd_decode (scheme, bytearray, &error);
+        converted = ussd_decode (scheme, data, data_size, &error);
         if (!converted)
             break;
 
@@ -4491,7 +4458,7 @@ process_ussd_message (MMBroadbandModemMbim *self,
         /* further action required */
         ussd_state = MM_MODEM_3GPP_USSD_SESSION_STATE_USER_RESPONSE;
 
-        converted = ussd_decode (scheme, bytearray, &error);
+        converted = ussd_decode (scheme, data, data_size, &error);
         if (!converted)
             break;
         /* Response to the user's request? */
@@ -4526,9 +4493,6 @@ process_ussd_message (MMBroadbandModemMbim *self,
 
     mm_iface_modem_3gpp_ussd_update_state (MM_IFACE_MODEM_3GPP_USSD (self), ussd_state);
 
-    if (bytearray)
-        g_byte_array_unref (bytearray);
-
     /* Complete the pending action */
     if (task) {
         if (error)
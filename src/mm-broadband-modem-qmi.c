@@ -8508,6 +8508,12 @@ mm_broadband_modem_qmi_init (MMBroadbandModemQmi *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_BROADBAND_MODEM_QMI,
                                               MMBroadbandModemQmiPrivate);
+
+    /* The IMEI, ESN and MEID are only kept when loading the equipment
+     * identifier, so it can never be restored from the info cache */
+    g_object_set (self,
+                  MM_IFACE_MODEM_INFO_CACHE_ENABLED, FALSE,
+                  NULL);
 }
 
 static void
@@ -48,7 +48,10 @@
 #include "mm-call-list.h"
 #include "mm-base-sim.h"
 #include "mm-log.h"
+#include "mm-trace.h"
+#include "mm-metrics.h"
 #include "mm-modem-helpers.h"
+#include "mm-ussd-codec.h"
 #include "mm-error-helpers.h"
 #include "mm-port-serial-qcdm.h"
 #include "libqcdm/src/errors.h"
@@ -114,11 +117,14 @@ enum {
     PROP_MODEM_MESSAGING_SMS_LIST,
     PROP_MODEM_MESSAGING_SMS_PDU_MODE,
     PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE,
+    PROP_MODEM_MESSAGING_SMS_SEND_INTERVAL,
     PROP_MODEM_VOICE_CALL_LIST,
     PROP_MODEM_SIMPLE_STATUS,
     PROP_MODEM_SIM_HOT_SWAP_SUPPORTED,
     PROP_MODEM_SIM_HOT_SWAP_CONFIGURED,
     PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED,
+    PROP_MODEM_INFO_CACHE_ENABLED,
+    PROP_MODEM_INFO_CACHE_SUPPORTED_ENABLED,
     PROP_FLOW_CONTROL,
     PROP_LAST
 };
@@ -139,6 +145,8 @@ struct _MMBroadbandModemPrivate {
     gboolean sim_hot_swap_supported;
     gboolean sim_hot_swap_configured;
     gboolean periodic_signal_check_disabled;
+    gboolean info_cache_enabled;
+    gboolean info_cache_supported_enabled;
 
     /*<--- Modem interface --->*/
     /* Properties */
@@ -160,7 +168,15 @@ struct _MMBroadbandModemPrivate {
     MM3gppCmerInd modem_cmer_ind;
     gboolean modem_cgerep_support_checked;
     gboolean modem_cgerep_supported;
+    gboolean modem_cgerep_primary_enabled;
+    gboolean modem_cgerep_secondary_enabled;
     MMFlowControl flow_control;
+    /* PDP context status shared by all bearers */
+    GList *pdp_status_list;
+    gint64 pdp_status_timestamp;
+    GList *pdp_status_pending;
+    MMMetric *metric_pdp_status_queries;
+    MMMetric *metric_pdp_status_queries_avoided;
 
     /*<--- Modem 3GPP interface --->*/
     /* Properties */
@@ -170,7 +186,6 @@ struct _MMBroadbandModemPrivate {
     gboolean modem_3gpp_ps_network_supported;
     gboolean modem_3gpp_eps_network_supported;
     /* Implementation helpers */
-    GPtrArray *modem_3gpp_registration_regex;
     MMModem3gppFacility modem_3gpp_ignored_facility_locks;
     MMBaseBearer *modem_3gpp_initial_eps_bearer;
 
@@ -180,6 +195,7 @@ struct _MMBroadbandModemPrivate {
     /* Implementation helpers */
     gboolean use_unencoded_ussd;
     GTask *pending_ussd_action;
+    MMUssdEncoding ussd_reply_encoding;
 
     /*<--- Modem CDMA interface --->*/
     /* Properties */
@@ -210,6 +226,7 @@ struct _MMBroadbandModemPrivate {
     MMSmsList *modem_messaging_sms_list;
     gboolean modem_messaging_sms_pdu_mode;
     MMSmsStorage modem_messaging_sms_default_storage;
+    guint modem_messaging_sms_send_interval;
     /* Implementation helpers */
     gboolean sms_supported_modes_checked;
     gboolean mem1_storage_locked;
@@ -1953,8 +1970,8 @@ signal_quality_csq_ready (MMBroadbandModem *self,
  * try the other command if the first one fails.
  */
 static const MMBaseModemAtCommand signal_quality_csq_sequence[] = {
-    { "+CSQ",  3, TRUE, response_processor_string_ignore_at_errors },
-    { "+CSQ?", 3, TRUE, response_processor_string_ignore_at_errors },
+    { "+CSQ",  3, TRUE, response_processor_string_ignore_at_errors, MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND },
+    { "+CSQ?", 3, TRUE, response_processor_string_ignore_at_errors, MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND },
     { NULL }
 };
 
@@ -2000,25 +2017,24 @@ normalize_ciev_cind_signal_quality (guint quality,
 }
 
 static void
-signal_quality_cind_ready (MMBroadbandModem *self,
-                           GAsyncResult *res,
+signal_quality_cind_ready (MMBaseModem *_self,
+                           const gchar *response,
+                           gsize response_len,
+                           const GError *command_error,
                            GTask *task)
 {
+    MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
     SignalQualityContext *ctx;
     GError *error = NULL;
-    const gchar *result;
     GByteArray *indicators;
     guint quality = 0;
 
     ctx = g_task_get_task_data (task);
 
-    result = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
-    if (error) {
-        g_clear_error (&error);
+    if (command_error)
         goto try_csq;
-    }
 
-    indicators = mm_3gpp_parse_cind_read_response (result, &error);
+    indicators = mm_3gpp_parse_cind_read_response (response, &error);
     if (!indicators) {
         mm_dbg ("(%s) Could not parse CIND signal quality results: %s",
                 mm_port_get_device (MM_PORT (ctx->at_port)),
@@ -2068,15 +2084,18 @@ signal_quality_cind (GTask *task)
     self = g_task_get_source_object (task);
     ctx = g_task_get_task_data (task);
 
-    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
-                                   MM_PORT_SERIAL_AT (ctx->at_port),
-                                   "+CIND?",
-                                   5,
-                                   FALSE,
-                                   FALSE, /* raw */
-                                   NULL, /* cancellable */
-                                   (GAsyncReadyCallback)signal_quality_cind_ready,
-                                   task);
+    /* Run on every signal quality poll, and the response is fully parsed in
+     * the callback, so there's no need to keep it */
+    mm_base_modem_at_command_borrowed_full (MM_BASE_MODEM (self),
+                                            MM_PORT_SERIAL_AT (ctx->at_port),
+                                            "+CIND?",
+                                            5,
+                                            FALSE,
+                                            FALSE, /* raw */
+                                            MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+                                            NULL, /* cancellable */
+                                            (MMBaseModemAtResponseFunc)signal_quality_cind_ready,
+                                            task);
 }
 
 static void
@@ -2193,8 +2212,11 @@ modem_load_signal_quality (MMIfaceModem *_self,
     task = g_task_new (self, NULL, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)signal_quality_context_free);
 
-    /* Check whether we can get a non-connected AT port */
-    ctx->at_port = (MMPortSerial *)mm_base_modem_get_best_at_port (MM_BASE_MODEM (self), &error);
+    /* Check whether we can get a non-connected AT port; signal quality
+     * polling may be scheduled in the secondary port if available */
+    ctx->at_port = (MMPortSerial *)mm_base_modem_get_scheduled_at_port (MM_BASE_MODEM (self),
+                                                                        MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+                                                                        &error);
     if (ctx->at_port) {
         if (self->priv->modem_cind_supported &&
             CIND_INDICATOR_IS_VALID (self->priv->modem_cind_indicator_signal_quality))
@@ -2846,6 +2868,8 @@ cgev_process_pdp (MMBroadbandModem *self,
     g_free (pdp_type);
 }
 
+static void pdp_status_invalidate (MMBroadbandModem *self);
+
 static void
 cgev_received (MMPortSerialAt   *port,
                GMatchInfo       *info,
@@ -2860,6 +2884,9 @@ cgev_received (MMPortSerialAt   *port,
 
     type = mm_3gpp_parse_cgev_indication_action (str);
 
+    /* Any context activation or deactivation makes the last +CGACT? result stale */
+    pdp_status_invalidate (self);
+
     switch (type) {
     case MM_3GPP_CGEV_NW_DETACH:
     case MM_3GPP_CGEV_ME_DETACH:
@@ -2929,6 +2956,222 @@ set_cgev_unsolicited_events_handlers (MMBroadbandModem *self,
     g_regex_unref (cgev_regex);
 }
 
+/*****************************************************************************/
+/* PDP context status, shared by all bearers */
+
+/* Just below the period of the bearer connection monitor, so that a single
+ * +CGACT? query per period is enough for all bearers */
+#define PDP_STATUS_MAX_AGE_SECS 4
+
+/* When deactivations are reported with +CGEV, active contexts are assumed to
+ * stay active until an indication arrives, but they are still verified once
+ * in a while in case an indication was lost or never sent by the modem */
+#define PDP_STATUS_MAX_AGE_REPORTED_SECS 60
+
+static void
+pdp_status_invalidate (MMBroadbandModem *self)
+{
+    mm_3gpp_pdp_context_active_list_free (self->priv->pdp_status_list);
+    self->priv->pdp_status_list = NULL;
+    self->priv->pdp_status_timestamp = 0;
+}
+
+static void
+pdp_status_metrics_setup (MMBroadbandModem *self)
+{
+    const gchar *device;
+
+    if (self->priv->metric_pdp_status_queries)
+        return;
+
+    device = mm_base_modem_get_device (MM_BASE_MODEM (self));
+    self->priv->metric_pdp_status_queries         = mm_metrics_get (MM_METRIC_TYPE_COUNTER, "mm_modem_pdp_status_queries_total",         device);
+    self->priv->metric_pdp_status_queries_avoided = mm_metrics_get (MM_METRIC_TYPE_COUNTER, "mm_modem_pdp_status_queries_avoided_total", device);
+}
+
+static gboolean
+pdp_status_cid_active (GList *pdp_active_list,
+                       guint  cid)
+{
+    GList *l;
+
+    for (l = pdp_active_list; l; l = g_list_next (l)) {
+        MM3gppPdpContextActive *pdp_active;
+
+        pdp_active = (MM3gppPdpContextActive *)(l->data);
+        if (pdp_active->cid == cid)
+            return pdp_active->active;
+    }
+    return FALSE;
+}
+
+/* +CGEV deactivations are reported right away, unless the port where they're
+ * enabled is in data mode */
+static gboolean
+pdp_status_reported (MMBroadbandModem *self)
+{
+    MMPortSerialAt *port;
+
+    if (self->priv->modem_cgerep_primary_enabled) {
+        port = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+        if (port && !mm_port_get_connected (MM_PORT (port)))
+            return TRUE;
+    }
+
+    if (self->priv->modem_cgerep_secondary_enabled) {
+        port = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+        if (port && !mm_port_get_connected (MM_PORT (port)))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+MMBearerConnectionStatus
+mm_broadband_modem_load_pdp_context_status_finish (MMBroadbandModem  *self,
+                                                   GAsyncResult      *res,
+                                                   GError           **error)
+{
+    GError *inner_error = NULL;
+    gssize value;
+
+    value = g_task_propagate_int (G_TASK (res), &inner_error);
+    if (inner_error) {
+        g_propagate_error (error, inner_error);
+        return MM_BEARER_CONNECTION_STATUS_UNKNOWN;
+    }
+    return (MMBearerConnectionStatus)value;
+}
+
+static void
+pdp_status_complete (GTask        *task,
+                     GList        *pdp_active_list,
+                     const GError *error)
+{
+    GList *l;
+    guint  cid;
+
+    if (error) {
+        g_task_return_error (task, g_error_copy (error));
+        g_object_unref (task);
+        return;
+    }
+
+    cid = GPOINTER_TO_UINT (g_task_get_task_data (task));
+    for (l = pdp_active_list; l; l = g_list_next (l)) {
+        MM3gppPdpContextActive *pdp_active;
+
+        pdp_active = (MM3gppPdpContextActive *)(l->data);
+        if (pdp_active->cid == cid) {
+            g_task_return_int (task, (gssize) (pdp_active->active ?
+                                               MM_BEARER_CONNECTION_STATUS_CONNECTED :
+                                               MM_BEARER_CONNECTION_STATUS_DISCONNECTED));
+            g_object_unref (task);
+            return;
+        }
+    }
+
+    /* PDP context not found? This shouldn't happen, error out */
+    g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                             "PDP context not found in the known contexts list");
+    g_object_unref (task);
+}
+
+static void
+pdp_status_query_ready (MMBaseModem  *_self,
+                        GAsyncResult *res)
+{
+    MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
+    const gchar      *response;
+    GError           *error = NULL;
+    GList            *pdp_active_list = NULL;
+    GList            *pending;
+    GList            *l;
+
+    response = mm_base_modem_at_command_finish (_self, res, &error);
+    if (response)
+        pdp_active_list = mm_3gpp_parse_cgact_read_response (response, &error);
+
+    pdp_status_invalidate (self);
+    if (error) {
+        g_assert (!pdp_active_list);
+        g_prefix_error (&error, "Couldn't check current list of active PDP contexts: ");
+    } else {
+        self->priv->pdp_status_list = pdp_active_list;
+        self->priv->pdp_status_timestamp = g_get_monotonic_time ();
+    }
+
+    mm_dbg ("PDP context status loaded (%" G_GINT64_FORMAT " queries sent, %" G_GINT64_FORMAT " avoided)",
+            mm_metric_get_value (self->priv->metric_pdp_status_queries),
+            mm_metric_get_value (self->priv->metric_pdp_status_queries_avoided));
+
+    /* Completing a task may trigger a new request */
+    pending = self->priv->pdp_status_pending;
+    self->priv->pdp_status_pending = NULL;
+    for (l = pending; l; l = g_list_next (l))
+        pdp_status_complete (G_TASK (l->data), pdp_active_list, error);
+    g_list_free (pending);
+
+    g_clear_error (&error);
+}
+
+void
+mm_broadband_modem_load_pdp_context_status (MMBroadbandModem    *self,
+                                            guint                cid,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+    GTask          *task;
+    MMPortSerialAt *port;
+    guint           max_age_secs;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, GUINT_TO_POINTER (cid), NULL);
+
+    pdp_status_metrics_setup (self);
+
+    /* Reuse the result of a recent query. Any +CGEV indication invalidates it,
+     * so if deactivations are being reported, contexts found active may be
+     * assumed to still be active for longer. */
+    max_age_secs = PDP_STATUS_MAX_AGE_SECS;
+    if (pdp_status_reported (self) && pdp_status_cid_active (self->priv->pdp_status_list, cid))
+        max_age_secs = PDP_STATUS_MAX_AGE_REPORTED_SECS;
+    if (self->priv->pdp_status_timestamp &&
+        (g_get_monotonic_time () - self->priv->pdp_status_timestamp) < (max_age_secs * G_USEC_PER_SEC)) {
+        mm_metric_inc (self->priv->metric_pdp_status_queries_avoided);
+        pdp_status_complete (task, self->priv->pdp_status_list, NULL);
+        return;
+    }
+
+    /* Wait for the ongoing query */
+    if (self->priv->pdp_status_pending) {
+        mm_metric_inc (self->priv->metric_pdp_status_queries_avoided);
+        self->priv->pdp_status_pending = g_list_append (self->priv->pdp_status_pending, task);
+        return;
+    }
+
+    port = mm_base_modem_peek_scheduled_at_port (MM_BASE_MODEM (self), MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND, NULL);
+    if (!port) {
+        g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                                 "Couldn't load connection status: no control port available");
+        g_object_unref (task);
+        return;
+    }
+
+    mm_metric_inc (self->priv->metric_pdp_status_queries);
+    self->priv->pdp_status_pending = g_list_append (NULL, task);
+    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                   port,
+                                   "+CGACT?",
+                                   3,
+                                   FALSE, /* allow cached */
+                                   FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback) pdp_status_query_ready,
+                                   NULL);
+}
+
 static void
 ciev_received (MMPortSerialAt *port,
                GMatchInfo *info,
@@ -3250,6 +3493,7 @@ typedef struct {
     gchar          *cgerep_command;
     gboolean        cgerep_primary_done;
     gboolean        cgerep_secondary_done;
+    MMPortSerialAt *cgerep_port;
 } UnsolicitedEventsContext;
 
 static void
@@ -3281,6 +3525,7 @@ unsolicited_events_setup_ready (MMBroadbandModem *self,
 {
     UnsolicitedEventsContext *ctx;
     GError                   *error = NULL;
+    gboolean                  ok = TRUE;
 
     ctx = g_task_get_task_data (task);
 
@@ -3288,7 +3533,17 @@ unsolicited_events_setup_ready (MMBroadbandModem *self,
         mm_dbg ("Couldn't %s event reporting: '%s'",
                 ctx->enable ? "enable" : "disable",
                 error->message);
-        g_error_free (error);
+        g_clear_error (&error);
+        ok = FALSE;
+    }
+
+    /* Keep track of the ports where +CGEV indications are enabled */
+    if (ctx->cgerep_port) {
+        if (ctx->cgerep_port == ctx->primary)
+            self->priv->modem_cgerep_primary_enabled = (ok && ctx->enable);
+        else
+            self->priv->modem_cgerep_secondary_enabled = (ok && ctx->enable);
+        ctx->cgerep_port = NULL;
     }
 
     /* Continue on next port/command */
@@ -3326,6 +3581,7 @@ run_unsolicited_events_setup (GTask *task)
         ctx->cgerep_primary_done = TRUE;
         command = ctx->cgerep_command;
         port = ctx->primary;
+        ctx->cgerep_port = port;
     }
     /* CGEREP on secondary port */
     else if (!ctx->cgerep_secondary_done && ctx->cgerep_command && ctx->secondary) {
@@ -3333,6 +3589,7 @@ run_unsolicited_events_setup (GTask *task)
         ctx->cgerep_secondary_done = TRUE;
         port = ctx->secondary;
         command = ctx->cgerep_command;
+        ctx->cgerep_port = port;
     }
 
     /* Enable unsolicited events in given port */
@@ -3343,6 +3600,7 @@ run_unsolicited_events_setup (GTask *task)
                                        3,
                                        FALSE,
                                        FALSE, /* raw */
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                        NULL, /* cancellable */
                                        (GAsyncReadyCallback)unsolicited_events_setup_ready,
                                        task);
@@ -4370,8 +4628,11 @@ registration_state_changed (MMPortSerialAt *port,
     gboolean cgreg = FALSE;
     gboolean cereg = FALSE;
     GError *error = NULL;
+    gint start = 0;
 
-    if (!mm_3gpp_parse_creg_response (match_info,
+    /* The report line is parsed in place, within the port buffer */
+    g_match_info_fetch_pos (match_info, 1, &start, NULL);
+    if (!mm_3gpp_parse_creg_response (g_match_info_get_string (match_info) + start,
                                       &state,
                                       &lac,
                                       &cell_id,
@@ -4422,32 +4683,29 @@ modem_3gpp_setup_unsolicited_registration_events (MMIfaceModem3gpp *self,
                                                   gpointer user_data)
 {
     MMPortSerialAt *ports[2];
-    GPtrArray *array;
+    GRegex *regex;
     guint i;
-    guint j;
     GTask *task;
 
     ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
 
     /* Set up CREG unsolicited message handlers in both ports */
-    array = mm_3gpp_creg_regex_get (FALSE);
+    regex = mm_3gpp_creg_unsolicited_regex_get ();
     for (i = 0; i < 2; i++) {
         if (!ports[i])
             continue;
 
         mm_dbg ("(%s) setting up 3GPP unsolicited registration messages handlers",
                 mm_port_get_device (MM_PORT (ports[i])));
-        for (j = 0; j < array->len; j++) {
-            mm_port_serial_at_add_unsolicited_msg_handler (
-                MM_PORT_SERIAL_AT (ports[i]),
-                (GRegex *) g_ptr_array_index (array, j),
-                (MMPortSerialAtUnsolicitedMsgFn)registration_state_changed,
-                self,
-                NULL);
-        }
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            MM_PORT_SERIAL_AT (ports[i]),
+            regex,
+            (MMPortSerialAtUnsolicitedMsgFn)registration_state_changed,
+            self,
+            NULL);
     }
-    mm_3gpp_creg_regex_destroy (array);
+    g_regex_unref (regex);
 
     task = g_task_new (self, NULL, callback, user_data);
     g_task_return_boolean (task, TRUE);
@@ -4471,16 +4729,15 @@ modem_3gpp_cleanup_unsolicited_registration_events (MMIfaceModem3gpp *self,
                                                     gpointer user_data)
 {
     MMPortSerialAt *ports[2];
-    GPtrArray *array;
+    GRegex *regex;
     guint i;
-    guint j;
     GTask *task;
 
     ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
 
     /* Set up CREG unsolicited message handlers in both ports */
-    array = mm_3gpp_creg_regex_get (FALSE);
+    regex = mm_3gpp_creg_unsolicited_regex_get ();
     for (i = 0; i < 2; i++) {
         if (!ports[i])
             continue;
@@ -4488,16 +4745,14 @@ modem_3gpp_cleanup_unsolicited_registration_events (MMIfaceModem3gpp *self,
         mm_dbg ("(%s) cleaning up unsolicited registration messages handlers",
                 mm_port_get_device (MM_PORT (ports[i])));
 
-        for (j = 0; j < array->len; j++) {
-            mm_port_serial_at_add_unsolicited_msg_handler (
-                MM_PORT_SERIAL_AT (ports[i]),
-                (GRegex *) g_ptr_array_index (array, j),
-                NULL,
-                NULL,
-                NULL);
-        }
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            MM_PORT_SERIAL_AT (ports[i]),
+            regex,
+            NULL,
+            NULL,
+            NULL);
     }
-    mm_3gpp_creg_regex_destroy (array);
+    g_regex_unref (regex);
 
     task = g_task_new (self, NULL, callback, user_data);
     g_task_return_boolean (task, TRUE);
@@ -4572,6 +4827,7 @@ modem_3gpp_register_in_network (MMIfaceModem3gpp *self,
                                    120,
                                    FALSE,
                                    FALSE, /* raw */
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    cancellable,
                                    callback,
                                    user_data);
@@ -4626,8 +4882,6 @@ registration_status_check_ready (MMBroadbandModem *self,
     RunRegistrationChecksContext *ctx;
     const gchar *response;
     GError *error = NULL;
-    GMatchInfo *match_info = NULL;
-    guint i;
     gboolean parsed;
     gboolean cgreg;
     gboolean cereg;
@@ -4667,36 +4921,6 @@ registration_status_check_ready (MMBroadbandModem *self,
         return;
     }
 
-    /* Try to match the response */
-    for (i = 0;
-         i < self->priv->modem_3gpp_registration_regex->len;
-         i++) {
-        if (g_regex_match ((GRegex *)g_ptr_array_index (
-                               self->priv->modem_3gpp_registration_regex, i),
-                           response,
-                           0,
-                           &match_info))
-            break;
-        g_match_info_free (match_info);
-        match_info = NULL;
-    }
-
-    if (!match_info) {
-        error = g_error_new (MM_CORE_ERROR,
-                             MM_CORE_ERROR_FAILED,
-                             "Unknown registration status response: '%s'",
-                             response);
-        if (ctx->running_cs)
-            ctx->cs_error = error;
-        else if (ctx->running_ps)
-            ctx->ps_error = error;
-        else
-            ctx->eps_error = error;
-
-        run_registration_checks_context_step (task);
-        return;
-    }
-
     cgreg = FALSE;
     cereg = FALSE;
     state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
@@ -4704,7 +4928,7 @@ registration_status_check_ready (MMBroadbandModem *self,
     tac = 0;
     lac = 0;
     cid = 0;
-    parsed = mm_3gpp_parse_creg_response (match_info,
+    parsed = mm_3gpp_parse_creg_response (response,
                                           &state,
                                           &lac,
                                           &cid,
@@ -4712,7 +4936,6 @@ registration_status_check_ready (MMBroadbandModem *self,
                                           &cgreg,
                                           &cereg,
                                           &error);
-    g_match_info_free (match_info);
 
     if (!parsed) {
         if (!error)
@@ -5111,6 +5334,7 @@ unsolicited_registration_events_sequence_ready (MMBroadbandModem *self,
                 3,
                 FALSE,
                 FALSE, /* raw */
+                MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                 NULL, /* cancellable */
                 (GAsyncReadyCallback)unsolicited_registration_events_sequence_ready,
                 task);
@@ -5544,6 +5768,29 @@ modem_3gpp_ussd_encode (MMIfaceModem3gppUssd *self,
     GByteArray *ussd_command;
     gchar *hex = NULL;
 
+    /* The scheme value does NOT represent the encoding used to encode the string
+     * we're giving. This scheme reflects the encoding that the modem should use when
+     * sending the data out to the network. We're hardcoding this to GSM-7 because
+     * USSD commands fit well in GSM-7, unlike USSD responses that may contain code
+     * points that may only be encoded in UCS-2. */
+    *scheme = MM_MODEM_GSM_USSD_SCHEME_7BIT;
+
+    /* UCS2 and GSM are encoded straight to hex */
+    if (broadband->priv->modem_current_charset == MM_MODEM_CHARSET_UCS2 ||
+        broadband->priv->modem_current_charset == MM_MODEM_CHARSET_GSM) {
+        MMUssdEncoding encoding;
+        GString *encoded;
+
+        encoding = (broadband->priv->modem_current_charset == MM_MODEM_CHARSET_UCS2 ?
+                    MM_USSD_ENCODING_UCS2 : MM_USSD_ENCODING_GSM7_UNPACKED);
+        encoded = g_string_sized_new (strlen (command) * 4 + 1);
+        if (!mm_ussd_encode_hex (encoding, command, encoded, error)) {
+            g_string_free (encoded, TRUE);
+            return NULL;
+        }
+        return g_string_free (encoded, FALSE);
+    }
+
     ussd_command = g_byte_array_new ();
 
     /* Encode to the current charset (as per AT+CSCS, which is what most modems
@@ -5552,12 +5799,6 @@ modem_3gpp_ussd_encode (MMIfaceModem3gppUssd *self,
                                             command,
                                             FALSE,
                                             broadband->priv->modem_current_charset)) {
-        /* The scheme value does NOT represent the encoding used to encode the string
-         * we're giving. This scheme reflects the encoding that the modem should use when
-         * sending the data out to the network. We're hardcoding this to GSM-7 because
-         * USSD commands fit well in GSM-7, unlike USSD responses that may contain code
-         * points that may only be encoded in UCS-2. */
-        *scheme = MM_MODEM_GSM_USSD_SCHEME_7BIT;
         /* convert to hex representation */
         hex = mm_utils_bin2hexstr (ussd_command->data, ussd_command->len);
     }
@@ -5573,10 +5814,27 @@ modem_3gpp_ussd_decode (MMIfaceModem3gppUssd *self,
                         GError **error)
 {
     MMBroadbandModem *broadband = MM_BROADBAND_MODEM (self);
+    MMUssdEncoding encoding;
+    GString *decoded;
+
+    /* UCS2 data from the network can't be converted to most charsets, so
+     * modems give it as it is */
+    if (broadband->priv->modem_current_charset == MM_MODEM_CHARSET_UCS2 ||
+        broadband->priv->ussd_reply_encoding == MM_USSD_ENCODING_UCS2)
+        encoding = MM_USSD_ENCODING_UCS2;
+    else if (broadband->priv->modem_current_charset == MM_MODEM_CHARSET_GSM)
+        encoding = MM_USSD_ENCODING_GSM7_UNPACKED;
+    else
+        /* Decode from current charset (as per AT+CSCS, which is what most modems
+         * (except for Huawei it seems) will ask for. */
+        return mm_modem_charset_hex_to_utf8 (reply, broadband->priv->modem_current_charset);
 
-    /* Decode from current charset (as per AT+CSCS, which is what most modems
-     * (except for Huawei it seems) will ask for. */
-    return mm_modem_charset_hex_to_utf8 (reply, broadband->priv->modem_current_charset);
+    decoded = g_string_sized_new (strlen (reply) + 1);
+    if (!mm_ussd_decode_hex (encoding, reply, strlen (reply), decoded, error)) {
+        g_string_free (decoded, TRUE);
+        return NULL;
+    }
+    return g_string_free (decoded, FALSE);
 }
 
 /*****************************************************************************/
@@ -5595,7 +5853,8 @@ decode_ussd_response (MMBroadbandModem *self,
                       const gchar *reply,
                       GError **error)
 {
-    gchar *p;
+    const gchar *p;
+    const gchar *end;
     gchar *str;
     gchar *decoded;
 
@@ -5613,25 +5872,31 @@ decode_ussd_response (MMBroadbandModem *self,
     /* Assume the string is the next field, and strip quotes. While doing this,
      * we also skip any other additional field we may have afterwards */
     if (p[1] == '"') {
-        str = g_strdup (&p[2]);
-        p = strchr (str, '"');
-        if (p)
-            *p = '\0';
+        p += 2;
+        end = strchr (p, '"');
     } else {
-        str = g_strdup (&p[1]);
-        p = strchr (str, ',');
-        if (p)
-            *p = '\0';
+        p += 1;
+        end = strchr (p, ',');
     }
+    if (!end)
+        end = p + strlen (p);
+    str = g_strndup (p, end - p);
 
     /* If reply doesn't seem to be hex; just return itself... */
     if (!mm_utils_ishexstr (str))
-        decoded = g_strdup (str);
-    else
-        decoded = mm_iface_modem_3gpp_ussd_decode (MM_IFACE_MODEM_3GPP_USSD (self), str, error);
+        return str;
 
-    g_free (str);
+    /* The data coding scheme is the field after the string. Each message of
+     * a session may use a different one, so it is given to the decoder just
+     * for this message */
+    if (*end == '"')
+        end++;
+    if (end[0] == ',' && isdigit (end[1]))
+        self->priv->ussd_reply_encoding = mm_ussd_encoding_from_dcs ((guint) strtoul (&end[1], NULL, 10));
 
+    decoded = mm_iface_modem_3gpp_ussd_decode (MM_IFACE_MODEM_3GPP_USSD (self), str, error);
+    self->priv->ussd_reply_encoding = MM_USSD_ENCODING_UNKNOWN;
+    g_free (str);
     return decoded;
 }
 
@@ -6552,7 +6817,7 @@ sms_part_ready (MMBroadbandModem *self,
         return;
     }
 
-    part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
+    part = mm_sms_part_3gpp_new_from_pdu_in_place (info->index, info->pdu, &error);
     if (part) {
         mm_dbg ("Correctly parsed PDU (%d)", ctx->idx);
         mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
@@ -6667,7 +6932,8 @@ cds_received (MMPortSerialAt *port,
     if (!pdu)
         return;
 
-    part = mm_sms_part_3gpp_new_from_pdu (SMS_PART_INVALID_INDEX, pdu, &error);
+    part = mm_sms_part_3gpp_new_from_pdu_in_place (SMS_PART_INVALID_INDEX, pdu, &error);
+    g_free (pdu);
     if (part) {
         mm_dbg ("Correctly parsed non-stored PDU");
         mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
@@ -7097,7 +7363,7 @@ sms_pdu_part_list_ready (MMBroadbandModem *self,
         MM3gppPduInfo *info = l->data;
         MMSmsPart *part;
 
-        part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
+        part = mm_sms_part_3gpp_new_from_pdu_in_place (info->index, info->pdu, &error);
         if (part) {
             mm_dbg ("Correctly parsed PDU (%d)", info->index);
             mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
@@ -9107,8 +9373,7 @@ setup_ports (MMBroadbandModem *self)
 {
     MMPortSerialAt *ports[2];
     GRegex *regex;
-    GPtrArray *array;
-    gint i, j;
+    gint i;
 
     ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
@@ -9126,20 +9391,18 @@ setup_ports (MMBroadbandModem *self)
     /* Cleanup all unsolicited message handlers in all AT ports */
 
     /* Set up CREG unsolicited message handlers, with NULL callbacks */
-    array = mm_3gpp_creg_regex_get (FALSE);
+    regex = mm_3gpp_creg_unsolicited_regex_get ();
     for (i = 0; i < 2; i++) {
         if (!ports[i])
             continue;
 
-        for (j = 0; j < array->len; j++) {
-            mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
-                                                           (GRegex *)g_ptr_array_index (array, j),
-                                                           NULL,
-                                                           NULL,
-                                                           NULL);
-        }
+        mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
+                                                       regex,
+                                                       NULL,
+                                                       NULL,
+                                                       NULL);
     }
-    mm_3gpp_creg_regex_destroy (array);
+    g_regex_unref (regex);
 
     /* Set up CIEV unsolicited message handler, with NULL callback */
     regex = mm_3gpp_ciev_regex_get ();
@@ -9280,12 +9543,12 @@ open_ports_initialization (MMBroadbandModem *self,
     mm_base_modem_at_command_full (MM_BASE_MODEM (self),
                                    ctx->primary,
                                    "E0", 3,
-                                   FALSE, FALSE, NULL, NULL, NULL);
+                                   FALSE, FALSE, MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, NULL, NULL, NULL);
     /* Try to get extended errors */
     mm_base_modem_at_command_full (MM_BASE_MODEM (self),
                                    ctx->primary,
                                    "+CMEE=1", 3,
-                                   FALSE, FALSE, NULL, NULL, NULL);
+                                   FALSE, FALSE, MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, NULL, NULL, NULL);
 
     return TRUE;
 }
@@ -9355,6 +9618,7 @@ enabling_modem_init (MMBroadbandModem *self,
                                    6,
                                    FALSE,
                                    FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                    NULL, /* cancellable */
                                    callback,
                                    user_data);
@@ -9623,6 +9887,295 @@ schedule_initial_registration_checks (MMBroadbandModem *self)
     g_idle_add ((GSourceFunc) schedule_initial_registration_checks_cb, g_object_ref (self));
 }
 
+/*****************************************************************************/
+/* Interface steps
+ *
+ * The per-interface steps of the initialization, enabling and disabling
+ * sequences are described as a dependency graph, where each step lists the
+ * interfaces that need to be processed before it. Steps whose dependencies
+ * are all processed may run at the same time if the modem is controlled
+ * through QMI or MBIM, where each interface talks to a different service.
+ * Steps which still use AT commands in those modems (e.g. USSD or voice in
+ * most plugins) are not really run concurrently, as their commands end up
+ * serialized in the command queue of the shared AT port. In AT-only modems
+ * all requests end up in the same command queue, so the steps are run one by
+ * one, in the order given in the table.
+ */
+
+typedef enum {
+    IFACE_MODEM,
+    IFACE_3GPP,
+    IFACE_3GPP_USSD,
+    IFACE_CDMA,
+    IFACE_LOCATION,
+    IFACE_MESSAGING,
+    IFACE_VOICE,
+    IFACE_TIME,
+    IFACE_SIGNAL,
+    IFACE_OMA,
+    IFACE_FIRMWARE,
+    IFACE_LAST
+} Iface;
+
+#define IFACE_MASK(iface) (1 << (iface))
+
+static const gchar *iface_names[IFACE_LAST] = {
+    [IFACE_MODEM]      = "Modem",
+    [IFACE_3GPP]       = "3GPP",
+    [IFACE_3GPP_USSD]  = "3GPP/USSD",
+    [IFACE_CDMA]       = "CDMA",
+    [IFACE_LOCATION]   = "Location",
+    [IFACE_MESSAGING]  = "Messaging",
+    [IFACE_VOICE]      = "Voice",
+    [IFACE_TIME]       = "Time",
+    [IFACE_SIGNAL]     = "Signal",
+    [IFACE_OMA]        = "OMA",
+    [IFACE_FIRMWARE]   = "Firmware",
+};
+
+typedef struct {
+    Iface iface;
+    guint depends;
+    gboolean fatal;
+    /* Returns FALSE if the interface is not available in the modem */
+    gboolean (* run)    (MMBroadbandModem *self,
+                         GCancellable *cancellable,
+                         GAsyncReadyCallback callback,
+                         gpointer user_data);
+    gboolean (* finish) (MMBroadbandModem *self,
+                         GAsyncResult *res,
+                         GError **error);
+    /* Initialization only */
+    void (* shutdown)           (MMBroadbandModem *self);
+    void (* bind_simple_status) (MMBroadbandModem *self,
+                                 MMSimpleStatus *status);
+} IfaceStep;
+
+#undef IFACE_STEP_FN
+#define IFACE_STEP_FN(NAME,OPERATION,TYPE,CONDITION,CALL)               \
+    static gboolean                                                     \
+    NAME##_##OPERATION##_step_run (MMBroadbandModem *self,              \
+                                   GCancellable *cancellable,           \
+                                   GAsyncReadyCallback callback,        \
+                                   gpointer user_data)                  \
+    {                                                                   \
+        if (!(CONDITION))                                               \
+            return FALSE;                                               \
+        CALL;                                                           \
+        return TRUE;                                                    \
+    }                                                                   \
+                                                                        \
+    static gboolean                                                     \
+    NAME##_##OPERATION##_step_finish (MMBroadbandModem *self,           \
+                                      GAsyncResult *res,                \
+                                      GError **error)                   \
+    {                                                                   \
+        return mm_##NAME##_##OPERATION##_finish (TYPE (self), res, error); \
+    }
+
+typedef struct _IfaceGraph IfaceGraph;
+
+struct _IfaceGraph {
+    MMBroadbandModem *self;
+    GTask *task;
+    const gchar *operation;
+    const IfaceStep *steps;
+    guint n_steps;
+    /* Called when each step finishes, and once all are done */
+    void (* step_done) (IfaceGraph *graph,
+                        const IfaceStep *step,
+                        const GError *error);
+    void (* done)      (GTask *task);
+
+    guint max_running;
+    guint n_running;
+    guint launched;
+    guint completed;
+    gboolean scheduling;
+    gboolean reschedule;
+    gboolean aborted;
+    GError *error;
+
+    gint64 start_time;
+    MMTraceSpan step_span[IFACE_LAST];
+};
+
+typedef struct {
+    IfaceGraph *graph;
+    const IfaceStep *step;
+} IfaceGraphRun;
+
+static void iface_graph_schedule (IfaceGraph *graph);
+
+static void
+iface_graph_init (IfaceGraph *graph,
+                  GTask *task,
+                  const gchar *operation,
+                  const IfaceStep *steps,
+                  guint n_steps,
+                  void (* step_done) (IfaceGraph *graph,
+                                      const IfaceStep *step,
+                                      const GError *error),
+                  void (* done) (GTask *task))
+{
+    memset (graph, 0, sizeof (IfaceGraph));
+    graph->self = g_task_get_source_object (task);
+    graph->task = task;
+    graph->operation = operation;
+    graph->steps = steps;
+    graph->n_steps = n_steps;
+    graph->step_done = step_done;
+    graph->done = done;
+    graph->start_time = g_get_monotonic_time ();
+
+    /* Only run steps concurrently when the control port is not a single
+     * command queue */
+    graph->max_running = 1;
+#if defined WITH_QMI
+    if (mm_base_modem_peek_port_qmi (MM_BASE_MODEM (graph->self)))
+        graph->max_running = n_steps;
+#endif
+#if defined WITH_MBIM
+    if (mm_base_modem_peek_port_mbim (MM_BASE_MODEM (graph->self)))
+        graph->max_running = n_steps;
+#endif
+}
+
+/* Steps not launched yet are never run */
+static void
+iface_graph_skip (IfaceGraph *graph,
+                  guint mask)
+{
+    mask &= ~graph->launched;
+    graph->launched |= mask;
+    graph->completed |= mask;
+}
+
+/* No new steps are launched; steps already running are waited for. The
+ * first error given is kept. */
+static void
+iface_graph_abort (IfaceGraph *graph,
+                   const GError *error)
+{
+    graph->aborted = TRUE;
+    if (error && !graph->error)
+        graph->error = g_error_copy (error);
+}
+
+static void
+iface_graph_step_ready (MMBroadbandModem *self,
+                        GAsyncResult *res,
+                        IfaceGraphRun *run)
+{
+    IfaceGraph *graph;
+    const IfaceStep *step;
+    GError *error = NULL;
+
+    graph = run->graph;
+    step = run->step;
+    g_slice_free (IfaceGraphRun, run);
+
+    if (!step->finish (self, res, &error) && !error)
+        error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Unknown error");
+
+    mm_dbg ("%s interface %s finished in %.3lfs",
+            iface_names[step->iface],
+            graph->operation,
+            (gdouble) (g_get_monotonic_time () - graph->step_span[step->iface].start) / G_USEC_PER_SEC);
+    mm_trace_span_end (&graph->step_span[step->iface], error);
+
+    graph->n_running--;
+    graph->completed |= IFACE_MASK (step->iface);
+    graph->step_done (graph, step, error);
+    g_clear_error (&error);
+
+    iface_graph_schedule (graph);
+}
+
+static void
+iface_graph_schedule (IfaceGraph *graph)
+{
+    guint i;
+
+    /* Steps completing right away are processed in the loop below */
+    if (graph->scheduling) {
+        graph->reschedule = TRUE;
+        return;
+    }
+    graph->scheduling = TRUE;
+
+    if (g_cancellable_is_cancelled (g_task_get_cancellable (graph->task)))
+        graph->aborted = TRUE;
+
+restart:
+    graph->reschedule = FALSE;
+    for (i = 0; !graph->aborted && i < graph->n_steps && graph->n_running < graph->max_running; i++) {
+        const IfaceStep *step = &graph->steps[i];
+        IfaceGraphRun *run;
+
+        if ((graph->launched & IFACE_MASK (step->iface)) ||
+            ((graph->completed & step->depends) != step->depends))
+            continue;
+
+        graph->launched |= IFACE_MASK (step->iface);
+        mm_trace_span_begin (&graph->step_span[step->iface],
+                             mm_base_modem_get_device (MM_BASE_MODEM (graph->self)),
+                             graph->operation,
+                             iface_names[step->iface]);
+        graph->n_running++;
+
+        run = g_slice_new (IfaceGraphRun);
+        run->graph = graph;
+        run->step = step;
+        if (!step->run (graph->self,
+                        g_task_get_cancellable (graph->task),
+                        (GAsyncReadyCallback) iface_graph_step_ready,
+                        run)) {
+            /* Not available; other steps depending on this one may now run,
+             * so start over */
+            graph->step_span[step->iface].name = NULL;
+            g_slice_free (IfaceGraphRun, run);
+            graph->n_running--;
+            graph->completed |= IFACE_MASK (step->iface);
+            goto restart;
+        }
+        mm_dbg ("%s interface %s started", iface_names[step->iface], graph->operation);
+    }
+
+    if (graph->reschedule)
+        goto restart;
+    graph->scheduling = FALSE;
+
+    /* As long as a step is running, more steps may become ready. If none is
+     * running, all steps that could run have finished. */
+    if (graph->n_running > 0)
+        return;
+
+    mm_dbg ("Interface %s finished in %.3lfs%s",
+            graph->operation,
+            (gdouble) (g_get_monotonic_time () - graph->start_time) / G_USEC_PER_SEC,
+            graph->aborted ? " (aborted)" : "");
+    graph->done (graph->task);
+}
+
+/* Errors in fatal steps abort the whole sequence */
+static void
+iface_graph_step_done_default (IfaceGraph *graph,
+                               const IfaceStep *step,
+                               const GError *error)
+{
+    if (!error)
+        return;
+
+    if (step->fatal) {
+        iface_graph_abort (graph, error);
+        return;
+    }
+
+    mm_dbg ("Couldn't run %s interface %s: '%s'",
+            iface_names[step->iface], graph->operation, error->message);
+}
+
 /*****************************************************************************/
 
 typedef enum {
@@ -9630,18 +10183,7 @@ typedef enum {
     DISABLING_STEP_WAIT_FOR_FINAL_STATE,
     DISABLING_STEP_DISCONNECT_BEARERS,
     DISABLING_STEP_IFACE_SIMPLE,
-    DISABLING_STEP_IFACE_FIRMWARE,
-    DISABLING_STEP_IFACE_SIGNAL,
-    DISABLING_STEP_IFACE_OMA,
-    DISABLING_STEP_IFACE_TIME,
-    DISABLING_STEP_IFACE_MESSAGING,
-    DISABLING_STEP_IFACE_VOICE,
-    DISABLING_STEP_IFACE_LOCATION,
-    DISABLING_STEP_IFACE_CONTACTS,
-    DISABLING_STEP_IFACE_CDMA,
-    DISABLING_STEP_IFACE_3GPP_USSD,
-    DISABLING_STEP_IFACE_3GPP,
-    DISABLING_STEP_IFACE_MODEM,
+    DISABLING_STEP_IFACES,
     DISABLING_STEP_LAST,
 } DisablingStep;
 
@@ -9650,6 +10192,8 @@ typedef struct {
     DisablingStep step;
     MMModemState previous_state;
     gboolean disabled;
+    IfaceGraph graph;
+    MMTraceSequence trace;
 } DisablingContext;
 
 static void disabling_step (GTask *task);
@@ -9676,6 +10220,8 @@ disabling_context_free (DisablingContext *ctx)
                                      MM_MODEM_STATE_CHANGE_REASON_UNKNOWN);
     }
 
+    mm_trace_sequence_clear (&ctx->trace);
+    g_clear_error (&ctx->graph.error);
     g_object_unref (ctx->self);
     g_free (ctx);
 }
@@ -9688,47 +10234,87 @@ disable_finish (MMBaseModem *self,
     return g_task_propagate_boolean (G_TASK (res), error);
 }
 
-#undef INTERFACE_DISABLE_READY_FN
-#define INTERFACE_DISABLE_READY_FN(NAME,TYPE,FATAL_ERRORS)              \
-    static void                                                         \
-    NAME##_disable_ready (MMBroadbandModem *self,                       \
-                          GAsyncResult *result,                         \
-                          GTask *task)                                  \
-    {                                                                   \
-        DisablingContext *ctx;                                          \
-        GError *error = NULL;                                           \
-                                                                        \
-        if (!mm_##NAME##_disable_finish (TYPE (self),                   \
-                                         result,                        \
-                                         &error)) {                     \
-            if (FATAL_ERRORS) {                                         \
-                g_task_return_error (task, error);                      \
-                g_object_unref (task);                                  \
-                return;                                                 \
-            }                                                           \
-                                                                        \
-            mm_dbg ("Couldn't disable interface: '%s'",                 \
-                    error->message);                                    \
-            g_error_free (error);                                       \
-            return;                                                     \
-        }                                                               \
-                                                                        \
-        /* Go on to next step */                                        \
-        ctx = g_task_get_task_data (task);                              \
-        ctx->step++;                                                    \
-        disabling_step (task);                                          \
-    }
+IFACE_STEP_FN (iface_modem, disable, MM_IFACE_MODEM,
+               self->priv->modem_dbus_skeleton,
+               mm_iface_modem_disable (MM_IFACE_MODEM (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_3gpp, disable, MM_IFACE_MODEM_3GPP,
+               self->priv->modem_3gpp_dbus_skeleton,
+               mm_iface_modem_3gpp_disable (MM_IFACE_MODEM_3GPP (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_3gpp_ussd, disable, MM_IFACE_MODEM_3GPP_USSD,
+               self->priv->modem_3gpp_ussd_dbus_skeleton,
+               mm_iface_modem_3gpp_ussd_disable (MM_IFACE_MODEM_3GPP_USSD (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_cdma, disable, MM_IFACE_MODEM_CDMA,
+               self->priv->modem_cdma_dbus_skeleton,
+               mm_iface_modem_cdma_disable (MM_IFACE_MODEM_CDMA (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_location, disable, MM_IFACE_MODEM_LOCATION,
+               self->priv->modem_location_dbus_skeleton,
+               mm_iface_modem_location_disable (MM_IFACE_MODEM_LOCATION (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_messaging, disable, MM_IFACE_MODEM_MESSAGING,
+               self->priv->modem_messaging_dbus_skeleton,
+               mm_iface_modem_messaging_disable (MM_IFACE_MODEM_MESSAGING (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_voice, disable, MM_IFACE_MODEM_VOICE,
+               self->priv->modem_voice_dbus_skeleton,
+               mm_iface_modem_voice_disable (MM_IFACE_MODEM_VOICE (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_time, disable, MM_IFACE_MODEM_TIME,
+               self->priv->modem_time_dbus_skeleton,
+               mm_iface_modem_time_disable (MM_IFACE_MODEM_TIME (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_signal, disable, MM_IFACE_MODEM_SIGNAL,
+               self->priv->modem_signal_dbus_skeleton,
+               mm_iface_modem_signal_disable (MM_IFACE_MODEM_SIGNAL (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_oma, disable, MM_IFACE_MODEM_OMA,
+               self->priv->modem_oma_dbus_skeleton,
+               mm_iface_modem_oma_disable (MM_IFACE_MODEM_OMA (self), callback, user_data))
+
+/* Interfaces are disabled in the reverse order of enabling */
+static const IfaceStep disabling_iface_steps[] = {
+    { IFACE_SIGNAL,    0, FALSE,
+      iface_modem_signal_disable_step_run,    iface_modem_signal_disable_step_finish },
+    { IFACE_OMA,       0, FALSE,
+      iface_modem_oma_disable_step_run,       iface_modem_oma_disable_step_finish },
+    { IFACE_TIME,      0, FALSE,
+      iface_modem_time_disable_step_run,      iface_modem_time_disable_step_finish },
+    { IFACE_MESSAGING, 0, FALSE,
+      iface_modem_messaging_disable_step_run, iface_modem_messaging_disable_step_finish },
+    { IFACE_VOICE,     0, FALSE,
+      iface_modem_voice_disable_step_run,     iface_modem_voice_disable_step_finish },
+    { IFACE_LOCATION,  0, FALSE,
+      iface_modem_location_disable_step_run,  iface_modem_location_disable_step_finish },
+    { IFACE_CDMA,
+      IFACE_MASK (IFACE_OMA) | IFACE_MASK (IFACE_TIME) | IFACE_MASK (IFACE_MESSAGING) | IFACE_MASK (IFACE_LOCATION),
+      TRUE,
+      iface_modem_cdma_disable_step_run,      iface_modem_cdma_disable_step_finish },
+    { IFACE_3GPP_USSD, 0, TRUE,
+      iface_modem_3gpp_ussd_disable_step_run, iface_modem_3gpp_ussd_disable_step_finish },
+    { IFACE_3GPP,
+      IFACE_MASK (IFACE_TIME) | IFACE_MASK (IFACE_MESSAGING) | IFACE_MASK (IFACE_VOICE) | IFACE_MASK (IFACE_LOCATION) | IFACE_MASK (IFACE_3GPP_USSD),
+      TRUE,
+      iface_modem_3gpp_disable_step_run,      iface_modem_3gpp_disable_step_finish },
+    { IFACE_MODEM,
+      IFACE_MASK (IFACE_SIGNAL) | IFACE_MASK (IFACE_OMA) | IFACE_MASK (IFACE_TIME) | IFACE_MASK (IFACE_MESSAGING) |
+      IFACE_MASK (IFACE_VOICE) | IFACE_MASK (IFACE_LOCATION) | IFACE_MASK (IFACE_CDMA) | IFACE_MASK (IFACE_3GPP),
+      TRUE,
+      iface_modem_disable_step_run,           iface_modem_disable_step_finish },
+};
 
-INTERFACE_DISABLE_READY_FN (iface_modem,           MM_IFACE_MODEM,           TRUE)
-INTERFACE_DISABLE_READY_FN (iface_modem_3gpp,      MM_IFACE_MODEM_3GPP,      TRUE)
-INTERFACE_DISABLE_READY_FN (iface_modem_3gpp_ussd, MM_IFACE_MODEM_3GPP_USSD, TRUE)
-INTERFACE_DISABLE_READY_FN (iface_modem_cdma,      MM_IFACE_MODEM_CDMA,      TRUE)
-INTERFACE_DISABLE_READY_FN (iface_modem_location,  MM_IFACE_MODEM_LOCATION,  FALSE)
-INTERFACE_DISABLE_READY_FN (iface_modem_messaging, MM_IFACE_MODEM_MESSAGING, FALSE)
-INTERFACE_DISABLE_READY_FN (iface_modem_voice,     MM_IFACE_MODEM_VOICE,     FALSE)
-INTERFACE_DISABLE_READY_FN (iface_modem_signal,    MM_IFACE_MODEM_SIGNAL,    FALSE)
-INTERFACE_DISABLE_READY_FN (iface_modem_time,      MM_IFACE_MODEM_TIME,      FALSE)
-INTERFACE_DISABLE_READY_FN (iface_modem_oma,       MM_IFACE_MODEM_OMA,       FALSE)
+static void
+disabling_ifaces_done (GTask *task)
+{
+    DisablingContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+
+    if (ctx->graph.error) {
+        mm_trace_sequence_complete (&ctx->trace, ctx->graph.error);
+        g_task_return_error (task, ctx->graph.error);
+        ctx->graph.error = NULL;
+        g_object_unref (task);
+        return;
+    }
+
+    /* Go on to next step */
+    ctx->step++;
+    disabling_step (task);
+}
 
 static void
 bearer_list_disconnect_all_bearers_ready (MMBearerList *list,
@@ -9762,6 +10348,7 @@ disabling_wait_for_final_state_ready (MMIfaceModem *self,
 
     ctx->previous_state = mm_iface_modem_wait_for_final_state_finish (self, res, &error);
     if (error) {
+        mm_trace_sequence_complete (&ctx->trace, error);
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
@@ -9776,6 +10363,7 @@ disabling_wait_for_final_state_ready (MMIfaceModem *self,
          * Note that we do consider here UNKNOWN and FAILED status on purpose,
          * as the MMManager will try to disable every modem before removing
          * it. */
+        mm_trace_sequence_complete (&ctx->trace, NULL);
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
         return;
@@ -9811,6 +10399,7 @@ disabling_step (GTask *task)
         ctx->step++;
 
     case DISABLING_STEP_WAIT_FOR_FINAL_STATE:
+        mm_trace_sequence_step (&ctx->trace, "wait-for-final-state");
         mm_iface_modem_wait_for_final_state (MM_IFACE_MODEM (ctx->self),
                                              MM_MODEM_STATE_UNKNOWN, /* just any */
                                              (GAsyncReadyCallback)disabling_wait_for_final_state_ready,
@@ -9818,6 +10407,7 @@ disabling_step (GTask *task)
         return;
 
     case DISABLING_STEP_DISCONNECT_BEARERS:
+        mm_trace_sequence_step (&ctx->trace, "disconnect-bearers");
         if (ctx->self->priv->modem_bearer_list) {
             mm_bearer_list_disconnect_all_bearers (
                 ctx->self->priv->modem_bearer_list,
@@ -9832,137 +10422,21 @@ disabling_step (GTask *task)
         /* Fall down to next step */
         ctx->step++;
 
-    case DISABLING_STEP_IFACE_FIRMWARE:
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_SIGNAL:
-        if (ctx->self->priv->modem_signal_dbus_skeleton) {
-            mm_dbg ("Modem has extended signal reporting capabilities, disabling the Signal interface...");
-            /* Disabling the Modem Signal interface */
-            mm_iface_modem_signal_disable (MM_IFACE_MODEM_SIGNAL (ctx->self),
-                                           (GAsyncReadyCallback)iface_modem_signal_disable_ready,
-                                           task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_OMA:
-        if (ctx->self->priv->modem_oma_dbus_skeleton) {
-            mm_dbg ("Modem has OMA capabilities, disabling the OMA interface...");
-            /* Disabling the Modem Oma interface */
-            mm_iface_modem_oma_disable (MM_IFACE_MODEM_OMA (ctx->self),
-                                        (GAsyncReadyCallback)iface_modem_oma_disable_ready,
-                                        task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_TIME:
-        if (ctx->self->priv->modem_time_dbus_skeleton) {
-            mm_dbg ("Modem has time capabilities, disabling the Time interface...");
-            /* Disabling the Modem Time interface */
-            mm_iface_modem_time_disable (MM_IFACE_MODEM_TIME (ctx->self),
-                                         (GAsyncReadyCallback)iface_modem_time_disable_ready,
-                                         task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_MESSAGING:
-        if (ctx->self->priv->modem_messaging_dbus_skeleton) {
-            mm_dbg ("Modem has messaging capabilities, disabling the Messaging interface...");
-            /* Disabling the Modem Messaging interface */
-            mm_iface_modem_messaging_disable (MM_IFACE_MODEM_MESSAGING (ctx->self),
-                                              (GAsyncReadyCallback)iface_modem_messaging_disable_ready,
-                                              task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_VOICE:
-        if (ctx->self->priv->modem_voice_dbus_skeleton) {
-            mm_dbg ("Modem has voice capabilities, disabling the Voice interface...");
-            /* Disabling the Modem Voice interface */
-            mm_iface_modem_voice_disable (MM_IFACE_MODEM_VOICE (ctx->self),
-                                          (GAsyncReadyCallback)iface_modem_voice_disable_ready,
-                                          task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_LOCATION:
-        if (ctx->self->priv->modem_location_dbus_skeleton) {
-            mm_dbg ("Modem has location capabilities, disabling the Location interface...");
-            /* Disabling the Modem Location interface */
-            mm_iface_modem_location_disable (MM_IFACE_MODEM_LOCATION (ctx->self),
-                                             (GAsyncReadyCallback)iface_modem_location_disable_ready,
-                                             task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_CONTACTS:
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_CDMA:
-        if (ctx->self->priv->modem_cdma_dbus_skeleton) {
-            mm_dbg ("Modem has CDMA capabilities, disabling the Modem CDMA interface...");
-            /* Disabling the Modem CDMA interface */
-            mm_iface_modem_cdma_disable (MM_IFACE_MODEM_CDMA (ctx->self),
-                                        (GAsyncReadyCallback)iface_modem_cdma_disable_ready,
-                                        task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_3GPP_USSD:
-        if (ctx->self->priv->modem_3gpp_ussd_dbus_skeleton) {
-            mm_dbg ("Modem has 3GPP/USSD capabilities, disabling the Modem 3GPP/USSD interface...");
-            /* Disabling the Modem 3GPP USSD interface */
-            mm_iface_modem_3gpp_ussd_disable (MM_IFACE_MODEM_3GPP_USSD (ctx->self),
-                                              (GAsyncReadyCallback)iface_modem_3gpp_ussd_disable_ready,
-                                              task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_3GPP:
-        if (ctx->self->priv->modem_3gpp_dbus_skeleton) {
-            mm_dbg ("Modem has 3GPP capabilities, disabling the Modem 3GPP interface...");
-            /* Disabling the Modem 3GPP interface */
-            mm_iface_modem_3gpp_disable (MM_IFACE_MODEM_3GPP (ctx->self),
-                                        (GAsyncReadyCallback)iface_modem_3gpp_disable_ready,
-                                        task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case DISABLING_STEP_IFACE_MODEM:
-        /* This skeleton may be NULL when mm_base_modem_disable() gets called at
-         * the same time as modem object disposal. */
-        if (ctx->self->priv->modem_dbus_skeleton) {
-            /* Disabling the Modem interface */
-            mm_iface_modem_disable (MM_IFACE_MODEM (ctx->self),
-                                    (GAsyncReadyCallback)iface_modem_disable_ready,
-                                    task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+    case DISABLING_STEP_IFACES:
+        mm_trace_sequence_step (&ctx->trace, "interfaces");
+        iface_graph_init (&ctx->graph,
+                          task,
+                          "disabling",
+                          disabling_iface_steps,
+                          G_N_ELEMENTS (disabling_iface_steps),
+                          iface_graph_step_done_default,
+                          disabling_ifaces_done);
+        iface_graph_schedule (&ctx->graph);
+        return;
 
     case DISABLING_STEP_LAST:
         ctx->disabled = TRUE;
+        mm_trace_sequence_complete (&ctx->trace, NULL);
         /* All disabled without errors! */
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
@@ -9984,6 +10458,7 @@ disable (MMBaseModem *self,
     ctx = g_new0 (DisablingContext, 1);
     ctx->self = g_object_ref (self);
     ctx->step = DISABLING_STEP_FIRST;
+    mm_trace_sequence_init (&ctx->trace, mm_base_modem_get_device (self), "disabling");
 
     task = g_task_new (self, cancellable, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)disabling_context_free);
@@ -9997,18 +10472,7 @@ typedef enum {
     ENABLING_STEP_FIRST,
     ENABLING_STEP_WAIT_FOR_FINAL_STATE,
     ENABLING_STEP_STARTED,
-    ENABLING_STEP_IFACE_MODEM,
-    ENABLING_STEP_IFACE_3GPP,
-    ENABLING_STEP_IFACE_3GPP_USSD,
-    ENABLING_STEP_IFACE_CDMA,
-    ENABLING_STEP_IFACE_CONTACTS,
-    ENABLING_STEP_IFACE_LOCATION,
-    ENABLING_STEP_IFACE_MESSAGING,
-    ENABLING_STEP_IFACE_VOICE,
-    ENABLING_STEP_IFACE_TIME,
-    ENABLING_STEP_IFACE_SIGNAL,
-    ENABLING_STEP_IFACE_OMA,
-    ENABLING_STEP_IFACE_FIRMWARE,
+    ENABLING_STEP_IFACES,
     ENABLING_STEP_IFACE_SIMPLE,
     ENABLING_STEP_LAST,
 } EnablingStep;
@@ -10018,6 +10482,8 @@ typedef struct {
     EnablingStep step;
     MMModemState previous_state;
     gboolean enabled;
+    IfaceGraph graph;
+    MMTraceSequence trace;
 } EnablingContext;
 
 static void enabling_step (GTask *task);
@@ -10036,6 +10502,8 @@ enabling_context_free (EnablingContext *ctx)
                                      MM_MODEM_STATE_CHANGE_REASON_UNKNOWN);
     }
 
+    mm_trace_sequence_clear (&ctx->trace);
+    g_clear_error (&ctx->graph.error);
     g_object_unref (ctx->self);
     g_free (ctx);
 }
@@ -10048,46 +10516,81 @@ enable_finish (MMBaseModem *self,
     return g_task_propagate_boolean (G_TASK (res), error);
 }
 
-#undef INTERFACE_ENABLE_READY_FN
-#define INTERFACE_ENABLE_READY_FN(NAME,TYPE,FATAL_ERRORS)               \
-    static void                                                         \
-    NAME##_enable_ready (MMBroadbandModem *self,                        \
-                         GAsyncResult *result,                          \
-                         GTask *task)                                   \
-    {                                                                   \
-        EnablingContext *ctx;                                           \
-        GError *error = NULL;                                           \
-                                                                        \
-        if (!mm_##NAME##_enable_finish (TYPE (self),                    \
-                                        result,                         \
-                                        &error)) {                      \
-            if (FATAL_ERRORS) {                                         \
-                g_task_return_error (task, error);                      \
-                g_object_unref (task);                                  \
-                return;                                                 \
-            }                                                           \
-                                                                        \
-            mm_dbg ("Couldn't enable interface: '%s'",                  \
-                    error->message);                                    \
-            g_error_free (error);                                       \
-        }                                                               \
-                                                                        \
-        /* Go on to next step */                                        \
-        ctx = g_task_get_task_data (task);                              \
-        ctx->step++;                                                    \
-        enabling_step (task);                                           \
+IFACE_STEP_FN (iface_modem, enable, MM_IFACE_MODEM,
+               TRUE,
+               mm_iface_modem_enable (MM_IFACE_MODEM (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_3gpp, enable, MM_IFACE_MODEM_3GPP,
+               self->priv->modem_3gpp_dbus_skeleton,
+               mm_iface_modem_3gpp_enable (MM_IFACE_MODEM_3GPP (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_3gpp_ussd, enable, MM_IFACE_MODEM_3GPP_USSD,
+               self->priv->modem_3gpp_ussd_dbus_skeleton,
+               mm_iface_modem_3gpp_ussd_enable (MM_IFACE_MODEM_3GPP_USSD (self), callback, user_data))
+IFACE_STEP_FN (iface_modem_cdma, enable, MM_IFACE_MODEM_CDMA,
+               self->priv->modem_cdma_dbus_skeleton,
+               mm_iface_modem_cdma_enable (MM_IFACE_MODEM_CDMA (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_location, enable, MM_IFACE_MODEM_LOCATION,
+               self->priv->modem_location_dbus_skeleton,
+               mm_iface_modem_location_enable (MM_IFACE_MODEM_LOCATION (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_messaging, enable, MM_IFACE_MODEM_MESSAGING,
+               self->priv->modem_messaging_dbus_skeleton,
+               mm_iface_modem_messaging_enable (MM_IFACE_MODEM_MESSAGING (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_voice, enable, MM_IFACE_MODEM_VOICE,
+               self->priv->modem_voice_dbus_skeleton,
+               mm_iface_modem_voice_enable (MM_IFACE_MODEM_VOICE (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_time, enable, MM_IFACE_MODEM_TIME,
+               self->priv->modem_time_dbus_skeleton,
+               mm_iface_modem_time_enable (MM_IFACE_MODEM_TIME (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_signal, enable, MM_IFACE_MODEM_SIGNAL,
+               self->priv->modem_signal_dbus_skeleton,
+               mm_iface_modem_signal_enable (MM_IFACE_MODEM_SIGNAL (self), cancellable, callback, user_data))
+IFACE_STEP_FN (iface_modem_oma, enable, MM_IFACE_MODEM_OMA,
+               self->priv->modem_oma_dbus_skeleton,
+               mm_iface_modem_oma_enable (MM_IFACE_MODEM_OMA (self), cancellable, callback, user_data))
+
+/* Location, messaging and time need the registration info from the 3GPP or
+ * CDMA interfaces */
+static const IfaceStep enabling_iface_steps[] = {
+    { IFACE_MODEM,     0, TRUE,
+      iface_modem_enable_step_run,           iface_modem_enable_step_finish },
+    { IFACE_3GPP,      IFACE_MASK (IFACE_MODEM), TRUE,
+      iface_modem_3gpp_enable_step_run,      iface_modem_3gpp_enable_step_finish },
+    { IFACE_3GPP_USSD, IFACE_MASK (IFACE_3GPP), TRUE,
+      iface_modem_3gpp_ussd_enable_step_run, iface_modem_3gpp_ussd_enable_step_finish },
+    { IFACE_CDMA,      IFACE_MASK (IFACE_MODEM), TRUE,
+      iface_modem_cdma_enable_step_run,      iface_modem_cdma_enable_step_finish },
+    { IFACE_LOCATION,  IFACE_MASK (IFACE_3GPP) | IFACE_MASK (IFACE_CDMA), FALSE,
+      iface_modem_location_enable_step_run,  iface_modem_location_enable_step_finish },
+    { IFACE_MESSAGING, IFACE_MASK (IFACE_3GPP) | IFACE_MASK (IFACE_CDMA), FALSE,
+      iface_modem_messaging_enable_step_run, iface_modem_messaging_enable_step_finish },
+    { IFACE_VOICE,     IFACE_MASK (IFACE_3GPP), FALSE,
+      iface_modem_voice_enable_step_run,     iface_modem_voice_enable_step_finish },
+    { IFACE_TIME,      IFACE_MASK (IFACE_3GPP) | IFACE_MASK (IFACE_CDMA), FALSE,
+      iface_modem_time_enable_step_run,      iface_modem_time_enable_step_finish },
+    { IFACE_SIGNAL,    IFACE_MASK (IFACE_MODEM), FALSE,
+      iface_modem_signal_enable_step_run,    iface_modem_signal_enable_step_finish },
+    { IFACE_OMA,       IFACE_MASK (IFACE_MODEM) | IFACE_MASK (IFACE_CDMA), FALSE,
+      iface_modem_oma_enable_step_run,       iface_modem_oma_enable_step_finish },
+};
+
+static void
+enabling_ifaces_done (GTask *task)
+{
+    EnablingContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+
+    if (ctx->graph.error) {
+        mm_trace_sequence_complete (&ctx->trace, ctx->graph.error);
+        g_task_return_error (task, ctx->graph.error);
+        ctx->graph.error = NULL;
+        g_object_unref (task);
+        return;
     }
 
-INTERFACE_ENABLE_READY_FN (iface_modem,           MM_IFACE_MODEM,           TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_3gpp,      MM_IFACE_MODEM_3GPP,      TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_3gpp_ussd, MM_IFACE_MODEM_3GPP_USSD, TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_cdma,      MM_IFACE_MODEM_CDMA,      TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_location,  MM_IFACE_MODEM_LOCATION,  FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_messaging, MM_IFACE_MODEM_MESSAGING, FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_voice,     MM_IFACE_MODEM_VOICE,     FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_signal,    MM_IFACE_MODEM_SIGNAL,    FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_time,      MM_IFACE_MODEM_TIME,      FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_oma,       MM_IFACE_MODEM_OMA,       FALSE)
+    /* Go on to next step */
+    ctx->step++;
+    enabling_step (task);
+}
 
 static void
 enabling_started_ready (MMBroadbandModem *self,
@@ -10121,6 +10624,7 @@ enabling_wait_for_final_state_ready (MMIfaceModem *self,
 
     ctx->previous_state = mm_iface_modem_wait_for_final_state_finish (self, res, &error);
     if (error) {
+        mm_trace_sequence_complete (&ctx->trace, error);
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
@@ -10128,6 +10632,7 @@ enabling_wait_for_final_state_ready (MMIfaceModem *self,
 
     if (ctx->previous_state >= MM_MODEM_STATE_ENABLED) {
         /* Just return success, don't relaunch enabling */
+        mm_trace_sequence_complete (&ctx->trace, NULL);
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
         return;
@@ -10162,6 +10667,7 @@ enabling_step (GTask *task)
         ctx->step++;
 
     case ENABLING_STEP_WAIT_FOR_FINAL_STATE:
+        mm_trace_sequence_step (&ctx->trace, "wait-for-final-state");
         mm_iface_modem_wait_for_final_state (MM_IFACE_MODEM (ctx->self),
                                              MM_MODEM_STATE_UNKNOWN, /* just any */
                                              (GAsyncReadyCallback)enabling_wait_for_final_state_ready,
@@ -10169,6 +10675,7 @@ enabling_step (GTask *task)
         return;
 
     case ENABLING_STEP_STARTED:
+        mm_trace_sequence_step (&ctx->trace, "started");
         if (MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->enabling_started &&
             MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->enabling_started_finish) {
             MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->enabling_started (ctx->self,
@@ -10179,137 +10686,18 @@ enabling_step (GTask *task)
         /* Fall down to next step */
         ctx->step++;
 
-    case ENABLING_STEP_IFACE_MODEM:
+    case ENABLING_STEP_IFACES:
+        mm_trace_sequence_step (&ctx->trace, "interfaces");
         g_assert (ctx->self->priv->modem_dbus_skeleton != NULL);
-        /* Enabling the Modem interface */
-        mm_iface_modem_enable (MM_IFACE_MODEM (ctx->self),
-                               g_task_get_cancellable (task),
-                               (GAsyncReadyCallback)iface_modem_enable_ready,
-                               task);
-        return;
-
-    case ENABLING_STEP_IFACE_3GPP:
-        if (ctx->self->priv->modem_3gpp_dbus_skeleton) {
-            mm_dbg ("Modem has 3GPP capabilities, enabling the Modem 3GPP interface...");
-            /* Enabling the Modem 3GPP interface */
-            mm_iface_modem_3gpp_enable (MM_IFACE_MODEM_3GPP (ctx->self),
-                                        g_task_get_cancellable (task),
-                                        (GAsyncReadyCallback)iface_modem_3gpp_enable_ready,
-                                        task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_3GPP_USSD:
-        if (ctx->self->priv->modem_3gpp_ussd_dbus_skeleton) {
-            mm_dbg ("Modem has 3GPP/USSD capabilities, enabling the Modem 3GPP/USSD interface...");
-            mm_iface_modem_3gpp_ussd_enable (MM_IFACE_MODEM_3GPP_USSD (ctx->self),
-                                             (GAsyncReadyCallback)iface_modem_3gpp_ussd_enable_ready,
-                                             task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_CDMA:
-        if (ctx->self->priv->modem_cdma_dbus_skeleton) {
-            mm_dbg ("Modem has CDMA capabilities, enabling the Modem CDMA interface...");
-            /* Enabling the Modem CDMA interface */
-            mm_iface_modem_cdma_enable (MM_IFACE_MODEM_CDMA (ctx->self),
-                                        g_task_get_cancellable (task),
-                                        (GAsyncReadyCallback)iface_modem_cdma_enable_ready,
-                                        task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_CONTACTS:
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_LOCATION:
-        if (ctx->self->priv->modem_location_dbus_skeleton) {
-            mm_dbg ("Modem has location capabilities, enabling the Location interface...");
-            /* Enabling the Modem Location interface */
-            mm_iface_modem_location_enable (MM_IFACE_MODEM_LOCATION (ctx->self),
-                                            g_task_get_cancellable (task),
-                                            (GAsyncReadyCallback)iface_modem_location_enable_ready,
-                                            task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_MESSAGING:
-        if (ctx->self->priv->modem_messaging_dbus_skeleton) {
-            mm_dbg ("Modem has messaging capabilities, enabling the Messaging interface...");
-            /* Enabling the Modem Messaging interface */
-            mm_iface_modem_messaging_enable (MM_IFACE_MODEM_MESSAGING (ctx->self),
-                                             g_task_get_cancellable (task),
-                                             (GAsyncReadyCallback)iface_modem_messaging_enable_ready,
-                                             task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_VOICE:
-        if (ctx->self->priv->modem_voice_dbus_skeleton) {
-            mm_dbg ("Modem has voice capabilities, enabling the Voice interface...");
-            /* Enabling the Modem Voice interface */
-            mm_iface_modem_voice_enable (MM_IFACE_MODEM_VOICE (ctx->self),
-                                         g_task_get_cancellable (task),
-                                         (GAsyncReadyCallback)iface_modem_voice_enable_ready,
-                                         task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_TIME:
-        if (ctx->self->priv->modem_time_dbus_skeleton) {
-            mm_dbg ("Modem has time capabilities, enabling the Time interface...");
-            /* Enabling the Modem Time interface */
-            mm_iface_modem_time_enable (MM_IFACE_MODEM_TIME (ctx->self),
-                                        g_task_get_cancellable (task),
-                                        (GAsyncReadyCallback)iface_modem_time_enable_ready,
-                                        task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_SIGNAL:
-        if (ctx->self->priv->modem_signal_dbus_skeleton) {
-            mm_dbg ("Modem has extended signal reporting capabilities, enabling the Signal interface...");
-            /* Enabling the Modem Signal interface */
-            mm_iface_modem_signal_enable (MM_IFACE_MODEM_SIGNAL (ctx->self),
-                                          g_task_get_cancellable (task),
-                                          (GAsyncReadyCallback)iface_modem_signal_enable_ready,
-                                          task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_OMA:
-        if (ctx->self->priv->modem_oma_dbus_skeleton) {
-            mm_dbg ("Modem has OMA capabilities, enabling the OMA interface...");
-            /* Enabling the Modem Oma interface */
-            mm_iface_modem_oma_enable (MM_IFACE_MODEM_OMA (ctx->self),
-                                       g_task_get_cancellable (task),
-                                       (GAsyncReadyCallback)iface_modem_oma_enable_ready,
-                                       task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_FIRMWARE:
-        /* Fall down to next step */
-        ctx->step++;
+        iface_graph_init (&ctx->graph,
+                          task,
+                          "enabling",
+                          enabling_iface_steps,
+                          G_N_ELEMENTS (enabling_iface_steps),
+                          iface_graph_step_done_default,
+                          enabling_ifaces_done);
+        iface_graph_schedule (&ctx->graph);
+        return;
 
     case ENABLING_STEP_IFACE_SIMPLE:
         /* Fall down to next step */
@@ -10327,6 +10715,8 @@ enabling_step (GTask *task)
          */
         schedule_initial_registration_checks (ctx->self);
 
+        mm_trace_sequence_complete (&ctx->trace, NULL);
+
         /* All enabled without errors! */
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
@@ -10375,6 +10765,7 @@ enable (MMBaseModem *self,
         ctx = g_new0 (EnablingContext, 1);
         ctx->self = g_object_ref (self);
         ctx->step = ENABLING_STEP_FIRST;
+        mm_trace_sequence_init (&ctx->trace, mm_base_modem_get_device (self), "enabling");
 
         g_task_set_task_data (task, ctx, (GDestroyNotify)enabling_context_free);
 
@@ -10407,18 +10798,7 @@ typedef enum {
     INITIALIZE_STEP_SETUP_PORTS,
     INITIALIZE_STEP_STARTED,
     INITIALIZE_STEP_SETUP_SIMPLE_STATUS,
-    INITIALIZE_STEP_IFACE_MODEM,
-    INITIALIZE_STEP_IFACE_3GPP,
-    INITIALIZE_STEP_IFACE_3GPP_USSD,
-    INITIALIZE_STEP_IFACE_CDMA,
-    INITIALIZE_STEP_IFACE_CONTACTS,
-    INITIALIZE_STEP_IFACE_LOCATION,
-    INITIALIZE_STEP_IFACE_MESSAGING,
-    INITIALIZE_STEP_IFACE_VOICE,
-    INITIALIZE_STEP_IFACE_TIME,
-    INITIALIZE_STEP_IFACE_SIGNAL,
-    INITIALIZE_STEP_IFACE_OMA,
-    INITIALIZE_STEP_IFACE_FIRMWARE,
+    INITIALIZE_STEP_IFACES,
     INITIALIZE_STEP_SIM_HOT_SWAP,
     INITIALIZE_STEP_IFACE_SIMPLE,
     INITIALIZE_STEP_LAST,
@@ -10428,6 +10808,8 @@ typedef struct {
     MMBroadbandModem *self;
     InitializeStep step;
     gpointer ports_ctx;
+    IfaceGraph graph;
+    MMTraceSequence trace;
 } InitializeContext;
 
 static void initialize_step (GTask *task);
@@ -10444,6 +10826,8 @@ initialize_context_free (InitializeContext *ctx)
         g_error_free (error);
     }
 
+    mm_trace_sequence_clear (&ctx->trace);
+    g_clear_error (&ctx->graph.error);
     g_object_unref (ctx->self);
     g_free (ctx);
 }
@@ -10490,19 +10874,88 @@ initialization_started_ready (MMBroadbandModem *self,
     initialize_step (task);
 }
 
+#define IFACE_INITIALIZE_FN(NAME,TYPE,CONDITION,CALL)                  \
+    IFACE_STEP_FN (NAME, initialize, TYPE, CONDITION, CALL)             \
+                                                                        \
+    static void                                                         \
+    NAME##_initialize_step_shutdown (MMBroadbandModem *self)            \
+    {                                                                   \
+        mm_##NAME##_shutdown (TYPE (self));                             \
+    }                                                                   \
+                                                                        \
+    static void                                                         \
+    NAME##_initialize_step_bind_simple_status (MMBroadbandModem *self,  \
+                                               MMSimpleStatus *status)  \
+    {                                                                   \
+        mm_##NAME##_bind_simple_status (TYPE (self), status);           \
+    }
+
+IFACE_INITIALIZE_FN (iface_modem, MM_IFACE_MODEM,
+                     TRUE,
+                     mm_iface_modem_initialize (MM_IFACE_MODEM (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_3gpp, MM_IFACE_MODEM_3GPP,
+                     mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self)),
+                     mm_iface_modem_3gpp_initialize (MM_IFACE_MODEM_3GPP (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_3gpp_ussd, MM_IFACE_MODEM_3GPP_USSD,
+                     mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self)),
+                     mm_iface_modem_3gpp_ussd_initialize (MM_IFACE_MODEM_3GPP_USSD (self), callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_cdma, MM_IFACE_MODEM_CDMA,
+                     mm_iface_modem_is_cdma (MM_IFACE_MODEM (self)),
+                     mm_iface_modem_cdma_initialize (MM_IFACE_MODEM_CDMA (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_location, MM_IFACE_MODEM_LOCATION,
+                     TRUE,
+                     mm_iface_modem_location_initialize (MM_IFACE_MODEM_LOCATION (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_messaging, MM_IFACE_MODEM_MESSAGING,
+                     TRUE,
+                     mm_iface_modem_messaging_initialize (MM_IFACE_MODEM_MESSAGING (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_voice, MM_IFACE_MODEM_VOICE,
+                     TRUE,
+                     mm_iface_modem_voice_initialize (MM_IFACE_MODEM_VOICE (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_time, MM_IFACE_MODEM_TIME,
+                     TRUE,
+                     mm_iface_modem_time_initialize (MM_IFACE_MODEM_TIME (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_signal, MM_IFACE_MODEM_SIGNAL,
+                     TRUE,
+                     mm_iface_modem_signal_initialize (MM_IFACE_MODEM_SIGNAL (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_oma, MM_IFACE_MODEM_OMA,
+                     TRUE,
+                     mm_iface_modem_oma_initialize (MM_IFACE_MODEM_OMA (self), cancellable, callback, user_data))
+IFACE_INITIALIZE_FN (iface_modem_firmware, MM_IFACE_MODEM_FIRMWARE,
+                     TRUE,
+                     mm_iface_modem_firmware_initialize (MM_IFACE_MODEM_FIRMWARE (self), cancellable, callback, user_data))
+
+#define IFACE_INITIALIZE_STEP(IFACE,NAME,DEPENDS,FATAL)                 \
+    { IFACE, DEPENDS, FATAL,                                            \
+      NAME##_initialize_step_run,                                       \
+      NAME##_initialize_step_finish,                                    \
+      NAME##_initialize_step_shutdown,                                  \
+      NAME##_initialize_step_bind_simple_status }
+
+/* Location and messaging check whether the modem is 3GPP or CDMA, and voice
+ * needs the 3GPP interface */
+static const IfaceStep initialize_iface_steps[] = {
+    IFACE_INITIALIZE_STEP (IFACE_MODEM,     iface_modem,           0,                                                   TRUE),
+    IFACE_INITIALIZE_STEP (IFACE_3GPP,      iface_modem_3gpp,      IFACE_MASK (IFACE_MODEM),                            TRUE),
+    IFACE_INITIALIZE_STEP (IFACE_3GPP_USSD, iface_modem_3gpp_ussd, IFACE_MASK (IFACE_3GPP),                             FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_CDMA,      iface_modem_cdma,      IFACE_MASK (IFACE_MODEM),                            TRUE),
+    IFACE_INITIALIZE_STEP (IFACE_LOCATION,  iface_modem_location,  IFACE_MASK (IFACE_3GPP) | IFACE_MASK (IFACE_CDMA),   FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_MESSAGING, iface_modem_messaging, IFACE_MASK (IFACE_3GPP) | IFACE_MASK (IFACE_CDMA),   FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_VOICE,     iface_modem_voice,     IFACE_MASK (IFACE_3GPP),                             FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_TIME,      iface_modem_time,      IFACE_MASK (IFACE_MODEM),                            FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_SIGNAL,    iface_modem_signal,    IFACE_MASK (IFACE_MODEM),                            FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_OMA,       iface_modem_oma,       IFACE_MASK (IFACE_MODEM),                            FALSE),
+    IFACE_INITIALIZE_STEP (IFACE_FIRMWARE,  iface_modem_firmware,  IFACE_MASK (IFACE_MODEM),                            FALSE),
+};
+
 static void
-iface_modem_initialize_ready (MMBroadbandModem *self,
-                              GAsyncResult *result,
-                              GTask *task)
+initialize_iface_modem_done (IfaceGraph *graph,
+                             const GError *error)
 {
-    InitializeContext *ctx;
-    GError *error = NULL;
-
-    ctx = g_task_get_task_data (task);
+    MMBroadbandModem *self = graph->self;
 
     /* If the modem interface fails to get initialized, we will move the modem
      * to a FAILED state. Note that in this case we still export the interface. */
-    if (!mm_iface_modem_initialize_finish (MM_IFACE_MODEM (self), result, &error)) {
+    if (error) {
         MMModemStateFailedReason failed_reason = MM_MODEM_STATE_FAILED_REASON_UNKNOWN;
 
         /* Report the new FAILED state */
@@ -10520,14 +10973,11 @@ iface_modem_initialize_ready (MMBroadbandModem *self,
                                   MM_MOBILE_EQUIPMENT_ERROR_SIM_WRONG))
             failed_reason = MM_MODEM_STATE_FAILED_REASON_SIM_MISSING;
 
-        g_error_free (error);
-
         mm_iface_modem_update_failed_state (MM_IFACE_MODEM (self), failed_reason);
 
-        /* Jump to the firmware step. We allow firmware switching even in failed
-         * state */
-        ctx->step = INITIALIZE_STEP_IFACE_FIRMWARE;
-        initialize_step (task);
+        /* Only run the firmware step. We allow firmware switching even in
+         * failed state */
+        iface_graph_skip (graph, (IFACE_MASK (IFACE_LAST) - 1) & ~IFACE_MASK (IFACE_FIRMWARE));
         return;
     }
 
@@ -10538,72 +10988,63 @@ iface_modem_initialize_ready (MMBroadbandModem *self,
     /* If we find ourselves in a LOCKED state, we shouldn't keep on
      * the initialization sequence. Instead, we will re-initialize once
      * we are unlocked. */
-    if (ctx->self->priv->modem_state == MM_MODEM_STATE_LOCKED) {
-        /* Jump to the Firmware interface. We do allow modems to export
+    if (self->priv->modem_state == MM_MODEM_STATE_LOCKED) {
+        /* Only run the Firmware interface step. We do allow modems to export
          * both the Firmware and Simple interfaces when locked. */
-        ctx->step = INITIALIZE_STEP_IFACE_FIRMWARE;
-        initialize_step (task);
+        iface_graph_skip (graph, (IFACE_MASK (IFACE_LAST) - 1) & ~IFACE_MASK (IFACE_FIRMWARE));
+    }
+}
+
+static void
+initialize_iface_step_done (IfaceGraph *graph,
+                            const IfaceStep *step,
+                            const GError *error)
+{
+    MMBroadbandModem *self = graph->self;
+
+    if (step->iface == IFACE_MODEM) {
+        initialize_iface_modem_done (graph, error);
         return;
     }
 
-    /* Go on to next step */
-    ctx->step++;
-    initialize_step (task);
-}
+    if (!error) {
+        /* bind simple properties */
+        step->bind_simple_status (self, self->priv->modem_simple_status);
+        return;
+    }
 
-#undef INTERFACE_INIT_READY_FN
-#define INTERFACE_INIT_READY_FN(NAME,TYPE,FATAL_ERRORS)                 \
-    static void                                                         \
-    NAME##_initialize_ready (MMBroadbandModem *self,                    \
-                             GAsyncResult *result,                      \
-                             GTask *task)                               \
-    {                                                                   \
-        InitializeContext *ctx;                                         \
-        GError *error = NULL;                                           \
-                                                                        \
-        ctx = g_task_get_task_data (task);                              \
-                                                                        \
-        if (!mm_##NAME##_initialize_finish (TYPE (self), result, &error)) { \
-            if (FATAL_ERRORS) {                                         \
-                mm_warn ("Couldn't initialize interface: '%s'",         \
-                         error->message);                               \
-                g_error_free (error);                                   \
-                                                                        \
-                /* Report the new FAILED state */                       \
-                mm_iface_modem_update_failed_state (MM_IFACE_MODEM (self), \
-                                                    MM_MODEM_STATE_FAILED_REASON_UNKNOWN); \
-                                                                        \
-                /* Just jump to the last step */                        \
-                ctx->step = INITIALIZE_STEP_LAST;                       \
-                initialize_step (task);                                 \
-                return;                                                 \
-            }                                                           \
-                                                                        \
-            mm_dbg ("Couldn't initialize interface: '%s'",              \
-                    error->message);                                    \
-            /* Just shutdown this interface */                          \
-            mm_##NAME##_shutdown (TYPE (self));                         \
-            g_error_free (error);                                       \
-        } else {                                                        \
-            /* bind simple properties */                                \
-            mm_##NAME##_bind_simple_status (TYPE (self), self->priv->modem_simple_status); \
-        }                                                               \
-                                                                        \
-        /* Go on to next step */                                        \
-        ctx->step++;                                                    \
-        initialize_step (task);                                         \
+    if (step->fatal) {
+        mm_warn ("Couldn't initialize %s interface: '%s'",
+                 iface_names[step->iface], error->message);
+
+        /* Report the new FAILED state */
+        mm_iface_modem_update_failed_state (MM_IFACE_MODEM (self),
+                                            MM_MODEM_STATE_FAILED_REASON_UNKNOWN);
+        iface_graph_abort (graph, NULL);
+        return;
     }
 
-INTERFACE_INIT_READY_FN (iface_modem_3gpp,      MM_IFACE_MODEM_3GPP,      TRUE)
-INTERFACE_INIT_READY_FN (iface_modem_3gpp_ussd, MM_IFACE_MODEM_3GPP_USSD, FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_cdma,      MM_IFACE_MODEM_CDMA,      TRUE)
-INTERFACE_INIT_READY_FN (iface_modem_location,  MM_IFACE_MODEM_LOCATION,  FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_messaging, MM_IFACE_MODEM_MESSAGING, FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_voice,     MM_IFACE_MODEM_VOICE,     FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_time,      MM_IFACE_MODEM_TIME,      FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_signal,    MM_IFACE_MODEM_SIGNAL,    FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_oma,       MM_IFACE_MODEM_OMA,       FALSE)
-INTERFACE_INIT_READY_FN (iface_modem_firmware,  MM_IFACE_MODEM_FIRMWARE,  FALSE)
+    mm_dbg ("Couldn't initialize %s interface: '%s'",
+            iface_names[step->iface], error->message);
+    /* Just shutdown this interface */
+    step->shutdown (self);
+}
+
+static void
+initialize_ifaces_done (GTask *task)
+{
+    InitializeContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+
+    /* On fatal errors, just jump to the last step */
+    if (ctx->graph.aborted &&
+        !g_cancellable_is_cancelled (g_task_get_cancellable (task)))
+        ctx->step = INITIALIZE_STEP_LAST;
+    else
+        ctx->step++;
+    initialize_step (task);
+}
 
 static void
 initialize_step (GTask *task)
@@ -10624,12 +11065,14 @@ initialize_step (GTask *task)
         ctx->step++;
 
     case INITIALIZE_STEP_SETUP_PORTS:
+        mm_trace_sequence_step (&ctx->trace, "setup-ports");
         if (MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->setup_ports)
             MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->setup_ports (ctx->self);
         /* Fall down to next step */
         ctx->step++;
 
     case INITIALIZE_STEP_STARTED:
+        mm_trace_sequence_step (&ctx->trace, "started");
         if (MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->initialization_started &&
             MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->initialization_started_finish) {
             MM_BROADBAND_MODEM_GET_CLASS (ctx->self)->initialization_started (ctx->self,
@@ -10649,111 +11092,20 @@ initialize_step (GTask *task)
         /* Fall down to next step */
         ctx->step++;
 
-    case INITIALIZE_STEP_IFACE_MODEM:
-        /* Initialize the Modem interface */
-        mm_iface_modem_initialize (MM_IFACE_MODEM (ctx->self),
-                                   g_task_get_cancellable (task),
-                                   (GAsyncReadyCallback)iface_modem_initialize_ready,
-                                   task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_3GPP:
-        if (mm_iface_modem_is_3gpp (MM_IFACE_MODEM (ctx->self))) {
-            /* Initialize the 3GPP interface */
-            mm_iface_modem_3gpp_initialize (MM_IFACE_MODEM_3GPP (ctx->self),
-                                            g_task_get_cancellable (task),
-                                            (GAsyncReadyCallback)iface_modem_3gpp_initialize_ready,
-                                            task);
-            return;
-        }
-
-        /* Fall down to next step */
-        ctx->step++;
-
-    case INITIALIZE_STEP_IFACE_3GPP_USSD:
-        if (mm_iface_modem_is_3gpp (MM_IFACE_MODEM (ctx->self))) {
-            /* Initialize the 3GPP/USSD interface */
-            mm_iface_modem_3gpp_ussd_initialize (MM_IFACE_MODEM_3GPP_USSD (ctx->self),
-                                                 (GAsyncReadyCallback)iface_modem_3gpp_ussd_initialize_ready,
-                                                 task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case INITIALIZE_STEP_IFACE_CDMA:
-        if (mm_iface_modem_is_cdma (MM_IFACE_MODEM (ctx->self))) {
-            /* Initialize the CDMA interface */
-            mm_iface_modem_cdma_initialize (MM_IFACE_MODEM_CDMA (ctx->self),
-                                            g_task_get_cancellable (task),
-                                            (GAsyncReadyCallback)iface_modem_cdma_initialize_ready,
-                                            task);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case INITIALIZE_STEP_IFACE_CONTACTS:
-        /* Fall down to next step */
-        ctx->step++;
-
-    case INITIALIZE_STEP_IFACE_LOCATION:
-        /* Initialize the Location interface */
-        mm_iface_modem_location_initialize (MM_IFACE_MODEM_LOCATION (ctx->self),
-                                            g_task_get_cancellable (task),
-                                            (GAsyncReadyCallback)iface_modem_location_initialize_ready,
-                                            task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_MESSAGING:
-        /* Initialize the Messaging interface */
-        mm_iface_modem_messaging_initialize (MM_IFACE_MODEM_MESSAGING (ctx->self),
-                                             g_task_get_cancellable (task),
-                                             (GAsyncReadyCallback)iface_modem_messaging_initialize_ready,
-                                             task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_VOICE:
-        /* Initialize the Voice interface */
-        mm_iface_modem_voice_initialize (MM_IFACE_MODEM_VOICE (ctx->self),
-                                         g_task_get_cancellable (task),
-                                         (GAsyncReadyCallback)iface_modem_voice_initialize_ready,
-                                         task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_TIME:
-        /* Initialize the Time interface */
-        mm_iface_modem_time_initialize (MM_IFACE_MODEM_TIME (ctx->self),
-                                        g_task_get_cancellable (task),
-                                        (GAsyncReadyCallback)iface_modem_time_initialize_ready,
-                                        task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_SIGNAL:
-        /* Initialize the Signal interface */
-        mm_iface_modem_signal_initialize (MM_IFACE_MODEM_SIGNAL (ctx->self),
-                                          g_task_get_cancellable (task),
-                                          (GAsyncReadyCallback)iface_modem_signal_initialize_ready,
-                                          task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_OMA:
-        /* Initialize the Oma interface */
-        mm_iface_modem_oma_initialize (MM_IFACE_MODEM_OMA (ctx->self),
-                                       g_task_get_cancellable (task),
-                                       (GAsyncReadyCallback)iface_modem_oma_initialize_ready,
-                                       task);
-        return;
-
-    case INITIALIZE_STEP_IFACE_FIRMWARE:
-        /* Initialize the Firmware interface */
-        mm_iface_modem_firmware_initialize (MM_IFACE_MODEM_FIRMWARE (ctx->self),
-                                            g_task_get_cancellable (task),
-                                            (GAsyncReadyCallback)iface_modem_firmware_initialize_ready,
-                                            task);
+    case INITIALIZE_STEP_IFACES:
+        mm_trace_sequence_step (&ctx->trace, "interfaces");
+        iface_graph_init (&ctx->graph,
+                          task,
+                          "initialization",
+                          initialize_iface_steps,
+                          G_N_ELEMENTS (initialize_iface_steps),
+                          initialize_iface_step_done,
+                          initialize_ifaces_done);
+        iface_graph_schedule (&ctx->graph);
         return;
 
     case INITIALIZE_STEP_SIM_HOT_SWAP:
+        mm_trace_sequence_step (&ctx->trace, "sim-hot-swap");
         /* Create the SIM hot swap ports context only if not already done before
          * (we may be re-running the initialization step after SIM-PIN unlock) */
         if (!ctx->self->priv->sim_hot_swap_ports_ctx) {
@@ -10862,18 +11214,22 @@ sim_hot_swap_enabled:
                 mm_iface_modem_simple_shutdown (MM_IFACE_MODEM_SIMPLE (ctx->self));
             }
 
+            mm_trace_sequence_complete (&ctx->trace, error);
             g_task_return_error (task, error);
             g_object_unref (task);
             return;
         }
 
         if (ctx->self->priv->modem_state == MM_MODEM_STATE_LOCKED) {
+            GError *error;
+
             /* We're locked :-/ */
-            g_task_return_new_error (task,
-                                     MM_CORE_ERROR,
-                                     MM_CORE_ERROR_WRONG_STATE,
-                                     "Modem is currently locked, "
-                                     "cannot fully initialize");
+            error = g_error_new (MM_CORE_ERROR,
+                                 MM_CORE_ERROR_WRONG_STATE,
+                                 "Modem is currently locked, "
+                                 "cannot fully initialize");
+            mm_trace_sequence_complete (&ctx->trace, error);
+            g_task_return_error (task, error);
             g_object_unref (task);
             return;
         }
@@ -10884,6 +11240,7 @@ sim_hot_swap_enabled:
                                      MM_MODEM_STATE_DISABLED,
                                      MM_MODEM_STATE_CHANGE_REASON_UNKNOWN);
 
+        mm_trace_sequence_complete (&ctx->trace, NULL);
         g_task_return_boolean (task, TRUE);
         g_object_unref (task);
         return;
@@ -10920,6 +11277,7 @@ initialize (MMBaseModem *self,
         ctx = g_new0 (InitializeContext, 1);
         ctx->self = g_object_ref (self);
         ctx->step = INITIALIZE_STEP_FIRST;
+        mm_trace_sequence_init (&ctx->trace, mm_base_modem_get_device (self), "initialization");
 
         g_task_set_task_data (task, ctx, (GDestroyNotify)initialize_context_free);
 
@@ -11034,6 +11392,13 @@ mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self)
         self->priv->sim_hot_swap_ports_ctx = NULL;
     }
 
+    /* Supported modes and bands may depend on the SIM card */
+    mm_iface_modem_info_cache_invalidate (MM_IFACE_MODEM (self), "SIM hot swap");
+
+    /* The same card may be inserted back after being modified elsewhere */
+    if (self->priv->modem_sim)
+        mm_base_sim_invalidate_info_cache (self->priv->modem_sim, "SIM hot swap");
+
     mm_base_modem_set_reprobe (MM_BASE_MODEM (self), TRUE);
     mm_base_modem_disable (MM_BASE_MODEM (self),
                            (GAsyncReadyCallback) after_hotswap_event_disable_ready,
@@ -11171,6 +11536,9 @@ set_property (GObject *object,
     case PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE:
         self->priv->modem_messaging_sms_default_storage = g_value_get_enum (value);
         break;
+    case PROP_MODEM_MESSAGING_SMS_SEND_INTERVAL:
+        self->priv->modem_messaging_sms_send_interval = g_value_get_uint (value);
+        break;
     case PROP_MODEM_SIMPLE_STATUS:
         g_clear_object (&self->priv->modem_simple_status);
         self->priv->modem_simple_status = g_value_dup_object (value);
@@ -11184,6 +11552,12 @@ set_property (GObject *object,
     case PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED:
         self->priv->periodic_signal_check_disabled = g_value_get_boolean (value);
         break;
+    case PROP_MODEM_INFO_CACHE_ENABLED:
+        self->priv->info_cache_enabled = g_value_get_boolean (value);
+        break;
+    case PROP_MODEM_INFO_CACHE_SUPPORTED_ENABLED:
+        self->priv->info_cache_supported_enabled = g_value_get_boolean (value);
+        break;
     case PROP_FLOW_CONTROL:
         self->priv->flow_control = g_value_get_flags (value);
         break;
@@ -11289,6 +11663,9 @@ get_property (GObject *object,
     case PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE:
         g_value_set_enum (value, self->priv->modem_messaging_sms_default_storage);
         break;
+    case PROP_MODEM_MESSAGING_SMS_SEND_INTERVAL:
+        g_value_set_uint (value, self->priv->modem_messaging_sms_send_interval);
+        break;
     case PROP_MODEM_SIMPLE_STATUS:
         g_value_set_object (value, self->priv->modem_simple_status);
         break;
@@ -11301,6 +11678,12 @@ get_property (GObject *object,
     case PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED:
         g_value_set_boolean (value, self->priv->periodic_signal_check_disabled);
         break;
+    case PROP_MODEM_INFO_CACHE_ENABLED:
+        g_value_set_boolean (value, self->priv->info_cache_enabled);
+        break;
+    case PROP_MODEM_INFO_CACHE_SUPPORTED_ENABLED:
+        g_value_set_boolean (value, self->priv->info_cache_supported_enabled);
+        break;
     case PROP_FLOW_CONTROL:
         g_value_set_flags (value, self->priv->flow_control);
         break;
@@ -11318,7 +11701,6 @@ mm_broadband_modem_init (MMBroadbandModem *self)
                                               MM_TYPE_BROADBAND_MODEM,
                                               MMBroadbandModemPrivate);
     self->priv->modem_state = MM_MODEM_STATE_UNKNOWN;
-    self->priv->modem_3gpp_registration_regex = mm_3gpp_creg_regex_get (TRUE);
     self->priv->modem_current_charset = MM_MODEM_CHARSET_UNKNOWN;
     self->priv->modem_3gpp_registration_state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     self->priv->modem_3gpp_cs_network_supported = TRUE;
@@ -11334,6 +11716,8 @@ mm_broadband_modem_init (MMBroadbandModem *self)
     self->priv->current_sms_mem2_storage = MM_SMS_STORAGE_UNKNOWN;
     self->priv->sim_hot_swap_supported = FALSE;
     self->priv->periodic_signal_check_disabled = FALSE;
+    self->priv->info_cache_enabled = TRUE;
+    self->priv->info_cache_supported_enabled = FALSE;
     self->priv->modem_cmer_enable_mode = MM_3GPP_CMER_MODE_NONE;
     self->priv->modem_cmer_disable_mode = MM_3GPP_CMER_MODE_NONE;
     self->priv->modem_cmer_ind = MM_3GPP_CMER_IND_NONE;
@@ -11351,8 +11735,10 @@ finalize (GObject *object)
     if (self->priv->sim_hot_swap_ports_ctx)
         ports_context_unref (self->priv->sim_hot_swap_ports_ctx);
 
-    if (self->priv->modem_3gpp_registration_regex)
-        mm_3gpp_creg_regex_destroy (self->priv->modem_3gpp_registration_regex);
+    g_assert (!self->priv->pdp_status_pending);
+    mm_3gpp_pdp_context_active_list_free (self->priv->pdp_status_list);
+    g_clear_pointer (&self->priv->metric_pdp_status_queries,         mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_pdp_status_queries_avoided, mm_metric_unref);
 
     G_OBJECT_CLASS (mm_broadband_modem_parent_class)->finalize (object);
 }
@@ -11813,6 +12199,10 @@ mm_broadband_modem_class_init (MMBroadbandModemClass *klass)
                                       PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE,
                                       MM_IFACE_MODEM_MESSAGING_SMS_DEFAULT_STORAGE);
 
+    g_object_class_override_property (object_class,
+                                      PROP_MODEM_MESSAGING_SMS_SEND_INTERVAL,
+                                      MM_IFACE_MODEM_MESSAGING_SMS_SEND_INTERVAL);
+
     g_object_class_override_property (object_class,
                                       PROP_MODEM_SIMPLE_STATUS,
                                       MM_IFACE_MODEM_SIMPLE_STATUS);
@@ -11829,6 +12219,14 @@ mm_broadband_modem_class_init (MMBroadbandModemClass *klass)
                                       PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED,
                                       MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED);
 
+    g_object_class_override_property (object_class,
+                                      PROP_MODEM_INFO_CACHE_ENABLED,
+                                      MM_IFACE_MODEM_INFO_CACHE_ENABLED);
+
+    g_object_class_override_property (object_class,
+                                      PROP_MODEM_INFO_CACHE_SUPPORTED_ENABLED,
+                                      MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED);
+
     properties[PROP_FLOW_CONTROL] =
         g_param_spec_flags (MM_BROADBAND_MODEM_FLOW_CONTROL,
                             "Flow control",
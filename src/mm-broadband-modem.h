@@ -27,6 +27,7 @@
 #include "mm-modem-helpers.h"
 #include "mm-charsets.h"
 #include "mm-base-modem.h"
+#include "mm-base-bearer.h"
 
 #define MM_TYPE_BROADBAND_MODEM            (mm_broadband_modem_get_type ())
 #define MM_BROADBAND_MODEM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_BROADBAND_MODEM, MMBroadbandModem))
@@ -133,4 +134,15 @@ void     mm_broadband_modem_unlock_sms_storages      (MMBroadbandModem *self,
 /* Helper to update SIM hot swap */
 void mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self);
 
+/* Connection status of a PDP context. A single +CGACT? query is shared by all
+ * the bearers polling within the same period, and no query is sent at all
+ * while +CGEV indications report deactivations. */
+void                     mm_broadband_modem_load_pdp_context_status        (MMBroadbandModem     *self,
+                                                                            guint                 cid,
+                                                                            GAsyncReadyCallback   callback,
+                                                                            gpointer              user_data);
+MMBearerConnectionStatus mm_broadband_modem_load_pdp_context_status_finish (MMBroadbandModem     *self,
+                                                                            GAsyncResult         *res,
+                                                                            GError              **error);
+
 #endif /* MM_BROADBAND_MODEM_H */
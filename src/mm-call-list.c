@@ -50,6 +50,8 @@ struct _MMCallListPrivate {
     MMBaseModem *modem;
     /* List of call objects */
     GList *list;
+    /* NULL-terminated array with the paths of the call objects */
+    GPtrArray *paths;
 };
 
 /*****************************************************************************/
@@ -60,25 +62,16 @@ mm_call_list_get_count (MMCallList *self)
     return g_list_length (self->priv->list);
 }
 
+const gchar *const *
+mm_call_list_peek_paths (MMCallList *self)
+{
+    return (const gchar *const *) self->priv->paths->pdata;
+}
+
 GStrv
 mm_call_list_get_paths (MMCallList *self)
 {
-    GStrv path_list = NULL;
-    GList *l;
-    guint i;
-
-    path_list = g_new0 (gchar *, 1 + g_list_length (self->priv->list));
-
-    for (i = 0, l = self->priv->list; l; l = g_list_next (l)) {
-        const gchar *path;
-
-        /* Don't try to add NULL paths (not yet exported CALL objects) */
-        path = mm_base_call_get_path (MM_BASE_CALL (l->data));
-        if (path)
-            path_list[i++] = g_strdup (path);
-    }
-
-    return path_list;
+    return g_strdupv ((gchar **) self->priv->paths->pdata);
 }
 
 /*****************************************************************************/
@@ -125,6 +118,7 @@ mm_call_list_delete_call (MMCallList   *self,
 {
     GList      *l;
     MMBaseCall *call;
+    guint       i;
 
     l = g_list_find_custom (self->priv->list,
                             (gpointer)call_path,
@@ -139,6 +133,12 @@ mm_call_list_delete_call (MMCallList   *self,
     }
 
     call = MM_BASE_CALL (l->data);
+    for (i = 0; i < self->priv->paths->len - 1; i++) {
+        if (g_str_equal (g_ptr_array_index (self->priv->paths, i), call_path)) {
+            g_ptr_array_remove_index (self->priv->paths, i);
+            break;
+        }
+    }
     mm_base_call_unexport (call);
     g_signal_emit (self, signals[SIGNAL_CALL_DELETED], 0, call_path);
 
@@ -155,6 +155,18 @@ mm_call_list_add_call (MMCallList *self,
                      MMBaseCall *call)
 {
     self->priv->list = g_list_prepend (self->priv->list, g_object_ref (call));
+
+    /* Don't try to add NULL paths (not yet exported CALL objects). Newest
+     * first, same as in the list; the NULL terminator is moved along with the
+     * other paths */
+    if (mm_base_call_get_path (call)) {
+        g_ptr_array_add (self->priv->paths, NULL);
+        memmove (&self->priv->paths->pdata[1],
+                 &self->priv->paths->pdata[0],
+                 (self->priv->paths->len - 1) * sizeof (gpointer));
+        self->priv->paths->pdata[0] = g_strdup (mm_base_call_get_path (call));
+    }
+
     g_signal_emit (self, signals[SIGNAL_CALL_ADDED], 0,
                    mm_base_call_get_path (call),
                    FALSE);
@@ -215,6 +227,9 @@ mm_call_list_init (MMCallList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_CALL_LIST,
                                               MMCallListPrivate);
+
+    self->priv->paths = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_add (self->priv->paths, NULL);
 }
 
 static void
@@ -229,6 +244,16 @@ dispose (GObject *object)
     G_OBJECT_CLASS (mm_call_list_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    MMCallList *self = MM_CALL_LIST (object);
+
+    g_ptr_array_unref (self->priv->paths);
+
+    G_OBJECT_CLASS (mm_call_list_parent_class)->finalize (object);
+}
+
 static void
 mm_call_list_class_init (MMCallListClass *klass)
 {
@@ -240,6 +265,7 @@ mm_call_list_class_init (MMCallListClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /* Properties */
     properties[PROP_MODEM] =
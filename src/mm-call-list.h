@@ -58,8 +58,9 @@ GType mm_call_list_get_type (void);
 
 MMCallList *mm_call_list_new (MMBaseModem *modem);
 
-GStrv mm_call_list_get_paths (MMCallList *self);
-guint mm_call_list_get_count (MMCallList *self);
+const gchar *const *mm_call_list_peek_paths (MMCallList *self);
+GStrv               mm_call_list_get_paths  (MMCallList *self);
+guint               mm_call_list_get_count  (MMCallList *self);
 
 void mm_call_list_add_call  (MMCallList *self,
                              MMBaseCall *call);
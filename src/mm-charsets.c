@@ -444,6 +444,88 @@ mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len)
     return g_byte_array_free (utf8, FALSE);
 }
 
+const gchar *
+mm_charset_gsm_char_to_utf8 (guint8    gsm,
+                             gboolean  extended,
+                             guint    *out_len)
+{
+    guint i;
+
+    if (!extended) {
+        if (gsm >= GSM_DEF_ALPHABET_SIZE)
+            return NULL;
+        *out_len = gsm_def_utf8_alphabet[gsm].len;
+        return gsm_def_utf8_alphabet[gsm].chars;
+    }
+
+    for (i = 0; i < GSM_EXT_ALPHABET_SIZE; i++) {
+        if (gsm == gsm_ext_utf8_alphabet[i].gsm) {
+            *out_len = gsm_ext_utf8_alphabet[i].len;
+            return gsm_ext_utf8_alphabet[i].chars;
+        }
+    }
+    return NULL;
+}
+
+/* ASCII to GSM lookup, built on first use. Extended chars have
+ * GSM_ASCII_EXTENDED set, unmapped ones are GSM_ASCII_NONE. */
+#define GSM_ASCII_EXTENDED 0x80
+#define GSM_ASCII_NONE     0xff
+
+static guint8 gsm_from_ascii[0x80];
+
+static void
+gsm_from_ascii_init (void)
+{
+    static gboolean initialized;
+    guint i;
+
+    if (G_LIKELY (initialized))
+        return;
+
+    memset (gsm_from_ascii, GSM_ASCII_NONE, sizeof (gsm_from_ascii));
+    for (i = 0; i < GSM_DEF_ALPHABET_SIZE; i++) {
+        guint8 c = (guint8) gsm_def_utf8_alphabet[i].chars[0];
+
+        /* Skips the escape code, mapped to a non-ASCII byte */
+        if (gsm_def_utf8_alphabet[i].len == 1 && c < 0x80)
+            gsm_from_ascii[c] = i;
+    }
+    for (i = 0; i < GSM_EXT_ALPHABET_SIZE; i++) {
+        if (gsm_ext_utf8_alphabet[i].len == 1)
+            gsm_from_ascii[(guint8) gsm_ext_utf8_alphabet[i].chars[0]] = gsm_ext_utf8_alphabet[i].gsm | GSM_ASCII_EXTENDED;
+    }
+    initialized = TRUE;
+}
+
+gboolean
+mm_charset_gsm_char_from_utf8 (gunichar  c,
+                               guint8   *out_gsm,
+                               gboolean *out_extended)
+{
+    gchar utf8[6];
+    gint  len;
+
+    if (c < 0x80) {
+        guint8 gsm;
+
+        gsm_from_ascii_init ();
+        gsm = gsm_from_ascii[c];
+        if (gsm == GSM_ASCII_NONE)
+            return FALSE;
+        *out_gsm = gsm & ~GSM_ASCII_EXTENDED;
+        *out_extended = !!(gsm & GSM_ASCII_EXTENDED);
+        return TRUE;
+    }
+
+    len = g_unichar_to_utf8 (c, utf8);
+    *out_extended = FALSE;
+    if (utf8_to_gsm_def_char (utf8, len, out_gsm))
+        return TRUE;
+    *out_extended = TRUE;
+    return utf8_to_gsm_ext_char (utf8, len, out_gsm);
+}
+
 guint8 *
 mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len)
 {
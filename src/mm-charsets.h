@@ -62,6 +62,15 @@ guint8 *mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len);
 
 guint8 *mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len);
 
+/* Single GSM 03.38 character conversions. Extended characters are the ones
+ * following the escape char (0x1b). */
+const gchar *mm_charset_gsm_char_to_utf8   (guint8    gsm,
+                                            gboolean  extended,
+                                            guint    *out_len);
+gboolean     mm_charset_gsm_char_from_utf8 (gunichar  c,
+                                            guint8   *out_gsm,
+                                            gboolean *out_extended);
+
 /* Checks whether conversion to the given charset may be done without errors */
 gboolean mm_charset_can_convert_to (const char *utf8,
                                     MMModemCharset charset);
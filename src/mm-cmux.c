@@ -0,0 +1,258 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <string.h>
+
+#include "mm-cmux.h"
+
+/*****************************************************************************/
+/* FCS, 3GPP TS 27.010 annex B: reversed CRC-8 with polynomial x^8+x^2+x+1 */
+
+static const guint8 crc_table[256] = {
+    0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75,
+    0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+    0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69,
+    0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+    0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D,
+    0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+    0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51,
+    0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+    0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05,
+    0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+    0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19,
+    0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+    0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D,
+    0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+    0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21,
+    0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+    0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95,
+    0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+    0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89,
+    0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+    0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD,
+    0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+    0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1,
+    0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+    0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5,
+    0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+    0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9,
+    0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+    0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD,
+    0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+    0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1,
+    0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF
+};
+
+guint8
+mm_cmux_fcs (const guint8 *data,
+             gsize         len)
+{
+    guint8 crc = 0xFF;
+    gsize  i;
+
+    for (i = 0; i < len; i++)
+        crc = crc_table[crc ^ data[i]];
+    return 0xFF - crc;
+}
+
+/*****************************************************************************/
+
+void
+mm_cmux_frame_append (GByteArray   *buffer,
+                      guint8        dlci,
+                      guint8        type,
+                      gboolean      pf,
+                      gboolean      cr,
+                      const guint8 *data,
+                      gsize         len)
+{
+    guint8 header[4];
+    guint  header_len;
+    guint  start;
+    guint8 fcs;
+
+    g_assert (dlci <= MM_CMUX_DLCI_MAX);
+    g_assert (len <= 0x7FFF);
+
+    header[0] = (dlci << 2) | (cr ? 0x02 : 0x00) | 0x01;
+    header[1] = type | (pf ? MM_CMUX_FRAME_PF : 0x00);
+    if (len <= 0x7F) {
+        header[2] = (len << 1) | 0x01;
+        header_len = 3;
+    } else {
+        header[2] = (len << 1) & 0xFE;
+        header[3] = len >> 7;
+        header_len = 4;
+    }
+
+    g_byte_array_append (buffer, (const guint8 *) "\xF9", 1);
+    start = buffer->len;
+    g_byte_array_append (buffer, header, header_len);
+    if (len)
+        g_byte_array_append (buffer, data, len);
+
+    /* UIH frames only protect the header, all others also the information */
+    fcs = mm_cmux_fcs (&buffer->data[start],
+                       (type == MM_CMUX_FRAME_TYPE_UIH) ? header_len : header_len + len);
+    g_byte_array_append (buffer, &fcs, 1);
+    g_byte_array_append (buffer, (const guint8 *) "\xF9", 1);
+}
+
+MMCmuxParseResult
+mm_cmux_frame_parse (const guint8 *buffer,
+                     gsize         len,
+                     MMCmuxFrame  *frame,
+                     gsize        *consumed)
+{
+    const guint8 *start;
+    gsize         header_len;
+    gsize         info_len;
+    gsize         total;
+    guint8        fcs;
+
+    g_assert (frame != NULL);
+    g_assert (consumed != NULL);
+
+    /* Skip garbage until the opening flag */
+    start = memchr (buffer, MM_CMUX_FLAG, len);
+    if (!start) {
+        *consumed = len;
+        return MM_CMUX_PARSE_RESULT_NEED_MORE;
+    }
+
+    /* Several consecutive flags may be found between frames */
+    while ((gsize)(start - buffer) + 1 < len && start[1] == MM_CMUX_FLAG)
+        start++;
+
+    *consumed = start - buffer;
+    len -= *consumed;
+
+    /* Flag, address, control and first length byte */
+    if (len < 4)
+        return MM_CMUX_PARSE_RESULT_NEED_MORE;
+
+    /* Only single-byte addresses are allowed */
+    if (!(start[1] & 0x01)) {
+        *consumed += 1;
+        return MM_CMUX_PARSE_RESULT_INVALID;
+    }
+
+    if (start[3] & 0x01) {
+        info_len = start[3] >> 1;
+        header_len = 3;
+    } else {
+        if (len < 5)
+            return MM_CMUX_PARSE_RESULT_NEED_MORE;
+        info_len = (start[3] >> 1) | (start[4] << 7);
+        header_len = 4;
+    }
+
+    /* Opening flag, header, information, FCS and closing flag */
+    total = 1 + header_len + info_len + 1 + 1;
+    if (len < total)
+        return MM_CMUX_PARSE_RESULT_NEED_MORE;
+
+    if (start[total - 1] != MM_CMUX_FLAG) {
+        /* Resync on the next flag */
+        *consumed += 1;
+        return MM_CMUX_PARSE_RESULT_INVALID;
+    }
+
+    /* Never consume the closing flag */
+    *consumed += total - 1;
+
+    frame->dlci = start[1] >> 2;
+    frame->cr   = !!(start[1] & 0x02);
+    frame->type = start[2] & ~MM_CMUX_FRAME_PF;
+    frame->pf   = !!(start[2] & MM_CMUX_FRAME_PF);
+    frame->data = info_len ? &start[1 + header_len] : NULL;
+    frame->len  = info_len;
+
+    fcs = mm_cmux_fcs (&start[1],
+                       (frame->type == MM_CMUX_FRAME_TYPE_UIH) ? header_len : header_len + info_len);
+    if (fcs != start[1 + header_len + info_len])
+        return MM_CMUX_PARSE_RESULT_INVALID;
+
+    return MM_CMUX_PARSE_RESULT_FRAME;
+}
+
+/*****************************************************************************/
+
+void
+mm_cmux_control_message_append (GByteArray   *buffer,
+                                guint8        type,
+                                gboolean      cr,
+                                const guint8 *value,
+                                gsize         len)
+{
+    guint8 header[2];
+
+    /* Control messages are always short, single byte length is enough */
+    g_assert (len <= 0x7F);
+
+    header[0] = (type << 2) | (cr ? 0x02 : 0x00) | 0x01;
+    header[1] = (len << 1) | 0x01;
+    g_byte_array_append (buffer, header, 2);
+    if (len)
+        g_byte_array_append (buffer, value, len);
+}
+
+gboolean
+mm_cmux_control_message_parse (const guint8  *data,
+                               gsize          len,
+                               guint8        *type,
+                               gboolean      *cr,
+                               const guint8 **value,
+                               gsize         *value_len)
+{
+    gsize msg_len;
+
+    /* Single byte type and length fields */
+    if (len < 2 || !(data[0] & 0x01) || !(data[1] & 0x01))
+        return FALSE;
+
+    msg_len = data[1] >> 1;
+    if (len < 2 + msg_len)
+        return FALSE;
+
+    *type = data[0] >> 2;
+    *cr = !!(data[0] & 0x02);
+    *value = msg_len ? &data[2] : NULL;
+    *value_len = msg_len;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+const gchar *
+mm_cmux_frame_type_get_string (guint8 type)
+{
+    switch (type & ~MM_CMUX_FRAME_PF) {
+    case MM_CMUX_FRAME_TYPE_SABM:
+        return "SABM";
+    case MM_CMUX_FRAME_TYPE_UA:
+        return "UA";
+    case MM_CMUX_FRAME_TYPE_DM:
+        return "DM";
+    case MM_CMUX_FRAME_TYPE_DISC:
+        return "DISC";
+    case MM_CMUX_FRAME_TYPE_UIH:
+        return "UIH";
+    case MM_CMUX_FRAME_TYPE_UI:
+        return "UI";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_CMUX_H
+#define MM_CMUX_H
+
+#include <glib.h>
+
+/*****************************************************************************/
+/* 3GPP TS 27.010 basic option frame codec */
+
+#define MM_CMUX_FLAG 0xF9
+
+/* Maximum DLCI value allowed in the address field */
+#define MM_CMUX_DLCI_MAX 63
+
+/* Default maximum information field length (N1) in basic option */
+#define MM_CMUX_DEFAULT_FRAME_SIZE 31
+
+/* Control field values, without the P/F bit */
+typedef enum {
+    MM_CMUX_FRAME_TYPE_SABM = 0x2F,
+    MM_CMUX_FRAME_TYPE_UA   = 0x63,
+    MM_CMUX_FRAME_TYPE_DM   = 0x0F,
+    MM_CMUX_FRAME_TYPE_DISC = 0x43,
+    MM_CMUX_FRAME_TYPE_UIH  = 0xEF,
+    MM_CMUX_FRAME_TYPE_UI   = 0x03,
+} MMCmuxFrameType;
+
+#define MM_CMUX_FRAME_PF 0x10
+
+/* Multiplexer control channel (DLCI 0) message types, without the C/R and EA
+ * bits */
+typedef enum {
+    MM_CMUX_CONTROL_TYPE_PN    = 0x20,
+    MM_CMUX_CONTROL_TYPE_PSC   = 0x10,
+    MM_CMUX_CONTROL_TYPE_CLD   = 0x30,
+    MM_CMUX_CONTROL_TYPE_TEST  = 0x08,
+    MM_CMUX_CONTROL_TYPE_FCON  = 0x28,
+    MM_CMUX_CONTROL_TYPE_FCOFF = 0x18,
+    MM_CMUX_CONTROL_TYPE_MSC   = 0x38,
+    MM_CMUX_CONTROL_TYPE_NSC   = 0x04,
+} MMCmuxControlType;
+
+/* V.24 signals in the MSC message */
+#define MM_CMUX_MSC_FC  0x02
+#define MM_CMUX_MSC_RTC 0x04
+#define MM_CMUX_MSC_RTR 0x08
+#define MM_CMUX_MSC_IC  0x40
+#define MM_CMUX_MSC_DV  0x80
+
+/* A parsed frame. The information field is not copied, it points to the
+ * buffer given to the parser. */
+typedef struct {
+    guint8        dlci;
+    guint8        type;
+    gboolean      pf;
+    gboolean      cr;
+    const guint8 *data;
+    gsize         len;
+} MMCmuxFrame;
+
+typedef enum {
+    MM_CMUX_PARSE_RESULT_NEED_MORE,
+    MM_CMUX_PARSE_RESULT_FRAME,
+    MM_CMUX_PARSE_RESULT_INVALID,
+} MMCmuxParseResult;
+
+guint8 mm_cmux_fcs (const guint8 *data,
+                    gsize         len);
+
+/* Appends a full frame, including the opening and closing flags, to the given
+ * buffer. */
+void mm_cmux_frame_append (GByteArray   *buffer,
+                           guint8        dlci,
+                           guint8        type,
+                           gboolean      pf,
+                           gboolean      cr,
+                           const guint8 *data,
+                           gsize         len);
+
+/* Looks for the next frame in the given buffer. In all cases, @consumed is
+ * set to the number of bytes that may be removed from the beginning of the
+ * buffer (e.g. the processed frame, or garbage found before it). The closing
+ * flag is never consumed, as it may be the opening flag of the next frame. */
+MMCmuxParseResult mm_cmux_frame_parse (const guint8 *buffer,
+                                       gsize         len,
+                                       MMCmuxFrame  *frame,
+                                       gsize        *consumed);
+
+/* Appends a control channel message (type, length and value), to be sent
+ * in a UIH frame on DLCI 0. */
+void mm_cmux_control_message_append (GByteArray   *buffer,
+                                     guint8        type,
+                                     gboolean      cr,
+                                     const guint8 *value,
+                                     gsize         len);
+
+gboolean mm_cmux_control_message_parse (const guint8  *data,
+                                        gsize          len,
+                                        guint8        *type,
+                                        gboolean      *cr,
+                                        const guint8 **value,
+                                        gsize         *value_len);
+
+const gchar *mm_cmux_frame_type_get_string (guint8 type);
+
+#endif /* MM_CMUX_H */
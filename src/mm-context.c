@@ -41,6 +41,15 @@ static gboolean      debug;
 static MMFilterRule  filter_policy = MM_FILTER_POLICY_DEFAULT;
 static gboolean      no_auto_scan = NO_AUTO_SCAN_DEFAULT;
 static const gchar  *initial_kernel_events;
+static gint          kernel_event_debounce = MM_CONTEXT_KERNEL_EVENT_DEBOUNCE_DEFAULT;
+static gint          network_scan_cache_ttl = MM_CONTEXT_NETWORK_SCAN_CACHE_TTL_DEFAULT;
+static gint          sms_send_interval;
+static const gchar  *metrics_file;
+static const gchar  *plugin_manifest;
+static gint          boot_probe_concurrency = MM_CONTEXT_BOOT_PROBE_CONCURRENCY_DEFAULT;
+static gint          probe_concurrency = MM_CONTEXT_PROBE_CONCURRENCY_DEFAULT;
+static gint          probe_concurrency_per_hub = MM_CONTEXT_PROBE_CONCURRENCY_PER_HUB_DEFAULT;
+static MMListPropertyUpdates list_property_updates = MM_LIST_PROPERTY_UPDATES_IMMEDIATE;
 
 static gboolean
 filter_policy_option_arg (const gchar  *option_name,
@@ -74,6 +83,33 @@ filter_policy_option_arg (const gchar  *option_name,
     return FALSE;
 }
 
+static gboolean
+list_property_updates_option_arg (const gchar  *option_name,
+                                  const gchar  *value,
+                                  gpointer      data,
+                                  GError      **error)
+{
+    if (!g_ascii_strcasecmp (value, "immediate")) {
+        list_property_updates = MM_LIST_PROPERTY_UPDATES_IMMEDIATE;
+        return TRUE;
+    }
+
+    if (!g_ascii_strcasecmp (value, "rate-limited")) {
+        list_property_updates = MM_LIST_PROPERTY_UPDATES_RATE_LIMITED;
+        return TRUE;
+    }
+
+    if (!g_ascii_strcasecmp (value, "signals-only")) {
+        list_property_updates = MM_LIST_PROPERTY_UPDATES_SIGNALS_ONLY;
+        return TRUE;
+    }
+
+    g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                 "Invalid list property updates value given: %s",
+                 value);
+    return FALSE;
+}
+
 static const GOptionEntry entries[] = {
     {
         "filter-policy", 0, 0, G_OPTION_ARG_CALLBACK, filter_policy_option_arg,
@@ -90,6 +126,51 @@ static const GOptionEntry entries[] = {
         "Path to initial kernel events file",
         "[PATH]"
     },
+    {
+        "kernel-event-debounce", 0, 0, G_OPTION_ARG_INT, &kernel_event_debounce,
+        "Time to wait for more kernel events of the same device before processing them, in ms (0 to disable)",
+        "[MS]"
+    },
+    {
+        "network-scan-cache-ttl", 0, 0, G_OPTION_ARG_INT, &network_scan_cache_ttl,
+        "Time network scan results are reused by later scan requests, in seconds (0, the default, to disable)",
+        "[SECS]"
+    },
+    {
+        "sms-send-interval", 0, 0, G_OPTION_ARG_INT, &sms_send_interval,
+        "Minimum time between consecutive SMS messages sent by a modem, in ms (0 to disable)",
+        "[MS]"
+    },
+    {
+        "metrics-file", 0, 0, G_OPTION_ARG_FILENAME, &metrics_file,
+        "Path to the file where the daemon metrics are periodically written",
+        "[PATH]"
+    },
+    {
+        "plugin-manifest", 0, 0, G_OPTION_ARG_FILENAME, &plugin_manifest,
+        "Path to the file caching plugin filters, so that plugins are only loaded when a matching device is found",
+        "[PATH]"
+    },
+    {
+        "boot-probe-concurrency", 0, 0, G_OPTION_ARG_INT, &boot_probe_concurrency,
+        "Maximum number of devices found at startup being probed at the same time, their ports still subject to --probe-concurrency (0 for no limit)",
+        "[N]"
+    },
+    {
+        "probe-concurrency", 0, 0, G_OPTION_ARG_INT, &probe_concurrency,
+        "Maximum number of ports being probed at the same time (0 for no limit)",
+        "[N]"
+    },
+    {
+        "probe-concurrency-per-hub", 0, 0, G_OPTION_ARG_INT, &probe_concurrency_per_hub,
+        "Maximum number of ports in devices behind the same USB hub, including all ports of the same modem, being probed at the same time (0, the default, for no limit)",
+        "[N]"
+    },
+    {
+        "list-property-updates", 0, 0, G_OPTION_ARG_CALLBACK, list_property_updates_option_arg,
+        "How the SMS and call list properties are updated: one of IMMEDIATE (default), RATE-LIMITED, SIGNALS-ONLY",
+        "[MODE]"
+    },
     {
         "debug", 0, 0, G_OPTION_ARG_NONE, &debug,
         "Run with extended debugging capabilities",
@@ -120,6 +201,60 @@ mm_context_get_initial_kernel_events (void)
     return initial_kernel_events;
 }
 
+guint
+mm_context_get_kernel_event_debounce (void)
+{
+    return (kernel_event_debounce > 0 ? (guint) kernel_event_debounce : 0);
+}
+
+guint
+mm_context_get_network_scan_cache_ttl (void)
+{
+    return (network_scan_cache_ttl > 0 ? (guint) network_scan_cache_ttl : 0);
+}
+
+guint
+mm_context_get_sms_send_interval (void)
+{
+    return (sms_send_interval > 0 ? (guint) sms_send_interval : 0);
+}
+
+const gchar *
+mm_context_get_metrics_file (void)
+{
+    return metrics_file;
+}
+
+const gchar *
+mm_context_get_plugin_manifest (void)
+{
+    return plugin_manifest;
+}
+
+guint
+mm_context_get_boot_probe_concurrency (void)
+{
+    return (boot_probe_concurrency > 0 ? (guint) boot_probe_concurrency : 0);
+}
+
+guint
+mm_context_get_probe_concurrency (void)
+{
+    return (probe_concurrency > 0 ? (guint) probe_concurrency : 0);
+}
+
+guint
+mm_context_get_probe_concurrency_per_hub (void)
+{
+    return (probe_concurrency_per_hub > 0 ? (guint) probe_concurrency_per_hub : 0);
+}
+
+MMListPropertyUpdates
+mm_context_get_list_property_updates (void)
+{
+    return list_property_updates;
+}
+
 gboolean
 mm_context_get_no_auto_scan (void)
 {
@@ -28,9 +28,50 @@
 void mm_context_init (gint    argc,
                       gchar **argv);
 
+/* Default time to wait for a burst of kernel events to settle, in ms */
+#define MM_CONTEXT_KERNEL_EVENT_DEBOUNCE_DEFAULT 100
+
+/* Default time network scan results are reused for, in seconds; disabled
+ * by default, as the networks around may change at any time */
+#define MM_CONTEXT_NETWORK_SCAN_CACHE_TTL_DEFAULT 0
+
+/* Default number of devices found at startup probed at the same time */
+#define MM_CONTEXT_BOOT_PROBE_CONCURRENCY_DEFAULT 8
+
+/* Default number of ports probed at the same time, in total and in devices
+ * behind the same USB hub. Both limits apply on top of the boot one, which
+ * decides which devices found at startup start probing at all; the ports of
+ * a single modem are all behind the same hub, so the per-hub limit is
+ * disabled by default not to serialize their probing. */
+#define MM_CONTEXT_PROBE_CONCURRENCY_DEFAULT         16
+#define MM_CONTEXT_PROBE_CONCURRENCY_PER_HUB_DEFAULT 0
+
 gboolean     mm_context_get_debug                 (void);
 const gchar *mm_context_get_initial_kernel_events (void);
+guint        mm_context_get_kernel_event_debounce (void);
 gboolean     mm_context_get_no_auto_scan          (void);
+guint        mm_context_get_network_scan_cache_ttl (void);
+guint        mm_context_get_sms_send_interval     (void);
+const gchar *mm_context_get_metrics_file          (void);
+const gchar *mm_context_get_plugin_manifest       (void);
+guint        mm_context_get_boot_probe_concurrency (void);
+guint        mm_context_get_probe_concurrency      (void);
+guint        mm_context_get_probe_concurrency_per_hub (void);
+
+/* Updates of the DBus properties listing SMS and call objects. By default
+ * every change is reported right away. In the rate-limited mode changes
+ * happening in a short time are reported in a single property update; in the
+ * signals-only mode the properties are not updated at all, and clients are
+ * expected to rely on the Added/Deleted signals and on the List() methods. */
+typedef enum {
+    MM_LIST_PROPERTY_UPDATES_IMMEDIATE,
+    MM_LIST_PROPERTY_UPDATES_RATE_LIMITED,
+    MM_LIST_PROPERTY_UPDATES_SIGNALS_ONLY,
+} MMListPropertyUpdates;
+
+#define MM_LIST_PROPERTY_UPDATES_INTERVAL_MS 500
+
+MMListPropertyUpdates mm_context_get_list_property_updates (void);
 
 /* Filter support */
 MMFilterRule mm_context_get_filter_policy (void);
@@ -311,6 +311,7 @@ clear_modem (MMDevice *self)
          * if any (which also holds a reference to the modem object) */
         g_object_run_dispose (G_OBJECT (self->priv->modem));
         g_clear_object (&(self->priv->modem));
+        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MODEM]);
     }
 }
 
@@ -418,6 +419,7 @@ mm_device_create_modem (MMDevice                  *self,
                                                        "notify::" MM_BASE_MODEM_VALID,
                                                        G_CALLBACK (modem_valid),
                                                        self);
+        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MODEM]);
     }
 
     return !!self->priv->modem;
@@ -26,6 +26,7 @@
 #include "mm-base-modem.h"
 #include "mm-modem-helpers.h"
 #include "mm-error-helpers.h"
+#include "mm-context.h"
 #include "mm-log.h"
 
 #define REGISTRATION_CHECK_TIMEOUT_SEC 30
@@ -34,9 +35,13 @@
 
 #define REGISTRATION_STATE_CONTEXT_TAG    "3gpp-registration-state-context-tag"
 #define REGISTRATION_CHECK_CONTEXT_TAG    "3gpp-registration-check-context-tag"
+#define NETWORK_SCAN_CONTEXT_TAG          "3gpp-network-scan-context-tag"
 
 static GQuark registration_state_context_quark;
 static GQuark registration_check_context_quark;
+static GQuark network_scan_context_quark;
+
+static void network_scan_cache_clear (MMIfaceModem3gpp *self);
 
 /*****************************************************************************/
 
@@ -499,8 +504,11 @@ handle_register_ready (MMIfaceModem3gpp *self,
 
     if (!MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->register_in_network_finish (self, res,&error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        /* The availability reported for each network has changed */
+        network_scan_cache_clear (self);
         mm_gdbus_modem3gpp_complete_register (ctx->skeleton, ctx->invocation);
+    }
 
     handle_register_context_free (ctx);
 }
@@ -660,29 +668,159 @@ scan_networks_build_result (GList *info_list)
     return g_variant_ref (g_variant_builder_end (&builder));
 }
 
+/* Scan() requests are shared: a request received while a scan is running
+ * joins it instead of launching a new one (most modems would just reject it
+ * as busy). The results of the last scan may also be reused during a while
+ * (--network-scan-cache-ttl), as a full scan may take minutes. */
+
+typedef struct {
+    /* HandleScanContexts waiting for the ongoing scan */
+    GList *waiters;
+    gboolean running;
+    /* Results of the last successful scan */
+    GVariant *cached_result;
+    gint64 cached_time;
+} NetworkScanContext;
+
 static void
-handle_scan_ready (MMIfaceModem3gpp *self,
-                   GAsyncResult *res,
-                   HandleScanContext *ctx)
+network_scan_context_free (NetworkScanContext *ctx)
+{
+    /* Waiters keep the modem alive, so none may be left at this point */
+    g_assert (ctx->waiters == NULL);
+    if (ctx->cached_result)
+        g_variant_unref (ctx->cached_result);
+    g_slice_free (NetworkScanContext, ctx);
+}
+
+static NetworkScanContext *
+get_network_scan_context (MMIfaceModem3gpp *self)
 {
+    NetworkScanContext *ctx;
+
+    if (G_UNLIKELY (!network_scan_context_quark))
+        network_scan_context_quark = (g_quark_from_static_string (
+                                          NETWORK_SCAN_CONTEXT_TAG));
+
+    ctx = g_object_get_qdata (G_OBJECT (self), network_scan_context_quark);
+    if (!ctx) {
+        ctx = g_slice_new0 (NetworkScanContext);
+        g_object_set_qdata_full (
+            G_OBJECT (self),
+            network_scan_context_quark,
+            ctx,
+            (GDestroyNotify)network_scan_context_free);
+    }
+
+    return ctx;
+}
+
+static void
+network_scan_cache_clear (MMIfaceModem3gpp *self)
+{
+    NetworkScanContext *ctx;
+
+    if (G_UNLIKELY (!network_scan_context_quark))
+        return;
+
+    ctx = g_object_get_qdata (G_OBJECT (self), network_scan_context_quark);
+    if (ctx && ctx->cached_result) {
+        mm_dbg ("Network scan results cache cleared");
+        g_variant_unref (ctx->cached_result);
+        ctx->cached_result = NULL;
+    }
+}
+
+static void
+network_scan_ready (MMIfaceModem3gpp *self,
+                    GAsyncResult *res,
+                    gpointer user_data)
+{
+    NetworkScanContext *ctx;
     GError *error = NULL;
     GList *info_list;
+    GList *waiters;
+    GList *l;
+    GVariant *dict_array = NULL;
+    guint ttl;
 
-    info_list = MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->scan_networks_finish (self, res, &error);
-    if (error)
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else {
-        GVariant *dict_array;
+    ctx = get_network_scan_context (self);
 
+    info_list = MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->scan_networks_finish (self, res, &error);
+    if (!error) {
         dict_array = scan_networks_build_result (info_list);
-        mm_gdbus_modem3gpp_complete_scan (ctx->skeleton,
-                                          ctx->invocation,
-                                          dict_array);
+
+        if (ctx->cached_result) {
+            g_variant_unref (ctx->cached_result);
+            ctx->cached_result = NULL;
+        }
+        ttl = mm_context_get_network_scan_cache_ttl ();
+        if (ttl > 0) {
+            ctx->cached_result = g_variant_ref (dict_array);
+            ctx->cached_time = g_get_monotonic_time ();
+        }
+    }
+    mm_3gpp_network_info_list_free (info_list);
+
+    /* Detach the waiters before completing, so that new requests received
+     * from now on launch a new scan */
+    waiters = ctx->waiters;
+    ctx->waiters = NULL;
+    ctx->running = FALSE;
+
+    for (l = waiters; l; l = g_list_next (l)) {
+        HandleScanContext *waiter = l->data;
+
+        if (error)
+            g_dbus_method_invocation_return_gerror (waiter->invocation, error);
+        else
+            mm_gdbus_modem3gpp_complete_scan (waiter->skeleton,
+                                              waiter->invocation,
+                                              dict_array);
+        handle_scan_context_free (waiter);
+    }
+    g_list_free (waiters);
+
+    if (error)
+        g_error_free (error);
+    if (dict_array)
         g_variant_unref (dict_array);
+}
+
+static void
+network_scan_join (HandleScanContext *ctx)
+{
+    NetworkScanContext *scan;
+
+    scan = get_network_scan_context (ctx->self);
+
+    if (scan->cached_result) {
+        gint64 age_secs;
+
+        age_secs = (g_get_monotonic_time () - scan->cached_time) / G_USEC_PER_SEC;
+        if (age_secs < (gint64) mm_context_get_network_scan_cache_ttl ()) {
+            mm_dbg ("Reusing network scan results (%" G_GINT64_FORMAT "s old)", age_secs);
+            mm_gdbus_modem3gpp_complete_scan (ctx->skeleton,
+                                              ctx->invocation,
+                                              scan->cached_result);
+            handle_scan_context_free (ctx);
+            return;
+        }
+        g_variant_unref (scan->cached_result);
+        scan->cached_result = NULL;
     }
 
-    mm_3gpp_network_info_list_free (info_list);
-    handle_scan_context_free (ctx);
+    scan->waiters = g_list_append (scan->waiters, ctx);
+    if (scan->running) {
+        mm_dbg ("Network scan already in progress, joining it (%u requests waiting)",
+                g_list_length (scan->waiters));
+        return;
+    }
+
+    scan->running = TRUE;
+    MM_IFACE_MODEM_3GPP_GET_INTERFACE (ctx->self)->scan_networks (
+        ctx->self,
+        (GAsyncReadyCallback)network_scan_ready,
+        NULL);
 }
 
 static void
@@ -746,10 +884,7 @@ handle_scan_auth_ready (MMBaseModem *self,
     case MM_MODEM_STATE_DISCONNECTING:
     case MM_MODEM_STATE_CONNECTING:
     case MM_MODEM_STATE_CONNECTED:
-        MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->scan_networks (
-            MM_IFACE_MODEM_3GPP (self),
-            (GAsyncReadyCallback)handle_scan_ready,
-            ctx);
+        network_scan_join (ctx);
         return;
     }
 
@@ -1694,6 +1829,7 @@ static void interface_disabling_step (GTask *task);
 
 typedef enum {
     DISABLING_STEP_FIRST,
+    DISABLING_STEP_NETWORK_SCAN_CACHE,
     DISABLING_STEP_INITIAL_EPS_BEARER,
     DISABLING_STEP_PERIODIC_REGISTRATION_CHECKS,
     DISABLING_STEP_DISABLE_UNSOLICITED_REGISTRATION_EVENTS,
@@ -1770,6 +1906,11 @@ interface_disabling_step (GTask *task)
         /* Fall down to next step */
         ctx->step++;
 
+    case DISABLING_STEP_NETWORK_SCAN_CACHE:
+        network_scan_cache_clear (self);
+        /* Fall down to next step */
+        ctx->step++;
+
     case DISABLING_STEP_INITIAL_EPS_BEARER:
         mm_iface_modem_3gpp_update_initial_eps_bearer (self, NULL);
         /* Fall down to next step */
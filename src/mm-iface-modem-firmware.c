@@ -193,8 +193,10 @@ change_current_ready (MMIfaceModemFirmware *self,
 
     if (!MM_IFACE_MODEM_FIRMWARE_GET_INTERFACE (self)->change_current_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_iface_modem_info_cache_invalidate (MM_IFACE_MODEM (self), "firmware changed");
         mm_gdbus_modem_firmware_complete_select (ctx->skeleton, ctx->invocation);
+    }
     handle_select_context_free (ctx);
 }
 
@@ -20,15 +20,19 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-messaging.h"
 #include "mm-sms-list.h"
+#include "mm-broadband-modem.h"
+#include "mm-context.h"
 #include "mm-log.h"
 
 #define SUPPORT_CHECKED_TAG "messaging-support-checked-tag"
 #define SUPPORTED_TAG       "messaging-supported-tag"
 #define STORAGE_CONTEXT_TAG "messaging-storage-context-tag"
+#define SEND_QUEUE_TAG      "messaging-send-queue-tag"
 
 static GQuark support_checked_quark;
 static GQuark supported_quark;
 static GQuark storage_context_quark;
+static GQuark send_queue_quark;
 
 /*****************************************************************************/
 
@@ -489,15 +493,85 @@ mm_iface_modem_messaging_is_storage_supported_for_receiving (MMIfaceModemMessagi
 
 /*****************************************************************************/
 
+/* Pending update of the Messages property, stored in the skeleton */
+#define MESSAGE_LIST_UPDATE_TAG "message-list-update-tag"
+
+typedef struct {
+    MmGdbusModemMessaging *skeleton;
+    MMSmsList *list;
+    guint timeout_id;
+} MessageListUpdate;
+
+static void
+message_list_update_free (MessageListUpdate *update)
+{
+    if (update->timeout_id)
+        g_source_remove (update->timeout_id);
+    g_object_unref (update->list);
+    g_slice_free (MessageListUpdate, update);
+}
+
+static void
+message_list_update_complete (MessageListUpdate *update)
+{
+    mm_gdbus_modem_messaging_set_messages (update->skeleton, mm_sms_list_peek_paths (update->list));
+    /* Disposes the update */
+    g_object_set_data (G_OBJECT (update->skeleton), MESSAGE_LIST_UPDATE_TAG, NULL);
+}
+
+static gboolean
+message_list_update_timeout (MessageListUpdate *update)
+{
+    update->timeout_id = 0;
+    message_list_update_complete (update);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+flush_message_list_update (MmGdbusModemMessaging *skeleton)
+{
+    MessageListUpdate *update;
+
+    update = g_object_get_data (G_OBJECT (skeleton), MESSAGE_LIST_UPDATE_TAG);
+    if (!update)
+        return;
+
+    g_source_remove (update->timeout_id);
+    update->timeout_id = 0;
+    message_list_update_complete (update);
+}
+
 static void
 update_message_list (MmGdbusModemMessaging *skeleton,
                      MMSmsList *list)
 {
-    gchar **paths;
+    MessageListUpdate *update;
 
-    paths = mm_sms_list_get_paths (list);
-    mm_gdbus_modem_messaging_set_messages (skeleton, (const gchar *const *)paths);
-    g_strfreev (paths);
+    switch (mm_context_get_list_property_updates ()) {
+    case MM_LIST_PROPERTY_UPDATES_IMMEDIATE:
+        mm_gdbus_modem_messaging_set_messages (skeleton, mm_sms_list_peek_paths (list));
+        return;
+    case MM_LIST_PROPERTY_UPDATES_SIGNALS_ONLY:
+        return;
+    case MM_LIST_PROPERTY_UPDATES_RATE_LIMITED:
+        /* If an update is already scheduled, it will include this change */
+        if (g_object_get_data (G_OBJECT (skeleton), MESSAGE_LIST_UPDATE_TAG))
+            return;
+
+        update = g_slice_new0 (MessageListUpdate);
+        update->skeleton = skeleton;
+        update->list = g_object_ref (list);
+        update->timeout_id = g_timeout_add (MM_LIST_PROPERTY_UPDATES_INTERVAL_MS,
+                                            (GSourceFunc)message_list_update_timeout,
+                                            update);
+        g_object_set_data_full (G_OBJECT (skeleton),
+                                MESSAGE_LIST_UPDATE_TAG,
+                                update,
+                                (GDestroyNotify)message_list_update_free);
+        return;
+    }
+
+    g_assert_not_reached ();
 }
 
 static void
@@ -523,6 +597,362 @@ sms_deleted (MMSmsList *list,
     mm_gdbus_modem_messaging_emit_deleted (skeleton, sms_path);
 }
 
+/*****************************************************************************/
+/* SMS send queue
+ *
+ * Send requests are processed one by one per modem, so that the commands of
+ * different messages never interleave. Consecutive messages sent from the
+ * same storage reuse a single storage lock, which is only released once the
+ * queue no longer needs it. Errors which surely happened before the message
+ * was submitted to the network are retried with an exponential backoff; any
+ * other error is reported right away, as retrying could send the message
+ * twice. An optional minimum interval between messages may be set by plugins
+ * or with the --sms-send-interval daemon option. */
+
+#define SEND_QUEUE_MAX_RETRIES      3
+#define SEND_QUEUE_RETRY_TIMEOUT_MS 1000
+
+typedef struct {
+    MMIfaceModemMessaging *self;
+    GQueue *pending;
+    GTask *current;
+    MMSmsStorage locked_storage;
+    gint64 last_send_time;
+    guint timeout_id;
+    gboolean aborting;
+    guint n_sent;
+    guint n_failed;
+} SendQueue;
+
+typedef struct {
+    MMBaseSms *sms;
+    guint n_retries;
+} SendQueueItem;
+
+static void send_queue_process_next (SendQueue *queue);
+
+static void
+send_queue_item_free (SendQueueItem *item)
+{
+    g_object_unref (item->sms);
+    g_slice_free (SendQueueItem, item);
+}
+
+static void
+send_queue_free (SendQueue *queue)
+{
+    /* Pending items hold a reference to the modem, so the queue can only be
+     * disposed once empty */
+    g_assert (g_queue_is_empty (queue->pending));
+    g_assert (!queue->current);
+    g_assert (!queue->timeout_id);
+    g_queue_free (queue->pending);
+    g_slice_free (SendQueue, queue);
+}
+
+static SendQueue *
+get_send_queue (MMIfaceModemMessaging *self)
+{
+    SendQueue *queue;
+
+    if (G_UNLIKELY (!send_queue_quark))
+        send_queue_quark = g_quark_from_static_string (SEND_QUEUE_TAG);
+
+    queue = g_object_get_qdata (G_OBJECT (self), send_queue_quark);
+    if (!queue) {
+        queue = g_slice_new0 (SendQueue);
+        queue->self = self;
+        queue->pending = g_queue_new ();
+        queue->locked_storage = MM_SMS_STORAGE_UNKNOWN;
+        g_object_set_qdata_full (G_OBJECT (self),
+                                 send_queue_quark,
+                                 queue,
+                                 (GDestroyNotify)send_queue_free);
+    }
+
+    return queue;
+}
+
+static void
+send_queue_update_stats (SendQueue *queue)
+{
+    MmGdbusModemMessaging *skeleton = NULL;
+
+    g_object_get (queue->self,
+                  MM_IFACE_MODEM_MESSAGING_DBUS_SKELETON, &skeleton,
+                  NULL);
+    if (!skeleton)
+        return;
+
+    mm_gdbus_modem_messaging_set_send_queue_depth (skeleton,
+                                                   g_queue_get_length (queue->pending) + (queue->current ? 1 : 0));
+    mm_gdbus_modem_messaging_set_send_queue_sent (skeleton, queue->n_sent);
+    mm_gdbus_modem_messaging_set_send_queue_failed (skeleton, queue->n_failed);
+    g_object_unref (skeleton);
+}
+
+static void
+send_queue_unlock_storage (SendQueue *queue)
+{
+    if (queue->locked_storage == MM_SMS_STORAGE_UNKNOWN)
+        return;
+
+    mm_broadband_modem_unlock_sms_storages (MM_BROADBAND_MODEM (queue->self), FALSE, TRUE);
+    queue->locked_storage = MM_SMS_STORAGE_UNKNOWN;
+}
+
+static gboolean
+send_queue_timeout (SendQueue *queue)
+{
+    MMIfaceModemMessaging *self = queue->self;
+
+    queue->timeout_id = 0;
+    send_queue_process_next (queue);
+    g_object_unref (self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+send_queue_schedule (SendQueue *queue,
+                     guint      timeout_ms)
+{
+    g_assert (!queue->timeout_id);
+    queue->timeout_id = g_timeout_add (timeout_ms, (GSourceFunc)send_queue_timeout, queue);
+    /* The modem must be valid until the timeout is dispatched */
+    g_object_ref (queue->self);
+}
+
+static gboolean
+send_queue_error_is_transient (const GError *error)
+{
+    /* Storage lock held by another operation */
+    if (g_error_matches (error, MM_CORE_ERROR, MM_CORE_ERROR_RETRY))
+        return TRUE;
+
+    /* SIM (i.e. storage) busy, reported before the message is submitted. Any
+     * other error may happen once the network already got the message */
+    if (g_error_matches (error, MM_MESSAGE_ERROR, MM_MESSAGE_ERROR_SIM_BUSY) ||
+        g_error_matches (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_SIM_BUSY))
+        return TRUE;
+
+    return FALSE;
+}
+
+static void
+send_queue_complete_current (SendQueue *queue,
+                             GError    *error)
+{
+    GTask *task;
+
+    task = queue->current;
+    queue->current = NULL;
+    queue->last_send_time = g_get_monotonic_time ();
+    /* The pending messages were already failed when aborting */
+    queue->aborting = FALSE;
+
+    if (error) {
+        queue->n_failed++;
+        g_task_return_error (task, error);
+    } else {
+        queue->n_sent++;
+        g_task_return_boolean (task, TRUE);
+    }
+    g_object_unref (task);
+
+    send_queue_update_stats (queue);
+    send_queue_process_next (queue);
+}
+
+static gboolean
+send_queue_retry_current (SendQueue *queue,
+                          GError    *error)
+{
+    SendQueueItem *item;
+    guint          timeout_ms;
+
+    /* Not retried once the interface is being disabled */
+    if (queue->aborting)
+        return FALSE;
+
+    item = g_task_get_task_data (queue->current);
+    if (!send_queue_error_is_transient (error) || item->n_retries >= SEND_QUEUE_MAX_RETRIES)
+        return FALSE;
+
+    timeout_ms = SEND_QUEUE_RETRY_TIMEOUT_MS << item->n_retries;
+    item->n_retries++;
+    mm_dbg ("Couldn't send SMS (%s), retrying in %ums (%u/%u)",
+            error->message, timeout_ms, item->n_retries, SEND_QUEUE_MAX_RETRIES);
+    g_error_free (error);
+
+    /* Back to the head of the queue, so that ordering is kept */
+    g_queue_push_head (queue->pending, queue->current);
+    queue->current = NULL;
+
+    /* Don't keep the storage locked while waiting */
+    send_queue_unlock_storage (queue);
+    send_queue_schedule (queue, timeout_ms);
+    return TRUE;
+}
+
+static void
+send_queue_sms_send_ready (MMBaseSms    *sms,
+                           GAsyncResult *res,
+                           SendQueue    *queue)
+{
+    GError *error = NULL;
+
+    if (!mm_base_sms_send_finish (sms, res, &error) &&
+        send_queue_retry_current (queue, error))
+        return;
+
+    send_queue_complete_current (queue, error);
+}
+
+static void
+send_queue_send_current (SendQueue *queue)
+{
+    SendQueueItem *item;
+
+    item = g_task_get_task_data (queue->current);
+    mm_base_sms_send (item->sms,
+                      queue->locked_storage != MM_SMS_STORAGE_UNKNOWN,
+                      (GAsyncReadyCallback)send_queue_sms_send_ready,
+                      queue);
+}
+
+static void
+send_queue_lock_storages_ready (MMBroadbandModem *modem,
+                                GAsyncResult     *res,
+                                SendQueue        *queue)
+{
+    SendQueueItem *item;
+    GError        *error = NULL;
+
+    if (!mm_broadband_modem_lock_sms_storages_finish (modem, res, &error)) {
+        if (!send_queue_retry_current (queue, error))
+            send_queue_complete_current (queue, error);
+        return;
+    }
+
+    item = g_task_get_task_data (queue->current);
+    queue->locked_storage = mm_base_sms_get_send_lock_storage (item->sms);
+    send_queue_send_current (queue);
+}
+
+static void
+send_queue_process_next (SendQueue *queue)
+{
+    SendQueueItem *item;
+    MMSmsStorage   storage;
+    guint          interval = 0;
+
+    /* Already busy */
+    if (queue->current || queue->timeout_id)
+        return;
+
+    if (g_queue_is_empty (queue->pending)) {
+        send_queue_unlock_storage (queue);
+        return;
+    }
+
+    /* Rate limit, if any; the strictest of the plugin and the user one */
+    g_object_get (queue->self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_SEND_INTERVAL, &interval,
+                  NULL);
+    interval = MAX (interval, mm_context_get_sms_send_interval ());
+    if (interval && queue->last_send_time) {
+        gint64 elapsed_ms;
+
+        elapsed_ms = (g_get_monotonic_time () - queue->last_send_time) / 1000;
+        if (elapsed_ms < interval) {
+            /* Don't keep the storage locked while waiting */
+            send_queue_unlock_storage (queue);
+            send_queue_schedule (queue, interval - elapsed_ms);
+            return;
+        }
+    }
+
+    queue->current = g_queue_pop_head (queue->pending);
+    item = g_task_get_task_data (queue->current);
+
+    /* Keep the storage lock while consecutive messages use the same one */
+    storage = mm_base_sms_get_send_lock_storage (item->sms);
+    if (storage != queue->locked_storage)
+        send_queue_unlock_storage (queue);
+
+    if (storage != MM_SMS_STORAGE_UNKNOWN && queue->locked_storage == MM_SMS_STORAGE_UNKNOWN) {
+        g_assert (MM_IS_BROADBAND_MODEM (queue->self));
+        mm_broadband_modem_lock_sms_storages (MM_BROADBAND_MODEM (queue->self),
+                                              MM_SMS_STORAGE_UNKNOWN, /* none required for mem1 */
+                                              storage,
+                                              (GAsyncReadyCallback)send_queue_lock_storages_ready,
+                                              queue);
+        return;
+    }
+
+    send_queue_send_current (queue);
+}
+
+static void
+send_queue_abort (SendQueue *queue)
+{
+    GTask *task;
+
+    if (queue->timeout_id) {
+        g_source_remove (queue->timeout_id);
+        queue->timeout_id = 0;
+        g_object_unref (queue->self);
+    }
+
+    /* The message currently being sent, if any, can't be cancelled; it is
+     * left to complete, but it won't be retried */
+    if (queue->current)
+        queue->aborting = TRUE;
+
+    while ((task = g_queue_pop_head (queue->pending)) != NULL) {
+        queue->n_failed++;
+        g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_ABORTED,
+                                 "SMS sending aborted: messaging interface disabled");
+        g_object_unref (task);
+    }
+
+    if (!queue->current)
+        send_queue_unlock_storage (queue);
+    send_queue_update_stats (queue);
+}
+
+gboolean
+mm_iface_modem_messaging_send_sms_finish (MMIfaceModemMessaging  *self,
+                                          GAsyncResult           *res,
+                                          GError                **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+void
+mm_iface_modem_messaging_send_sms (MMIfaceModemMessaging *self,
+                                   MMBaseSms             *sms,
+                                   GAsyncReadyCallback    callback,
+                                   gpointer               user_data)
+{
+    SendQueue     *queue;
+    SendQueueItem *item;
+    GTask         *task;
+
+    queue = get_send_queue (self);
+
+    item = g_slice_new0 (SendQueueItem);
+    item->sms = g_object_ref (sms);
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, item, (GDestroyNotify)send_queue_item_free);
+    g_queue_push_tail (queue->pending, task);
+
+    mm_dbg ("SMS send request queued (%u pending)", g_queue_get_length (queue->pending));
+    send_queue_update_stats (queue);
+    send_queue_process_next (queue);
+}
+
 /*****************************************************************************/
 
 typedef struct _DisablingContext DisablingContext;
@@ -609,6 +1039,8 @@ interface_disabling_step (GTask *task)
 
     switch (ctx->step) {
     case DISABLING_STEP_FIRST:
+        /* Fail any SMS still waiting to be sent */
+        send_queue_abort (get_send_queue (self));
         /* Fall down to next step */
         ctx->step++;
 
@@ -639,6 +1071,9 @@ interface_disabling_step (GTask *task)
         ctx->step++;
 
     case DISABLING_STEP_LAST:
+        /* Report any pending change in the SMS list before clearing it */
+        flush_message_list_update (ctx->skeleton);
+
         /* Clear SMS list */
         g_object_set (self,
                       MM_IFACE_MODEM_MESSAGING_SMS_LIST, NULL,
@@ -1472,6 +1907,14 @@ iface_modem_messaging_init (gpointer g_iface)
                             MM_SMS_STORAGE_ME,
                             G_PARAM_READWRITE));
 
+    g_object_interface_install_property
+        (g_iface,
+         g_param_spec_uint (MM_IFACE_MODEM_MESSAGING_SMS_SEND_INTERVAL,
+                            "SMS send interval",
+                            "Minimum time between consecutive SMS messages sent, in ms",
+                            0, G_MAXUINT, 0,
+                            G_PARAM_READWRITE));
+
     initialized = TRUE;
 }
 
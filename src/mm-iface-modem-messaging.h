@@ -34,6 +34,7 @@
 #define MM_IFACE_MODEM_MESSAGING_SMS_LIST            "iface-modem-messaging-sms-list"
 #define MM_IFACE_MODEM_MESSAGING_SMS_PDU_MODE        "iface-modem-messaging-sms-pdu-mode"
 #define MM_IFACE_MODEM_MESSAGING_SMS_DEFAULT_STORAGE "iface-modem-messaging-sms-default-storage"
+#define MM_IFACE_MODEM_MESSAGING_SMS_SEND_INTERVAL   "iface-modem-messaging-sms-send-interval"
 
 typedef struct _MMIfaceModemMessaging MMIfaceModemMessaging;
 
@@ -185,6 +186,15 @@ gboolean mm_iface_modem_messaging_is_storage_supported_for_receiving (MMIfaceMod
 /* SMS creation */
 MMBaseSms *mm_iface_modem_messaging_create_sms (MMIfaceModemMessaging *self);
 
+/* Queue a SMS to be sent */
+void     mm_iface_modem_messaging_send_sms        (MMIfaceModemMessaging *self,
+                                                   MMBaseSms *sms,
+                                                   GAsyncReadyCallback callback,
+                                                   gpointer user_data);
+gboolean mm_iface_modem_messaging_send_sms_finish (MMIfaceModemMessaging *self,
+                                                   GAsyncResult *res,
+                                                   GError **error);
+
 /* Look for a new valid multipart reference */
 guint8 mm_iface_modem_messaging_get_local_multipart_reference (MMIfaceModemMessaging *self,
                                                                const gchar *number,
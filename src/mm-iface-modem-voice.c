@@ -20,6 +20,7 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-voice.h"
 #include "mm-call-list.h"
+#include "mm-context.h"
 #include "mm-log.h"
 
 #define SUPPORT_CHECKED_TAG "voice-support-checked-tag"
@@ -368,17 +369,92 @@ handle_list (MmGdbusModemVoice *skeleton,
 
 /*****************************************************************************/
 
+/* Pending update of the Calls property, stored in the skeleton */
+#define CALL_LIST_UPDATE_TAG "call-list-update-tag"
+
+typedef struct {
+    MmGdbusModemVoice *skeleton;
+    MMCallList *list;
+    guint timeout_id;
+} CallListUpdate;
+
+static void
+call_list_update_free (CallListUpdate *update)
+{
+    if (update->timeout_id)
+        g_source_remove (update->timeout_id);
+    g_object_unref (update->list);
+    g_slice_free (CallListUpdate, update);
+}
+
+static void
+set_call_list (MmGdbusModemVoice *skeleton,
+               MMCallList *list)
+{
+    mm_gdbus_modem_voice_set_calls (skeleton, mm_call_list_peek_paths (list));
+    g_dbus_interface_skeleton_flush (G_DBUS_INTERFACE_SKELETON (skeleton));
+}
+
+static void
+call_list_update_complete (CallListUpdate *update)
+{
+    set_call_list (update->skeleton, update->list);
+    /* Disposes the update */
+    g_object_set_data (G_OBJECT (update->skeleton), CALL_LIST_UPDATE_TAG, NULL);
+}
+
+static gboolean
+call_list_update_timeout (CallListUpdate *update)
+{
+    update->timeout_id = 0;
+    call_list_update_complete (update);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+flush_call_list_update (MmGdbusModemVoice *skeleton)
+{
+    CallListUpdate *update;
+
+    update = g_object_get_data (G_OBJECT (skeleton), CALL_LIST_UPDATE_TAG);
+    if (!update)
+        return;
+
+    g_source_remove (update->timeout_id);
+    update->timeout_id = 0;
+    call_list_update_complete (update);
+}
+
 static void
 update_message_list (MmGdbusModemVoice *skeleton,
                      MMCallList *list)
 {
-    gchar **paths;
+    CallListUpdate *update;
 
-    paths = mm_call_list_get_paths (list);
-    mm_gdbus_modem_voice_set_calls (skeleton, (const gchar *const *)paths);
-    g_strfreev (paths);
+    switch (mm_context_get_list_property_updates ()) {
+    case MM_LIST_PROPERTY_UPDATES_IMMEDIATE:
+        set_call_list (skeleton, list);
+        return;
+    case MM_LIST_PROPERTY_UPDATES_SIGNALS_ONLY:
+        return;
+    case MM_LIST_PROPERTY_UPDATES_RATE_LIMITED:
+        if (g_object_get_data (G_OBJECT (skeleton), CALL_LIST_UPDATE_TAG))
+            return;
 
-    g_dbus_interface_skeleton_flush (G_DBUS_INTERFACE_SKELETON (skeleton));
+        update = g_slice_new0 (CallListUpdate);
+        update->skeleton = skeleton;
+        update->list = g_object_ref (list);
+        update->timeout_id = g_timeout_add (MM_LIST_PROPERTY_UPDATES_INTERVAL_MS,
+                                            (GSourceFunc)call_list_update_timeout,
+                                            update);
+        g_object_set_data_full (G_OBJECT (skeleton),
+                                CALL_LIST_UPDATE_TAG,
+                                update,
+                                (GDestroyNotify)call_list_update_free);
+        return;
+    }
+
+    g_assert_not_reached ();
 }
 
 static void
@@ -517,6 +593,8 @@ interface_disabling_step (GTask *task)
         ctx->step++;
 
     case DISABLING_STEP_LAST:
+        flush_call_list_update (ctx->skeleton);
+
         /* Clear CALL list */
         g_object_set (self,
                       MM_IFACE_MODEM_VOICE_CALL_LIST, NULL,
@@ -26,6 +26,8 @@
 #include "mm-base-modem-at.h"
 #include "mm-base-sim.h"
 #include "mm-bearer-list.h"
+#include "mm-modem-info-cache.h"
+#include "mm-trace.h"
 #include "mm-log.h"
 #include "mm-context.h"
 
@@ -2044,8 +2046,10 @@ handle_factory_reset_ready (MMIfaceModem *self,
 
     if (!MM_IFACE_MODEM_GET_INTERFACE (self)->factory_reset_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_iface_modem_info_cache_invalidate (self, "factory reset");
         mm_gdbus_modem_complete_factory_reset (ctx->skeleton, ctx->invocation);
+    }
 
     handle_factory_reset_context_free (ctx);
 }
@@ -3939,6 +3943,7 @@ typedef enum {
     INITIALIZATION_STEP_CURRENT_CAPABILITIES,
     INITIALIZATION_STEP_SUPPORTED_CAPABILITIES,
     INITIALIZATION_STEP_BEARERS,
+    INITIALIZATION_STEP_INFO_CACHE_LOOKUP,
     INITIALIZATION_STEP_MANUFACTURER,
     INITIALIZATION_STEP_MODEL,
     INITIALIZATION_STEP_REVISION,
@@ -3947,6 +3952,7 @@ typedef enum {
     INITIALIZATION_STEP_DEVICE_ID,
     INITIALIZATION_STEP_SUPPORTED_MODES,
     INITIALIZATION_STEP_SUPPORTED_BANDS,
+    INITIALIZATION_STEP_INFO_CACHE_STORE,
     INITIALIZATION_STEP_SUPPORTED_IP_FAMILIES,
     INITIALIZATION_STEP_POWER_STATE,
     INITIALIZATION_STEP_SIM_HOT_SWAP,
@@ -3962,12 +3968,17 @@ struct _InitializationContext {
     InitializationStep step;
     MmGdbusModem *skeleton;
     GError *fatal_error;
+    gboolean info_cache_enabled;
+    gboolean info_cache_supported_enabled;
+    gboolean info_cache_store;
+    MMTraceSequence trace;
 };
 
 static void
 initialization_context_free (InitializationContext *ctx)
 {
     g_assert (ctx->fatal_error == NULL);
+    mm_trace_sequence_clear (&ctx->trace);
     g_object_unref (ctx->skeleton);
     g_free (ctx);
 }
@@ -4166,6 +4177,177 @@ STR_REPLY_READY_FN (hardware_revision, "HardwareRevision")
 STR_REPLY_READY_FN (equipment_identifier, "Equipment Identifier")
 STR_REPLY_READY_FN (device_identifier, "Device Identifier")
 
+static void
+info_cache_restore (MMIfaceModem *self,
+                    InitializationContext *ctx,
+                    const MMModemInfo *info)
+{
+    gboolean partial = FALSE;
+
+    mm_dbg ("Using cached modem info");
+
+    /* Only values not loaded yet are set; any value missing in the cache
+     * will be loaded in its own step */
+#define RESTORE_STR(NAME)                                               \
+    if (!mm_gdbus_modem_get_##NAME (ctx->skeleton)) {                   \
+        mm_gdbus_modem_set_##NAME (ctx->skeleton, info->NAME);          \
+        partial |= !info->NAME;                                         \
+    }
+    RESTORE_STR (manufacturer)
+    RESTORE_STR (model)
+    RESTORE_STR (hardware_revision)
+    RESTORE_STR (device_identifier)
+#undef RESTORE_STR
+
+    if (ctx->info_cache_supported_enabled) {
+        if (info->supported_modes)
+            mm_gdbus_modem_set_supported_modes (ctx->skeleton,
+                                                mm_common_mode_combinations_garray_to_variant (info->supported_modes));
+        if (info->supported_bands)
+            mm_gdbus_modem_set_supported_bands (ctx->skeleton,
+                                                mm_common_bands_garray_to_variant (info->supported_bands));
+        partial |= (!info->supported_modes || !info->supported_bands);
+    }
+
+    /* Values loaded because they were missing in the cache (e.g. expired
+     * supported modes and bands) are stored back into the entry */
+    ctx->info_cache_store = partial;
+}
+
+static void
+info_cache_load_equipment_identifier_ready (MMIfaceModem *self,
+                                            GAsyncResult *res,
+                                            GTask *task)
+{
+    InitializationContext *ctx;
+    const MMModemInfo *info;
+    const gchar *uid;
+    GError *error = NULL;
+    gchar *equipment_identifier;
+
+    ctx = g_task_get_task_data (task);
+    uid = mm_base_modem_get_device (MM_BASE_MODEM (self));
+
+    equipment_identifier = MM_IFACE_MODEM_GET_INTERFACE (self)->load_equipment_identifier_finish (self, res, &error);
+    if (!equipment_identifier) {
+        /* The equipment identifier step will retry */
+        mm_dbg ("couldn't load equipment identifier to validate cached modem info: '%s'",
+                error ? error->message : "unknown error");
+        g_clear_error (&error);
+        ctx->step++;
+        interface_initialization_step (task);
+        return;
+    }
+
+    /* Keep it, no need to load it again even if the cached info is not
+     * reused */
+    mm_gdbus_modem_set_equipment_identifier (ctx->skeleton, equipment_identifier);
+
+    /* A different device of the same model may have been plugged in the
+     * same port, so the cached info is only reused if the equipment
+     * identifier matches */
+    info = mm_modem_info_cache_peek (uid, mm_gdbus_modem_get_revision (ctx->skeleton));
+    if (info) {
+        if (g_strcmp0 (info->equipment_identifier, equipment_identifier) == 0)
+            info_cache_restore (self, ctx, info);
+        else
+            mm_modem_info_cache_invalidate (uid, "equipment identifier changed");
+    }
+    g_free (equipment_identifier);
+
+    ctx->step++;
+    interface_initialization_step (task);
+}
+
+static void
+info_cache_load_revision_ready (MMIfaceModem *self,
+                                GAsyncResult *res,
+                                GTask *task)
+{
+    InitializationContext *ctx;
+    const MMModemInfo *info;
+    GError *error = NULL;
+    gchar *revision;
+
+    ctx = g_task_get_task_data (task);
+
+    revision = MM_IFACE_MODEM_GET_INTERFACE (self)->load_revision_finish (self, res, &error);
+    if (!revision) {
+        /* The revision step will retry */
+        mm_dbg ("couldn't load revision to validate cached modem info: '%s'",
+                error ? error->message : "unknown error");
+        g_clear_error (&error);
+        ctx->step++;
+        interface_initialization_step (task);
+        return;
+    }
+
+    /* Keep the revision, no need to load it again even if the cached info is
+     * no longer valid */
+    mm_gdbus_modem_set_revision (ctx->skeleton, revision);
+
+    info = mm_modem_info_cache_peek (mm_base_modem_get_device (MM_BASE_MODEM (self)), revision);
+    g_free (revision);
+
+    /* Entries without equipment identifier can't be validated */
+    if (info &&
+        info->equipment_identifier &&
+        MM_IFACE_MODEM_GET_INTERFACE (self)->load_equipment_identifier &&
+        MM_IFACE_MODEM_GET_INTERFACE (self)->load_equipment_identifier_finish) {
+        MM_IFACE_MODEM_GET_INTERFACE (self)->load_equipment_identifier (
+            self,
+            (GAsyncReadyCallback)info_cache_load_equipment_identifier_ready,
+            task);
+        return;
+    }
+
+    ctx->step++;
+    interface_initialization_step (task);
+}
+
+static void
+info_cache_store (MMIfaceModem *self,
+                  InitializationContext *ctx)
+{
+    MMModemInfo *info;
+
+    info = mm_modem_info_new ();
+    info->manufacturer = g_strdup (mm_gdbus_modem_get_manufacturer (ctx->skeleton));
+    info->model = g_strdup (mm_gdbus_modem_get_model (ctx->skeleton));
+    info->revision = g_strdup (mm_gdbus_modem_get_revision (ctx->skeleton));
+    info->hardware_revision = g_strdup (mm_gdbus_modem_get_hardware_revision (ctx->skeleton));
+    info->equipment_identifier = g_strdup (mm_gdbus_modem_get_equipment_identifier (ctx->skeleton));
+    info->device_identifier = g_strdup (mm_gdbus_modem_get_device_identifier (ctx->skeleton));
+
+    if (ctx->info_cache_supported_enabled) {
+        GArray *modes;
+        GArray *bands;
+
+        /* Default values are never cached, so that they're loaded again */
+        modes = mm_common_mode_combinations_variant_to_garray (mm_gdbus_modem_get_supported_modes (ctx->skeleton));
+        if (modes->len > 1 ||
+            (modes->len == 1 &&
+             (g_array_index (modes, MMModemModeCombination, 0).allowed != MM_MODEM_MODE_ANY ||
+              g_array_index (modes, MMModemModeCombination, 0).preferred != MM_MODEM_MODE_NONE)))
+            info->supported_modes = g_array_ref (modes);
+        g_array_unref (modes);
+
+        bands = mm_common_bands_variant_to_garray (mm_gdbus_modem_get_supported_bands (ctx->skeleton));
+        if (bands->len > 0 && g_array_index (bands, MMModemBand, 0) != MM_MODEM_BAND_UNKNOWN)
+            info->supported_bands = g_array_ref (bands);
+        g_array_unref (bands);
+    }
+
+    mm_modem_info_cache_store (mm_base_modem_get_device (MM_BASE_MODEM (self)), info);
+}
+
+void
+mm_iface_modem_info_cache_invalidate (MMIfaceModem *self,
+                                      const gchar *reason)
+{
+    mm_modem_info_cache_invalidate (mm_base_modem_get_device (MM_BASE_MODEM (self)), reason);
+}
+
 static void
 load_supported_modes_ready (MMIfaceModem *self,
                             GAsyncResult *res,
@@ -4495,6 +4677,7 @@ interface_initialization_step (GTask *task)
 
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
+        mm_trace_sequence_step (&ctx->trace, "device");
         /* Load device if not done before */
         if (!mm_gdbus_modem_get_device (ctx->skeleton)) {
             gchar *device;
@@ -4555,6 +4738,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_CURRENT_CAPABILITIES:
+        mm_trace_sequence_step (&ctx->trace, "current-capabilities");
         /* Current capabilities may change during runtime, i.e. if new firmware reloaded; but we'll
          * try to handle that by making sure the capabilities are cleared when the new firmware is
          * reloaded. So if we're asked to re-initialize, if we already have current capabilities loaded,
@@ -4574,6 +4758,8 @@ interface_initialization_step (GTask *task)
     case INITIALIZATION_STEP_SUPPORTED_CAPABILITIES: {
         GArray *supported_capabilities;
 
+        mm_trace_sequence_step (&ctx->trace, "supported-capabilities");
+
         supported_capabilities = (mm_common_capability_combinations_variant_to_garray (
                                       mm_gdbus_modem_get_supported_capabilities (ctx->skeleton)));
 
@@ -4612,6 +4798,8 @@ interface_initialization_step (GTask *task)
     case INITIALIZATION_STEP_BEARERS: {
         MMBearerList *list = NULL;
 
+        mm_trace_sequence_step (&ctx->trace, "bearers");
+
         /* Bearers setup is meant to be loaded only once during the whole
          * lifetime of the modem. The list may have been created by the object
          * implementing the interface; if so use it. */
@@ -4652,7 +4840,28 @@ interface_initialization_step (GTask *task)
         ctx->step++;
     }
 
+    case INITIALIZATION_STEP_INFO_CACHE_LOOKUP:
+        mm_trace_sequence_step (&ctx->trace, "info-cache-lookup");
+        /* If we already know this device (e.g. reprobed, or reset), the info
+         * loaded during the last initialization may be reused, as long as the
+         * firmware revision didn't change. */
+        if (ctx->info_cache_enabled && mm_gdbus_modem_get_revision (ctx->skeleton) == NULL)
+            ctx->info_cache_store = TRUE;
+        if (ctx->info_cache_store &&
+            MM_IFACE_MODEM_GET_INTERFACE (self)->load_revision &&
+            MM_IFACE_MODEM_GET_INTERFACE (self)->load_revision_finish &&
+            mm_modem_info_cache_peek (mm_base_modem_get_device (MM_BASE_MODEM (self)), NULL)) {
+            MM_IFACE_MODEM_GET_INTERFACE (self)->load_revision (
+                self,
+                (GAsyncReadyCallback)info_cache_load_revision_ready,
+                task);
+            return;
+        }
+        /* Fall down to next step */
+        ctx->step++;
+
     case INITIALIZATION_STEP_MANUFACTURER:
+        mm_trace_sequence_step (&ctx->trace, "manufacturer");
         /* Manufacturer is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4669,6 +4878,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_MODEL:
+        mm_trace_sequence_step (&ctx->trace, "model");
         /* Model is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4685,6 +4895,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_REVISION:
+        mm_trace_sequence_step (&ctx->trace, "revision");
         /* Revision is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4701,6 +4912,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_HARDWARE_REVISION:
+        mm_trace_sequence_step (&ctx->trace, "hardware-revision");
         /* HardwareRevision is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4717,6 +4929,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_EQUIPMENT_ID:
+        mm_trace_sequence_step (&ctx->trace, "equipment-id");
         /* Equipment ID is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4733,6 +4946,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_DEVICE_ID:
+        mm_trace_sequence_step (&ctx->trace, "device-id");
         /* Device ID is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4749,6 +4963,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_SUPPORTED_MODES:
+        mm_trace_sequence_step (&ctx->trace, "supported-modes");
         if (MM_IFACE_MODEM_GET_INTERFACE (self)->load_supported_modes != NULL &&
             MM_IFACE_MODEM_GET_INTERFACE (self)->load_supported_modes_finish != NULL) {
             GArray *supported_modes;
@@ -4780,6 +4995,8 @@ interface_initialization_step (GTask *task)
     case INITIALIZATION_STEP_SUPPORTED_BANDS: {
         GArray *supported_bands;
 
+        mm_trace_sequence_step (&ctx->trace, "supported-bands");
+
         supported_bands = (mm_common_bands_variant_to_garray (
                                mm_gdbus_modem_get_supported_bands (ctx->skeleton)));
 
@@ -4808,7 +5025,17 @@ interface_initialization_step (GTask *task)
         ctx->step++;
     }
 
+    case INITIALIZATION_STEP_INFO_CACHE_STORE:
+        mm_trace_sequence_step (&ctx->trace, "info-cache-store");
+        /* Stored unless everything was restored from the cache. Storing again
+         * doesn't extend the lifetime of the identity info of the entry */
+        if (ctx->info_cache_store && mm_gdbus_modem_get_revision (ctx->skeleton) != NULL)
+            info_cache_store (self, ctx);
+        /* Fall down to next step */
+        ctx->step++;
+
     case INITIALIZATION_STEP_SUPPORTED_IP_FAMILIES:
+        mm_trace_sequence_step (&ctx->trace, "supported-ip-families");
         /* Supported ip_families are meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4825,6 +5052,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_POWER_STATE:
+        mm_trace_sequence_step (&ctx->trace, "power-state");
         /* Initial power state is meant to be loaded only once. Therefore, if we
          * already have it loaded, don't try to load it again. */
         if (mm_gdbus_modem_get_power_state (ctx->skeleton) == MM_MODEM_POWER_STATE_UNKNOWN) {
@@ -4844,6 +5072,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_SIM_HOT_SWAP:
+        mm_trace_sequence_step (&ctx->trace, "sim-hot-swap");
         if (MM_IFACE_MODEM_GET_INTERFACE (self)->setup_sim_hot_swap &&
             MM_IFACE_MODEM_GET_INTERFACE (self)->setup_sim_hot_swap_finish) {
             MM_IFACE_MODEM_GET_INTERFACE (self)->setup_sim_hot_swap (
@@ -4856,6 +5085,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_UNLOCK_REQUIRED:
+        mm_trace_sequence_step (&ctx->trace, "unlock-required");
         /* Only check unlock required if we were previously not unlocked */
         if (mm_gdbus_modem_get_unlock_required (ctx->skeleton) != MM_MODEM_LOCK_NONE) {
             mm_iface_modem_update_lock_info (self,
@@ -4868,6 +5098,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_SIM:
+        mm_trace_sequence_step (&ctx->trace, "sim");
         /* If the modem doesn't need any SIM (not implemented by plugin, or not
          * needed in CDMA-only modems) */
         if (!mm_iface_modem_is_cdma_only (self) &&
@@ -4900,6 +5131,7 @@ interface_initialization_step (GTask *task)
         ctx->step++;
 
     case INITIALIZATION_STEP_OWN_NUMBERS:
+        mm_trace_sequence_step (&ctx->trace, "own-numbers");
         /* Own numbers is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
          * don't try to load them again. */
@@ -4920,6 +5152,8 @@ interface_initialization_step (GTask *task)
         MMModemMode preferred = MM_MODEM_MODE_NONE;
         GVariant *aux;
 
+        mm_trace_sequence_step (&ctx->trace, "current-modes");
+
         aux = mm_gdbus_modem_get_current_modes (ctx->skeleton);
         if (aux)
             g_variant_get (aux, "(uu)", &allowed, &preferred);
@@ -4960,6 +5194,8 @@ interface_initialization_step (GTask *task)
     case INITIALIZATION_STEP_CURRENT_BANDS: {
         GArray *current;
 
+        mm_trace_sequence_step (&ctx->trace, "current-bands");
+
         current = (mm_common_bands_variant_to_garray (
                        mm_gdbus_modem_get_current_bands (ctx->skeleton)));
 
@@ -5010,6 +5246,7 @@ interface_initialization_step (GTask *task)
             mm_gdbus_object_skeleton_set_modem (MM_GDBUS_OBJECT_SKELETON (self),
                                                 MM_GDBUS_MODEM (ctx->skeleton));
 
+        mm_trace_sequence_complete (&ctx->trace, ctx->fatal_error);
         if (ctx->fatal_error) {
             g_task_return_error (task, ctx->fatal_error);
             ctx->fatal_error = NULL;
@@ -5089,6 +5326,13 @@ mm_iface_modem_initialize (MMIfaceModem *self,
     ctx = g_new0 (InitializationContext, 1);
     ctx->step = INITIALIZATION_STEP_FIRST;
     ctx->skeleton = skeleton;
+    g_object_get (self,
+                  MM_IFACE_MODEM_INFO_CACHE_ENABLED,           &ctx->info_cache_enabled,
+                  MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED, &ctx->info_cache_supported_enabled,
+                  NULL);
+    mm_trace_sequence_init (&ctx->trace,
+                            mm_base_modem_get_device (MM_BASE_MODEM (self)),
+                            "modem-initialization");
 
     task = g_task_new (self, NULL, callback, user_data);
     g_task_set_task_data (task, ctx, (GDestroyNotify)initialization_context_free);
@@ -5415,6 +5659,22 @@ iface_modem_init (gpointer g_iface)
                                FALSE,
                                G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 
+    g_object_interface_install_property
+        (g_iface,
+         g_param_spec_boolean (MM_IFACE_MODEM_INFO_CACHE_ENABLED,
+                               "Info cache enabled",
+                               "Whether identity info may be restored from the cache of a previous initialization.",
+                               TRUE,
+                               G_PARAM_READWRITE));
+
+    g_object_interface_install_property
+        (g_iface,
+         g_param_spec_boolean (MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED,
+                               "Info cache supported enabled",
+                               "Whether supported modes and bands may be restored from the cache of a previous initialization.",
+                               FALSE,
+                               G_PARAM_READWRITE));
+
     initialized = TRUE;
 }
 
@@ -39,6 +39,8 @@
 #define MM_IFACE_MODEM_SIM_HOT_SWAP_SUPPORTED  "iface-modem-sim-hot-swap-supported"
 #define MM_IFACE_MODEM_SIM_HOT_SWAP_CONFIGURED "iface-modem-sim-hot-swap-configured"
 #define MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED "iface-modem-periodic-signal-check-disabled"
+#define MM_IFACE_MODEM_INFO_CACHE_ENABLED      "iface-modem-info-cache-enabled"
+#define MM_IFACE_MODEM_INFO_CACHE_SUPPORTED_ENABLED "iface-modem-info-cache-supported-enabled"
 
 typedef struct _MMIfaceModem MMIfaceModem;
 
@@ -477,6 +479,11 @@ void mm_iface_modem_update_signal_quality (MMIfaceModem *self,
 /* Allow requesting to refresh signal via polling */
 void mm_iface_modem_refresh_signal (MMIfaceModem *self);
 
+/* Drop the info cached for this device in a previous initialization, e.g.
+ * when the firmware or the SIM card are changed */
+void mm_iface_modem_info_cache_invalidate (MMIfaceModem *self,
+                                           const gchar *reason);
+
 /* Allow setting allowed modes */
 void     mm_iface_modem_set_current_modes        (MMIfaceModem *self,
                                                   MMModemMode allowed,
@@ -0,0 +1,627 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-metrics.h"
+#include "mm-log.h"
+#include "mm-modem-helpers.h"
+
+/*****************************************************************************/
+
+static const guint64 histogram_bounds[] = { MM_METRICS_HISTOGRAM_BOUNDS };
+
+G_STATIC_ASSERT (G_N_ELEMENTS (histogram_bounds) + 1 == MM_METRICS_HISTOGRAM_N_BUCKETS);
+
+typedef struct {
+    guint64 buckets[MM_METRICS_HISTOGRAM_N_BUCKETS];
+    guint64 count;
+    guint64 sum;
+} Histogram;
+
+static void
+histogram_observe (Histogram *histogram,
+                   guint64    value_ms)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (histogram_bounds); i++) {
+        if (value_ms <= histogram_bounds[i])
+            break;
+    }
+    histogram->buckets[i]++;
+    histogram->count++;
+    histogram->sum += value_ms;
+}
+
+/*****************************************************************************/
+
+struct _MMMetric {
+    guint         ref_count;
+    MMMetricType  type;
+    const gchar  *name;
+    gchar        *owner;
+    gint64        value;
+    Histogram     histogram;
+};
+
+/* Set of MMMetric, keyed by name and owner. Not owning references. */
+static GHashTable *registry;
+
+static guint
+metric_hash (gconstpointer v)
+{
+    const MMMetric *metric = v;
+
+    return g_str_hash (metric->name) ^ (metric->owner ? g_str_hash (metric->owner) : 0);
+}
+
+static gboolean
+metric_equal (gconstpointer a,
+              gconstpointer b)
+{
+    const MMMetric *metric_a = a;
+    const MMMetric *metric_b = b;
+
+    return (g_str_equal (metric_a->name, metric_b->name) &&
+            g_strcmp0 (metric_a->owner, metric_b->owner) == 0);
+}
+
+MMMetric *
+mm_metrics_get (MMMetricType  type,
+                const gchar  *name,
+                const gchar  *owner)
+{
+    MMMetric  key;
+    MMMetric *metric;
+
+    g_assert (name);
+
+    if (G_UNLIKELY (!registry))
+        registry = g_hash_table_new (metric_hash, metric_equal);
+
+    key.name  = name;
+    key.owner = (gchar *) owner;
+    metric = g_hash_table_lookup (registry, &key);
+    if (metric) {
+        /* Same name must always be used with the same type */
+        g_assert (metric->type == type);
+        return mm_metric_ref (metric);
+    }
+
+    metric = g_slice_new0 (MMMetric);
+    metric->ref_count = 1;
+    metric->type      = type;
+    metric->name      = name;
+    metric->owner     = g_strdup (owner);
+    g_hash_table_add (registry, metric);
+    return metric;
+}
+
+MMMetric *
+mm_metric_ref (MMMetric *metric)
+{
+    g_assert (metric->ref_count > 0);
+    metric->ref_count++;
+    return metric;
+}
+
+void
+mm_metric_unref (MMMetric *metric)
+{
+    g_assert (metric->ref_count > 0);
+    if (--metric->ref_count > 0)
+        return;
+
+    g_hash_table_remove (registry, metric);
+    g_free (metric->owner);
+    g_slice_free (MMMetric, metric);
+}
+
+/*****************************************************************************/
+
+void
+mm_metric_inc (MMMetric *metric)
+{
+    if (G_LIKELY (metric))
+        metric->value++;
+}
+
+void
+mm_metric_dec (MMMetric *metric)
+{
+    if (G_LIKELY (metric)) {
+        g_assert (metric->type == MM_METRIC_TYPE_GAUGE);
+        metric->value--;
+    }
+}
+
+void
+mm_metric_set (MMMetric *metric,
+               gint64    value)
+{
+    if (G_LIKELY (metric)) {
+        g_assert (metric->type == MM_METRIC_TYPE_GAUGE);
+        metric->value = value;
+    }
+}
+
+gint64
+mm_metric_get_value (MMMetric *metric)
+{
+    return metric->value;
+}
+
+void
+mm_metric_observe (MMMetric *metric,
+                   guint64   value_ms)
+{
+    if (G_LIKELY (metric)) {
+        g_assert (metric->type == MM_METRIC_TYPE_HISTOGRAM);
+        histogram_observe (&metric->histogram, value_ms);
+    }
+}
+
+guint64
+mm_metric_get_count (MMMetric *metric)
+{
+    return metric->histogram.count;
+}
+
+guint64
+mm_metric_get_sum (MMMetric *metric)
+{
+    return metric->histogram.sum;
+}
+
+guint64
+mm_metric_get_bucket (MMMetric *metric,
+                      guint     bucket)
+{
+    g_assert (bucket < MM_METRICS_HISTOGRAM_N_BUCKETS);
+    return metric->histogram.buckets[bucket];
+}
+
+/*****************************************************************************/
+/* DBus method latency
+ *
+ * The connection filter runs in the GDBus worker thread, so this is the only
+ * state in the module protected by a lock. Requests are matched to their
+ * replies by sender and serial. */
+
+#define DBUS_MAX_PENDING_CALLS 512
+
+#define DBUS_LATENCY_METRIC "mm_dbus_method_latency_ms"
+#define DBUS_ERRORS_METRIC  "mm_dbus_method_errors_total"
+
+typedef struct {
+    gchar  *method;
+    gint64  start;
+} DBusPendingCall;
+
+typedef struct {
+    Histogram latency;
+    guint64   n_errors;
+} DBusMethodStats;
+
+static GMutex           dbus_lock;
+static GHashTable      *dbus_pending;
+static GHashTable      *dbus_methods;
+static GDBusConnection *dbus_connection;
+static guint            dbus_filter_id;
+
+static void
+dbus_pending_call_free (DBusPendingCall *call)
+{
+    g_free (call->method);
+    g_slice_free (DBusPendingCall, call);
+}
+
+static void
+dbus_method_stats_free (DBusMethodStats *stats)
+{
+    g_slice_free (DBusMethodStats, stats);
+}
+
+static void
+dbus_call_started (GDBusMessage *message)
+{
+    DBusPendingCall *call;
+    const gchar     *sender;
+    const gchar     *interface;
+
+    if (g_dbus_message_get_flags (message) & G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED)
+        return;
+
+    sender = g_dbus_message_get_sender (message);
+    if (!sender)
+        return;
+
+    /* The interface is optional in method calls */
+    interface = g_dbus_message_get_interface (message);
+
+    call = g_slice_new (DBusPendingCall);
+    call->method = g_strdup_printf ("%s%s%s",
+                                    interface ? interface : "",
+                                    interface ? "." : "",
+                                    g_dbus_message_get_member (message));
+    call->start = g_get_monotonic_time ();
+
+    g_mutex_lock (&dbus_lock);
+    {
+        /* The connection may have been unwatched already */
+        if (!dbus_pending) {
+            g_mutex_unlock (&dbus_lock);
+            dbus_pending_call_free (call);
+            return;
+        }
+        /* Requests never replied must not make the table grow forever */
+        if (g_hash_table_size (dbus_pending) >= DBUS_MAX_PENDING_CALLS)
+            g_hash_table_remove_all (dbus_pending);
+        g_hash_table_replace (dbus_pending,
+                              g_strdup_printf ("%s/%u", sender, g_dbus_message_get_serial (message)),
+                              call);
+    }
+    g_mutex_unlock (&dbus_lock);
+}
+
+static void
+dbus_call_finished (GDBusMessage *message,
+                    gboolean      failed)
+{
+    const gchar     *destination;
+    gchar           *key;
+    DBusPendingCall *call;
+
+    destination = g_dbus_message_get_destination (message);
+    if (!destination)
+        return;
+
+    key = g_strdup_printf ("%s/%u", destination, g_dbus_message_get_reply_serial (message));
+
+    g_mutex_lock (&dbus_lock);
+    {
+        call = dbus_pending ? g_hash_table_lookup (dbus_pending, key) : NULL;
+        if (call) {
+            DBusMethodStats *stats;
+
+            stats = g_hash_table_lookup (dbus_methods, call->method);
+            if (!stats) {
+                stats = g_slice_new0 (DBusMethodStats);
+                g_hash_table_insert (dbus_methods, g_strdup (call->method), stats);
+            }
+            histogram_observe (&stats->latency, (g_get_monotonic_time () - call->start) / 1000);
+            if (failed)
+                stats->n_errors++;
+            g_hash_table_remove (dbus_pending, key);
+        }
+    }
+    g_mutex_unlock (&dbus_lock);
+
+    g_free (key);
+}
+
+static GDBusMessage *
+dbus_filter (GDBusConnection *connection,
+             GDBusMessage    *message,
+             gboolean         incoming,
+             gpointer         user_data)
+{
+    switch (g_dbus_message_get_message_type (message)) {
+    case G_DBUS_MESSAGE_TYPE_METHOD_CALL:
+        if (incoming)
+            dbus_call_started (message);
+        break;
+    case G_DBUS_MESSAGE_TYPE_METHOD_RETURN:
+        if (!incoming)
+            dbus_call_finished (message, FALSE);
+        break;
+    case G_DBUS_MESSAGE_TYPE_ERROR:
+        if (!incoming)
+            dbus_call_finished (message, TRUE);
+        break;
+    default:
+        break;
+    }
+
+    return message;
+}
+
+void
+mm_metrics_watch_connection (GDBusConnection *connection)
+{
+    g_assert (!dbus_connection);
+
+    g_mutex_lock (&dbus_lock);
+    {
+        dbus_pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              (GDestroyNotify) dbus_pending_call_free);
+        dbus_methods = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              (GDestroyNotify) dbus_method_stats_free);
+    }
+    g_mutex_unlock (&dbus_lock);
+
+    dbus_connection = g_object_ref (connection);
+    dbus_filter_id = g_dbus_connection_add_filter (connection, dbus_filter, NULL, NULL);
+}
+
+static void
+dbus_unwatch_connection (void)
+{
+    if (!dbus_connection)
+        return;
+
+    /* The filter may still be running in the GDBus worker thread after being
+     * removed, so it checks the tables under the lock before using them */
+    g_dbus_connection_remove_filter (dbus_connection, dbus_filter_id);
+    dbus_filter_id = 0;
+    g_clear_object (&dbus_connection);
+
+    g_mutex_lock (&dbus_lock);
+    {
+        g_clear_pointer (&dbus_pending, g_hash_table_unref);
+        g_clear_pointer (&dbus_methods, g_hash_table_unref);
+    }
+    g_mutex_unlock (&dbus_lock);
+}
+
+/*****************************************************************************/
+/* Text exposition */
+
+static void
+append_label (GString     *str,
+              const gchar *label,
+              const gchar *value,
+              gboolean     first)
+{
+    g_string_append_printf (str, "%s%s=", first ? "" : ",", label);
+    mm_str_append_escaped (str, value);
+}
+
+/* Appends the sample with the given suffix and labels; @le is only given for
+ * histogram buckets. */
+static void
+append_sample (GString     *str,
+               const gchar *name,
+               const gchar *suffix,
+               const gchar *label,
+               const gchar *label_value,
+               const gchar *le,
+               guint64      value,
+               gboolean     is_signed)
+{
+    g_string_append (str, name);
+    g_string_append (str, suffix);
+    if (label_value || le) {
+        g_string_append_c (str, '{');
+        if (label_value)
+            append_label (str, label, label_value, TRUE);
+        if (le)
+            append_label (str, "le", le, !label_value);
+        g_string_append_c (str, '}');
+    }
+    if (is_signed)
+        g_string_append_printf (str, " %" G_GINT64_FORMAT "\n", (gint64) value);
+    else
+        g_string_append_printf (str, " %" G_GUINT64_FORMAT "\n", value);
+}
+
+static void
+append_histogram (GString         *str,
+                  const gchar     *name,
+                  const gchar     *label,
+                  const gchar     *label_value,
+                  const Histogram *histogram)
+{
+    guint64 cumulative = 0;
+    guint   i;
+
+    for (i = 0; i < MM_METRICS_HISTOGRAM_N_BUCKETS; i++) {
+        gchar le[24];
+
+        if (i < G_N_ELEMENTS (histogram_bounds))
+            g_snprintf (le, sizeof (le), "%" G_GUINT64_FORMAT, histogram_bounds[i]);
+        else
+            g_strlcpy (le, "+Inf", sizeof (le));
+        cumulative += histogram->buckets[i];
+        append_sample (str, name, "_bucket", label, label_value, le, cumulative, FALSE);
+    }
+    append_sample (str, name, "_sum", label, label_value, NULL, histogram->sum, FALSE);
+    append_sample (str, name, "_count", label, label_value, NULL, histogram->count, FALSE);
+}
+
+static const gchar *
+metric_type_to_string (MMMetricType type)
+{
+    switch (type) {
+    case MM_METRIC_TYPE_COUNTER:
+        return "counter";
+    case MM_METRIC_TYPE_GAUGE:
+        return "gauge";
+    case MM_METRIC_TYPE_HISTOGRAM:
+        return "histogram";
+    default:
+        break;
+    }
+
+    g_assert_not_reached ();
+    return NULL;
+}
+
+static gint
+metric_cmp (const MMMetric **a,
+            const MMMetric **b)
+{
+    gint ret;
+
+    ret = strcmp ((*a)->name, (*b)->name);
+    if (ret)
+        return ret;
+    return g_strcmp0 ((*a)->owner, (*b)->owner);
+}
+
+static void
+build_registry (GString *str)
+{
+    GPtrArray      *metrics;
+    GHashTableIter  iter;
+    gpointer        key;
+    const gchar    *last_name = NULL;
+    guint           i;
+
+    if (!registry)
+        return;
+
+    metrics = g_ptr_array_sized_new (g_hash_table_size (registry));
+    g_hash_table_iter_init (&iter, registry);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        g_ptr_array_add (metrics, key);
+    g_ptr_array_sort (metrics, (GCompareFunc) metric_cmp);
+
+    for (i = 0; i < metrics->len; i++) {
+        const MMMetric *metric;
+
+        metric = g_ptr_array_index (metrics, i);
+        if (!last_name || !g_str_equal (last_name, metric->name)) {
+            g_string_append_printf (str, "# TYPE %s %s\n", metric->name, metric_type_to_string (metric->type));
+            last_name = metric->name;
+        }
+
+        if (metric->type == MM_METRIC_TYPE_HISTOGRAM)
+            append_histogram (str, metric->name, "owner", metric->owner, &metric->histogram);
+        else
+            append_sample (str, metric->name, "", "owner", metric->owner, NULL,
+                           (guint64) metric->value, TRUE);
+    }
+
+    g_ptr_array_unref (metrics);
+}
+
+static gint
+method_cmp (const gchar **a,
+            const gchar **b)
+{
+    return strcmp (*a, *b);
+}
+
+static void
+build_dbus (GString *str)
+{
+    GHashTableIter  iter;
+    gpointer        key;
+    gpointer        value;
+    GPtrArray      *methods;
+    guint           i;
+
+    g_mutex_lock (&dbus_lock);
+
+    if (!dbus_methods || !g_hash_table_size (dbus_methods)) {
+        g_mutex_unlock (&dbus_lock);
+        return;
+    }
+
+    methods = g_ptr_array_sized_new (g_hash_table_size (dbus_methods));
+    g_hash_table_iter_init (&iter, dbus_methods);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        g_ptr_array_add (methods, key);
+    g_ptr_array_sort (methods, (GCompareFunc) method_cmp);
+
+    g_string_append (str, "# TYPE " DBUS_LATENCY_METRIC " histogram\n");
+    for (i = 0; i < methods->len; i++) {
+        value = g_hash_table_lookup (dbus_methods, g_ptr_array_index (methods, i));
+        append_histogram (str, DBUS_LATENCY_METRIC, "method", g_ptr_array_index (methods, i),
+                          &((DBusMethodStats *) value)->latency);
+    }
+
+    g_string_append (str, "# TYPE " DBUS_ERRORS_METRIC " counter\n");
+    for (i = 0; i < methods->len; i++) {
+        value = g_hash_table_lookup (dbus_methods, g_ptr_array_index (methods, i));
+        append_sample (str, DBUS_ERRORS_METRIC, "", "method", g_ptr_array_index (methods, i), NULL,
+                       ((DBusMethodStats *) value)->n_errors, FALSE);
+    }
+
+    g_mutex_unlock (&dbus_lock);
+
+    g_ptr_array_unref (methods);
+}
+
+gchar *
+mm_metrics_build (void)
+{
+    GString *str;
+
+    str = g_string_new ("");
+    build_registry (str);
+    build_dbus (str);
+    return g_string_free (str, FALSE);
+}
+
+/*****************************************************************************/
+/* File export */
+
+static gchar *export_path;
+static guint  export_id;
+
+static void
+export_write (void)
+{
+    gchar  *report;
+    GError *error = NULL;
+
+    /* The file is replaced atomically, readers never see a partial report */
+    report = mm_metrics_build ();
+    if (!g_file_set_contents (export_path, report, -1, &error)) {
+        mm_warn ("Couldn't write metrics to '%s': %s", export_path, error->message);
+        g_error_free (error);
+    }
+    g_free (report);
+}
+
+static gboolean
+export_timeout_cb (gpointer user_data)
+{
+    export_write ();
+    return G_SOURCE_CONTINUE;
+}
+
+void
+mm_metrics_export_to_file (const gchar *path)
+{
+    g_assert (path);
+    g_assert (!export_path);
+
+    export_path = g_strdup (path);
+    export_write ();
+    export_id = g_timeout_add_seconds (MM_METRICS_FILE_INTERVAL_SECS, export_timeout_cb, NULL);
+}
+
+void
+mm_metrics_shutdown (void)
+{
+    if (export_path) {
+        g_source_remove (export_id);
+        export_id = 0;
+        /* Last report, with the final values */
+        export_write ();
+        g_clear_pointer (&export_path, g_free);
+    }
+
+    dbus_unwatch_connection ();
+}
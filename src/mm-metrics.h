@@ -0,0 +1,83 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_METRICS_H
+#define MM_METRICS_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+/*****************************************************************************/
+/* Registry of counters, gauges and latency histograms.
+ *
+ * Metrics are looked up (or created) once by name and owner, e.g. the port or
+ * modem device, and the returned reference is kept by whoever updates them,
+ * so that updating a metric is just an increment with no lookup. A metric is
+ * removed from the registry when its last reference is released, which keeps
+ * ports and modems that are gone out of the report.
+ *
+ * Metrics must only be used from the main thread. All update methods accept
+ * NULL, so users may skip creating the metrics they don't need. */
+
+typedef struct _MMMetric MMMetric;
+
+typedef enum {
+    MM_METRIC_TYPE_COUNTER,
+    MM_METRIC_TYPE_GAUGE,
+    MM_METRIC_TYPE_HISTOGRAM,
+} MMMetricType;
+
+/* Upper bounds of the histogram buckets, in milliseconds. An additional
+ * bucket takes all the values above the last bound. */
+#define MM_METRICS_HISTOGRAM_BOUNDS 1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000
+#define MM_METRICS_HISTOGRAM_N_BUCKETS 14
+
+/* @name must be a static string; @owner may be NULL for daemon-wide metrics */
+MMMetric *mm_metrics_get (MMMetricType  type,
+                          const gchar  *name,
+                          const gchar  *owner);
+MMMetric *mm_metric_ref   (MMMetric *metric);
+void      mm_metric_unref (MMMetric *metric);
+
+/* Counters and gauges */
+void   mm_metric_inc       (MMMetric *metric);
+void   mm_metric_dec       (MMMetric *metric);
+void   mm_metric_set       (MMMetric *metric,
+                            gint64    value);
+gint64 mm_metric_get_value (MMMetric *metric);
+
+/* Histograms */
+void    mm_metric_observe     (MMMetric *metric,
+                               guint64   value_ms);
+guint64 mm_metric_get_count   (MMMetric *metric);
+guint64 mm_metric_get_sum     (MMMetric *metric);
+guint64 mm_metric_get_bucket  (MMMetric *metric,
+                               guint     bucket);
+
+/* Latency of the DBus methods handled in @connection, per interface and
+ * method. The measurement is done from the GDBus worker thread, and it
+ * includes the time the request waits for the main loop. */
+void mm_metrics_watch_connection (GDBusConnection *connection);
+
+/* Report in the Prometheus text exposition format */
+gchar *mm_metrics_build (void);
+
+/* Periodically write the report to the given file, until shutdown */
+#define MM_METRICS_FILE_INTERVAL_SECS 10
+
+void mm_metrics_export_to_file (const gchar *path);
+void mm_metrics_shutdown       (void);
+
+#endif /* MM_METRICS_H */
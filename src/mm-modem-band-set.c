@@ -0,0 +1,228 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-modem-band-set.h"
+#include "mm-modem-helpers.h"
+
+#define BAND_WORD(band) ((guint)(band) / 32)
+#define BAND_BIT(band)  ((guint32) 1 << ((guint)(band) % 32))
+
+/* Bands out of range are never added, so that values received from clients
+ * don't need to be validated beforehand */
+#define BAND_VALID(band) ((guint)(band) <= MM_MODEM_BAND_ANY)
+
+/*****************************************************************************/
+
+void
+mm_modem_band_set_clear (MMModemBandSet *set)
+{
+    memset (set, 0, sizeof (MMModemBandSet));
+}
+
+void
+mm_modem_band_set_add (MMModemBandSet *set,
+                       MMModemBand     band)
+{
+    if (BAND_VALID (band))
+        set->bits[BAND_WORD (band)] |= BAND_BIT (band);
+}
+
+void
+mm_modem_band_set_remove (MMModemBandSet *set,
+                          MMModemBand     band)
+{
+    if (BAND_VALID (band))
+        set->bits[BAND_WORD (band)] &= ~BAND_BIT (band);
+}
+
+gboolean
+mm_modem_band_set_contains (const MMModemBandSet *set,
+                            MMModemBand           band)
+{
+    return (BAND_VALID (band) && (set->bits[BAND_WORD (band)] & BAND_BIT (band)));
+}
+
+gboolean
+mm_modem_band_set_is_empty (const MMModemBandSet *set)
+{
+    guint i;
+
+    for (i = 0; i < MM_MODEM_BAND_SET_N_WORDS; i++) {
+        if (set->bits[i])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+guint
+mm_modem_band_set_count (const MMModemBandSet *set)
+{
+    guint i;
+    guint n = 0;
+
+    for (i = 0; i < MM_MODEM_BAND_SET_N_WORDS; i++)
+        n += mm_count_bits_set (set->bits[i]);
+    return n;
+}
+
+gboolean
+mm_modem_band_set_equal (const MMModemBandSet *a,
+                         const MMModemBandSet *b)
+{
+    return (memcmp (a->bits, b->bits, sizeof (a->bits)) == 0);
+}
+
+/*****************************************************************************/
+
+void
+mm_modem_band_set_union (MMModemBandSet       *set,
+                         const MMModemBandSet *other)
+{
+    guint i;
+
+    for (i = 0; i < MM_MODEM_BAND_SET_N_WORDS; i++)
+        set->bits[i] |= other->bits[i];
+}
+
+void
+mm_modem_band_set_intersect (MMModemBandSet       *set,
+                             const MMModemBandSet *other)
+{
+    guint i;
+
+    for (i = 0; i < MM_MODEM_BAND_SET_N_WORDS; i++)
+        set->bits[i] &= other->bits[i];
+}
+
+void
+mm_modem_band_set_subtract (MMModemBandSet       *set,
+                            const MMModemBandSet *other)
+{
+    guint i;
+
+    for (i = 0; i < MM_MODEM_BAND_SET_N_WORDS; i++)
+        set->bits[i] &= ~other->bits[i];
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_modem_band_set_iter_next (const MMModemBandSet *set,
+                             guint                *iter,
+                             MMModemBand          *band)
+{
+    guint word;
+
+    /* Iterator is the next band value to look at */
+    for (word = *iter / 32; word < MM_MODEM_BAND_SET_N_WORDS; word++) {
+        guint32 bits;
+        gint    nth;
+
+        bits = set->bits[word];
+        /* Skip the bits already iterated in the first word */
+        if (word == *iter / 32)
+            bits &= ~(BAND_BIT (*iter) - 1);
+        if (!bits)
+            continue;
+
+        nth = g_bit_nth_lsf (bits, -1);
+        g_assert (nth >= 0);
+        *band = (MMModemBand) (word * 32 + nth);
+        *iter = *band + 1;
+        return TRUE;
+    }
+
+    *iter = MM_MODEM_BAND_SET_N_WORDS * 32;
+    return FALSE;
+}
+
+/*****************************************************************************/
+
+void
+mm_modem_band_set_add_range_mask (MMModemBandSet *set,
+                                  MMModemBand     first,
+                                  guint64         mask)
+{
+    guint i;
+
+    for (i = 0; mask; i++, mask >>= 1) {
+        if (mask & 1)
+            mm_modem_band_set_add (set, (MMModemBand) (first + i));
+    }
+}
+
+guint64
+mm_modem_band_set_get_range_mask (const MMModemBandSet *set,
+                                  MMModemBand           first,
+                                  MMModemBand           last)
+{
+    guint64 mask = 0;
+    guint   i;
+
+    g_assert (last >= first && (last - first) < 64);
+
+    for (i = 0; i <= (guint)(last - first); i++) {
+        if (mm_modem_band_set_contains (set, (MMModemBand) (first + i)))
+            mask |= ((guint64) 1 << i);
+    }
+    return mask;
+}
+
+/*****************************************************************************/
+
+void
+mm_modem_band_set_add_array (MMModemBandSet *set,
+                             const GArray   *array)
+{
+    guint i;
+
+    if (!array)
+        return;
+
+    for (i = 0; i < array->len; i++)
+        mm_modem_band_set_add (set, g_array_index (array, MMModemBand, i));
+}
+
+GArray *
+mm_modem_band_set_to_array (const MMModemBandSet *set)
+{
+    GArray      *array;
+    guint        iter = 0;
+    MMModemBand  band;
+
+    array = g_array_sized_new (FALSE, FALSE, sizeof (MMModemBand), mm_modem_band_set_count (set));
+    while (mm_modem_band_set_iter_next (set, &iter, &band))
+        g_array_append_val (array, band);
+    return array;
+}
+
+gboolean
+mm_modem_band_array_is_special (const GArray *array)
+{
+    MMModemBand band;
+
+    if (!array || array->len != 1)
+        return FALSE;
+
+    band = g_array_index (array, MMModemBand, 0);
+    return (band == MM_MODEM_BAND_UNKNOWN || band == MM_MODEM_BAND_ANY);
+}
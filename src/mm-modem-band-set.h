@@ -0,0 +1,87 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_MODEM_BAND_SET_H
+#define MM_MODEM_BAND_SET_H
+
+#include <glib.h>
+
+#include <ModemManager.h>
+
+/*****************************************************************************/
+/* Fixed-size set of MMModemBand values, one bit per band.
+ *
+ * Band lists are exposed in DBus as arrays, but internally most of the
+ * operations done with them are membership checks, unions and intersections,
+ * which are much cheaper on a bitset. Sets are plain structs, so they can be
+ * allocated in the stack and copied by value. Converting a set to an array
+ * always gives the bands sorted by value. */
+
+#define MM_MODEM_BAND_SET_N_WORDS ((MM_MODEM_BAND_ANY / 32) + 1)
+
+typedef struct {
+    guint32 bits[MM_MODEM_BAND_SET_N_WORDS];
+} MMModemBandSet;
+
+void     mm_modem_band_set_clear     (MMModemBandSet       *set);
+void     mm_modem_band_set_add       (MMModemBandSet       *set,
+                                      MMModemBand           band);
+void     mm_modem_band_set_remove    (MMModemBandSet       *set,
+                                      MMModemBand           band);
+gboolean mm_modem_band_set_contains  (const MMModemBandSet *set,
+                                      MMModemBand           band);
+gboolean mm_modem_band_set_is_empty  (const MMModemBandSet *set);
+guint    mm_modem_band_set_count     (const MMModemBandSet *set);
+gboolean mm_modem_band_set_equal     (const MMModemBandSet *a,
+                                      const MMModemBandSet *b);
+
+/* In-place set operations, the result is stored in @set */
+void     mm_modem_band_set_union     (MMModemBandSet       *set,
+                                      const MMModemBandSet *other);
+void     mm_modem_band_set_intersect (MMModemBandSet       *set,
+                                      const MMModemBandSet *other);
+void     mm_modem_band_set_subtract  (MMModemBandSet       *set,
+                                      const MMModemBandSet *other);
+
+/* Iteration in ascending order:
+ *
+ *   guint       iter = 0;
+ *   MMModemBand band;
+ *
+ *   while (mm_modem_band_set_iter_next (&set, &iter, &band))
+ *       ...
+ */
+gboolean mm_modem_band_set_iter_next (const MMModemBandSet *set,
+                                      guint                *iter,
+                                      MMModemBand          *band);
+
+/* Vendor bitmasks where bit N corresponds to band @first + N, e.g. LTE band
+ * masks with bit 0 being EUTRAN 1. */
+void     mm_modem_band_set_add_range_mask (MMModemBandSet       *set,
+                                           MMModemBand           first,
+                                           guint64               mask);
+guint64  mm_modem_band_set_get_range_mask (const MMModemBandSet *set,
+                                           MMModemBand           first,
+                                           MMModemBand           last);
+
+/* Conversions from/to GArrays of MMModemBand, used at the DBus boundary */
+void     mm_modem_band_set_add_array (MMModemBandSet       *set,
+                                      const GArray         *array);
+GArray  *mm_modem_band_set_to_array  (const MMModemBandSet *set);
+
+/* Whether the array is just one of the special UNKNOWN or ANY values */
+gboolean mm_modem_band_array_is_special (const GArray *array);
+
+#endif /* MM_MODEM_BAND_SET_H */
@@ -20,6 +20,7 @@
 #include <mm-errors-types.h>
 
 #include "mm-modem-helpers-qmi.h"
+#include "mm-modem-band-set.h"
 #include "mm-enums-types.h"
 #include "mm-log.h"
 
@@ -563,62 +564,61 @@ mm_modem_bands_to_qmi_band_preference (GArray *mm_bands,
                                        guint64 *extended_qmi_lte_bands,
                                        guint extended_qmi_lte_bands_size)
 {
+    MMModemBandSet pending;
+    MMModemBand band;
+    guint iter = 0;
     guint i;
 
     *qmi_bands = 0;
     *qmi_lte_bands = 0;
     memset (extended_qmi_lte_bands, 0, extended_qmi_lte_bands_size * sizeof (guint64));
 
-    for (i = 0; i < mm_bands->len; i++) {
-        MMModemBand band;
-
-        band = g_array_index (mm_bands, MMModemBand, i);
-
-        if (band >= MM_MODEM_BAND_EUTRAN_1 && band <= MM_MODEM_BAND_EUTRAN_71) {
-            if (extended_qmi_lte_bands && extended_qmi_lte_bands_size) {
-                /* Add extended LTE band preference */
-                guint val;
-                guint j;
-                guint k;
-
-                /* it's really (band - MM_MODEM_BAND_EUTRAN_1 +1 -1), because
-                 * we want EUTRAN1 in index 0 */
-                val = band - MM_MODEM_BAND_EUTRAN_1;
-                j = val / 64;
-                g_assert (j < extended_qmi_lte_bands_size);
-                k = val % 64;
-
-                extended_qmi_lte_bands[j] |= ((guint64)1 << k);
-            } else {
-                /* Add LTE band preference */
-                guint j;
-
-                for (j = 0; j < G_N_ELEMENTS (nas_lte_bands_map); j++) {
-                    if (nas_lte_bands_map[j].mm_band == band) {
-                        *qmi_lte_bands |= nas_lte_bands_map[j].qmi_band;
-                        break;
-                    }
-                }
-
-                if (j == G_N_ELEMENTS (nas_lte_bands_map))
-                    mm_dbg ("Cannot add the following LTE band: '%s'",
-                            mm_modem_band_get_string (band));
-            }
-        } else {
-            /* Add non-LTE band preference */
-            guint j;
+    /* Bands are removed from the pending set as they're converted, so that
+     * we can report the ones left */
+    mm_modem_band_set_clear (&pending);
+    mm_modem_band_set_add_array (&pending, mm_bands);
 
-            for (j = 0; j < G_N_ELEMENTS (nas_bands_map); j++) {
-                if (nas_bands_map[j].mm_band == band) {
-                    *qmi_bands |= nas_bands_map[j].qmi_band;
-                    break;
-                }
-            }
+    /* Add non-LTE band preference */
+    for (i = 0; i < G_N_ELEMENTS (nas_bands_map); i++) {
+        if (mm_modem_band_set_contains (&pending, nas_bands_map[i].mm_band)) {
+            *qmi_bands |= nas_bands_map[i].qmi_band;
+            mm_modem_band_set_remove (&pending, nas_bands_map[i].mm_band);
+        }
+    }
 
-            if (j == G_N_ELEMENTS (nas_bands_map))
-                mm_dbg ("Cannot add the following band: '%s'",
-                        mm_modem_band_get_string (band));
+    if (extended_qmi_lte_bands && extended_qmi_lte_bands_size) {
+        /* Add extended LTE band preference; EUTRAN 1 is bit 0 of the first
+         * item */
+        for (i = 0; i < extended_qmi_lte_bands_size; i++) {
+            MMModemBand first;
+            MMModemBand last;
+
+            first = MM_MODEM_BAND_EUTRAN_1 + (i * 64);
+            if (first > MM_MODEM_BAND_EUTRAN_71)
+                break;
+            last = MIN (first + 63, MM_MODEM_BAND_EUTRAN_71);
+
+            extended_qmi_lte_bands[i] = mm_modem_band_set_get_range_mask (&pending, first, last);
+            for (band = first; band <= last; band++)
+                mm_modem_band_set_remove (&pending, band);
         }
+    } else {
+        /* Add LTE band preference */
+        for (i = 0; i < G_N_ELEMENTS (nas_lte_bands_map); i++) {
+            if (mm_modem_band_set_contains (&pending, nas_lte_bands_map[i].mm_band)) {
+                *qmi_lte_bands |= nas_lte_bands_map[i].qmi_band;
+                mm_modem_band_set_remove (&pending, nas_lte_bands_map[i].mm_band);
+            }
+        }
+    }
+
+    while (mm_modem_band_set_iter_next (&pending, &iter, &band)) {
+        if (band >= MM_MODEM_BAND_EUTRAN_1 && band <= MM_MODEM_BAND_EUTRAN_71)
+            mm_dbg ("Cannot add the following LTE band: '%s'",
+                    mm_modem_band_get_string (band));
+        else
+            mm_dbg ("Cannot add the following band: '%s'",
+                    mm_modem_band_get_string (band));
     }
 }
 
@@ -30,6 +30,7 @@
 
 #include "mm-sms-part.h"
 #include "mm-modem-helpers.h"
+#include "mm-modem-band-set.h"
 #include "mm-helper-enums-types.h"
 #include "mm-log.h"
 
@@ -132,6 +133,43 @@ mm_split_string_groups (const gchar *str)
 
 /*****************************************************************************/
 
+void
+mm_str_append_escaped (GString     *str,
+                       const gchar *value)
+{
+    const gchar *p;
+
+    g_string_append_c (str, '"');
+    for (p = value; *p; p++) {
+        switch (*p) {
+        case '"':
+            g_string_append (str, "\\\"");
+            break;
+        case '\\':
+            g_string_append (str, "\\\\");
+            break;
+        case '\n':
+            g_string_append (str, "\\n");
+            break;
+        case '\r':
+            g_string_append (str, "\\r");
+            break;
+        case '\t':
+            g_string_append (str, "\\t");
+            break;
+        default:
+            if ((guchar)(*p) < 0x20)
+                g_string_append_printf (str, "\\u%04x", (guint)(guchar)(*p));
+            else
+                g_string_append_c (str, *p);
+            break;
+        }
+    }
+    g_string_append_c (str, '"');
+}
+
+/*****************************************************************************/
+
 static int uint_compare_func (gconstpointer a, gconstpointer b)
 {
    return (*(guint *)a - *(guint *)b);
@@ -346,6 +384,7 @@ mm_filter_current_bands (const GArray *supported_bands,
     /* We will assure that the list given in 'current' bands maps the list
      * given in 'supported' bands, unless 'UNKNOWN' or 'ANY' is given, of
      * course */
+    MMModemBandSet supported;
     guint i;
     GArray *filtered;
 
@@ -355,28 +394,22 @@ mm_filter_current_bands (const GArray *supported_bands,
         current_bands->len == 0)
         return NULL;
 
-    if (supported_bands->len == 1 &&
-        (g_array_index (supported_bands, MMModemBand, 0) == MM_MODEM_BAND_UNKNOWN ||
-         g_array_index (supported_bands, MMModemBand, 0) == MM_MODEM_BAND_ANY))
+    if (mm_modem_band_array_is_special (supported_bands) ||
+        mm_modem_band_array_is_special (current_bands))
         return NULL;
 
-    if (current_bands->len == 1 &&
-        (g_array_index (current_bands, MMModemBand, 0) == MM_MODEM_BAND_UNKNOWN ||
-         g_array_index (current_bands, MMModemBand, 0) == MM_MODEM_BAND_ANY))
-        return NULL;
+    mm_modem_band_set_clear (&supported);
+    mm_modem_band_set_add_array (&supported, supported_bands);
 
     filtered = g_array_sized_new (FALSE, FALSE, sizeof (MMModemBand), current_bands->len);
 
+    /* Keep the order given in the current bands list */
     for (i = 0; i < current_bands->len; i++) {
-        guint j;
+        MMModemBand band;
 
-        for (j = 0; j < supported_bands->len; j++) {
-            if (g_array_index (supported_bands, MMModemBand, j) == g_array_index (current_bands, MMModemBand, i)) {
-                g_array_append_val (filtered, g_array_index (current_bands, MMModemBand, i));
-                /* Found */
-                break;
-            }
-        }
+        band = g_array_index (current_bands, MMModemBand, i);
+        if (mm_modem_band_set_contains (&supported, band))
+            g_array_append_val (filtered, band);
     }
 
     if (filtered->len == 0) {
@@ -697,158 +730,15 @@ mm_flow_control_from_string (const gchar  *str,
 
 /*************************************************************************/
 
-/* +CREG: <stat>                      (GSM 07.07 CREG=1 unsolicited) */
-#define CREG1 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9])"
-
-/* +CREG: <n>,<stat>                  (GSM 07.07 CREG=1 solicited) */
-#define CREG2 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])"
-
-/* +CREG: <stat>,<lac>,<ci>           (GSM 07.07 CREG=2 unsolicited) */
-#define CREG3 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)"
-#define CREG11 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*(\"[^\"\\s]*\")\\s*,\\s*(\"[^\"\\s]*\")"
-
-/* +CREG: <n>,<stat>,<lac>,<ci>       (GSM 07.07 solicited and some CREG=2 unsolicited) */
-#define CREG4 "\\+(CREG|CGREG|CEREG):\\s*([0-9]),\\s*([0-9])\\s*,\\s*([^,]*)\\s*,\\s*([^,\\s]*)"
-#define CREG5 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*(\"[^,]*\")\\s*,\\s*(\"[^,\\s]*\")"
-
-/* +CREG: <stat>,<lac>,<ci>,<AcT>     (ETSI 27.007 CREG=2 unsolicited) */
-#define CREG6 "\\+(CREG|CGREG|CEREG):\\s*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([0-9])"
-#define CREG7 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9])\\s*,\\s*(\"[^,\\s]*\")\\s*,\\s*(\"[^,\\s]*\")\\s*,\\s*0*([0-9])"
-
-/* +CREG: <n>,<stat>,<lac>,<ci>,<AcT> (ETSI 27.007 solicited and some CREG=2 unsolicited) */
-#define CREG8 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])"
-
-/* +CREG: <n>,<stat>,<lac>,<ci>,<AcT?>,<something> (Samsung Wave S8500) */
-/* '<CR><LF>+CREG: 2,1,000B,2816, B, C2816<CR><LF><CR><LF>OK<CR><LF>' */
-#define CREG9 "\\+(CREG|CGREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*[^,\\s]*"
-
-/* +CREG: <stat>,<lac>,<ci>,<AcT>,<RAC> (ETSI 27.007 v9.20 CREG=2 unsolicited with RAC) */
-#define CREG10 "\\+(CREG|CGREG):\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])\\s*,\\s*([^,\\s]*)"
-
-/* +CEREG: <stat>,<lac>,<rac>,<ci>,<AcT>     (ETSI 27.007 v8.6 CREG=2 unsolicited with RAC) */
-#define CEREG1 "\\+(CEREG):\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])"
-
-/* +CEREG: <n>,<stat>,<lac>,<rac>,<ci>,<AcT> (ETSI 27.007 v8.6 CREG=2 solicited with RAC) */
-#define CEREG2 "\\+(CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])"
-
-GPtrArray *
-mm_3gpp_creg_regex_get (gboolean solicited)
-{
-    GPtrArray *array = g_ptr_array_sized_new (13);
-    GRegex *regex;
-
-    /* #1 */
-    if (solicited)
-        regex = g_regex_new (CREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #2 */
-    if (solicited)
-        regex = g_regex_new (CREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #3 */
-    if (solicited)
-        regex = g_regex_new (CREG3 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG3 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #4 */
-    if (solicited)
-        regex = g_regex_new (CREG4 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG4 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #5 */
-    if (solicited)
-        regex = g_regex_new (CREG5 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG5 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #6 */
-    if (solicited)
-        regex = g_regex_new (CREG6 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG6 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #7 */
-    if (solicited)
-        regex = g_regex_new (CREG7 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG7 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #8 */
-    if (solicited)
-        regex = g_regex_new (CREG8 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG8 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #9 */
-    if (solicited)
-        regex = g_regex_new (CREG9 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG9 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #10 */
-    if (solicited)
-        regex = g_regex_new (CREG10 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG10 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #11 */
-    if (solicited)
-        regex = g_regex_new (CREG11 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG11 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* CEREG #1 */
-    if (solicited)
-        regex = g_regex_new (CEREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CEREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* CEREG #2 */
-    if (solicited)
-        regex = g_regex_new (CEREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CEREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    return array;
-}
-
-void
-mm_3gpp_creg_regex_destroy (GPtrArray *array)
+GRegex *
+mm_3gpp_creg_unsolicited_regex_get (void)
 {
-    g_ptr_array_foreach (array, (GFunc) g_regex_unref, NULL);
-    g_ptr_array_free (array, TRUE);
+    /* Just the whole line, mm_3gpp_parse_creg_response() knows all the
+     * different layouts */
+    return g_regex_new ("\\r\\n(\\+(?:CREG|CGREG|CEREG):[^\\r\\n]*)\\r\\n",
+                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                        0,
+                        NULL);
 }
 
 /*************************************************************************/
@@ -1655,47 +1545,179 @@ mm_3gpp_parse_cgact_read_response (const gchar *reply,
 
 /*************************************************************************/
 
-static gulong
-parse_uint (char *str, int base, glong nmin, glong nmax, gboolean *valid)
+/* +CREG, +CGREG and +CEREG replies and unsolicited messages come in many
+ * different layouts, depending on the <n> mode, on whether they are
+ * solicited or not, and on the vendor:
+ *
+ *   <stat>                              (CREG=1 unsolicited)
+ *   <n>,<stat>                          (CREG=1 solicited)
+ *   <stat>,<lac>,<ci>                   (CREG=2 unsolicited)
+ *   <n>,<stat>,<lac>,<ci>               (CREG=2 solicited, some unsolicited)
+ *   <stat>,<lac>,<ci>,<AcT>             (27.007 CREG=2 unsolicited)
+ *   <n>,<stat>,<lac>,<ci>,<AcT>         (27.007 CREG=2 solicited)
+ *   <stat>,<lac>,<ci>,<AcT>,<RAC>       (27.007 v9.20 CREG=2 unsolicited)
+ *   <n>,<stat>,<lac>,<ci>,<AcT?>,<?>    (Samsung Wave S8500)
+ *   <stat>,<lac>,<rac>,<ci>,<AcT>       (27.007 v8.6 CEREG=2 unsolicited)
+ *   <n>,<stat>,<lac>,<rac>,<ci>,<AcT>   (27.007 v8.6 CEREG=2 solicited)
+ *
+ * The line is split into fields in a single pass, and the layout is looked
+ * up by number of fields and report type. When that is not enough, the
+ * second field tells whether the report starts with <n>,<stat> or with
+ * <stat>,<lac>.
+ */
+
+typedef enum {
+    CREG_TYPE_CREG  = 1 << 0,
+    CREG_TYPE_CGREG = 1 << 1,
+    CREG_TYPE_CEREG = 1 << 2,
+} CregType;
+
+#define CREG_TYPE_ANY (CREG_TYPE_CREG | CREG_TYPE_CGREG | CREG_TYPE_CEREG)
+
+static const struct {
+    const gchar *prefix;
+    gsize        prefix_len;
+    CregType     type;
+} creg_prefixes[] = {
+    { "+CREG:",  6, CREG_TYPE_CREG  },
+    { "+CGREG:", 7, CREG_TYPE_CGREG },
+    { "+CEREG:", 7, CREG_TYPE_CEREG },
+};
+
+typedef enum {
+    CREG_START_ANY,
+    CREG_START_N_STAT,
+    CREG_START_STAT_LAC,
+} CregStart;
+
+/* Field indices, -1 if not reported */
+typedef struct {
+    guint     n_fields;
+    guint     types;
+    CregStart start;
+    gint      stat;
+    gint      lac;
+    gint      ci;
+    gint      act;
+} CregLayout;
+
+static const CregLayout creg_layouts[] = {
+    { 1, CREG_TYPE_ANY,                    CREG_START_ANY,      0, -1, -1, -1 },
+    { 2, CREG_TYPE_ANY,                    CREG_START_ANY,      1, -1, -1, -1 },
+    { 3, CREG_TYPE_ANY,                    CREG_START_ANY,      0,  1,  2, -1 },
+    { 4, CREG_TYPE_ANY,                    CREG_START_N_STAT,   1,  2,  3, -1 },
+    { 4, CREG_TYPE_ANY,                    CREG_START_STAT_LAC, 0,  1,  2,  3 },
+    { 5, CREG_TYPE_CREG | CREG_TYPE_CGREG, CREG_START_N_STAT,   1,  2,  3,  4 },
+    { 5, CREG_TYPE_CREG | CREG_TYPE_CGREG, CREG_START_STAT_LAC, 0,  1,  2,  3 },
+    { 5, CREG_TYPE_CEREG,                  CREG_START_N_STAT,   1,  2,  3,  4 },
+    { 5, CREG_TYPE_CEREG,                  CREG_START_STAT_LAC, 0,  1,  3,  4 },
+    { 6, CREG_TYPE_CREG | CREG_TYPE_CGREG, CREG_START_N_STAT,   1,  2,  3,  4 },
+    { 6, CREG_TYPE_CEREG,                  CREG_START_N_STAT,   1,  2,  4,  5 },
+};
+
+#define CREG_MAX_FIELDS 6
+
+typedef struct {
+    const gchar *str;
+    gsize        len;
+} CregField;
+
+/* Splits the fields up to the end of the line, honouring quotes and
+ * skipping the whitespace around each field. Returns the number of fields
+ * found, which may be more than the ones stored. */
+static guint
+creg_split_fields (const gchar *p,
+                   CregField   *fields)
 {
-    gulong ret = 0;
-    gchar *endquote;
+    guint n_fields = 0;
 
-    *valid = FALSE;
-    if (!str)
-        return 0;
+    while (TRUE) {
+        const gchar *start;
+        const gchar *end;
+        gboolean     quoted = FALSE;
+
+        while (*p == ' ' || *p == '\t')
+            p++;
+        start = p;
+        while (*p && *p != '\r' && *p != '\n' && (quoted || *p != ',')) {
+            if (*p == '"')
+                quoted = !quoted;
+            p++;
+        }
+        end = p;
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t'))
+            end--;
+
+        if (n_fields < CREG_MAX_FIELDS) {
+            fields[n_fields].str = start;
+            fields[n_fields].len = end - start;
+        }
+        n_fields++;
+
+        if (*p != ',')
+            return n_fields;
+        p++;
+    }
+}
+
+static gboolean
+creg_field_get_uint (const CregField *field,
+                     guint            base,
+                     gulong           nmin,
+                     gulong           nmax,
+                     gulong          *out)
+{
+    const gchar *str = field->str;
+    const gchar *quote;
+    gsize        len = field->len;
+    gchar        buf[32];
+    gulong       value;
 
     /* Strip quotes */
-    if (str[0] == '"')
+    if (len && str[0] == '"') {
         str++;
-    endquote = strchr (str, '"');
-    if (endquote)
-        *endquote = '\0';
-
-    if (strlen (str)) {
-        ret = strtol (str, NULL, base);
-        if ((nmin == nmax) || (ret >= nmin && ret <= nmax))
-            *valid = TRUE;
+        len--;
     }
-    return *valid ? (guint) ret : 0;
+    quote = memchr (str, '"', len);
+    if (quote)
+        len = quote - str;
+
+    if (!len || len >= sizeof (buf))
+        return FALSE;
+    memcpy (buf, str, len);
+    buf[len] = '\0';
+
+    value = strtoul (buf, NULL, base);
+    if (value < nmin || value > nmax)
+        return FALSE;
+    *out = value;
+    return TRUE;
 }
 
+/* A <stat> is a single digit without quotes. Some modems (e.g. Iridium) pad
+ * it with zeros, which is only accepted when followed by a quoted LAC, as
+ * otherwise it could be an unquoted LAC itself. */
 static gboolean
-item_is_lac_not_stat (GMatchInfo *info, guint32 item)
+creg_field_is_stat (const CregField *fields,
+                    guint            i)
 {
-    gchar *str;
-    gboolean is_lac = FALSE;
+    const CregField *field = &fields[i];
+    gsize            j;
 
-    /* A <stat> will always be a single digit, without quotes */
-    str = g_match_info_fetch (info, item);
-    g_assert (str);
-    is_lac = (strchr (str, '"') || strlen (str) > 1);
-    g_free (str);
-    return is_lac;
+    if (!field->len)
+        return FALSE;
+    for (j = 0; j < field->len; j++) {
+        if (!g_ascii_isdigit (field->str[j]))
+            return FALSE;
+        if (j + 1 < field->len && field->str[j] != '0')
+            return FALSE;
+    }
+
+    return (field->len == 1 || (fields[i + 1].len && fields[i + 1].str[0] == '"'));
 }
 
 gboolean
-mm_3gpp_parse_creg_response (GMatchInfo *info,
+mm_3gpp_parse_creg_response (const gchar *reply,
                              MMModem3gppRegistrationState *out_reg_state,
                              gulong *out_lac,
                              gulong *out_ci,
@@ -1704,13 +1726,15 @@ mm_3gpp_parse_creg_response (GMatchInfo *info,
                              gboolean *out_cereg,
                              GError **error)
 {
-    gboolean success = FALSE, foo;
-    gint n_matches, act = -1;
-    gulong stat = 0, lac = 0, ci = 0;
-    guint istat = 0, ilac = 0, ici = 0, iact = 0;
-    gchar *str;
+    const gchar      *p;
+    const CregLayout *layout = NULL;
+    CregType          type = 0;
+    CregField         fields[CREG_MAX_FIELDS];
+    guint             n_fields;
+    CregStart         start = CREG_START_ANY;
+    gulong            stat = 0, lac = 0, ci = 0, act = 0;
+    guint             i;
 
-    g_return_val_if_fail (info != NULL, FALSE);
     g_return_val_if_fail (out_reg_state != NULL, FALSE);
     g_return_val_if_fail (out_lac != NULL, FALSE);
     g_return_val_if_fail (out_ci != NULL, FALSE);
@@ -1718,93 +1742,38 @@ mm_3gpp_parse_creg_response (GMatchInfo *info,
     g_return_val_if_fail (out_cgreg != NULL, FALSE);
     g_return_val_if_fail (out_cereg != NULL, FALSE);
 
-    str = g_match_info_fetch (info, 1);
-    *out_cgreg = (str && strstr (str, "CGREG")) ? TRUE : FALSE;
-    *out_cereg = (str && strstr (str, "CEREG")) ? TRUE : FALSE;
-    g_free (str);
-
-    /* Normally the number of matches could be used to determine what each
-     * item is, but we have overlap in one case.
-     */
-    n_matches = g_match_info_get_match_count (info);
-    if (n_matches == 3) {
-        /* CREG=1: +CREG: <stat> */
-        istat = 2;
-    } else if (n_matches == 4) {
-        /* Solicited response: +CREG: <n>,<stat> */
-        istat = 3;
-    } else if (n_matches == 5) {
-        /* CREG=2 (GSM 07.07): +CREG: <stat>,<lac>,<ci> */
-        istat = 2;
-        ilac = 3;
-        ici = 4;
-    } else if (n_matches == 6) {
-        /* CREG=2 (ETSI 27.007): +CREG: <stat>,<lac>,<ci>,<AcT>
-         * CREG=2 (non-standard): +CREG: <n>,<stat>,<lac>,<ci>
-         */
-
-        /* Check if the third item is the LAC to distinguish the two cases */
-        if (item_is_lac_not_stat (info, 3)) {
-            istat = 2;
-            ilac = 3;
-            ici = 4;
-            iact = 5;
-        } else {
-            istat = 3;
-            ilac = 4;
-            ici = 5;
-        }
-    } else if (n_matches == 7) {
-        /* CREG=2 (solicited):            +CREG: <n>,<stat>,<lac>,<ci>,<AcT>
-         * CREG=2 (unsolicited with RAC): +CREG: <stat>,<lac>,<ci>,<AcT>,<RAC>
-         * CEREG=2 (solicited):           +CEREG: <n>,<stat>,<lac>,<ci>,<AcT>
-         * CEREG=2 (unsolicited with RAC): +CEREG: <stat>,<lac>,<rac>,<ci>,<AcT>
-         */
-
-        if (*out_cereg) {
-            /* Check if the third item is the LAC to distinguish the two cases */
-            if (item_is_lac_not_stat (info, 3)) {
-                istat = 2;
-                ilac = 3;
-            } else {
-                istat = 3;
-                ilac = 4;
-            }
-            ici = 5;
-            iact = 6;
-        } else {
-            /* Check if the third item is the LAC to distinguish the two cases */
-            if (item_is_lac_not_stat (info, 3)) {
-                istat = 2;
-                ilac = 3;
-                ici = 4;
-                iact = 5;
-            } else {
-                istat = 3;
-                ilac = 4;
-                ici = 5;
-                iact = 6;
+    /* Look for the first registration report in the reply */
+    p = reply ? strchr (reply, '+') : NULL;
+    while (p && !type) {
+        for (i = 0; i < G_N_ELEMENTS (creg_prefixes); i++) {
+            if (!strncmp (p, creg_prefixes[i].prefix, creg_prefixes[i].prefix_len)) {
+                type = creg_prefixes[i].type;
+                p += creg_prefixes[i].prefix_len;
+                break;
             }
         }
-    } else if (n_matches == 8) {
-        /* CEREG=2 (solicited with RAC):  +CEREG: <n>,<stat>,<lac>,<rac>,<ci>,<AcT>
-         */
-        if (*out_cereg) {
-            istat = 3;
-            ilac = 4;
-            ici = 6;
-            iact = 7;
+        if (!type)
+            p = strchr (p + 1, '+');
+    }
+
+    if (type) {
+        n_fields = creg_split_fields (p, fields);
+        if (n_fields >= 4 && n_fields <= CREG_MAX_FIELDS)
+            start = creg_field_is_stat (fields, 1) ? CREG_START_N_STAT : CREG_START_STAT_LAC;
+
+        for (i = 0; i < G_N_ELEMENTS (creg_layouts) && !layout; i++) {
+            if (creg_layouts[i].n_fields == n_fields &&
+                (creg_layouts[i].types & type) &&
+                (creg_layouts[i].start == CREG_START_ANY || creg_layouts[i].start == start))
+                layout = &creg_layouts[i];
         }
-     }
+    }
 
-    /* Status */
-    str = g_match_info_fetch (info, istat);
-    stat = parse_uint (str, 10, 0, G_MAXUINT, &success);
-    g_free (str);
-    if (!success) {
-        g_set_error_literal (error,
-                             MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
-                             "Could not parse the registration status response");
+    if (!layout || !creg_field_get_uint (&fields[layout->stat], 10, 0, G_MAXUINT, &stat)) {
+        g_set_error (error,
+                     MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Could not parse the registration status response: '%s'",
+                     reply ? reply : "");
         return FALSE;
     }
 
@@ -1814,40 +1783,72 @@ mm_3gpp_parse_creg_response (GMatchInfo *info,
         stat = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     }
 
-    /* Location Area Code */
-    if (ilac) {
-        /* FIXME: some phones apparently swap the LAC bytes (LG, SonyEricsson,
-         * Sagem).  Need to handle that.
-         */
-        str = g_match_info_fetch (info, ilac);
-        lac = parse_uint (str, 16, 1, 0xFFFF, &foo);
-        g_free (str);
-    }
+    *out_cgreg = (type == CREG_TYPE_CGREG);
+    *out_cereg = (type == CREG_TYPE_CEREG);
+    *out_reg_state = (MMModem3gppRegistrationState) stat;
 
-    /* Cell ID */
-    if (ici) {
-        str = g_match_info_fetch (info, ici);
-        ci = parse_uint (str, 16, 1, 0x0FFFFFFE, &foo);
-        g_free (str);
-    }
+    /* Don't fill in lac/ci/act if the device's state is unknown */
+    if (stat == MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN)
+        return TRUE;
 
-    /* Access Technology */
-    if (iact) {
-        str = g_match_info_fetch (info, iact);
-        act = (gint) parse_uint (str, 10, 0, 7, &foo);
-        g_free (str);
-        if (!foo)
-            act = -1;
+    /* FIXME: some phones apparently swap the LAC bytes (LG, SonyEricsson,
+     * Sagem).  Need to handle that.
+     */
+    if (layout->lac < 0 || !creg_field_get_uint (&fields[layout->lac], 16, 1, 0xFFFF, &lac))
+        lac = 0;
+    if (layout->ci < 0 || !creg_field_get_uint (&fields[layout->ci], 16, 1, 0x0FFFFFFE, &ci))
+        ci = 0;
+
+    *out_lac = lac;
+    *out_ci = ci;
+    *out_act = ((layout->act >= 0 && creg_field_get_uint (&fields[layout->act], 10, 0, 7, &act)) ?
+                get_mm_access_tech_from_etsi_access_tech (act) :
+                MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN);
+    return TRUE;
+}
+
+/*************************************************************************/
+
+gboolean
+mm_3gpp_parse_cmms_test_response (const gchar  *reply,
+                                  gboolean     *keep_link_supported,
+                                  GError      **error)
+{
+    GArray *modes;
+    gchar  *aux;
+    GError *inner_error = NULL;
+    guint   i;
+
+    /* e.g.:
+     *   +CMMS: (0-2)
+     *   +CMMS: (0,1)
+     */
+    aux = g_strdelimit (g_strdup (mm_strip_tag (reply, "+CMMS:")), "()", ' ');
+    modes = mm_parse_uint_list (g_strstrip (aux), &inner_error);
+    g_free (aux);
+
+    if (inner_error) {
+        g_propagate_error (error, inner_error);
+        return FALSE;
     }
 
-    *out_reg_state = (MMModem3gppRegistrationState) stat;
-    if (stat != MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN) {
-        /* Don't fill in lac/ci/act if the device's state is unknown */
-        *out_lac = lac;
-        *out_ci = ci;
+    if (!modes) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't parse +CMMS=? response: '%s'", reply);
+        return FALSE;
+    }
 
-        *out_act = get_mm_access_tech_from_etsi_access_tech (act);
+    /* Mode 1 keeps the link open until the time between messages exceeds
+     * the modem's timeout, and then goes back to mode 0 by itself */
+    *keep_link_supported = FALSE;
+    for (i = 0; i < modes->len; i++) {
+        if (g_array_index (modes, guint, i) == 1) {
+            *keep_link_supported = TRUE;
+            break;
+        }
     }
+
+    g_array_unref (modes);
     return TRUE;
 }
 
@@ -53,6 +53,12 @@ const gchar *mm_strip_tag    (const gchar *str,
 
 gchar **mm_split_string_groups (const gchar *str);
 
+/* Appends @value quoted, with quotes, backslashes and control chars escaped
+ * as in JSON strings. Strings without control chars other than newlines are
+ * also valid Prometheus label values. */
+void mm_str_append_escaped (GString     *str,
+                            const gchar *value);
+
 GArray *mm_parse_uint_list (const gchar  *str,
                             GError      **error);
 
@@ -122,8 +128,7 @@ MMFlowControl mm_flow_control_from_string (const gchar  *str,
 /*****************************************************************************/
 
 /* Common Regex getters */
-GPtrArray *mm_3gpp_creg_regex_get     (gboolean solicited);
-void       mm_3gpp_creg_regex_destroy (GPtrArray *array);
+GRegex    *mm_3gpp_creg_unsolicited_regex_get (void);
 GRegex    *mm_3gpp_ciev_regex_get (void);
 GRegex    *mm_3gpp_cgev_regex_get (void);
 GRegex    *mm_3gpp_cusd_regex_get (void);
@@ -189,8 +194,9 @@ gint mm_3gpp_pdp_context_active_cmp (MM3gppPdpContextActive *a,
 GList *mm_3gpp_parse_cgact_read_response (const gchar *reply,
                                           GError **error);
 
-/* CREG/CGREG response/unsolicited message parser */
-gboolean mm_3gpp_parse_creg_response (GMatchInfo *info,
+/* CREG/CGREG/CEREG response/unsolicited message parser, the first report
+ * found in @reply is parsed */
+gboolean mm_3gpp_parse_creg_response (const gchar *reply,
                                       MMModem3gppRegistrationState *out_reg_state,
                                       gulong *out_lac,
                                       gulong *out_ci,
@@ -199,6 +205,11 @@ gboolean mm_3gpp_parse_creg_response (GMatchInfo *info,
                                       gboolean *out_cereg,
                                       GError **error);
 
+/* AT+CMMS=? (More messages to send) response parser */
+gboolean mm_3gpp_parse_cmms_test_response (const gchar  *reply,
+                                           gboolean     *keep_link_supported,
+                                           GError      **error);
+
 /* AT+CMGF=? (SMS message format) response parser */
 gboolean mm_3gpp_parse_cmgf_test_response (const gchar *reply,
                                            gboolean *sms_pdu_supported,
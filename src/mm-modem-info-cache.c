@@ -0,0 +1,170 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include "mm-modem-info-cache.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+MMModemInfo *
+mm_modem_info_new (void)
+{
+    return g_slice_new0 (MMModemInfo);
+}
+
+MMModemInfo *
+mm_modem_info_dup (const MMModemInfo *info)
+{
+    MMModemInfo *copy;
+
+    copy = mm_modem_info_new ();
+    copy->manufacturer         = g_strdup (info->manufacturer);
+    copy->model                = g_strdup (info->model);
+    copy->revision             = g_strdup (info->revision);
+    copy->hardware_revision    = g_strdup (info->hardware_revision);
+    copy->equipment_identifier = g_strdup (info->equipment_identifier);
+    copy->device_identifier    = g_strdup (info->device_identifier);
+    copy->supported_modes      = info->supported_modes ? g_array_ref (info->supported_modes) : NULL;
+    copy->supported_bands      = info->supported_bands ? g_array_ref (info->supported_bands) : NULL;
+    return copy;
+}
+
+void
+mm_modem_info_free (MMModemInfo *info)
+{
+    if (!info)
+        return;
+
+    g_free (info->manufacturer);
+    g_free (info->model);
+    g_free (info->revision);
+    g_free (info->hardware_revision);
+    g_free (info->equipment_identifier);
+    g_free (info->device_identifier);
+    if (info->supported_modes)
+        g_array_unref (info->supported_modes);
+    if (info->supported_bands)
+        g_array_unref (info->supported_bands);
+    g_slice_free (MMModemInfo, info);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    MMModemInfo *info;
+    gint64       identity_expiration;
+    gint64       supported_expiration;
+} CacheEntry;
+
+static GHashTable *cache;
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+    mm_modem_info_free (entry->info);
+    g_slice_free (CacheEntry, entry);
+}
+
+void
+mm_modem_info_cache_store (const gchar *uid,
+                           MMModemInfo *info)
+{
+    CacheEntry *entry;
+    CacheEntry *previous;
+    gint64      now;
+
+    g_return_if_fail (uid != NULL);
+    g_return_if_fail (info != NULL && info->revision != NULL);
+
+    if (G_UNLIKELY (!cache))
+        cache = g_hash_table_new_full (g_str_hash,
+                                       g_str_equal,
+                                       g_free,
+                                       (GDestroyNotify) cache_entry_free);
+
+    now = g_get_monotonic_time ();
+
+    entry = g_slice_new0 (CacheEntry);
+    entry->info = info;
+    entry->identity_expiration = now + (MM_MODEM_INFO_CACHE_IDENTITY_TTL_SECS * G_USEC_PER_SEC);
+
+    /* Refreshing the entry of the same device (e.g. after the supported modes
+     * and bands expired) doesn't extend the lifetime of its identity */
+    previous = g_hash_table_lookup (cache, uid);
+    if (previous &&
+        now < previous->identity_expiration &&
+        g_strcmp0 (previous->info->revision, info->revision) == 0 &&
+        g_strcmp0 (previous->info->equipment_identifier, info->equipment_identifier) == 0)
+        entry->identity_expiration = previous->identity_expiration;
+    entry->supported_expiration = now + (MM_MODEM_INFO_CACHE_SUPPORTED_TTL_SECS * G_USEC_PER_SEC);
+
+    mm_dbg ("(%s) caching modem information for revision '%s'", uid, info->revision);
+    g_hash_table_replace (cache, g_strdup (uid), entry);
+}
+
+const MMModemInfo *
+mm_modem_info_cache_peek (const gchar *uid,
+                          const gchar *revision)
+{
+    CacheEntry *entry;
+    gint64      now;
+
+    g_return_val_if_fail (uid != NULL, NULL);
+
+    if (!cache || !(entry = g_hash_table_lookup (cache, uid)))
+        return NULL;
+
+    now = g_get_monotonic_time ();
+
+    if (now >= entry->identity_expiration) {
+        mm_modem_info_cache_invalidate (uid, "expired");
+        return NULL;
+    }
+
+    if (revision && g_strcmp0 (revision, entry->info->revision) != 0) {
+        mm_modem_info_cache_invalidate (uid, "firmware revision changed");
+        return NULL;
+    }
+
+    /* Supported modes and bands expire on their own, the identity information
+     * is kept */
+    if (now >= entry->supported_expiration &&
+        (entry->info->supported_modes || entry->info->supported_bands)) {
+        mm_dbg ("(%s) cached supported modes and bands expired", uid);
+        g_clear_pointer (&entry->info->supported_modes, g_array_unref);
+        g_clear_pointer (&entry->info->supported_bands, g_array_unref);
+    }
+
+    return entry->info;
+}
+
+void
+mm_modem_info_cache_invalidate (const gchar *uid,
+                                const gchar *reason)
+{
+    g_return_if_fail (uid != NULL);
+
+    if (cache && g_hash_table_remove (cache, uid))
+        mm_dbg ("(%s) cached modem information invalidated: %s", uid, reason ? reason : "unknown");
+}
+
+void
+mm_modem_info_cache_clear (void)
+{
+    g_clear_pointer (&cache, g_hash_table_unref);
+}
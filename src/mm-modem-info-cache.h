@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_MODEM_INFO_CACHE_H
+#define MM_MODEM_INFO_CACHE_H
+
+#include <glib.h>
+
+/*****************************************************************************/
+/* Cache of the static modem information loaded during initialization, kept
+ * across modem objects for the same device (e.g. when reprobing or after a
+ * modem reset). Entries are keyed by device uid, and only valid as long as
+ * the firmware revision reported by the modem doesn't change. */
+
+/* Identity information is not expected to change at all, so just make sure
+ * it's reloaded once in a while */
+#define MM_MODEM_INFO_CACHE_IDENTITY_TTL_SECS  (24 * 60 * 60)
+
+/* Supported modes and bands may change e.g. with carrier configuration
+ * updates */
+#define MM_MODEM_INFO_CACHE_SUPPORTED_TTL_SECS (60 * 60)
+
+typedef struct {
+    gchar  *manufacturer;
+    gchar  *model;
+    gchar  *revision;
+    gchar  *hardware_revision;
+    gchar  *equipment_identifier;
+    gchar  *device_identifier;
+    GArray *supported_modes; /* MMModemModeCombination */
+    GArray *supported_bands; /* MMModemBand */
+} MMModemInfo;
+
+MMModemInfo *mm_modem_info_new  (void);
+MMModemInfo *mm_modem_info_dup  (const MMModemInfo *info);
+void         mm_modem_info_free (MMModemInfo *info);
+
+/* Takes ownership of @info, which must have a revision. Any previous entry
+ * for the same device is replaced; if it has the same revision and equipment
+ * identifier, its identity expiration time is kept. */
+void mm_modem_info_cache_store (const gchar *uid,
+                                MMModemInfo *info);
+
+/* Returns the cached information for the given device, or NULL if not found
+ * or expired. If @revision is given and doesn't match the cached one (i.e.
+ * the firmware has changed), the entry is invalidated. The returned value is
+ * owned by the cache, and only valid until the cache is next modified. */
+const MMModemInfo *mm_modem_info_cache_peek (const gchar *uid,
+                                             const gchar *revision);
+
+void mm_modem_info_cache_invalidate (const gchar *uid,
+                                     const gchar *reason);
+
+/* Removes all entries */
+void mm_modem_info_cache_clear (void);
+
+#endif /* MM_MODEM_INFO_CACHE_H */
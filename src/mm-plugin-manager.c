@@ -21,13 +21,17 @@
 
 #include <gmodule.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 
 #include <ModemManager.h>
 #include <mm-errors-types.h>
 
 #include "mm-plugin-manager.h"
 #include "mm-plugin.h"
+#include "mm-plugin-manifest.h"
 #include "mm-log.h"
+#include "mm-metrics.h"
+#include "mm-context.h"
 
 static void initable_iface_init (GInitableIface *iface);
 
@@ -49,16 +53,35 @@ struct _MMPluginManagerPrivate {
     MMFilter *filter;
 
     /* This list contains all plugins except for the generic one, order is not
-     * important. It is loaded once when the program starts, and the list is NOT
-     * expected to change after that.*/
+     * important. It is loaded once when the program starts, and after that it
+     * only grows when deferred plugins are loaded. */
     GList *plugins;
     /* Last, the generic plugin. */
     MMPlugin *generic;
+    /* Plugins not loaded yet, until a device they may support is found. Once
+     * loaded, they're moved to the list of plugins above. */
+    GList *deferred_plugins;
 
     /* List of ongoing device support checks */
     GList *device_contexts;
+
+    /* Devices found at startup currently being probed, and the ones waiting
+     * for their turn */
+    guint   n_boot_devices_probing;
+    GQueue  boot_devices_queue;
+
+    /* Probing metrics */
+    MMMetric *metric_port_probe_time;
+    MMMetric *metric_ports_probing;
+    MMMetric *metric_device_probe_time;
+    MMMetric *metric_devices_unsupported;
 };
 
+static void      plugin_manager_load_deferred_plugins (MMPluginManager *self,
+                                                       MMDevice        *device);
+static MMPlugin *plugin_manager_load_deferred_plugin  (MMPluginManager *self,
+                                                       const gchar     *plugin_name);
+
 /*****************************************************************************/
 /* Build plugin list for a single port */
 
@@ -71,6 +94,9 @@ plugin_manager_build_plugins_list (MMPluginManager *self,
     GList *l;
     gboolean supported_found = FALSE;
 
+    /* Bring in the plugins that may support this device */
+    plugin_manager_load_deferred_plugins (self, device);
+
     for (l = self->priv->plugins; l && !supported_found; l = g_list_next (l)) {
         MMPluginSupportsHint hint;
 
@@ -270,6 +296,15 @@ port_context_complete (PortContext *port_context)
     mm_dbg ("[plugin manager] task %s: finished in '%lf' seconds",
             port_context->name, g_timer_elapsed (port_context->timer, NULL));
 
+    {
+        MMPluginManager *self;
+
+        self = MM_PLUGIN_MANAGER (g_task_get_source_object (task));
+        mm_metric_dec (self->priv->metric_ports_probing);
+        mm_metric_observe (self->priv->metric_port_probe_time,
+                           (guint64) (g_timer_elapsed (port_context->timer, NULL) * 1000));
+    }
+
     if (!port_context->best_plugin)
         g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED, "Unsupported");
     else
@@ -640,6 +675,7 @@ port_context_run (MMPluginManager     *self,
     /* Create an inner task for the port context. The result we expect is the
      * best plugin found for the port. */
     port_context->task = g_task_new (self, port_context->cancellable, callback, user_data);
+    mm_metric_inc (self->priv->metric_ports_probing);
 
     mm_dbg ("[plugin manager) task %s: started", port_context->name);
 
@@ -716,6 +752,12 @@ struct _DeviceContext {
     /* Port support check contexts waiting to be run after min wait time */
     GList *wait_port_contexts;
 
+    /* Devices found at startup may need to wait for others to be probed
+     * before their own probing starts. While queued, grabbed ports are kept
+     * in the list of port contexts waiting to be run. */
+    gboolean boot_queued;
+    gboolean boot_probing;
+
     /* Minimum probing_time. The device support check task cannot be finished
      * before this timeout expires. Once the timeout is expired, the id is reset
      * to 0. */
@@ -807,19 +849,26 @@ device_context_run_finish (MMPluginManager  *self,
     return MM_PLUGIN (g_task_propagate_pointer (G_TASK (res), error));
 }
 
+static void device_context_start_probing (DeviceContext *device_context);
+
 static void
 device_context_complete (DeviceContext *device_context)
 {
-    GTask *task;
+    MMPluginManager *self;
+    GTask           *task;
 
     /* Steal the task from the context */
     g_assert (device_context->task);
     task = device_context->task;
     device_context->task = NULL;
 
+    self = device_context->self;
+
     /* Log about the time required to complete the checks */
     mm_dbg ("[plugin manager] task %s: finished in '%lf' seconds",
             device_context->name, g_timer_elapsed (device_context->timer, NULL));
+    mm_metric_observe (device_context->self->priv->metric_device_probe_time,
+                       (guint64) (g_timer_elapsed (device_context->timer, NULL) * 1000));
 
     /* Remove signal handlers */
     if (device_context->grabbed_id) {
@@ -841,13 +890,37 @@ device_context_complete (DeviceContext *device_context)
         device_context->min_probing_time_id = 0;
     }
 
+    /* Leave the startup queue, or let the next queued device be probed */
+    if (device_context->boot_queued) {
+        device_context->boot_queued = FALSE;
+        g_queue_remove (&self->priv->boot_devices_queue, device_context);
+        device_context_unref (device_context);
+    } else if (device_context->boot_probing) {
+        device_context->boot_probing = FALSE;
+        g_assert (self->priv->n_boot_devices_probing > 0);
+        self->priv->n_boot_devices_probing--;
+    }
+
     /* Task completion */
-    if (!device_context->best_plugin)
+    if (!device_context->best_plugin) {
+        mm_metric_inc (self->priv->metric_devices_unsupported);
         g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
                                  "not supported by any plugin");
-    else
+    } else
         g_task_return_pointer (task, g_object_ref (device_context->best_plugin), g_object_unref);
     g_object_unref (task);
+
+    if (self->priv->n_boot_devices_probing < mm_context_get_boot_probe_concurrency () &&
+        !g_queue_is_empty (&self->priv->boot_devices_queue)) {
+        DeviceContext *next;
+
+        next = g_queue_pop_head (&self->priv->boot_devices_queue);
+        next->boot_queued = FALSE;
+        next->boot_probing = TRUE;
+        self->priv->n_boot_devices_probing++;
+        device_context_start_probing (next);
+        device_context_unref (next);
+    }
 }
 
 static void
@@ -1106,8 +1179,8 @@ device_context_run_port_context (DeviceContext *device_context,
     g_list_free_full (plugins, g_object_unref);
 }
 
-static gboolean
-device_context_min_wait_time_elapsed (DeviceContext *device_context)
+static void
+device_context_start_probing (DeviceContext *device_context)
 {
     MMPluginManager *self;
     GList           *l;
@@ -1115,9 +1188,6 @@ device_context_min_wait_time_elapsed (DeviceContext *device_context)
 
     self = device_context->self;
 
-    device_context->min_wait_time_id = 0;
-    mm_dbg ("[plugin manager] task %s: min wait time elapsed", device_context->name);
-
     /* Move list of port contexts out of the wait list */
     g_assert (!device_context->port_contexts);
     tmp = device_context->wait_port_contexts;
@@ -1138,6 +1208,40 @@ device_context_min_wait_time_elapsed (DeviceContext *device_context)
     }
     g_list_free (tmp);
 
+    /* Without min probing time, nothing else will complete the device
+     * context if all ports were filtered */
+    if (!device_context->port_contexts && !device_context->min_probing_time_id)
+        device_context_continue (device_context);
+}
+
+static gboolean
+device_context_min_wait_time_elapsed (DeviceContext *device_context)
+{
+    MMPluginManager *self;
+
+    self = device_context->self;
+
+    device_context->min_wait_time_id = 0;
+    mm_dbg ("[plugin manager] task %s: min wait time elapsed", device_context->name);
+
+    /* Devices found at startup are probed a few at a time, so that the first
+     * ones get ready soon instead of all of them getting ready late */
+    if (!mm_device_get_hotplugged (device_context->device)) {
+        guint max_probing;
+
+        max_probing = mm_context_get_boot_probe_concurrency ();
+        if (max_probing && self->priv->n_boot_devices_probing >= max_probing) {
+            mm_dbg ("[plugin manager] task %s: deferred until other devices are probed",
+                    device_context->name);
+            device_context->boot_queued = TRUE;
+            g_queue_push_tail (&self->priv->boot_devices_queue, device_context_ref (device_context));
+            return G_SOURCE_REMOVE;
+        }
+        device_context->boot_probing = TRUE;
+        self->priv->n_boot_devices_probing++;
+    }
+
+    device_context_start_probing (device_context);
     return G_SOURCE_REMOVE;
 }
 
@@ -1212,7 +1316,7 @@ device_context_port_grabbed (DeviceContext  *device_context,
             port_context->name);
 
     /* Îf still waiting the min wait time, store it in the waiting list */
-    if (device_context->min_wait_time_id) {
+    if (device_context->min_wait_time_id || device_context->boot_queued) {
         mm_dbg ("[plugin manager) task %s: deferred until min wait time elapsed",
                 port_context->name);
         /* Store the port reference in the list within the device */
@@ -1284,24 +1388,33 @@ device_context_run (MMPluginManager     *self,
                                                             G_CALLBACK (device_context_port_released),
                                                             device_context);
 
-    /* Set the initial waiting timeout. We don't want to probe any port before
-     * this timeout expires, so that we get as many ports added in the device
-     * as possible. If we don't do this, some plugin filters won't work properly,
-     * like the 'forbidden-drivers' one.
-     */
-    device_context->min_wait_time_id = g_timeout_add (MIN_WAIT_TIME_MSECS,
-                                                      (GSourceFunc) device_context_min_wait_time_elapsed,
-                                                      device_context);
-
-    /* Set the initial probing timeout. We force the probing time of the device to
-     * be at least this amount of time, so that the kernel has enough time to
-     * bring up ports. Given that we launch this only when the first port of the
-     * device has been exposed in udev, this timeout effectively means that we
-     * leave up to 2s to the remaining ports to appear.
-     */
-    device_context->min_probing_time_id = g_timeout_add (MIN_PROBING_TIME_MSECS,
-                                                         (GSourceFunc) device_context_min_probing_time_elapsed,
-                                                         device_context);
+    if (!mm_device_get_hotplugged (device_context->device)) {
+        /* Devices already there when scanning have all their ports grabbed
+         * right after the first one, within the same main loop iteration, so
+         * there's no need to wait for ports to show up. Just let the scan
+         * finish before probing. */
+        device_context->min_wait_time_id = g_idle_add ((GSourceFunc) device_context_min_wait_time_elapsed,
+                                                       device_context);
+    } else {
+        /* Set the initial waiting timeout. We don't want to probe any port before
+         * this timeout expires, so that we get as many ports added in the device
+         * as possible. If we don't do this, some plugin filters won't work properly,
+         * like the 'forbidden-drivers' one.
+         */
+        device_context->min_wait_time_id = g_timeout_add (MIN_WAIT_TIME_MSECS,
+                                                          (GSourceFunc) device_context_min_wait_time_elapsed,
+                                                          device_context);
+
+        /* Set the initial probing timeout. We force the probing time of the device to
+         * be at least this amount of time, so that the kernel has enough time to
+         * bring up ports. Given that we launch this only when the first port of the
+         * device has been exposed in udev, this timeout effectively means that we
+         * leave up to 2s to the remaining ports to appear.
+         */
+        device_context->min_probing_time_id = g_timeout_add (MIN_PROBING_TIME_MSECS,
+                                                             (GSourceFunc) device_context_min_probing_time_elapsed,
+                                                             device_context);
+    }
 
     /* The full device context is now cancellable. We pass this cancellable also
      * to the inner GTask, so that if we're cancelled we always return a
@@ -1491,7 +1604,7 @@ mm_plugin_manager_peek_plugin (MMPluginManager *self,
             return plugin;
     }
 
-    return NULL;
+    return plugin_manager_load_deferred_plugin (self, plugin_name);
 }
 
 /*****************************************************************************/
@@ -1557,6 +1670,165 @@ out:
     return plugin;
 }
 
+/*****************************************************************************/
+/* Deferred plugin loading
+ *
+ * When a plugin manifest file is given, the device filters of each plugin are
+ * stored in it the first time the plugin is loaded. In later runs, plugins with
+ * an up to date entry in the manifest are not loaded at startup, only once a
+ * device they may support is found; see mm-plugin-manifest.h.
+ */
+
+typedef struct {
+    gchar                 *path;
+    MMPluginManifestEntry *entry;
+} DeferredPlugin;
+
+static void
+deferred_plugin_free (DeferredPlugin *deferred)
+{
+    mm_plugin_manifest_entry_free (deferred->entry);
+    g_free (deferred->path);
+    g_slice_free (DeferredPlugin, deferred);
+}
+
+static DeferredPlugin *
+deferred_plugin_new_from_manifest (GKeyFile    *manifest,
+                                   const gchar *fname,
+                                   const gchar *path)
+{
+    DeferredPlugin        *deferred;
+    MMPluginManifestEntry *entry;
+
+    entry = mm_plugin_manifest_entry_load (manifest, fname);
+    if (!entry)
+        return NULL;
+
+    deferred = g_slice_new0 (DeferredPlugin);
+    deferred->path  = g_strdup (path);
+    deferred->entry = entry;
+    return deferred;
+}
+
+static void
+manifest_set_entry (GKeyFile       *manifest,
+                    const gchar    *fname,
+                    const GStatBuf *st,
+                    MMPlugin       *plugin)
+{
+    const gchar * const  *drivers = NULL;
+    const guint16        *vendor_ids = NULL;
+    const mm_uint16_pair *product_ids = NULL;
+    gboolean              deferrable;
+
+    /* The generic plugin is always required */
+    deferrable = (!g_str_equal (mm_plugin_get_name (plugin), MM_PLUGIN_GENERIC_NAME) &&
+                  mm_plugin_get_device_filters (plugin, &drivers, &vendor_ids, &product_ids));
+
+    mm_plugin_manifest_entry_store (manifest,
+                                    fname,
+                                    (gint64) st->st_size,
+                                    (gint64) st->st_mtime,
+                                    mm_plugin_get_name (plugin),
+                                    deferrable,
+                                    drivers,
+                                    vendor_ids,
+                                    product_ids);
+}
+
+static gboolean
+deferred_plugin_may_support_device (DeferredPlugin *deferred,
+                                    MMDevice       *device)
+{
+    return mm_plugin_manifest_entry_may_support (deferred->entry,
+                                                 mm_device_get_drivers (device),
+                                                 mm_device_get_vendor (device),
+                                                 mm_device_get_product (device));
+}
+
+static MMPlugin *load_plugin (const gchar *path);
+
+static MMPlugin *
+plugin_manager_load_deferred (MMPluginManager *self,
+                              GList           *l)
+{
+    DeferredPlugin *deferred;
+    MMPlugin       *plugin;
+
+    deferred = (DeferredPlugin *) l->data;
+    self->priv->deferred_plugins = g_list_delete_link (self->priv->deferred_plugins, l);
+
+    plugin = load_plugin (deferred->path);
+    if (plugin) {
+        mm_dbg ("[plugin manager] loaded deferred plugin '%s'", mm_plugin_get_name (plugin));
+        self->priv->plugins = g_list_append (self->priv->plugins, plugin);
+    }
+
+    deferred_plugin_free (deferred);
+    return plugin;
+}
+
+static void
+plugin_manager_load_deferred_plugins (MMPluginManager *self,
+                                      MMDevice        *device)
+{
+    GList *l;
+    GList *next;
+
+    for (l = self->priv->deferred_plugins; l; l = next) {
+        next = g_list_next (l);
+        if (deferred_plugin_may_support_device ((DeferredPlugin *) l->data, device))
+            plugin_manager_load_deferred (self, l);
+    }
+}
+
+static MMPlugin *
+plugin_manager_load_deferred_plugin (MMPluginManager *self,
+                                     const gchar     *plugin_name)
+{
+    GList *l;
+
+    for (l = self->priv->deferred_plugins; l; l = g_list_next (l)) {
+        if (g_str_equal (((DeferredPlugin *) l->data)->entry->name, plugin_name))
+            return plugin_manager_load_deferred (self, l);
+    }
+    return NULL;
+}
+
+static GKeyFile *
+manifest_load (const gchar *path)
+{
+    GKeyFile *manifest;
+    GError   *error = NULL;
+
+    manifest = g_key_file_new ();
+    if (!g_key_file_load_from_file (manifest, path, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            mm_warn ("[plugin manager] couldn't load plugin manifest: %s", error->message);
+        g_error_free (error);
+    }
+    return manifest;
+}
+
+static void
+manifest_save (GKeyFile    *manifest,
+               const gchar *path)
+{
+    gchar  *data;
+    gsize   len;
+    GError *error = NULL;
+
+    data = g_key_file_to_data (manifest, &len, NULL);
+    if (!g_file_set_contents (path, data, len, &error)) {
+        mm_warn ("[plugin manager] couldn't write plugin manifest: %s", error->message);
+        g_error_free (error);
+    } else
+        mm_dbg ("[plugin manager] plugin manifest updated");
+    g_free (data);
+}
+
+/*****************************************************************************/
+
 static gboolean
 load_plugins (MMPluginManager *self,
               GError **error)
@@ -1564,6 +1836,10 @@ load_plugins (MMPluginManager *self,
     GDir *dir = NULL;
     const gchar *fname;
     gchar *plugindir_display = NULL;
+    const gchar *manifest_path;
+    GKeyFile *manifest = NULL;
+    GHashTable *manifest_seen = NULL;
+    gboolean manifest_changed = FALSE;
 
     if (!g_module_supported ()) {
         g_set_error (error,
@@ -1587,20 +1863,53 @@ load_plugins (MMPluginManager *self,
         goto out;
     }
 
+    manifest_path = mm_context_get_plugin_manifest ();
+    if (manifest_path) {
+        manifest = manifest_load (manifest_path);
+        manifest_seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    }
+
     while ((fname = g_dir_read_name (dir)) != NULL) {
         gchar *path;
         MMPlugin *plugin;
+        GStatBuf st;
+        gboolean update_manifest = FALSE;
 
         if (!g_str_has_suffix (fname, G_MODULE_SUFFIX))
             continue;
 
         path = g_module_build_path (self->priv->plugin_dir, fname);
+
+        if (manifest && g_stat (path, &st) == 0) {
+            g_hash_table_add (manifest_seen, g_strdup (fname));
+
+            if (mm_plugin_manifest_entry_is_current (manifest, fname, (gint64) st.st_size, (gint64) st.st_mtime)) {
+                DeferredPlugin *deferred;
+
+                deferred = deferred_plugin_new_from_manifest (manifest, fname, path);
+                if (deferred) {
+                    mm_dbg ("[plugin manager] deferred loading plugin '%s'", deferred->entry->name);
+                    self->priv->deferred_plugins = g_list_append (self->priv->deferred_plugins, deferred);
+                    g_free (path);
+                    continue;
+                }
+                /* Rewrite malformed entries */
+                update_manifest = mm_plugin_manifest_entry_is_deferrable (manifest, fname);
+            } else
+                update_manifest = TRUE;
+        }
+
         plugin = load_plugin (path);
         g_free (path);
 
         if (!plugin)
             continue;
 
+        if (update_manifest) {
+            manifest_set_entry (manifest, fname, &st, plugin);
+            manifest_changed = TRUE;
+        }
+
         mm_dbg ("[plugin manager] loaded plugin '%s'", mm_plugin_get_name (plugin));
 
         if (g_str_equal (mm_plugin_get_name (plugin), MM_PLUGIN_GENERIC_NAME))
@@ -1611,12 +1920,30 @@ load_plugins (MMPluginManager *self,
             self->priv->plugins = g_list_append (self->priv->plugins, plugin);
     }
 
+    /* Drop the entries of plugins no longer installed */
+    if (manifest) {
+        gchar **groups;
+        guint   i;
+
+        groups = g_key_file_get_groups (manifest, NULL);
+        for (i = 0; groups[i]; i++) {
+            if (!g_hash_table_contains (manifest_seen, groups[i])) {
+                g_key_file_remove_group (manifest, groups[i], NULL);
+                manifest_changed = TRUE;
+            }
+        }
+        g_strfreev (groups);
+
+        if (manifest_changed)
+            manifest_save (manifest, manifest_path);
+    }
+
     /* Check the generic plugin once all looped */
     if (!self->priv->generic)
         mm_warn ("[plugin manager] generic plugin not loaded");
 
     /* Treat as error if we don't find any plugin */
-    if (!self->priv->plugins && !self->priv->generic) {
+    if (!self->priv->plugins && !self->priv->generic && !self->priv->deferred_plugins) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_NO_PLUGINS,
@@ -1625,16 +1952,21 @@ load_plugins (MMPluginManager *self,
         goto out;
     }
 
-    mm_dbg ("[plugin manager] successfully loaded %u plugins",
-            g_list_length (self->priv->plugins) + !!self->priv->generic);
+    mm_dbg ("[plugin manager] successfully loaded %u plugins (%u deferred)",
+            g_list_length (self->priv->plugins) + !!self->priv->generic,
+            g_list_length (self->priv->deferred_plugins));
 
 out:
+    if (manifest_seen)
+        g_hash_table_unref (manifest_seen);
+    if (manifest)
+        g_key_file_free (manifest);
     if (dir)
         g_dir_close (dir);
     g_free (plugindir_display);
 
     /* Return TRUE if at least one plugin found */
-    return (self->priv->plugins || self->priv->generic);
+    return (self->priv->plugins || self->priv->generic || self->priv->deferred_plugins);
 }
 
 MMPluginManager *
@@ -1657,6 +1989,13 @@ mm_plugin_manager_init (MMPluginManager *manager)
     manager->priv = G_TYPE_INSTANCE_GET_PRIVATE (manager,
                                                  MM_TYPE_PLUGIN_MANAGER,
                                                  MMPluginManagerPrivate);
+
+    g_queue_init (&manager->priv->boot_devices_queue);
+
+    manager->priv->metric_port_probe_time     = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_probe_port_time_ms",             NULL);
+    manager->priv->metric_ports_probing       = mm_metrics_get (MM_METRIC_TYPE_GAUGE,     "mm_probe_ports_in_progress",        NULL);
+    manager->priv->metric_device_probe_time   = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_probe_device_time_ms",           NULL);
+    manager->priv->metric_devices_unsupported = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_probe_devices_unsupported_total", NULL);
 }
 
 static void
@@ -1722,12 +2061,21 @@ dispose (GObject *object)
         self->priv->plugins = NULL;
     }
     g_clear_object (&self->priv->generic);
+    if (self->priv->deferred_plugins) {
+        g_list_free_full (self->priv->deferred_plugins, (GDestroyNotify) deferred_plugin_free);
+        self->priv->deferred_plugins = NULL;
+    }
 
     g_free (self->priv->plugin_dir);
     self->priv->plugin_dir = NULL;
 
     g_clear_object (&self->priv->filter);
 
+    g_clear_pointer (&self->priv->metric_port_probe_time,     mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_ports_probing,       mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_device_probe_time,   mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_devices_unsupported, mm_metric_unref);
+
     G_OBJECT_CLASS (mm_plugin_manager_parent_class)->dispose (object);
 }
 
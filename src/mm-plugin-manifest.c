@@ -0,0 +1,309 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <string.h>
+
+#include "mm-plugin-manifest.h"
+
+/*****************************************************************************/
+
+void
+mm_filter_device_ids (const guint16        *vendor_ids,
+                      const mm_uint16_pair *product_ids,
+                      guint16               vendor,
+                      guint16               product,
+                      gboolean             *out_vendor_filtered,
+                      gboolean             *out_product_filtered)
+{
+    gboolean vendor_filtered = FALSE;
+    gboolean product_filtered = FALSE;
+    guint    i;
+
+    /* Only some vendor IDs supported */
+    if (vendor_ids) {
+        /* If we didn't get any vendor: filtered */
+        if (!vendor)
+            vendor_filtered = TRUE;
+        else {
+            for (i = 0; vendor_ids[i]; i++)
+                if (vendor == vendor_ids[i])
+                    break;
+
+            /* If we didn't match any vendor: filtered */
+            if (!vendor_ids[i])
+                vendor_filtered = TRUE;
+        }
+    }
+
+    /* Only some vendor+product ID pairs supported */
+    if (product_ids) {
+        /* If we didn't get any product: filtered */
+        if (!product || !vendor)
+            product_filtered = TRUE;
+        else {
+            for (i = 0; product_ids[i].l; i++)
+                if (vendor == product_ids[i].l &&
+                    product == product_ids[i].r)
+                    break;
+
+            /* If we didn't match any product: filtered */
+            if (!product_ids[i].l)
+                product_filtered = TRUE;
+        }
+
+        /* When both vendor ids and product ids are given, it may be the case that
+         * we're allowing a full VID1 and only a subset of another VID2, so try to
+         * handle that properly. */
+        if (vendor_filtered && !product_filtered)
+            vendor_filtered = FALSE;
+        if (product_filtered && vendor_ids && !vendor_filtered)
+            product_filtered = FALSE;
+    }
+
+    *out_vendor_filtered = vendor_filtered;
+    *out_product_filtered = product_filtered;
+}
+
+/*****************************************************************************/
+
+#define MANIFEST_KEY_NAME        "name"
+#define MANIFEST_KEY_SIZE        "size"
+#define MANIFEST_KEY_MTIME       "mtime"
+#define MANIFEST_KEY_DEFERRABLE  "deferrable"
+#define MANIFEST_KEY_DRIVERS     "drivers"
+#define MANIFEST_KEY_VENDOR_IDS  "vendor-ids"
+#define MANIFEST_KEY_PRODUCT_IDS "product-ids"
+
+void
+mm_plugin_manifest_entry_free (MMPluginManifestEntry *entry)
+{
+    g_free (entry->product_ids);
+    g_free (entry->vendor_ids);
+    g_strfreev (entry->drivers);
+    g_free (entry->name);
+    g_slice_free (MMPluginManifestEntry, entry);
+}
+
+static gboolean
+parse_id (const gchar *str,
+          const gchar *end,
+          guint16     *out)
+{
+    guint64  value;
+    gchar   *parsed_end = NULL;
+
+    value = g_ascii_strtoull (str, &parsed_end, 16);
+    if (parsed_end == str || parsed_end != end || value == 0 || value > G_MAXUINT16)
+        return FALSE;
+    *out = (guint16) value;
+    return TRUE;
+}
+
+static guint16 *
+manifest_get_vendor_ids (GKeyFile    *manifest,
+                         const gchar *group)
+{
+    GArray  *array;
+    gchar  **strv;
+    guint    i;
+
+    strv = g_key_file_get_string_list (manifest, group, MANIFEST_KEY_VENDOR_IDS, NULL, NULL);
+    if (!strv)
+        return NULL;
+
+    array = g_array_new (TRUE, FALSE, sizeof (guint16));
+    for (i = 0; strv[i]; i++) {
+        guint16 vid;
+
+        if (!parse_id (strv[i], strv[i] + strlen (strv[i]), &vid)) {
+            g_array_unref (array);
+            array = NULL;
+            break;
+        }
+        g_array_append_val (array, vid);
+    }
+    g_strfreev (strv);
+    return (array ? (guint16 *) g_array_free (array, FALSE) : NULL);
+}
+
+static mm_uint16_pair *
+manifest_get_product_ids (GKeyFile    *manifest,
+                          const gchar *group)
+{
+    GArray  *array;
+    gchar  **strv;
+    guint    i;
+
+    strv = g_key_file_get_string_list (manifest, group, MANIFEST_KEY_PRODUCT_IDS, NULL, NULL);
+    if (!strv)
+        return NULL;
+
+    array = g_array_new (TRUE, FALSE, sizeof (mm_uint16_pair));
+    for (i = 0; strv[i]; i++) {
+        mm_uint16_pair  pair;
+        const gchar    *separator;
+
+        separator = strchr (strv[i], ':');
+        if (!separator ||
+            !parse_id (strv[i], separator, &pair.l) ||
+            !parse_id (separator + 1, separator + 1 + strlen (separator + 1), &pair.r)) {
+            g_array_unref (array);
+            array = NULL;
+            break;
+        }
+        g_array_append_val (array, pair);
+    }
+    g_strfreev (strv);
+    return (array ? (mm_uint16_pair *) g_array_free (array, FALSE) : NULL);
+}
+
+gboolean
+mm_plugin_manifest_entry_is_current (GKeyFile    *manifest,
+                                     const gchar *fname,
+                                     gint64       size,
+                                     gint64       mtime)
+{
+    GError *error = NULL;
+    gint64  stored_size;
+    gint64  stored_mtime = 0;
+
+    if (!g_key_file_has_group (manifest, fname))
+        return FALSE;
+
+    stored_size = g_key_file_get_int64 (manifest, fname, MANIFEST_KEY_SIZE, &error);
+    if (!error)
+        stored_mtime = g_key_file_get_int64 (manifest, fname, MANIFEST_KEY_MTIME, &error);
+    if (error) {
+        g_error_free (error);
+        return FALSE;
+    }
+
+    return (stored_size == size && stored_mtime == mtime);
+}
+
+gboolean
+mm_plugin_manifest_entry_is_deferrable (GKeyFile    *manifest,
+                                        const gchar *fname)
+{
+    return g_key_file_get_boolean (manifest, fname, MANIFEST_KEY_DEFERRABLE, NULL);
+}
+
+MMPluginManifestEntry *
+mm_plugin_manifest_entry_load (GKeyFile    *manifest,
+                               const gchar *fname)
+{
+    MMPluginManifestEntry *entry;
+
+    if (!mm_plugin_manifest_entry_is_deferrable (manifest, fname))
+        return NULL;
+
+    entry = g_slice_new0 (MMPluginManifestEntry);
+    entry->name        = g_key_file_get_string (manifest, fname, MANIFEST_KEY_NAME, NULL);
+    entry->drivers     = g_key_file_get_string_list (manifest, fname, MANIFEST_KEY_DRIVERS, NULL, NULL);
+    entry->vendor_ids  = manifest_get_vendor_ids (manifest, fname);
+    entry->product_ids = manifest_get_product_ids (manifest, fname);
+
+    /* Malformed entries, or without any filter, make the plugin load right away */
+    if (!entry->name ||
+        (g_key_file_has_key (manifest, fname, MANIFEST_KEY_VENDOR_IDS, NULL) && !entry->vendor_ids) ||
+        (g_key_file_has_key (manifest, fname, MANIFEST_KEY_PRODUCT_IDS, NULL) && !entry->product_ids) ||
+        (!entry->drivers && !entry->vendor_ids && !entry->product_ids)) {
+        mm_plugin_manifest_entry_free (entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+void
+mm_plugin_manifest_entry_store (GKeyFile             *manifest,
+                                const gchar          *fname,
+                                gint64                size,
+                                gint64                mtime,
+                                const gchar          *name,
+                                gboolean              deferrable,
+                                const gchar * const  *drivers,
+                                const guint16        *vendor_ids,
+                                const mm_uint16_pair *product_ids)
+{
+    g_key_file_remove_group (manifest, fname, NULL);
+    g_key_file_set_string (manifest, fname, MANIFEST_KEY_NAME, name);
+    g_key_file_set_int64 (manifest, fname, MANIFEST_KEY_SIZE, size);
+    g_key_file_set_int64 (manifest, fname, MANIFEST_KEY_MTIME, mtime);
+    g_key_file_set_boolean (manifest, fname, MANIFEST_KEY_DEFERRABLE, deferrable);
+    if (!deferrable)
+        return;
+
+    if (drivers)
+        g_key_file_set_string_list (manifest, fname, MANIFEST_KEY_DRIVERS,
+                                    drivers, g_strv_length ((gchar **) drivers));
+
+    if (vendor_ids) {
+        GPtrArray *strv;
+        guint      i;
+
+        strv = g_ptr_array_new_with_free_func (g_free);
+        for (i = 0; vendor_ids[i]; i++)
+            g_ptr_array_add (strv, g_strdup_printf ("%04x", vendor_ids[i]));
+        g_key_file_set_string_list (manifest, fname, MANIFEST_KEY_VENDOR_IDS,
+                                    (const gchar * const *) strv->pdata, strv->len);
+        g_ptr_array_unref (strv);
+    }
+
+    if (product_ids) {
+        GPtrArray *strv;
+        guint      i;
+
+        strv = g_ptr_array_new_with_free_func (g_free);
+        for (i = 0; product_ids[i].l; i++)
+            g_ptr_array_add (strv, g_strdup_printf ("%04x:%04x", product_ids[i].l, product_ids[i].r));
+        g_key_file_set_string_list (manifest, fname, MANIFEST_KEY_PRODUCT_IDS,
+                                    (const gchar * const *) strv->pdata, strv->len);
+        g_ptr_array_unref (strv);
+    }
+}
+
+gboolean
+mm_plugin_manifest_entry_may_support (const MMPluginManifestEntry  *entry,
+                                      const gchar                 **drivers,
+                                      guint16                       vendor,
+                                      guint16                       product)
+{
+    gboolean vendor_filtered;
+    gboolean product_filtered;
+    guint    i;
+
+    /* Nothing to match against, e.g. in virtual devices */
+    if (!drivers && !vendor)
+        return TRUE;
+
+    if (entry->drivers) {
+        gboolean found = FALSE;
+
+        for (i = 0; drivers && drivers[i] && !found; i++) {
+            guint j;
+
+            for (j = 0; entry->drivers[j] && !found; j++)
+                found = g_str_equal (drivers[i], entry->drivers[j]);
+        }
+        if (!found)
+            return FALSE;
+    }
+
+    mm_filter_device_ids (entry->vendor_ids, entry->product_ids,
+                          vendor, product,
+                          &vendor_filtered, &product_filtered);
+    return (!vendor_filtered && !product_filtered);
+}
@@ -0,0 +1,88 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_PLUGIN_MANIFEST_H
+#define MM_PLUGIN_MANIFEST_H
+
+#include <glib.h>
+
+#include "mm-private-boxed-types.h"
+
+/*****************************************************************************/
+/* Device ID filters
+ *
+ * Matches the vendor and product IDs of a device against the vendor ID list
+ * and the vendor/product ID pair list of a plugin, either of them optional
+ * and zero-terminated. When both lists are given, a device is accepted if it
+ * matches any of them, so that a plugin may allow a full vendor and only some
+ * products of another one. */
+
+void mm_filter_device_ids (const guint16        *vendor_ids,
+                           const mm_uint16_pair *product_ids,
+                           guint16               vendor,
+                           guint16               product,
+                           gboolean             *out_vendor_filtered,
+                           gboolean             *out_product_filtered);
+
+/*****************************************************************************/
+/* Plugin manifest
+ *
+ * Key file storing the device filters of each plugin, so that plugins may be
+ * loaded only once a device they may support is found. Entries are keyed by
+ * the plugin file name, and they're considered up to date as long as the size
+ * and modification time of the file didn't change. */
+
+typedef struct {
+    gchar          *name;
+    gchar         **drivers;
+    guint16        *vendor_ids;  /* zero-terminated */
+    mm_uint16_pair *product_ids; /* zero-terminated */
+} MMPluginManifestEntry;
+
+void mm_plugin_manifest_entry_free (MMPluginManifestEntry *entry);
+
+gboolean mm_plugin_manifest_entry_is_current (GKeyFile    *manifest,
+                                              const gchar *fname,
+                                              gint64       size,
+                                              gint64       mtime);
+
+/* Returns NULL if the plugin can't be deferred, or if the entry is malformed
+ * or has no filter at all */
+MMPluginManifestEntry *mm_plugin_manifest_entry_load (GKeyFile    *manifest,
+                                                      const gchar *fname);
+
+/* Any previous entry for the same file is replaced. Filters are only stored
+ * if @deferrable is TRUE. */
+void mm_plugin_manifest_entry_store (GKeyFile             *manifest,
+                                     const gchar          *fname,
+                                     gint64                size,
+                                     gint64                mtime,
+                                     const gchar          *name,
+                                     gboolean              deferrable,
+                                     const gchar * const  *drivers,
+                                     const guint16        *vendor_ids,
+                                     const mm_uint16_pair *product_ids);
+
+gboolean mm_plugin_manifest_entry_is_deferrable (GKeyFile    *manifest,
+                                                 const gchar *fname);
+
+/* Whether the plugin may support a device with the given drivers and IDs,
+ * i.e. whether it needs to be loaded when the device is found */
+gboolean mm_plugin_manifest_entry_may_support (const MMPluginManifestEntry  *entry,
+                                               const gchar                 **drivers,
+                                               guint16                       vendor,
+                                               guint16                       product);
+
+#endif /* MM_PLUGIN_MANIFEST_H */
@@ -34,6 +34,7 @@
 #include "mm-port-serial-qcdm.h"
 #include "mm-serial-parsers.h"
 #include "mm-private-boxed-types.h"
+#include "mm-plugin-manifest.h"
 #include "mm-log.h"
 #include "mm-daemon-enums-types.h"
 
@@ -134,6 +135,28 @@ mm_plugin_get_name (MMPlugin *self)
     return self->priv->name;
 }
 
+gboolean
+mm_plugin_get_device_filters (MMPlugin              *self,
+                              const gchar * const  **drivers,
+                              const guint16        **vendor_ids,
+                              const mm_uint16_pair **product_ids)
+{
+    /* Vendor and product IDs only discard devices when there are no vendor or
+     * product strings to match after probing; see apply_pre_probing_filters() */
+    if (self->priv->vendor_strings ||
+        self->priv->product_strings ||
+        self->priv->forbidden_product_strings) {
+        *vendor_ids = NULL;
+        *product_ids = NULL;
+    } else {
+        *vendor_ids = self->priv->vendor_ids;
+        *product_ids = self->priv->product_ids;
+    }
+    *drivers = (const gchar * const *) self->priv->drivers;
+
+    return (*drivers || *vendor_ids || *product_ids);
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -205,8 +228,8 @@ apply_pre_probing_filters (MMPlugin       *self,
 {
     guint16 vendor;
     guint16 product;
-    gboolean product_filtered = FALSE;
-    gboolean vendor_filtered = FALSE;
+    gboolean product_filtered;
+    gboolean vendor_filtered;
     guint i;
 
     *need_vendor_probing = FALSE;
@@ -325,48 +348,14 @@ apply_pre_probing_filters (MMPlugin       *self,
     vendor = mm_device_get_vendor (device);
     product = mm_device_get_product (device);
 
-    /* The plugin may specify that only some vendor IDs are supported. If that
-     * is the case, filter by vendor ID. */
-    if (self->priv->vendor_ids) {
-        /* If we didn't get any vendor: filtered */
-        if (!vendor)
-            vendor_filtered = TRUE;
-        else {
-            for (i = 0; self->priv->vendor_ids[i]; i++)
-                if (vendor == self->priv->vendor_ids[i])
-                    break;
-
-            /* If we didn't match any vendor: filtered */
-            if (!self->priv->vendor_ids[i])
-                vendor_filtered = TRUE;
-        }
-    }
-
-    /* The plugin may specify that only some product IDs are supported. If
-     * that is the case, filter by vendor+product ID pair */
-    if (self->priv->product_ids) {
-        /* If we didn't get any product: filtered */
-        if (!product || !vendor)
-            product_filtered = TRUE;
-        else {
-            for (i = 0; self->priv->product_ids[i].l; i++)
-                if (vendor == self->priv->product_ids[i].l &&
-                    product == self->priv->product_ids[i].r)
-                    break;
-
-            /* If we didn't match any product: filtered */
-            if (!self->priv->product_ids[i].l)
-                product_filtered = TRUE;
-        }
-
-        /* When both vendor ids and product ids are given, it may be the case that
-         * we're allowing a full VID1 and only a subset of another VID2, so try to
-         * handle that properly. */
-        if (vendor_filtered && !product_filtered)
-            vendor_filtered = FALSE;
-        if (product_filtered && self->priv->vendor_ids && !vendor_filtered)
-            product_filtered = FALSE;
-    }
+    /* The plugin may specify that only some vendor IDs or vendor+product ID
+     * pairs are supported. If that is the case, filter by them. */
+    mm_filter_device_ids (self->priv->vendor_ids,
+                          self->priv->product_ids,
+                          vendor,
+                          product,
+                          &vendor_filtered,
+                          &product_filtered);
 
     /* If we got filtered by vendor or product IDs; mark it as unsupported only if:
      *   a) we do not have vendor or product strings to compare with (i.e. plugin
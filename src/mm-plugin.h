@@ -26,6 +26,7 @@
 #include "mm-port-probe.h"
 #include "mm-device.h"
 #include "mm-kernel-device.h"
+#include "mm-private-boxed-types.h"
 
 #define MM_PLUGIN_GENERIC_NAME "Generic"
 #define MM_PLUGIN_MAJOR_VERSION 4
@@ -126,6 +127,13 @@ GType mm_plugin_get_type (void);
 
 const gchar *mm_plugin_get_name (MMPlugin *plugin);
 
+/* Filters that may discard a whole device before any of its ports is probed,
+ * or NULL if not applicable. Returns FALSE if the plugin has none of them. */
+gboolean mm_plugin_get_device_filters (MMPlugin              *plugin,
+                                       const gchar * const  **drivers,
+                                       const guint16        **vendor_ids,
+                                       const mm_uint16_pair **product_ids);
+
 /* This method will run all pre-probing filters, to see if we can discard this
  * plugin from the probing logic as soon as possible. */
 MMPluginSupportsHint mm_plugin_discard_port_early (MMPlugin       *plugin,
@@ -27,6 +27,7 @@
 
 #include "mm-port-mbim.h"
 #include "mm-log.h"
+#include "mm-metrics.h"
 
 G_DEFINE_TYPE (MMPortMbim, mm_port_mbim, MM_TYPE_PORT)
 
@@ -37,6 +38,13 @@ struct _MMPortMbimPrivate {
     QmiDevice  *qmi_device;
     GList      *qmi_clients;
 #endif
+
+    /* Metrics, setup on the first open attempt */
+    gint64      open_start_time;
+    gulong      indicate_status_id;
+    MMMetric   *metric_open_time;
+    MMMetric   *metric_open_failures;
+    MMMetric   *metric_indications;
 };
 
 /*****************************************************************************/
@@ -234,6 +242,24 @@ qmi_device_new_ready (GObject      *unused,
 
 #endif
 
+static void
+mbim_device_indicate_status_cb (MbimDevice  *device,
+                                MbimMessage *notification,
+                                MMPortMbim  *self)
+{
+    mm_metric_inc (self->priv->metric_indications);
+}
+
+static void
+port_mbim_indications_unwatch (MMPortMbim *self)
+{
+    if (self->priv->indicate_status_id) {
+        g_assert (self->priv->mbim_device);
+        g_signal_handler_disconnect (self->priv->mbim_device, self->priv->indicate_status_id);
+        self->priv->indicate_status_id = 0;
+    }
+}
+
 static void
 mbim_device_open_ready (MbimDevice   *mbim_device,
                         GAsyncResult *res,
@@ -244,7 +270,11 @@ mbim_device_open_ready (MbimDevice   *mbim_device,
 
     self = g_task_get_source_object (task);
 
+    mm_metric_observe (self->priv->metric_open_time,
+                       (g_get_monotonic_time () - self->priv->open_start_time) / 1000);
+
     if (!mbim_device_open_full_finish (mbim_device, res, &error)) {
+        mm_metric_inc (self->priv->metric_open_failures);
         g_clear_object (&self->priv->mbim_device);
         self->priv->in_progress = FALSE;
         g_task_return_error (task, error);
@@ -255,6 +285,12 @@ mbim_device_open_ready (MbimDevice   *mbim_device,
     mm_dbg ("[%s] MBIM device is now open",
             mm_port_get_device (MM_PORT (self)));
 
+    g_assert (!self->priv->indicate_status_id);
+    self->priv->indicate_status_id = g_signal_connect (self->priv->mbim_device,
+                                                       MBIM_DEVICE_SIGNAL_INDICATE_STATUS,
+                                                       G_CALLBACK (mbim_device_indicate_status_cb),
+                                                       self);
+
 #if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
     {
         GFile *file;
@@ -288,6 +324,7 @@ mbim_device_new_ready (GObject      *unused,
     self = g_task_get_source_object (task);
     self->priv->mbim_device = mbim_device_new_finish (res, &error);
     if (!self->priv->mbim_device) {
+        mm_metric_inc (self->priv->metric_open_failures);
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
@@ -334,6 +371,16 @@ mm_port_mbim_open (MMPortMbim          *self,
         return;
     }
 
+    if (!self->priv->metric_open_time) {
+        const gchar *device;
+
+        device = mm_port_get_device (MM_PORT (self));
+        self->priv->metric_open_time     = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_mbim_open_time_ms",       device);
+        self->priv->metric_open_failures = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_mbim_open_failures_total", device);
+        self->priv->metric_indications   = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_mbim_indications_total",  device);
+    }
+    self->priv->open_start_time = g_get_monotonic_time ();
+
     fullpath = g_strdup_printf ("/dev/%s", mm_port_get_device (MM_PORT (self)));
     file = g_file_new_for_path (fullpath);
 
@@ -433,6 +480,7 @@ mm_port_mbim_close (MMPortMbim *self,
     }
 #endif
 
+    port_mbim_indications_unwatch (self);
     mbim_device_close (self->priv->mbim_device,
                        5,
                        NULL,
@@ -481,8 +529,13 @@ dispose (GObject *object)
 #endif
 
     /* Clear device object */
+    port_mbim_indications_unwatch (self);
     g_clear_object (&self->priv->mbim_device);
 
+    g_clear_pointer (&self->priv->metric_open_time,     mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_open_failures, mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_indications,   mm_metric_unref);
+
     G_OBJECT_CLASS (mm_port_mbim_parent_class)->dispose (object);
 }
 
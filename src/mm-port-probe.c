@@ -37,6 +37,7 @@
 #include "libqcdm/src/errors.h"
 #include "mm-port-serial-qcdm.h"
 #include "mm-daemon-enums-types.h"
+#include "mm-probe-scheduler.h"
 
 #if defined WITH_QMI
 #include "mm-port-qmi.h"
@@ -361,6 +362,10 @@ typedef struct {
     guint32 flags;
     guint source_id;
     GCancellable *cancellable;
+    /* Probing slot, kept until the probing is finished */
+    MMProbeSchedulerTicket *ticket;
+    gulong ticket_cancelled_id;
+    GSourceFunc first_step;
 
     /* ---- Serial probing specific context ---- */
 
@@ -411,6 +416,16 @@ static void     serial_probe_schedule (MMPortProbe *self);
 static void
 port_probe_run_context_free (PortProbeRunContext *ctx)
 {
+    if (ctx->cancellable && ctx->ticket_cancelled_id) {
+        g_cancellable_disconnect (ctx->cancellable, ctx->ticket_cancelled_id);
+        ctx->ticket_cancelled_id = 0;
+    }
+
+    if (ctx->ticket) {
+        mm_probe_scheduler_release (ctx->ticket);
+        ctx->ticket = NULL;
+    }
+
     if (ctx->cancellable && ctx->at_probing_cancellable_linked) {
         g_cancellable_disconnect (ctx->cancellable, ctx->at_probing_cancellable_linked);
         ctx->at_probing_cancellable_linked = 0;
@@ -1080,6 +1095,7 @@ serial_probe_at (MMPortProbe *self)
         ctx->at_commands->timeout,
         FALSE,
         FALSE,
+        MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
         ctx->at_probing_cancellable,
         (GAsyncReadyCallback)serial_probe_at_parse_response,
         self);
@@ -1410,6 +1426,75 @@ mm_port_probe_run_cancel_at_probing (MMPortProbe *self)
     return TRUE;
 }
 
+static void
+port_probe_run_ticket_ready (MMPortProbe *self)
+{
+    PortProbeRunContext *ctx;
+
+    g_assert (self->priv->task);
+    ctx = g_task_get_task_data (self->priv->task);
+
+    if (ctx->ticket_cancelled_id) {
+        g_cancellable_disconnect (ctx->cancellable, ctx->ticket_cancelled_id);
+        ctx->ticket_cancelled_id = 0;
+    }
+
+    ctx->first_step (self);
+}
+
+static void
+port_probe_run_ticket_cancelled (GCancellable *cancellable,
+                                 MMPortProbe  *self)
+{
+    PortProbeRunContext *ctx;
+
+    g_assert (self->priv->task);
+    ctx = g_task_get_task_data (self->priv->task);
+
+    /* Avoid trying to disconnect cancellable on the handler, or we'll deadlock */
+    ctx->ticket_cancelled_id = 0;
+
+    /* Don't wait for the slot; the first step completes the task right away
+     * when cancelled */
+    mm_probe_scheduler_release (ctx->ticket);
+    ctx->ticket = NULL;
+    ctx->source_id = g_idle_add (ctx->first_step, self);
+}
+
+static void
+port_probe_run_schedule (MMPortProbe *self,
+                         GSourceFunc  first_step)
+{
+    PortProbeRunContext *ctx;
+    gchar               *group = NULL;
+    gboolean             priority;
+
+    ctx = g_task_get_task_data (self->priv->task);
+    ctx->first_step = first_step;
+
+    /* Limit the probings on the same USB hub, as some USB to serial bridges
+     * don't cope well with many ports being flashed and probed at once */
+    if (!g_strcmp0 (mm_kernel_device_get_physdev_subsystem (self->priv->port), "usb") &&
+        mm_kernel_device_get_physdev_sysfs_path (self->priv->port))
+        group = g_path_get_dirname (mm_kernel_device_get_physdev_sysfs_path (self->priv->port));
+
+    /* Ports expected to be the main control port of the modem go first */
+    priority = (self->priv->maybe_at_primary ||
+                g_str_has_prefix (mm_kernel_device_get_name (self->priv->port), "cdc-wdm"));
+
+    ctx->ticket = mm_probe_scheduler_request (group,
+                                              priority,
+                                              (MMProbeSchedulerReadyFunc) port_probe_run_ticket_ready,
+                                              self);
+    g_free (group);
+
+    if (ctx->cancellable)
+        ctx->ticket_cancelled_id = g_cancellable_connect (ctx->cancellable,
+                                                          G_CALLBACK (port_probe_run_ticket_cancelled),
+                                                          self,
+                                                          NULL);
+}
+
 gboolean
 mm_port_probe_run_finish (MMPortProbe   *self,
                           GAsyncResult  *result,
@@ -1531,19 +1616,19 @@ mm_port_probe_run (MMPortProbe                *self,
                                                                         (GCallback) at_cancellable_cancel,
                                                                         ctx,
                                                                         NULL);
-        ctx->source_id = g_idle_add ((GSourceFunc) serial_open_at, self);
+        port_probe_run_schedule (self, (GSourceFunc) serial_open_at);
         return;
     }
 
     /* If QCDM probing needed, start by opening as QCDM port */
     if (ctx->flags & MM_PORT_PROBE_QCDM) {
-        ctx->source_id = g_idle_add ((GSourceFunc) serial_probe_qcdm, self);
+        port_probe_run_schedule (self, (GSourceFunc) serial_probe_qcdm);
         return;
     }
 
     /* If QMI/MBIM probing needed, go on */
     if (ctx->flags & MM_PORT_PROBE_QMI || ctx->flags & MM_PORT_PROBE_MBIM) {
-        ctx->source_id = g_idle_add ((GSourceFunc) wdm_probe, self);
+        port_probe_run_schedule (self, (GSourceFunc) wdm_probe);
         return;
     }
 
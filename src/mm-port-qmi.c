@@ -23,6 +23,7 @@
 
 #include "mm-port-qmi.h"
 #include "mm-log.h"
+#include "mm-metrics.h"
 
 G_DEFINE_TYPE (MMPortQmi, mm_port_qmi, MM_TYPE_PORT)
 
@@ -37,6 +38,12 @@ struct _MMPortQmiPrivate {
     QmiDevice *qmi_device;
     GList *services;
     gboolean llp_is_raw_ip;
+
+    /* Metrics, setup on the first open attempt */
+    MMMetric *metric_open_time;
+    MMMetric *metric_open_failures;
+    MMMetric *metric_client_allocations;
+    MMMetric *metric_client_allocation_failures;
 };
 
 /*****************************************************************************/
@@ -117,12 +124,14 @@ allocate_client_ready (QmiDevice *qmi_device,
     ctx = g_task_get_task_data (task);
     ctx->info->client = qmi_device_allocate_client_finish (qmi_device, res, &error);
     if (!ctx->info->client) {
+        mm_metric_inc (self->priv->metric_client_allocation_failures);
         g_prefix_error (&error,
                         "Couldn't create client for service '%s': ",
                         qmi_service_get_string (ctx->info->service));
         g_task_return_error (task, error);
     } else {
         /* Move the service info to our internal list */
+        mm_metric_inc (self->priv->metric_client_allocations);
         self->priv->services = g_list_prepend (self->priv->services, ctx->info);
         ctx->info = NULL;
         g_task_return_boolean (task, TRUE);
@@ -204,6 +213,7 @@ typedef struct {
     QmiClient *wda;
     GError *error;
     PortOpenStep step;
+    gint64 start_time;
     gboolean set_data_format;
     QmiDeviceExpectedDataFormat kernel_data_format;
     QmiWdaLinkLayerProtocol llp;
@@ -522,7 +532,10 @@ port_open_step (GTask *task)
         /* Reset opening flag */
         self->priv->opening = FALSE;
 
+        mm_metric_observe (self->priv->metric_open_time, (g_get_monotonic_time () - ctx->start_time) / 1000);
+
         if (ctx->error) {
+            mm_metric_inc (self->priv->metric_open_failures);
             /* Propagate error */
             if (ctx->device)
                 qmi_device_close (ctx->device, NULL);
@@ -552,8 +565,19 @@ mm_port_qmi_open (MMPortQmi *self,
 
     g_return_if_fail (MM_IS_PORT_QMI (self));
 
+    if (!self->priv->metric_open_time) {
+        const gchar *device;
+
+        device = mm_port_get_device (MM_PORT (self));
+        self->priv->metric_open_time                  = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_qmi_open_time_ms",                     device);
+        self->priv->metric_open_failures              = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_qmi_open_failures_total",              device);
+        self->priv->metric_client_allocations         = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_qmi_client_allocations_total",         device);
+        self->priv->metric_client_allocation_failures = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_qmi_client_allocation_failures_total", device);
+    }
+
     ctx = g_slice_new0 (PortOpenContext);
     ctx->step = PORT_OPEN_STEP_FIRST;
+    ctx->start_time = g_get_monotonic_time ();
     ctx->set_data_format = set_data_format;
     ctx->kernel_data_format = QMI_DEVICE_EXPECTED_DATA_FORMAT_UNKNOWN;
     ctx->llp = QMI_WDA_LINK_LAYER_PROTOCOL_UNKNOWN;
@@ -644,6 +668,11 @@ dispose (GObject *object)
     /* Clear device object */
     g_clear_object (&self->priv->qmi_device);
 
+    g_clear_pointer (&self->priv->metric_open_time,                  mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_open_failures,              mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_client_allocations,         mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_client_allocation_failures, mm_metric_unref);
+
     G_OBJECT_CLASS (mm_port_qmi_parent_class)->dispose (object);
 }
 
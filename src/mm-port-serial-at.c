@@ -23,6 +23,7 @@
 
 #include "mm-port-serial-at.h"
 #include "mm-log.h"
+#include "mm-metrics.h"
 
 G_DEFINE_TYPE (MMPortSerialAt, mm_port_serial_at, MM_TYPE_PORT_SERIAL)
 
@@ -50,6 +51,9 @@ struct _MMPortSerialAtPrivate {
     guint init_sequence_enabled;
     gchar **init_sequence;
     gboolean send_lf;
+
+    /* Unsolicited messages handled, created on the first one */
+    MMMetric *metric_urcs;
 };
 
 /*****************************************************************************/
@@ -162,9 +166,12 @@ parse_response (MMPortSerial *port,
         return MM_PORT_SERIAL_RESPONSE_ERROR;
     }
 
-    /* Otherwise, build a new GByteArray considered as parsed response */
+    /* Otherwise, build a new GByteArray considered as parsed response. The
+     * trailing NUL byte is kept in the array storage, so that the response
+     * can be used as a string without copying it. */
     parsed_len = string->len;
-    *parsed_response = g_byte_array_new_take ((guint8 *) g_string_free (string, FALSE), parsed_len);
+    *parsed_response = g_byte_array_new_take ((guint8 *) g_string_free (string, FALSE), parsed_len + 1);
+    g_byte_array_set_size (*parsed_response, parsed_len);
     return MM_PORT_SERIAL_RESPONSE_BUFFER;
 }
 
@@ -281,6 +288,11 @@ parse_unsolicited (MMPortSerial *port, GByteArray *response)
                                       0, 0, &match_info, NULL);
         if (handler->callback) {
             while (g_match_info_matches (match_info)) {
+                if (G_UNLIKELY (!self->priv->metric_urcs))
+                    self->priv->metric_urcs = mm_metrics_get (MM_METRIC_TYPE_COUNTER,
+                                                              "mm_serial_urcs_total",
+                                                              mm_port_get_device (MM_PORT (self)));
+                mm_metric_inc (self->priv->metric_urcs);
                 handler->callback (self, match_info, handler->user_data);
                 g_match_info_next (match_info, NULL);
             }
@@ -400,6 +412,7 @@ mm_port_serial_at_command (MMPortSerialAt *self,
                            guint32 timeout_seconds,
                            gboolean is_raw,
                            gboolean allow_cached,
+                           MMPortSerialCommandPriority priority,
                            GCancellable *cancellable,
                            GAsyncReadyCallback callback,
                            gpointer user_data)
@@ -427,12 +440,73 @@ mm_port_serial_at_command (MMPortSerialAt *self,
                             buf,
                             timeout_seconds,
                             allow_cached,
+                            priority,
                             cancellable,
                             (GAsyncReadyCallback)serial_command_ready,
                             simple);
     g_byte_array_unref (buf);
 }
 
+const gchar *
+mm_port_serial_at_command_borrowed_finish (MMPortSerialAt *self,
+                                           GAsyncResult *res,
+                                           gsize *response_len,
+                                           GError **error)
+{
+    GByteArray *response;
+
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    /* Parsed responses already have room for the trailing NUL byte, but
+     * cached or coalesced replies are plain copies of the response bytes, so
+     * ensure it's always there without accounting it in the length */
+    response = (GByteArray *)g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
+    g_byte_array_append (response, (const guint8 *) "", 1);
+    g_byte_array_set_size (response, response->len - 1);
+
+    if (response_len)
+        *response_len = response->len;
+    return (const gchar *) response->data;
+}
+
+void
+mm_port_serial_at_command_borrowed (MMPortSerialAt *self,
+                                    const char *command,
+                                    guint32 timeout_seconds,
+                                    gboolean is_raw,
+                                    gboolean allow_cached,
+                                    MMPortSerialCommandPriority priority,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data)
+{
+    GByteArray *buf;
+
+    g_return_if_fail (self != NULL);
+    g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
+    g_return_if_fail (command != NULL);
+
+    buf = at_command_to_byte_array (command,
+                                    is_raw,
+                                    (mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY ?
+                                     self->priv->send_lf :
+                                     TRUE));
+    g_return_if_fail (buf != NULL);
+
+    /* The result of the serial port command is given directly to the caller,
+     * so that the response can be read from the same buffer */
+    mm_port_serial_command (MM_PORT_SERIAL (self),
+                            buf,
+                            timeout_seconds,
+                            allow_cached,
+                            priority,
+                            cancellable,
+                            callback,
+                            user_data);
+    g_byte_array_unref (buf);
+}
+
 static void
 debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
 {
@@ -628,6 +702,9 @@ finalize (GObject *object)
 
     g_strfreev (self->priv->init_sequence);
 
+    if (self->priv->metric_urcs)
+        mm_metric_unref (self->priv->metric_urcs);
+
     G_OBJECT_CLASS (mm_port_serial_at_parent_class)->finalize (object);
 }
 
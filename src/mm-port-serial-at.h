@@ -100,6 +100,7 @@ void         mm_port_serial_at_command        (MMPortSerialAt *self,
                                                guint32 timeout_seconds,
                                                gboolean is_raw,
                                                gboolean allow_cached,
+                                               MMPortSerialCommandPriority priority,
                                                GCancellable *cancellable,
                                                GAsyncReadyCallback callback,
                                                gpointer user_data);
@@ -107,6 +108,23 @@ const gchar *mm_port_serial_at_command_finish (MMPortSerialAt *self,
                                                GAsyncResult *res,
                                                GError **error);
 
+/* Like mm_port_serial_at_command(), but the response is not copied out of the
+ * port. The returned string is NUL-terminated, and it is only valid until the
+ * callback which called the finish() method returns. */
+void         mm_port_serial_at_command_borrowed        (MMPortSerialAt *self,
+                                                        const char *command,
+                                                        guint32 timeout_seconds,
+                                                        gboolean is_raw,
+                                                        gboolean allow_cached,
+                                                        MMPortSerialCommandPriority priority,
+                                                        GCancellable *cancellable,
+                                                        GAsyncReadyCallback callback,
+                                                        gpointer user_data);
+const gchar *mm_port_serial_at_command_borrowed_finish (MMPortSerialAt *self,
+                                                        GAsyncResult *res,
+                                                        gsize *response_len,
+                                                        GError **error);
+
 /*
  * Convert a string into a quoted and escaped string. Returns a new
  * allocated string. Follows ITU V.250 5.4.2.2 "String constants".
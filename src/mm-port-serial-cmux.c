@@ -0,0 +1,1093 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#define _GNU_SOURCE  /* for posix_openpt() and friends */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <termios.h>
+
+#include <glib-unix.h>
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-port-serial-cmux.h"
+#include "mm-cmux.h"
+#include "mm-serial-parsers.h"
+#include "mm-log.h"
+
+G_DEFINE_TYPE (MMPortSerialCmux, mm_port_serial_cmux, MM_TYPE_PORT_SERIAL)
+
+enum {
+    PROP_0,
+    PROP_FRAME_SIZE,
+    PROP_SEND_COMMAND,
+    PROP_LAST
+};
+
+static GParamSpec *properties[PROP_LAST];
+
+enum {
+    SIGNAL_STOPPED,
+    SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST];
+
+/* Time to wait for the reply to each SABM, and number of attempts */
+#define HANDSHAKE_TIMEOUT_SECS 3
+#define HANDSHAKE_MAX_RETRIES  3
+
+/* Maximum amount of data kept for a channel when nobody is reading it */
+#define CHANNEL_DOWNLINK_MAX 65536
+
+typedef struct {
+    MMPortSerialCmux *self;
+    guint8            dlci;
+    gint              master_fd;
+    gint              slave_fd;
+    guint             master_id;
+    guint             downlink_id;
+    GByteArray       *downlink;
+    guint8           *uplink;
+    gboolean          flow_stopped;
+    MMPortSerialAt   *port;
+} Channel;
+
+struct _MMPortSerialCmuxPrivate {
+    guint    frame_size;
+    gboolean send_command;
+
+    /* Whether we opened the underlying port */
+    gboolean port_open;
+    /* Whether input is processed as 27.010 frames */
+    gboolean framing;
+    /* Whether all channels are available */
+    gboolean running;
+    /* Aggregate flow control (FCoff) requested by the modem */
+    gboolean flow_stopped;
+
+    /* Start operation and channel handshake */
+    GTask *start_task;
+    guint8 handshake_dlci;
+    guint  handshake_retries;
+    guint  handshake_timeout_id;
+
+    /* Reused frame building buffer */
+    GByteArray *frame;
+
+    Channel *channels[MM_PORT_SERIAL_CMUX_CHANNEL_LAST + 1];
+};
+
+static void cmux_teardown (MMPortSerialCmux *self,
+                           gboolean          close_down);
+
+/*****************************************************************************/
+
+static gboolean
+send_frame (MMPortSerialCmux  *self,
+            guint8             dlci,
+            guint8             type,
+            gboolean           pf,
+            gboolean           cr,
+            const guint8      *data,
+            gsize              len,
+            GError           **error)
+{
+    GError *inner_error = NULL;
+
+    g_byte_array_set_size (self->priv->frame, 0);
+    mm_cmux_frame_append (self->priv->frame, dlci, type, pf, cr, data, len);
+    if (!mm_port_serial_write (MM_PORT_SERIAL (self),
+                               self->priv->frame->data,
+                               self->priv->frame->len,
+                               &inner_error)) {
+        mm_dbg ("(%s) couldn't send %s frame on DLCI %u: %s",
+                mm_port_get_device (MM_PORT (self)),
+                mm_cmux_frame_type_get_string (type),
+                dlci,
+                inner_error->message);
+        g_propagate_error (error, inner_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+send_control_message (MMPortSerialCmux *self,
+                      guint8            type,
+                      gboolean          cr,
+                      const guint8     *value,
+                      gsize             len)
+{
+    guint8 message[2 + 8];
+
+    /* Control messages are tiny, so build them in the stack */
+    g_assert (len <= sizeof (message) - 2);
+    message[0] = (type << 2) | (cr ? 0x02 : 0x00) | 0x01;
+    message[1] = (len << 1) | 0x01;
+    if (len)
+        memcpy (&message[2], value, len);
+
+    send_frame (self, 0, MM_CMUX_FRAME_TYPE_UIH, FALSE, TRUE, message, 2 + len, NULL);
+}
+
+/*****************************************************************************/
+/* Channels */
+
+static void channel_flush_downlink (Channel *channel);
+
+static gboolean
+channel_master_output_cb (gint          fd,
+                          GIOCondition  condition,
+                          Channel      *channel)
+{
+    channel->downlink_id = 0;
+    channel_flush_downlink (channel);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+channel_flush_downlink (Channel *channel)
+{
+    while (channel->downlink->len > 0) {
+        gssize written;
+
+        written = write (channel->master_fd, channel->downlink->data, channel->downlink->len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                break;
+            mm_warn ("(%s) couldn't write to multiplexer channel %u: %s",
+                     mm_port_get_device (MM_PORT (channel->self)),
+                     channel->dlci,
+                     g_strerror (errno));
+            g_byte_array_set_size (channel->downlink, 0);
+            break;
+        }
+        g_byte_array_remove_range (channel->downlink, 0, written);
+    }
+
+    /* Wait until the pty is writable again */
+    if (channel->downlink->len > 0 && !channel->downlink_id)
+        channel->downlink_id = g_unix_fd_add (channel->master_fd,
+                                              G_IO_OUT,
+                                              (GUnixFDSourceFunc) channel_master_output_cb,
+                                              channel);
+}
+
+static void
+channel_write_downlink (Channel      *channel,
+                        const guint8 *data,
+                        gsize         len)
+{
+    /* If nobody reads the channel, drop the oldest data */
+    if (channel->downlink->len + len > CHANNEL_DOWNLINK_MAX) {
+        mm_dbg ("(%s) multiplexer channel %u buffer full, discarding data",
+                mm_port_get_device (MM_PORT (channel->self)),
+                channel->dlci);
+        g_byte_array_remove_range (channel->downlink, 0, MIN (channel->downlink->len, len));
+    }
+
+    g_byte_array_append (channel->downlink, data, len);
+
+    /* If already waiting for the pty, data will be written afterwards */
+    if (!channel->downlink_id)
+        channel_flush_downlink (channel);
+}
+
+static gboolean
+channel_master_input_cb (gint          fd,
+                         GIOCondition  condition,
+                         Channel      *channel)
+{
+    MMPortSerialCmux *self = channel->self;
+    gssize            n_read;
+
+    /* We keep the slave side open, so this shouldn't happen */
+    if (condition & (G_IO_HUP | G_IO_ERR)) {
+        mm_warn ("(%s) multiplexer channel %u hung up",
+                 mm_port_get_device (MM_PORT (self)),
+                 channel->dlci);
+        channel->master_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    /* Each read is sent in a single UIH frame */
+    n_read = read (channel->master_fd, channel->uplink, self->priv->frame_size);
+    if (n_read < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return G_SOURCE_CONTINUE;
+        mm_warn ("(%s) couldn't read from multiplexer channel %u: %s",
+                 mm_port_get_device (MM_PORT (self)),
+                 channel->dlci,
+                 g_strerror (errno));
+        channel->master_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    if (n_read > 0)
+        send_frame (self, channel->dlci, MM_CMUX_FRAME_TYPE_UIH, FALSE, TRUE,
+                    channel->uplink, n_read, NULL);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+channel_update_watch (Channel *channel)
+{
+    gboolean enable;
+
+    enable = !channel->flow_stopped && !channel->self->priv->flow_stopped;
+
+    if (enable && !channel->master_id)
+        channel->master_id = g_unix_fd_add (channel->master_fd,
+                                            G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                            (GUnixFDSourceFunc) channel_master_input_cb,
+                                            channel);
+    else if (!enable && channel->master_id) {
+        g_source_remove (channel->master_id);
+        channel->master_id = 0;
+    }
+}
+
+static void
+channel_free (Channel *channel)
+{
+    if (channel->master_id)
+        g_source_remove (channel->master_id);
+    if (channel->downlink_id)
+        g_source_remove (channel->downlink_id);
+
+    /* Closing the master side hangs up the pty, so that whoever is using the
+     * AT port gets notified */
+    close (channel->master_fd);
+    close (channel->slave_fd);
+
+    g_object_unref (channel->port);
+    g_byte_array_unref (channel->downlink);
+    g_free (channel->uplink);
+    g_slice_free (Channel, channel);
+}
+
+static Channel *
+channel_new (MMPortSerialCmux  *self,
+             guint8             dlci,
+             GError           **error)
+{
+    Channel        *channel;
+    gint            master_fd;
+    gint            slave_fd;
+    const gchar    *slave_path;
+    struct termios  tio;
+
+    master_fd = posix_openpt (O_RDWR | O_NOCTTY);
+    if (master_fd < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't open pseudo-terminal: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    if (grantpt (master_fd) < 0 ||
+        unlockpt (master_fd) < 0 ||
+        !(slave_path = ptsname (master_fd)) ||
+        !g_str_has_prefix (slave_path, "/dev/")) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't setup pseudo-terminal: %s", g_strerror (errno));
+        close (master_fd);
+        return NULL;
+    }
+
+    /* Keep the slave side open ourselves, otherwise the master would get
+     * hung up every time the AT port is closed */
+    slave_fd = open (slave_path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (slave_fd < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't open pseudo-terminal slave %s: %s", slave_path, g_strerror (errno));
+        close (master_fd);
+        return NULL;
+    }
+
+    /* No echo or any other line processing in the pty */
+    if (tcgetattr (slave_fd, &tio) == 0) {
+        cfmakeraw (&tio);
+        tcsetattr (slave_fd, TCSANOW, &tio);
+    }
+
+    fcntl (master_fd, F_SETFL, fcntl (master_fd, F_GETFL) | O_NONBLOCK);
+
+    channel = g_slice_new0 (Channel);
+    channel->self = self;
+    channel->dlci = dlci;
+    channel->master_fd = master_fd;
+    channel->slave_fd = slave_fd;
+    channel->downlink = g_byte_array_new ();
+    channel->uplink = g_malloc (self->priv->frame_size);
+
+    /* Device names are given relative to /dev */
+    channel->port = mm_port_serial_at_new (slave_path + strlen ("/dev/"), MM_PORT_SUBSYS_TTY);
+    mm_port_serial_at_set_response_parser (channel->port,
+                                           mm_serial_parser_v1_parse,
+                                           mm_serial_parser_v1_new (),
+                                           mm_serial_parser_v1_destroy);
+    switch (dlci) {
+    case MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL:
+        mm_port_serial_at_set_flags (channel->port, MM_PORT_SERIAL_AT_FLAG_PRIMARY);
+        break;
+    case MM_PORT_SERIAL_CMUX_CHANNEL_AT:
+        mm_port_serial_at_set_flags (channel->port, MM_PORT_SERIAL_AT_FLAG_SECONDARY);
+        break;
+    case MM_PORT_SERIAL_CMUX_CHANNEL_DATA:
+        mm_port_serial_at_set_flags (channel->port, MM_PORT_SERIAL_AT_FLAG_PPP);
+        break;
+    default:
+        g_assert_not_reached ();
+    }
+
+    channel_update_watch (channel);
+
+    mm_dbg ("(%s) multiplexer channel %u available at %s",
+            mm_port_get_device (MM_PORT (self)), dlci, slave_path);
+    return channel;
+}
+
+static Channel *
+find_channel (MMPortSerialCmux *self,
+              guint8            dlci)
+{
+    if (dlci == 0 || dlci > MM_PORT_SERIAL_CMUX_CHANNEL_LAST)
+        return NULL;
+    return self->priv->channels[dlci];
+}
+
+MMPortSerialAt *
+mm_port_serial_cmux_peek_channel (MMPortSerialCmux        *self,
+                                  MMPortSerialCmuxChannel  channel)
+{
+    Channel *found;
+
+    g_return_val_if_fail (MM_IS_PORT_SERIAL_CMUX (self), NULL);
+
+    if (!self->priv->running)
+        return NULL;
+
+    found = find_channel (self, (guint8) channel);
+    return found ? found->port : NULL;
+}
+
+/*****************************************************************************/
+/* Incoming frames */
+
+static void start_handshake_done (MMPortSerialCmux *self,
+                                  GError           *error);
+
+static void
+update_flow_control (MMPortSerialCmux *self)
+{
+    guint i;
+
+    for (i = 1; i <= MM_PORT_SERIAL_CMUX_CHANNEL_LAST; i++) {
+        if (self->priv->channels[i])
+            channel_update_watch (self->priv->channels[i]);
+    }
+}
+
+static void
+process_control_message (MMPortSerialCmux *self,
+                         const guint8     *data,
+                         gsize             len)
+{
+    guint8        type;
+    gboolean      cr;
+    const guint8 *value;
+    gsize         value_len;
+    Channel      *channel;
+
+    if (!mm_cmux_control_message_parse (data, len, &type, &cr, &value, &value_len)) {
+        mm_dbg ("(%s) invalid multiplexer control message",
+                mm_port_get_device (MM_PORT (self)));
+        return;
+    }
+
+    /* Responses to our own commands need no processing */
+    if (!cr)
+        return;
+
+    switch (type) {
+    case MM_CMUX_CONTROL_TYPE_MSC:
+        /* Per-channel flow control in the V.24 signals */
+        if (value_len >= 2 && (channel = find_channel (self, value[0] >> 2)) != NULL) {
+            channel->flow_stopped = !!(value[1] & MM_CMUX_MSC_FC);
+            channel_update_watch (channel);
+        }
+        send_control_message (self, type, FALSE, value, MIN (value_len, 8));
+        break;
+    case MM_CMUX_CONTROL_TYPE_FCON:
+    case MM_CMUX_CONTROL_TYPE_FCOFF:
+        self->priv->flow_stopped = (type == MM_CMUX_CONTROL_TYPE_FCOFF);
+        update_flow_control (self);
+        send_control_message (self, type, FALSE, NULL, 0);
+        break;
+    case MM_CMUX_CONTROL_TYPE_TEST:
+    case MM_CMUX_CONTROL_TYPE_PSC:
+        send_control_message (self, type, FALSE, value, MIN (value_len, 8));
+        break;
+    case MM_CMUX_CONTROL_TYPE_CLD:
+        mm_dbg ("(%s) multiplexer closed down by the modem",
+                mm_port_get_device (MM_PORT (self)));
+        send_control_message (self, type, FALSE, NULL, 0);
+        cmux_teardown (self, FALSE);
+        break;
+    default:
+        /* Non supported command, report the type as received */
+        send_control_message (self, MM_CMUX_CONTROL_TYPE_NSC, FALSE, data, 1);
+        break;
+    }
+}
+
+static void
+process_frame (MMPortSerialCmux  *self,
+               const MMCmuxFrame *frame)
+{
+    Channel *channel;
+
+    switch (frame->type) {
+    case MM_CMUX_FRAME_TYPE_UA:
+    case MM_CMUX_FRAME_TYPE_DM:
+        if (self->priv->handshake_timeout_id && frame->dlci == self->priv->handshake_dlci) {
+            start_handshake_done (self,
+                                  (frame->type == MM_CMUX_FRAME_TYPE_UA ?
+                                   NULL :
+                                   g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                                                "Multiplexer channel %u rejected",
+                                                frame->dlci)));
+            return;
+        }
+        mm_dbg ("(%s) unexpected %s on DLCI %u",
+                mm_port_get_device (MM_PORT (self)),
+                mm_cmux_frame_type_get_string (frame->type),
+                frame->dlci);
+        return;
+
+    case MM_CMUX_FRAME_TYPE_SABM:
+        /* Channels are only opened by us */
+        send_frame (self, frame->dlci, MM_CMUX_FRAME_TYPE_DM, frame->pf, FALSE, NULL, 0, NULL);
+        return;
+
+    case MM_CMUX_FRAME_TYPE_DISC:
+        send_frame (self, frame->dlci, MM_CMUX_FRAME_TYPE_UA, frame->pf, FALSE, NULL, 0, NULL);
+        if (frame->dlci == 0) {
+            mm_dbg ("(%s) multiplexer disconnected by the modem",
+                    mm_port_get_device (MM_PORT (self)));
+            cmux_teardown (self, FALSE);
+        } else if ((channel = find_channel (self, frame->dlci)) != NULL) {
+            mm_dbg ("(%s) multiplexer channel %u disconnected by the modem",
+                    mm_port_get_device (MM_PORT (self)), frame->dlci);
+            self->priv->channels[frame->dlci] = NULL;
+            channel_free (channel);
+        }
+        return;
+
+    case MM_CMUX_FRAME_TYPE_UIH:
+    case MM_CMUX_FRAME_TYPE_UI:
+        if (frame->dlci == 0)
+            process_control_message (self, frame->data, frame->len);
+        else if ((channel = find_channel (self, frame->dlci)) != NULL) {
+            if (frame->len)
+                channel_write_downlink (channel, frame->data, frame->len);
+        } else
+            mm_dbg ("(%s) data received on unknown DLCI %u",
+                    mm_port_get_device (MM_PORT (self)), frame->dlci);
+        return;
+
+    default:
+        mm_dbg ("(%s) unknown frame type 0x%02x on DLCI %u",
+                mm_port_get_device (MM_PORT (self)), frame->type, frame->dlci);
+        return;
+    }
+}
+
+static void
+parse_unsolicited (MMPortSerial *port,
+                   GByteArray   *response)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (port);
+
+    if (!self->priv->framing)
+        return;
+
+    /* Processing a frame may end up tearing down the multiplexer */
+    g_object_ref (self);
+    while (self->priv->framing && response->len > 0) {
+        MMCmuxFrame       frame;
+        MMCmuxParseResult result;
+        gsize             consumed = 0;
+
+        result = mm_cmux_frame_parse (response->data, response->len, &frame, &consumed);
+        if (result == MM_CMUX_PARSE_RESULT_FRAME)
+            process_frame (self, &frame);
+        else if (result == MM_CMUX_PARSE_RESULT_INVALID)
+            mm_dbg ("(%s) invalid multiplexer frame discarded",
+                    mm_port_get_device (MM_PORT (self)));
+
+        /* The frame information points to the response buffer, so only
+         * remove it once processed */
+        if (consumed)
+            g_byte_array_remove_range (response, 0, MIN (consumed, response->len));
+
+        if (result == MM_CMUX_PARSE_RESULT_NEED_MORE)
+            break;
+    }
+    g_object_unref (self);
+}
+
+static MMPortSerialResponseType
+parse_response (MMPortSerial  *port,
+                GByteArray    *response,
+                GByteArray   **parsed_response,
+                GError       **error)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (port);
+    const gchar      *str;
+    gsize             end;
+
+    /* Only the AT+CMUX command is sent through the command queue */
+    if (self->priv->framing)
+        return MM_PORT_SERIAL_RESPONSE_NONE;
+
+    str = g_strstr_len ((const gchar *) response->data, response->len, "OK\r\n");
+    if (str) {
+        /* Anything after the reply is already multiplexed data */
+        end = (str - (const gchar *) response->data) + strlen ("OK\r\n");
+        *parsed_response = g_byte_array_sized_new (end);
+        g_byte_array_append (*parsed_response, response->data, end);
+        g_byte_array_remove_range (response, 0, end);
+        return MM_PORT_SERIAL_RESPONSE_BUFFER;
+    }
+
+    if (g_strstr_len ((const gchar *) response->data, response->len, "ERROR")) {
+        g_byte_array_remove_range (response, 0, response->len);
+        g_set_error_literal (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                             "Multiplexing mode not supported");
+        return MM_PORT_SERIAL_RESPONSE_ERROR;
+    }
+
+    return MM_PORT_SERIAL_RESPONSE_NONE;
+}
+
+/*****************************************************************************/
+/* Start */
+
+typedef enum {
+    START_STEP_FIRST,
+    START_STEP_OPEN,
+    START_STEP_COMMAND,
+    START_STEP_CONTROL_CHANNEL,
+    START_STEP_CHANNELS,
+    START_STEP_LAST,
+} StartStep;
+
+typedef struct {
+    StartStep step;
+    guint8    dlci;
+} StartContext;
+
+static void start_step (GTask *task);
+
+gboolean
+mm_port_serial_cmux_start_finish (MMPortSerialCmux  *self,
+                                  GAsyncResult      *res,
+                                  GError           **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+start_fail (MMPortSerialCmux *self,
+            GError           *error)
+{
+    GTask *task;
+
+    task = self->priv->start_task;
+    g_assert (task);
+    self->priv->start_task = NULL;
+
+    cmux_teardown (self, TRUE);
+
+    g_task_return_error (task, error);
+    g_object_unref (task);
+}
+
+static gboolean
+handshake_timeout_cb (MMPortSerialCmux *self)
+{
+    self->priv->handshake_timeout_id = 0;
+
+    if (++self->priv->handshake_retries >= HANDSHAKE_MAX_RETRIES) {
+        start_fail (self,
+                    g_error_new (MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT,
+                                 "Couldn't open multiplexer channel %u: timed out",
+                                 self->priv->handshake_dlci));
+        return G_SOURCE_REMOVE;
+    }
+
+    start_step (self->priv->start_task);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+handshake_run (MMPortSerialCmux *self)
+{
+    GError *error = NULL;
+
+    g_assert (!self->priv->handshake_timeout_id);
+
+    if (!send_frame (self, self->priv->handshake_dlci, MM_CMUX_FRAME_TYPE_SABM, TRUE, TRUE, NULL, 0, &error)) {
+        start_fail (self, error);
+        return;
+    }
+
+    self->priv->handshake_timeout_id = g_timeout_add_seconds (HANDSHAKE_TIMEOUT_SECS,
+                                                              (GSourceFunc) handshake_timeout_cb,
+                                                              self);
+}
+
+static void
+start_handshake_done (MMPortSerialCmux *self,
+                      GError           *error)
+{
+    StartContext *ctx;
+
+    g_assert (self->priv->start_task);
+
+    if (self->priv->handshake_timeout_id) {
+        g_source_remove (self->priv->handshake_timeout_id);
+        self->priv->handshake_timeout_id = 0;
+    }
+
+    if (error) {
+        start_fail (self, error);
+        return;
+    }
+
+    ctx = g_task_get_task_data (self->priv->start_task);
+
+    if (self->priv->handshake_dlci > 0) {
+        Channel *channel;
+        guint8   msc[2];
+
+        channel = channel_new (self, self->priv->handshake_dlci, &error);
+        if (!channel) {
+            start_fail (self, error);
+            return;
+        }
+        self->priv->channels[channel->dlci] = channel;
+
+        /* Some modems don't send any data in the channel until the V.24
+         * signals are set */
+        msc[0] = (channel->dlci << 2) | 0x02 | 0x01;
+        msc[1] = MM_CMUX_MSC_RTC | MM_CMUX_MSC_RTR | MM_CMUX_MSC_DV | 0x01;
+        send_control_message (self, MM_CMUX_CONTROL_TYPE_MSC, TRUE, msc, sizeof (msc));
+
+        ctx->dlci++;
+    } else
+        ctx->step++;
+
+    self->priv->handshake_retries = 0;
+    start_step (self->priv->start_task);
+}
+
+static void
+cmux_command_ready (MMPortSerial *port,
+                    GAsyncResult *res,
+                    GTask        *task)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (port);
+    StartContext     *ctx;
+    GByteArray       *response;
+    GError           *error = NULL;
+
+    response = mm_port_serial_command_finish (port, res, &error);
+
+    /* The start operation may have been aborted meanwhile; the command holds
+     * its own task reference */
+    if (self->priv->start_task != task) {
+        if (response)
+            g_byte_array_unref (response);
+        g_clear_error (&error);
+        g_object_unref (task);
+        return;
+    }
+    g_object_unref (task);
+
+    if (!response) {
+        start_fail (self, error);
+        return;
+    }
+    g_byte_array_unref (response);
+
+    mm_dbg ("(%s) multiplexing mode enabled", mm_port_get_device (MM_PORT (self)));
+    self->priv->framing = TRUE;
+
+    ctx = g_task_get_task_data (task);
+    ctx->step++;
+    start_step (task);
+}
+
+static void
+start_step (GTask *task)
+{
+    MMPortSerialCmux *self;
+    StartContext     *ctx;
+    GError           *error = NULL;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    if (g_cancellable_is_cancelled (g_task_get_cancellable (task))) {
+        start_fail (self, g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_CANCELLED,
+                                       "Multiplexer start cancelled"));
+        return;
+    }
+
+    switch (ctx->step) {
+    case START_STEP_FIRST:
+        ctx->step++;
+        /* fall through */
+
+    case START_STEP_OPEN:
+        if (!mm_port_serial_open (MM_PORT_SERIAL (self), &error)) {
+            start_fail (self, error);
+            return;
+        }
+        self->priv->port_open = TRUE;
+        ctx->step++;
+        /* fall through */
+
+    case START_STEP_COMMAND:
+        if (self->priv->send_command) {
+            GByteArray *command;
+            gchar      *str;
+
+            str = (self->priv->frame_size == MM_CMUX_DEFAULT_FRAME_SIZE ?
+                   g_strdup ("AT+CMUX=0\r") :
+                   g_strdup_printf ("AT+CMUX=0,0,,%u\r", self->priv->frame_size));
+            command = g_byte_array_new_take ((guint8 *) str, strlen (str));
+            mm_port_serial_command (MM_PORT_SERIAL (self),
+                                    command,
+                                    3,
+                                    FALSE,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL,
+                                    NULL,
+                                    (GAsyncReadyCallback) cmux_command_ready,
+                                    g_object_ref (task));
+            g_byte_array_unref (command);
+            return;
+        }
+        self->priv->framing = TRUE;
+        ctx->step++;
+        /* fall through */
+
+    case START_STEP_CONTROL_CHANNEL:
+        self->priv->handshake_dlci = 0;
+        handshake_run (self);
+        return;
+
+    case START_STEP_CHANNELS:
+        if (ctx->dlci <= MM_PORT_SERIAL_CMUX_CHANNEL_LAST) {
+            self->priv->handshake_dlci = ctx->dlci;
+            handshake_run (self);
+            return;
+        }
+        ctx->step++;
+        /* fall through */
+
+    case START_STEP_LAST:
+        mm_dbg ("(%s) multiplexer running", mm_port_get_device (MM_PORT (self)));
+        self->priv->start_task = NULL;
+        self->priv->running = TRUE;
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+
+    default:
+        g_assert_not_reached ();
+    }
+}
+
+void
+mm_port_serial_cmux_start (MMPortSerialCmux    *self,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+    GTask        *task;
+    StartContext *ctx;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL_CMUX (self));
+
+    task = g_task_new (self, cancellable, callback, user_data);
+
+    if (self->priv->start_task || self->priv->running) {
+        g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_IN_PROGRESS,
+                                 "Multiplexer already started");
+        g_object_unref (task);
+        return;
+    }
+
+    ctx = g_new0 (StartContext, 1);
+    ctx->step = START_STEP_FIRST;
+    ctx->dlci = MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL;
+    g_task_set_task_data (task, ctx, g_free);
+
+    self->priv->start_task = task;
+    start_step (task);
+}
+
+/*****************************************************************************/
+/* Stop */
+
+static void
+cmux_teardown (MMPortSerialCmux *self,
+               gboolean          close_down)
+{
+    guint i;
+
+    if (self->priv->handshake_timeout_id) {
+        g_source_remove (self->priv->handshake_timeout_id);
+        self->priv->handshake_timeout_id = 0;
+    }
+
+    for (i = 1; i <= MM_PORT_SERIAL_CMUX_CHANNEL_LAST; i++) {
+        if (self->priv->channels[i]) {
+            channel_free (self->priv->channels[i]);
+            self->priv->channels[i] = NULL;
+        }
+    }
+
+    /* The modem goes back to AT command mode after the close down */
+    if (self->priv->framing && close_down && self->priv->port_open)
+        send_control_message (self, MM_CMUX_CONTROL_TYPE_CLD, TRUE, NULL, 0);
+    self->priv->framing = FALSE;
+    self->priv->flow_stopped = FALSE;
+
+    if (self->priv->port_open) {
+        self->priv->port_open = FALSE;
+        mm_port_serial_close (MM_PORT_SERIAL (self));
+    }
+
+    if (self->priv->running) {
+        mm_dbg ("(%s) multiplexer stopped", mm_port_get_device (MM_PORT (self)));
+        self->priv->running = FALSE;
+        g_signal_emit (self, signals[SIGNAL_STOPPED], 0);
+    }
+}
+
+void
+mm_port_serial_cmux_stop (MMPortSerialCmux *self)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_CMUX (self));
+
+    if (self->priv->start_task)
+        start_fail (self, g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_ABORTED,
+                                       "Multiplexer stopped"));
+    else
+        cmux_teardown (self, TRUE);
+}
+
+gboolean
+mm_port_serial_cmux_is_running (MMPortSerialCmux *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL_CMUX (self), FALSE);
+
+    return self->priv->running;
+}
+
+static void
+forced_close (MMPortSerial *port)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (port);
+
+    /* The port is already closed at this point */
+    self->priv->port_open = FALSE;
+
+    if (self->priv->start_task)
+        start_fail (self, g_error_new (MM_SERIAL_ERROR, MM_SERIAL_ERROR_NOT_OPEN,
+                                       "Multiplexed port forced to close"));
+    else
+        cmux_teardown (self, FALSE);
+}
+
+/*****************************************************************************/
+
+static void
+debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
+{
+    static GString *debug = NULL;
+    const char *s = buf;
+
+    if (!debug)
+        debug = g_string_sized_new (512);
+
+    g_string_append (debug, prefix);
+
+    while (len--)
+        g_string_append_printf (debug, " %02x", (guint8) (*s++ & 0xFF));
+
+    mm_dbg ("(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
+    g_string_truncate (debug, 0);
+}
+
+/*****************************************************************************/
+
+MMPortSerialCmux *
+mm_port_serial_cmux_new (const gchar  *name,
+                         MMPortSubsys  subsys)
+{
+    g_return_val_if_fail (subsys == MM_PORT_SUBSYS_TTY ||
+                          subsys == MM_PORT_SUBSYS_UNIX, NULL);
+
+    return MM_PORT_SERIAL_CMUX (g_object_new (MM_TYPE_PORT_SERIAL_CMUX,
+                                              MM_PORT_DEVICE, name,
+                                              MM_PORT_SUBSYS, subsys,
+                                              MM_PORT_TYPE, MM_PORT_TYPE_AT,
+                                              NULL));
+}
+
+static void
+mm_port_serial_cmux_init (MMPortSerialCmux *self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
+                                              MM_TYPE_PORT_SERIAL_CMUX,
+                                              MMPortSerialCmuxPrivate);
+
+    self->priv->frame_size = MM_CMUX_DEFAULT_FRAME_SIZE;
+    self->priv->send_command = TRUE;
+    self->priv->frame = g_byte_array_sized_new (MM_CMUX_DEFAULT_FRAME_SIZE + 8);
+}
+
+static void
+set_property (GObject      *object,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (object);
+
+    switch (prop_id) {
+    case PROP_FRAME_SIZE:
+        self->priv->frame_size = g_value_get_uint (value);
+        break;
+    case PROP_SEND_COMMAND:
+        self->priv->send_command = g_value_get_boolean (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property (GObject    *object,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (object);
+
+    switch (prop_id) {
+    case PROP_FRAME_SIZE:
+        g_value_set_uint (value, self->priv->frame_size);
+        break;
+    case PROP_SEND_COMMAND:
+        g_value_set_boolean (value, self->priv->send_command);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+dispose (GObject *object)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (object);
+
+    /* The start task holds a reference, so it can't be running here */
+    g_assert (!self->priv->start_task);
+    cmux_teardown (self, TRUE);
+
+    G_OBJECT_CLASS (mm_port_serial_cmux_parent_class)->dispose (object);
+}
+
+static void
+finalize (GObject *object)
+{
+    MMPortSerialCmux *self = MM_PORT_SERIAL_CMUX (object);
+
+    g_byte_array_unref (self->priv->frame);
+
+    G_OBJECT_CLASS (mm_port_serial_cmux_parent_class)->finalize (object);
+}
+
+static void
+mm_port_serial_cmux_class_init (MMPortSerialCmuxClass *klass)
+{
+    GObjectClass      *object_class = G_OBJECT_CLASS (klass);
+    MMPortSerialClass *serial_class = MM_PORT_SERIAL_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (MMPortSerialCmuxPrivate));
+
+    /* Virtual methods */
+    object_class->set_property = set_property;
+    object_class->get_property = get_property;
+    object_class->dispose      = dispose;
+    object_class->finalize     = finalize;
+
+    serial_class->parse_unsolicited = parse_unsolicited;
+    serial_class->parse_response    = parse_response;
+    serial_class->debug_log         = debug_log;
+    serial_class->forced_close      = forced_close;
+
+    properties[PROP_FRAME_SIZE] =
+        g_param_spec_uint (MM_PORT_SERIAL_CMUX_FRAME_SIZE,
+                           "Frame size",
+                           "Maximum length of the information field in each frame (N1)",
+                           1, 32767, MM_CMUX_DEFAULT_FRAME_SIZE,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_FRAME_SIZE, properties[PROP_FRAME_SIZE]);
+
+    properties[PROP_SEND_COMMAND] =
+        g_param_spec_boolean (MM_PORT_SERIAL_CMUX_SEND_COMMAND,
+                              "Send command",
+                              "Whether AT+CMUX should be sent to switch the port to multiplexing mode",
+                              TRUE,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_SEND_COMMAND, properties[PROP_SEND_COMMAND]);
+
+    signals[SIGNAL_STOPPED] =
+        g_signal_new ("stopped",
+                      G_OBJECT_CLASS_TYPE (object_class),
+                      G_SIGNAL_RUN_FIRST,
+                      G_STRUCT_OFFSET (MMPortSerialCmuxClass, stopped),
+                      NULL, NULL,
+                      g_cclosure_marshal_generic,
+                      G_TYPE_NONE, 0);
+}
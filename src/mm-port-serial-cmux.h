@@ -0,0 +1,87 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_PORT_SERIAL_CMUX_H
+#define MM_PORT_SERIAL_CMUX_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "mm-port-serial.h"
+#include "mm-port-serial-at.h"
+
+#define MM_TYPE_PORT_SERIAL_CMUX            (mm_port_serial_cmux_get_type ())
+#define MM_PORT_SERIAL_CMUX(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_PORT_SERIAL_CMUX, MMPortSerialCmux))
+#define MM_PORT_SERIAL_CMUX_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  MM_TYPE_PORT_SERIAL_CMUX, MMPortSerialCmuxClass))
+#define MM_IS_PORT_SERIAL_CMUX(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MM_TYPE_PORT_SERIAL_CMUX))
+#define MM_IS_PORT_SERIAL_CMUX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  MM_TYPE_PORT_SERIAL_CMUX))
+#define MM_PORT_SERIAL_CMUX_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  MM_TYPE_PORT_SERIAL_CMUX, MMPortSerialCmuxClass))
+
+#define MM_PORT_SERIAL_CMUX_FRAME_SIZE   "frame-size"   /* Construct-only */
+#define MM_PORT_SERIAL_CMUX_SEND_COMMAND "send-command" /* Construct-only */
+
+/* Virtual channels set up on top of the multiplexed port, given as DLCI.
+ * DLCI 0 is the multiplexer control channel, and is never exposed. */
+typedef enum {
+    MM_PORT_SERIAL_CMUX_CHANNEL_CONTROL = 1,
+    MM_PORT_SERIAL_CMUX_CHANNEL_AT      = 2,
+    MM_PORT_SERIAL_CMUX_CHANNEL_DATA    = 3,
+} MMPortSerialCmuxChannel;
+
+#define MM_PORT_SERIAL_CMUX_CHANNEL_LAST MM_PORT_SERIAL_CMUX_CHANNEL_DATA
+
+typedef struct _MMPortSerialCmux MMPortSerialCmux;
+typedef struct _MMPortSerialCmuxClass MMPortSerialCmuxClass;
+typedef struct _MMPortSerialCmuxPrivate MMPortSerialCmuxPrivate;
+
+struct _MMPortSerialCmux {
+    MMPortSerial parent;
+    MMPortSerialCmuxPrivate *priv;
+};
+
+struct _MMPortSerialCmuxClass {
+    MMPortSerialClass parent;
+
+    /* Signals */
+    void (*stopped) (MMPortSerialCmux *self);
+};
+
+GType mm_port_serial_cmux_get_type (void);
+
+MMPortSerialCmux *mm_port_serial_cmux_new (const gchar  *name,
+                                           MMPortSubsys  subsys);
+
+/* Switches the port to multiplexing mode (AT+CMUX) and opens all the virtual
+ * channels. The port is kept open until the multiplexer is stopped. */
+void     mm_port_serial_cmux_start        (MMPortSerialCmux     *self,
+                                           GCancellable         *cancellable,
+                                           GAsyncReadyCallback   callback,
+                                           gpointer              user_data);
+gboolean mm_port_serial_cmux_start_finish (MMPortSerialCmux     *self,
+                                           GAsyncResult         *res,
+                                           GError              **error);
+
+/* Closes down the multiplexer; the virtual channels are hung up */
+void     mm_port_serial_cmux_stop         (MMPortSerialCmux     *self);
+
+gboolean mm_port_serial_cmux_is_running   (MMPortSerialCmux     *self);
+
+/* The virtual channels are exposed as AT ports backed by pseudo-terminals,
+ * so that they can also be given to pppd. Only available while running. */
+MMPortSerialAt *mm_port_serial_cmux_peek_channel (MMPortSerialCmux        *self,
+                                                  MMPortSerialCmuxChannel  channel);
+
+#endif /* MM_PORT_SERIAL_CMUX_H */
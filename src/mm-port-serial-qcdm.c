@@ -193,6 +193,7 @@ mm_port_serial_qcdm_command (MMPortSerialQcdm *self,
                             command,
                             timeout_seconds,
                             FALSE, /* never cached */
+                            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                             cancellable,
                             (GAsyncReadyCallback)serial_command_ready,
                             task);
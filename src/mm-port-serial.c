@@ -36,12 +36,15 @@
 #include "mm-port-serial.h"
 #include "mm-log.h"
 #include "mm-helper-enums-types.h"
+#include "mm-metrics.h"
 
 static gboolean port_serial_queue_process          (gpointer data);
 static void     port_serial_schedule_queue_process (MMPortSerial *self,
                                                     guint timeout_ms);
 static void     port_serial_close_force            (MMPortSerial *self);
 static void     port_serial_reopen_cancel          (MMPortSerial *self);
+static void     port_serial_update_busy_time       (MMPortSerial *self);
+static void     port_serial_timeout_found          (MMPortSerial *self);
 static void     port_serial_set_cached_reply       (MMPortSerial *self,
                                                     const GByteArray *command,
                                                     const GByteArray *response);
@@ -75,6 +78,9 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 #define SERIAL_BUF_SIZE 2048
 
+/* Time to wait before retrying a raw write which couldn't be fully sent */
+#define WRITE_RETRY_TIMEOUT_MS 10
+
 struct _MMPortSerialPrivate {
     guint32 open_count;
     gboolean forced_close;
@@ -109,15 +115,49 @@ struct _MMPortSerialPrivate {
 
     guint n_consecutive_timeouts;
 
+    /* Raw data pending to be written, bypassing the command queue */
+    GByteArray *write_buffer;
+    guint write_id;
+
+    MMPortSerialQueueStats queue_stats[MM_PORT_SERIAL_COMMAND_PRIORITY_LAST + 1];
+    guint queue_stats_id;
+
+    /* Port utilisation: time with commands being processed while open */
+    gint64 open_time;
+    gint64 busy_since;
+    guint64 busy_time_ms;
+    guint64 open_time_ms;
+
     guint connected_id;
 
     GTask *flash_task;
     GTask *reopen_task;
+
+    /* Metrics, setup when the port is first opened */
+    MMMetric *metric_commands;
+    MMMetric *metric_timeouts;
+    MMMetric *metric_consecutive_timeouts;
+    MMMetric *metric_open_failures;
+    MMMetric *metric_queue_wait;
+    MMMetric *metric_queue_depth;
+    MMMetric *metric_queue_coalesced;
+    MMMetric *metric_queue_rejected;
+    MMMetric *metric_response_time;
 };
 
 /*****************************************************************************/
 /* Command */
 
+/* Maximum number of commands waiting in the queue */
+#define QUEUE_MAX_DEPTH 64
+
+/* Time after which a background command is no longer overtaken by other
+ * commands */
+#define QUEUE_BACKGROUND_MAX_WAIT_MS 10000
+
+/* Period of the queue statistics logs while the port is open */
+#define QUEUE_STATS_LOG_PERIOD_SECS 300
+
 typedef struct {
     MMPortSerial *self;
     GSimpleAsyncResult *result;
@@ -125,8 +165,15 @@ typedef struct {
     GByteArray *command;
     guint32 timeout;
     gboolean allow_cached;
+    MMPortSerialCommandPriority priority;
     guint32 eagain_count;
 
+    /* Results of other requests merged into this one */
+    GList *coalesced;
+    gint64 queued_time;
+    /* When the command was first processed */
+    gint64 start_time;
+
     guint32 idx;
     gboolean started;
     gboolean done;
@@ -135,11 +182,22 @@ typedef struct {
 static void
 command_context_complete_and_free (CommandContext *ctx, gboolean idle)
 {
+    GList *l;
+
     if (idle)
         g_simple_async_result_complete_in_idle (ctx->result);
     else
         g_simple_async_result_complete (ctx->result);
     g_object_unref (ctx->result);
+
+    for (l = ctx->coalesced; l; l = g_list_next (l)) {
+        if (idle)
+            g_simple_async_result_complete_in_idle (G_SIMPLE_ASYNC_RESULT (l->data));
+        else
+            g_simple_async_result_complete (G_SIMPLE_ASYNC_RESULT (l->data));
+    }
+    g_list_free_full (ctx->coalesced, g_object_unref);
+
     g_byte_array_unref (ctx->command);
     if (ctx->cancellable)
         g_object_unref (ctx->cancellable);
@@ -147,6 +205,294 @@ command_context_complete_and_free (CommandContext *ctx, gboolean idle)
     g_slice_free (CommandContext, ctx);
 }
 
+static void
+command_context_set_error (CommandContext *ctx,
+                           const GError   *error)
+{
+    GList *l;
+
+    g_simple_async_result_set_from_error (ctx->result, error);
+    for (l = ctx->coalesced; l; l = g_list_next (l))
+        g_simple_async_result_set_from_error (G_SIMPLE_ASYNC_RESULT (l->data), error);
+}
+
+static void
+command_context_set_response (CommandContext *ctx,
+                              GByteArray     *parsed_response)
+{
+    GList *l;
+
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               g_byte_array_ref (parsed_response),
+                                               (GDestroyNotify) g_byte_array_unref);
+
+    /* Merged requests get their own copy of the response, as the caller is
+     * allowed to consume the response buffer */
+    for (l = ctx->coalesced; l; l = g_list_next (l)) {
+        GByteArray *copy;
+
+        copy = g_byte_array_sized_new (parsed_response->len);
+        g_byte_array_append (copy, parsed_response->data, parsed_response->len);
+        g_simple_async_result_set_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (l->data),
+                                                   copy,
+                                                   (GDestroyNotify) g_byte_array_unref);
+    }
+}
+
+static const gchar *
+command_priority_get_string (MMPortSerialCommandPriority priority)
+{
+    switch (priority) {
+    case MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL:
+        return "control";
+    case MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE:
+        return "interactive";
+    case MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND:
+        return "background";
+    default:
+        return "unknown";
+    }
+}
+
+/* Background requests which are exactly equal to a command already waiting in
+ * the queue don't need to be sent twice; just report the same response to
+ * both. */
+static CommandContext *
+port_serial_find_coalescable_command (MMPortSerial   *self,
+                                      CommandContext *ctx)
+{
+    GList *l;
+
+    if (ctx->priority != MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND)
+        return NULL;
+
+    for (l = self->priv->queue->head; l; l = g_list_next (l)) {
+        CommandContext *queued = (CommandContext *)(l->data);
+
+        if (!queued->started &&
+            queued->priority == ctx->priority &&
+            queued->allow_cached == ctx->allow_cached &&
+            queued->cancellable == ctx->cancellable &&
+            queued->command->len == ctx->command->len &&
+            memcmp (queued->command->data, ctx->command->data, ctx->command->len) == 0)
+            return queued;
+    }
+
+    return NULL;
+}
+
+/* Rank of each priority in the queue; commands with a higher rank are sent
+ * before the ones with a lower rank */
+static guint
+command_priority_get_rank (MMPortSerialCommandPriority priority)
+{
+    switch (priority) {
+    case MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL:
+        return 2;
+    case MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE:
+        return 1;
+    case MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND:
+    default:
+        return 0;
+    }
+}
+
+/* Commands are kept ordered by priority (control, then interactive, then
+ * background), and in FIFO order among the ones with the same priority, as
+ * any of them may depend on the ones queued earlier. Background commands
+ * which have waited long enough are never overtaken, so that they don't
+ * starve. The command at the head of the queue may already be in progress,
+ * and if so, it's never preempted. */
+static void
+port_serial_queue_command (MMPortSerial   *self,
+                           CommandContext *ctx)
+{
+    MMPortSerialQueueStats *stats;
+    GList                  *l;
+    gint64                  now;
+    guint                   rank;
+    guint                   depth;
+
+    now = g_get_monotonic_time ();
+    rank = command_priority_get_rank (ctx->priority);
+    for (l = self->priv->queue->tail; l; l = g_list_previous (l)) {
+        CommandContext *queued = (CommandContext *)(l->data);
+
+        if (queued->started ||
+            command_priority_get_rank (queued->priority) >= rank ||
+            (queued->priority == MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND &&
+             (now - queued->queued_time) >= (QUEUE_BACKGROUND_MAX_WAIT_MS * 1000)))
+            break;
+    }
+
+    if (l)
+        g_queue_insert_after (self->priv->queue, l, ctx);
+    else
+        g_queue_push_head (self->priv->queue, ctx);
+
+    depth = g_queue_get_length (self->priv->queue);
+    stats = &self->priv->queue_stats[ctx->priority];
+    stats->n_queued++;
+    if (depth > stats->max_depth)
+        stats->max_depth = depth;
+    ctx->queued_time = now;
+
+    mm_metric_set (self->priv->metric_queue_depth, depth);
+}
+
+static void
+port_serial_update_wait_stats (MMPortSerial   *self,
+                               CommandContext *ctx)
+{
+    MMPortSerialQueueStats *stats;
+    guint                   wait_ms;
+
+    ctx->start_time = g_get_monotonic_time ();
+
+    stats = &self->priv->queue_stats[ctx->priority];
+    wait_ms = (guint)((ctx->start_time - ctx->queued_time) / 1000);
+    stats->total_wait_ms += wait_ms;
+    if (wait_ms > stats->max_wait_ms)
+        stats->max_wait_ms = wait_ms;
+
+    mm_metric_inc (self->priv->metric_commands);
+    mm_metric_observe (self->priv->metric_queue_wait, wait_ms);
+}
+
+static void
+port_serial_metrics_setup (MMPortSerial *self)
+{
+    const gchar *device;
+
+    if (self->priv->metric_commands)
+        return;
+
+    device = mm_port_get_device (MM_PORT (self));
+    self->priv->metric_commands             = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_serial_commands_total",        device);
+    self->priv->metric_timeouts             = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_serial_timeouts_total",        device);
+    self->priv->metric_consecutive_timeouts = mm_metrics_get (MM_METRIC_TYPE_GAUGE,     "mm_serial_consecutive_timeouts",  device);
+    self->priv->metric_open_failures        = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_serial_open_failures_total",   device);
+    self->priv->metric_queue_wait           = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_serial_queue_wait_ms",         device);
+    self->priv->metric_queue_depth          = mm_metrics_get (MM_METRIC_TYPE_GAUGE,     "mm_serial_queue_depth",           device);
+    self->priv->metric_queue_coalesced      = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_serial_queue_coalesced_total", device);
+    self->priv->metric_queue_rejected       = mm_metrics_get (MM_METRIC_TYPE_COUNTER,   "mm_serial_queue_rejected_total",  device);
+    self->priv->metric_response_time        = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_serial_response_time_ms",      device);
+}
+
+static void
+port_serial_metrics_clear (MMPortSerial *self)
+{
+    g_clear_pointer (&self->priv->metric_commands,             mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_timeouts,             mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_consecutive_timeouts, mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_open_failures,        mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_queue_wait,           mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_queue_depth,          mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_queue_coalesced,      mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_queue_rejected,       mm_metric_unref);
+    g_clear_pointer (&self->priv->metric_response_time,        mm_metric_unref);
+}
+
+static void
+port_serial_update_busy_time (MMPortSerial *self)
+{
+    if (!self->priv->busy_since)
+        return;
+
+    self->priv->busy_time_ms += (g_get_monotonic_time () - self->priv->busy_since) / 1000;
+    self->priv->busy_since = 0;
+}
+
+guint
+mm_port_serial_get_queue_length (MMPortSerial *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), 0);
+
+    return g_queue_get_length (self->priv->queue);
+}
+
+void
+mm_port_serial_get_utilisation (MMPortSerial *self,
+                                guint64      *busy_time_ms,
+                                guint64      *open_time_ms)
+{
+    guint64 busy;
+    guint64 open;
+    gint64  now;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    now = g_get_monotonic_time ();
+    busy = self->priv->busy_time_ms;
+    if (self->priv->busy_since)
+        busy += (now - self->priv->busy_since) / 1000;
+    open = self->priv->open_time_ms;
+    if (self->priv->open_time)
+        open += (now - self->priv->open_time) / 1000;
+
+    if (busy_time_ms)
+        *busy_time_ms = busy;
+    if (open_time_ms)
+        *open_time_ms = open;
+}
+
+void
+mm_port_serial_get_queue_stats (MMPortSerial                *self,
+                                MMPortSerialCommandPriority  priority,
+                                MMPortSerialQueueStats      *stats)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+    g_return_if_fail (priority <= MM_PORT_SERIAL_COMMAND_PRIORITY_LAST);
+    g_return_if_fail (stats != NULL);
+
+    *stats = self->priv->queue_stats[priority];
+}
+
+static void
+port_serial_log_queue_stats (MMPortSerial *self)
+{
+    guint64 busy_time_ms;
+    guint64 open_time_ms;
+    guint   i;
+
+    mm_port_serial_get_utilisation (self, &busy_time_ms, &open_time_ms);
+    if (open_time_ms)
+        mm_dbg ("(%s) port busy %" G_GUINT64_FORMAT " ms out of %" G_GUINT64_FORMAT " ms open (%u%%)",
+                mm_port_get_device (MM_PORT (self)),
+                busy_time_ms,
+                open_time_ms,
+                (guint) ((100 * busy_time_ms) / open_time_ms));
+
+    for (i = 0; i <= MM_PORT_SERIAL_COMMAND_PRIORITY_LAST; i++) {
+        MMPortSerialQueueStats *stats;
+        guint64                 n_processed;
+
+        stats = &self->priv->queue_stats[i];
+        if (!stats->n_queued && !stats->n_rejected)
+            continue;
+
+        /* Merged requests don't wait in the queue on their own */
+        n_processed = stats->n_queued - stats->n_coalesced;
+        mm_dbg ("(%s) %s commands: %" G_GUINT64_FORMAT " queued, %" G_GUINT64_FORMAT " coalesced, "
+                "%" G_GUINT64_FORMAT " rejected, max queue depth %u, average wait %" G_GUINT64_FORMAT " ms, max wait %u ms",
+                mm_port_get_device (MM_PORT (self)),
+                command_priority_get_string ((MMPortSerialCommandPriority) i),
+                stats->n_queued,
+                stats->n_coalesced,
+                stats->n_rejected,
+                stats->max_depth,
+                n_processed ? (stats->total_wait_ms / n_processed) : 0,
+                stats->max_wait_ms);
+    }
+}
+
+static gboolean
+port_serial_queue_stats_log_cb (MMPortSerial *self)
+{
+    port_serial_log_queue_stats (self);
+    return G_SOURCE_CONTINUE;
+}
+
 GByteArray *
 mm_port_serial_command_finish (MMPortSerial *self,
                                GAsyncResult *res,
@@ -163,14 +509,17 @@ mm_port_serial_command (MMPortSerial *self,
                         GByteArray *command,
                         guint32 timeout_seconds,
                         gboolean allow_cached,
+                        MMPortSerialCommandPriority priority,
                         GCancellable *cancellable,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
 {
     CommandContext *ctx;
+    CommandContext *queued;
 
     g_return_if_fail (MM_IS_PORT_SERIAL (self));
     g_return_if_fail (command != NULL);
+    g_return_if_fail (priority <= MM_PORT_SERIAL_COMMAND_PRIORITY_LAST);
 
     /* Setup command context */
     ctx = g_slice_new0 (CommandContext);
@@ -181,6 +530,7 @@ mm_port_serial_command (MMPortSerial *self,
                                              mm_port_serial_command);
     ctx->command = g_byte_array_ref (command);
     ctx->allow_cached = allow_cached;
+    ctx->priority = priority;
     ctx->timeout = timeout_seconds;
     ctx->cancellable = (cancellable ? g_object_ref (cancellable) : NULL);
 
@@ -199,14 +549,39 @@ mm_port_serial_command (MMPortSerial *self,
         return;
     }
 
+    /* Same command already waiting in the queue? If so, the new request will
+     * be completed along with the queued one */
+    queued = port_serial_find_coalescable_command (self, ctx);
+    if (queued) {
+        queued->coalesced = g_list_append (queued->coalesced, ctx->result);
+        self->priv->queue_stats[priority].n_queued++;
+        self->priv->queue_stats[priority].n_coalesced++;
+        mm_metric_inc (self->priv->metric_queue_coalesced);
+        g_byte_array_unref (ctx->command);
+        if (ctx->cancellable)
+            g_object_unref (ctx->cancellable);
+        g_object_unref (ctx->self);
+        g_slice_free (CommandContext, ctx);
+        return;
+    }
+
+    if (g_queue_get_length (self->priv->queue) >= QUEUE_MAX_DEPTH) {
+        self->priv->queue_stats[priority].n_rejected++;
+        mm_metric_inc (self->priv->metric_queue_rejected);
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_SERIAL_ERROR,
+                                         MM_SERIAL_ERROR_QUEUE_FULL,
+                                         "Sending command failed: too many commands queued");
+        command_context_complete_and_free (ctx, TRUE);
+        return;
+    }
+
     /* Clear the cached value for this command if not asking for cached value */
     if (!allow_cached)
         port_serial_set_cached_reply (self, ctx->command, NULL);
 
-    g_queue_push_tail (self->priv->queue, ctx);
-
-    if (g_queue_get_length (self->priv->queue) == 1)
-        port_serial_schedule_queue_process (self, 0);
+    port_serial_queue_command (self, ctx);
+    port_serial_schedule_queue_process (self, 0);
 }
 
 /*****************************************************************************/
@@ -608,7 +983,7 @@ port_serial_process_command (MMPortSerial *self,
             ctx->eagain_count--;
             if (ctx->eagain_count <= 0) {
                 /* If we reach the limit of EAGAIN errors, treat as a timeout error. */
-                self->priv->n_consecutive_timeouts++;
+                port_serial_timeout_found (self);
                 g_signal_emit (self, signals[TIMED_OUT], 0, self->priv->n_consecutive_timeouts);
 
                 g_set_error (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_SEND_FAILED,
@@ -641,7 +1016,7 @@ port_serial_process_command (MMPortSerial *self,
             ctx->eagain_count--;
             if (ctx->eagain_count <= 0) {
                 /* If we reach the limit of EAGAIN errors, treat as a timeout error. */
-                self->priv->n_consecutive_timeouts++;
+                port_serial_timeout_found (self);
                 g_signal_emit (self, signals[TIMED_OUT], 0, self->priv->n_consecutive_timeouts);
                 g_set_error (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_SEND_FAILED,
                              "Sending command failed: '%s'", strerror (errno));
@@ -663,6 +1038,116 @@ port_serial_process_command (MMPortSerial *self,
     return TRUE;
 }
 
+/*****************************************************************************/
+/* Raw write */
+
+static gboolean
+port_serial_write_flush (MMPortSerial  *self,
+                         GError       **error)
+{
+    while (self->priv->write_buffer->len > 0) {
+        gsize written = 0;
+
+        if (self->priv->iochannel) {
+            if (g_io_channel_write_chars (self->priv->iochannel,
+                                          (const gchar *)self->priv->write_buffer->data,
+                                          self->priv->write_buffer->len,
+                                          &written,
+                                          error) == G_IO_STATUS_ERROR) {
+                g_prefix_error (error, "Writing data failed: ");
+                return FALSE;
+            }
+        } else if (self->priv->socket) {
+            GError *inner_error = NULL;
+            gssize bytes_sent;
+
+            bytes_sent = g_socket_send (self->priv->socket,
+                                        (const gchar *)self->priv->write_buffer->data,
+                                        self->priv->write_buffer->len,
+                                        NULL,
+                                        &inner_error);
+            if (bytes_sent < 0) {
+                if (!g_error_matches (inner_error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+                    g_propagate_prefixed_error (error, inner_error, "Writing data failed: ");
+                    return FALSE;
+                }
+                g_error_free (inner_error);
+            } else
+                written = (gsize)bytes_sent;
+        } else {
+            g_set_error_literal (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_SEND_FAILED,
+                                 "Writing data failed: device is not enabled");
+            return FALSE;
+        }
+
+        /* Nothing written (EAGAIN), retry later */
+        if (!written)
+            break;
+
+        g_byte_array_remove_range (self->priv->write_buffer, 0, written);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+port_serial_write_retry_cb (MMPortSerial *self)
+{
+    GError *error = NULL;
+
+    self->priv->write_id = 0;
+
+    if (!port_serial_write_flush (self, &error)) {
+        mm_warn ("(%s) %s", mm_port_get_device (MM_PORT (self)), error->message);
+        g_error_free (error);
+        g_byte_array_set_size (self->priv->write_buffer, 0);
+        return G_SOURCE_REMOVE;
+    }
+
+    if (self->priv->write_buffer->len > 0)
+        self->priv->write_id = g_timeout_add (WRITE_RETRY_TIMEOUT_MS,
+                                              (GSourceFunc) port_serial_write_retry_cb,
+                                              self);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean
+mm_port_serial_write (MMPortSerial  *self,
+                      const guint8  *data,
+                      gsize          len,
+                      GError       **error)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), FALSE);
+    g_return_val_if_fail (data != NULL && len > 0, FALSE);
+
+    if (self->priv->iochannel == NULL && self->priv->socket == NULL) {
+        g_set_error_literal (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_SEND_FAILED,
+                             "Writing data failed: device is not enabled");
+        return FALSE;
+    }
+
+    serial_debug (self, "-->", (const char *) data, len);
+    g_byte_array_append (self->priv->write_buffer, data, len);
+
+    /* If already waiting to retry a previous write, the new data will be
+     * sent afterwards */
+    if (self->priv->write_id)
+        return TRUE;
+
+    if (!port_serial_write_flush (self, error)) {
+        g_byte_array_set_size (self->priv->write_buffer, 0);
+        return FALSE;
+    }
+
+    if (self->priv->write_buffer->len > 0)
+        self->priv->write_id = g_timeout_add (WRITE_RETRY_TIMEOUT_MS,
+                                              (GSourceFunc) port_serial_write_retry_cb,
+                                              self);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 static void
 port_serial_set_cached_reply (MMPortSerial *self,
                               const GByteArray *command,
@@ -740,16 +1225,19 @@ port_serial_got_response (MMPortSerial *self,
         CommandContext *ctx;
 
         ctx = (CommandContext *) g_queue_pop_head (self->priv->queue);
+        mm_metric_set (self->priv->metric_queue_depth, g_queue_get_length (self->priv->queue));
         if (ctx) {
+            if (ctx->start_time)
+                mm_metric_observe (self->priv->metric_response_time,
+                                   (g_get_monotonic_time () - ctx->start_time) / 1000);
+
             /* Complete the command context with the appropriate result */
             if (error)
-                g_simple_async_result_set_from_error (ctx->result, error);
+                command_context_set_error (ctx, error);
             else {
                 if (ctx->allow_cached)
                     port_serial_set_cached_reply (self, ctx->command, parsed_response);
-                g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                           g_byte_array_ref (parsed_response),
-                                                           (GDestroyNotify) g_byte_array_unref);
+                command_context_set_response (ctx, parsed_response);
             }
 
             /* Don't complete in idle. We need the caller remove the response range which
@@ -759,10 +1247,27 @@ port_serial_got_response (MMPortSerial *self,
 
         if (!g_queue_is_empty (self->priv->queue))
             port_serial_schedule_queue_process (self, 0);
+        else
+            port_serial_update_busy_time (self);
     }
     g_object_unref (self);
 }
 
+static void
+port_serial_timeout_found (MMPortSerial *self)
+{
+    self->priv->n_consecutive_timeouts++;
+    mm_metric_inc (self->priv->metric_timeouts);
+    mm_metric_set (self->priv->metric_consecutive_timeouts, self->priv->n_consecutive_timeouts);
+}
+
+static void
+port_serial_timeouts_reset (MMPortSerial *self)
+{
+    self->priv->n_consecutive_timeouts = 0;
+    mm_metric_set (self->priv->metric_consecutive_timeouts, 0);
+}
+
 static gboolean
 port_serial_timed_out (gpointer data)
 {
@@ -772,7 +1277,7 @@ port_serial_timed_out (gpointer data)
     self->priv->timeout_id = 0;
 
     /* Update number of consecutive timeouts found */
-    self->priv->n_consecutive_timeouts++;
+    port_serial_timeout_found (self);
 
     /* FIXME: This is not completely correct - if the response finally arrives and there's
      * some other command waiting for response right now, the other command will
@@ -830,6 +1335,13 @@ port_serial_queue_process (gpointer data)
     if (!ctx)
         return G_SOURCE_REMOVE;
 
+    /* Only account the wait time the first time the command is processed */
+    if (!ctx->started)
+        port_serial_update_wait_stats (self, ctx);
+
+    if (!self->priv->busy_since)
+        self->priv->busy_since = g_get_monotonic_time ();
+
     if (ctx->allow_cached) {
         const GByteArray *cached;
 
@@ -924,7 +1436,7 @@ parse_response_buffer (MMPortSerial *self)
     case MM_PORT_SERIAL_RESPONSE_BUFFER:
         /* We have a valid response to process */
         g_assert (parsed_response);
-        self->priv->n_consecutive_timeouts = 0;
+        port_serial_timeouts_reset (self);
         /* Note: may complete last operation and unref the MMPortSerial */
         port_serial_got_response (self, parsed_response, NULL);
         g_byte_array_unref (parsed_response);
@@ -932,7 +1444,7 @@ parse_response_buffer (MMPortSerial *self)
     case MM_PORT_SERIAL_RESPONSE_ERROR:
         /* We have an error to process */
         g_assert (error);
-        self->priv->n_consecutive_timeouts = 0;
+        port_serial_timeouts_reset (self);
         /* Note: may complete last operation and unref the MMPortSerial */
         port_serial_got_response (self, NULL, error);
         g_error_free (error);
@@ -1157,6 +1669,8 @@ mm_port_serial_open (MMPortSerial *self, GError **error)
 
     device = mm_port_get_device (MM_PORT (self));
 
+    port_serial_metrics_setup (self);
+
     if (self->priv->forced_close) {
         g_set_error (error,
                      MM_SERIAL_ERROR,
@@ -1321,6 +1835,14 @@ success:
     self->priv->open_count++;
     mm_dbg ("(%s) device open count is %d (open)", device, self->priv->open_count);
 
+    if (self->priv->open_count == 1) {
+        self->priv->open_time = g_get_monotonic_time ();
+        g_assert (!self->priv->queue_stats_id);
+        self->priv->queue_stats_id = g_timeout_add_seconds (QUEUE_STATS_LOG_PERIOD_SECS,
+                                                            (GSourceFunc) port_serial_queue_stats_log_cb,
+                                                            self);
+    }
+
     /* Run additional port config if just opened */
     if (self->priv->open_count == 1 && MM_PORT_SERIAL_GET_CLASS (self)->config)
         MM_PORT_SERIAL_GET_CLASS (self)->config (self);
@@ -1329,6 +1851,7 @@ success:
 
 error:
     mm_warn ("(%s) failed to open serial device", device);
+    mm_metric_inc (self->priv->metric_open_failures);
 
     if (self->priv->iochannel) {
         g_io_channel_unref (self->priv->iochannel);
@@ -1455,15 +1978,29 @@ _close_internal (MMPortSerial *self, gboolean force)
     /* Clear the command queue */
     for (i = 0; i < g_queue_get_length (self->priv->queue); i++) {
         CommandContext *ctx;
+        GError *error;
 
         ctx = g_queue_peek_nth (self->priv->queue, i);
-        g_simple_async_result_set_error (ctx->result,
-                                         MM_SERIAL_ERROR,
-                                         MM_SERIAL_ERROR_SEND_FAILED,
-                                         "Serial port is now closed");
+        error = g_error_new_literal (MM_SERIAL_ERROR,
+                                     MM_SERIAL_ERROR_SEND_FAILED,
+                                     "Serial port is now closed");
+        command_context_set_error (ctx, error);
+        g_error_free (error);
         command_context_complete_and_free (ctx, TRUE);
     }
     g_queue_clear (self->priv->queue);
+    mm_metric_set (self->priv->metric_queue_depth, 0);
+
+    port_serial_update_busy_time (self);
+    if (self->priv->open_time) {
+        self->priv->open_time_ms += (g_get_monotonic_time () - self->priv->open_time) / 1000;
+        self->priv->open_time = 0;
+    }
+    if (self->priv->queue_stats_id) {
+        g_source_remove (self->priv->queue_stats_id);
+        self->priv->queue_stats_id = 0;
+    }
+    port_serial_log_queue_stats (self);
 
     if (self->priv->timeout_id) {
         g_source_remove (self->priv->timeout_id);
@@ -1475,6 +2012,12 @@ _close_internal (MMPortSerial *self, gboolean force)
         self->priv->queue_id = 0;
     }
 
+    if (self->priv->write_id) {
+        g_source_remove (self->priv->write_id);
+        self->priv->write_id = 0;
+    }
+    g_byte_array_set_size (self->priv->write_buffer, 0);
+
     if (self->priv->cancellable_id) {
         g_assert (self->priv->cancellable != NULL);
         g_cancellable_disconnect (self->priv->cancellable,
@@ -1960,6 +2503,7 @@ mm_port_serial_init (MMPortSerial *self)
 
     self->priv->queue = g_queue_new ();
     self->priv->response = g_byte_array_sized_new (500);
+    self->priv->write_buffer = g_byte_array_new ();
 }
 
 static void
@@ -2066,10 +2610,16 @@ finalize (GObject *object)
     if (self->priv->queue_id)
         g_source_remove (self->priv->queue_id);
 
+    if (self->priv->write_id)
+        g_source_remove (self->priv->write_id);
+
     g_hash_table_destroy (self->priv->reply_cache);
     g_byte_array_unref (self->priv->response);
+    g_byte_array_unref (self->priv->write_buffer);
     g_queue_free (self->priv->queue);
 
+    port_serial_metrics_clear (self);
+
     G_OBJECT_CLASS (mm_port_serial_parent_class)->finalize (object);
 }
 
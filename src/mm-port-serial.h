@@ -47,6 +47,36 @@ typedef enum {
     MM_PORT_SERIAL_RESPONSE_ERROR,
 } MMPortSerialResponseType;
 
+/* Priority of the commands queued in the port. Control commands are sent
+ * before interactive ones, and these before background commands (e.g.
+ * periodic polls); commands with the same priority are always sent in the
+ * same order they were queued, as they may depend on each other. A background
+ * command which has been waiting for too long is no longer overtaken, and no
+ * command ever preempts the one currently in progress. Background commands
+ * which are equal to one already queued are merged with it. */
+typedef enum {
+    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE = 0,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND  = 1,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL     = 2,
+} MMPortSerialCommandPriority;
+
+#define MM_PORT_SERIAL_COMMAND_PRIORITY_LAST MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL
+
+/* Queue statistics, per command priority */
+typedef struct {
+    /* Number of commands queued */
+    guint64 n_queued;
+    /* Number of requests merged into an already queued command */
+    guint64 n_coalesced;
+    /* Number of requests rejected because the queue was full */
+    guint64 n_rejected;
+    /* Maximum number of commands found in the queue when adding a new one */
+    guint   max_depth;
+    /* Time spent by commands in the queue before being processed */
+    guint64 total_wait_ms;
+    guint   max_wait_ms;
+} MMPortSerialQueueStats;
+
 typedef struct _MMPortSerial MMPortSerial;
 typedef struct _MMPortSerialClass MMPortSerialClass;
 typedef struct _MMPortSerialPrivate MMPortSerialPrivate;
@@ -144,6 +174,7 @@ void        mm_port_serial_command        (MMPortSerial *self,
                                            GByteArray *command,
                                            guint32 timeout_seconds,
                                            gboolean allow_cached,
+                                           MMPortSerialCommandPriority priority,
                                            GCancellable *cancellable,
                                            GAsyncReadyCallback callback,
                                            gpointer user_data);
@@ -151,9 +182,25 @@ GByteArray *mm_port_serial_command_finish (MMPortSerial *self,
                                            GAsyncResult *res,
                                            GError **error);
 
+/* Writes raw data to the port, bypassing the command queue. Only to be used
+ * by subclasses implementing their own framing on top of the port, which
+ * don't mix raw writes with queued commands. */
+gboolean    mm_port_serial_write          (MMPortSerial *self,
+                                           const guint8 *data,
+                                           gsize len,
+                                           GError **error);
+
 gboolean mm_port_serial_set_flow_control (MMPortSerial   *self,
                                           MMFlowControl   flow_control,
                                           GError        **error);
 
 MMFlowControl mm_port_serial_get_flow_control (MMPortSerial *self);
+
+void  mm_port_serial_get_queue_stats (MMPortSerial                *self,
+                                      MMPortSerialCommandPriority  priority,
+                                      MMPortSerialQueueStats      *stats);
+guint mm_port_serial_get_queue_length (MMPortSerial                *self);
+void  mm_port_serial_get_utilisation  (MMPortSerial                *self,
+                                      guint64                     *busy_time_ms,
+                                      guint64                     *open_time_ms);
 #endif /* MM_PORT_SERIAL_H */
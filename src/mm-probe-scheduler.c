@@ -0,0 +1,217 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+
+#include "mm-probe-scheduler.h"
+#include "mm-metrics.h"
+#include "mm-log.h"
+
+struct _MMProbeSchedulerTicket {
+    gchar                     *group;
+    gboolean                   priority;
+    gboolean                   running;
+    gint64                     request_time;
+    guint                      ready_id;
+    MMProbeSchedulerReadyFunc  ready;
+    gpointer                   user_data;
+};
+
+static guint max_running;
+static guint max_running_per_group;
+
+static guint       n_running;
+/* Number of running tickets per group */
+static GHashTable *running_groups;
+
+static GQueue priority_queue = G_QUEUE_INIT;
+static GQueue normal_queue   = G_QUEUE_INIT;
+
+static MMMetric *metric_queue_wait;
+static MMMetric *metric_queued;
+static MMMetric *metric_running;
+
+/*****************************************************************************/
+
+static guint
+group_get_n_running (const gchar *group)
+{
+    if (!running_groups)
+        return 0;
+    return GPOINTER_TO_UINT (g_hash_table_lookup (running_groups, group));
+}
+
+static void
+group_set_n_running (const gchar *group,
+                     guint        n)
+{
+    if (G_UNLIKELY (!running_groups))
+        running_groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    if (n)
+        g_hash_table_insert (running_groups, g_strdup (group), GUINT_TO_POINTER (n));
+    else
+        g_hash_table_remove (running_groups, group);
+}
+
+static gboolean
+ticket_can_run (MMProbeSchedulerTicket *ticket)
+{
+    if (max_running && n_running >= max_running)
+        return FALSE;
+    if (ticket->group && max_running_per_group && group_get_n_running (ticket->group) >= max_running_per_group)
+        return FALSE;
+    return TRUE;
+}
+
+static void
+update_gauges (void)
+{
+    mm_metric_set (metric_running, n_running);
+    mm_metric_set (metric_queued, priority_queue.length + normal_queue.length);
+}
+
+static gboolean
+ticket_ready_idle (MMProbeSchedulerTicket *ticket)
+{
+    ticket->ready_id = 0;
+    ticket->ready (ticket->user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+ticket_start (MMProbeSchedulerTicket *ticket)
+{
+    ticket->running = TRUE;
+    n_running++;
+    if (ticket->group)
+        group_set_n_running (ticket->group, group_get_n_running (ticket->group) + 1);
+
+    mm_metric_observe (metric_queue_wait, (g_get_monotonic_time () - ticket->request_time) / 1000);
+    ticket->ready_id = g_idle_add ((GSourceFunc) ticket_ready_idle, ticket);
+}
+
+static void
+schedule_queue (GQueue *queue)
+{
+    GList *l;
+    GList *next;
+
+    for (l = queue->head; l; l = next) {
+        MMProbeSchedulerTicket *ticket;
+
+        /* Nothing else can run */
+        if (max_running && n_running >= max_running)
+            return;
+
+        next = g_list_next (l);
+        ticket = (MMProbeSchedulerTicket *) l->data;
+        if (!ticket_can_run (ticket))
+            continue;
+
+        g_queue_delete_link (queue, l);
+        ticket_start (ticket);
+    }
+}
+
+static void
+schedule (void)
+{
+    /* Tickets blocked by the limit of their group don't block the ones
+     * behind them */
+    schedule_queue (&priority_queue);
+    schedule_queue (&normal_queue);
+    update_gauges ();
+}
+
+/*****************************************************************************/
+
+void
+mm_probe_scheduler_set_limits (guint max_running_value,
+                               guint max_running_per_group_value)
+{
+    max_running           = max_running_value;
+    max_running_per_group = max_running_per_group_value;
+
+    mm_dbg ("probe scheduler limits: %u running (%u per group)",
+            max_running, max_running_per_group);
+
+    /* New limits may allow queued tickets to run */
+    schedule ();
+}
+
+MMProbeSchedulerTicket *
+mm_probe_scheduler_request (const gchar               *group,
+                            gboolean                   priority,
+                            MMProbeSchedulerReadyFunc  ready,
+                            gpointer                   user_data)
+{
+    MMProbeSchedulerTicket *ticket;
+
+    g_assert (ready);
+
+    if (G_UNLIKELY (!metric_queue_wait)) {
+        metric_queue_wait = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "mm_probe_queue_wait_ms", NULL);
+        metric_queued     = mm_metrics_get (MM_METRIC_TYPE_GAUGE,     "mm_probe_queued",        NULL);
+        metric_running    = mm_metrics_get (MM_METRIC_TYPE_GAUGE,     "mm_probe_running",       NULL);
+    }
+
+    ticket = g_slice_new0 (MMProbeSchedulerTicket);
+    ticket->group        = g_strdup (group);
+    ticket->priority     = priority;
+    ticket->request_time = g_get_monotonic_time ();
+    ticket->ready        = ready;
+    ticket->user_data    = user_data;
+
+    g_queue_push_tail (priority ? &priority_queue : &normal_queue, ticket);
+    schedule ();
+
+    if (!ticket->running)
+        mm_dbg ("probe scheduler: request queued (%u running, %u queued)",
+                n_running, priority_queue.length + normal_queue.length);
+
+    return ticket;
+}
+
+void
+mm_probe_scheduler_release (MMProbeSchedulerTicket *ticket)
+{
+    if (ticket->running) {
+        if (ticket->ready_id)
+            g_source_remove (ticket->ready_id);
+        g_assert (n_running > 0);
+        n_running--;
+        if (ticket->group)
+            group_set_n_running (ticket->group, group_get_n_running (ticket->group) - 1);
+    } else
+        g_queue_remove (ticket->priority ? &priority_queue : &normal_queue, ticket);
+
+    g_free (ticket->group);
+    g_slice_free (MMProbeSchedulerTicket, ticket);
+
+    schedule ();
+}
+
+guint
+mm_probe_scheduler_get_n_running (void)
+{
+    return n_running;
+}
+
+guint
+mm_probe_scheduler_get_n_queued (void)
+{
+    return priority_queue.length + normal_queue.length;
+}
@@ -0,0 +1,51 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_PROBE_SCHEDULER_H
+#define MM_PROBE_SCHEDULER_H
+
+#include <glib.h>
+
+/*****************************************************************************/
+/* Limits how many port probings run at the same time.
+ *
+ * Before talking to a port, a probing requests a ticket and waits until the
+ * ticket is ready. Tickets may be given a group, e.g. the USB hub the device
+ * is connected to, so that the number of probings running in the same group
+ * can be limited as well as the total number. Priority tickets are always
+ * made ready before the other ones.
+ *
+ * The ready callback is always called from an idle, never from within
+ * mm_probe_scheduler_request(). Tickets must be released once the probing is
+ * done, or to cancel a request that is still waiting. */
+
+typedef struct _MMProbeSchedulerTicket MMProbeSchedulerTicket;
+
+typedef void (* MMProbeSchedulerReadyFunc) (gpointer user_data);
+
+/* 0 means no limit */
+void mm_probe_scheduler_set_limits (guint max_running,
+                                    guint max_running_per_group);
+
+MMProbeSchedulerTicket *mm_probe_scheduler_request (const gchar               *group,
+                                                    gboolean                   priority,
+                                                    MMProbeSchedulerReadyFunc  ready,
+                                                    gpointer                   user_data);
+void                    mm_probe_scheduler_release (MMProbeSchedulerTicket    *ticket);
+
+guint mm_probe_scheduler_get_n_running (void);
+guint mm_probe_scheduler_get_n_queued  (void);
+
+#endif /* MM_PROBE_SCHEDULER_H */
@@ -0,0 +1,137 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include "mm-sim-info-cache.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+typedef struct {
+    /* file id -> contents */
+    GHashTable *files;
+    gint64      created;
+    gint64      expiration;
+} CacheEntry;
+
+static GHashTable *cache;
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+    g_hash_table_unref (entry->files);
+    g_slice_free (CacheEntry, entry);
+}
+
+static void
+evict_oldest (void)
+{
+    GHashTableIter  iter;
+    gpointer        key;
+    gpointer        value;
+    const gchar    *oldest_iccid = NULL;
+    gint64          oldest_created = G_MAXINT64;
+
+    g_hash_table_iter_init (&iter, cache);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        CacheEntry *entry = value;
+
+        if (entry->created < oldest_created) {
+            oldest_created = entry->created;
+            oldest_iccid = key;
+        }
+    }
+
+    if (oldest_iccid)
+        mm_sim_info_cache_invalidate (oldest_iccid, "too many cards");
+}
+
+void
+mm_sim_info_cache_store (const gchar *iccid,
+                         guint        file_id,
+                         const gchar *contents)
+{
+    CacheEntry *entry;
+
+    g_return_if_fail (iccid != NULL);
+    g_return_if_fail (contents != NULL);
+
+    if (G_UNLIKELY (!cache))
+        cache = g_hash_table_new_full (g_str_hash,
+                                       g_str_equal,
+                                       g_free,
+                                       (GDestroyNotify) cache_entry_free);
+
+    entry = g_hash_table_lookup (cache, iccid);
+    if (entry && g_get_monotonic_time () >= entry->expiration) {
+        mm_sim_info_cache_invalidate (iccid, "expired");
+        entry = NULL;
+    }
+
+    if (!entry) {
+        if (g_hash_table_size (cache) >= MM_SIM_INFO_CACHE_MAX_CARDS)
+            evict_oldest ();
+
+        entry = g_slice_new0 (CacheEntry);
+        entry->files = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+        entry->created = g_get_monotonic_time ();
+        entry->expiration = entry->created + (MM_SIM_INFO_CACHE_TTL_SECS * G_USEC_PER_SEC);
+        g_hash_table_insert (cache, g_strdup (iccid), entry);
+    }
+
+    mm_dbg ("(%s) caching SIM file 0x%04x", iccid, file_id);
+    g_hash_table_replace (entry->files, GUINT_TO_POINTER (file_id), g_strdup (contents));
+}
+
+const gchar *
+mm_sim_info_cache_peek (const gchar *iccid,
+                        guint        file_id)
+{
+    CacheEntry *entry;
+
+    g_return_val_if_fail (iccid != NULL, NULL);
+
+    if (!cache || !(entry = g_hash_table_lookup (cache, iccid)))
+        return NULL;
+
+    if (g_get_monotonic_time () >= entry->expiration) {
+        mm_sim_info_cache_invalidate (iccid, "expired");
+        return NULL;
+    }
+
+    return g_hash_table_lookup (entry->files, GUINT_TO_POINTER (file_id));
+}
+
+void
+mm_sim_info_cache_invalidate (const gchar *iccid,
+                              const gchar *reason)
+{
+    g_return_if_fail (iccid != NULL);
+
+    if (!cache || !g_hash_table_contains (cache, iccid))
+        return;
+
+    /* Log before removing, @iccid may be the key itself */
+    mm_dbg ("(%s) cached SIM files invalidated: %s", iccid, reason ? reason : "unknown");
+    g_hash_table_remove (cache, iccid);
+}
+
+void
+mm_sim_info_cache_clear (void)
+{
+    g_clear_pointer (&cache, g_hash_table_unref);
+}
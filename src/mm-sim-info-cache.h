@@ -0,0 +1,59 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_SIM_INFO_CACHE_H
+#define MM_SIM_INFO_CACHE_H
+
+#include <glib.h>
+
+/*****************************************************************************/
+/* Cache of SIM elementary file contents, kept across SIM objects so that
+ * the files don't need to be read again when the same card is found after
+ * a modem reset or reprobe. Entries are keyed by ICCID, which is always read
+ * from the card, so a different card never gets the contents of another
+ * one. The contents are stored as given by the loader (e.g. the raw +CRSM
+ * response) and parsed again by the user. */
+
+/* SIM files are not expected to change while the card is in use, just make
+ * sure they're read once in a while */
+#define MM_SIM_INFO_CACHE_TTL_SECS (24 * 60 * 60)
+
+/* Bound the number of cards remembered, the oldest one is evicted */
+#define MM_SIM_INFO_CACHE_MAX_CARDS 8
+
+/* Elementary file identifiers, 3GPP TS 31.102 */
+#define MM_SIM_FILE_ICCID 0x2FE2
+#define MM_SIM_FILE_IMSI  0x6F07
+#define MM_SIM_FILE_SPN   0x6F46
+#define MM_SIM_FILE_AD    0x6FAD
+
+/* Any previous contents of the same file for the same card are replaced */
+void mm_sim_info_cache_store (const gchar *iccid,
+                              guint        file_id,
+                              const gchar *contents);
+
+/* Returns the cached contents of the file, or NULL if not found or expired.
+ * The returned value is owned by the cache, and only valid until the cache
+ * is next modified. */
+const gchar *mm_sim_info_cache_peek (const gchar *iccid,
+                                     guint        file_id);
+
+void mm_sim_info_cache_invalidate (const gchar *iccid,
+                                   const gchar *reason);
+
+/* Removes all entries */
+void mm_sim_info_cache_clear (void);
+
+#endif /* MM_SIM_INFO_CACHE_H */
@@ -50,6 +50,9 @@ struct _MMSmsListPrivate {
     MMBaseModem *modem;
     /* List of sms objects */
     GList *list;
+    /* NULL-terminated array with the paths of the sms objects, kept in sync
+     * with the list so that it doesn't need to be rebuilt on every change */
+    GPtrArray *paths;
 };
 
 /*****************************************************************************/
@@ -89,26 +92,59 @@ mm_sms_list_get_count (MMSmsList *self)
     return g_list_length (self->priv->list);
 }
 
+const gchar *const *
+mm_sms_list_peek_paths (MMSmsList *self)
+{
+    return (const gchar *const *) self->priv->paths->pdata;
+}
+
 GStrv
 mm_sms_list_get_paths (MMSmsList *self)
 {
-    GStrv path_list = NULL;
-    GList *l;
-    guint i;
+    return g_strdupv ((gchar **) self->priv->paths->pdata);
+}
 
-    path_list = g_new0 (gchar *,
-                        1 + g_list_length (self->priv->list));
+static void
+paths_add (MMSmsList   *self,
+           const gchar *path)
+{
+    /* Don't try to add NULL paths (not yet exported SMS objects) */
+    if (!path)
+        return;
 
-    for (i = 0, l = self->priv->list; l; l = g_list_next (l)) {
-        const gchar *path;
+    /* Newest first, same as in the list; the NULL terminator is moved along
+     * with the other paths */
+    g_ptr_array_add (self->priv->paths, NULL);
+    memmove (&self->priv->paths->pdata[1],
+             &self->priv->paths->pdata[0],
+             (self->priv->paths->len - 1) * sizeof (gpointer));
+    self->priv->paths->pdata[0] = g_strdup (path);
+}
 
-        /* Don't try to add NULL paths (not yet exported SMS objects) */
-        path = mm_base_sms_get_path (MM_BASE_SMS (l->data));
-        if (path)
-            path_list[i++] = g_strdup (path);
+static void
+paths_remove (MMSmsList   *self,
+              const gchar *path)
+{
+    guint i;
+
+    for (i = 0; i < self->priv->paths->len - 1; i++) {
+        if (g_str_equal (g_ptr_array_index (self->priv->paths, i), path)) {
+            g_ptr_array_remove_index (self->priv->paths, i);
+            return;
+        }
     }
+}
 
-    return path_list;
+static void
+list_add_sms (MMSmsList *self,
+              MMBaseSms *sms,
+              gboolean   received)
+{
+    self->priv->list = g_list_prepend (self->priv->list, sms);
+    paths_add (self, mm_base_sms_get_path (sms));
+    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
+                   mm_base_sms_get_path (sms),
+                   received);
 }
 
 /*****************************************************************************/
@@ -155,6 +191,7 @@ delete_ready (MMBaseSms *sms,
         g_object_unref (MM_BASE_SMS (l->data));
         self->priv->list = g_list_delete_link (self->priv->list, l);
     }
+    paths_remove (self, path);
 
     /* We don't need to unref the SMS any more, but we can use the
      * reference we got in the method, which is the one kept alive
@@ -208,10 +245,7 @@ void
 mm_sms_list_add_sms (MMSmsList *self,
                      MMBaseSms *sms)
 {
-    self->priv->list = g_list_prepend (self->priv->list, g_object_ref (sms));
-    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
-                   mm_base_sms_get_path (sms),
-                   FALSE);
+    list_add_sms (self, g_object_ref (sms), FALSE);
 }
 
 /*****************************************************************************/
@@ -256,10 +290,7 @@ take_singlepart (MMSmsList *self,
     if (!sms)
         return FALSE;
 
-    self->priv->list = g_list_prepend (self->priv->list, sms);
-    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
-                   mm_base_sms_get_path (sms),
-                   state == MM_SMS_STATE_RECEIVED);
+    list_add_sms (self, sms, state == MM_SMS_STATE_RECEIVED);
     return TRUE;
 }
 
@@ -293,11 +324,8 @@ take_multipart (MMSmsList *self,
     if (!sms)
         return FALSE;
 
-    self->priv->list = g_list_prepend (self->priv->list, sms);
-    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
-                   mm_base_sms_get_path (sms),
-                   (state == MM_SMS_STATE_RECEIVED ||
-                    state == MM_SMS_STATE_RECEIVING));
+    list_add_sms (self, sms, (state == MM_SMS_STATE_RECEIVED ||
+                              state == MM_SMS_STATE_RECEIVING));
 
     return TRUE;
 }
@@ -421,6 +449,9 @@ mm_sms_list_init (MMSmsList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_SMS_LIST,
                                               MMSmsListPrivate);
+
+    self->priv->paths = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_add (self->priv->paths, NULL);
 }
 
 static void
@@ -435,6 +466,16 @@ dispose (GObject *object)
     G_OBJECT_CLASS (mm_sms_list_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    MMSmsList *self = MM_SMS_LIST (object);
+
+    g_ptr_array_unref (self->priv->paths);
+
+    G_OBJECT_CLASS (mm_sms_list_parent_class)->finalize (object);
+}
+
 static void
 mm_sms_list_class_init (MMSmsListClass *klass)
 {
@@ -446,6 +487,7 @@ mm_sms_list_class_init (MMSmsListClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /* Properties */
     properties[PROP_MODEM] =
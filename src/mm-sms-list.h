@@ -58,8 +58,9 @@ GType mm_sms_list_get_type (void);
 
 MMSmsList *mm_sms_list_new (MMBaseModem *modem);
 
-GStrv mm_sms_list_get_paths (MMSmsList *self);
-guint mm_sms_list_get_count (MMSmsList *self);
+const gchar *const *mm_sms_list_peek_paths (MMSmsList *self);
+GStrv               mm_sms_list_get_paths  (MMSmsList *self);
+guint               mm_sms_list_get_count  (MMSmsList *self);
 
 gboolean mm_sms_list_has_part (MMSmsList *self,
                                MMSmsStorage storage,
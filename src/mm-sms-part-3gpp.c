@@ -280,6 +280,28 @@ sms_decode_text (const guint8 *text, int len, MMSmsEncoding encoding, int bit_of
     return utf8;
 }
 
+/* Deferred decoders, given the user data copied out of the PDU */
+
+static gchar *
+sms_decode_gsm7_text (const guint8 *data,
+                      gsize data_len,
+                      guint n_elements,
+                      guint bit_offset)
+{
+    /* Never unpack more septets than the copied data holds */
+    n_elements = MIN (n_elements, (data_len * 8 - MIN (bit_offset, data_len * 8)) / 7);
+    return sms_decode_text (data, n_elements, MM_SMS_ENCODING_GSM7, bit_offset);
+}
+
+static gchar *
+sms_decode_ucs2_text (const guint8 *data,
+                      gsize data_len,
+                      guint n_elements,
+                      guint bit_offset)
+{
+    return sms_decode_text (data, MIN (n_elements, data_len), MM_SMS_ENCODING_UCS2, 0);
+}
+
 static guint
 relative_to_validity (guint8 relative)
 {
@@ -362,6 +384,27 @@ mm_sms_part_3gpp_new_from_pdu (guint index,
     return part;
 }
 
+MMSmsPart *
+mm_sms_part_3gpp_new_from_pdu_in_place (guint index,
+                                        gchar *hexpdu,
+                                        GError **error)
+{
+    gsize pdu_len;
+    guint8 *pdu;
+
+    /* Convert PDU from hex to binary, reusing the hex buffer */
+    pdu = mm_sms_part_hexpdu_to_bin_in_place (hexpdu, &pdu_len);
+    if (!pdu) {
+        g_set_error_literal (error,
+                             MM_CORE_ERROR,
+                             MM_CORE_ERROR_FAILED,
+                             "Couldn't convert 3GPP PDU from hex to binary");
+        return NULL;
+    }
+
+    return mm_sms_part_3gpp_new_from_binary_pdu (index, pdu, pdu_len, error);
+}
+
 MMSmsPart *
 mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                                       const guint8 *pdu,
@@ -713,15 +756,25 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         switch (user_data_encoding) {
         case MM_SMS_ENCODING_GSM7:
         case MM_SMS_ENCODING_UCS2:
-            /* Otherwise if it's 7-bit or UCS2 we can decode it */
-            mm_dbg ("Decoding SMS text with '%u' elements", tp_user_data_size_elements);
-            mm_sms_part_take_text (sms_part,
-                                   sms_decode_text (&pdu[tp_user_data_offset],
-                                                    tp_user_data_size_elements,
-                                                    user_data_encoding,
-                                                    bit_offset));
-            g_warn_if_fail (mm_sms_part_get_text (sms_part) != NULL);
-            break;
+            {
+                GByteArray *undecoded;
+                guint undecoded_len;
+
+                /* Otherwise if it's 7-bit or UCS2 we can decode it; but only
+                 * keep the user data here, the text is decoded when read */
+                mm_dbg ("Keeping SMS text with '%u' elements", tp_user_data_size_elements);
+                undecoded_len = MIN (tp_user_data_size_bytes, pdu_len - tp_user_data_offset);
+                undecoded = g_byte_array_sized_new (undecoded_len);
+                g_byte_array_append (undecoded, &pdu[tp_user_data_offset], undecoded_len);
+                mm_sms_part_take_undecoded_text (sms_part,
+                                                 undecoded,
+                                                 tp_user_data_size_elements,
+                                                 bit_offset,
+                                                 (user_data_encoding == MM_SMS_ENCODING_GSM7 ?
+                                                  sms_decode_gsm7_text :
+                                                  sms_decode_ucs2_text));
+                break;
+            }
 
         default:
             {
@@ -26,6 +26,11 @@ MMSmsPart *mm_sms_part_3gpp_new_from_pdu  (guint index,
                                            const gchar *hexpdu,
                                            GError **error);
 
+/* Same as above, but decoding the PDU over @hexpdu, which is overwritten */
+MMSmsPart *mm_sms_part_3gpp_new_from_pdu_in_place (guint index,
+                                                   gchar *hexpdu,
+                                                   GError **error);
+
 MMSmsPart *mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                                                  const guint8 *pdu,
                                                  gsize pdu_len,
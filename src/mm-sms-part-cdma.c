@@ -336,6 +336,27 @@ mm_sms_part_cdma_new_from_pdu (guint index,
     return part;
 }
 
+MMSmsPart *
+mm_sms_part_cdma_new_from_pdu_in_place (guint index,
+                                        gchar *hexpdu,
+                                        GError **error)
+{
+    gsize pdu_len;
+    guint8 *pdu;
+
+    /* Convert PDU from hex to binary, reusing the hex buffer */
+    pdu = mm_sms_part_hexpdu_to_bin_in_place (hexpdu, &pdu_len);
+    if (!pdu) {
+        g_set_error_literal (error,
+                             MM_CORE_ERROR,
+                             MM_CORE_ERROR_FAILED,
+                             "Couldn't convert CDMA PDU from hex to binary");
+        return NULL;
+    }
+
+    return mm_sms_part_cdma_new_from_binary_pdu (index, pdu, pdu_len, error);
+}
+
 struct Parameter {
     guint8 parameter_id;
     guint8 parameter_len;
@@ -765,6 +786,104 @@ read_bearer_data_message_identifier (MMSmsPart *sms_part,
     mm_dbg ("            header indicator: %u", header_ind);
 }
 
+/* Text fields aren't byte aligned, so the decoders work on a copy of the
+ * user data starting at the byte where the first field is, plus the offset
+ * in bits of the field within that byte. The caller has already validated
+ * that all fields are available in the data. */
+
+static guint8 *
+read_fields (const guint8 *data,
+             guint bit_offset,
+             guint n_fields,
+             guint8 field_bits)
+{
+    guint8 *fields;
+    guint byte_offset = 0;
+    guint i;
+
+    fields = g_malloc (n_fields + 1);
+    for (i = 0; i < n_fields; i++) {
+        fields[i] = read_bits (&data[byte_offset], bit_offset, field_bits);
+        bit_offset += field_bits;
+        if (bit_offset >= 8) {
+            bit_offset -= 8;
+            byte_offset++;
+        }
+    }
+    fields[i] = '\0';
+    return fields;
+}
+
+static gchar *
+decode_ascii_7bit_text (const guint8 *data,
+                        gsize data_len,
+                        guint n_elements,
+                        guint bit_offset)
+{
+    gchar *text;
+
+    text = (gchar *) read_fields (data, bit_offset, n_elements, 7);
+    mm_dbg ("CDMA SMS text: '%s'", text);
+    return text;
+}
+
+static gchar *
+decode_latin_text (const guint8 *data,
+                   gsize data_len,
+                   guint n_elements,
+                   guint bit_offset)
+{
+    guint8 *latin;
+    gchar *text;
+
+    latin = read_fields (data, bit_offset, n_elements, 8);
+    text = g_convert ((const gchar *) latin, -1, "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
+    if (!text)
+        mm_dbg ("CDMA SMS text ignored (latin to UTF-8 conversion error)");
+    else
+        mm_dbg ("CDMA SMS text: '%s'", text);
+    g_free (latin);
+    return text;
+}
+
+static gchar *
+decode_unicode_text (const guint8 *data,
+                     gsize data_len,
+                     guint n_elements,
+                     guint bit_offset)
+{
+    guint8 *utf16;
+    gchar *text;
+
+    /* 2 bytes per field */
+    utf16 = read_fields (data, bit_offset, n_elements * 2, 8);
+    text = g_convert ((const gchar *) utf16, n_elements * 2, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
+    if (!text)
+        mm_dbg ("CDMA SMS text ignored (UTF-16 to UTF-8 conversion error)");
+    else
+        mm_dbg ("CDMA SMS text: '%s'", text);
+    g_free (utf16);
+    return text;
+}
+
+static void
+take_undecoded_text (MMSmsPart *sms_part,
+                     const struct Parameter *subparameter,
+                     guint byte_offset,
+                     guint bit_offset,
+                     guint num_fields,
+                     MMSmsPartTextDecodeFunc decode_func)
+{
+    GByteArray *undecoded;
+
+    undecoded = g_byte_array_sized_new (subparameter->parameter_len - byte_offset);
+    g_byte_array_append (undecoded,
+                         &subparameter->parameter_value[byte_offset],
+                         subparameter->parameter_len - byte_offset);
+    mm_dbg ("            text: %u fields, decoded when requested", num_fields);
+    mm_sms_part_take_undecoded_text (sms_part, undecoded, num_fields, bit_offset, decode_func);
+}
+
 static void
 read_bearer_data_user_data (MMSmsPart *sms_part,
                             const struct Parameter *subparameter)
@@ -833,78 +952,21 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
         break;
     }
 
-    case ENCODING_ASCII_7BIT: {
-        gchar *text;
-        guint i;
-
+    case ENCODING_ASCII_7BIT:
         SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 7)) / 8));
-
-        text = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            text[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 7);
-            OFFSETS_UPDATE (7);
-        }
-        text[i] = '\0';
-
-        mm_dbg ("            text: '%s'", text);
-        mm_sms_part_take_text (sms_part, text);
+        take_undecoded_text (sms_part, subparameter, byte_offset, bit_offset, num_fields, decode_ascii_7bit_text);
         break;
-    }
-
-    case ENCODING_LATIN: {
-        gchar *latin;
-        gchar *text;
-        guint i;
 
+    case ENCODING_LATIN:
         SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-
-        latin = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            latin[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        latin[i] = '\0';
-
-        text = g_convert (latin, -1, "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
-        if (!text) {
-            mm_dbg ("            text/data: ignored (latin to UTF-8 conversion error)");
-        } else {
-            mm_dbg ("            text: '%s'", text);
-            mm_sms_part_take_text (sms_part, text);
-        }
-
-        g_free (latin);
+        take_undecoded_text (sms_part, subparameter, byte_offset, bit_offset, num_fields, decode_latin_text);
         break;
-    }
-
-    case ENCODING_UNICODE: {
-        gchar *utf16;
-        gchar *text;
-        guint i;
-        guint num_bytes;
 
+    case ENCODING_UNICODE:
         /* 2 bytes per field! */
-        num_bytes = num_fields * 2;
-
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_bytes * 8)) / 8));
-
-        utf16 = g_malloc (num_bytes);
-        for (i = 0; i < num_bytes; i++) {
-            utf16[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-
-        text = g_convert (utf16, num_bytes, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
-        if (!text) {
-            mm_dbg ("            text/data: ignored (UTF-16 to UTF-8 conversion error)");
-        } else {
-            mm_dbg ("            text: '%s'", text);
-            mm_sms_part_take_text (sms_part, text);
-        }
-
-        g_free (utf16);
+        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 2 * 8)) / 8));
+        take_undecoded_text (sms_part, subparameter, byte_offset, bit_offset, num_fields, decode_unicode_text);
         break;
-    }
 
     default:
         mm_dbg ("            text/data: ignored (unsupported encoding)");
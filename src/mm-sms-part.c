@@ -35,6 +35,11 @@ struct _MMSmsPart {
     gchar *discharge_timestamp;
     gchar *number;
     gchar *text;
+    /* User data not yet converted to text, see mm_sms_part_take_undecoded_text() */
+    GByteArray *undecoded_text;
+    guint undecoded_text_elements;
+    guint undecoded_text_bit_offset;
+    MMSmsPartTextDecodeFunc undecoded_text_func;
     MMSmsEncoding encoding;
     GByteArray *data;
     gint  class;
@@ -62,6 +67,8 @@ mm_sms_part_free (MMSmsPart *self)
     g_free (self->smsc);
     g_free (self->number);
     g_free (self->text);
+    if (self->undecoded_text)
+        g_byte_array_unref (self->undecoded_text);
     if (self->data)
         g_byte_array_unref (self->data);
     g_slice_free (MMSmsPart, self);
@@ -115,8 +122,6 @@ PART_GET_FUNC (guint, concat_max)
 PART_SET_FUNC (guint, concat_max)
 PART_GET_FUNC (guint, concat_sequence)
 PART_SET_FUNC (guint, concat_sequence)
-PART_GET_FUNC (const gchar *, text)
-PART_SET_TAKE_STR_FUNC (text)
 PART_GET_FUNC (MMSmsEncoding, encoding)
 PART_SET_FUNC (MMSmsEncoding, encoding)
 PART_GET_FUNC (gint,  class)
@@ -140,6 +145,104 @@ mm_sms_part_set_concat_reference (MMSmsPart *self,
     self->concat_reference = value;
 }
 
+/*****************************************************************************/
+/* Text, optionally decoded on demand */
+
+static void
+clear_undecoded_text (MMSmsPart *self)
+{
+    if (self->undecoded_text) {
+        g_byte_array_unref (self->undecoded_text);
+        self->undecoded_text = NULL;
+    }
+    self->undecoded_text_func = NULL;
+}
+
+const gchar *
+mm_sms_part_get_text (MMSmsPart *self)
+{
+    if (!self->text && self->undecoded_text) {
+        self->text = self->undecoded_text_func (self->undecoded_text->data,
+                                                self->undecoded_text->len,
+                                                self->undecoded_text_elements,
+                                                self->undecoded_text_bit_offset);
+        clear_undecoded_text (self);
+    }
+    return self->text;
+}
+
+void
+mm_sms_part_set_text (MMSmsPart *self,
+                      const gchar *value)
+{
+    clear_undecoded_text (self);
+    g_free (self->text);
+    self->text = g_strdup (value);
+}
+
+void
+mm_sms_part_take_text (MMSmsPart *self,
+                       gchar *value)
+{
+    clear_undecoded_text (self);
+    g_free (self->text);
+    self->text = value;
+}
+
+void
+mm_sms_part_take_undecoded_text (MMSmsPart *self,
+                                 GByteArray *undecoded,
+                                 guint n_elements,
+                                 guint bit_offset,
+                                 MMSmsPartTextDecodeFunc decode_func)
+{
+    g_assert (decode_func != NULL);
+
+    g_free (self->text);
+    self->text = NULL;
+    clear_undecoded_text (self);
+
+    self->undecoded_text = undecoded;
+    self->undecoded_text_elements = n_elements;
+    self->undecoded_text_bit_offset = bit_offset;
+    self->undecoded_text_func = decode_func;
+}
+
+gboolean
+mm_sms_part_has_text (MMSmsPart *self)
+{
+    return (self->text || self->undecoded_text);
+}
+
+/*****************************************************************************/
+/* In-place PDU conversion */
+
+guint8 *
+mm_sms_part_hexpdu_to_bin_in_place (gchar *hexpdu,
+                                    gsize *out_len)
+{
+    const gchar *ipos;
+    guint8 *opos;
+
+    /* Every output byte is written at or before the position of the two hex
+     * digits it comes from, so the conversion can be done over the input */
+    for (ipos = hexpdu, opos = (guint8 *) hexpdu; ipos[0]; ipos += 2) {
+        gint a;
+
+        if (!ipos[1])
+            return NULL;
+        a = mm_utils_hex2byte (ipos);
+        if (a < 0)
+            return NULL;
+        *opos++ = (guint8) a;
+    }
+
+    *out_len = opos - (guint8 *) hexpdu;
+    return (guint8 *) hexpdu;
+}
+
+/*****************************************************************************/
+
 PART_GET_FUNC (const GByteArray *, data)
 
 void
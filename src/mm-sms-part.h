@@ -81,6 +81,22 @@ void              mm_sms_part_set_text               (MMSmsPart *part,
 void              mm_sms_part_take_text              (MMSmsPart *part,
                                                       gchar *text);
 
+/* Most parts are stored or merged into a multipart message without anyone
+ * looking at their text, so PDU parsers may keep the raw user data and a
+ * decoder instead, and the charset conversion is done the first time
+ * mm_sms_part_get_text() is called. The decoder returns a newly allocated
+ * UTF-8 string, or NULL if the data cannot be converted. */
+typedef gchar * (* MMSmsPartTextDecodeFunc) (const guint8 *data,
+                                             gsize data_len,
+                                             guint n_elements,
+                                             guint bit_offset);
+void              mm_sms_part_take_undecoded_text    (MMSmsPart *part,
+                                                      GByteArray *undecoded,
+                                                      guint n_elements,
+                                                      guint bit_offset,
+                                                      MMSmsPartTextDecodeFunc decode_func);
+gboolean          mm_sms_part_has_text               (MMSmsPart *part);
+
 const GByteArray *mm_sms_part_get_data               (MMSmsPart *part);
 void              mm_sms_part_set_data               (MMSmsPart *part,
                                                       GByteArray *data);
@@ -132,4 +148,11 @@ MMSmsCdmaServiceCategory mm_sms_part_get_cdma_service_category (MMSmsPart *part)
 void                     mm_sms_part_set_cdma_service_category (MMSmsPart *part,
                                                                 MMSmsCdmaServiceCategory cdma_service_category);
 
+/* Converts a hex PDU to binary over the same buffer, so that PDUs already
+ * owned by the caller don't need an additional allocation. Returns @hexpdu
+ * itself on success or NULL if it isn't a valid hex string; either way the
+ * original contents of @hexpdu are lost. */
+guint8 *mm_sms_part_hexpdu_to_bin_in_place (gchar *hexpdu,
+                                            gsize *out_len);
+
 #endif /* MM_SMS_PART_H */
@@ -0,0 +1,388 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-trace.h"
+#include "mm-modem-helpers.h"
+
+/*****************************************************************************/
+
+typedef struct {
+    const gchar    *owner;
+    const gchar    *category;
+    const gchar    *name;
+    gint64          start;
+    gint64          end;
+    MMTraceOutcome  outcome;
+    gchar          *message;
+} TraceRecord;
+
+/* Allocated on first use */
+static TraceRecord *ring;
+static guint        ring_next;
+static guint        ring_len;
+
+static void
+record (const MMTraceSpan *span,
+        MMTraceOutcome     outcome,
+        const gchar       *message)
+{
+    TraceRecord *rec;
+
+    if (G_UNLIKELY (!ring))
+        ring = g_new0 (TraceRecord, MM_TRACE_RING_SIZE);
+
+    rec = &ring[ring_next];
+    g_free (rec->message);
+
+    rec->owner    = span->owner;
+    rec->category = span->category;
+    rec->name     = span->name;
+    rec->start    = span->start;
+    rec->end      = g_get_monotonic_time ();
+    rec->outcome  = outcome;
+    rec->message  = g_strdup (message);
+
+    ring_next = (ring_next + 1) % MM_TRACE_RING_SIZE;
+    if (ring_len < MM_TRACE_RING_SIZE)
+        ring_len++;
+}
+
+void
+mm_trace_clear (void)
+{
+    guint i;
+
+    if (!ring)
+        return;
+
+    for (i = 0; i < MM_TRACE_RING_SIZE; i++)
+        g_free (ring[i].message);
+    g_clear_pointer (&ring, g_free);
+    ring_next = 0;
+    ring_len = 0;
+}
+
+/*****************************************************************************/
+
+void
+mm_trace_span_begin (MMTraceSpan *span,
+                     const gchar *owner,
+                     const gchar *category,
+                     const gchar *name)
+{
+    g_assert (category && name);
+
+    span->owner    = owner ? g_intern_string (owner) : "unknown";
+    span->category = category;
+    span->name     = name;
+    span->start    = g_get_monotonic_time ();
+}
+
+void
+mm_trace_span_end (MMTraceSpan  *span,
+                   const GError *error)
+{
+    if (!span->name)
+        return;
+
+    if (error)
+        record (span, MM_TRACE_OUTCOME_FAILURE, error->message);
+    else
+        record (span, MM_TRACE_OUTCOME_SUCCESS, NULL);
+    span->name = NULL;
+}
+
+void
+mm_trace_span_abort (MMTraceSpan *span)
+{
+    if (!span->name)
+        return;
+
+    record (span, MM_TRACE_OUTCOME_ABORTED, NULL);
+    span->name = NULL;
+}
+
+/*****************************************************************************/
+
+void
+mm_trace_sequence_init (MMTraceSequence *seq,
+                        const gchar     *owner,
+                        const gchar     *category)
+{
+    memset (seq, 0, sizeof (MMTraceSequence));
+    mm_trace_span_begin (&seq->total, owner, category, category);
+}
+
+void
+mm_trace_sequence_step (MMTraceSequence *seq,
+                        const gchar     *step)
+{
+    if (!seq->total.name)
+        return;
+
+    mm_trace_span_end (&seq->step, NULL);
+    mm_trace_span_begin (&seq->step, seq->total.owner, seq->total.category, step);
+}
+
+void
+mm_trace_sequence_complete (MMTraceSequence *seq,
+                            const GError    *error)
+{
+    mm_trace_span_end (&seq->step, error);
+    mm_trace_span_end (&seq->total, error);
+}
+
+void
+mm_trace_sequence_clear (MMTraceSequence *seq)
+{
+    mm_trace_span_abort (&seq->step);
+    mm_trace_span_abort (&seq->total);
+}
+
+/*****************************************************************************/
+
+static const gchar *outcome_str[] = {
+    [MM_TRACE_OUTCOME_SUCCESS] = "success",
+    [MM_TRACE_OUTCOME_FAILURE] = "failure",
+    [MM_TRACE_OUTCOME_ABORTED] = "aborted",
+};
+
+gboolean
+mm_trace_format_from_string (const gchar    *str,
+                             MMTraceFormat  *format,
+                             GError        **error)
+{
+    if (!str || !str[0] || g_ascii_strcasecmp (str, "text") == 0) {
+        *format = MM_TRACE_FORMAT_TEXT;
+        return TRUE;
+    }
+    if (g_ascii_strcasecmp (str, "chrome") == 0) {
+        *format = MM_TRACE_FORMAT_CHROME;
+        return TRUE;
+    }
+
+    g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                 "Unknown trace format: '%s'", str);
+    return FALSE;
+}
+
+static gint
+record_cmp_start (const TraceRecord **a,
+                  const TraceRecord **b)
+{
+    if ((*a)->start != (*b)->start)
+        return (*a)->start < (*b)->start ? -1 : 1;
+    /* Enclosing spans first */
+    if ((*a)->end != (*b)->end)
+        return (*a)->end > (*b)->end ? -1 : 1;
+    return 0;
+}
+
+/* Records sorted by start time */
+static GPtrArray *
+build_sorted_records (void)
+{
+    GPtrArray *array;
+    guint      i;
+
+    array = g_ptr_array_sized_new (ring_len);
+    for (i = 0; i < ring_len; i++)
+        g_ptr_array_add (array, &ring[i]);
+    g_ptr_array_sort (array, (GCompareFunc) record_cmp_start);
+    return array;
+}
+
+static void
+build_text (GString   *str,
+            GPtrArray *records)
+{
+    gint64 origin;
+    guint  i;
+
+    if (!records->len) {
+        g_string_append (str, "no trace records\n");
+        return;
+    }
+
+    origin = ((TraceRecord *) g_ptr_array_index (records, 0))->start;
+    for (i = 0; i < records->len; i++) {
+        const TraceRecord *rec = g_ptr_array_index (records, i);
+
+        g_string_append_printf (str, "[+%10.3lfs] %8.3lfs %-7s %s %s/%s",
+                                (gdouble) (rec->start - origin) / G_USEC_PER_SEC,
+                                (gdouble) (rec->end - rec->start) / G_USEC_PER_SEC,
+                                outcome_str[rec->outcome],
+                                rec->owner,
+                                rec->category,
+                                rec->name);
+        if (rec->message)
+            g_string_append_printf (str, ": %s", rec->message);
+        g_string_append_c (str, '\n');
+    }
+}
+
+/* Each owner is reported as a process, and each category of each owner as
+ * one or more threads. Events in the same thread must not partially overlap,
+ * so concurrent spans (e.g. interfaces initialized in parallel) are spread
+ * over several lanes. */
+
+#define MAX_LANES 16
+
+typedef struct {
+    guint   tid;
+    gint64  lane_end[MAX_LANES][8];
+    guint   lane_depth[MAX_LANES];
+} ThreadInfo;
+
+static guint
+assign_lane (ThreadInfo        *info,
+             const TraceRecord *rec)
+{
+    guint lane;
+
+    for (lane = 0; lane < MAX_LANES; lane++) {
+        /* Drop finished spans from the stack */
+        while (info->lane_depth[lane] > 0 &&
+               info->lane_end[lane][info->lane_depth[lane] - 1] <= rec->start)
+            info->lane_depth[lane]--;
+
+        /* Free lane, or fully enclosed by the innermost span */
+        if (info->lane_depth[lane] == 0 ||
+            (info->lane_end[lane][info->lane_depth[lane] - 1] >= rec->end &&
+             info->lane_depth[lane] < G_N_ELEMENTS (info->lane_end[lane])))
+            break;
+    }
+
+    /* Too many concurrent spans, just let them overlap */
+    if (lane == MAX_LANES)
+        return MAX_LANES - 1;
+
+    info->lane_end[lane][info->lane_depth[lane]++] = rec->end;
+    return lane;
+}
+
+static void
+build_chrome (GString   *str,
+              GPtrArray *records)
+{
+    GHashTable *owners;
+    GHashTable *threads;
+    GHashTable *named;
+    GString    *metadata;
+    guint       n_threads = 0;
+    guint       i;
+
+    owners = g_hash_table_new (g_direct_hash, g_direct_equal);
+    threads = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    named = g_hash_table_new (g_direct_hash, g_direct_equal);
+    metadata = g_string_new ("");
+
+    g_string_append (str, "{\"traceEvents\":[");
+    for (i = 0; i < records->len; i++) {
+        const TraceRecord *rec = g_ptr_array_index (records, i);
+        ThreadInfo        *info;
+        gchar             *key;
+        guint              pid;
+        guint              lane;
+
+        pid = GPOINTER_TO_UINT (g_hash_table_lookup (owners, rec->owner));
+        if (!pid) {
+            pid = g_hash_table_size (owners) + 1;
+            g_hash_table_insert (owners, (gpointer) rec->owner, GUINT_TO_POINTER (pid));
+            g_string_append_printf (metadata,
+                                    ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":",
+                                    pid);
+            mm_str_append_escaped (metadata, rec->owner);
+            g_string_append (metadata, "}}");
+        }
+
+        key = g_strdup_printf ("%u/%s", pid, rec->category);
+        info = g_hash_table_lookup (threads, key);
+        if (!info) {
+            info = g_new0 (ThreadInfo, 1);
+            info->tid = ++n_threads * MAX_LANES;
+            g_hash_table_insert (threads, key, info);
+        } else
+            g_free (key);
+
+        lane = assign_lane (info, rec);
+        if (!g_hash_table_contains (named, GUINT_TO_POINTER (info->tid + lane))) {
+            g_hash_table_add (named, GUINT_TO_POINTER (info->tid + lane));
+            g_string_append_printf (metadata,
+                                    ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":",
+                                    pid, info->tid + lane);
+            mm_str_append_escaped (metadata, rec->category);
+            g_string_append (metadata, "}}");
+        }
+
+        g_string_append (str, i ? ",\n{" : "\n{");
+        g_string_append (str, "\"name\":");
+        mm_str_append_escaped (str, rec->name);
+        g_string_append (str, ",\"cat\":");
+        mm_str_append_escaped (str, rec->category);
+        g_string_append_printf (str,
+                                ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT
+                                ",\"pid\":%u,\"tid\":%u,\"args\":{\"outcome\":\"%s\"",
+                                rec->start,
+                                rec->end - rec->start,
+                                pid,
+                                info->tid + lane,
+                                outcome_str[rec->outcome]);
+        if (rec->message) {
+            g_string_append (str, ",\"error\":");
+            mm_str_append_escaped (str, rec->message);
+        }
+        g_string_append (str, "}}");
+    }
+
+    g_string_append (str, metadata->str);
+    g_string_append (str, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    g_string_free (metadata, TRUE);
+    g_hash_table_unref (named);
+    g_hash_table_unref (threads);
+    g_hash_table_unref (owners);
+}
+
+gchar *
+mm_trace_build (MMTraceFormat format)
+{
+    GString   *str;
+    GPtrArray *records;
+
+    str = g_string_new ("");
+    records = build_sorted_records ();
+
+    switch (format) {
+    case MM_TRACE_FORMAT_TEXT:
+        build_text (str, records);
+        break;
+    case MM_TRACE_FORMAT_CHROME:
+        build_chrome (str, records);
+        break;
+    default:
+        g_assert_not_reached ();
+    }
+
+    g_ptr_array_unref (records);
+    return g_string_free (str, FALSE);
+}
@@ -0,0 +1,85 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_TRACE_H
+#define MM_TRACE_H
+
+#include <glib.h>
+
+/*****************************************************************************/
+/* Timing of the steps run by the modem and bearer state machines.
+ *
+ * Only finished spans are recorded, in a bounded in-memory ring where the
+ * oldest entries get overwritten. Recording a span doesn't allocate memory,
+ * except for the error message of failed ones. Categories and step names must
+ * be static strings; owners (e.g. the modem device or the bearer path) are
+ * interned. */
+
+#define MM_TRACE_RING_SIZE 1024
+
+typedef enum {
+    MM_TRACE_OUTCOME_SUCCESS,
+    MM_TRACE_OUTCOME_FAILURE,
+    MM_TRACE_OUTCOME_ABORTED,
+} MMTraceOutcome;
+
+typedef enum {
+    MM_TRACE_FORMAT_TEXT,
+    MM_TRACE_FORMAT_CHROME,
+} MMTraceFormat;
+
+/* A single span, which may overlap with others. A span with a NULL name is
+ * not running, and ending it is a no-op. */
+typedef struct {
+    const gchar *owner;
+    const gchar *category;
+    const gchar *name;
+    gint64       start;
+} MMTraceSpan;
+
+void mm_trace_span_begin (MMTraceSpan  *span,
+                          const gchar  *owner,
+                          const gchar  *category,
+                          const gchar  *name);
+void mm_trace_span_end   (MMTraceSpan  *span,
+                          const GError *error);
+void mm_trace_span_abort (MMTraceSpan  *span);
+
+/* Steps of a sequential state machine; starting a step ends the previous
+ * one successfully. The whole sequence is recorded as an additional span
+ * named after the category. */
+typedef struct {
+    MMTraceSpan total;
+    MMTraceSpan step;
+} MMTraceSequence;
+
+void mm_trace_sequence_init     (MMTraceSequence *seq,
+                                 const gchar     *owner,
+                                 const gchar     *category);
+void mm_trace_sequence_step     (MMTraceSequence *seq,
+                                 const gchar     *step);
+void mm_trace_sequence_complete (MMTraceSequence *seq,
+                                 const GError    *error);
+/* Records the sequence as aborted unless already completed */
+void mm_trace_sequence_clear    (MMTraceSequence *seq);
+
+gboolean mm_trace_format_from_string (const gchar    *str,
+                                      MMTraceFormat  *format,
+                                      GError        **error);
+
+gchar *mm_trace_build (MMTraceFormat format);
+void   mm_trace_clear (void);
+
+#endif /* MM_TRACE_H */
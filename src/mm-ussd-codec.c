@@ -0,0 +1,501 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-ussd-codec.h"
+#include "mm-charsets.h"
+
+#define GSM_ESCAPE_CHAR 0x1b
+#define GSM_CR          0x0d
+
+/*****************************************************************************/
+
+MMUssdEncoding
+mm_ussd_encoding_from_dcs (guint dcs)
+{
+    switch (dcs & 0xF0) {
+    case 0x10:
+        /* Language given in the first chars of the message */
+        return (dcs == 0x11) ? MM_USSD_ENCODING_UCS2 : MM_USSD_ENCODING_GSM7;
+    case 0x40:
+    case 0x50:
+    case 0x60:
+    case 0x70:
+    case 0x90:
+        /* General data coding, compressed text not supported */
+        if (dcs & 0x20)
+            return MM_USSD_ENCODING_UNKNOWN;
+        switch ((dcs >> 2) & 0x03) {
+        case 0x01:
+            return MM_USSD_ENCODING_8BIT;
+        case 0x02:
+            return MM_USSD_ENCODING_UCS2;
+        default:
+            return MM_USSD_ENCODING_GSM7;
+        }
+    case 0xE0:
+        /* WAP Forum defined */
+        return MM_USSD_ENCODING_UNKNOWN;
+    case 0xF0:
+        return (dcs & 0x04) ? MM_USSD_ENCODING_8BIT : MM_USSD_ENCODING_GSM7;
+    default:
+        /* Language groups and reserved values all use the GSM alphabet */
+        return MM_USSD_ENCODING_GSM7;
+    }
+}
+
+guint
+mm_ussd_encoding_to_dcs (MMUssdEncoding encoding)
+{
+    switch (encoding) {
+    case MM_USSD_ENCODING_8BIT:
+        return 0x44;
+    case MM_USSD_ENCODING_UCS2:
+        return 0x48;
+    case MM_USSD_ENCODING_GSM7:
+    case MM_USSD_ENCODING_GSM7_UNPACKED:
+    case MM_USSD_ENCODING_UNKNOWN:
+    default:
+        return 0x0F;
+    }
+}
+
+MMUssdEncoding
+mm_ussd_encoding_for_utf8 (const gchar *utf8)
+{
+    const gchar *p;
+
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        guint8   gsm;
+        gboolean extended;
+
+        if (!mm_charset_gsm_char_from_utf8 (g_utf8_get_char (p), &gsm, &extended))
+            return MM_USSD_ENCODING_UCS2;
+    }
+    return MM_USSD_ENCODING_GSM7;
+}
+
+/*****************************************************************************/
+/* Decoding */
+
+typedef struct {
+    const guint8 *data;
+    gboolean      hex;
+    /* In bytes, i.e. half the number of hex digits */
+    gsize         len;
+} Input;
+
+static inline guint8
+input_get (const Input *input,
+           gsize        i)
+{
+    if (!input->hex)
+        return input->data[i];
+    /* Hex digits already validated */
+    return (g_ascii_xdigit_value (input->data[2 * i]) << 4) | g_ascii_xdigit_value (input->data[2 * i + 1]);
+}
+
+typedef struct {
+    GString  *out;
+    gboolean  escaped;
+} GsmDecoder;
+
+static void
+gsm_decoder_feed (GsmDecoder *decoder,
+                  guint8      septet)
+{
+    const gchar *utf8;
+    guint        len;
+
+    if (decoder->escaped) {
+        decoder->escaped = FALSE;
+        utf8 = mm_charset_gsm_char_to_utf8 (septet, TRUE, &len);
+        if (utf8) {
+            g_string_append_len (decoder->out, utf8, len);
+            return;
+        }
+        /* Unknown extended char, keep it as a default one */
+        g_string_append_c (decoder->out, '?');
+    } else if (septet == GSM_ESCAPE_CHAR) {
+        decoder->escaped = TRUE;
+        return;
+    }
+
+    utf8 = mm_charset_gsm_char_to_utf8 (septet, FALSE, &len);
+    if (utf8)
+        g_string_append_len (decoder->out, utf8, len);
+    else
+        g_string_append_c (decoder->out, '?');
+}
+
+static void
+gsm_decoder_finish (GsmDecoder *decoder)
+{
+    /* Dangling escape char */
+    if (decoder->escaped)
+        g_string_append_c (decoder->out, '?');
+}
+
+static void
+decode_gsm7 (const Input *input,
+             GString     *out)
+{
+    GsmDecoder decoder = { out, FALSE };
+    gsize      n_septets;
+    gsize      n_fed = 0;
+    guint32    bits = 0;
+    guint      n_bits = 0;
+    gsize      i;
+
+    n_septets = (input->len * 8) / 7;
+
+    /* If the last septet fills a 7-byte block and it's the <CR> padding
+     * character, drop it (3GPP TS 23.038, section 6.1.2.3.1) */
+    if (n_septets && input->len % 7 == 0 && (input_get (input, input->len - 1) >> 1) == GSM_CR)
+        n_septets--;
+
+    for (i = 0; i < input->len && n_fed < n_septets; i++) {
+        bits |= ((guint32) input_get (input, i)) << n_bits;
+        n_bits += 8;
+        while (n_bits >= 7 && n_fed < n_septets) {
+            gsm_decoder_feed (&decoder, bits & 0x7F);
+            bits >>= 7;
+            n_bits -= 7;
+            n_fed++;
+        }
+    }
+    gsm_decoder_finish (&decoder);
+}
+
+static void
+decode_gsm7_unpacked (const Input *input,
+                      GString     *out)
+{
+    GsmDecoder decoder = { out, FALSE };
+    gsize      i;
+
+    for (i = 0; i < input->len; i++)
+        gsm_decoder_feed (&decoder, input_get (input, i));
+    gsm_decoder_finish (&decoder);
+}
+
+static void
+decode_8bit (const Input *input,
+             GString     *out)
+{
+    gsize i;
+
+    for (i = 0; i < input->len; i++)
+        g_string_append_unichar (out, input_get (input, i));
+}
+
+static gboolean
+decode_ucs2 (const Input  *input,
+             GString      *out,
+             GError      **error)
+{
+    gunichar high = 0;
+    gsize    i;
+
+    if (input->len % 2) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                     "Cannot decode UCS2 USSD string: odd number of bytes (%" G_GSIZE_FORMAT ")",
+                     input->len);
+        return FALSE;
+    }
+
+    for (i = 0; i < input->len; i += 2) {
+        gunichar c;
+
+        c = (input_get (input, i) << 8) | input_get (input, i + 1);
+
+        /* Surrogate pairs are also accepted, given that most modems really
+         * use UTF-16 */
+        if (c >= 0xD800 && c <= 0xDBFF) {
+            if (high)
+                g_string_append_c (out, '?');
+            high = c;
+            continue;
+        }
+        if (c >= 0xDC00 && c <= 0xDFFF) {
+            if (!high) {
+                g_string_append_c (out, '?');
+                continue;
+            }
+            c = 0x10000 + ((high - 0xD800) << 10) + (c - 0xDC00);
+            high = 0;
+        } else if (high) {
+            g_string_append_c (out, '?');
+            high = 0;
+        }
+        g_string_append_unichar (out, c);
+    }
+
+    if (high)
+        g_string_append_c (out, '?');
+    return TRUE;
+}
+
+static gboolean
+decode (MMUssdEncoding   encoding,
+        const Input     *input,
+        GString         *out,
+        GError         **error)
+{
+    switch (encoding) {
+    case MM_USSD_ENCODING_GSM7:
+        decode_gsm7 (input, out);
+        return TRUE;
+    case MM_USSD_ENCODING_GSM7_UNPACKED:
+        decode_gsm7_unpacked (input, out);
+        return TRUE;
+    case MM_USSD_ENCODING_8BIT:
+        decode_8bit (input, out);
+        return TRUE;
+    case MM_USSD_ENCODING_UCS2:
+        return decode_ucs2 (input, out, error);
+    case MM_USSD_ENCODING_UNKNOWN:
+    default:
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                     "Cannot decode USSD string: unknown encoding");
+        return FALSE;
+    }
+}
+
+gboolean
+mm_ussd_decode (MMUssdEncoding   encoding,
+                const guint8    *data,
+                gsize            len,
+                GString         *out,
+                GError         **error)
+{
+    Input input;
+
+    input.data = data;
+    input.hex  = FALSE;
+    input.len  = len;
+    return decode (encoding, &input, out, error);
+}
+
+gboolean
+mm_ussd_decode_hex (MMUssdEncoding   encoding,
+                    const gchar     *hex,
+                    gsize            hex_len,
+                    GString         *out,
+                    GError         **error)
+{
+    Input input;
+    gsize i;
+
+    if (hex_len % 2) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                     "Cannot decode USSD string: odd number of hex digits (%" G_GSIZE_FORMAT ")",
+                     hex_len);
+        return FALSE;
+    }
+
+    for (i = 0; i < hex_len; i++) {
+        if (!g_ascii_isxdigit (hex[i])) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                         "Cannot decode USSD string: invalid hex digit at position %" G_GSIZE_FORMAT,
+                         i);
+            return FALSE;
+        }
+    }
+
+    input.data = (const guint8 *) hex;
+    input.hex  = TRUE;
+    input.len  = hex_len / 2;
+    return decode (encoding, &input, out, error);
+}
+
+/*****************************************************************************/
+/* Encoding */
+
+typedef struct {
+    GByteArray *bytes;
+    GString    *hex;
+} Output;
+
+static inline void
+output_append (Output *output,
+               guint8  byte)
+{
+    static const gchar digits[] = "0123456789ABCDEF";
+
+    if (output->bytes)
+        g_byte_array_append (output->bytes, &byte, 1);
+    else {
+        g_string_append_c (output->hex, digits[byte >> 4]);
+        g_string_append_c (output->hex, digits[byte & 0x0F]);
+    }
+}
+
+static void
+encode_gsm7 (const gchar *utf8,
+             gboolean     packed,
+             Output      *output)
+{
+    const gchar *p;
+    guint32      bits = 0;
+    guint        n_bits = 0;
+    gsize        n_septets = 0;
+
+#define APPEND_SEPTET(septet) do {                    \
+        if (!packed)                                  \
+            output_append (output, (septet));         \
+        else {                                        \
+            bits |= ((guint32) (septet)) << n_bits;   \
+            n_bits += 7;                              \
+            if (n_bits >= 8) {                        \
+                output_append (output, bits & 0xFF);  \
+                bits >>= 8;                           \
+                n_bits -= 8;                          \
+            }                                         \
+        }                                             \
+        n_septets++;                                  \
+    } while (0)
+
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        guint8   gsm;
+        gboolean extended;
+
+        if (!mm_charset_gsm_char_from_utf8 (g_utf8_get_char (p), &gsm, &extended)) {
+            gsm = '?';
+            extended = FALSE;
+        }
+        if (extended)
+            APPEND_SEPTET (GSM_ESCAPE_CHAR);
+        APPEND_SEPTET (gsm);
+    }
+
+    if (packed) {
+        /* 7 spare bits at the end would be read as '@', so use <CR> as
+         * padding instead (3GPP TS 23.038, section 6.1.2.3.1) */
+        if (n_septets % 8 == 7)
+            APPEND_SEPTET (GSM_CR);
+        if (n_bits)
+            output_append (output, bits & 0xFF);
+    }
+
+#undef APPEND_SEPTET
+}
+
+static gboolean
+encode_8bit (const gchar  *utf8,
+             Output       *output,
+             GError      **error)
+{
+    const gchar *p;
+
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        gunichar c;
+
+        c = g_utf8_get_char (p);
+        if (c > 0xFF) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                         "Cannot encode USSD string: character U+%04X doesn't fit in 8-bit data",
+                         c);
+            return FALSE;
+        }
+        output_append (output, c);
+    }
+    return TRUE;
+}
+
+static void
+encode_ucs2 (const gchar *utf8,
+             Output      *output)
+{
+    const gchar *p;
+
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        gunichar c;
+
+        c = g_utf8_get_char (p);
+        if (c > 0xFFFF) {
+            gunichar high;
+            gunichar low;
+
+            high = 0xD800 + ((c - 0x10000) >> 10);
+            low  = 0xDC00 + ((c - 0x10000) & 0x3FF);
+            output_append (output, high >> 8);
+            output_append (output, high & 0xFF);
+            c = low;
+        }
+        output_append (output, c >> 8);
+        output_append (output, c & 0xFF);
+    }
+}
+
+static gboolean
+encode (MMUssdEncoding   encoding,
+        const gchar     *utf8,
+        Output          *output,
+        GError         **error)
+{
+    if (!g_utf8_validate (utf8, -1, NULL)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                     "Cannot encode USSD string: invalid UTF-8");
+        return FALSE;
+    }
+
+    switch (encoding) {
+    case MM_USSD_ENCODING_GSM7:
+        encode_gsm7 (utf8, TRUE, output);
+        return TRUE;
+    case MM_USSD_ENCODING_GSM7_UNPACKED:
+        encode_gsm7 (utf8, FALSE, output);
+        return TRUE;
+    case MM_USSD_ENCODING_8BIT:
+        return encode_8bit (utf8, output, error);
+    case MM_USSD_ENCODING_UCS2:
+        encode_ucs2 (utf8, output);
+        return TRUE;
+    case MM_USSD_ENCODING_UNKNOWN:
+    default:
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                     "Cannot encode USSD string: unknown encoding");
+        return FALSE;
+    }
+}
+
+gboolean
+mm_ussd_encode (MMUssdEncoding   encoding,
+                const gchar     *utf8,
+                GByteArray      *out,
+                GError         **error)
+{
+    Output output = { out, NULL };
+
+    return encode (encoding, utf8, &output, error);
+}
+
+gboolean
+mm_ussd_encode_hex (MMUssdEncoding   encoding,
+                    const gchar     *utf8,
+                    GString         *out,
+                    GError         **error)
+{
+    Output output = { NULL, out };
+
+    return encode (encoding, utf8, &output, error);
+}
@@ -0,0 +1,73 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#ifndef MM_USSD_CODEC_H
+#define MM_USSD_CODEC_H
+
+#include <glib.h>
+
+/*****************************************************************************/
+/* USSD string encoding and decoding.
+ *
+ * USSD strings are converted straight between UTF-8 and the encoded data,
+ * either as raw bytes or in their hex representation as given in +CUSD,
+ * without going through intermediate buffers. Output is appended to the given
+ * GString or GByteArray, so that callers processing many messages may reuse
+ * them. */
+
+typedef enum {
+    MM_USSD_ENCODING_UNKNOWN,
+    /* GSM 03.38 default alphabet, packed septets */
+    MM_USSD_ENCODING_GSM7,
+    /* GSM 03.38 default alphabet, one septet per byte, as given by modems
+     * using the GSM charset (AT+CSCS) */
+    MM_USSD_ENCODING_GSM7_UNPACKED,
+    /* 8-bit data, decoded as ISO-8859-1 */
+    MM_USSD_ENCODING_8BIT,
+    /* UCS2 (UTF-16 big endian) */
+    MM_USSD_ENCODING_UCS2,
+} MMUssdEncoding;
+
+/* Encoding given by a 3GPP TS 23.038 CBS data coding scheme. Compressed data
+ * is reported as UNKNOWN. */
+MMUssdEncoding mm_ussd_encoding_from_dcs (guint          dcs);
+/* Data coding scheme to report along with data in the given encoding */
+guint          mm_ussd_encoding_to_dcs   (MMUssdEncoding encoding);
+
+/* GSM7 if the whole string fits in the GSM default alphabet, UCS2 otherwise */
+MMUssdEncoding mm_ussd_encoding_for_utf8 (const gchar   *utf8);
+
+gboolean mm_ussd_decode     (MMUssdEncoding   encoding,
+                             const guint8    *data,
+                             gsize            len,
+                             GString         *out,
+                             GError         **error);
+gboolean mm_ussd_decode_hex (MMUssdEncoding   encoding,
+                             const gchar     *hex,
+                             gsize            hex_len,
+                             GString         *out,
+                             GError         **error);
+
+/* Chars not found in the GSM default alphabet are encoded as '?' */
+gboolean mm_ussd_encode     (MMUssdEncoding   encoding,
+                             const gchar     *utf8,
+                             GByteArray      *out,
+                             GError         **error);
+gboolean mm_ussd_encode_hex (MMUssdEncoding   encoding,
+                             const gchar     *utf8,
+                             GString         *out,
+                             GError         **error);
+
+#endif /* MM_USSD_CODEC_H */
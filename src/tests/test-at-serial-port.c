@@ -15,9 +15,14 @@
 
 #include <config.h>
 #include <string.h>
+#include <pty.h>
+#include <unistd.h>
+#include <termios.h>
+#include <fcntl.h>
 #include <glib.h>
 
 #include "mm-port-serial-at.h"
+#include "mm-serial-parsers.h"
 #include "mm-log.h"
 
 typedef struct {
@@ -64,6 +69,140 @@ at_serial_echo_removal (void)
     }
 }
 
+/*****************************************************************************/
+
+typedef struct {
+    const gchar                 *command;
+    MMPortSerialCommandPriority  priority;
+    /* Position in which the command is expected to be sent */
+    guint                        expected;
+} QueueOrderTest;
+
+/* Control commands first, then interactive, then background; FIFO order among
+ * the ones with the same priority */
+static const QueueOrderTest queue_order_tests[] = {
+    { "+BG1",   MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,  4 },
+    { "+INT1",  MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, 2 },
+    { "+BG2",   MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,  5 },
+    { "+CTRL1", MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL,     0 },
+    { "+INT2",  MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE, 3 },
+    { "+CTRL2", MM_PORT_SERIAL_COMMAND_PRIORITY_CONTROL,     1 },
+};
+
+typedef struct {
+    int        master;
+    GMainLoop *loop;
+    guint      n_completed;
+} QueueOrderContext;
+
+/* Every command gets the same successful response */
+static gboolean
+queue_order_master_read_cb (GIOChannel        *channel,
+                            GIOCondition       condition,
+                            QueueOrderContext *ctx)
+{
+    static const gchar response[] = "\r\nOK\r\n";
+    gchar   buf[256];
+    ssize_t n;
+    ssize_t i;
+
+    while ((n = read (ctx->master, buf, sizeof (buf))) > 0) {
+        for (i = 0; i < n; i++) {
+            if (buf[i] == '\r')
+                g_assert_cmpint (write (ctx->master, response, strlen (response)), ==, strlen (response));
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+queue_order_command_ready (MMPortSerialAt *port,
+                           GAsyncResult   *res,
+                           gpointer        user_data)
+{
+    const QueueOrderTest *test = user_data;
+    QueueOrderContext    *ctx;
+    GError               *error = NULL;
+
+    mm_port_serial_at_command_finish (port, res, &error);
+    g_assert_no_error (error);
+
+    /* Commands are sent one by one, so they complete in the same order */
+    ctx = g_object_get_data (G_OBJECT (port), "queue-order-context");
+    g_assert_cmpuint (test->expected, ==, ctx->n_completed);
+    if (++ctx->n_completed == G_N_ELEMENTS (queue_order_tests))
+        g_main_loop_quit (ctx->loop);
+}
+
+static void
+at_serial_queue_order (void)
+{
+    QueueOrderContext  ctx;
+    MMPortSerialAt    *port;
+    struct termios     stbuf;
+    GIOChannel        *channel;
+    guint              master_id;
+    int                slave;
+    guint              i;
+    GError            *error = NULL;
+
+    memset (&ctx, 0, sizeof (ctx));
+    g_assert_cmpint (openpty (&ctx.master, &slave, NULL, NULL, NULL), ==, 0);
+    memset (&stbuf, 0, sizeof (stbuf));
+    tcgetattr (slave, &stbuf);
+    cfmakeraw (&stbuf);
+    tcsetattr (slave, TCSANOW, &stbuf);
+    fcntl (slave, F_SETFL, O_NONBLOCK);
+    fcntl (ctx.master, F_SETFL, O_NONBLOCK);
+
+    channel = g_io_channel_unix_new (ctx.master);
+    master_id = g_io_add_watch (channel, G_IO_IN, (GIOFunc) queue_order_master_read_cb, &ctx);
+    g_io_channel_unref (channel);
+
+    port = MM_PORT_SERIAL_AT (g_object_new (MM_TYPE_PORT_SERIAL_AT,
+                                            MM_PORT_DEVICE, "pty",
+                                            MM_PORT_SUBSYS, MM_PORT_SUBSYS_TTY,
+                                            MM_PORT_TYPE, MM_PORT_TYPE_AT,
+                                            MM_PORT_SERIAL_FD, slave,
+                                            MM_PORT_SERIAL_SEND_DELAY, (guint64) 0,
+                                            MM_PORT_SERIAL_AT_INIT_SEQUENCE_ENABLED, FALSE,
+                                            NULL));
+    mm_port_serial_at_set_response_parser (port,
+                                           mm_serial_parser_v1_parse,
+                                           mm_serial_parser_v1_new (),
+                                           mm_serial_parser_v1_destroy);
+    g_assert (mm_port_serial_open (MM_PORT_SERIAL (port), &error));
+    g_assert_no_error (error);
+
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    g_object_set_data (G_OBJECT (port), "queue-order-context", &ctx);
+
+    /* The queue is only processed once back in the main loop, so all commands
+     * are queued before the first one is sent */
+    for (i = 0; i < G_N_ELEMENTS (queue_order_tests); i++)
+        mm_port_serial_at_command (port,
+                                   queue_order_tests[i].command,
+                                   3,
+                                   FALSE,
+                                   FALSE,
+                                   queue_order_tests[i].priority,
+                                   NULL,
+                                   (GAsyncReadyCallback) queue_order_command_ready,
+                                   (gpointer) &queue_order_tests[i]);
+    g_main_loop_run (ctx.loop);
+    g_assert_cmpuint (ctx.n_completed, ==, G_N_ELEMENTS (queue_order_tests));
+
+    g_main_loop_unref (ctx.loop);
+    /* Closing the port also closes the slave fd */
+    mm_port_serial_close (MM_PORT_SERIAL (port));
+    g_object_unref (port);
+    g_source_remove (master_id);
+    close (ctx.master);
+}
+
+/*****************************************************************************/
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -89,6 +228,7 @@ int main (int argc, char **argv)
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/ModemManager/AT-serial/echo-removal", at_serial_echo_removal);
+    g_test_add_func ("/ModemManager/AT-serial/queue-order", at_serial_queue_order);
 
     return g_test_run ();
 }
@@ -0,0 +1,290 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <string.h>
+#include <pty.h>
+#include <unistd.h>
+#include <termios.h>
+#include <fcntl.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-base-modem.h"
+#include "mm-base-modem-at.h"
+#include "mm-serial-parsers.h"
+#include "mm-log.h"
+
+#define N_COMMANDS    20
+#define TEST_RESPONSE "+CIND: 5,3"
+
+/*****************************************************************************/
+/* Minimal modem, only used to run AT commands on a given port */
+
+typedef MMBaseModem      TestModem;
+typedef MMBaseModemClass TestModemClass;
+
+static GType test_modem_get_type (void);
+
+G_DEFINE_TYPE (TestModem, test_modem, MM_TYPE_BASE_MODEM)
+
+static void
+test_modem_init (TestModem *self)
+{
+}
+
+static void
+test_modem_class_init (TestModemClass *klass)
+{
+}
+
+/* The daemon authorization provider isn't needed to run commands */
+MMAuthProvider *
+mm_auth_get_provider (void)
+{
+    return mm_auth_provider_new ();
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    int             master;
+    int             slave;
+    guint           master_id;
+    MMBaseModem    *modem;
+    MMPortSerialAt *port;
+    GMainLoop      *loop;
+    guint           n_pending;
+} TestData;
+
+/* Every command gets the same successful response */
+static gboolean
+master_read_cb (GIOChannel   *channel,
+                GIOCondition  condition,
+                TestData     *d)
+{
+    static const gchar response[] = "\r\n" TEST_RESPONSE "\r\n\r\nOK\r\n";
+    gchar   buf[256];
+    ssize_t n;
+    ssize_t i;
+
+    while ((n = read (d->master, buf, sizeof (buf))) > 0) {
+        for (i = 0; i < n; i++) {
+            if (buf[i] == '\r')
+                g_assert_cmpint (write (d->master, response, strlen (response)), ==, strlen (response));
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+test_setup (TestData      *d,
+            gconstpointer  user_data)
+{
+    struct termios  stbuf;
+    GIOChannel     *channel;
+    GError         *error = NULL;
+
+    memset (d, 0, sizeof (*d));
+
+    g_assert_cmpint (openpty (&d->master, &d->slave, NULL, NULL, NULL), ==, 0);
+    memset (&stbuf, 0, sizeof (stbuf));
+    tcgetattr (d->slave, &stbuf);
+    cfmakeraw (&stbuf);
+    tcsetattr (d->slave, TCSANOW, &stbuf);
+    fcntl (d->slave, F_SETFL, O_NONBLOCK);
+    fcntl (d->master, F_SETFL, O_NONBLOCK);
+
+    channel = g_io_channel_unix_new (d->master);
+    d->master_id = g_io_add_watch (channel, G_IO_IN, (GIOFunc) master_read_cb, d);
+    g_io_channel_unref (channel);
+
+    d->port = MM_PORT_SERIAL_AT (g_object_new (MM_TYPE_PORT_SERIAL_AT,
+                                               MM_PORT_DEVICE, "pty",
+                                               MM_PORT_SUBSYS, MM_PORT_SUBSYS_TTY,
+                                               MM_PORT_TYPE, MM_PORT_TYPE_AT,
+                                               MM_PORT_SERIAL_FD, d->slave,
+                                               MM_PORT_SERIAL_SEND_DELAY, (guint64) 0,
+                                               MM_PORT_SERIAL_AT_INIT_SEQUENCE_ENABLED, FALSE,
+                                               NULL));
+    mm_port_serial_at_set_response_parser (d->port,
+                                           mm_serial_parser_v1_parse,
+                                           mm_serial_parser_v1_new (),
+                                           mm_serial_parser_v1_destroy);
+    /* Keep the port open in between commands */
+    g_assert (mm_port_serial_open (MM_PORT_SERIAL (d->port), &error));
+    g_assert_no_error (error);
+
+    d->modem = MM_BASE_MODEM (g_object_new (test_modem_get_type (),
+                                            MM_BASE_MODEM_DEVICE, "test",
+                                            NULL));
+    d->loop = g_main_loop_new (NULL, FALSE);
+}
+
+static void
+test_teardown (TestData      *d,
+               gconstpointer  user_data)
+{
+    g_main_loop_unref (d->loop);
+    g_object_unref (d->modem);
+    /* Closing the port also closes the slave fd */
+    mm_port_serial_close (MM_PORT_SERIAL (d->port));
+    g_object_unref (d->port);
+    g_source_remove (d->master_id);
+    close (d->master);
+}
+
+/*****************************************************************************/
+
+static void run_full_command (TestData *d);
+
+static void
+full_command_ready (MMBaseModem  *modem,
+                    GAsyncResult *res,
+                    TestData     *d)
+{
+    const gchar *response;
+    GError      *error = NULL;
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (response, ==, TEST_RESPONSE);
+
+    if (--d->n_pending)
+        run_full_command (d);
+    else
+        g_main_loop_quit (d->loop);
+}
+
+static void
+run_full_command (TestData *d)
+{
+    mm_base_modem_at_command_full (d->modem,
+                                   d->port,
+                                   "+CIND?",
+                                   3,
+                                   FALSE,
+                                   FALSE,
+                                   MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+                                   NULL,
+                                   (GAsyncReadyCallback) full_command_ready,
+                                   d);
+}
+
+static void run_borrowed_command (TestData *d);
+
+static void
+borrowed_command_ready (MMBaseModem  *modem,
+                        const gchar  *response,
+                        gsize         response_len,
+                        const GError *error,
+                        TestData     *d)
+{
+    g_assert_no_error (error);
+    g_assert_cmpstr (response, ==, TEST_RESPONSE);
+    g_assert_cmpuint (response_len, ==, strlen (TEST_RESPONSE));
+
+    if (--d->n_pending)
+        run_borrowed_command (d);
+    else
+        g_main_loop_quit (d->loop);
+}
+
+static void
+run_borrowed_command (TestData *d)
+{
+    mm_base_modem_at_command_borrowed_full (d->modem,
+                                            d->port,
+                                            "+CIND?",
+                                            3,
+                                            FALSE,
+                                            FALSE,
+                                            MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+                                            NULL,
+                                            (MMBaseModemAtResponseFunc) borrowed_command_ready,
+                                            d);
+}
+
+static void
+test_borrowed_stats (TestData      *d,
+                     gconstpointer  user_data)
+{
+    MMBaseModemAtStats before;
+    MMBaseModemAtStats after;
+
+    /* Commands with an async result: one result per command. The next command
+     * is run from the callback, before the context of the previous one is
+     * released, so two contexts alternate */
+    mm_base_modem_at_get_stats (&before);
+    d->n_pending = N_COMMANDS;
+    run_full_command (d);
+    g_main_loop_run (d->loop);
+    mm_base_modem_at_get_stats (&after);
+
+    g_assert_cmpuint (after.n_commands - before.n_commands, ==, N_COMMANDS);
+    g_assert_cmpuint (after.n_async_results - before.n_async_results, ==, N_COMMANDS);
+    g_assert_cmpuint (after.n_contexts_allocated - before.n_contexts_allocated, <=, 2);
+    g_assert_cmpuint (after.n_contexts_reused - before.n_contexts_reused, >=, N_COMMANDS - 2);
+
+    /* Commands with a borrowed response: no async result created by the
+     * modem at all, and no new context either */
+    mm_base_modem_at_get_stats (&before);
+    d->n_pending = N_COMMANDS;
+    run_borrowed_command (d);
+    g_main_loop_run (d->loop);
+    mm_base_modem_at_get_stats (&after);
+
+    g_assert_cmpuint (after.n_commands - before.n_commands, ==, N_COMMANDS);
+    g_assert_cmpuint (after.n_borrowed_commands - before.n_borrowed_commands, ==, N_COMMANDS);
+    g_assert_cmpuint (after.n_async_results - before.n_async_results, ==, 0);
+    g_assert_cmpuint (after.n_contexts_allocated - before.n_contexts_allocated, ==, 0);
+    g_assert_cmpuint (after.n_contexts_reused - before.n_contexts_reused, ==, N_COMMANDS);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add ("/MM/base-modem-at/borrowed-stats", TestData, NULL,
+                test_setup, test_borrowed_stats, test_teardown);
+
+    return g_test_run ();
+}
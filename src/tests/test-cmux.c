@@ -0,0 +1,258 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "mm-cmux.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+static void
+common_test_frame_append (guint8        dlci,
+                          guint8        type,
+                          gboolean      pf,
+                          gboolean      cr,
+                          const guint8 *data,
+                          gsize         len,
+                          const guint8 *expected,
+                          gsize         expected_len)
+{
+    GByteArray *buffer;
+
+    buffer = g_byte_array_new ();
+    mm_cmux_frame_append (buffer, dlci, type, pf, cr, data, len);
+    g_assert_cmpuint (buffer->len, ==, expected_len);
+    g_assert (memcmp (buffer->data, expected, expected_len) == 0);
+    g_byte_array_unref (buffer);
+}
+
+static void
+test_frame_append_sabm (void)
+{
+    static const guint8 expected_dlci0[] = { 0xF9, 0x03, 0x3F, 0x01, 0x1C, 0xF9 };
+    static const guint8 expected_dlci1[] = { 0xF9, 0x07, 0x3F, 0x01, 0xDE, 0xF9 };
+
+    common_test_frame_append (0, MM_CMUX_FRAME_TYPE_SABM, TRUE, TRUE, NULL, 0,
+                              expected_dlci0, sizeof (expected_dlci0));
+    common_test_frame_append (1, MM_CMUX_FRAME_TYPE_SABM, TRUE, TRUE, NULL, 0,
+                              expected_dlci1, sizeof (expected_dlci1));
+}
+
+static void
+test_frame_append_uih (void)
+{
+    static const guint8 expected[] = { 0xF9, 0x07, 0xEF, 0x07, 'A', 'T', '\r', 0xD3, 0xF9 };
+
+    common_test_frame_append (1, MM_CMUX_FRAME_TYPE_UIH, FALSE, TRUE, (const guint8 *)"AT\r", 3,
+                              expected, sizeof (expected));
+}
+
+static void
+test_frame_append_cld (void)
+{
+    static const guint8 expected[] = { 0xF9, 0x03, 0xEF, 0x05, 0xC3, 0x01, 0xF2, 0xF9 };
+    GByteArray *message;
+
+    message = g_byte_array_new ();
+    mm_cmux_control_message_append (message, MM_CMUX_CONTROL_TYPE_CLD, TRUE, NULL, 0);
+    common_test_frame_append (0, MM_CMUX_FRAME_TYPE_UIH, FALSE, TRUE, message->data, message->len,
+                              expected, sizeof (expected));
+    g_byte_array_unref (message);
+}
+
+/*****************************************************************************/
+
+static void
+test_frame_parse_ua (void)
+{
+    static const guint8 buffer[] = { 0xF9, 0x03, 0x73, 0x01, 0xD7, 0xF9 };
+    MMCmuxFrame frame;
+    gsize consumed = 0;
+
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer, sizeof (buffer), &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_FRAME);
+    g_assert_cmpuint (consumed, ==, sizeof (buffer) - 1);
+    g_assert_cmpuint (frame.dlci, ==, 0);
+    g_assert_cmpuint (frame.type, ==, MM_CMUX_FRAME_TYPE_UA);
+    g_assert (frame.pf);
+    g_assert (frame.cr);
+    g_assert_cmpuint (frame.len, ==, 0);
+}
+
+static void
+test_frame_parse_sequence (void)
+{
+    GByteArray *buffer;
+    MMCmuxFrame frame;
+    gsize consumed;
+
+    /* Garbage, then two frames sharing the flag in between */
+    buffer = g_byte_array_new ();
+    g_byte_array_append (buffer, (const guint8 *)"\r\nOK\r\n", 6);
+    mm_cmux_frame_append (buffer, 2, MM_CMUX_FRAME_TYPE_UIH, FALSE, FALSE, (const guint8 *)"\r\nOK\r\n", 6);
+    g_byte_array_remove_index (buffer, buffer->len - 1);
+    mm_cmux_frame_append (buffer, 3, MM_CMUX_FRAME_TYPE_UIH, FALSE, FALSE, (const guint8 *)"CONNECT", 7);
+
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer->data, buffer->len, &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_FRAME);
+    g_assert_cmpuint (frame.dlci, ==, 2);
+    g_assert (!frame.cr);
+    g_assert_cmpuint (frame.len, ==, 6);
+    g_assert (memcmp (frame.data, "\r\nOK\r\n", 6) == 0);
+    g_byte_array_remove_range (buffer, 0, consumed);
+
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer->data, buffer->len, &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_FRAME);
+    g_assert_cmpuint (frame.dlci, ==, 3);
+    g_assert_cmpuint (frame.len, ==, 7);
+    g_assert (memcmp (frame.data, "CONNECT", 7) == 0);
+    g_byte_array_remove_range (buffer, 0, consumed);
+
+    /* Only the closing flag is left */
+    g_assert_cmpuint (buffer->len, ==, 1);
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer->data, buffer->len, &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_NEED_MORE);
+    g_assert_cmpuint (consumed, ==, 0);
+
+    g_byte_array_unref (buffer);
+}
+
+static void
+test_frame_parse_partial (void)
+{
+    GByteArray *buffer;
+    MMCmuxFrame frame;
+    gsize consumed;
+    guint i;
+
+    buffer = g_byte_array_new ();
+    mm_cmux_frame_append (buffer, 1, MM_CMUX_FRAME_TYPE_UIH, FALSE, FALSE, (const guint8 *)"+CSQ: 20,99", 11);
+
+    /* No frame until all bytes are available */
+    for (i = 1; i < buffer->len; i++) {
+        g_assert_cmpuint (mm_cmux_frame_parse (buffer->data, i, &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_NEED_MORE);
+        g_assert_cmpuint (consumed, ==, 0);
+    }
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer->data, buffer->len, &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_FRAME);
+
+    g_byte_array_unref (buffer);
+}
+
+static void
+test_frame_parse_long (void)
+{
+    GByteArray *buffer;
+    guint8 data[300];
+    MMCmuxFrame frame;
+    gsize consumed;
+    guint i;
+
+    for (i = 0; i < sizeof (data); i++)
+        data[i] = (guint8) i;
+
+    /* More than 127 bytes require the two-byte length field */
+    buffer = g_byte_array_new ();
+    mm_cmux_frame_append (buffer, 3, MM_CMUX_FRAME_TYPE_UIH, FALSE, TRUE, data, sizeof (data));
+    g_assert_cmpuint (buffer->len, ==, 1 + 4 + sizeof (data) + 1 + 1);
+
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer->data, buffer->len, &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_FRAME);
+    g_assert_cmpuint (frame.len, ==, sizeof (data));
+    g_assert (memcmp (frame.data, data, sizeof (data)) == 0);
+
+    g_byte_array_unref (buffer);
+}
+
+static void
+test_frame_parse_invalid_fcs (void)
+{
+    static const guint8 buffer[] = { 0xF9, 0x03, 0x73, 0x01, 0xD8, 0xF9 };
+    MMCmuxFrame frame;
+    gsize consumed = 0;
+
+    /* The whole frame is discarded */
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer, sizeof (buffer), &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_INVALID);
+    g_assert_cmpuint (consumed, ==, sizeof (buffer) - 1);
+}
+
+static void
+test_frame_parse_garbage (void)
+{
+    static const guint8 buffer[] = { 'A', 'T', '\r', '\n' };
+    MMCmuxFrame frame;
+    gsize consumed = 0;
+
+    g_assert_cmpuint (mm_cmux_frame_parse (buffer, sizeof (buffer), &frame, &consumed), ==, MM_CMUX_PARSE_RESULT_NEED_MORE);
+    g_assert_cmpuint (consumed, ==, sizeof (buffer));
+}
+
+/*****************************************************************************/
+
+static void
+test_control_message_msc (void)
+{
+    static const guint8 msc[] = { 0xE3, 0x05, 0x0B, 0x8D };
+    guint8 type;
+    gboolean cr;
+    const guint8 *value;
+    gsize value_len;
+
+    g_assert (mm_cmux_control_message_parse (msc, sizeof (msc), &type, &cr, &value, &value_len));
+    g_assert_cmpuint (type, ==, MM_CMUX_CONTROL_TYPE_MSC);
+    g_assert (cr);
+    g_assert_cmpuint (value_len, ==, 2);
+    g_assert_cmpuint (value[0] >> 2, ==, 2);
+    g_assert_cmpuint (value[1], ==, MM_CMUX_MSC_RTC | MM_CMUX_MSC_RTR | MM_CMUX_MSC_DV | 0x01);
+
+    /* Truncated */
+    g_assert (!mm_cmux_control_message_parse (msc, 3, &type, &cr, &value, &value_len));
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/cmux/frame/append/sabm",        test_frame_append_sabm);
+    g_test_add_func ("/MM/cmux/frame/append/uih",         test_frame_append_uih);
+    g_test_add_func ("/MM/cmux/frame/append/cld",         test_frame_append_cld);
+    g_test_add_func ("/MM/cmux/frame/parse/ua",           test_frame_parse_ua);
+    g_test_add_func ("/MM/cmux/frame/parse/sequence",     test_frame_parse_sequence);
+    g_test_add_func ("/MM/cmux/frame/parse/partial",      test_frame_parse_partial);
+    g_test_add_func ("/MM/cmux/frame/parse/long",         test_frame_parse_long);
+    g_test_add_func ("/MM/cmux/frame/parse/invalid-fcs",  test_frame_parse_invalid_fcs);
+    g_test_add_func ("/MM/cmux/frame/parse/garbage",      test_frame_parse_garbage);
+    g_test_add_func ("/MM/cmux/control-message/msc",      test_control_message_msc);
+
+    return g_test_run ();
+}
@@ -0,0 +1,165 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-metrics.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+static void
+test_registry (void)
+{
+    MMMetric *a;
+    MMMetric *b;
+    MMMetric *other;
+    gchar    *report;
+
+    /* Same name and owner gives the same metric */
+    a = mm_metrics_get (MM_METRIC_TYPE_COUNTER, "test_commands_total", "ttyUSB0");
+    b = mm_metrics_get (MM_METRIC_TYPE_COUNTER, "test_commands_total", "ttyUSB0");
+    other = mm_metrics_get (MM_METRIC_TYPE_COUNTER, "test_commands_total", "ttyUSB1");
+    g_assert (a == b);
+    g_assert (a != other);
+
+    mm_metric_inc (a);
+    mm_metric_inc (b);
+    mm_metric_inc (other);
+    g_assert_cmpint (mm_metric_get_value (a), ==, 2);
+    g_assert_cmpint (mm_metric_get_value (other), ==, 1);
+
+    /* NULL metrics are ignored */
+    mm_metric_inc (NULL);
+    mm_metric_observe (NULL, 10);
+
+    report = mm_metrics_build ();
+    g_assert_cmpstr (report, ==,
+                     "# TYPE test_commands_total counter\n"
+                     "test_commands_total{owner=\"ttyUSB0\"} 2\n"
+                     "test_commands_total{owner=\"ttyUSB1\"} 1\n");
+    g_free (report);
+
+    /* Metrics stay around until the last reference is gone */
+    mm_metric_unref (a);
+    mm_metric_unref (other);
+    report = mm_metrics_build ();
+    g_assert_cmpstr (report, ==,
+                     "# TYPE test_commands_total counter\n"
+                     "test_commands_total{owner=\"ttyUSB0\"} 2\n");
+    g_free (report);
+
+    mm_metric_unref (b);
+    report = mm_metrics_build ();
+    g_assert_cmpstr (report, ==, "");
+    g_free (report);
+}
+
+static void
+test_gauge (void)
+{
+    MMMetric *gauge;
+    gchar    *report;
+
+    gauge = mm_metrics_get (MM_METRIC_TYPE_GAUGE, "test_in_progress", NULL);
+    mm_metric_inc (gauge);
+    mm_metric_dec (gauge);
+    mm_metric_dec (gauge);
+    g_assert_cmpint (mm_metric_get_value (gauge), ==, -1);
+
+    report = mm_metrics_build ();
+    g_assert_cmpstr (report, ==,
+                     "# TYPE test_in_progress gauge\n"
+                     "test_in_progress -1\n");
+    g_free (report);
+
+    mm_metric_set (gauge, 7);
+    g_assert_cmpint (mm_metric_get_value (gauge), ==, 7);
+    mm_metric_unref (gauge);
+}
+
+static void
+test_histogram (void)
+{
+    MMMetric *histogram;
+    gchar    *report;
+
+    histogram = mm_metrics_get (MM_METRIC_TYPE_HISTOGRAM, "test_latency_ms", "owner \"quoted\"");
+
+    /* Bounds are inclusive */
+    mm_metric_observe (histogram, 0);
+    mm_metric_observe (histogram, 1);
+    mm_metric_observe (histogram, 2);
+    mm_metric_observe (histogram, 30000);
+    mm_metric_observe (histogram, 30001);
+
+    g_assert_cmpuint (mm_metric_get_count (histogram), ==, 5);
+    g_assert_cmpuint (mm_metric_get_sum (histogram), ==, 60004);
+    g_assert_cmpuint (mm_metric_get_bucket (histogram, 0), ==, 2);
+    g_assert_cmpuint (mm_metric_get_bucket (histogram, 1), ==, 1);
+    g_assert_cmpuint (mm_metric_get_bucket (histogram, MM_METRICS_HISTOGRAM_N_BUCKETS - 2), ==, 1);
+    g_assert_cmpuint (mm_metric_get_bucket (histogram, MM_METRICS_HISTOGRAM_N_BUCKETS - 1), ==, 1);
+
+    /* Buckets are cumulative in the report */
+    report = mm_metrics_build ();
+    g_assert (g_str_has_prefix (report, "# TYPE test_latency_ms histogram\n"));
+    g_assert (strstr (report, "test_latency_ms_bucket{owner=\"owner \\\"quoted\\\"\",le=\"1\"} 2\n"));
+    g_assert (strstr (report, "test_latency_ms_bucket{owner=\"owner \\\"quoted\\\"\",le=\"5\"} 3\n"));
+    g_assert (strstr (report, "test_latency_ms_bucket{owner=\"owner \\\"quoted\\\"\",le=\"10000\"} 3\n"));
+    g_assert (strstr (report, "test_latency_ms_bucket{owner=\"owner \\\"quoted\\\"\",le=\"30000\"} 4\n"));
+    g_assert (strstr (report, "test_latency_ms_bucket{owner=\"owner \\\"quoted\\\"\",le=\"+Inf\"} 5\n"));
+    g_assert (strstr (report, "test_latency_ms_sum{owner=\"owner \\\"quoted\\\"\"} 60004\n"));
+    g_assert (strstr (report, "test_latency_ms_count{owner=\"owner \\\"quoted\\\"\"} 5\n"));
+    g_free (report);
+
+    mm_metric_unref (histogram);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/metrics/registry",  test_registry);
+    g_test_add_func ("/MM/metrics/gauge",     test_gauge);
+    g_test_add_func ("/MM/metrics/histogram", test_histogram);
+
+    return g_test_run ();
+}
@@ -0,0 +1,222 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-modem-band-set.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+static void
+test_membership (void)
+{
+    MMModemBandSet set;
+
+    mm_modem_band_set_clear (&set);
+    g_assert (mm_modem_band_set_is_empty (&set));
+    g_assert_cmpuint (mm_modem_band_set_count (&set), ==, 0);
+
+    mm_modem_band_set_add (&set, MM_MODEM_BAND_EGSM);
+    mm_modem_band_set_add (&set, MM_MODEM_BAND_EUTRAN_71);
+    mm_modem_band_set_add (&set, MM_MODEM_BAND_UTRAN_32);
+    mm_modem_band_set_add (&set, MM_MODEM_BAND_ANY);
+    /* Already there */
+    mm_modem_band_set_add (&set, MM_MODEM_BAND_EGSM);
+    /* Out of range, ignored */
+    mm_modem_band_set_add (&set, (MMModemBand) (MM_MODEM_BAND_ANY + 1));
+
+    g_assert (!mm_modem_band_set_is_empty (&set));
+    g_assert_cmpuint (mm_modem_band_set_count (&set), ==, 4);
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_EGSM));
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_EUTRAN_71));
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_UTRAN_32));
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_ANY));
+    g_assert (!mm_modem_band_set_contains (&set, MM_MODEM_BAND_DCS));
+    g_assert (!mm_modem_band_set_contains (&set, (MMModemBand) (MM_MODEM_BAND_ANY + 1)));
+
+    mm_modem_band_set_remove (&set, MM_MODEM_BAND_EUTRAN_71);
+    g_assert (!mm_modem_band_set_contains (&set, MM_MODEM_BAND_EUTRAN_71));
+    g_assert_cmpuint (mm_modem_band_set_count (&set), ==, 3);
+}
+
+static void
+test_operations (void)
+{
+    MMModemBandSet a;
+    MMModemBandSet b;
+    MMModemBandSet c;
+
+    mm_modem_band_set_clear (&a);
+    mm_modem_band_set_add (&a, MM_MODEM_BAND_DCS);
+    mm_modem_band_set_add (&a, MM_MODEM_BAND_UTRAN_1);
+    mm_modem_band_set_add (&a, MM_MODEM_BAND_CDMA_BC0);
+
+    mm_modem_band_set_clear (&b);
+    mm_modem_band_set_add (&b, MM_MODEM_BAND_UTRAN_1);
+    mm_modem_band_set_add (&b, MM_MODEM_BAND_EUTRAN_3);
+
+    c = a;
+    mm_modem_band_set_union (&c, &b);
+    g_assert_cmpuint (mm_modem_band_set_count (&c), ==, 4);
+    g_assert (mm_modem_band_set_contains (&c, MM_MODEM_BAND_EUTRAN_3));
+
+    c = a;
+    mm_modem_band_set_intersect (&c, &b);
+    g_assert_cmpuint (mm_modem_band_set_count (&c), ==, 1);
+    g_assert (mm_modem_band_set_contains (&c, MM_MODEM_BAND_UTRAN_1));
+
+    c = a;
+    mm_modem_band_set_subtract (&c, &b);
+    g_assert_cmpuint (mm_modem_band_set_count (&c), ==, 2);
+    g_assert (!mm_modem_band_set_contains (&c, MM_MODEM_BAND_UTRAN_1));
+
+    g_assert (!mm_modem_band_set_equal (&a, &b));
+    c = a;
+    g_assert (mm_modem_band_set_equal (&a, &c));
+}
+
+static void
+test_iter (void)
+{
+    static const MMModemBand bands[] = {
+        MM_MODEM_BAND_UNKNOWN,
+        MM_MODEM_BAND_UTRAN_7,
+        MM_MODEM_BAND_EUTRAN_1,   /* last of the first word */
+        MM_MODEM_BAND_EUTRAN_2,   /* first of the second word */
+        MM_MODEM_BAND_CDMA_BC19,
+        MM_MODEM_BAND_ANY,
+    };
+    MMModemBandSet set;
+    MMModemBand    band;
+    guint          iter = 0;
+    guint          i;
+
+    mm_modem_band_set_clear (&set);
+    for (i = G_N_ELEMENTS (bands); i > 0; i--)
+        mm_modem_band_set_add (&set, bands[i - 1]);
+
+    for (i = 0; mm_modem_band_set_iter_next (&set, &iter, &band); i++) {
+        g_assert_cmpuint (i, <, G_N_ELEMENTS (bands));
+        g_assert_cmpuint (band, ==, bands[i]);
+    }
+    g_assert_cmpuint (i, ==, G_N_ELEMENTS (bands));
+
+    /* Iterating again after the end is fine */
+    g_assert (!mm_modem_band_set_iter_next (&set, &iter, &band));
+}
+
+static void
+test_range_mask (void)
+{
+    MMModemBandSet set;
+
+    mm_modem_band_set_clear (&set);
+    mm_modem_band_set_add_range_mask (&set, MM_MODEM_BAND_EUTRAN_1, 0x800000000000000bULL);
+    g_assert_cmpuint (mm_modem_band_set_count (&set), ==, 4);
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_EUTRAN_1));
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_EUTRAN_2));
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_EUTRAN_4));
+    g_assert (mm_modem_band_set_contains (&set, MM_MODEM_BAND_EUTRAN_64));
+
+    g_assert_cmphex (mm_modem_band_set_get_range_mask (&set, MM_MODEM_BAND_EUTRAN_1, MM_MODEM_BAND_EUTRAN_64),
+                     ==, 0x800000000000000bULL);
+    g_assert_cmphex (mm_modem_band_set_get_range_mask (&set, MM_MODEM_BAND_EUTRAN_2, MM_MODEM_BAND_EUTRAN_4),
+                     ==, 0x5);
+    g_assert_cmphex (mm_modem_band_set_get_range_mask (&set, MM_MODEM_BAND_EUTRAN_65, MM_MODEM_BAND_EUTRAN_71),
+                     ==, 0);
+}
+
+static void
+test_array (void)
+{
+    static const MMModemBand input[] = {
+        MM_MODEM_BAND_UTRAN_2,
+        MM_MODEM_BAND_EGSM,
+        MM_MODEM_BAND_UTRAN_2,
+        MM_MODEM_BAND_EUTRAN_20,
+    };
+    static const MMModemBand expected[] = {
+        MM_MODEM_BAND_EGSM,
+        MM_MODEM_BAND_UTRAN_2,
+        MM_MODEM_BAND_EUTRAN_20,
+    };
+    MMModemBandSet  set;
+    GArray         *array;
+    guint           i;
+
+    array = g_array_new (FALSE, FALSE, sizeof (MMModemBand));
+    g_array_append_vals (array, input, G_N_ELEMENTS (input));
+
+    mm_modem_band_set_clear (&set);
+    mm_modem_band_set_add_array (&set, array);
+    g_array_unref (array);
+
+    /* Duplicates removed and sorted */
+    array = mm_modem_band_set_to_array (&set);
+    g_assert_cmpuint (array->len, ==, G_N_ELEMENTS (expected));
+    for (i = 0; i < array->len; i++)
+        g_assert_cmpuint (g_array_index (array, MMModemBand, i), ==, expected[i]);
+    g_array_unref (array);
+
+    /* Special arrays */
+    array = g_array_new (FALSE, FALSE, sizeof (MMModemBand));
+    g_assert (!mm_modem_band_array_is_special (array));
+    g_array_append_val (array, expected[0]);
+    g_assert (!mm_modem_band_array_is_special (array));
+    g_array_index (array, MMModemBand, 0) = MM_MODEM_BAND_ANY;
+    g_assert (mm_modem_band_array_is_special (array));
+    g_array_index (array, MMModemBand, 0) = MM_MODEM_BAND_UNKNOWN;
+    g_assert (mm_modem_band_array_is_special (array));
+    g_array_unref (array);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/modem-band-set/membership", test_membership);
+    g_test_add_func ("/MM/modem-band-set/operations", test_operations);
+    g_test_add_func ("/MM/modem-band-set/iter",       test_iter);
+    g_test_add_func ("/MM/modem-band-set/range-mask", test_range_mask);
+    g_test_add_func ("/MM/modem-band-set/array",      test_array);
+
+    return g_test_run ();
+}
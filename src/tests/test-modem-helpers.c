@@ -1034,8 +1034,7 @@ test_normalize_operator (void)
 /* Test CREG/CGREG responses and unsolicited messages */
 
 typedef struct {
-    GPtrArray *solicited_creg;
-    GPtrArray *unsolicited_creg;
+    GRegex *unsolicited_creg;
 } RegTestData;
 
 static RegTestData *
@@ -1044,16 +1043,14 @@ reg_test_data_new (void)
     RegTestData *data;
 
     data = g_malloc0 (sizeof (RegTestData));
-    data->solicited_creg = mm_3gpp_creg_regex_get (TRUE);
-    data->unsolicited_creg = mm_3gpp_creg_regex_get (FALSE);
+    data->unsolicited_creg = mm_3gpp_creg_unsolicited_regex_get ();
     return data;
 }
 
 static void
 reg_test_data_free (RegTestData *data)
 {
-    mm_3gpp_creg_regex_destroy (data->solicited_creg);
-    mm_3gpp_creg_regex_destroy (data->unsolicited_creg);
+    g_regex_unref (data->unsolicited_creg);
     g_free (data);
 }
 
@@ -1063,7 +1060,6 @@ typedef struct {
     gulong ci;
     MMModemAccessTechnology act;
 
-    guint regex_num;
     gboolean cgreg;
     gboolean cereg;
 } CregResult;
@@ -1075,15 +1071,13 @@ test_creg_match (const char *test,
                  RegTestData *data,
                  const CregResult *result)
 {
-    int i;
     GMatchInfo *info  = NULL;
     MMModem3gppRegistrationState state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     MMModemAccessTechnology access_tech = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
     gulong lac = 0, ci = 0;
     GError *error = NULL;
     gboolean success, cgreg = FALSE, cereg = FALSE;
-    guint regex_num = 0;
-    GPtrArray *array;
+    const gchar *report;
 
     g_assert (reply);
     g_assert (test);
@@ -1095,30 +1089,23 @@ test_creg_match (const char *test,
            result->cgreg ? "G" : "",
            solicited ? "solicited" : "unsolicited");
 
-    array = solicited ? data->solicited_creg : data->unsolicited_creg;
-    for (i = 0; i < array->len; i++) {
-        GRegex *r = g_ptr_array_index (array, i);
+    /* Unsolicited messages go through the port URC handler first, which
+     * gives the whole report line to the parser */
+    if (solicited)
+        report = reply;
+    else {
+        gint start = 0;
 
-        if (g_regex_match (r, reply, 0, &info)) {
-            trace ("  matched with %d\n", i);
-            regex_num = i + 1;
-            break;
-        }
-        g_match_info_free (info);
-        info = NULL;
+        g_assert (g_regex_match (data->unsolicited_creg, reply, 0, &info));
+        g_match_info_fetch_pos (info, 1, &start, NULL);
+        report = reply + start;
     }
 
-    trace ("  regex_num (%u) == result->regex_num (%u)\n",
-           regex_num,
-           result->regex_num);
-
-    g_assert (info != NULL);
-    g_assert_cmpuint (regex_num, ==, result->regex_num);
-
-    success = mm_3gpp_parse_creg_response (info, &state, &lac, &ci, &access_tech, &cgreg, &cereg, &error);
-    g_match_info_free (info);
-    g_assert (success);
+    success = mm_3gpp_parse_creg_response (report, &state, &lac, &ci, &access_tech, &cgreg, &cereg, &error);
+    if (info)
+        g_match_info_free (info);
     g_assert_no_error (error);
+    g_assert (success);
     g_assert_cmpuint (state, ==, result->state);
     g_assert (lac == result->lac);
     g_assert (ci == result->ci);
@@ -1135,7 +1122,7 @@ test_creg1_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 1,3";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 2, FALSE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("CREG=1", TRUE, reply, data, &result);
 }
@@ -1145,7 +1132,7 @@ test_creg1_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 3\r\n";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 1, FALSE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("CREG=1", FALSE, reply, data, &result);
 }
@@ -1155,7 +1142,7 @@ test_creg2_mercury_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 0,1,84CD,00D30173";
-    const CregResult result = { 1, 0x84cd, 0xd30173, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x84cd, 0xd30173, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Sierra Mercury CREG=2", TRUE, reply, data, &result);
 }
@@ -1165,7 +1152,7 @@ test_creg2_mercury_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 1,84CD,00D30156\r\n";
-    const CregResult result = { 1, 0x84cd, 0xd30156, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 1, 0x84cd, 0xd30156, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Sierra Mercury CREG=2", FALSE, reply, data, &result);
 }
@@ -1175,7 +1162,7 @@ test_creg2_sek850i_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,1,\"CE00\",\"01CEAD8F\"";
-    const CregResult result = { 1, 0xce00, 0x01cead8f, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0xce00, 0x01cead8f, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Sony Ericsson K850i CREG=2", TRUE, reply, data, &result);
 }
@@ -1185,7 +1172,7 @@ test_creg2_sek850i_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 1,\"CE00\",\"00005449\"\r\n";
-    const CregResult result = { 1, 0xce00, 0x5449, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 1, 0xce00, 0x5449, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Sony Ericsson K850i CREG=2", FALSE, reply, data, &result);
 }
@@ -1195,7 +1182,7 @@ test_creg2_e160g_solicited_unregistered (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,0,00,0";
-    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Huawei E160G unregistered CREG=2", TRUE, reply, data, &result);
 }
@@ -1205,7 +1192,7 @@ test_creg2_e160g_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,1,8BE3,2BAF";
-    const CregResult result = { 1, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Huawei E160G CREG=2", TRUE, reply, data, &result);
 }
@@ -1215,7 +1202,7 @@ test_creg2_e160g_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,8BE3,2BAF\r\n";
-    const CregResult result = { 2, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 2, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Huawei E160G CREG=2", FALSE, reply, data, &result);
 }
@@ -1225,7 +1212,7 @@ test_creg2_tm506_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,1,\"8BE3\",\"00002BAF\"";
-    const CregResult result = { 1, 0x8BE3, 0x2BAF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x8BE3, 0x2BAF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     /* Test leading zeros in the CI */
     test_creg_match ("Sony Ericsson TM-506 CREG=2", TRUE, reply, data, &result);
@@ -1236,7 +1223,7 @@ test_creg2_xu870_unsolicited_unregistered (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,,\r\n";
-    const CregResult result = { 2, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 2, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Novatel XU870 unregistered CREG=2", FALSE, reply, data, &result);
 }
@@ -1246,7 +1233,7 @@ test_creg2_iridium_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG:002,001,\"18d8\",\"ffff\"";
-    const CregResult result = { 1, 0x18D8, 0xFFFF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 5, FALSE, FALSE };
+    const CregResult result = { 1, 0x18D8, 0xFFFF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Iridium, CREG=2", TRUE, reply, data, &result);
 }
@@ -1256,7 +1243,7 @@ test_creg2_no_leading_zeros_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG:2,1,0001,0010";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("solicited CREG=2 with no leading zeros in integer fields", TRUE, reply, data, &result);
 }
@@ -1266,7 +1253,7 @@ test_creg2_leading_zeros_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG:002,001,\"0001\",\"0010\"";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 5, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("solicited CREG=2 with leading zeros in integer fields", TRUE, reply, data, &result);
 }
@@ -1276,7 +1263,7 @@ test_creg2_no_leading_zeros_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 1,0001,0010,0\r\n";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, 6, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, FALSE, FALSE };
 
     test_creg_match ("unsolicited CREG=2 with no leading zeros in integer fields", FALSE, reply, data, &result);
 }
@@ -1286,7 +1273,7 @@ test_creg2_leading_zeros_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 001,\"0001\",\"0010\",000\r\n";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, 7, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, FALSE, FALSE };
 
     test_creg_match ("unsolicited CREG=2 with leading zeros in integer fields", FALSE, reply, data, &result);
 }
@@ -1297,7 +1284,7 @@ test_creg2_ublox_solicited (void *f, gpointer d)
     RegTestData *data = (RegTestData *) d;
     const gchar *reply = "\r\n+CREG: 2,6,\"8B37\",\"0A265185\",7\r\n";
     /* NOTE: '6' means registered for "SMS only", home network; we just assume UNKNOWN in this case */
-    const CregResult result = { MM_MODEM_3GPP_REGISTRATION_STATE_HOME_SMS_ONLY, 0x8B37, 0x0A265185, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 8, FALSE, FALSE };
+    const CregResult result = { MM_MODEM_3GPP_REGISTRATION_STATE_HOME_SMS_ONLY, 0x8B37, 0x0A265185, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, FALSE };
 
     test_creg_match ("Ublox Toby-L2 solicited while on LTE", TRUE, reply, data, &result);
 }
@@ -1308,7 +1295,7 @@ test_creg2_ublox_unsolicited (void *f, gpointer d)
     RegTestData *data = (RegTestData *) d;
     const gchar *reply = "\r\n+CREG: 6,\"8B37\",\"0A265185\",7\r\n";
     /* NOTE: '6' means registered for "SMS only", home network; we just assume UNKNOWN in this case */
-    const CregResult result = { MM_MODEM_3GPP_REGISTRATION_STATE_HOME_SMS_ONLY, 0x8B37, 0x0A265185, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 6, FALSE, FALSE };
+    const CregResult result = { MM_MODEM_3GPP_REGISTRATION_STATE_HOME_SMS_ONLY, 0x8B37, 0x0A265185, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, FALSE };
 
     test_creg_match ("Ublox Toby-L2 unsolicited while on LTE", FALSE, reply, data, &result);
 }
@@ -1318,7 +1305,7 @@ test_cgreg1_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CGREG: 1,3";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 2, TRUE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("CGREG=1", TRUE, reply, data, &result);
 }
@@ -1328,7 +1315,7 @@ test_cgreg1_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 3\r\n";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 1, TRUE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("CGREG=1", FALSE, reply, data, &result);
 }
@@ -1338,7 +1325,7 @@ test_cgreg2_f3607gw_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CGREG: 2,1,\"8BE3\",\"00002B5D\",3";
-    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, 8, TRUE, FALSE };
+    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, TRUE, FALSE };
 
     test_creg_match ("Ericsson F3607gw CGREG=2", TRUE, reply, data, &result);
 }
@@ -1348,7 +1335,7 @@ test_cgreg2_f3607gw_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 1,\"8BE3\",\"00002B5D\",3\r\n";
-    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, 6, TRUE, FALSE };
+    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, TRUE, FALSE };
 
     test_creg_match ("Ericsson F3607gw CGREG=2", FALSE, reply, data, &result);
 }
@@ -1358,7 +1345,7 @@ test_creg2_md400_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,5,\"0502\",\"0404736D\"\r\n";
-    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Sony-Ericsson MD400 CREG=2", FALSE, reply, data, &result);
 }
@@ -1368,7 +1355,7 @@ test_cgreg2_md400_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 5,\"0502\",\"0404736D\",2\r\n";
-    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UMTS, 6, TRUE, FALSE };
+    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UMTS, TRUE, FALSE };
 
     test_creg_match ("Sony-Ericsson MD400 CGREG=2", FALSE, reply, data, &result);
 }
@@ -1378,7 +1365,7 @@ test_creg_cgreg_multi_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 5\r\n\r\n+CGREG: 0\r\n";
-    const CregResult result = { 5, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 1, FALSE, FALSE };
+    const CregResult result = { 5, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Multi CREG/CGREG", FALSE, reply, data, &result);
 }
@@ -1388,7 +1375,7 @@ test_creg_cgreg_multi2_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 0\r\n\r\n+CREG: 5\r\n";
-    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 1, TRUE, FALSE };
+    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("Multi CREG/CGREG #2", FALSE, reply, data, &result);
 }
@@ -1398,7 +1385,7 @@ test_cgreg2_x220_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 2,1, 81ED, 1A9CEB\r\n";
-    const CregResult result = { 1, 0x81ED, 0x1A9CEB, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 4, TRUE, FALSE };
+    const CregResult result = { 1, 0x81ED, 0x1A9CEB, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     /* Tests random spaces in response */
     test_creg_match ("Alcatel One-Touch X220D CGREG=2", FALSE, reply, data, &result);
@@ -1409,7 +1396,7 @@ test_creg2_s8500_wave_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,1,000B,2816, B, C2816\r\n";
-    const CregResult result = { 1, 0x000B, 0x2816, MM_MODEM_ACCESS_TECHNOLOGY_GSM, 9, FALSE, FALSE };
+    const CregResult result = { 1, 0x000B, 0x2816, MM_MODEM_ACCESS_TECHNOLOGY_GSM, FALSE, FALSE };
 
     test_creg_match ("Samsung Wave S8500 CREG=2", FALSE, reply, data, &result);
 }
@@ -1419,7 +1406,7 @@ test_creg2_gobi_weird_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,1,  0 5, 2715\r\n";
-    const CregResult result = { 1, 0x0000, 0x2715, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x0000, 0x2715, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Qualcomm Gobi 1000 CREG=2", TRUE, reply, data, &result);
 }
@@ -1429,7 +1416,7 @@ test_cgreg2_unsolicited_with_rac (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 1,\"1422\",\"00000142\",3,\"00\"\r\n";
-    const CregResult result = { 1, 0x1422, 0x0142, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, 10, TRUE, FALSE };
+    const CregResult result = { 1, 0x1422, 0x0142, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, TRUE, FALSE };
 
     test_creg_match ("CGREG=2 with RAC", FALSE, reply, data, &result);
 }
@@ -1439,7 +1426,7 @@ test_cereg1_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CEREG: 1,3";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 2, FALSE, TRUE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, TRUE };
 
     test_creg_match ("CEREG=1", TRUE, reply, data, &result);
 }
@@ -1449,7 +1436,7 @@ test_cereg1_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 3\r\n";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 1, FALSE, TRUE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, TRUE };
 
     test_creg_match ("CEREG=1", FALSE, reply, data, &result);
 }
@@ -1459,7 +1446,7 @@ test_cereg2_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 2,1, 1F00, 79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 8, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("CEREG=2", TRUE, reply, data, &result);
 }
@@ -1469,7 +1456,7 @@ test_cereg2_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 1, 1F00, 79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 6, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("CEREG=2", FALSE, reply, data, &result);
 }
@@ -1479,7 +1466,7 @@ test_cereg2_altair_lte_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 1, 2, 0001, 00000100, 7\r\n";
-    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 8, FALSE, TRUE };
+    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Altair LTE CEREG=2", FALSE, reply, data, &result);
 }
@@ -1489,7 +1476,7 @@ test_cereg2_altair_lte_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 2, 0001, 00000100, 7\r\n";
-    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 6, FALSE, TRUE };
+    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Altair LTE CEREG=2", FALSE, reply, data, &result);
 }
@@ -1499,7 +1486,7 @@ test_cereg2_novatel_lte_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 2,1, 1F00, 20 ,79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 13, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Novatel LTE E362 CEREG=2", TRUE, reply, data, &result);
 }
@@ -1509,7 +1496,7 @@ test_cereg2_novatel_lte_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 1, 1F00, 20 ,79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 12, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Novatel LTE E362 CEREG=2", FALSE, reply, data, &result);
 }
@@ -1519,7 +1506,7 @@ test_cgreg2_thuraya_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CGREG: 1, \"0426\", \"F0,0F\"";
-    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 11, TRUE, FALSE };
+    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("Thuraya solicited CREG=2", TRUE, reply, data, &result);
 }
@@ -1529,11 +1516,39 @@ test_cgreg2_thuraya_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 1, \"0426\", \"F0,0F\"\r\n";
-    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 11, TRUE, FALSE };
+    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("Thuraya unsolicited CREG=2", FALSE, reply, data, &result);
 }
 
+static void
+test_creg_invalid (void *f, gpointer d)
+{
+    static const gchar *replies[] = {
+        "+CREG: ",
+        "+CREG: 1,",
+        "+CREG: 2,1,\"8BE3\",\"2BAF\",7,1,2",
+        "+CEREG: 1,2,3,4,5,6,7",
+        "+COPS: 0,0,\"Vodafone\",2",
+        "",
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (replies); i++) {
+        MMModem3gppRegistrationState state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
+        MMModemAccessTechnology access_tech = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
+        gulong lac = 0, ci = 0;
+        gboolean cgreg = FALSE, cereg = FALSE;
+        GError *error = NULL;
+        gboolean success;
+
+        success = mm_3gpp_parse_creg_response (replies[i], &state, &lac, &ci, &access_tech, &cgreg, &cereg, &error);
+        g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+        g_assert (!success);
+        g_error_free (error);
+    }
+}
+
 /*****************************************************************************/
 /* Test CSCS responses */
 
@@ -2883,6 +2898,53 @@ test_cpms_query_response (void *f, gpointer d) {
     }
 }
 
+/*****************************************************************************/
+/* Test +CMMS=? responses */
+
+typedef struct {
+    const gchar *str;
+    gboolean     keep_link_supported;
+} CmmsTestResponseTest;
+
+static const CmmsTestResponseTest cmms_test_response_tests[] = {
+    { "+CMMS: (0-2)",   TRUE  },
+    { "+CMMS: (0,1,2)", TRUE  },
+    { "+CMMS: (0,1)",   TRUE  },
+    { "+CMMS: (0)",     FALSE },
+    { "+CMMS: (0,2)",   FALSE },
+    { "+CMMS:(0-2)",    TRUE  },
+};
+
+static void
+test_cmms_test_response (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (cmms_test_response_tests); i++) {
+        gboolean  keep_link_supported = FALSE;
+        gboolean  success;
+        GError   *error = NULL;
+
+        success = mm_3gpp_parse_cmms_test_response (cmms_test_response_tests[i].str, &keep_link_supported, &error);
+        g_assert_no_error (error);
+        g_assert (success);
+        g_assert_cmpuint (keep_link_supported, ==, cmms_test_response_tests[i].keep_link_supported);
+    }
+}
+
+static void
+test_cmms_test_response_error (void)
+{
+    gboolean  keep_link_supported = FALSE;
+    gboolean  success;
+    GError   *error = NULL;
+
+    success = mm_3gpp_parse_cmms_test_response ("+CMMS: ", &keep_link_supported, &error);
+    g_assert (error != NULL);
+    g_assert (!success);
+    g_error_free (error);
+}
+
 /*****************************************************************************/
 /* Test CNUM responses */
 
@@ -3970,6 +4032,31 @@ test_parse_uint_list (void)
 
 /*****************************************************************************/
 
+static void
+common_test_str_append_escaped (const gchar *value,
+                                const gchar *expected)
+{
+    GString *str;
+
+    str = g_string_new ("");
+    mm_str_append_escaped (str, value);
+    g_assert_cmpstr (str->str, ==, expected);
+    g_string_free (str, TRUE);
+}
+
+static void
+test_str_append_escaped (void)
+{
+    common_test_str_append_escaped ("", "\"\"");
+    common_test_str_append_escaped ("ttyUSB0", "\"ttyUSB0\"");
+    common_test_str_append_escaped ("a\"b\\c", "\"a\\\"b\\\\c\"");
+    common_test_str_append_escaped ("a\nb\rc\td", "\"a\\nb\\rc\\td\"");
+    common_test_str_append_escaped ("a\x01" "b", "\"a\\u0001b\"");
+    common_test_str_append_escaped ("\xc3\xb1", "\"\xc3\xb1\"");
+}
+
+/*****************************************************************************/
+
 typedef struct {
     const guint8 bcd[10];
     gsize bcd_len;
@@ -4139,6 +4226,7 @@ int main (int argc, char **argv)
 
     g_test_suite_add (suite, TESTCASE (test_creg_cgreg_multi_unsolicited, reg_data));
     g_test_suite_add (suite, TESTCASE (test_creg_cgreg_multi2_unsolicited, reg_data));
+    g_test_suite_add (suite, TESTCASE (test_creg_invalid, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cscs_icon225_support_response, NULL));
     g_test_suite_add (suite, TESTCASE (test_cscs_sierra_mercury_support_response, NULL));
@@ -4181,6 +4269,9 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cpms_response_empty_fields, NULL));
     g_test_suite_add (suite, TESTCASE (test_cpms_query_response,        NULL));
 
+    g_test_suite_add (suite, TESTCASE (test_cmms_test_response,       NULL));
+    g_test_suite_add (suite, TESTCASE (test_cmms_test_response_error, NULL));
+
     g_test_suite_add (suite, TESTCASE (test_cmp_apn_name, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cgdcont_test_response_single, NULL));
@@ -4237,6 +4328,7 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cesq_response_to_signal, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_parse_uint_list, NULL));
+    g_test_suite_add (suite, TESTCASE (test_str_append_escaped, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_bcd_to_string, NULL));
 
@@ -0,0 +1,178 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-modem-info-cache.h"
+#include "mm-log.h"
+
+#define TEST_UID "/sys/devices/pci0000:00/0000:00:14.0/usb1/1-2"
+
+/*****************************************************************************/
+
+static MMModemInfo *
+common_build_info (const gchar *revision)
+{
+    MMModemInfo *info;
+    MMModemBand  band;
+
+    info = mm_modem_info_new ();
+    info->manufacturer = g_strdup ("Acme");
+    info->model = g_strdup ("Rocket 3000");
+    info->revision = g_strdup (revision);
+    info->equipment_identifier = g_strdup ("123456789012345");
+
+    info->supported_bands = g_array_new (FALSE, FALSE, sizeof (MMModemBand));
+    band = MM_MODEM_BAND_EGSM;
+    g_array_append_val (info->supported_bands, band);
+    band = MM_MODEM_BAND_UTRAN_1;
+    g_array_append_val (info->supported_bands, band);
+
+    return info;
+}
+
+static void
+test_store_peek (void)
+{
+    const MMModemInfo *info;
+
+    mm_modem_info_cache_clear ();
+    g_assert (mm_modem_info_cache_peek (TEST_UID, NULL) == NULL);
+
+    mm_modem_info_cache_store (TEST_UID, common_build_info ("1.0.0"));
+
+    /* Any revision */
+    info = mm_modem_info_cache_peek (TEST_UID, NULL);
+    g_assert (info != NULL);
+    g_assert_cmpstr (info->revision, ==, "1.0.0");
+
+    /* Same revision */
+    info = mm_modem_info_cache_peek (TEST_UID, "1.0.0");
+    g_assert (info != NULL);
+    g_assert_cmpstr (info->manufacturer, ==, "Acme");
+    g_assert_cmpstr (info->model, ==, "Rocket 3000");
+    g_assert_cmpstr (info->equipment_identifier, ==, "123456789012345");
+    g_assert (info->hardware_revision == NULL);
+    g_assert (info->supported_modes == NULL);
+    g_assert_cmpuint (info->supported_bands->len, ==, 2);
+
+    /* Other devices are not affected */
+    g_assert (mm_modem_info_cache_peek ("/sys/devices/other", NULL) == NULL);
+
+    mm_modem_info_cache_clear ();
+}
+
+static void
+test_revision_changed (void)
+{
+    mm_modem_info_cache_clear ();
+
+    mm_modem_info_cache_store (TEST_UID, common_build_info ("1.0.0"));
+
+    /* New firmware invalidates the entry */
+    g_assert (mm_modem_info_cache_peek (TEST_UID, "1.0.1") == NULL);
+    g_assert (mm_modem_info_cache_peek (TEST_UID, "1.0.0") == NULL);
+    g_assert (mm_modem_info_cache_peek (TEST_UID, NULL) == NULL);
+
+    mm_modem_info_cache_clear ();
+}
+
+static void
+test_replace (void)
+{
+    const MMModemInfo *info;
+
+    mm_modem_info_cache_clear ();
+
+    mm_modem_info_cache_store (TEST_UID, common_build_info ("1.0.0"));
+    mm_modem_info_cache_store (TEST_UID, common_build_info ("2.0.0"));
+
+    info = mm_modem_info_cache_peek (TEST_UID, NULL);
+    g_assert (info != NULL);
+    g_assert_cmpstr (info->revision, ==, "2.0.0");
+
+    mm_modem_info_cache_clear ();
+}
+
+static void
+test_invalidate (void)
+{
+    mm_modem_info_cache_clear ();
+
+    /* Invalidating unknown devices is fine */
+    mm_modem_info_cache_invalidate (TEST_UID, "SIM hot swap");
+
+    mm_modem_info_cache_store (TEST_UID, common_build_info ("1.0.0"));
+    mm_modem_info_cache_invalidate (TEST_UID, "SIM hot swap");
+    g_assert (mm_modem_info_cache_peek (TEST_UID, NULL) == NULL);
+
+    mm_modem_info_cache_clear ();
+}
+
+static void
+test_dup (void)
+{
+    MMModemInfo *info;
+    MMModemInfo *copy;
+
+    info = common_build_info ("1.0.0");
+    copy = mm_modem_info_dup (info);
+    mm_modem_info_free (info);
+
+    g_assert_cmpstr (copy->revision, ==, "1.0.0");
+    g_assert_cmpstr (copy->manufacturer, ==, "Acme");
+    g_assert_cmpuint (copy->supported_bands->len, ==, 2);
+    g_assert_cmpuint (g_array_index (copy->supported_bands, MMModemBand, 0), ==, MM_MODEM_BAND_EGSM);
+    mm_modem_info_free (copy);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/modem-info-cache/store-peek",       test_store_peek);
+    g_test_add_func ("/MM/modem-info-cache/revision-changed", test_revision_changed);
+    g_test_add_func ("/MM/modem-info-cache/replace",          test_replace);
+    g_test_add_func ("/MM/modem-info-cache/invalidate",       test_invalidate);
+    g_test_add_func ("/MM/modem-info-cache/dup",              test_dup);
+
+    return g_test_run ();
+}
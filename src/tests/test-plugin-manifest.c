@@ -0,0 +1,385 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "mm-plugin-manifest.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+static GKeyFile *
+load_manifest (const gchar *data)
+{
+    GKeyFile *manifest;
+    GError   *error = NULL;
+
+    manifest = g_key_file_new ();
+    g_assert (g_key_file_load_from_data (manifest, data, -1, G_KEY_FILE_NONE, &error));
+    g_assert_no_error (error);
+    return manifest;
+}
+
+static void
+test_parse (void)
+{
+    static const gchar *data =
+        "[libmm-plugin-foo.so]\n"
+        "name=Foo\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "drivers=option1;qmi_wwan;\n"
+        "vendor-ids=12d1;1e0e;\n"
+        "product-ids=19d2:0117;19D2:2003;\n";
+    GKeyFile              *manifest;
+    MMPluginManifestEntry *entry;
+
+    manifest = load_manifest (data);
+    entry = mm_plugin_manifest_entry_load (manifest, "libmm-plugin-foo.so");
+    g_assert (entry);
+
+    g_assert_cmpstr (entry->name, ==, "Foo");
+
+    g_assert (entry->drivers);
+    g_assert_cmpuint (g_strv_length (entry->drivers), ==, 2);
+    g_assert_cmpstr (entry->drivers[0], ==, "option1");
+    g_assert_cmpstr (entry->drivers[1], ==, "qmi_wwan");
+
+    g_assert (entry->vendor_ids);
+    g_assert_cmpuint (entry->vendor_ids[0], ==, 0x12d1);
+    g_assert_cmpuint (entry->vendor_ids[1], ==, 0x1e0e);
+    g_assert_cmpuint (entry->vendor_ids[2], ==, 0);
+
+    g_assert (entry->product_ids);
+    g_assert_cmpuint (entry->product_ids[0].l, ==, 0x19d2);
+    g_assert_cmpuint (entry->product_ids[0].r, ==, 0x0117);
+    g_assert_cmpuint (entry->product_ids[1].l, ==, 0x19d2);
+    g_assert_cmpuint (entry->product_ids[1].r, ==, 0x2003);
+    g_assert_cmpuint (entry->product_ids[2].l, ==, 0);
+
+    mm_plugin_manifest_entry_free (entry);
+    g_key_file_unref (manifest);
+}
+
+static void
+test_parse_not_deferred (void)
+{
+    static const gchar *data =
+        /* Explicitly not deferrable */
+        "[libmm-plugin-generic.so]\n"
+        "name=Generic\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=false\n"
+        /* No filters at all */
+        "[libmm-plugin-nofilters.so]\n"
+        "name=NoFilters\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        /* No name */
+        "[libmm-plugin-noname.so]\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "drivers=option1;\n"
+        /* Vendor ID out of range */
+        "[libmm-plugin-badvid.so]\n"
+        "name=BadVid\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "vendor-ids=12d1;10000;\n"
+        /* Vendor ID with trailing garbage */
+        "[libmm-plugin-badvid2.so]\n"
+        "name=BadVid2\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "vendor-ids=12d1x;\n"
+        /* Product ID without separator */
+        "[libmm-plugin-badpid.so]\n"
+        "name=BadPid\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "product-ids=19d20117;\n"
+        /* Product ID zero */
+        "[libmm-plugin-badpid2.so]\n"
+        "name=BadPid2\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "product-ids=19d2:0;\n";
+    static const gchar *fnames[] = {
+        "libmm-plugin-generic.so",
+        "libmm-plugin-nofilters.so",
+        "libmm-plugin-noname.so",
+        "libmm-plugin-badvid.so",
+        "libmm-plugin-badvid2.so",
+        "libmm-plugin-badpid.so",
+        "libmm-plugin-badpid2.so",
+        "libmm-plugin-missing.so",
+    };
+    GKeyFile *manifest;
+    guint     i;
+
+    manifest = load_manifest (data);
+    for (i = 0; i < G_N_ELEMENTS (fnames); i++)
+        g_assert (!mm_plugin_manifest_entry_load (manifest, fnames[i]));
+
+    /* Malformed entries of deferrable plugins are rewritten */
+    g_assert (!mm_plugin_manifest_entry_is_deferrable (manifest, "libmm-plugin-generic.so"));
+    g_assert (mm_plugin_manifest_entry_is_deferrable (manifest, "libmm-plugin-badvid.so"));
+    g_assert (!mm_plugin_manifest_entry_is_deferrable (manifest, "libmm-plugin-missing.so"));
+
+    g_key_file_unref (manifest);
+}
+
+static void
+test_store (void)
+{
+    static const gchar * const  drivers[] = { "option1", NULL };
+    static const guint16        vendor_ids[] = { 0x12d1, 0 };
+    static const mm_uint16_pair product_ids[] = { { 0x19d2, 0x0117 }, { 0, 0 } };
+    GKeyFile                   *manifest;
+    MMPluginManifestEntry      *entry;
+    gchar                      *data;
+
+    manifest = g_key_file_new ();
+    mm_plugin_manifest_entry_store (manifest, "libmm-plugin-foo.so", 1000, 2000,
+                                    "Foo", TRUE, drivers, vendor_ids, product_ids);
+    mm_plugin_manifest_entry_store (manifest, "libmm-plugin-generic.so", 3000, 4000,
+                                    "Generic", FALSE, drivers, vendor_ids, product_ids);
+
+    /* Write and read back, as done by the plugin manager */
+    data = g_key_file_to_data (manifest, NULL, NULL);
+    g_key_file_unref (manifest);
+    manifest = load_manifest (data);
+    g_free (data);
+
+    entry = mm_plugin_manifest_entry_load (manifest, "libmm-plugin-foo.so");
+    g_assert (entry);
+    g_assert_cmpstr (entry->name, ==, "Foo");
+    g_assert_cmpuint (g_strv_length (entry->drivers), ==, 1);
+    g_assert_cmpstr (entry->drivers[0], ==, "option1");
+    g_assert_cmpuint (entry->vendor_ids[0], ==, 0x12d1);
+    g_assert_cmpuint (entry->vendor_ids[1], ==, 0);
+    g_assert_cmpuint (entry->product_ids[0].l, ==, 0x19d2);
+    g_assert_cmpuint (entry->product_ids[0].r, ==, 0x0117);
+    g_assert_cmpuint (entry->product_ids[1].l, ==, 0);
+    mm_plugin_manifest_entry_free (entry);
+    g_assert (mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-foo.so", 1000, 2000));
+
+    /* Filters of non-deferrable plugins are not stored */
+    g_assert (!mm_plugin_manifest_entry_load (manifest, "libmm-plugin-generic.so"));
+    g_assert (!g_key_file_has_key (manifest, "libmm-plugin-generic.so", "drivers", NULL));
+    g_assert (mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-generic.so", 3000, 4000));
+
+    /* Storing again replaces the whole entry */
+    mm_plugin_manifest_entry_store (manifest, "libmm-plugin-foo.so", 1001, 2001,
+                                    "Foo", TRUE, NULL, vendor_ids, NULL);
+    entry = mm_plugin_manifest_entry_load (manifest, "libmm-plugin-foo.so");
+    g_assert (entry);
+    g_assert (!entry->drivers);
+    g_assert (!entry->product_ids);
+    g_assert_cmpuint (entry->vendor_ids[0], ==, 0x12d1);
+    mm_plugin_manifest_entry_free (entry);
+
+    g_key_file_unref (manifest);
+}
+
+/*****************************************************************************/
+
+static void
+test_stale (void)
+{
+    static const gchar *data =
+        "[libmm-plugin-foo.so]\n"
+        "name=Foo\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "drivers=option1;\n"
+        "[libmm-plugin-nosize.so]\n"
+        "name=NoSize\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "drivers=option1;\n"
+        "[libmm-plugin-badmtime.so]\n"
+        "name=BadMtime\n"
+        "size=1000\n"
+        "mtime=yesterday\n"
+        "deferrable=true\n"
+        "drivers=option1;\n";
+    GKeyFile *manifest;
+
+    manifest = load_manifest (data);
+
+    g_assert (mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-foo.so", 1000, 2000));
+    /* Rebuilt plugin, different size */
+    g_assert (!mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-foo.so", 1001, 2000));
+    /* Reinstalled plugin, same size but different modification time */
+    g_assert (!mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-foo.so", 1000, 2001));
+    /* New plugin */
+    g_assert (!mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-bar.so", 1000, 2000));
+    /* Malformed entries are never current */
+    g_assert (!mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-nosize.so", 0, 2000));
+    g_assert (!mm_plugin_manifest_entry_is_current (manifest, "libmm-plugin-badmtime.so", 1000, 0));
+
+    g_key_file_unref (manifest);
+}
+
+/*****************************************************************************/
+
+static void
+test_filter_device_ids (void)
+{
+    static const guint16        vendor_ids[] = { 0x12d1, 0 };
+    static const mm_uint16_pair product_ids[] = { { 0x19d2, 0x0117 }, { 0, 0 } };
+    gboolean                    vendor_filtered;
+    gboolean                    product_filtered;
+
+    /* No filters */
+    mm_filter_device_ids (NULL, NULL, 0x12d1, 0x1001, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && !product_filtered);
+
+    /* Vendor IDs only */
+    mm_filter_device_ids (vendor_ids, NULL, 0x12d1, 0x1001, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && !product_filtered);
+    mm_filter_device_ids (vendor_ids, NULL, 0x19d2, 0x0117, &vendor_filtered, &product_filtered);
+    g_assert (vendor_filtered && !product_filtered);
+    mm_filter_device_ids (vendor_ids, NULL, 0, 0, &vendor_filtered, &product_filtered);
+    g_assert (vendor_filtered && !product_filtered);
+
+    /* Product IDs only */
+    mm_filter_device_ids (NULL, product_ids, 0x19d2, 0x0117, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && !product_filtered);
+    mm_filter_device_ids (NULL, product_ids, 0x19d2, 0x2003, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && product_filtered);
+    mm_filter_device_ids (NULL, product_ids, 0x19d2, 0, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && product_filtered);
+
+    /* Both: a full vendor and a single product of another one */
+    mm_filter_device_ids (vendor_ids, product_ids, 0x12d1, 0x1001, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && !product_filtered);
+    mm_filter_device_ids (vendor_ids, product_ids, 0x19d2, 0x0117, &vendor_filtered, &product_filtered);
+    g_assert (!vendor_filtered && !product_filtered);
+    mm_filter_device_ids (vendor_ids, product_ids, 0x19d2, 0x2003, &vendor_filtered, &product_filtered);
+    g_assert (vendor_filtered || product_filtered);
+    mm_filter_device_ids (vendor_ids, product_ids, 0x1e0e, 0x9001, &vendor_filtered, &product_filtered);
+    g_assert (vendor_filtered || product_filtered);
+}
+
+static void
+test_may_support (void)
+{
+    static const gchar *data =
+        "[libmm-plugin-drivers.so]\n"
+        "name=Drivers\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "drivers=option1;\n"
+        "[libmm-plugin-ids.so]\n"
+        "name=Ids\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "vendor-ids=12d1;\n"
+        "product-ids=19d2:0117;\n"
+        "[libmm-plugin-both.so]\n"
+        "name=Both\n"
+        "size=1000\n"
+        "mtime=2000\n"
+        "deferrable=true\n"
+        "drivers=qmi_wwan;\n"
+        "vendor-ids=1199;\n";
+    static const gchar    *option_drivers[] = { "usb-storage", "option1", NULL };
+    static const gchar    *qmi_drivers[] = { "qmi_wwan", "qcserial", NULL };
+    GKeyFile              *manifest;
+    MMPluginManifestEntry *drivers;
+    MMPluginManifestEntry *ids;
+    MMPluginManifestEntry *both;
+
+    manifest = load_manifest (data);
+    drivers = mm_plugin_manifest_entry_load (manifest, "libmm-plugin-drivers.so");
+    ids = mm_plugin_manifest_entry_load (manifest, "libmm-plugin-ids.so");
+    both = mm_plugin_manifest_entry_load (manifest, "libmm-plugin-both.so");
+    g_assert (drivers && ids && both);
+
+    /* Driver filter, any of the device drivers may match */
+    g_assert (mm_plugin_manifest_entry_may_support (drivers, option_drivers, 0x12d1, 0x1001));
+    g_assert (!mm_plugin_manifest_entry_may_support (drivers, qmi_drivers, 0x12d1, 0x1001));
+
+    /* Vendor ID or vendor+product ID pair */
+    g_assert (mm_plugin_manifest_entry_may_support (ids, option_drivers, 0x12d1, 0x1001));
+    g_assert (mm_plugin_manifest_entry_may_support (ids, option_drivers, 0x19d2, 0x0117));
+    g_assert (!mm_plugin_manifest_entry_may_support (ids, option_drivers, 0x19d2, 0x2003));
+    g_assert (!mm_plugin_manifest_entry_may_support (ids, option_drivers, 0x1199, 0x68c0));
+
+    /* Both driver and IDs must match */
+    g_assert (mm_plugin_manifest_entry_may_support (both, qmi_drivers, 0x1199, 0x68c0));
+    g_assert (!mm_plugin_manifest_entry_may_support (both, option_drivers, 0x1199, 0x68c0));
+    g_assert (!mm_plugin_manifest_entry_may_support (both, qmi_drivers, 0x12d1, 0x1001));
+
+    /* Nothing to match against, e.g. virtual devices: always loaded */
+    g_assert (mm_plugin_manifest_entry_may_support (drivers, NULL, 0, 0));
+    g_assert (mm_plugin_manifest_entry_may_support (ids, NULL, 0, 0));
+    g_assert (mm_plugin_manifest_entry_may_support (both, NULL, 0, 0));
+
+    mm_plugin_manifest_entry_free (drivers);
+    mm_plugin_manifest_entry_free (ids);
+    mm_plugin_manifest_entry_free (both);
+    g_key_file_unref (manifest);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/plugin-manifest/parse",              test_parse);
+    g_test_add_func ("/MM/plugin-manifest/parse-not-deferred", test_parse_not_deferred);
+    g_test_add_func ("/MM/plugin-manifest/store",              test_store);
+    g_test_add_func ("/MM/plugin-manifest/stale",              test_stale);
+    g_test_add_func ("/MM/plugin-manifest/filter-device-ids",  test_filter_device_ids);
+    g_test_add_func ("/MM/plugin-manifest/may-support",        test_may_support);
+
+    return g_test_run ();
+}
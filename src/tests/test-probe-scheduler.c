@@ -0,0 +1,172 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "mm-probe-scheduler.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+/* Names of the requests made ready, in order */
+static GString *ready_order;
+
+static void
+ticket_ready (const gchar *name)
+{
+    g_string_append (ready_order, name);
+}
+
+static void
+run_pending (void)
+{
+    while (g_main_context_iteration (NULL, FALSE));
+}
+
+static void
+test_limits (void)
+{
+    MMProbeSchedulerTicket *a;
+    MMProbeSchedulerTicket *b;
+    MMProbeSchedulerTicket *c;
+    MMProbeSchedulerTicket *d;
+
+    ready_order = g_string_new ("");
+    mm_probe_scheduler_set_limits (2, 1);
+
+    a = mm_probe_scheduler_request ("hub1", FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "a");
+    b = mm_probe_scheduler_request ("hub1", FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "b");
+    c = mm_probe_scheduler_request ("hub2", FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "c");
+    d = mm_probe_scheduler_request (NULL,   FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "d");
+
+    /* Never ready right away */
+    g_assert_cmpstr (ready_order->str, ==, "");
+
+    /* 'b' waits for 'a' in the same hub, 'd' waits for a free slot */
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "ac");
+    g_assert_cmpuint (mm_probe_scheduler_get_n_running (), ==, 2);
+    g_assert_cmpuint (mm_probe_scheduler_get_n_queued (), ==, 2);
+
+    /* Releasing 'c' lets 'd' run, but not 'b' */
+    mm_probe_scheduler_release (c);
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "acd");
+
+    mm_probe_scheduler_release (a);
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "acdb");
+
+    mm_probe_scheduler_release (b);
+    mm_probe_scheduler_release (d);
+    g_assert_cmpuint (mm_probe_scheduler_get_n_running (), ==, 0);
+    g_assert_cmpuint (mm_probe_scheduler_get_n_queued (), ==, 0);
+
+    g_string_free (ready_order, TRUE);
+}
+
+static void
+test_priority (void)
+{
+    MMProbeSchedulerTicket *a;
+    MMProbeSchedulerTicket *b;
+    MMProbeSchedulerTicket *c;
+
+    ready_order = g_string_new ("");
+    mm_probe_scheduler_set_limits (1, 0);
+
+    a = mm_probe_scheduler_request (NULL, FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "a");
+    b = mm_probe_scheduler_request (NULL, FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "b");
+    c = mm_probe_scheduler_request (NULL, TRUE,  (MMProbeSchedulerReadyFunc) ticket_ready, "c");
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "a");
+
+    /* Priority requests go before the ones queued earlier */
+    mm_probe_scheduler_release (a);
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "ac");
+
+    mm_probe_scheduler_release (c);
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "acb");
+
+    mm_probe_scheduler_release (b);
+    g_string_free (ready_order, TRUE);
+}
+
+static void
+test_release_queued (void)
+{
+    MMProbeSchedulerTicket *a;
+    MMProbeSchedulerTicket *b;
+
+    ready_order = g_string_new ("");
+    mm_probe_scheduler_set_limits (1, 0);
+
+    /* Released before being ready, the callback is never called */
+    a = mm_probe_scheduler_request (NULL, FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "a");
+    b = mm_probe_scheduler_request (NULL, FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "b");
+    mm_probe_scheduler_release (b);
+    mm_probe_scheduler_release (a);
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "");
+    g_assert_cmpuint (mm_probe_scheduler_get_n_running (), ==, 0);
+    g_assert_cmpuint (mm_probe_scheduler_get_n_queued (), ==, 0);
+
+    /* Raising the limits lets queued requests run */
+    a = mm_probe_scheduler_request (NULL, FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "a");
+    b = mm_probe_scheduler_request (NULL, FALSE, (MMProbeSchedulerReadyFunc) ticket_ready, "b");
+    mm_probe_scheduler_set_limits (0, 0);
+    run_pending ();
+    g_assert_cmpstr (ready_order->str, ==, "ab");
+
+    mm_probe_scheduler_release (a);
+    mm_probe_scheduler_release (b);
+    g_string_free (ready_order, TRUE);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/probe-scheduler/limits",         test_limits);
+    g_test_add_func ("/MM/probe-scheduler/priority",       test_priority);
+    g_test_add_func ("/MM/probe-scheduler/release-queued", test_release_queued);
+
+    return g_test_run ();
+}
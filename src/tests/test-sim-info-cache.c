@@ -0,0 +1,150 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+
+#include <glib.h>
+#include <string.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-sim-info-cache.h"
+#include "mm-log.h"
+
+#define TEST_ICCID  "89014103211118510720"
+#define OTHER_ICCID "89310410106543789301"
+
+#define TEST_AD_RESPONSE  "+CRSM: 144,0,\"00FFFF02\""
+#define TEST_SPN_RESPONSE "+CRSM: 144,0,\"00436172726965724E616D65FFFFFFFFFF\""
+
+/*****************************************************************************/
+
+static void
+test_store_peek (void)
+{
+    mm_sim_info_cache_clear ();
+    g_assert (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_AD) == NULL);
+
+    mm_sim_info_cache_store (TEST_ICCID, MM_SIM_FILE_IMSI, "310410123456789");
+    mm_sim_info_cache_store (TEST_ICCID, MM_SIM_FILE_AD, TEST_AD_RESPONSE);
+
+    g_assert_cmpstr (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_IMSI), ==, "310410123456789");
+    g_assert_cmpstr (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_AD), ==, TEST_AD_RESPONSE);
+
+    /* Files not read yet */
+    g_assert (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_SPN) == NULL);
+
+    /* Other cards are not affected */
+    g_assert (mm_sim_info_cache_peek (OTHER_ICCID, MM_SIM_FILE_IMSI) == NULL);
+
+    mm_sim_info_cache_clear ();
+}
+
+static void
+test_replace (void)
+{
+    mm_sim_info_cache_clear ();
+
+    mm_sim_info_cache_store (TEST_ICCID, MM_SIM_FILE_SPN, "+CRSM: 144,0,\"00FF\"");
+    mm_sim_info_cache_store (TEST_ICCID, MM_SIM_FILE_SPN, TEST_SPN_RESPONSE);
+    g_assert_cmpstr (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_SPN), ==, TEST_SPN_RESPONSE);
+
+    mm_sim_info_cache_clear ();
+}
+
+static void
+test_invalidate (void)
+{
+    mm_sim_info_cache_clear ();
+
+    /* Invalidating unknown cards is fine */
+    mm_sim_info_cache_invalidate (TEST_ICCID, "SIM hot swap");
+
+    mm_sim_info_cache_store (TEST_ICCID, MM_SIM_FILE_IMSI, "310410123456789");
+    mm_sim_info_cache_store (TEST_ICCID, MM_SIM_FILE_AD, TEST_AD_RESPONSE);
+    mm_sim_info_cache_store (OTHER_ICCID, MM_SIM_FILE_IMSI, "204080123456789");
+
+    /* All files of the card are gone */
+    mm_sim_info_cache_invalidate (TEST_ICCID, "SIM hot swap");
+    g_assert (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_IMSI) == NULL);
+    g_assert (mm_sim_info_cache_peek (TEST_ICCID, MM_SIM_FILE_AD) == NULL);
+    g_assert_cmpstr (mm_sim_info_cache_peek (OTHER_ICCID, MM_SIM_FILE_IMSI), ==, "204080123456789");
+
+    mm_sim_info_cache_clear ();
+}
+
+static void
+test_max_cards (void)
+{
+    guint i;
+
+    mm_sim_info_cache_clear ();
+
+    /* One more card than allowed, the first one is evicted */
+    for (i = 0; i <= MM_SIM_INFO_CACHE_MAX_CARDS; i++) {
+        gchar *iccid;
+
+        iccid = g_strdup_printf ("8901410321111851%04u", i);
+        mm_sim_info_cache_store (iccid, MM_SIM_FILE_IMSI, "310410123456789");
+        g_free (iccid);
+        /* Creation times must differ */
+        g_usleep (1000);
+    }
+
+    g_assert (mm_sim_info_cache_peek ("89014103211118510000", MM_SIM_FILE_IMSI) == NULL);
+    for (i = 1; i <= MM_SIM_INFO_CACHE_MAX_CARDS; i++) {
+        gchar *iccid;
+
+        iccid = g_strdup_printf ("8901410321111851%04u", i);
+        g_assert (mm_sim_info_cache_peek (iccid, MM_SIM_FILE_IMSI) != NULL);
+        g_free (iccid);
+    }
+
+    mm_sim_info_cache_clear ();
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/sim-info-cache/store-peek", test_store_peek);
+    g_test_add_func ("/MM/sim-info-cache/replace",    test_replace);
+    g_test_add_func ("/MM/sim-info-cache/invalidate", test_invalidate);
+    g_test_add_func ("/MM/sim-info-cache/max-cards",  test_max_cards);
+
+    return g_test_run ();
+}
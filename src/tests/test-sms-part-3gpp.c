@@ -46,22 +46,15 @@
 /********************* PDU PARSER TESTS *********************/
 
 static void
-common_test_part_from_hexpdu (const gchar *hexpdu,
-                              const gchar *expected_smsc,
-                              const gchar *expected_number,
-                              const gchar *expected_timestamp,
-                              gboolean expected_multipart,
-                              const gchar *expected_text,
-                              const guint8 *expected_data,
-                              gsize expected_data_size)
+common_test_part (MMSmsPart *part,
+                  const gchar *expected_smsc,
+                  const gchar *expected_number,
+                  const gchar *expected_timestamp,
+                  gboolean expected_multipart,
+                  const gchar *expected_text,
+                  const guint8 *expected_data,
+                  gsize expected_data_size)
 {
-    MMSmsPart *part;
-    GError *error = NULL;
-
-    part = mm_sms_part_3gpp_new_from_pdu (0, hexpdu, &error);
-    g_assert_no_error (error);
-    g_assert (part != NULL);
-
     if (expected_smsc)
         g_assert_cmpstr (expected_smsc, ==, mm_sms_part_get_smsc (part));
     if (expected_number)
@@ -85,6 +78,50 @@ common_test_part_from_hexpdu (const gchar *hexpdu,
     mm_sms_part_free (part);
 }
 
+static void
+common_test_part_from_hexpdu (const gchar *hexpdu,
+                              const gchar *expected_smsc,
+                              const gchar *expected_number,
+                              const gchar *expected_timestamp,
+                              gboolean expected_multipart,
+                              const gchar *expected_text,
+                              const guint8 *expected_data,
+                              gsize expected_data_size)
+{
+    MMSmsPart *part;
+    GError *error = NULL;
+    gchar *copy;
+
+    part = mm_sms_part_3gpp_new_from_pdu (0, hexpdu, &error);
+    g_assert_no_error (error);
+    g_assert (part != NULL);
+    common_test_part (part,
+                      expected_smsc,
+                      expected_number,
+                      expected_timestamp,
+                      expected_multipart,
+                      expected_text,
+                      expected_data,
+                      expected_data_size);
+
+    /* Same when parsing over a copy of the hex PDU, which is wiped before
+     * the part is checked, so the part must not refer to it */
+    copy = g_strdup (hexpdu);
+    part = mm_sms_part_3gpp_new_from_pdu_in_place (0, copy, &error);
+    memset (copy, 0, strlen (hexpdu));
+    g_free (copy);
+    g_assert_no_error (error);
+    g_assert (part != NULL);
+    common_test_part (part,
+                      expected_smsc,
+                      expected_number,
+                      expected_timestamp,
+                      expected_multipart,
+                      expected_text,
+                      expected_data,
+                      expected_data_size);
+}
+
 static void
 common_test_part_from_pdu (const guint8 *pdu,
                            gsize pdu_size,
@@ -454,6 +491,188 @@ test_pdu_not_stored (void)
         NULL, 0);
 }
 
+static void
+test_pdu_invalid_hex (void)
+{
+    static const gchar *invalid[] = {
+        "079121436",        /* odd number of digits */
+        "0791ZZ4365870901", /* not hex */
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (invalid); i++) {
+        GError *error = NULL;
+        MMSmsPart *part;
+        gchar *hexpdu;
+
+        hexpdu = g_strdup (invalid[i]);
+        part = mm_sms_part_3gpp_new_from_pdu_in_place (0, hexpdu, &error);
+        g_assert (part == NULL);
+        g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+        g_error_free (error);
+        g_free (hexpdu);
+    }
+}
+
+/********************* PDU PARSER BENCHMARKS *********************/
+
+/* Corpus of SUBMIT PDUs built with our own encoder: GSM-7 and UCS-2 texts of
+ * several lengths, the longest ones split in multiple concatenated parts. */
+
+#define BENCHMARK_QUICK_ITERATIONS 2
+#define BENCHMARK_PERF_ITERATIONS  500
+
+static const gchar *benchmark_texts[] = {
+    "Hi",
+    "Your verification code is 1234, it expires in 10 minutes.",
+    "Here's a longer message [{with some extended characters}] "
+    "thrown in, such as £ and ΩΠΨ and §¿ as well.",
+    "тест сообщения, который пришел из сети",
+    "Ñandú 日本語 ☺",
+};
+
+static GPtrArray *
+benchmark_corpus_new (gsize *total_len)
+{
+    GPtrArray *corpus;
+    guint i;
+    guint reference = 0;
+
+    corpus = g_ptr_array_new_with_free_func (g_free);
+    *total_len = 0;
+
+    for (i = 0; i < G_N_ELEMENTS (benchmark_texts) * 16; i++) {
+        GString *text;
+        gchar **split;
+        MMSmsEncoding encoding = MM_SMS_ENCODING_UNKNOWN;
+        guint n_repeats;
+        guint n_parts;
+        guint j;
+
+        /* From single short parts up to 8x the base text */
+        text = g_string_new (NULL);
+        n_repeats = 1 + (i / G_N_ELEMENTS (benchmark_texts)) % 8;
+        for (j = 0; j < n_repeats; j++)
+            g_string_append (text, benchmark_texts[i % G_N_ELEMENTS (benchmark_texts)]);
+
+        split = mm_sms_part_3gpp_util_split_text (text->str, &encoding);
+        g_assert (split != NULL);
+        n_parts = g_strv_length (split);
+        reference++;
+
+        for (j = 0; j < n_parts; j++) {
+            MMSmsPart *part;
+            guint8 *pdu;
+            guint len = 0;
+            guint msgstart = 0;
+            GError *error = NULL;
+            gchar *hexpdu;
+
+            part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_SUBMIT);
+            mm_sms_part_set_smsc (part, "+12404492164");
+            mm_sms_part_set_number (part, "+16175927198");
+            mm_sms_part_set_text (part, split[j]);
+            mm_sms_part_set_encoding (part, encoding);
+            if (n_parts > 1) {
+                mm_sms_part_set_concat_reference (part, reference);
+                mm_sms_part_set_concat_max (part, n_parts);
+                mm_sms_part_set_concat_sequence (part, j + 1);
+            }
+
+            pdu = mm_sms_part_3gpp_get_submit_pdu (part, &len, &msgstart, &error);
+            g_assert_no_error (error);
+            g_assert (pdu != NULL);
+            mm_sms_part_free (part);
+
+            hexpdu = mm_utils_bin2hexstr (pdu, len);
+            *total_len += strlen (hexpdu);
+            g_ptr_array_add (corpus, hexpdu);
+            g_free (pdu);
+        }
+
+        g_strfreev (split);
+        g_string_free (text, TRUE);
+    }
+
+    return corpus;
+}
+
+static void
+common_benchmark_decode (gboolean in_place,
+                         gboolean read_text)
+{
+    GPtrArray *corpus;
+    gsize total_len;
+    gchar *buffer;
+    GTimer *timer;
+    gdouble elapsed;
+    guint n_iterations;
+    guint iteration;
+    guint i;
+
+    corpus = benchmark_corpus_new (&total_len);
+    /* Only the in-place variant writes here; the copy into it stands for the
+     * response buffer which callers already own */
+    buffer = g_malloc (total_len + 1);
+
+    n_iterations = g_test_perf () ? BENCHMARK_PERF_ITERATIONS : BENCHMARK_QUICK_ITERATIONS;
+
+    timer = g_timer_new ();
+    for (iteration = 0; iteration < n_iterations; iteration++) {
+        for (i = 0; i < corpus->len; i++) {
+            const gchar *hexpdu;
+            MMSmsPart *part;
+            GError *error = NULL;
+
+            hexpdu = g_ptr_array_index (corpus, i);
+            if (in_place) {
+                strcpy (buffer, hexpdu);
+                part = mm_sms_part_3gpp_new_from_pdu_in_place (0, buffer, &error);
+            } else
+                part = mm_sms_part_3gpp_new_from_pdu (0, hexpdu, &error);
+            g_assert_no_error (error);
+            g_assert (part != NULL);
+            if (read_text)
+                g_assert (mm_sms_part_get_text (part) != NULL);
+            mm_sms_part_free (part);
+        }
+    }
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    g_test_minimized_result ((elapsed * 1e9) / (n_iterations * corpus->len),
+                             "%s decode%s: ns per PDU (%u PDUs)",
+                             in_place ? "in-place" : "copying",
+                             read_text ? " with text" : "",
+                             corpus->len);
+    if (elapsed > 0)
+        g_test_maximized_result ((total_len * n_iterations) / (elapsed * 1e6),
+                                 "%s decode%s: MB/s of hex PDU",
+                                 in_place ? "in-place" : "copying",
+                                 read_text ? " with text" : "");
+
+    g_free (buffer);
+    g_ptr_array_unref (corpus);
+}
+
+static void
+benchmark_decode_copying (void)
+{
+    common_benchmark_decode (FALSE, TRUE);
+}
+
+static void
+benchmark_decode_in_place (void)
+{
+    common_benchmark_decode (TRUE, TRUE);
+}
+
+static void
+benchmark_decode_in_place_no_text (void)
+{
+    common_benchmark_decode (TRUE, FALSE);
+}
+
 /********************* SMS ADDRESS ENCODER TESTS *********************/
 
 static void
@@ -881,6 +1100,11 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-multipart", test_pdu_multipart);
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-stored-by-us", test_pdu_stored_by_us);
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-not-stored", test_pdu_not_stored);
+    g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-invalid-hex", test_pdu_invalid_hex);
+
+    g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/benchmark/copying", benchmark_decode_copying);
+    g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/benchmark/in-place", benchmark_decode_in_place);
+    g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/benchmark/in-place-no-text", benchmark_decode_in_place_no_text);
 
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/smsc-intl", test_address_encode_smsc_intl);
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/smsc-unknown", test_address_encode_smsc_unknown);
@@ -45,21 +45,13 @@
 /********************* PDU PARSER TESTS *********************/
 
 static void
-common_test_part_from_hexpdu (const gchar *hexpdu,
-                              MMSmsCdmaTeleserviceId expected_teleservice_id,
-                              MMSmsCdmaServiceCategory expected_service_category,
-                              const gchar *expected_address,
-                              guint8 expected_bearer_reply_option,
-                              const gchar *expected_text)
+common_test_part (MMSmsPart *part,
+                  MMSmsCdmaTeleserviceId expected_teleservice_id,
+                  MMSmsCdmaServiceCategory expected_service_category,
+                  const gchar *expected_address,
+                  guint8 expected_bearer_reply_option,
+                  const gchar *expected_text)
 {
-    MMSmsPart *part;
-    GError *error = NULL;
-
-    mm_dbg (" ");
-    part = mm_sms_part_cdma_new_from_pdu (0, hexpdu, &error);
-    g_assert_no_error (error);
-    g_assert (part != NULL);
-
     if (expected_teleservice_id != MM_SMS_CDMA_TELESERVICE_ID_UNKNOWN)
         g_assert_cmpuint (expected_teleservice_id, ==, mm_sms_part_get_cdma_teleservice_id (part));
     if (expected_service_category != MM_SMS_CDMA_SERVICE_CATEGORY_UNKNOWN)
@@ -78,6 +70,45 @@ common_test_part_from_hexpdu (const gchar *hexpdu,
     mm_sms_part_free (part);
 }
 
+static void
+common_test_part_from_hexpdu (const gchar *hexpdu,
+                              MMSmsCdmaTeleserviceId expected_teleservice_id,
+                              MMSmsCdmaServiceCategory expected_service_category,
+                              const gchar *expected_address,
+                              guint8 expected_bearer_reply_option,
+                              const gchar *expected_text)
+{
+    MMSmsPart *part;
+    GError *error = NULL;
+    gchar *copy;
+
+    mm_dbg (" ");
+    part = mm_sms_part_cdma_new_from_pdu (0, hexpdu, &error);
+    g_assert_no_error (error);
+    g_assert (part != NULL);
+    common_test_part (part,
+                      expected_teleservice_id,
+                      expected_service_category,
+                      expected_address,
+                      expected_bearer_reply_option,
+                      expected_text);
+
+    /* The in-place decoder must give the same result, even if the hex PDU
+     * buffer is wiped before the text is read */
+    copy = g_strdup (hexpdu);
+    part = mm_sms_part_cdma_new_from_pdu_in_place (0, copy, &error);
+    memset (copy, 0, strlen (hexpdu));
+    g_free (copy);
+    g_assert_no_error (error);
+    g_assert (part != NULL);
+    common_test_part (part,
+                      expected_teleservice_id,
+                      expected_service_category,
+                      expected_address,
+                      expected_bearer_reply_option,
+                      expected_text);
+}
+
 static void
 common_test_part_from_pdu (const guint8 *pdu,
                            gsize pdu_size,
@@ -367,6 +398,140 @@ test_unicode_encoding (void)
         "中國哲學書電子化計劃");
 }
 
+/********************* PDU PARSER BENCHMARKS *********************/
+
+/* Corpus of SUBMIT PDUs built with our own encoder, which picks ASCII,
+ * latin or unicode depending on the text. */
+
+#define BENCHMARK_QUICK_ITERATIONS 2
+#define BENCHMARK_PERF_ITERATIONS  500
+
+static const gchar *benchmark_texts[] = {
+    "AAAA",
+    "Your verification code is 1234, it expires in 10 minutes.",
+    "Ñandú, café y pingüino",
+    "тест сообщения, который пришел из сети",
+};
+
+static GPtrArray *
+benchmark_corpus_new (gsize *total_len)
+{
+    GPtrArray *corpus;
+    guint i;
+
+    corpus = g_ptr_array_new_with_free_func (g_free);
+    *total_len = 0;
+
+    for (i = 0; i < G_N_ELEMENTS (benchmark_texts) * 16; i++) {
+        GString *text;
+        MMSmsPart *part;
+        guint8 *pdu;
+        guint len = 0;
+        GError *error = NULL;
+        gchar *hexpdu;
+        guint n_repeats;
+        guint j;
+
+        /* Up to 2x the base text, so that all fit in a single PDU */
+        text = g_string_new (NULL);
+        n_repeats = 1 + (i / G_N_ELEMENTS (benchmark_texts)) % 2;
+        for (j = 0; j < n_repeats; j++)
+            g_string_append (text, benchmark_texts[i % G_N_ELEMENTS (benchmark_texts)]);
+
+        part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
+        mm_sms_part_set_cdma_teleservice_id (part, MM_SMS_CDMA_TELESERVICE_ID_WMT);
+        mm_sms_part_set_number (part, "3305773196");
+        mm_sms_part_set_text (part, text->str);
+
+        pdu = mm_sms_part_cdma_get_submit_pdu (part, &len, &error);
+        g_assert_no_error (error);
+        g_assert (pdu != NULL);
+        mm_sms_part_free (part);
+
+        hexpdu = mm_utils_bin2hexstr (pdu, len);
+        *total_len += strlen (hexpdu);
+        g_ptr_array_add (corpus, hexpdu);
+        g_free (pdu);
+        g_string_free (text, TRUE);
+    }
+
+    return corpus;
+}
+
+static void
+common_benchmark_decode (gboolean in_place,
+                         gboolean read_text)
+{
+    GPtrArray *corpus;
+    gsize total_len;
+    gchar *buffer;
+    GTimer *timer;
+    gdouble elapsed;
+    guint n_iterations;
+    guint iteration;
+    guint i;
+
+    corpus = benchmark_corpus_new (&total_len);
+    buffer = g_malloc (total_len + 1);
+
+    n_iterations = g_test_perf () ? BENCHMARK_PERF_ITERATIONS : BENCHMARK_QUICK_ITERATIONS;
+
+    timer = g_timer_new ();
+    for (iteration = 0; iteration < n_iterations; iteration++) {
+        for (i = 0; i < corpus->len; i++) {
+            const gchar *hexpdu;
+            MMSmsPart *part;
+            GError *error = NULL;
+
+            hexpdu = g_ptr_array_index (corpus, i);
+            if (in_place) {
+                strcpy (buffer, hexpdu);
+                part = mm_sms_part_cdma_new_from_pdu_in_place (0, buffer, &error);
+            } else
+                part = mm_sms_part_cdma_new_from_pdu (0, hexpdu, &error);
+            g_assert_no_error (error);
+            g_assert (part != NULL);
+            if (read_text)
+                mm_sms_part_get_text (part);
+            mm_sms_part_free (part);
+        }
+    }
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    g_test_minimized_result ((elapsed * 1e9) / (n_iterations * corpus->len),
+                             "%s decode%s: ns per PDU (%u PDUs)",
+                             in_place ? "in-place" : "copying",
+                             read_text ? " with text" : "",
+                             corpus->len);
+    if (elapsed > 0)
+        g_test_maximized_result ((total_len * n_iterations) / (elapsed * 1e6),
+                                 "%s decode%s: MB/s of hex PDU",
+                                 in_place ? "in-place" : "copying",
+                                 read_text ? " with text" : "");
+
+    g_free (buffer);
+    g_ptr_array_unref (corpus);
+}
+
+static void
+benchmark_decode_copying (void)
+{
+    common_benchmark_decode (FALSE, TRUE);
+}
+
+static void
+benchmark_decode_in_place (void)
+{
+    common_benchmark_decode (TRUE, TRUE);
+}
+
+static void
+benchmark_decode_in_place_no_text (void)
+{
+    common_benchmark_decode (TRUE, FALSE);
+}
+
 /********************* PDU CREATOR TESTS *********************/
 
 static void
@@ -539,6 +704,10 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/latin-encoding-2", test_latin_encoding_2);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/unicode-encoding", test_unicode_encoding);
 
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/benchmark/copying", benchmark_decode_copying);
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/benchmark/in-place", benchmark_decode_in_place);
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/benchmark/in-place-no-text", benchmark_decode_in_place_no_text);
+
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/ascii-encoding", test_create_pdu_text_ascii_encoding);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/latin-encoding", test_create_pdu_text_latin_encoding);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/unicode-encoding", test_create_pdu_text_unicode_encoding);
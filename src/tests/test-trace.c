@@ -0,0 +1,202 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-trace.h"
+#include "mm-log.h"
+
+#define TEST_OWNER "/sys/devices/pci0000:00/0000:00:14.0/usb1/1-2"
+
+/*****************************************************************************/
+
+static guint
+count_lines (const gchar *str)
+{
+    guint n = 0;
+
+    for (; *str; str++) {
+        if (*str == '\n')
+            n++;
+    }
+    return n;
+}
+
+static void
+test_sequence (void)
+{
+    MMTraceSequence  seq;
+    GError          *error;
+    gchar           *text;
+
+    mm_trace_clear ();
+
+    mm_trace_sequence_init (&seq, TEST_OWNER, "enabling");
+    mm_trace_sequence_step (&seq, "first");
+    mm_trace_sequence_step (&seq, "second");
+    error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "oops");
+    mm_trace_sequence_complete (&seq, error);
+    g_error_free (error);
+
+    /* Already completed, nothing else recorded */
+    mm_trace_sequence_clear (&seq);
+
+    text = mm_trace_build (MM_TRACE_FORMAT_TEXT);
+    g_assert_cmpuint (count_lines (text), ==, 3);
+    g_assert (strstr (text, "success " TEST_OWNER " enabling/first\n"));
+    g_assert (strstr (text, "failure " TEST_OWNER " enabling/second: oops\n"));
+    g_assert (strstr (text, "failure " TEST_OWNER " enabling/enabling: oops\n"));
+    g_free (text);
+
+    mm_trace_clear ();
+}
+
+static void
+test_sequence_aborted (void)
+{
+    MMTraceSequence  seq;
+    gchar           *text;
+
+    mm_trace_clear ();
+
+    mm_trace_sequence_init (&seq, TEST_OWNER, "connection");
+    mm_trace_sequence_step (&seq, "dial");
+    mm_trace_sequence_clear (&seq);
+
+    text = mm_trace_build (MM_TRACE_FORMAT_TEXT);
+    g_assert_cmpuint (count_lines (text), ==, 2);
+    g_assert (strstr (text, "aborted " TEST_OWNER " connection/dial\n"));
+    g_free (text);
+
+    mm_trace_clear ();
+}
+
+static void
+test_ring_wrap (void)
+{
+    MMTraceSpan  span;
+    gchar       *text;
+    guint        i;
+
+    mm_trace_clear ();
+
+    for (i = 0; i < MM_TRACE_RING_SIZE + 10; i++) {
+        mm_trace_span_begin (&span, TEST_OWNER, "initialization", "step");
+        mm_trace_span_end (&span, NULL);
+    }
+
+    /* Ending twice is a no-op */
+    mm_trace_span_end (&span, NULL);
+
+    text = mm_trace_build (MM_TRACE_FORMAT_TEXT);
+    g_assert_cmpuint (count_lines (text), ==, MM_TRACE_RING_SIZE);
+    g_free (text);
+
+    mm_trace_clear ();
+    text = mm_trace_build (MM_TRACE_FORMAT_TEXT);
+    g_assert_cmpstr (text, ==, "no trace records\n");
+    g_free (text);
+}
+
+static void
+test_chrome (void)
+{
+    MMTraceSpan  a;
+    MMTraceSpan  b;
+    GError      *error;
+    gchar       *json;
+
+    mm_trace_clear ();
+
+    json = mm_trace_build (MM_TRACE_FORMAT_CHROME);
+    g_assert_cmpstr (json, ==, "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n");
+    g_free (json);
+
+    /* Overlapping spans */
+    mm_trace_span_begin (&a, TEST_OWNER, "enabling", "3GPP");
+    g_usleep (1000);
+    mm_trace_span_begin (&b, TEST_OWNER, "enabling", "Location");
+    g_usleep (1000);
+    mm_trace_span_end (&a, NULL);
+    error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "quote \" and \\ backslash");
+    mm_trace_span_end (&b, error);
+    g_error_free (error);
+
+    json = mm_trace_build (MM_TRACE_FORMAT_CHROME);
+    g_assert (g_str_has_prefix (json, "{\"traceEvents\":["));
+    g_assert (strstr (json, "\"name\":\"3GPP\",\"cat\":\"enabling\",\"ph\":\"X\""));
+    g_assert (strstr (json, "\"args\":{\"outcome\":\"failure\",\"error\":\"quote \\\" and \\\\ backslash\"}"));
+    g_assert (strstr (json, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"" TEST_OWNER "\"}}"));
+    /* Each overlapping span in its own thread */
+    g_assert (strstr (json, "\"pid\":1,\"tid\":16,"));
+    g_assert (strstr (json, "\"pid\":1,\"tid\":17,"));
+    g_free (json);
+
+    mm_trace_clear ();
+}
+
+static void
+test_format (void)
+{
+    MMTraceFormat  format;
+    GError        *error = NULL;
+
+    g_assert (mm_trace_format_from_string ("", &format, &error));
+    g_assert_cmpuint (format, ==, MM_TRACE_FORMAT_TEXT);
+    g_assert (mm_trace_format_from_string ("CHROME", &format, &error));
+    g_assert_cmpuint (format, ==, MM_TRACE_FORMAT_CHROME);
+    g_assert (!mm_trace_format_from_string ("xml", &format, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS);
+    g_error_free (error);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/trace/sequence",         test_sequence);
+    g_test_add_func ("/MM/trace/sequence-aborted", test_sequence_aborted);
+    g_test_add_func ("/MM/trace/ring-wrap",        test_ring_wrap);
+    g_test_add_func ("/MM/trace/chrome",           test_chrome);
+    g_test_add_func ("/MM/trace/format",           test_format);
+
+    return g_test_run ();
+}
@@ -0,0 +1,381 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2019 The ModemManager authors
+ */
+
+/*
+ * Besides the unit tests, the USSD codec is benchmarked against the previous
+ * conversion through binary buffers and the charset helpers. The actual
+ * measurements are done in performance mode:
+ *
+ *   $ ./src/tests/test-ussd-codec -m perf --verbose
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-ussd-codec.h"
+#include "mm-charsets.h"
+#include "mm-log.h"
+
+#define QUICK_ITERATIONS 10
+#define PERF_ITERATIONS  100000
+
+/*****************************************************************************/
+
+static void
+test_dcs (void)
+{
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x00), ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x0F), ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x10), ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x11), ==, MM_USSD_ENCODING_UCS2);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x40), ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x44), ==, MM_USSD_ENCODING_8BIT);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x48), ==, MM_USSD_ENCODING_UCS2);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x68), ==, MM_USSD_ENCODING_UNKNOWN);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0x98), ==, MM_USSD_ENCODING_UCS2);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0xF0), ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_from_dcs (0xF4), ==, MM_USSD_ENCODING_8BIT);
+
+    g_assert_cmpuint (mm_ussd_encoding_to_dcs (MM_USSD_ENCODING_GSM7), ==, 0x0F);
+    g_assert_cmpuint (mm_ussd_encoding_to_dcs (MM_USSD_ENCODING_UCS2), ==, 0x48);
+
+    g_assert_cmpint (mm_ussd_encoding_for_utf8 ("*100#"),     ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_for_utf8 ("{€}"),       ==, MM_USSD_ENCODING_GSM7);
+    g_assert_cmpint (mm_ussd_encoding_for_utf8 ("Привет"),    ==, MM_USSD_ENCODING_UCS2);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    MMUssdEncoding  encoding;
+    const gchar    *hex;
+    const gchar    *utf8;
+} CodecTest;
+
+static const CodecTest codec_tests[] = {
+    { MM_USSD_ENCODING_GSM7,          "AA180C3602",                                   "*100#"                     },
+    /* 7 chars, padded with <CR> */
+    { MM_USSD_ENCODING_GSM7,          "C2303BEC1E971B",                               "Balance"                   },
+    { MM_USSD_ENCODING_GSM7,          "D9775D0E1287D961F7B80C4ACF413199AB060315AB52", "Your balance is 12.50 EUR" },
+    /* Extended chars */
+    { MM_USSD_ENCODING_GSM7,          "1B147E9302",                                   "{x}"                       },
+    { MM_USSD_ENCODING_GSM7_UNPACKED, "2A31303023",                                   "*100#"                     },
+    { MM_USSD_ENCODING_GSM7_UNPACKED, "1B6531001B65",                                 "€1@€"                      },
+    { MM_USSD_ENCODING_8BIT,          "48E9",                                         "Hé"                        },
+    { MM_USSD_ENCODING_UCS2,          "041F04400438043204350442",                     "Привет"                    },
+    /* Surrogate pair */
+    { MM_USSD_ENCODING_UCS2,          "D83DDE000061",                                 "\xF0\x9F\x98\x80" "a"      },
+};
+
+static void
+test_decode (void)
+{
+    GString *out;
+    guint    i;
+
+    out = g_string_new (NULL);
+    for (i = 0; i < G_N_ELEMENTS (codec_tests); i++) {
+        GError *error = NULL;
+        gchar  *bin;
+        gsize   bin_len;
+
+        g_string_truncate (out, 0);
+        g_assert (mm_ussd_decode_hex (codec_tests[i].encoding, codec_tests[i].hex, strlen (codec_tests[i].hex), out, &error));
+        g_assert_no_error (error);
+        g_assert_cmpstr (out->str, ==, codec_tests[i].utf8);
+
+        bin = mm_utils_hexstr2bin (codec_tests[i].hex, &bin_len);
+        g_string_truncate (out, 0);
+        g_assert (mm_ussd_decode (codec_tests[i].encoding, (const guint8 *) bin, bin_len, out, &error));
+        g_assert_no_error (error);
+        g_assert_cmpstr (out->str, ==, codec_tests[i].utf8);
+        g_free (bin);
+    }
+    g_string_free (out, TRUE);
+}
+
+static void
+test_encode (void)
+{
+    GString    *out;
+    GByteArray *array;
+    guint       i;
+
+    out = g_string_new (NULL);
+    array = g_byte_array_new ();
+    for (i = 0; i < G_N_ELEMENTS (codec_tests); i++) {
+        GError *error = NULL;
+        gchar  *hex;
+
+        g_string_truncate (out, 0);
+        g_assert (mm_ussd_encode_hex (codec_tests[i].encoding, codec_tests[i].utf8, out, &error));
+        g_assert_no_error (error);
+        g_assert_cmpstr (out->str, ==, codec_tests[i].hex);
+
+        g_byte_array_set_size (array, 0);
+        g_assert (mm_ussd_encode (codec_tests[i].encoding, codec_tests[i].utf8, array, &error));
+        g_assert_no_error (error);
+        hex = mm_utils_bin2hexstr (array->data, array->len);
+        g_assert_cmpstr (hex, ==, codec_tests[i].hex);
+        g_free (hex);
+    }
+    g_byte_array_unref (array);
+    g_string_free (out, TRUE);
+}
+
+static void
+test_errors (void)
+{
+    GString    *out;
+    GByteArray *array;
+    GError     *error = NULL;
+
+    out = g_string_new (NULL);
+    array = g_byte_array_new ();
+
+    g_assert (!mm_ussd_decode_hex (MM_USSD_ENCODING_GSM7, "AA1", 3, out, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS);
+    g_clear_error (&error);
+
+    g_assert (!mm_ussd_decode_hex (MM_USSD_ENCODING_GSM7, "AAXX", 4, out, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS);
+    g_clear_error (&error);
+
+    g_assert (!mm_ussd_decode_hex (MM_USSD_ENCODING_UCS2, "041F04", 6, out, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS);
+    g_clear_error (&error);
+
+    g_assert (!mm_ussd_decode_hex (MM_USSD_ENCODING_UNKNOWN, "AA", 2, out, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED);
+    g_clear_error (&error);
+
+    g_assert (!mm_ussd_encode (MM_USSD_ENCODING_8BIT, "Привет", array, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED);
+    g_clear_error (&error);
+
+    /* Chars out of the GSM alphabet are replaced */
+    g_assert (mm_ussd_encode_hex (MM_USSD_ENCODING_GSM7_UNPACKED, "aПb", out, &error));
+    g_assert_no_error (error);
+    g_assert_cmpstr (out->str, ==, "613F62");
+
+    g_byte_array_unref (array);
+    g_string_free (out, TRUE);
+}
+
+/*****************************************************************************/
+/* Benchmarks */
+
+typedef struct {
+    const gchar    *name;
+    MMUssdEncoding  encoding;
+    const gchar    *hex;
+} CodecBenchmark;
+
+static const CodecBenchmark codec_benchmarks[] = {
+    {
+        "gsm7", MM_USSD_ENCODING_GSM7,
+        /* "Your balance is 12.50 EUR. Valid until 31.12.2019. Dial *100*1# for bundles" */
+        "D9775D0E1287D961F7B80C4ACF413199AB060315AB5217C81A66A7C9A0BA9B9E66836631"
+        "574CE692C162391788980EB341AA180CA68A8D40E6B71C24AEBBC9ECF21C"
+    },
+    {
+        "ucs2", MM_USSD_ENCODING_UCS2,
+        /* "Ваш баланс: 125.40 руб. Действителен до 31.12.2019" */
+        "041204300448002004310430043B0430043D0441003A0020003100320035002E003400300020"
+        "044004430431002E0020041404350439044104420432043804420435043B0435043D00200434"
+        "043E002000330031002E00310032002E0032003000310039"
+    },
+};
+
+static void
+legacy_decode (MMUssdEncoding  encoding,
+               const gchar    *hex)
+{
+    gchar *decoded = NULL;
+
+    if (encoding == MM_USSD_ENCODING_GSM7) {
+        gchar   *bin;
+        gsize    bin_len;
+        guint8  *unpacked;
+        guint32  unpacked_len;
+
+        bin = mm_utils_hexstr2bin (hex, &bin_len);
+        unpacked = mm_charset_gsm_unpack ((guint8 *) bin, (bin_len * 8) / 7, 0, &unpacked_len);
+        decoded = (gchar *) mm_charset_gsm_unpacked_to_utf8 (unpacked, unpacked_len);
+        g_free (unpacked);
+        g_free (bin);
+    } else
+        decoded = mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_UCS2);
+
+    g_assert (decoded);
+    g_free (decoded);
+}
+
+static gchar *
+legacy_encode (MMUssdEncoding  encoding,
+               const gchar    *utf8)
+{
+    GByteArray *array;
+    gchar      *hex;
+
+    array = g_byte_array_new ();
+    if (encoding == MM_USSD_ENCODING_GSM7) {
+        guint8  *gsm;
+        guint8  *packed;
+        guint32  len = 0;
+        guint32  packed_len = 0;
+
+        gsm = mm_charset_utf8_to_unpacked_gsm (utf8, &len);
+        packed = mm_charset_gsm_pack (gsm, len, 0, &packed_len);
+        g_byte_array_append (array, packed, packed_len);
+        g_free (packed);
+        g_free (gsm);
+    } else
+        g_assert (mm_modem_charset_byte_array_append (array, utf8, FALSE, MM_MODEM_CHARSET_UCS2));
+
+    hex = mm_utils_bin2hexstr (array->data, array->len);
+    g_byte_array_unref (array);
+    return hex;
+}
+
+static void
+report (const gchar *name,
+        const gchar *operation,
+        gsize        n_bytes,
+        guint        n_iterations,
+        gdouble      elapsed)
+{
+    g_test_minimized_result ((elapsed * 1e9) / n_iterations,
+                             "%s %s: %.0f ns/op, %.1f MB/s",
+                             name, operation, (elapsed * 1e9) / n_iterations,
+                             (n_bytes * n_iterations) / (elapsed * 1e6));
+}
+
+static void
+run_decode_benchmark (gconstpointer user_data)
+{
+    const CodecBenchmark *benchmark = user_data;
+    GString              *out;
+    gsize                 hex_len;
+    guint                 n_iterations;
+    guint                 i;
+
+    n_iterations = g_test_perf () ? PERF_ITERATIONS : QUICK_ITERATIONS;
+    hex_len = strlen (benchmark->hex);
+    out = g_string_sized_new (hex_len);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        g_string_truncate (out, 0);
+        mm_ussd_decode_hex (benchmark->encoding, benchmark->hex, hex_len, out, NULL);
+    }
+    report (benchmark->name, "decode", hex_len / 2, n_iterations, g_test_timer_elapsed ());
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        legacy_decode (benchmark->encoding, benchmark->hex);
+    report (benchmark->name, "legacy decode", hex_len / 2, n_iterations, g_test_timer_elapsed ());
+
+    g_string_free (out, TRUE);
+}
+
+static void
+run_encode_benchmark (gconstpointer user_data)
+{
+    const CodecBenchmark *benchmark = user_data;
+    GString              *out;
+    gchar                *utf8;
+    gchar                *legacy;
+    guint                 n_iterations;
+    guint                 i;
+
+    n_iterations = g_test_perf () ? PERF_ITERATIONS : QUICK_ITERATIONS;
+    out = g_string_new (NULL);
+    g_assert (mm_ussd_decode_hex (benchmark->encoding, benchmark->hex, strlen (benchmark->hex), out, NULL));
+    utf8 = g_string_free (out, FALSE);
+
+    /* Both must give the same result */
+    out = g_string_sized_new (strlen (benchmark->hex) + 1);
+    g_assert (mm_ussd_encode_hex (benchmark->encoding, utf8, out, NULL));
+    legacy = legacy_encode (benchmark->encoding, utf8);
+    g_assert_cmpstr (out->str, ==, legacy);
+    g_free (legacy);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        g_string_truncate (out, 0);
+        mm_ussd_encode_hex (benchmark->encoding, utf8, out, NULL);
+    }
+    report (benchmark->name, "encode", strlen (utf8), n_iterations, g_test_timer_elapsed ());
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        g_free (legacy_encode (benchmark->encoding, utf8));
+    report (benchmark->name, "legacy encode", strlen (utf8), n_iterations, g_test_timer_elapsed ());
+
+    g_string_free (out, TRUE);
+    g_free (utf8);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    guint i;
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/ussd-codec/dcs",    test_dcs);
+    g_test_add_func ("/MM/ussd-codec/decode", test_decode);
+    g_test_add_func ("/MM/ussd-codec/encode", test_encode);
+    g_test_add_func ("/MM/ussd-codec/errors", test_errors);
+
+    for (i = 0; i < G_N_ELEMENTS (codec_benchmarks); i++) {
+        gchar *path;
+
+        path = g_strdup_printf ("/MM/ussd-codec/benchmark/%s/decode", codec_benchmarks[i].name);
+        g_test_add_data_func (path, &codec_benchmarks[i], run_decode_benchmark);
+        g_free (path);
+        path = g_strdup_printf ("/MM/ussd-codec/benchmark/%s/encode", codec_benchmarks[i].name);
+        g_test_add_data_func (path, &codec_benchmarks[i], run_encode_benchmark);
+        g_free (path);
+    }
+
+    return g_test_run ();
+}